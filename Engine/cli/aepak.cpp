@@ -0,0 +1,47 @@
+// aepak: build a .aepak packed asset archive.
+//
+// usage: aepak [-c] <out.aepak> <pakDir> <files...>
+//
+// each file is stored in the pack as <pakDir>\<file name>, i.e. the same flat layout that copy.bat produces for
+// the res/ folder. -c enables per-chunk compression.
+
+#define AE_PAK_IMPL
+#include "automata_engine_pak.h"
+
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+    bool bCompress = false;
+    int  arg       = 1;
+    if (arg < argc && !strcmp(argv[arg], "-c")) {
+        bCompress = true;
+        arg++;
+    }
+    if (argc - arg < 2) {
+        fprintf(stderr, "usage: aepak [-c] <out.aepak> <pakDir> <files...>\n");
+        return 1;
+    }
+    const char *outPath = argv[arg++];
+    std::string pakDir  = argv[arg++];
+
+    std::vector<std::string>  pakPathStorage;
+    std::vector<const char *> srcPaths, pakPaths;
+    for (; arg < argc; arg++) {
+        const char *src  = argv[arg];
+        const char *name = src;
+        for (const char *c = src; *c; c++) {
+            if (*c == '\\' || *c == '/') name = c + 1;
+        }
+        pakPathStorage.push_back(pakDir + "\\" + name);
+        srcPaths.push_back(src);
+    }
+    for (const std::string &s : pakPathStorage) pakPaths.push_back(s.c_str());
+
+    if (!automata_engine::pak::writePack(outPath, srcPaths.data(), pakPaths.data(), (uint32_t)srcPaths.size(), bCompress))
+        return 1;
+
+    printf("aepak: wrote %zu files to %s\n", srcPaths.size(), outPath);
+    return 0;
+}
@@ -0,0 +1,144 @@
+// aetex: cook an image into a .KTX2 or .DDS texture with a full mip chain.
+//
+// usage: aetex [-f rgba8|bc1|bc3|bc5|bc7] [-m box|kaiser|lanczos] [-linear] <in> <out.ktx2|out.dds>
+//
+// the input is any format that stb_image supports. the mips are filtered in linear space unless -linear says that
+// the image is not sRGB encoded (e.g. a normal map). the default is bc7 with the kaiser filter.
+
+#include <automata_engine.hpp>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace ae = automata_engine;
+
+// NOTE: the engine library reaches the platform through ae::EM. the tool stands in for the platform layer with
+// the C runtime.
+static ae::loaded_file_t ReadEntireFile(const char *fileName)
+{
+    ae::loaded_file_t result = {};
+    result.fileName          = fileName;
+    FILE *file               = fopen(fileName, "rb");
+    if (!file) return result;
+    fseek(file, 0, SEEK_END);
+    result.contentSize = (int)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    result.contents = malloc(result.contentSize);
+    fread(result.contents, 1, result.contentSize, file);
+    fclose(file);
+    return result;
+}
+
+static bool WriteEntireFile(const char *fileName, void *memory, uint32_t memorySize)
+{
+    FILE *file = fopen(fileName, "wb");
+    if (!file) return false;
+    bool result = fwrite(memory, 1, memorySize, file) == memorySize;
+    fclose(file);
+    return result;
+}
+
+static void  FreeLoadedFile(ae::loaded_file_t file) { free(file.contents); }
+static void *Alloc(uint32_t bytes) { return malloc(bytes); }
+static void  Free(void *data) { free(data); }
+static void  FprintfProxy(int handle, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
+
+int main(int argc, char **argv)
+{
+    static ae::engine_memory_t engineMemory = {};
+    engineMemory.pfn.readEntireFile         = ReadEntireFile;
+    engineMemory.pfn.writeEntireFile        = WriteEntireFile;
+    engineMemory.pfn.freeLoadedFile         = FreeLoadedFile;
+    engineMemory.pfn.alloc                  = Alloc;
+    engineMemory.pfn.free                   = Free;
+    engineMemory.pfn.fprintf_proxy          = FprintfProxy;
+    ae::setEngineContext(&engineMemory);
+
+    ae::texture::texture_format_t format = ae::texture::TEXTURE_FORMAT_BC7;
+    ae::io::mip_filter_t          filter = ae::io::MIP_FILTER_KAISER;
+    bool                          bSRGB  = true;
+    int                           arg    = 1;
+    for (; arg + 1 < argc && argv[arg][0] == '-'; arg++) {
+        if (!strcmp(argv[arg], "-linear")) {
+            bSRGB = false;
+        } else if (!strcmp(argv[arg], "-f")) {
+            const char *name = argv[++arg];
+            if (!strcmp(name, "rgba8")) format = ae::texture::TEXTURE_FORMAT_RGBA8;
+            else if (!strcmp(name, "bc1")) format = ae::texture::TEXTURE_FORMAT_BC1;
+            else if (!strcmp(name, "bc3")) format = ae::texture::TEXTURE_FORMAT_BC3;
+            else if (!strcmp(name, "bc5")) format = ae::texture::TEXTURE_FORMAT_BC5;
+            else if (!strcmp(name, "bc7")) format = ae::texture::TEXTURE_FORMAT_BC7;
+            else format = ae::texture::TEXTURE_FORMAT_UNKNOWN;
+        } else if (!strcmp(argv[arg], "-m")) {
+            const char *name = argv[++arg];
+            if (!strcmp(name, "box")) filter = ae::io::MIP_FILTER_BOX;
+            else if (!strcmp(name, "kaiser")) filter = ae::io::MIP_FILTER_KAISER;
+            else if (!strcmp(name, "lanczos")) filter = ae::io::MIP_FILTER_LANCZOS;
+            else format = ae::texture::TEXTURE_FORMAT_UNKNOWN;
+        } else {
+            format = ae::texture::TEXTURE_FORMAT_UNKNOWN;
+        }
+    }
+    if (argc - arg != 2 || format == ae::texture::TEXTURE_FORMAT_UNKNOWN) {
+        fprintf(stderr,
+            "usage: aetex [-f rgba8|bc1|bc3|bc5|bc7] [-m box|kaiser|lanczos] [-linear] <in> <out.ktx2|out.dds>\n");
+        return 1;
+    }
+    const char *inPath  = argv[arg];
+    const char *outPath = argv[arg + 1];
+
+    // NOTE: BC5 stores two independent channels (normal maps, etc), which have no sRGB variant.
+    if (format == ae::texture::TEXTURE_FORMAT_BC5) bSRGB = false;
+    if (bSRGB) {
+        switch (format) {
+            case ae::texture::TEXTURE_FORMAT_RGBA8:
+                format = ae::texture::TEXTURE_FORMAT_RGBA8_SRGB;
+                break;
+            case ae::texture::TEXTURE_FORMAT_BC1:
+                format = ae::texture::TEXTURE_FORMAT_BC1_SRGB;
+                break;
+            case ae::texture::TEXTURE_FORMAT_BC3:
+                format = ae::texture::TEXTURE_FORMAT_BC3_SRGB;
+                break;
+            case ae::texture::TEXTURE_FORMAT_BC7:
+                format = ae::texture::TEXTURE_FORMAT_BC7_SRGB;
+                break;
+            default:
+                break;
+        }
+    }
+
+    ae::loaded_image_t image = {};
+    if (ae::io::loadImages(&inPath, 1, &image) != 1) return 1;
+    ae::texture::texture_t mips = ae::io::generateMips(image, filter, bSRGB);
+    ae::io::freeLoadedImage(image);
+    if (!mips.data) return 1;
+
+    ae::texture::texture_t cooked = mips;
+    if (ae::texture::isCompressed(format)) {
+        cooked = ae::texture::compress(mips, format);
+        ae::texture::freeTexture(mips);
+        if (!cooked.data) return 1;
+    }
+
+    size_t outLen = strlen(outPath);
+    bool   bDDS   = outLen >= 4 && (!strcmp(outPath + outLen - 4, ".dds") || !strcmp(outPath + outLen - 4, ".DDS"));
+    bool   bResult = bDDS ? ae::texture::writeDDS(outPath, cooked) : ae::texture::writeKTX2(outPath, cooked);
+    ae::texture::freeTexture(cooked);
+    ae::jobs::shutdown();
+    if (!bResult) {
+        fprintf(stderr, "aetex: failed to write %s\n", outPath);
+        return 1;
+    }
+
+    printf("aetex: wrote %s\n", outPath);
+    return 0;
+}
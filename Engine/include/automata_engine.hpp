@@ -153,12 +153,24 @@ namespace automata_engine {
     struct loaded_image_t;
     struct loaded_file_t;
     struct loaded_wav_t;
+    struct voice_buffer_t;
+    struct voice_state_t;
     struct raw_model_t;
     enum   update_model_t;
 
     /// @brief a type for a generic game function pointer.
     typedef void (*PFN_GameFunctionKind)(game_memory_t *);
 
+    /// @brief the types of the game's audio callbacks, GameOnVoiceBufferProcess and GameOnVoiceBufferEnd.
+    typedef void (*PFN_GameOnVoiceBufferProcess)(game_memory_t *gameMemory,
+        intptr_t                                                 voiceHandle,
+        float                                                   *dst,
+        float                                                   *src,
+        uint32_t                                                 samplesToWrite,
+        int                                                      channels,
+        int                                                      bytesPerSample);
+    typedef void (*PFN_GameOnVoiceBufferEnd)(game_memory_t *gameMemory, intptr_t voiceHandle);
+
     namespace math {
         struct transform_t;
         struct camera_t;
@@ -171,6 +183,90 @@ namespace automata_engine {
         struct mat4_t;
     };
 
+    namespace mesh {
+        struct meshlet_t;
+        struct meshlet_model_t;
+    };
+
+    namespace audio {
+        struct audio_stream_t;
+        struct mixer_t;
+        struct mixer_voice_t;
+        struct mixer_desc_t;
+        struct mixer_voice_params_t;
+        struct mixer_stats_t;
+        struct mixer_clock_t;
+        struct audio_device_t;
+        struct audio_device_desc_t;
+        struct spatializer_t;
+        struct spatializer_desc_t;
+        struct listener_t;
+        struct emitter_desc_t;
+        enum attenuation_t : uint32_t;
+    };
+
+    namespace dsp {
+        struct biquad_t;
+        struct one_pole_t;
+        struct compressor_t;
+        struct compressor_params_t;
+        struct delay_t;
+        struct delay_desc_t;
+        struct delay_params_t;
+        struct reverb_t;
+        struct reverb_desc_t;
+        struct reverb_params_t;
+        enum biquad_type_t : uint32_t;
+    };
+
+    namespace frender {
+        struct backbuffer_t;
+        struct rasterizer_t;
+        struct raster_material_t;
+        struct raster_stats_t;
+        enum image_filter_t : uint32_t;
+        struct sprite_batch_t;
+        struct sprite_quad_t;
+        struct dirty_rect_t;
+        struct dirty_rects_t;
+        struct path_tracer_t;
+        struct path_material_t;
+        struct path_settings_t;
+        struct path_stats_t;
+        struct glyph_cache_t;
+        struct font_t;
+        struct text_draw_t;
+        struct text_metrics_t;
+        struct glyph_cache_stats_t;
+        struct ui_renderer_t;
+        struct ui_vertex_t;
+        struct ui_command_t;
+        struct ui_draw_list_t;
+        struct ui_draw_data_t;
+        struct ui_stats_t;
+        struct backbuffer_ring_t;
+        struct backbuffer_ring_stats_t;
+    };
+
+    namespace asset {
+        struct asset_handle_t;
+        enum asset_state_t : uint32_t;
+    };
+
+    namespace io {
+        enum mip_filter_t : uint32_t;
+        enum resample_quality_t : uint32_t;
+        enum wav_encoding_t : uint32_t;
+        struct audio_format_t;
+        struct audio_converter_t;
+    };
+
+    namespace texture {
+        struct texture_level_t;
+        struct texture_t;
+        enum texture_format_t : uint32_t;
+    };
+
 #if defined(AUTOMATA_ENGINE_GL_BACKEND)
     namespace GL {
         struct vertex_attrib_t;
@@ -303,6 +399,18 @@ namespace automata_engine {
         /// has sane default parameters which can be overriden by member calls.
         Image createImage(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage);
 
+        /// @brief create a structure suitable for creation of a VkImage with the format, size and levels of
+        /// the texture.
+        Image createImage(const texture::texture_t &texture, VkImageUsageFlags usage);
+
+        /// @brief get the VkFormat for a texture format.
+        VkFormat getTextureFormat(texture::texture_format_t format);
+
+        /// @brief record the copy of every level of a texture from a buffer to an image. the buffer holds
+        /// texture_t::data at srcOffset and the image must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL.
+        void cmdCopyTextureToImage(
+            VkCommandBuffer cmd, VkBuffer src, VkDeviceSize srcOffset, VkImage dst, const texture::texture_t &texture);
+
         /// @brief create a structure suitable for creation of a VkImageView. this structure
         /// has sane default parameters which can be overriden by member calls.
         ImageView createImageView(VkImage image, VkFormat format);
@@ -495,7 +603,8 @@ namespace automata_engine {
 
         // TODO(Noah): There's got to be a nice and clean way to get rid of the duplication
         // here with the header of the wrapper.
-        /// @brief Load and upload to GPU a texture from disk. This function supports the same file formats as stbi_load.
+        /// @brief Load and upload to GPU a texture from disk. This function supports the same file formats as stbi_load,
+        /// as well as .DDS and .KTX2 files (see texture::loadTexture), whose mips are used instead of generateMips.
         GLuint createTextureFromFile(
             const char *filePath,
             GLint minFilter = GL_LINEAR, GLint magFilter = GL_LINEAR,
@@ -509,6 +618,15 @@ namespace automata_engine {
             bool generateMips = true, GLint wrap = GL_CLAMP_TO_BORDER
         );
 
+        /// @brief Upload to GPU a texture with all of its mip levels, which may be block compressed.
+        GLuint createTexture(
+            const texture::texture_t &texture,
+            GLint minFilter = GL_LINEAR, GLint magFilter = GL_LINEAR, GLint wrap = GL_CLAMP_TO_BORDER
+        );
+
+        /// @brief Get the GL internal format for a texture format.
+        GLenum getTextureInternalFormat(texture::texture_format_t format);
+
         /// @brief Helper function to set a uniform 4x4 matrix in a shader program.
         void setUniformMat4f(GLuint shader, const char *uniformName, math::mat4_t val);
 
@@ -724,6 +842,25 @@ namespace automata_engine {
     /// it should be called at app end + any time that the game DLL is unloaded.
     void shutdownModuleGlobals();
 
+    // AE job system. a pool of worker threads that is started on first use.
+    namespace jobs {
+        /// @brief run a job on a worker thread. jobs run in the order that they are submitted but may complete in
+        /// any order.
+        void submit(std::function<void()> job);
+
+        /// @brief get the number of worker threads in the pool.
+        uint32_t getWorkerCount();
+
+        /// @brief split [0, count) into chunks of grainSize and run body on each chunk in parallel. the calling
+        /// thread also runs chunks and the call returns once every chunk is complete.
+        /// @param body called as body(begin, end) for the half-open range [begin, end).
+        void parallelFor(uint32_t count, uint32_t grainSize, std::function<void(uint32_t begin, uint32_t end)> body);
+
+        /// @brief finish all submitted jobs and stop the worker threads. this is called by shutdownModuleGlobals.
+        /// the pool starts again on the next submit.
+        void shutdown();
+    }  // namespace jobs
+
     namespace super {
         /// @brief present an ImGui engine overlay.
         void updateAndRender(game_memory_t * gameMemory);
@@ -757,8 +894,20 @@ namespace automata_engine {
 
     // AE input/output engine.
     namespace io {
-        /// @brief load a .WAV file into memory. this must be freed with freeWav.
-        loaded_wav_t loadWav(const char *);
+        /// @brief load a .WAV file into memory. this must be freed with freeWav. integer PCM (8, 16, 24 or 32 bit)
+        /// and float PCM (32 or 64 bit) files are accepted at any sample rate, as are WAVE_FORMAT_EXTENSIBLE files
+        /// of those formats. the samples are converted to the engine mix format, which is 16-bit stereo at
+        /// ENGINE_DESIRED_SAMPLES_PER_SECOND. files that are already in the mix format are not copied.
+        /// @returns a zeroed loaded_wav_t on failure.
+        loaded_wav_t loadWav(const char *fileName);
+
+        /// @brief load a .WAV file as above. IMA and MS ADPCM files (mono or stereo) are accepted too.
+        /// @param quality         the resampler preset used when the file is not at the engine mix rate. the default
+        ///                        is RESAMPLE_QUALITY_DEFAULT.
+        /// @param bKeepCompressed if true, ADPCM files at the engine mix rate are kept in their 4-bit blocks rather
+        ///                        than decoded to 16-bit samples. such a wav has no sampleData. it is played with
+        ///                        audio::voiceSubmitWav, which decodes the blocks as the voice plays them.
+        loaded_wav_t loadWav(const char *fileName, resample_quality_t quality, bool bKeepCompressed = false);
 
         /// @brief free a loaded_wav_t.
         void freeWav(loaded_wav_t wavFile);
@@ -766,6 +915,19 @@ namespace automata_engine {
         /// @brief load a .BMP file into memory. this must be freed with freeLoadedImage.
         loaded_image_t loadBMP(const char *path);
 
+        /// @brief load a batch of images (any format that stb_image supports) in parallel on the job system. each
+        /// image must be freed with freeLoadedImage. the pixel data is 0xABGR (32bpp).
+        /// @param out              array of count images to fill. an image that fails to load is left zeroed.
+        /// @param bFlipVertically  if true, the first row in memory is the bottom row of the image. this is the
+        ///                         layout that stbImageLoad produces.
+        /// @param bSwizzleRB       if true, swap the R and B channels so that the pixel data is 0xARGB.
+        /// @returns the number of images that loaded successfully.
+        uint32_t loadImages(const char **paths,
+            uint32_t                      count,
+            loaded_image_t               *out,
+            bool                          bFlipVertically = true,
+            bool                          bSwizzleRB      = false);
+
         /// @brief load a .OBJ file into memory. this must be freed with freeObj.
         raw_model_t loadObj(const char *filePath);
 
@@ -775,10 +937,480 @@ namespace automata_engine {
         /// @brief free a loaded_image_t.
         void freeLoadedImage(loaded_image_t img);
 
-        /// @brief any .WAV file loaded must have this many samples per second.
+        /// @brief generate a full mip chain for an image on the CPU. the filtering is done in linear space and with
+        /// premultiplied alpha. the result can be passed to texture::compress and saved with texture::writeKTX2 so
+        /// that the mips are computed once offline. this must be freed with texture::freeTexture.
+        /// @param bSRGB if true, the color channels are sRGB encoded. the result is TEXTURE_FORMAT_RGBA8_SRGB rather
+        ///              than TEXTURE_FORMAT_RGBA8.
+        texture::texture_t generateMips(loaded_image_t image, mip_filter_t filter, bool bSRGB = true);
+
+        /// @brief read the format and the location of the samples of a .WAV file without loading the file. the
+        /// formats are those that loadWav accepts.
+        /// @param pDataOffset offset in bytes of the first sample within the file.
+        /// @param pDataSize   size in bytes of the samples.
+        /// @returns false if the file is missing, malformed or of an unsupported format.
+        bool readWavInfo(const char *fileName, audio_format_t *pFormat, uint32_t *pDataOffset, uint32_t *pDataSize);
+
+        /// @brief the sample rate of the engine mix format. loadWav resamples all sounds to this rate.
         constexpr static uint32_t ENGINE_DESIRED_SAMPLES_PER_SECOND = 44100;
+
+        /// @brief decode whole blocks of an ADPCM wav to the engine mix format. up to four blocks and channels are
+        /// decoded side by side with SIMD. this does not allocate and is safe to call from the audio thread.
+        /// @param dst array of 16-bit stereo frames. it must fit blockCount * wav.framesPerBlock frames.
+        /// @returns the number of frames of the sound that were written to dst. this is less than what dst must fit
+        /// for the last block of the sound, which may be partial.
+        uint32_t decodeWavBlocks(const loaded_wav_t &wav, uint32_t firstBlock, uint32_t blockCount, int16_t *dst);
+
+        /// @brief create a converter from interleaved samples in some format to the engine mix format (16-bit stereo
+        /// at ENGINE_DESIRED_SAMPLES_PER_SECOND). the converter keeps state between calls so that a sound may be
+        /// converted in chunks. mono is duplicated to both channels and quad and 5.1 are downmixed to stereo.
+        /// this must be freed with destroyAudioConverter.
+        /// @returns nullptr if the format is not supported.
+        audio_converter_t *createAudioConverter(const audio_format_t &format, resample_quality_t quality);
+
+        /// @brief free an audio_converter_t.
+        void destroyAudioConverter(audio_converter_t *converter);
+
+        /// @brief get an upper bound on the number of frames that the next call to convertAudio writes.
+        uint32_t getMaxConvertedFrames(audio_converter_t *converter, uint32_t frameCount);
+
+        /// @brief convert a chunk of interleaved samples. all of the input is consumed. the resampler lags behind
+        /// the input by a few frames, which are written once more input arrives or by flushAudioConverter.
+        /// @param dst array of 16-bit stereo frames. it must fit getMaxConvertedFrames(converter, frameCount).
+        /// @returns the number of frames written to dst.
+        uint32_t convertAudio(audio_converter_t *converter, const void *samples, uint32_t frameCount, int16_t *dst);
+
+        /// @brief write the frames that the resampler is holding back at the end of a sound. the converter can then
+        /// be used for a new sound.
+        /// @param dst array of 16-bit stereo frames. it must fit getMaxConvertedFrames(converter, 0).
+        /// @returns the number of frames written to dst.
+        uint32_t flushAudioConverter(audio_converter_t *converter, int16_t *dst);
+
+        /// @brief write a .WAV file of frames in the engine mix format.
+        /// @param frames array of frameCount 16-bit stereo frames.
+        /// @returns false on failure.
+        bool writeWav(const char *fileName, const int16_t *frames, uint32_t frameCount);
     };  // namespace io
 
+    // AE audio. streams play long sounds (e.g. music) from disk. a stream decodes the file in chunks on the decoder
+    // thread into a small ring of buffers, from which the voice is refilled each time that it finishes a buffer.
+    //
+    // the mixer plays many sounds through a single platform voice. its voices are cheap slots in a pool rather
+    // than platform voices. the game thread controls them through a lock-free queue of commands, which the audio
+    // thread applies at the start of each block that it renders. voices too quiet to hear, or beyond the number
+    // that the mixer is allowed to mix, are virtual: they keep their place in the sound but are not mixed. the
+    // mixer clock counts the frames rendered, and mixerPlayAt starts a voice on an exact frame of it.
+    //
+    // a software device stands in for the platform audio device, e.g. for headless runs and tests. once installed,
+    // the voices that EM->pfn creates are its voices. nothing plays on its own: each call to advanceDevice renders
+    // the next frames of every playing voice, calling the game's audio callbacks as the platform device would. the
+    // output therefore depends on nothing but the calls made, and is the same on every run.
+    //
+    // the spatializer places mixer voices in 3D. each emitter is a voice with a position and velocity. once per game
+    // frame, updateSpatializer computes the gain, pan and pitch of every emitter relative to the listener, four
+    // emitters at a time, and sends the parameters that changed to the mixer through its command queue.
+    namespace audio {
+        /// @brief the number of decoded buffers that a stream keeps.
+        constexpr static uint32_t AUDIO_STREAM_BUFFER_COUNT = 4;
+
+        /// @brief the size of each decoded buffer of a stream, in frames of the engine mix format.
+        constexpr static uint32_t AUDIO_STREAM_BUFFER_FRAMES = 8192;
+
+        /// @brief open a .WAV file for streaming. the formats are those that io::loadWav accepts and the stream
+        /// produces the engine mix format. the first buffer is decoded before this returns. this must be freed
+        /// with closeStream.
+        /// @param bLoop if true, the stream wraps around to the start of the file without a gap.
+        /// @returns nullptr on failure.
+        audio_stream_t *openStream(const char *fileName, bool bLoop = false);
+
+        /// @brief free a stream. no voice may be playing the stream.
+        void closeStream(audio_stream_t *stream);
+
+        /// @brief stop the thread that decodes every stream. this is called by shutdownModuleGlobals. the thread
+        /// starts again on the next openStream.
+        void stopStreamDecoder();
+
+        /// @brief get the length of a stream in frames of the engine mix format.
+        uint64_t getStreamLength(audio_stream_t *stream);
+
+        /// @brief move the stream to a new position. the buffers decoded from before the seek are dropped, so the
+        /// stream is silent until the buffer at the new position is decoded.
+        /// @param frame the position in frames of the engine mix format.
+        void seekStream(audio_stream_t *stream, uint64_t frame);
+
+        /// @brief copy decoded audio out of a stream. this never blocks and is safe to call from the audio thread.
+        /// @param dst array of frameCount 16-bit stereo frames.
+        /// @returns the number of frames written. this is less than frameCount when the decoder has fallen behind
+        /// or the stream has ended.
+        uint32_t readStream(audio_stream_t *stream, int16_t *dst, uint32_t frameCount);
+
+        /// @brief check if a stream that does not loop has been read to the end.
+        bool isStreamEnded(audio_stream_t *stream);
+
+        /// @brief play a stream on a voice. this replaces whatever the voice was playing. the voice does not begin
+        /// playing. once playing, it plays the stream to the end, then stops. if the decoder falls behind, the
+        /// voice plays silence until it catches up.
+        /// @returns false on failure.
+        bool voiceSubmitStream(intptr_t voiceHandle, audio_stream_t *stream);
+
+        /// @brief play a loaded wav on a voice. this replaces whatever the voice was playing. the voice does not
+        /// begin playing. unlike EM->pfn.voiceSubmitBuffer, this also plays wavs that were kept compressed. their
+        /// blocks are decoded on the audio thread a few at a time, just before the voice reaches them.
+        /// @param bLoop if true, the wav plays until the voice is given something else to play.
+        /// @returns false on failure.
+        bool voiceSubmitWav(intptr_t voiceHandle, const loaded_wav_t &wav, bool bLoop = false);
+
+        /// @brief queue a buffer to a voice, as EM->pfn.voiceQueueBuffer does. what voiceSubmitWav keeps for a voice
+        /// is released when the voice is given other sound through this, voiceSubmitWav, voiceSubmitStream or
+        /// voiceSubmitMixer, but not when the sound goes straight to EM->pfn.
+        /// @returns false on failure, or if platform::VOICE_MAX_QUEUED_BUFFERS buffers are already queued.
+        bool voiceQueueBuffer(intptr_t voiceHandle, const voice_buffer_t &buffer);
+
+        /// @brief the most frames that the mixer renders at once. commands and voice parameters take effect at the
+        /// start of a block. gain and pan changes are ramped across the block.
+        constexpr static uint32_t MIXER_BLOCK_FRAMES = 256;
+
+        /// @brief the highest pitch of a mixer voice. higher pitches are clamped.
+        constexpr static float MIXER_MAX_PITCH = 4.f;
+
+        /// @brief create a mixer. this must be freed with destroyMixer.
+        /// @returns nullptr on failure.
+        mixer_t *createMixer(const mixer_desc_t &desc);
+
+        /// @brief free a mixer. nothing may be rendering the mixer.
+        void destroyMixer(mixer_t *mixer);
+
+        /// @brief start playing a loaded wav on a free voice of the mixer. the wav may be compressed, and must stay
+        /// loaded while the voice plays. all mixer calls except mixerRender must come from the same (game) thread.
+        /// @param bLoop if true, the voice plays until it is stopped.
+        /// @returns the zero handle if there is no free voice or the command queue is full.
+        mixer_voice_t mixerPlay(mixer_t *mixer, const loaded_wav_t &wav, const mixer_voice_params_t &params,
+            bool bLoop = false);
+
+        /// @brief as mixerPlay, but the voice starts on a frame of the mixer clock, which may be within a block. a
+        /// voice waiting for its start frame is playing and virtual. a start frame that has already been rendered
+        /// when the command is applied starts the voice at once, which counts as a late start.
+        /// @param startFrame see getMixerClock and getMixerFrameAt.
+        mixer_voice_t mixerPlayAt(mixer_t *mixer, const loaded_wav_t &wav, const mixer_voice_params_t &params,
+            uint64_t startFrame, bool bLoop = false);
+
+        /// @brief stop a voice. the voice is then free to be reused. stale handles are ignored.
+        void mixerStop(mixer_t *mixer, mixer_voice_t voice);
+
+        /// @brief change the gain, pan and pitch of a voice. stale handles are ignored.
+        void mixerSetParams(mixer_t *mixer, mixer_voice_t voice, const mixer_voice_params_t &params);
+
+        /// @brief check if a voice is still playing. a voice that has ended is seen as ended once the game thread
+        /// makes its next mixer call after the block in which it ended.
+        bool mixerIsPlaying(mixer_t *mixer, mixer_voice_t voice);
+
+        /// @brief mix the playing voices. this is called from the audio thread (or the thread of a device) and
+        /// never blocks or allocates.
+        /// @param dst array of frameCount float stereo frames, which is overwritten.
+        void mixerRender(mixer_t *mixer, float *dst, uint32_t frameCount);
+
+        /// @brief get the voice counts of the last block that was rendered.
+        mixer_stats_t getMixerStats(mixer_t *mixer);
+
+        /// @brief get the mixer clock, which counts the frames that the mixer has rendered, along with the wall clock
+        /// time of the last render. this may be called from any thread.
+        mixer_clock_t getMixerClock(mixer_t *mixer);
+
+        /// @brief get the frame of the mixer clock that is due at a wall clock time. this extends the clock from the
+        /// last render at the rate of the engine mix format, since the device consumes frames in real time. the
+        /// frames are rendered ahead of being heard, by the latency of the device, which is the same for all of
+        /// them. a render covers a whole device period at once, so a voice is in time only if it is scheduled at
+        /// least a period past getMixerFrameAt(now). without a wall clock time for the last render, this is the
+        /// first frame of the last render.
+        /// @param wallClock a time from EM->pfn.wallClock.
+        uint64_t getMixerFrameAt(mixer_t *mixer, uint64_t wallClock);
+
+        /// @brief play the output of a mixer on a platform voice. this replaces whatever the voice was playing. the
+        /// voice does not begin playing. once playing, it plays until it is given something else to play.
+        /// @returns false on failure.
+        bool voiceSubmitMixer(intptr_t voiceHandle, mixer_t *mixer);
+
+        /// @brief create a software device that drops its output. this must be freed with destroyDevice.
+        audio_device_t *createNullDevice(const audio_device_desc_t &desc);
+
+        /// @brief create a software device that records its output to a .WAV file in the engine mix format. the file
+        /// is written by destroyDevice.
+        audio_device_t *createWavDevice(const char *fileName, const audio_device_desc_t &desc);
+
+        /// @brief free a software device, and uninstall it if it is installed.
+        /// @returns false if the device records to a file, which failed to write.
+        bool destroyDevice(audio_device_t *device);
+
+        /// @brief route the voice functions of EM->pfn (createVoice, voicePlayBuffer, voiceSubmitBuffer,
+        /// voiceSubmitCallback, voiceQueueBuffer and voiceGetState) to a software device. the functions that were
+        /// there before are put back when the device is destroyed. only one device is installed at a time.
+        void installDevice(audio_device_t *device);
+
+        /// @brief render the next frames of a software device, on the calling thread. the frames are rendered in
+        /// passes of at most desc.periodFrames. each pass pulls a buffer from each playing voice and hands it to
+        /// onVoiceBufferProcess. onVoiceBufferEnd, and the onEnd of queued buffers, are called once the pass in
+        /// which the sound or buffer ended is done.
+        void advanceDevice(audio_device_t *device, uint32_t frameCount);
+
+        /// @brief get the clock of a software device, which is the number of frames rendered so far.
+        uint64_t getDeviceClock(audio_device_t *device);
+
+        /// @brief a constant representing an invalid emitter.
+        constexpr static uint32_t INVALID_EMITTER = UINT32_MAX;
+
+        /// @brief create a spatializer for the voices of a mixer. this must be freed with destroySpatializer. like
+        /// the other mixer calls, all spatializer calls come from the game thread.
+        spatializer_t *createSpatializer(mixer_t *mixer, const spatializer_desc_t &desc);
+
+        /// @brief free a spatializer. the voices of its emitters keep playing.
+        void destroySpatializer(spatializer_t *spatializer);
+
+        /// @brief make a mixer voice an emitter. the voice keeps its own gain and pitch, which the spatializer
+        /// scales, while its pan is replaced.
+        /// @returns INVALID_EMITTER if the spatializer is full.
+        uint32_t addEmitter(spatializer_t *spatializer, mixer_voice_t voice, const emitter_desc_t &desc);
+
+        /// @brief stop spatializing a voice. this does not stop the voice.
+        void removeEmitter(spatializer_t *spatializer, uint32_t emitter);
+
+        /// @brief move an emitter. this takes effect on the next updateSpatializer.
+        /// @param velocity in units per second, which is used for Doppler.
+        void setEmitterTransform(spatializer_t *spatializer, uint32_t emitter, math::vec3_t pos, math::vec3_t velocity);
+
+        /// @brief build a listener at a camera, which hears along the camera's right axis.
+        listener_t makeListener(const math::camera_t &cam);
+
+        /// @brief compute the parameters of every emitter for a listener, and send those that changed to the mixer.
+        void updateSpatializer(spatializer_t *spatializer, const listener_t &listener);
+
+        /// @brief get the parameters that the last updateSpatializer computed for an emitter. an invalid emitter
+        /// gets the default parameters.
+        mixer_voice_params_t getEmitterParams(spatializer_t *spatializer, uint32_t emitter);
+    }  // namespace audio
+
+    // AE DSP. effects for the game to run on the voice buffers that it is handed in GameOnVoiceBufferProcess, or on
+    // any other block of interleaved float samples. every effect processes in place and keeps its state between
+    // blocks, so a sound can be processed in blocks of any size. the filters run the channels of a frame side by
+    // side in SIMD lanes, the delay runs spans of samples and the reverb runs its delay lines. each process call
+    // flushes denormals to zero while it runs, so that tails decaying toward silence cost no more than the rest of
+    // the sound.
+    //
+    // the filters and the compressor hold no memory of their own and are plain structs. the delay and the reverb
+    // own their delay lines and are created and destroyed.
+    namespace dsp {
+        /// @brief the most channels that the effects process.
+        constexpr static uint32_t DSP_MAX_CHANNELS = 8;
+
+        /// @brief set the coefficients of a biquad, following the RBJ audio EQ cookbook. the state of the filter is
+        /// kept, so this may be called between blocks to sweep a filter. a zeroed biquad_t is a valid filter.
+        /// @param frequency the cutoff or center frequency, in Hz.
+        /// @param q         the resonance. 0.7071 is the flattest response for the pass and shelf filters.
+        /// @param gainDb    the gain of BIQUAD_PEAK and the shelves. the other types ignore this.
+        void designBiquad(
+            biquad_t *filter, biquad_type_t type, float sampleRate, float frequency, float q, float gainDb = 0.f);
+
+        /// @brief filter a block in place.
+        /// @param samples array of frameCount frames of interleaved channels.
+        /// @param channels at most DSP_MAX_CHANNELS.
+        void processBiquad(biquad_t *filter, float *samples, uint32_t frameCount, uint32_t channels);
+
+        /// @brief set the cutoff of a one-pole lowpass, which is also a smoother for parameters. the state is kept.
+        void designOnePole(one_pole_t *filter, float sampleRate, float cutoff);
+
+        /// @brief lowpass a block in place, in the layout of processBiquad.
+        void processOnePole(one_pole_t *filter, float *samples, uint32_t frameCount, uint32_t channels);
+
+        /// @brief scale a block by a gain that moves smoothly toward gain, rather than jumping to it, which clicks.
+        /// the current gain is the state of the first channel of the smoother, which starts at 0 in a zeroed
+        /// one_pole_t. so a new smoother fades in.
+        void applySmoothedGain(
+            one_pole_t *smoother, float gain, float *samples, uint32_t frameCount, uint32_t channels);
+
+        /// @brief set the parameters of a compressor. the envelope is kept. a zeroed compressor_t is not valid
+        /// until this is called.
+        void designCompressor(compressor_t *compressor, float sampleRate, const compressor_params_t &params);
+
+        /// @brief compress a block in place, in the layout of processBiquad. the channels are linked: they all get
+        /// the gain of the loudest.
+        void processCompressor(compressor_t *compressor, float *samples, uint32_t frameCount, uint32_t channels);
+
+        /// @brief create a delay (echo) effect. this must be freed with destroyDelay.
+        /// @returns nullptr on failure.
+        delay_t *createDelay(const delay_desc_t &desc);
+
+        /// @brief free a delay.
+        void destroyDelay(delay_t *delay);
+
+        /// @brief change the parameters of a delay. a new delay time takes effect at once.
+        void setDelayParams(delay_t *delay, const delay_params_t &params);
+
+        /// @brief process a block in place. the block has the channels that the delay was created with.
+        void processDelay(delay_t *delay, float *samples, uint32_t frameCount);
+
+        /// @brief create a reverb. this must be freed with destroyReverb.
+        /// @returns nullptr on failure.
+        reverb_t *createReverb(const reverb_desc_t &desc);
+
+        /// @brief free a reverb.
+        void destroyReverb(reverb_t *reverb);
+
+        /// @brief change the parameters of a reverb. the tail that is already in the reverb keeps ringing.
+        void setReverbParams(reverb_t *reverb, const reverb_params_t &params);
+
+        /// @brief process a block in place. the block has the channels that the reverb was created with.
+        void processReverb(reverb_t *reverb, float *samples, uint32_t frameCount);
+    }  // namespace dsp
+
+    // AE asset cache. assets are keyed by their normalized path so that loading the same path twice returns the
+    // same asset. the cache holds a reference count per asset; unreferenced assets stay cached until the cache
+    // exceeds its memory budget, at which point the least recently used of them are evicted.
+    namespace asset {
+        /// @brief the default memory budget of the cache, in bytes.
+        constexpr static uint64_t ASSET_DEFAULT_MEMORY_BUDGET = 256ull * 1024 * 1024;
+
+        /// @brief load an image (via stbImageLoad), or add a reference to it if it is already cached.
+        /// @param bAsync if true, the load happens on a worker thread and the asset is ASSET_STATE_LOADING until it
+        ///               is complete. otherwise the call blocks until the asset is loaded.
+        ///               loading an asset whose load failed tries it again, within the same handle.
+        asset_handle_t loadImage(const char *path, bool bAsync = false);
+
+        /// @brief load a .OBJ model, or add a reference to it if it is already cached.
+        asset_handle_t loadModel(const char *path, bool bAsync = false);
+
+        /// @brief load a .WAV file, or add a reference to it if it is already cached.
+        asset_handle_t loadWav(const char *path, bool bAsync = false);
+
+        /// @brief add a reference to an asset.
+        void acquire(asset_handle_t handle);
+
+        /// @brief drop a reference to an asset. an asset without references may be evicted at any time after this
+        /// call, after which the handle is stale.
+        void release(asset_handle_t handle);
+
+        /// @brief get the load state of an asset. stale handles return ASSET_STATE_INVALID.
+        asset_state_t getState(asset_handle_t handle);
+
+        /// @brief block until an asset is no longer ASSET_STATE_LOADING.
+        asset_state_t wait(asset_handle_t handle);
+
+        /// @brief get a loaded asset. the result is zeroed if the asset is not loaded or the handle is not of the
+        /// matching type. the data remains owned by the cache and is valid while a reference is held.
+        loaded_image_t getImage(asset_handle_t handle);
+        raw_model_t    getModel(asset_handle_t handle);
+        loaded_wav_t   getWav(asset_handle_t handle);
+
+        /// @brief set the memory budget of the cache, in bytes. unreferenced assets are evicted to meet it.
+        void setMemoryBudget(uint64_t bytes);
+
+        /// @brief get the memory used by all loaded assets, in bytes.
+        uint64_t getMemoryUsage();
+
+        /// @brief evict every asset without references.
+        void evictUnused();
+
+        /// @brief wait for pending loads and free every asset. all handles become stale. this is called by
+        /// shutdownModuleGlobals.
+        void clear();
+    }  // namespace asset
+
+    // AE texture compression and containers. a texture_t is a mip chain in one of the formats that GPUs sample
+    // directly. these are meant to be cooked offline and loaded at runtime with loadTexture.
+    namespace texture {
+        /// @brief the maximum number of mip levels within a texture_t.
+        constexpr static uint32_t TEXTURE_MAX_LEVELS = 16;
+
+        /// @brief check if the format is block compressed.
+        bool isCompressed(texture_format_t format);
+
+        /// @brief check if the format stores sRGB encoded color.
+        bool isSRGB(texture_format_t format);
+
+        /// @brief get the size in bytes of a 4x4 block, or of a pixel for uncompressed formats.
+        uint32_t getBlockSize(texture_format_t format);
+
+        /// @brief get the size in bytes of a width x height level.
+        uint32_t getLevelSize(texture_format_t format, uint32_t width, uint32_t height);
+
+        /// @brief get the number of levels in a full mip chain, i.e. down to 1x1.
+        uint32_t getMaxLevelCount(uint32_t width, uint32_t height);
+
+        /// @brief allocate a texture with uninitialized storage for its levels. this must be freed with
+        /// freeTexture.
+        /// @param levelCount the number of levels. 0 is a full mip chain.
+        texture_t createTexture(texture_format_t format, uint32_t width, uint32_t height, uint32_t levelCount);
+
+        /// @brief create a single level RGBA8 texture with a copy of the image.
+        texture_t createTextureFromImage(loaded_image_t image, bool bSRGB);
+
+        /// @brief free a texture_t.
+        void freeTexture(texture_t texture);
+
+        /// @brief encode 0xABGR pixels as blocks of format. the blocks are encoded in parallel on the job system.
+        /// BC1 is encoded as opaque and BC7 is encoded with mode 6 only.
+        void compressBlocks(
+            const uint32_t *pixels, uint32_t width, uint32_t height, texture_format_t format, void *blocksOut);
+
+        /// @brief decode blocks of format to 0xABGR pixels.
+        /// @returns false if some blocks could not be decoded. only mode 6 BC7 blocks are decoded.
+        bool decompressBlocks(
+            const void *blocks, uint32_t width, uint32_t height, texture_format_t format, uint32_t *pixelsOut);
+
+        /// @brief encode every level of an RGBA8 texture. this must be freed with freeTexture.
+        texture_t compress(const texture_t &source, texture_format_t format);
+
+        /// @brief compute the peak signal-to-noise ratio in dB between two sets of 0xABGR pixels.
+        /// @param channelMask only the channels whose bytes are set in the mask are compared.
+        float computePSNR(const uint32_t *a, const uint32_t *b, uint32_t pixelCount, uint32_t channelMask = ~0u);
+
+        /// @brief load a .DDS or .KTX2 file. this must be freed with freeTexture.
+        texture_t loadTexture(const char *path);
+
+        /// @brief write a .DDS file with a DX10 header.
+        bool writeDDS(const char *path, const texture_t &texture);
+
+        /// @brief write a .KTX2 file. the orientation is recorded as bottom-up, which is the row order of engine
+        /// images.
+        bool writeKTX2(const char *path, const texture_t &texture);
+    }  // namespace texture
+
+    // AE mesh processing.
+    namespace mesh {
+        /// @brief the maximum number of unique vertices that a single meshlet may reference.
+        constexpr static uint32_t MESHLET_MAX_VERTICES = 64;
+
+        /// @brief the maximum number of triangles within a single meshlet.
+        constexpr static uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+        /// @brief split a model into small clusters of triangles (meshlets) for fine-grained culling.
+        ///
+        /// Triangles are grouped greedily by adjacency so that each meshlet stays spatially compact. Each meshlet
+        /// gets a local index buffer, a bounding sphere and a normal cone. The result must be freed with freeMeshlets.
+        /// Front faces are presumed to have counter-clockwise winding.
+        /// @param maxVertices  must not exceed MESHLET_MAX_VERTICES.
+        /// @param maxTriangles must not exceed MESHLET_MAX_TRIANGLES.
+        meshlet_model_t buildMeshlets(raw_model_t model,
+            uint32_t                              maxVertices  = MESHLET_MAX_VERTICES,
+            uint32_t                              maxTriangles = MESHLET_MAX_TRIANGLES);
+
+        /// @brief free a meshlet_model_t.
+        void freeMeshlets(meshlet_model_t meshlets);
+
+        /// @brief cull meshlets against the camera frustum and by their normal cone (backface cluster culling).
+        ///
+        /// The surviving triangles are written to indicesOut as a compacted triangle list that indexes into the
+        /// vertexData of the raw_model_t that the meshlets were built from. The frustum is derived from buildProjMat.
+        /// @param modelMat    the model to world transform of the model. the meshlets are only culled by their normal
+        ///                    cone when this is a rotation and a uniform scale (plus a translation).
+        /// @param indicesOut  must have room for at least meshlets.indexCount indices.
+        /// @param pVisibleOut if not null, receives the number of meshlets that survived culling.
+        /// @return the number of indices written to indicesOut.
+        uint32_t cullMeshlets(const meshlet_model_t &meshlets,
+            const math::camera_t                    &cam,
+            const math::mat4_t                      &modelMat,
+            uint32_t                                *indicesOut,
+            uint32_t                                *pVisibleOut = nullptr);
+    }  // namespace mesh
+
     // fallback rendering routines (CPU).
     namespace frender {
         /// @brief render the engine intro.
@@ -788,6 +1420,259 @@ namespace automata_engine {
         /// @param pLogo  the engine logo that is displayed during the intro.
         /// @param pTheme the sound to play during the intro.
         void engineIntroLoadAssets(loaded_image_t *pLogo, loaded_wav_t *pTheme);
+
+        /// @brief set every pixel of a target to a color. see fill.
+        void clear(backbuffer_t *target, uint32_t color);
+
+        /// @brief set a rectangle of a target to a color, clipped to the target. a large fill is split by rows across
+        /// the jobs, and streams its stores past the cache.
+        /// @param x     the left of the rectangle in the target, in pixels.
+        /// @param y     the top of the rectangle in the target.
+        /// @param color 0xAARRGGBB, which is written as is.
+        void fill(backbuffer_t *target, int32_t x, int32_t y, int32_t width, int32_t height, uint32_t color);
+
+        /// @brief the most rects that a dirty_rects_t holds. past that, the two rects that cost the least to merge are
+        /// merged.
+        constexpr static uint32_t DIRTY_RECT_MAX = 16;
+
+        /// @brief add a rectangle to the dirty rects of a target, if it has them. the rectangle is clipped to the
+        /// target and merged with the rects that it overlaps. the frender draw calls mark what they draw, so this is
+        /// for the pixels that the game writes itself. this is not thread safe.
+        void markDirty(backbuffer_t *target, int32_t x, int32_t y, int32_t width, int32_t height);
+
+        /// @brief copy the dirty rects of a backbuffer to a front buffer of the same size, e.g. the stand in for the
+        /// window of a headless run, and empty the rects. a backbuffer without dirty rects is copied whole.
+        /// @return the number of bytes copied.
+        uint64_t presentDirty(backbuffer_t *front, const backbuffer_t &back);
+
+        /// @brief premultiply the color of an image by its alpha, in place, so that it can be drawn with drawBitmap.
+        /// the image is 0xABGR as io::loadImages gives it.
+        void premultiplyAlpha(loaded_image_t image);
+
+        /// @brief blend an image over a target. the image is 0xABGR with premultiplied alpha and the bottom row first,
+        /// as io::loadImages and then premultiplyAlpha give it.
+        /// @param x     the left of the image in the target. the image is clipped to the target.
+        /// @param y     the top of the image in the target.
+        /// @param scale each pixel of the image covers scale x scale pixels of the target. 2, 3 and 4 are fastest.
+        void drawBitmap(backbuffer_t *target, const loaded_image_t &image, int32_t x, int32_t y, uint32_t scale = 1);
+
+        /// @brief blend an image over a rectangle of a target, resampled to any size with fixed point filtering. the
+        /// image is as drawBitmap takes it. the edges of the image are clamped, and the pixels of the target whose
+        /// centers are in the rectangle are drawn, clipped to the target. at a scale of 1 and an integer position, this
+        /// draws the same as drawBitmap.
+        /// @param x      the left of the rectangle in the target, in pixels. this need not be an integer.
+        /// @param y      the top of the rectangle in the target.
+        /// @param width  the width of the rectangle. smaller than the image shrinks it.
+        /// @param height the height of the rectangle.
+        /// @param filter the kernel to resample with. neither filters more than a 4x4 footprint, so an image shrunk
+        ///               below half its size aliases.
+        void drawBitmapScaled(backbuffer_t *target,
+            const loaded_image_t           &image,
+            float                           x,
+            float                           y,
+            float                           width,
+            float                           height,
+            image_filter_t                  filter);
+
+        /// @brief create a rasterizer, which draws raw_model_t triangles into a backbuffer_t on the CPU. the
+        /// triangles are binned into tiles of the target, and the tiles are drawn in parallel with jobs. this must be
+        /// freed with destroyRasterizer.
+        rasterizer_t *createRasterizer();
+
+        /// @brief free a rasterizer.
+        void destroyRasterizer(rasterizer_t *rasterizer);
+
+        /// @brief begin a frame of triangles. the depth buffer is sized to the target and cleared, the color is not.
+        /// the target must stay valid until endRaster.
+        /// @param viewProj the world to clip transform, e.g. math::buildProjMat(cam) * math::buildViewMat(cam).
+        /// @return false if the target is not 32 bits per pixel or is larger than 8192 pixels on a side.
+        bool beginRaster(rasterizer_t *rasterizer, const backbuffer_t &target, const math::mat4_t &viewProj);
+
+        /// @brief transform, clip and bin the triangles of a model. nothing is drawn until endRaster, which draws the
+        /// triangles with a depth test, in the order that they were submitted.
+        /// @param indices    if not null, the triangle list to draw instead of model.indexData, e.g. the output of
+        ///                   mesh::cullMeshlets.
+        /// @param indexCount the number of indices in indices.
+        void rasterModel(rasterizer_t *rasterizer,
+            const raw_model_t         &model,
+            const math::mat4_t        &modelMat,
+            const raster_material_t   &material,
+            const uint32_t            *indices    = nullptr,
+            uint32_t                   indexCount = 0);
+
+        /// @brief draw the triangles binned since beginRaster into the target.
+        void endRaster(rasterizer_t *rasterizer);
+
+        /// @brief get the triangle counts of the frame since beginRaster.
+        raster_stats_t getRasterStats(rasterizer_t *rasterizer);
+
+        /// @brief create a sprite batch, which collects 2D quads and draws them into a backbuffer_t on the CPU. the
+        /// quads are sorted by depth and binned into tiles of the target, and the tiles are drawn in parallel with
+        /// jobs. this must be freed with destroySpriteBatch.
+        sprite_batch_t *createSpriteBatch();
+
+        /// @brief free a sprite batch.
+        void destroySpriteBatch(sprite_batch_t *batch);
+
+        /// @brief begin a frame of quads. the target must stay valid until endSprites.
+        /// @return false if the target is not 32 bits per pixel or is larger than 8192 pixels on a side.
+        bool beginSprites(sprite_batch_t *batch, const backbuffer_t &target);
+
+        /// @brief push a quad to the batch. nothing is drawn until endSprites. the image of the quad must stay valid
+        /// until then.
+        void pushQuad(sprite_batch_t *batch, const sprite_quad_t &quad);
+
+        /// @brief push a whole image, drawn 1:1 with its top left at (x, y). see pushQuad.
+        /// @param tint 0xAARRGGBB, which multiplies the image.
+        void pushSprite(sprite_batch_t *batch,
+            const loaded_image_t       &image,
+            float                       x,
+            float                       y,
+            uint32_t                    tint  = 0xFFFFFFFF,
+            float                       depth = 0.f);
+
+        /// @brief push a rectangle of a color. see pushQuad.
+        /// @param color 0xAARRGGBB, blended over the target by its alpha.
+        void pushRect(sprite_batch_t *batch,
+            float                     x,
+            float                     y,
+            float                     width,
+            float                     height,
+            uint32_t                  color,
+            float                     depth = 0.f);
+
+        /// @brief draw the quads pushed since beginSprites into the target, from the greatest depth to the least.
+        /// quads of the same depth are drawn in the order that they were pushed.
+        void endSprites(sprite_batch_t *batch);
+
+        /// @brief create a path tracer, which renders a scene of triangles with global illumination on the CPU. each
+        /// renderPath call adds samples to those of the frames before it, until the camera, the settings or the scene
+        /// change. this must be freed with destroyPathTracer.
+        path_tracer_t *createPathTracer();
+
+        /// @brief free a path tracer.
+        void destroyPathTracer(path_tracer_t *tracer);
+
+        /// @brief add the triangles of a model to the scene of the tracer. they are copied in world space, so the
+        /// model can be freed after. the texture of the material must stay valid while the model is in the scene.
+        /// @param modelMat the model matrix. the normals are transformed by it as well, so it should not scale
+        ///                 unevenly.
+        void addPathModel(path_tracer_t *tracer,
+            const raw_model_t           &model,
+            const math::mat4_t          &modelMat,
+            const path_material_t       &material);
+
+        /// @brief remove every model from the scene of the tracer.
+        void clearPathScene(path_tracer_t *tracer);
+
+        /// @brief drop the samples accumulated so far, e.g. after changing the texture of a material.
+        void resetPathAccumulation(path_tracer_t *tracer);
+
+        /// @brief add settings.samplesPerPixel samples to each pixel and write the average of them to the target.
+        /// the BVH of the scene is rebuilt here if a model was added or removed since the last call.
+        /// @param camera looks down -Z, as with buildViewMat. the fov spans the width of the target.
+        /// @return false if the target is not 32 bits per pixel.
+        bool renderPath(path_tracer_t *tracer,
+            backbuffer_t              *target,
+            const math::camera_t      &camera,
+            const path_settings_t     &settings);
+
+        /// @brief find the closest triangle of the scene along a ray, e.g. to pick what is under the mouse.
+        /// @param dir the direction of the ray. t is in units of its length.
+        /// @param t   set to the distance to the hit, if there is one.
+        /// @return false if the ray hits nothing.
+        bool intersectPath(path_tracer_t *tracer, const math::vec3_t &origin, const math::vec3_t &dir, float *t);
+
+        /// @brief get the counts and the timing of the last renderPath call.
+        path_stats_t getPathStats(path_tracer_t *tracer);
+
+        /// @brief create a glyph cache, which rasterizes the glyphs of fonts with FreeType the first time that they are
+        /// drawn and keeps them in an atlas, keyed by font, size and codepoint. text that was drawn before costs only
+        /// the blits. a glyph cache is not thread safe. this must be freed with destroyGlyphCache.
+        /// @param atlasSize the width and height of the atlas. when it is full, it is emptied and refilled.
+        /// @return null if FreeType could not be initialized.
+        glyph_cache_t *createGlyphCache(uint32_t atlasSize = 1024);
+
+        /// @brief free a glyph cache and the fonts loaded into it.
+        void destroyGlyphCache(glyph_cache_t *cache);
+
+        /// @brief load a TrueType or OpenType font with the platform readEntireFile. the font is freed with the cache.
+        /// @return null if the file could not be read or is not a font.
+        font_t *loadFont(glyph_cache_t *cache, const char *path);
+
+        /// @brief draw strings into the target, in order. the glyphs of all of the strings are laid out first and
+        /// then blended by their coverage, in bands of rows in parallel when there are many.
+        void drawTexts(glyph_cache_t *cache, backbuffer_t *target, const text_draw_t *draws, uint32_t count);
+
+        /// @brief draw a string into the target. see text_draw_t.
+        void drawText(glyph_cache_t *cache,
+            backbuffer_t            *target,
+            font_t                  *font,
+            uint32_t                 pixelSize,
+            float                    x,
+            float                    y,
+            const char              *text,
+            uint32_t                 color);
+
+        /// @brief get the size that a string would be drawn at, without drawing it.
+        text_metrics_t measureText(glyph_cache_t *cache, font_t *font, uint32_t pixelSize, const char *text);
+
+        /// @brief get the counts of the glyphs of a cache.
+        glyph_cache_stats_t getGlyphCacheStats(glyph_cache_t *cache);
+
+        /// @brief create a UI renderer, which draws the indexed triangles of an immediate mode UI (e.g. ImDrawData)
+        /// into a backbuffer_t on the CPU. the triangles are binned into tiles of the target, and the tiles are drawn
+        /// in parallel with jobs. the quads that are axis aligned, which most of such a UI is, are drawn as spans
+        /// without edge tests. this must be freed with destroyUiRenderer.
+        ui_renderer_t *createUiRenderer();
+
+        /// @brief free a UI renderer.
+        void destroyUiRenderer(ui_renderer_t *renderer);
+
+        /// @brief draw the lists of the data into the target, in order, as ImGui does: each command is clipped to its
+        /// rectangle, and the triangles are blended over the target by the alpha of their vertices.
+        /// @return false if the target is not 32 bits per pixel or is larger than 8192 pixels on a side.
+        bool renderUi(ui_renderer_t *renderer, backbuffer_t *target, const ui_draw_data_t &data);
+
+        /// @brief get the counts of the last renderUi call.
+        ui_stats_t getUiStats(ui_renderer_t *renderer);
+
+        /// @brief create a ring of backbuffers, so that one thread renders the next frame into a buffer while another
+        /// presents the last one. a frame is acquired, drawn and submitted by the renderer, and then acquired to
+        /// present by the presenter. when the presenter falls behind, the frame that still waits is dropped for the
+        /// newer one rather than the renderer waiting, so with 3 or more buffers acquireBackbuffer never blocks. the
+        /// pixels of a buffer only grow, with room to spare, so most resizes do not allocate. this must be freed with
+        /// destroyBackbufferRing, once neither thread is in it.
+        /// @param count the number of buffers. at least 2.
+        backbuffer_ring_t *createBackbufferRing(uint32_t count = 3);
+
+        /// @brief free a backbuffer ring.
+        void destroyBackbufferRing(backbuffer_ring_t *ring);
+
+        /// @brief get the buffer to render the next frame into. it holds the last submitted frame, so that only what
+        /// changes needs to be drawn, and its dirty rects start empty. after a resize, it is black and all dirty.
+        /// acquiring again before submitBackbuffer gives the same buffer. this waits only while the presenter has
+        /// every other buffer.
+        /// @return null once the ring is closed.
+        backbuffer_t *acquireBackbuffer(backbuffer_ring_t *ring, uint32_t width, uint32_t height);
+
+        /// @brief release the acquired buffer to the presenter, as the newest frame.
+        void submitBackbuffer(backbuffer_ring_t *ring);
+
+        /// @brief wait for a frame newer than the last one acquired to present, and acquire it. the buffer is kept
+        /// unchanged until the next call, e.g. to paint the window again, and the previous one goes back to the
+        /// renderer.
+        /// @param timeoutMs the most time to wait, in milliseconds.
+        /// @param dirty     if not null, set to the rects that changed since the last frame acquired to present,
+        ///                  including those of the frames that were dropped.
+        /// @return null if there was no new frame in time, or the ring is closed.
+        const backbuffer_t *acquireFrontBuffer(backbuffer_ring_t *ring, uint32_t timeoutMs, dirty_rects_t *dirty);
+
+        /// @brief wake the threads that wait on the ring, and make each later acquire return null. for shutdown.
+        void closeBackbufferRing(backbuffer_ring_t *ring);
+
+        /// @brief get the counts of a backbuffer ring.
+        backbuffer_ring_stats_t getBackbufferRingStats(backbuffer_ring_t *ring);
     }  // namespace frender
 
 // -------------------- [SECTION] Platform Layer --------------------
@@ -836,12 +1721,14 @@ namespace automata_engine {
 
 // --------- [SECTION] PLATFORM AUDIO ----------------
 //
-// TODO(Noah): allow for multiple buffer submissions to a voice. currently
-// we are doing a single buffer model.
+// a voice plays a single submitted buffer, a callback, or a queue of buffers (see EM->pfn.voiceQueueBuffer).
 //
         /// @brief a constant representing an invalid voice handle.
         static const intptr_t INVALID_VOICE = UINT32_MAX;
 
+        /// @brief the most buffers that may be queued to a voice at once.
+        static const uint32_t VOICE_MAX_QUEUED_BUFFERS = 64;
+
         /// @brief submit a 16-bit LPCM buffer of sound data to a voice.
         /// The voice does not begin playing. Once playing, it will play the buffer to completion, then stop.
         /// @returns false on failure.
@@ -972,15 +1859,50 @@ namespace automata_engine {
     };
 
     /// @brief a struct representing a .WAV file loaded into memory.
-    /// @param sampleData pointer to contiguous chunk of memory corresponding to 16-bit LPCM sound samples. When
-    ///                   there are two channels, the data is interleaved.
-    /// @param parentFile internal storage for corresponding loaded_file that contains the unparsed sound data.
-    ///                   This is retained so that we can ultimately free the loaded file.
+    /// @param sampleCount number of sample frames.
+    /// @param sampleData  pointer to contiguous chunk of memory corresponding to 16-bit LPCM sound samples. When
+    ///                    there are two channels, the data is interleaved.
+    /// @param parentFile  internal storage for corresponding loaded_file that contains the unparsed sound data.
+    ///                    This is retained so that we can ultimately free the loaded file. When the samples had to
+    ///                    be converted, this is instead the converted samples.
+    /// @param encoding    how the samples are stored. for ADPCM, sampleData is nullptr and the samples are in
+    ///                    blockData, with channels being those of the file. see io::decodeWavBlocks.
+    /// @param blockSize   size in bytes of each ADPCM block.
+    /// @param framesPerBlock number of sample frames that each ADPCM block decodes to.
     struct loaded_wav_t {
         int                  sampleCount;
         int                  channels;
         short               *sampleData;
         struct loaded_file_t parentFile;
+        io::wav_encoding_t   encoding;
+        const uint8_t       *blockData;
+        uint32_t             blockSize;
+        uint32_t             framesPerBlock;
+    };
+
+    /// @brief called once a voice is done with a queued buffer, which is then free to be reused. this runs on the
+    /// audio thread and must not block. it may queue more buffers to the voice.
+    typedef void (*PFN_voiceBufferEndCallback)(void *context, intptr_t voiceHandle);
+
+    /// @brief a buffer of sound data to queue to a voice.
+    /// @param frames     16-bit stereo frames in the engine mix format. these must stay valid until onEnd is called.
+    /// @param frameCount the number of frames.
+    /// @param onEnd      called once the voice is done with the buffer: it has played, or the voice was given a new
+    ///                   sound. this may be null.
+    /// @param context    passed to onEnd.
+    struct voice_buffer_t {
+        const int16_t             *frames;
+        uint32_t                   frameCount;
+        PFN_voiceBufferEndCallback onEnd;
+        void                      *context;
+    };
+
+    /// @brief the state of a voice that plays queued buffers.
+    /// @param buffersQueued the buffers that the voice has not finished with, including the one playing.
+    /// @param framesPlayed  the frames that the voice has played since its first buffer was queued.
+    struct voice_state_t {
+        uint32_t buffersQueued;
+        uint64_t framesPlayed;
     };
 
     /// @brief a struct allocated by the engine and passed to the game layer.
@@ -1031,6 +1953,11 @@ namespace automata_engine {
         uint32_t  backbufferWidth;
         uint32_t  backbufferHeight;
 
+        /// @brief the rects of the backbuffer that the game changed this frame. when
+        /// engine_memory_t::requestDirtyRectPresent is set, only these are copied to the window. the platform empties
+        /// them once they are presented.
+        frender::dirty_rects_t *backbufferDirty;
+
         std::mutex m_mutex;
         void       setInitialized(bool newVal)
         {
@@ -1191,6 +2118,7 @@ namespace automata_engine {
 
     /// @brief submit a loaded_wav_t of sound data to a voice.
     /// The voice does not begin playing. Once playing, it will play the buffer to completion, then stop.
+    /// The wav must have sampleData, i.e. it was not kept compressed.
     /// @returns false on failure.
     typedef bool (*PFN_voiceSubmitBuffer)(intptr_t voiceHandle, loaded_wav_t wavFile);
 
@@ -1198,6 +2126,33 @@ namespace automata_engine {
     /// @returns INVALID_VOICE on failure, a handle to the voice on success.
     typedef intptr_t (*PFN_createVoice)();
 
+    /// @brief called by a voice to get more sound data. this runs on the audio thread and must not block.
+    /// @param dst        array of frameCount 16-bit stereo frames to write to.
+    /// @returns the number of frames written. returning less than frameCount ends the sound.
+    typedef uint32_t (*PFN_voiceFillCallback)(void *user, int16_t *dst, uint32_t frameCount);
+
+    /// @brief have a voice pull its sound data from a callback. this replaces whatever the voice was playing.
+    /// The voice does not begin playing. Once playing, it plays until the callback returns short, then stops.
+    /// Once this returns, the callback that the voice had before is no longer called.
+    /// @returns false on failure.
+    typedef bool (*PFN_voiceSubmitCallback)(intptr_t voiceHandle, PFN_voiceFillCallback fill, void *user);
+
+    /// @brief add a buffer to the end of a voice's queue. this does not stop the voice, which moves from one buffer
+    /// to the next without a gap. when the queue runs dry, the voice plays silence until more is queued. the first
+    /// buffer queued after the voice was given some other sound replaces that sound, and stops the voice.
+    /// @returns false on failure, or if platform::VOICE_MAX_QUEUED_BUFFERS buffers are already queued.
+    typedef bool (*PFN_voiceQueueBuffer)(intptr_t voiceHandle, const voice_buffer_t &buffer);
+
+    /// @brief get the state of a voice's queue. this is safe to call from the audio thread.
+    /// @returns false on failure.
+    typedef bool (*PFN_voiceGetState)(intptr_t voiceHandle, voice_state_t *pState);
+
+    /// @brief read part of a file from disk into memory.
+    /// @param offset offset in bytes from the start of the file.
+    /// @returns the number of bytes read. this is less than size if the range runs past the end of the file, and 0
+    /// on failure.
+    typedef uint32_t (*PFN_readFileRange)(const char *fileName, uint64_t offset, void *dst, uint32_t size);
+
     /// @brief  get numGpus many GPU infos. the infos _MUST_ be provided back to AE to free the enumerated adapters.
     /// @param pInfo   output array with size numGpus to receive the gpu info into.
     /// @param numGpus the size of the pInfo array.
@@ -1261,9 +2216,13 @@ namespace automata_engine {
             PFN_readEntireFile      readEntireFile;
             PFN_writeEntireFile     writeEntireFile;
             PFN_freeLoadedFile      freeLoadedFile;
+            PFN_readFileRange       readFileRange;
             PFN_setAdditionalLogger setAdditionalLogger;
             PFN_voicePlayBuffer     voicePlayBuffer;
             PFN_voiceSubmitBuffer   voiceSubmitBuffer;
+            PFN_voiceSubmitCallback voiceSubmitCallback;
+            PFN_voiceQueueBuffer    voiceQueueBuffer;
+            PFN_voiceGetState       voiceGetState;
             PFN_createVoice         createVoice;
             PFN_getGpuInfos         getGpuInfos;
             PFN_freeGpuInfos        freeGpuInfos;
@@ -1315,6 +2274,11 @@ namespace automata_engine {
         /// @brief set to true to request fallback rendering.
         bool requestFallbackRendering = false;
 
+        /// @brief set to true to present only the game_memory_t::backbufferDirty rects of the fallback backbuffer,
+        /// rather than all of it. the game must then mark every pixel that it changes, e.g. by drawing through frender
+        /// with the dirty rects set on its backbuffer_t.
+        bool requestDirtyRectPresent = false;
+
         // NOTE: this exists since we want to enable this even for Release builds.
         bool requestDebugFileLogging = true;
 
@@ -1353,6 +2317,10 @@ namespace automata_engine {
 
         user_input_t userInput;
 
+        /// @brief the bytes of the fallback backbuffer that the last frame copied to the window. this is written by the
+        /// present thread of the platform.
+        std::atomic<uint64_t> lastFramePresentedBytes = 0;
+
         bool              bCanRenderImGui = true;
         std::atomic<bool> bMouseVisible   = true;
 
@@ -1514,6 +2482,601 @@ namespace automata_engine {
         };
     }  // namespace math
 
+    namespace audio {
+        /// @brief a handle to a voice of the mixer. the generation is bumped each time that a voice is reused,
+        /// which makes handles to voices that have ended detectably stale. the zero handle is never valid.
+        struct mixer_voice_t {
+            uint32_t index;
+            uint32_t generation;
+        };
+
+        /// @brief a struct to create a mixer.
+        /// @param maxVoices        the size of the voice pool. this is the most voices that can play at once.
+        /// @param maxRealVoices    the most voices that are mixed at once. the loudest voices are mixed and the rest
+        ///                         are virtual.
+        /// @param virtualThreshold voices with a peak channel gain below this are virtual. the default is -60 dB.
+        /// @param commandCapacity  the size of the command queue. this is rounded up to a power of two.
+        struct mixer_desc_t {
+            uint32_t maxVoices        = 256;
+            uint32_t maxRealVoices    = 64;
+            float    virtualThreshold = 0.001f;
+            uint32_t commandCapacity  = 1024;
+        };
+
+        /// @brief the parameters of a mixer voice.
+        /// @param gain  linear gain.
+        /// @param pan   -1 is hard left and 1 is hard right. the pan law is equal power, scaled such that the
+        ///              center is unity gain on both channels.
+        /// @param pitch playback rate, where 1 plays the sound as is. the sound is resampled with linear
+        ///              interpolation.
+        struct mixer_voice_params_t {
+            float gain  = 1.f;
+            float pan   = 0.f;
+            float pitch = 1.f;
+        };
+
+        /// @brief the voice counts of a mixer.
+        /// @param realVoices    the voices that are mixed. this is at most maxRealVoices.
+        /// @param virtualVoices the rest of the playing voices, including those that fade out as they go virtual.
+        /// @param lateStarts    the voices of mixerPlayAt that started after their start frame, since the mixer was
+        ///                      created.
+        struct mixer_stats_t {
+            uint32_t playingVoices;
+            uint32_t realVoices;
+            uint32_t virtualVoices;
+            uint32_t lateStarts;
+        };
+
+        /// @brief the mixer clock.
+        /// @param frame     the first frame of the last render. the clock starts at 0.
+        /// @param wallClock the EM->pfn.wallClock time at which the last render began. this is 0 before the first
+        ///                  render, or without EM->pfn.wallClock.
+        struct mixer_clock_t {
+            uint64_t frame;
+            uint64_t wallClock;
+        };
+
+        /// @brief a struct to create a software audio device.
+        /// @param gameMemory           passed to the callbacks.
+        /// @param onVoiceBufferProcess called in place on each buffer of each voice, as the platform calls
+        ///                             GameOnVoiceBufferProcess. the samples are float. this may be null.
+        /// @param onVoiceBufferEnd     called when the sound of a voice ends, as the platform calls
+        ///                             GameOnVoiceBufferEnd. this may submit to the voice. this may be null.
+        /// @param periodFrames         the most frames rendered per pass. the default is 10 ms, the pass of XAudio2.
+        struct audio_device_desc_t {
+            game_memory_t               *gameMemory           = nullptr;
+            PFN_GameOnVoiceBufferProcess onVoiceBufferProcess = nullptr;
+            PFN_GameOnVoiceBufferEnd     onVoiceBufferEnd     = nullptr;
+            uint32_t                     periodFrames         = 441;
+        };
+
+        /// @brief a struct to create a spatializer.
+        /// @param maxEmitters   the most emitters at once.
+        /// @param speedOfSound  in units per second. the default is that of air, with a unit of one meter.
+        /// @param dopplerFactor scales the Doppler shift. 0 turns it off.
+        struct spatializer_desc_t {
+            uint32_t maxEmitters   = 256;
+            float    speedOfSound  = 343.f;
+            float    dopplerFactor = 1.f;
+        };
+
+        /// @brief a listener, e.g. from makeListener.
+        /// @param right    the unit vector toward the listener's right ear.
+        /// @param velocity in units per second.
+        struct listener_t {
+            math::vec3_t pos;
+            math::vec3_t right;
+            math::vec3_t velocity;
+        };
+
+        /// @brief how the gain of an emitter falls off with distance, between minDistance and maxDistance. closer
+        /// than minDistance, the gain is 1. beyond maxDistance, it stays what it is at maxDistance.
+        /// ATTENUATION_INVERSE is minDistance / (minDistance + rolloff * (distance - minDistance)).
+        /// ATTENUATION_LINEAR is 1 - rolloff * (distance - minDistance) / (maxDistance - minDistance).
+        enum attenuation_t : uint32_t { ATTENUATION_INVERSE = 0, ATTENUATION_LINEAR };
+
+        /// @brief a struct to add an emitter.
+        /// @param params the parameters of the voice before spatializing. the pan is unused.
+        struct emitter_desc_t {
+            mixer_voice_params_t params;
+            attenuation_t        attenuation = ATTENUATION_INVERSE;
+            float                minDistance = 1.f;
+            float                maxDistance = 100.f;
+            float                rolloff     = 1.f;
+        };
+    }  // namespace audio
+
+    namespace dsp {
+        /// @brief an enum for the responses of a biquad.
+        enum biquad_type_t : uint32_t {
+            BIQUAD_LOWPASS = 0,
+            BIQUAD_HIGHPASS,
+            BIQUAD_BANDPASS,
+            BIQUAD_NOTCH,
+            BIQUAD_PEAK,
+            BIQUAD_LOWSHELF,
+            BIQUAD_HIGHSHELF
+        };
+
+        /// @brief a second order IIR filter, in transposed direct form II. the coefficients are normalized such
+        /// that a0 is 1. z1 and z2 are the state of each channel.
+        struct biquad_t {
+            float b0, b1, b2, a1, a2;
+            float z1[DSP_MAX_CHANNELS];
+            float z2[DSP_MAX_CHANNELS];
+        };
+
+        /// @brief a one-pole lowpass, y += a * (x - y). y is the state of each channel.
+        struct one_pole_t {
+            float a;
+            float y[DSP_MAX_CHANNELS];
+        };
+
+        /// @brief the parameters of a compressor, which is a peak compressor with a hard knee.
+        /// @param thresholdDb the level above which the gain is reduced.
+        /// @param ratio       the input level over the threshold per unit of output level over it, in dB. INFINITY
+        ///                    with an attackTime of 0 is a limiter, whose output peaks never exceed the threshold.
+        /// @param attackTime  the time that the envelope takes to rise 63% of the way to a louder peak, in seconds.
+        /// @param releaseTime the same for falling, in seconds.
+        /// @param makeupDb    gain applied after compressing.
+        struct compressor_params_t {
+            float thresholdDb = -12.f;
+            float ratio       = 4.f;
+            float attackTime  = 0.005f;
+            float releaseTime = 0.1f;
+            float makeupDb    = 0.f;
+        };
+
+        /// @brief the state of a compressor. set it with designCompressor.
+        struct compressor_t {
+            float threshold;
+            float slope;  // 1 / ratio - 1, the exponent of the gain over the threshold.
+            float attack, release;
+            float makeup;
+            float envelope;
+        };
+
+        /// @brief the parameters of a delay. each echo is the last one scaled by feedback.
+        /// @param delayTime in seconds. this is clamped to [1 frame, maxDelayTime].
+        /// @param feedback  in [0, 1).
+        /// @param wet       the gain of the echoes.
+        /// @param dry       the gain of the input.
+        struct delay_params_t {
+            float delayTime = 0.25f;
+            float feedback  = 0.4f;
+            float wet       = 0.5f;
+            float dry       = 1.f;
+        };
+
+        /// @brief a struct to create a delay.
+        struct delay_desc_t {
+            float          sampleRate   = 44100.f;
+            uint32_t       channels     = 2;
+            float          maxDelayTime = 1.f;
+            delay_params_t params;
+        };
+
+        /// @brief the parameters of a reverb.
+        /// @param decayTime        the time for the tail to fall by 60 dB, in seconds.
+        /// @param dampingFrequency the cutoff of the lowpass in the feedback path. above it, the tail decays faster.
+        /// @param wet              the gain of the reverb.
+        /// @param dry              the gain of the input.
+        struct reverb_params_t {
+            float decayTime        = 1.5f;
+            float dampingFrequency = 6000.f;
+            float wet              = 0.3f;
+            float dry              = 1.f;
+        };
+
+        /// @brief a struct to create a reverb.
+        struct reverb_desc_t {
+            float           sampleRate = 44100.f;
+            uint32_t        channels   = 2;
+            reverb_params_t params;
+        };
+    }  // namespace dsp
+
+    namespace asset {
+        /// @brief a handle to an asset within the cache. the generation is bumped each time that a cache slot is
+        /// reused, which makes handles to evicted assets detectably stale. the zero handle is never valid.
+        struct asset_handle_t {
+            uint32_t index;
+            uint32_t generation;
+        };
+
+        /// @brief an enum for the load state of an asset.
+        enum asset_state_t : uint32_t {
+            ASSET_STATE_INVALID = 0,
+            ASSET_STATE_LOADING,
+            ASSET_STATE_LOADED,
+            ASSET_STATE_FAILED
+        };
+    }  // namespace asset
+
+    namespace io {
+        /// @brief an enum for the kernels that generateMips can filter with.
+        /// @param MIP_FILTER_BOX     averages the source pixels under each destination pixel.
+        /// @param MIP_FILTER_KAISER  Kaiser windowed sinc. sharper than box with little ringing.
+        /// @param MIP_FILTER_LANCZOS Lanczos-3 windowed sinc. the sharpest, with the most ringing.
+        enum mip_filter_t : uint32_t {
+            MIP_FILTER_BOX = 0,
+            MIP_FILTER_KAISER,
+            MIP_FILTER_LANCZOS
+        };
+
+        /// @brief an enum for the quality/speed presets of the audio resampler. the presets differ in the length of
+        /// the windowed sinc kernel and in how finely the fractional sample offsets are quantized.
+        /// @param RESAMPLE_QUALITY_FAST    8 taps. for sounds converted at runtime where speed matters most.
+        /// @param RESAMPLE_QUALITY_DEFAULT 24 taps. alias-free across most of the audible band.
+        /// @param RESAMPLE_QUALITY_HIGH    64 taps. for offline conversion and music.
+        enum resample_quality_t : uint32_t {
+            RESAMPLE_QUALITY_FAST = 0,
+            RESAMPLE_QUALITY_DEFAULT,
+            RESAMPLE_QUALITY_HIGH
+        };
+
+        /// @brief an enum for how the samples of a loaded_wav_t are stored.
+        /// @param WAV_ENCODING_PCM16     16-bit stereo samples at the engine mix rate.
+        /// @param WAV_ENCODING_IMA_ADPCM IMA (DVI) ADPCM blocks. 4 bits per sample.
+        /// @param WAV_ENCODING_MS_ADPCM  Microsoft ADPCM blocks. 4 bits per sample.
+        enum wav_encoding_t : uint32_t {
+            WAV_ENCODING_PCM16 = 0,
+            WAV_ENCODING_IMA_ADPCM,
+            WAV_ENCODING_MS_ADPCM
+        };
+
+        /// @brief a struct describing the layout of interleaved PCM samples.
+        /// @param bitsPerSample 8, 16, 24 or 32 for integer samples and 32 or 64 for float samples. 8-bit samples
+        ///                      are unsigned, as in .WAV files.
+        /// @param channels      1 (mono), 2 (stereo), 4 (quad) or 6 (5.1).
+        struct audio_format_t {
+            uint32_t sampleRate;
+            uint32_t channels;
+            uint32_t bitsPerSample;
+            bool     bFloat;
+        };
+    }  // namespace io
+
+    namespace texture {
+        /// @brief an enum for the pixel formats of a texture_t.
+        enum texture_format_t : uint32_t {
+            TEXTURE_FORMAT_UNKNOWN = 0,
+            TEXTURE_FORMAT_RGBA8,
+            TEXTURE_FORMAT_RGBA8_SRGB,
+            TEXTURE_FORMAT_BC1,
+            TEXTURE_FORMAT_BC1_SRGB,
+            TEXTURE_FORMAT_BC3,
+            TEXTURE_FORMAT_BC3_SRGB,
+            TEXTURE_FORMAT_BC5,
+            TEXTURE_FORMAT_BC7,
+            TEXTURE_FORMAT_BC7_SRGB
+        };
+
+        /// @brief a struct describing a single mip level of a texture_t.
+        /// @param offset offset in bytes of the level within texture_t::data.
+        /// @param size   size in bytes of the level.
+        struct texture_level_t {
+            uint32_t width;
+            uint32_t height;
+            uint32_t offset;
+            uint32_t size;
+        };
+
+        /// @brief a struct representing a mip chain. levels are stored contiguously in data, level 0 first. rows
+        /// (of blocks) are in the same order as the image that they came from.
+        struct texture_t {
+            texture_format_t format;
+            uint32_t         width;
+            uint32_t         height;
+            uint32_t         levelCount;
+            texture_level_t  levels[TEXTURE_MAX_LEVELS];
+            uint8_t         *data;
+            uint32_t         dataSize;
+        };
+    }  // namespace texture
+
+    namespace mesh {
+        /// @brief a struct describing a single cluster of triangles.
+        /// @param vertexOffset   offset into meshlet_model_t::vertexIndices of the first vertex of this meshlet.
+        /// @param vertexCount    number of unique vertices referenced by this meshlet.
+        /// @param triangleOffset offset into meshlet_model_t::triangleIndices of the first local index.
+        /// @param triangleCount  number of triangles in this meshlet.
+        /// @param center         center of the bounding sphere in model space.
+        /// @param radius         radius of the bounding sphere in model space.
+        /// @param coneApex       apex of the normal cone in model space.
+        /// @param coneAxis       normalized average facing direction of the triangles.
+        /// @param coneCutoff     the meshlet is backfacing when dot(normalize(coneApex - eye), coneAxis) > coneCutoff.
+        ///                       a value of 1 means that the meshlet cannot be backface culled.
+        struct meshlet_t {
+            uint32_t     vertexOffset;
+            uint32_t     vertexCount;
+            uint32_t     triangleOffset;
+            uint32_t     triangleCount;
+            math::vec3_t center;
+            float        radius;
+            math::vec3_t coneApex;
+            math::vec3_t coneAxis;
+            float        coneCutoff;
+        };
+
+        /// @brief a struct representing a model split into meshlets.
+        /// @param meshlets        a stretchy buffer of meshlets.
+        /// @param vertexIndices   a stretchy buffer mapping meshlet local vertices to the vertices of the model.
+        /// @param triangleIndices a stretchy buffer of meshlet local indices, three per triangle.
+        /// @param indexCount      the total number of indices across all meshlets.
+        struct meshlet_model_t {
+            meshlet_t *meshlets;         // stretchy buf
+            uint32_t  *vertexIndices;    // stretchy buf
+            uint8_t   *triangleIndices;  // stretchy buf
+            uint32_t   indexCount;
+        };
+    }  // namespace mesh
+
+    namespace frender {
+        /// @brief a struct describing a 32 bit image in memory that the CPU renders to, such as
+        /// game_memory_t::backbufferPixels. the first row is the top of the image. each pixel is 0xAARRGGBB.
+        /// @param pitch the number of bytes from the start of one row to the start of the next.
+        /// @param dirty if not null, the frender draw calls mark the pixels that they change here. see markDirty.
+        struct backbuffer_t {
+            uint32_t      *memory;
+            uint32_t       width;
+            uint32_t       height;
+            uint32_t       bytesPerPixel;
+            uint32_t       pitch;
+            dirty_rects_t *dirty = nullptr;
+        };
+
+        /// @brief a struct describing a rectangle of a target, in pixels from the top left.
+        struct dirty_rect_t {
+            int32_t x;
+            int32_t y;
+            int32_t width;
+            int32_t height;
+        };
+
+        /// @brief a struct of the rectangles of a target that changed since it was last presented. see markDirty.
+        struct dirty_rects_t {
+            uint32_t     count;
+            dirty_rect_t rects[DIRTY_RECT_MAX];
+        };
+
+        /// @brief an enum for the kernels that drawBitmapScaled can resample with.
+        /// @param IMAGE_FILTER_BILINEAR blends the 2x2 source pixels around each target pixel.
+        /// @param IMAGE_FILTER_BICUBIC  Catmull-Rom over the 4x4 source pixels. sharper, with slight ringing.
+        enum image_filter_t : uint32_t {
+            IMAGE_FILTER_BILINEAR = 0,
+            IMAGE_FILTER_BICUBIC
+        };
+
+        /// @brief a struct describing a rectangle of a sprite batch, see pushQuad. the pixels of the target whose
+        /// centers are in the rectangle are drawn.
+        /// @param image  if not null, e.g. an atlas, as drawBitmap takes it. the image is sampled with nearest
+        ///               filtering and clamped to its edges. if null, the quad is a rectangle of tint.
+        /// @param x      the left of the rectangle in the target, in pixels.
+        /// @param y      the top of the rectangle in the target.
+        /// @param u0     the left of the region of the image that is drawn, from 0 to 1. u1 < u0 flips the region.
+        /// @param v0     the top of the region, where 0 is the top row of the image.
+        /// @param tint   0xAARRGGBB, which multiplies the image.
+        /// @param depth  the quads are drawn from the greatest depth to the least.
+        struct sprite_quad_t {
+            const loaded_image_t *image  = nullptr;
+            float                 x      = 0.f;
+            float                 y      = 0.f;
+            float                 width  = 0.f;
+            float                 height = 0.f;
+            float                 u0     = 0.f;
+            float                 v0     = 0.f;
+            float                 u1     = 1.f;
+            float                 v1     = 1.f;
+            uint32_t              tint   = 0xFFFFFFFF;
+            float                 depth  = 0.f;
+        };
+
+        /// @brief a struct describing how the triangles of a rasterModel call are shaded.
+        /// @param texture        if not null, sampled with nearest filtering and wrapping. the pixels are 0xABGR with
+        ///                       the bottom row first, as io::loadImages gives them. texels with alpha below 128 are
+        ///                       cut out.
+        /// @param color          0xAARRGGBB. the color of an untextured model, else a tint that multiplies the texture.
+        /// @param bLit           flat shade the faces: color is scaled by ambient + (1 - ambient) * max(0, N.L), where
+        ///                       N is the normal of the face.
+        /// @param lightDir       the normalized world space direction toward the light.
+        /// @param ambient        the light that faces turned away from the light still get.
+        /// @param bCullBackfaces skip the faces that are clockwise on screen. front faces are counter-clockwise, as in
+        ///                       GL.
+        struct raster_material_t {
+            const loaded_image_t *texture        = nullptr;
+            uint32_t              color          = 0xFFFFFFFF;
+            bool                  bLit           = false;
+            math::vec3_t          lightDir       = math::vec3_t(0.f, 1.f, 0.f);
+            float                 ambient        = 0.2f;
+            bool                  bCullBackfaces = true;
+        };
+
+        /// @brief a struct of the triangle counts of a frame of the rasterizer.
+        /// @param triangles     the triangles submitted with rasterModel.
+        /// @param culled        the triangles that were dropped as backfacing, degenerate, between pixel centers or
+        ///                      outside of the frustum. after clipping, this counts the pieces of a triangle.
+        /// @param clipped       the triangles that crossed the near or far plane or the guard band.
+        /// @param binned        the triangles, after clipping, that were binned to at least one tile.
+        /// @param tileTriangles the sum over the tiles of the triangles binned to each.
+        struct raster_stats_t {
+            uint32_t triangles;
+            uint32_t culled;
+            uint32_t clipped;
+            uint32_t binned;
+            uint32_t tileTriangles;
+        };
+
+        /// @brief a struct describing the surface of a model in a path traced scene. the surfaces are two sided.
+        /// @param albedo       the fraction of the light that is reflected, per channel.
+        /// @param texture      if not null, multiplies albedo. sampled with nearest filtering and wrapping, as with
+        ///                     raster_material_t.
+        /// @param emission     the light that the surface gives off, in the same units as the sky.
+        /// @param reflectivity the chance that a ray is mirrored rather than scattered diffusely.
+        struct path_material_t {
+            math::vec3_t          albedo       = math::vec3_t(0.8f, 0.8f, 0.8f);
+            const loaded_image_t *texture      = nullptr;
+            math::vec3_t          emission     = math::vec3_t(0.f, 0.f, 0.f);
+            float                 reflectivity = 0.f;
+        };
+
+        /// @brief a struct of the settings of a renderPath call. changing any but samplesPerPixel and exposure drops
+        /// the samples accumulated so far.
+        /// @param samplesPerPixel the samples added to each pixel by the call.
+        /// @param maxBounces      the most bounces of a path. paths also end by russian roulette after 3 bounces.
+        /// @param skyColor        the light from every direction that misses the scene.
+        /// @param sunDirection    the world space direction toward the sun.
+        /// @param sunColor        the light of the sun. the sun is sampled directly at each diffuse bounce, with a
+        ///                        shadow ray. zero turns it off.
+        /// @param exposure        scales the average of the samples before it is sRGB encoded and clamped.
+        struct path_settings_t {
+            uint32_t     samplesPerPixel = 1;
+            uint32_t     maxBounces      = 4;
+            math::vec3_t skyColor        = math::vec3_t(0.6f, 0.7f, 0.9f);
+            math::vec3_t sunDirection    = math::vec3_t(0.f, 1.f, 0.f);
+            math::vec3_t sunColor        = math::vec3_t(0.f, 0.f, 0.f);
+            float        exposure        = 1.f;
+        };
+
+        /// @brief a struct of the counts and the timing of a renderPath call.
+        /// @param triangles          the triangles in the scene.
+        /// @param bvhNodes           the nodes of the BVH over them.
+        /// @param accumulatedSamples the samples of each pixel in the image, including those of this call.
+        /// @param samples            the samples traced by this call, over all pixels.
+        /// @param rays               the rays traced by this call, including bounces and shadow rays.
+        /// @param seconds            the wall time of the call. zero if the platform has no timer.
+        struct path_stats_t {
+            uint32_t triangles;
+            uint32_t bvhNodes;
+            uint32_t accumulatedSamples;
+            uint64_t samples;
+            uint64_t rays;
+            float    seconds;
+            float    samplesPerSecond;
+            float    raysPerSecond;
+        };
+
+        /// @brief a struct describing a string for drawTexts.
+        /// @param pixelSize the size of the font, as the height of its em square in pixels.
+        /// @param x         the left of the string in the target.
+        /// @param y         the top of the first line, i.e. the ascender of the font is above the baseline by this.
+        /// @param text      UTF-8, where '\n' starts a new line. a malformed sequence draws as U+FFFD.
+        /// @param color     0xAARRGGBB, blended over the target by its alpha and the coverage of the glyphs.
+        struct text_draw_t {
+            font_t     *font;
+            uint32_t    pixelSize;
+            float       x;
+            float       y;
+            const char *text;
+            uint32_t    color;
+        };
+
+        /// @brief a struct of the size of a string as it would be drawn.
+        /// @param width      the advance of the widest line.
+        /// @param height     from the ascender of the first line to the descender of the last.
+        /// @param ascent     the height of the font above the baseline.
+        /// @param descent    the depth of the font below the baseline, as a positive number.
+        /// @param lineHeight the distance between the baselines of the lines.
+        struct text_metrics_t {
+            float    width;
+            float    height;
+            float    ascent;
+            float    descent;
+            float    lineHeight;
+            uint32_t lines;
+        };
+
+        /// @brief a struct of the counts of a glyph cache.
+        /// @param glyphs      the glyphs in the atlas.
+        /// @param rasterized  the glyphs that were rasterized, since the cache was created.
+        /// @param hits        the lookups that found a glyph in the atlas, since the cache was created.
+        /// @param atlasResets the times that the atlas filled up and was emptied.
+        struct glyph_cache_stats_t {
+            uint32_t glyphs;
+            uint64_t rasterized;
+            uint64_t hits;
+            uint32_t atlasResets;
+        };
+
+        /// @brief a struct of a vertex of a UI triangle. the layout is that of ImDrawVert.
+        /// @param x     in the units of ui_draw_data_t, e.g. ImGui display coordinates.
+        /// @param u     the texture coordinate, from 0 to 1. v = 0 is the top row of the texture.
+        /// @param color 0xAABBGGRR, i.e. IM_COL32, not premultiplied.
+        struct ui_vertex_t {
+            float    x;
+            float    y;
+            float    u;
+            float    v;
+            uint32_t color;
+        };
+
+        /// @brief a struct of a draw of a ui_draw_list_t, i.e. an ImDrawCmd.
+        /// @param clipMinX     the pixels outside of the clip rectangle are not drawn. in the units of the vertices.
+        /// @param texture      if not null, sampled with nearest filtering and clamped to its edges. the pixels are
+        ///                     premultiplied 0xABGR with the bottom row first, as for sprite_quad_t.
+        /// @param vertexOffset added to each index of the draw.
+        /// @param indexOffset  the first index of the draw.
+        /// @param indexCount   three per triangle.
+        struct ui_command_t {
+            float                 clipMinX;
+            float                 clipMinY;
+            float                 clipMaxX;
+            float                 clipMaxY;
+            const loaded_image_t *texture;
+            uint32_t              vertexOffset;
+            uint32_t              indexOffset;
+            uint32_t              indexCount;
+        };
+
+        /// @brief a struct of the buffers of a UI draw list, i.e. an ImDrawList.
+        struct ui_draw_list_t {
+            const ui_vertex_t  *vertices;
+            uint32_t            vertexCount;
+            const uint16_t     *indices;
+            uint32_t            indexCount;
+            const ui_command_t *commands;
+            uint32_t            commandCount;
+        };
+
+        /// @brief a struct of a frame of UI draw lists, i.e. an ImDrawData.
+        /// @param displayX the position of the top left of the target, in the units of the vertices.
+        /// @param scaleX   the pixels per unit, e.g. ImDrawData::FramebufferScale.
+        struct ui_draw_data_t {
+            const ui_draw_list_t *lists;
+            uint32_t              listCount;
+            float                 displayX = 0.f;
+            float                 displayY = 0.f;
+            float                 scaleX   = 1.f;
+            float                 scaleY   = 1.f;
+        };
+
+        /// @brief a struct of the counts of a renderUi call.
+        /// @param triangles  the triangles that were drawn as triangles.
+        /// @param rects      the pairs of triangles that were drawn as axis aligned rectangles.
+        /// @param culled     the triangles that were degenerate, clipped away or that had invalid indices.
+        /// @param tileShapes the sum over the tiles of the triangles and rectangles binned to each.
+        struct ui_stats_t {
+            uint32_t triangles;
+            uint32_t rects;
+            uint32_t culled;
+            uint32_t tileShapes;
+        };
+
+        /// @brief a struct of the counts of a backbuffer ring, since it was created.
+        /// @param submitted   the frames that the renderer submitted.
+        /// @param presented   the frames that the presenter acquired.
+        /// @param dropped     the frames that a newer one replaced before they were presented.
+        /// @param allocations the times that the pixels of a buffer grew.
+        /// @param copiedBytes the bytes copied into acquired buffers to bring them up to the last frame.
+        struct backbuffer_ring_stats_t {
+            uint64_t submitted;
+            uint64_t presented;
+            uint64_t dropped;
+            uint64_t allocations;
+            uint64_t copiedBytes;
+        };
+    }  // namespace frender
+
 #if defined(AUTOMATA_ENGINE_VK_BACKEND)
     namespace VK {
         struct RenderPass : public VkRenderPassCreateInfo {};
@@ -1556,6 +3119,12 @@ namespace automata_engine {
                 ci.flags              = flags;
                 return *this;
             }
+            Image &mipLevels(uint32_t levels)
+            {
+                VkImageCreateInfo &ci = *this;
+                ci.mipLevels          = levels;
+                return *this;
+            }
         };
 
         struct PipelineLayout : public VkPipelineLayoutCreateInfo {
@@ -62,32 +62,12 @@ namespace automata_engine {
 #endif
 
     loaded_image_t platform::stbImageLoad(const char *fileName) {
-        int x, y, n;
-        int desired_channels=4;
+        // NOTE(Noah): For now, let's avoid .jpg.
+        // seems stb image loader has troubles with a subset of .jpg,
+        // and I would rather not put any effort into determining precisely
+        // which .jpg I have.
         loaded_image_t myImage = {};
-        loaded_file_t myFile = EM->pfn.readEntireFile(fileName);
-        if (myFile.contents) {
-            myImage.parentFile = myFile;
-            // NOTE(Noah): For now, let's avoid .jpg.
-            // seems stb image loader has troubles with a subset of .jpg,
-            // and I would rather not put any effort into determining precisely
-            // which .jpg I have.
-            
-            //unsigned char *data = stbi_load(fileName, &x, &y, &n, 0);
-            unsigned char *data = stbi_load_from_memory((stbi_uc*)myFile.contents, myFile.contentSize, &x,
-                                      &y, &n, desired_channels);
-            if (data != NULL) {
-              myImage.pixelPointer = (uint32_t *)data;
-              myImage.width = x;
-              myImage.height = y;
-              // assert(n == 4);
-            } else {
-              // TODO(Noah): Do something intelligent in the case of failure
-              // here.
-              //               AELoggerError(EM, "ae::platform::stbImageLoad failed");
-              assert(false);
-            }
-        }
+        io::loadImages(&fileName, 1, &myImage);
         return myImage;
     }
 
@@ -243,6 +223,10 @@ namespace automata_engine {
 #endif
     }
     void shutdownModuleGlobals() {
+        // NOTE: the asset cache may have loads in flight on the job system, so it must be cleared first.
+        ae::asset::clear();
+        ae::jobs::shutdown();
+        ae::audio::stopStreamDecoder();
 #if defined(AUTOMATA_ENGINE_DX12_BACKEND) || defined(AUTOMATA_ENGINE_VK_BACKEND)
         ae::HLSL::_close();
 #endif
@@ -1,5 +1,7 @@
 
 #define NC_STR_IMPL
+#define AE_PAK_IMPL
+#define AE_FRENDER_IMPL
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 
@@ -12,6 +14,13 @@
 #include "automata_engine.cpp"
 #include "automata_engine_io.cpp"
 #include "automata_engine_frender.cpp"
+#include "automata_engine_text.cpp"
+#include "automata_engine_mesh.cpp"
+#include "automata_engine_jobs.cpp"
+#include "automata_engine_asset.cpp"
+#include "automata_engine_texture.cpp"
+#include "automata_engine_audio.cpp"
+#include "automata_engine_dsp.cpp"
 
 #if defined(AUTOMATA_ENGINE_DX12_BACKEND)
 #include "automata_engine_dx.cpp"
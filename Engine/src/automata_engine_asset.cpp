@@ -0,0 +1,359 @@
+#include <automata_engine.hpp>
+
+#include <automata_engine_utils.hpp>
+
+#include "automata_engine_pak.h"
+// NOTE: stb_ds is implemented (and so already included) by automata_engine_io.cpp within the amalgamation.
+#if !defined(INCLUDE_STB_DS_H)
+#include "stb_ds.h"
+#endif
+
+#include <condition_variable>
+
+namespace automata_engine {
+    namespace asset {
+
+        enum asset_type_t { ASSET_TYPE_IMAGE, ASSET_TYPE_MODEL, ASSET_TYPE_WAV };
+
+        struct asset_slot_t {
+            char         *path;  // normalized. null when the slot is free.
+            uint64_t      pathHash;
+            uint32_t      generation;
+            uint32_t      refCount;
+            asset_type_t  type;
+            asset_state_t state;
+            uint64_t      bytes;
+            uint64_t      lastUse;
+            union {
+                loaded_image_t image;
+                raw_model_t    model;
+                loaded_wav_t   wav;
+            };
+        };
+
+        // NOTE: slots are addressed by index and never by pointer, since the stretchy buffer may move when it grows.
+        static asset_slot_t *g_slots     = nullptr;  // stretchy buf
+        static uint32_t     *g_freeSlots = nullptr;  // stretchy buf
+        static struct {
+            uint64_t key;
+            uint32_t value;
+        } *g_pathMap = nullptr;  // stb_ds hashmap
+
+        static std::mutex              g_mutex;
+        static std::condition_variable g_loadCv;
+        static uint64_t                g_memoryBudget = ASSET_DEFAULT_MEMORY_BUDGET;
+        static uint64_t                g_memoryUsage  = 0;
+        static uint64_t                g_useClock     = 0;
+        static uint32_t                g_pendingLoads = 0;
+
+        static char *CopyString(const char *str)
+        {
+            size_t len  = strlen(str) + 1;
+            char  *copy = (char *)malloc(len);
+            memcpy(copy, str, len);
+            return copy;
+        }
+
+        static asset_slot_t *GetSlotLocked(asset_handle_t handle)
+        {
+            if (handle.generation == 0 || handle.index >= (uint32_t)StretchyBufferCount(g_slots)) return nullptr;
+            asset_slot_t *slot = &g_slots[handle.index];
+            return (slot->path && slot->generation == handle.generation) ? slot : nullptr;
+        }
+
+        static void FreeSlotLocked(uint32_t index)
+        {
+            asset_slot_t &slot = g_slots[index];
+            assert(slot.state != ASSET_STATE_LOADING);
+            if (slot.state == ASSET_STATE_LOADED) {
+                switch (slot.type) {
+                    case ASSET_TYPE_IMAGE:
+                        io::freeLoadedImage(slot.image);
+                        break;
+                    case ASSET_TYPE_MODEL:
+                        io::freeObj(slot.model);
+                        break;
+                    case ASSET_TYPE_WAV:
+                        io::freeWav(slot.wav);
+                        break;
+                }
+            }
+            g_memoryUsage -= slot.bytes;
+            stbds_hmdel(g_pathMap, slot.pathHash);
+            free(slot.path);
+            slot.path  = nullptr;
+            slot.state = ASSET_STATE_INVALID;
+            // NOTE: bumping the generation here is what makes outstanding handles stale.
+            slot.generation++;
+            if (slot.generation == 0) slot.generation = 1;
+            StretchyBufferPush(g_freeSlots, index);
+        }
+
+        // evict the least recently used unreferenced assets until the cache is within budget.
+        static void EvictLocked(uint64_t budget)
+        {
+            while (g_memoryUsage > budget) {
+                uint32_t victim = UINT32_MAX;
+                for (uint32_t i = 0; i < (uint32_t)StretchyBufferCount(g_slots); i++) {
+                    const asset_slot_t &slot = g_slots[i];
+                    if (!slot.path || slot.refCount || slot.state == ASSET_STATE_LOADING) continue;
+                    if (victim == UINT32_MAX || slot.lastUse < g_slots[victim].lastUse) victim = i;
+                }
+                if (victim == UINT32_MAX) break;
+                FreeSlotLocked(victim);
+            }
+        }
+
+        // do the actual load and decode. runs without the lock held.
+        static void LoadAsset(uint32_t index, uint32_t generation, asset_type_t type, const char *path)
+        {
+            asset_slot_t loaded = {};
+            bool         bOk    = false;
+            switch (type) {
+                case ASSET_TYPE_IMAGE: {
+                    loaded.image = platform::stbImageLoad(path);
+                    bOk          = loaded.image.pixelPointer != nullptr;
+                    loaded.bytes = uint64_t(loaded.image.width) * loaded.image.height * sizeof(uint32_t) +
+                                   loaded.image.parentFile.contentSize;
+                } break;
+                case ASSET_TYPE_MODEL: {
+                    loaded.model = io::loadObj(path);
+                    bOk          = loaded.model.vertexData != nullptr;
+                    loaded.bytes = sizeof(float) * StretchyBufferCount(loaded.model.vertexData) +
+                                   sizeof(uint32_t) * StretchyBufferCount(loaded.model.indexData);
+                } break;
+                case ASSET_TYPE_WAV: {
+                    loaded.wav   = io::loadWav(path);
+                    bOk          = loaded.wav.sampleData != nullptr;
+                    loaded.bytes = loaded.wav.parentFile.contentSize;
+                } break;
+            }
+            if (!bOk) {
+                AELoggerError("asset cache failed to load '%s'", path);
+                // NOTE: a failed load may still have read the file.
+                switch (type) {
+                    case ASSET_TYPE_IMAGE:
+                        EM->pfn.freeLoadedFile(loaded.image.parentFile);
+                        break;
+                    case ASSET_TYPE_MODEL:
+                        io::freeObj(loaded.model);
+                        break;
+                    case ASSET_TYPE_WAV:
+                        io::freeWav(loaded.wav);
+                        break;
+                }
+                loaded.bytes = 0;
+            }
+
+            std::lock_guard<std::mutex> lock(g_mutex);
+            asset_slot_t               &slot = g_slots[index];
+            assert(slot.generation == generation && slot.state == ASSET_STATE_LOADING);
+            slot.state = bOk ? ASSET_STATE_LOADED : ASSET_STATE_FAILED;
+            slot.bytes = loaded.bytes;
+            switch (type) {
+                case ASSET_TYPE_IMAGE:
+                    slot.image = loaded.image;
+                    break;
+                case ASSET_TYPE_MODEL:
+                    slot.model = loaded.model;
+                    break;
+                case ASSET_TYPE_WAV:
+                    slot.wav = loaded.wav;
+                    break;
+            }
+            g_memoryUsage += slot.bytes;
+            EvictLocked(g_memoryBudget);
+            g_loadCv.notify_all();
+        }
+
+        // load a slot that is ASSET_STATE_LOADING, on a worker thread if bAsync. releases the lock.
+        static void StartLoad(
+            std::unique_lock<std::mutex> &lock, uint32_t index, asset_type_t type, const char *path, bool bAsync)
+        {
+            char    *pathCopy   = CopyString(path);
+            uint32_t generation = g_slots[index].generation;
+
+            if (bAsync) {
+                g_pendingLoads++;
+                lock.unlock();
+                jobs::submit([=]() {
+                    LoadAsset(index, generation, type, pathCopy);
+                    free(pathCopy);
+                    std::lock_guard<std::mutex> lock(g_mutex);
+                    g_pendingLoads--;
+                    g_loadCv.notify_all();
+                });
+            } else {
+                lock.unlock();
+                LoadAsset(index, generation, type, pathCopy);
+                free(pathCopy);
+            }
+        }
+
+        static asset_handle_t Load(const char *path, asset_type_t type, bool bAsync)
+        {
+            char normalized[260];
+            if (!pak::normalizePath(path, normalized, sizeof(normalized))) {
+                AELoggerError("asset path too long '%s'", path);
+                return {};
+            }
+            uint64_t hash = pak::hashPath(normalized);
+
+            std::unique_lock<std::mutex> lock(g_mutex);
+
+            // dedupe.
+            ptrdiff_t mapIndex = stbds_hmgeti(g_pathMap, hash);
+            if (mapIndex != -1) {
+                uint32_t      index = g_pathMap[mapIndex].value;
+                asset_slot_t &slot  = g_slots[index];
+                if (slot.type != type || strcmp(slot.path, normalized) != 0) {
+                    AELoggerError("asset '%s' collides with cached asset '%s'", normalized, slot.path);
+                    return {};
+                }
+                slot.refCount++;
+                slot.lastUse          = ++g_useClock;
+                asset_handle_t handle = {index, slot.generation};
+                // NOTE: a failed asset is loaded again, as the file may have been written or fixed since.
+                if (slot.state == ASSET_STATE_FAILED) {
+                    slot.state = ASSET_STATE_LOADING;
+                    StartLoad(lock, index, type, path, bAsync);
+                    return handle;
+                }
+                if (!bAsync) g_loadCv.wait(lock, [&] { return g_slots[index].state != ASSET_STATE_LOADING; });
+                return handle;
+            }
+
+            uint32_t index;
+            if (StretchyBufferCount(g_freeSlots)) {
+                index = StretchyBufferPop(g_freeSlots);
+            } else {
+                asset_slot_t empty = {};
+                empty.generation   = 1;
+                StretchyBufferPush(g_slots, empty);
+                index = StretchyBufferCount(g_slots) - 1;
+            }
+
+            asset_slot_t &slot = g_slots[index];
+            slot.path          = CopyString(normalized);
+            slot.pathHash      = hash;
+            slot.refCount      = 1;
+            slot.type          = type;
+            slot.state         = ASSET_STATE_LOADING;
+            slot.bytes         = 0;
+            slot.lastUse       = ++g_useClock;
+            stbds_hmput(g_pathMap, hash, index);
+
+            asset_handle_t handle = {index, slot.generation};
+            StartLoad(lock, index, type, path, bAsync);
+            return handle;
+        }
+
+        asset_handle_t loadImage(const char *path, bool bAsync) { return Load(path, ASSET_TYPE_IMAGE, bAsync); }
+        asset_handle_t loadModel(const char *path, bool bAsync) { return Load(path, ASSET_TYPE_MODEL, bAsync); }
+        asset_handle_t loadWav(const char *path, bool bAsync) { return Load(path, ASSET_TYPE_WAV, bAsync); }
+
+        void acquire(asset_handle_t handle)
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            asset_slot_t               *slot = GetSlotLocked(handle);
+            assert(slot);
+            if (slot) slot->refCount++;
+        }
+
+        void release(asset_handle_t handle)
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            asset_slot_t               *slot = GetSlotLocked(handle);
+            assert(slot && slot->refCount);
+            if (!slot || !slot->refCount) return;
+            slot->refCount--;
+            slot->lastUse = ++g_useClock;
+            if (slot->refCount == 0) EvictLocked(g_memoryBudget);
+        }
+
+        asset_state_t getState(asset_handle_t handle)
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            asset_slot_t               *slot = GetSlotLocked(handle);
+            return slot ? slot->state : ASSET_STATE_INVALID;
+        }
+
+        asset_state_t wait(asset_handle_t handle)
+        {
+            std::unique_lock<std::mutex> lock(g_mutex);
+            asset_slot_t                *slot;
+            g_loadCv.wait(lock, [&] {
+                slot = GetSlotLocked(handle);
+                return !slot || slot->state != ASSET_STATE_LOADING;
+            });
+            return slot ? slot->state : ASSET_STATE_INVALID;
+        }
+
+        // returns null unless the handle refers to a loaded asset of the requested type.
+        static asset_slot_t *GetLoadedSlotLocked(asset_handle_t handle, asset_type_t type)
+        {
+            asset_slot_t *slot = GetSlotLocked(handle);
+            if (!slot || slot->type != type || slot->state != ASSET_STATE_LOADED) return nullptr;
+            slot->lastUse = ++g_useClock;
+            return slot;
+        }
+
+        loaded_image_t getImage(asset_handle_t handle)
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            asset_slot_t               *slot = GetLoadedSlotLocked(handle, ASSET_TYPE_IMAGE);
+            return slot ? slot->image : loaded_image_t{};
+        }
+
+        raw_model_t getModel(asset_handle_t handle)
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            asset_slot_t               *slot = GetLoadedSlotLocked(handle, ASSET_TYPE_MODEL);
+            return slot ? slot->model : raw_model_t{};
+        }
+
+        loaded_wav_t getWav(asset_handle_t handle)
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            asset_slot_t               *slot = GetLoadedSlotLocked(handle, ASSET_TYPE_WAV);
+            return slot ? slot->wav : loaded_wav_t{};
+        }
+
+        void setMemoryBudget(uint64_t bytes)
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            g_memoryBudget = bytes;
+            EvictLocked(g_memoryBudget);
+        }
+
+        uint64_t getMemoryUsage()
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            return g_memoryUsage;
+        }
+
+        void evictUnused()
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            EvictLocked(0);
+        }
+
+        void clear()
+        {
+            std::unique_lock<std::mutex> lock(g_mutex);
+            g_loadCv.wait(lock, [] { return g_pendingLoads == 0; });
+            for (uint32_t i = 0; i < (uint32_t)StretchyBufferCount(g_slots); i++) {
+                if (g_slots[i].path) FreeSlotLocked(i);
+            }
+            assert(g_memoryUsage == 0);
+            StretchyBufferFree(g_slots);
+            StretchyBufferFree(g_freeSlots);
+            stbds_hmfree(g_pathMap);
+            g_slots        = nullptr;
+            g_freeSlots    = nullptr;
+            g_memoryUsage  = 0;
+            g_memoryBudget = ASSET_DEFAULT_MEMORY_BUDGET;
+        }
+
+    }  // namespace asset
+}  // namespace automata_engine
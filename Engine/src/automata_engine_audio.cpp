@@ -0,0 +1,1519 @@
+#include <automata_engine.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <emmintrin.h>
+
+namespace automata_engine {
+    namespace audio {
+
+        enum stream_slot_state_t : uint32_t { STREAM_SLOT_FREE = 0, STREAM_SLOT_READY };
+
+        struct stream_slot_t {
+            std::atomic<uint32_t> state;
+            uint32_t              frameCount;
+            uint32_t              generation;  // the seek generation that the slot was decoded in.
+            bool                  bLast;
+            int16_t               samples[AUDIO_STREAM_BUFFER_FRAMES * 2];
+        };
+
+        // NOTE: the ring of slots is single producer, single consumer. the decoder thread is the producer and whoever
+        // calls readStream (the audio thread) is the consumer. a slot is handed from one to the other through its
+        // state, so the consumer never takes a lock.
+        struct audio_stream_t {
+            std::string           fileName;
+            io::audio_format_t    format;
+            uint32_t              frameSize;
+            uint32_t              dataOffset;
+            uint32_t              frameCount;  // of the file, which is not at the mix rate in general.
+            bool                  bLoop;
+            std::atomic<uint32_t> refCount;    // the owner plus the decoder thread while it decodes the stream.
+            std::atomic<bool>     bClosed;
+
+            // seeks come from the game thread and are applied by the decoder thread.
+            std::mutex            seekMutex;
+            uint64_t              seekFrame;
+            std::atomic<uint32_t> seekGeneration;
+
+            // producer state.
+            io::audio_converter_t *converter;
+            std::vector<uint8_t>   fileChunk;
+            std::atomic<uint32_t>  decodeGeneration;
+            std::atomic<bool>      bSourceEnded;
+            uint32_t               cursor;  // the next frame of the file to decode.
+            uint32_t               writeSlot;
+
+            // consumer state.
+            uint32_t          readSlot;
+            uint32_t          readOffset;
+            uint32_t          readGeneration;
+            std::atomic<bool> bEnded;
+
+            stream_slot_t slots[AUDIO_STREAM_BUFFER_COUNT];
+        };
+
+        // the largest chunk of the file whose converted frames fit in a slot, including the frames that the
+        // converter flushes at the end of the file.
+        static uint32_t GetStreamChunkFrames(audio_stream_t *stream)
+        {
+            uint32_t count = uint32_t(uint64_t(AUDIO_STREAM_BUFFER_FRAMES) * stream->format.sampleRate /
+                                      io::ENGINE_DESIRED_SAMPLES_PER_SECOND);
+            while (count > 1 && io::getMaxConvertedFrames(stream->converter, count) > AUDIO_STREAM_BUFFER_FRAMES)
+                count -= math::max(1u, count / 64);
+            return count;
+        }
+
+        // decode the next chunk of the file into the slot after the last one decoded.
+        // returns false if there is no free slot or nothing left to decode.
+        static bool DecodeStreamSlot(audio_stream_t *stream)
+        {
+            if (stream->bClosed.load()) return false;
+            stream_slot_t *slot = &stream->slots[stream->writeSlot];
+            if (slot->state.load(std::memory_order_acquire) != STREAM_SLOT_FREE) return false;
+
+            if (stream->seekGeneration.load() != stream->decodeGeneration.load()) {
+                uint64_t frame;
+                {
+                    std::lock_guard<std::mutex> lock(stream->seekMutex);
+                    frame = stream->seekFrame;
+                    stream->decodeGeneration.store(stream->seekGeneration.load());
+                }
+                // NOTE: the seek is in frames of the mix rate and the cursor is in frames of the file.
+                uint64_t cursor = frame * stream->format.sampleRate / io::ENGINE_DESIRED_SAMPLES_PER_SECOND;
+                stream->cursor  = uint32_t(math::min(cursor, uint64_t(stream->frameCount)));
+                std::vector<int16_t> discard(size_t(io::getMaxConvertedFrames(stream->converter, 0)) * 2);
+                io::flushAudioConverter(stream->converter, discard.data());
+                stream->bSourceEnded.store(false);
+            }
+            if (stream->bSourceEnded.load()) return false;
+
+            uint32_t budget = GetStreamChunkFrames(stream), written = 0;
+            bool     bLast  = false;
+            while (budget) {
+                uint32_t count = math::min(budget, stream->frameCount - stream->cursor);
+                bool     bTruncated = false;
+                if (count) {
+                    uint32_t size = count * stream->frameSize;
+                    stream->fileChunk.resize(size);
+                    uint32_t bytesRead = EM->pfn.readFileRange(stream->fileName.c_str(),
+                        stream->dataOffset + uint64_t(stream->cursor) * stream->frameSize,
+                        stream->fileChunk.data(),
+                        size);
+                    if (bytesRead != size) {
+                        AELoggerWarn("%s is truncated at frame %u of %u",
+                            stream->fileName.c_str(),
+                            stream->cursor + bytesRead / stream->frameSize,
+                            stream->frameCount);
+                        count      = bytesRead / stream->frameSize;
+                        bTruncated = true;
+                    }
+                    written += io::convertAudio(stream->converter, stream->fileChunk.data(), count,
+                        slot->samples + size_t(written) * 2);
+                    stream->cursor += count;
+                    budget -= count;
+                }
+                if (bTruncated || stream->cursor == stream->frameCount) {
+                    // NOTE: the converter is not flushed on a loop, so the resampler runs across the seam.
+                    if (stream->bLoop && !bTruncated) {
+                        stream->cursor = 0;
+                        continue;
+                    }
+                    written += io::flushAudioConverter(stream->converter, slot->samples + size_t(written) * 2);
+                    stream->bSourceEnded.store(true);
+                    bLast = true;
+                    break;
+                }
+            }
+
+            slot->frameCount = written;
+            slot->generation = stream->decodeGeneration.load();
+            slot->bLast      = bLast;
+            slot->state.store(STREAM_SLOT_READY, std::memory_order_release);
+            stream->writeSlot = (stream->writeSlot + 1) % AUDIO_STREAM_BUFFER_COUNT;
+            return true;
+        }
+
+        static void ReleaseStream(audio_stream_t *stream)
+        {
+            if (stream->refCount.fetch_sub(1) != 1) return;
+            io::destroyAudioConverter(stream->converter);
+            delete stream;
+        }
+
+        // NOTE: every stream is decoded by the one decoder thread, which the first openStream starts. the audio thread
+        // only bumps the wake counter when it frees a slot, so readStream never takes a lock or allocates.
+        struct stream_decoder_t {
+            std::mutex                    mutex;  // guards the streams and the thread.
+            std::vector<audio_stream_t *> streams;
+            std::thread                  *thread;
+            std::atomic<bool>             bStop;
+            std::atomic<uint32_t>         wake;
+        };
+
+        static stream_decoder_t g_decoder = {};
+
+        static void WakeDecoder()
+        {
+            g_decoder.wake.fetch_add(1);
+            g_decoder.wake.notify_one();
+        }
+
+        static void DecoderMain()
+        {
+            std::vector<audio_stream_t *> streams;
+            while (true) {
+                // NOTE: the counter is read before the streams are looked at, so a wake that comes in while they are
+                // decoded makes the wait below return right away.
+                uint32_t wake = g_decoder.wake.load();
+                if (g_decoder.bStop.load()) return;
+                {
+                    std::lock_guard<std::mutex> lock(g_decoder.mutex);
+                    streams = g_decoder.streams;
+                    for (audio_stream_t *stream : streams) stream->refCount.fetch_add(1);
+                }
+                // the streams are decoded outside of the lock so that openStream and closeStream never wait on disk.
+                for (audio_stream_t *stream : streams) {
+                    while (DecodeStreamSlot(stream)) {}
+                    ReleaseStream(stream);
+                }
+                g_decoder.wake.wait(wake);
+            }
+        }
+
+        void stopStreamDecoder()
+        {
+            std::thread *thread;
+            {
+                std::lock_guard<std::mutex> lock(g_decoder.mutex);
+                thread           = g_decoder.thread;
+                g_decoder.thread = nullptr;
+            }
+            if (!thread) return;
+            g_decoder.bStop.store(true);
+            WakeDecoder();
+            thread->join();
+            delete thread;
+            g_decoder.bStop.store(false);
+        }
+
+        audio_stream_t *openStream(const char *fileName, bool bLoop)
+        {
+            io::audio_format_t format = {};
+            uint32_t           dataOffset, dataSize;
+            if (!io::readWavInfo(fileName, &format, &dataOffset, &dataSize)) {
+                AELoggerError("unable to stream %s. the .WAV file is malformed or of an unsupported format.", fileName);
+                return nullptr;
+            }
+            io::audio_converter_t *converter = io::createAudioConverter(format, io::RESAMPLE_QUALITY_DEFAULT);
+            uint32_t               frameSize = format.channels * format.bitsPerSample / 8;
+            if (!converter || dataSize < frameSize) {
+                AELoggerError("unable to stream %s. the file has no samples of a supported format.", fileName);
+                io::destroyAudioConverter(converter);
+                return nullptr;
+            }
+
+            audio_stream_t *stream = new audio_stream_t();
+            stream->fileName       = fileName;
+            stream->format         = format;
+            stream->frameSize      = frameSize;
+            stream->dataOffset     = dataOffset;
+            stream->frameCount     = dataSize / frameSize;
+            stream->bLoop          = bLoop;
+            stream->refCount       = 1;
+            stream->converter      = converter;
+
+            // NOTE: the first buffer is decoded right away so that a voice can start on the stream without a gap.
+            DecodeStreamSlot(stream);
+            {
+                std::lock_guard<std::mutex> lock(g_decoder.mutex);
+                g_decoder.streams.push_back(stream);
+                if (!g_decoder.thread) g_decoder.thread = new std::thread(DecoderMain);
+            }
+            WakeDecoder();
+            return stream;
+        }
+
+        void closeStream(audio_stream_t *stream)
+        {
+            if (!stream) return;
+            // NOTE: the decoder thread holds a reference while it decodes, so the stream lives on until then.
+            {
+                std::lock_guard<std::mutex> lock(g_decoder.mutex);
+                g_decoder.streams.erase(std::find(g_decoder.streams.begin(), g_decoder.streams.end(), stream));
+            }
+            stream->bClosed.store(true);
+            ReleaseStream(stream);
+        }
+
+        uint64_t getStreamLength(audio_stream_t *stream)
+        {
+            uint64_t rate = stream->format.sampleRate;
+            return (uint64_t(stream->frameCount) * io::ENGINE_DESIRED_SAMPLES_PER_SECOND + rate - 1) / rate;
+        }
+
+        void seekStream(audio_stream_t *stream, uint64_t frame)
+        {
+            {
+                std::lock_guard<std::mutex> lock(stream->seekMutex);
+                stream->seekFrame = frame;
+                stream->seekGeneration.fetch_add(1);
+            }
+            stream->bEnded.store(false);
+            WakeDecoder();
+        }
+
+        uint32_t readStream(audio_stream_t *stream, int16_t *dst, uint32_t frameCount)
+        {
+            uint32_t generation = stream->seekGeneration.load();
+            if (generation != stream->readGeneration) {
+                stream->readGeneration = generation;
+                stream->bEnded.store(false);
+            }
+            if (stream->bEnded.load()) return 0;
+
+            uint32_t written = 0;
+            bool     bFreed  = false;
+            while (written < frameCount) {
+                stream_slot_t *slot = &stream->slots[stream->readSlot];
+                if (slot->state.load(std::memory_order_acquire) != STREAM_SLOT_READY) break;
+                // slots decoded before a seek are dropped.
+                bool bStale = slot->generation != generation;
+                if (!bStale) {
+                    uint32_t count = math::min(frameCount - written, slot->frameCount - stream->readOffset);
+                    memcpy(dst + size_t(written) * 2, slot->samples + size_t(stream->readOffset) * 2,
+                        size_t(count) * 2 * sizeof(int16_t));
+                    written += count;
+                    stream->readOffset += count;
+                    if (stream->readOffset < slot->frameCount) break;
+                }
+                bool bLast         = !bStale && slot->bLast;
+                stream->readOffset = 0;
+                slot->state.store(STREAM_SLOT_FREE, std::memory_order_release);
+                stream->readSlot = (stream->readSlot + 1) % AUDIO_STREAM_BUFFER_COUNT;
+                bFreed           = true;
+                if (bLast) {
+                    stream->bEnded.store(true);
+                    break;
+                }
+            }
+            if (bFreed) WakeDecoder();
+            return written;
+        }
+
+        bool isStreamEnded(audio_stream_t *stream) { return stream->bEnded.load(); }
+
+        static uint32_t StreamFillCallback(void *user, int16_t *dst, uint32_t frameCount)
+        {
+            audio_stream_t *stream  = (audio_stream_t *)user;
+            uint32_t        written = readStream(stream, dst, frameCount);
+            if (written == frameCount || isStreamEnded(stream)) return written;
+            // the decoder fell behind. the gap is filled with silence so that the voice keeps playing.
+            memset(dst + size_t(written) * 2, 0, size_t(frameCount - written) * 2 * sizeof(int16_t));
+            return frameCount;
+        }
+
+        static void ReleaseWavVoice(intptr_t voiceHandle, struct wav_voice_t *state = nullptr);
+
+        bool voiceSubmitStream(intptr_t voiceHandle, audio_stream_t *stream)
+        {
+            if (!stream || !EM->pfn.voiceSubmitCallback) return false;
+            if (!EM->pfn.voiceSubmitCallback(voiceHandle, StreamFillCallback, stream)) return false;
+            ReleaseWavVoice(voiceHandle);
+            return true;
+        }
+
+        // NOTE: compressed blocks are decoded into the cache as many at a time as decodeWavBlocks decodes in one
+        // pass, so the cache is at most 4 blocks of the mix format.
+        struct wav_source_t {
+            loaded_wav_t         wav;
+            uint32_t             cacheFirst;
+            uint32_t             cacheFrames;
+            std::vector<int16_t> cache;
+        };
+
+        static void InitWavSource(wav_source_t *source, const loaded_wav_t &wav)
+        {
+            source->wav         = wav;
+            source->cacheFirst  = 0;
+            source->cacheFrames = 0;
+            if (wav.encoding != io::WAV_ENCODING_PCM16)
+                source->cache.resize(size_t(4 / wav.channels) * wav.framesPerBlock * 2);
+        }
+
+        // get the 16-bit stereo frames of a wav from frame on, which must be within the wav.
+        static const int16_t *GetWavFrames(wav_source_t *source, uint32_t frame, uint32_t *pAvailable)
+        {
+            const loaded_wav_t &wav = source->wav;
+            if (wav.encoding == io::WAV_ENCODING_PCM16) {
+                *pAvailable = uint32_t(wav.sampleCount) - frame;
+                return wav.sampleData + size_t(frame) * 2;
+            }
+            if (frame < source->cacheFirst || frame >= source->cacheFirst + source->cacheFrames) {
+                uint32_t block      = frame / wav.framesPerBlock;
+                source->cacheFirst  = block * wav.framesPerBlock;
+                source->cacheFrames = io::decodeWavBlocks(wav, block, 4 / wav.channels, source->cache.data());
+            }
+            *pAvailable = source->cacheFirst + source->cacheFrames - frame;
+            return source->cache.data() + size_t(frame - source->cacheFirst) * 2;
+        }
+
+        struct wav_voice_t {
+            wav_source_t source;
+            bool         bLoop;
+            uint32_t     cursor;  // the next frame to play.
+        };
+
+        // the state of the voices that play a wav through a callback, indexed by voice handle. the state of a voice
+        // is released when the voice is given other sound through the audio functions, once the platform no longer
+        // calls back with it. sound submitted straight to EM->pfn is not seen here, so the state lives on until then.
+        static std::mutex                 g_wavVoiceMutex;
+        static std::vector<wav_voice_t *> g_wavVoices;
+
+        // replace the state of a voice. this must only be called once the voice has been given its new sound.
+        static void ReleaseWavVoice(intptr_t voiceHandle, wav_voice_t *state)
+        {
+            std::lock_guard<std::mutex> lock(g_wavVoiceMutex);
+            if (g_wavVoices.size() <= size_t(voiceHandle)) {
+                if (!state) return;
+                g_wavVoices.resize(size_t(voiceHandle) + 1, nullptr);
+            }
+            delete g_wavVoices[voiceHandle];
+            g_wavVoices[voiceHandle] = state;
+        }
+
+        static uint32_t WavFillCallback(void *user, int16_t *dst, uint32_t frameCount)
+        {
+            wav_voice_t *voice       = (wav_voice_t *)user;
+            uint32_t     sampleCount = uint32_t(voice->source.wav.sampleCount);
+            uint32_t     written     = 0;
+            while (written < frameCount) {
+                if (voice->cursor >= sampleCount) {
+                    if (!voice->bLoop) break;
+                    voice->cursor = 0;
+                }
+                uint32_t       available;
+                const int16_t *src   = GetWavFrames(&voice->source, voice->cursor, &available);
+                uint32_t       count = math::min(frameCount - written, available);
+                memcpy(dst + size_t(written) * 2, src, size_t(count) * 2 * sizeof(int16_t));
+                written += count;
+                voice->cursor += count;
+            }
+            return written;
+        }
+
+        bool voiceSubmitWav(intptr_t voiceHandle, const loaded_wav_t &wav, bool bLoop)
+        {
+            bool bCompressed = wav.encoding != io::WAV_ENCODING_PCM16;
+            if (voiceHandle < 0 || wav.sampleCount <= 0) return false;
+            if (bCompressed ? (!wav.blockData || !wav.framesPerBlock) : !wav.sampleData) return false;
+
+            wav_voice_t *state = nullptr;
+            bool         bResult;
+            if (!bCompressed && !bLoop) {
+                // NOTE: the platform plays plain samples straight from the wav, without a callback.
+                bResult = EM->pfn.voiceSubmitBuffer(voiceHandle, wav);
+            } else {
+                if (!EM->pfn.voiceSubmitCallback) return false;
+                state        = new wav_voice_t();
+                state->bLoop = bLoop;
+                InitWavSource(&state->source, wav);
+                bResult = EM->pfn.voiceSubmitCallback(voiceHandle, WavFillCallback, state);
+            }
+            if (!bResult) {
+                // the voice may still be calling back with its old state.
+                delete state;
+                return false;
+            }
+
+            ReleaseWavVoice(voiceHandle, state);
+            return true;
+        }
+
+        bool voiceQueueBuffer(intptr_t voiceHandle, const voice_buffer_t &buffer)
+        {
+            if (voiceHandle < 0 || !EM->pfn.voiceQueueBuffer) return false;
+            if (!EM->pfn.voiceQueueBuffer(voiceHandle, buffer)) return false;
+            ReleaseWavVoice(voiceHandle);
+            return true;
+        }
+
+
+        // NOTE: a ring with one producer and one consumer, each on their own thread. neither side ever waits for
+        // the other; a push to a full ring fails.
+        template <typename T> struct spsc_ring_t {
+            std::vector<T>        items;
+            uint32_t              mask;
+            std::atomic<uint32_t> head;  // the next item to write. only the producer writes it.
+            std::atomic<uint32_t> tail;  // the next item to read. only the consumer writes it.
+        };
+
+        template <typename T> static void InitRing(spsc_ring_t<T> *ring, uint32_t capacity)
+        {
+            uint32_t size = 1;
+            while (size < capacity) size <<= 1;
+            ring->items.resize(size);
+            ring->mask = size - 1;
+            ring->head = 0;
+            ring->tail = 0;
+        }
+
+        template <typename T> static bool PushRing(spsc_ring_t<T> *ring, const T &item)
+        {
+            uint32_t head = ring->head.load(std::memory_order_relaxed);
+            if (head - ring->tail.load(std::memory_order_acquire) > ring->mask) return false;
+            ring->items[head & ring->mask] = item;
+            ring->head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        template <typename T> static bool PopRing(spsc_ring_t<T> *ring, T *pItem)
+        {
+            uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+            if (tail == ring->head.load(std::memory_order_acquire)) return false;
+            *pItem = ring->items[tail & ring->mask];
+            ring->tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        enum mixer_command_type_t : uint32_t {
+            MIXER_COMMAND_PLAY = 0,
+            MIXER_COMMAND_PLAY_AT,
+            MIXER_COMMAND_STOP,
+            MIXER_COMMAND_SET_PARAMS
+        };
+
+        struct mixer_command_t {
+            mixer_command_type_t type;
+            mixer_voice_t        voice;
+            mixer_voice_params_t params;
+            uint64_t             startFrame;  // the frame of the mixer clock for MIXER_COMMAND_PLAY_AT.
+        };
+
+        // NOTE: the game thread sets up the sound of a free voice, then hands the voice to the audio thread with the
+        // play command. the audio thread hands it back through the retired ring once it ends. the generation is
+        // read by both threads to drop commands for voices that have since been reused.
+        struct mixer_slot_t {
+            std::atomic<uint32_t> generation;
+            wav_source_t          source;
+            bool                  bLoop;
+
+            // audio thread state.
+            bool                 bActive;
+            bool                 bStopping;  // the voice fades out over the next block, then ends.
+            bool                 bReal;      // the voice is mixed in the block being rendered.
+            bool                 bStarting;  // the voice has not been through a block yet.
+            uint32_t             activeIndex;
+            uint64_t             startFrame;  // the frame of the mixer clock on which the voice starts.
+            uint64_t             position;   // 32.32 fixed point frame within the sound.
+            mixer_voice_params_t params;
+            float                gains[2];   // the channel gains at the end of the last block that was mixed.
+            float                targetGains[2];
+            float                audibility;
+        };
+
+        struct mixer_t {
+            mixer_desc_t                    desc;
+            std::unique_ptr<mixer_slot_t[]> slots;
+            spsc_ring_t<mixer_command_t>    commands;  // game thread to audio thread.
+            spsc_ring_t<uint32_t>           retired;   // voices that ended, audio thread to game thread.
+
+            // game thread state.
+            std::vector<uint32_t> freeSlots;
+            std::vector<uint8_t>  bPlaying;  // the game thread's view of which voices are playing.
+
+            // audio thread state. nothing here is resized after createMixer.
+            std::vector<uint32_t> active;
+            std::vector<uint32_t> audible;
+            std::vector<float>    staging;  // the source frames of the voice being mixed.
+            std::vector<float>    output;   // the float output of voiceSubmitMixer.
+
+            uint64_t              clock;  // the first frame of the block being rendered.
+
+            std::atomic<uint32_t> playingCount;
+            std::atomic<uint32_t> realCount;
+            std::atomic<uint32_t> virtualCount;
+            std::atomic<uint32_t> lateStarts;
+
+            // NOTE: the clock of the last render, for any thread. the audio thread writes it under a sequence lock:
+            // the sequence is odd while the pair is being written, and a reader retries if the sequence moved.
+            std::atomic<uint32_t> clockSequence;
+            std::atomic<uint64_t> clockFrame;
+            std::atomic<uint64_t> clockWall;
+        };
+
+        // the most source frames that a block reads, including the frame after the last for interpolation.
+        static constexpr uint32_t MIXER_STAGING_FRAMES = uint32_t(MIXER_BLOCK_FRAMES * MIXER_MAX_PITCH) + 2;
+
+        mixer_t *createMixer(const mixer_desc_t &desc)
+        {
+            if (!desc.maxVoices || !desc.commandCapacity) {
+                AELoggerError("unable to create a mixer with maxVoices=%u and commandCapacity=%u", desc.maxVoices,
+                    desc.commandCapacity);
+                return nullptr;
+            }
+            mixer_t *mixer            = new mixer_t();
+            mixer->desc               = desc;
+            mixer->desc.maxRealVoices = math::min(desc.maxRealVoices, desc.maxVoices);
+            mixer->slots.reset(new mixer_slot_t[desc.maxVoices]());
+            InitRing(&mixer->commands, desc.commandCapacity);
+            // NOTE: a voice is retired at most once per play, so the ring never fills.
+            InitRing(&mixer->retired, desc.maxVoices);
+            for (uint32_t i = desc.maxVoices; i > 0; i--) mixer->freeSlots.push_back(i - 1);
+            mixer->bPlaying.resize(desc.maxVoices, 0);
+            mixer->active.reserve(desc.maxVoices);
+            mixer->audible.resize(desc.maxVoices);
+            mixer->staging.resize(size_t(MIXER_STAGING_FRAMES) * 2);
+            mixer->output.resize(size_t(MIXER_BLOCK_FRAMES) * 2);
+            return mixer;
+        }
+
+        void destroyMixer(mixer_t *mixer) { delete mixer; }
+
+        static void DrainRetiredVoices(mixer_t *mixer)
+        {
+            uint32_t index;
+            while (PopRing(&mixer->retired, &index)) {
+                mixer->bPlaying[index] = 0;
+                mixer->freeSlots.push_back(index);
+            }
+        }
+
+        static void PushMixerCommand(mixer_t *mixer, const mixer_command_t &command)
+        {
+            if (!PushRing(&mixer->commands, command))
+                AELoggerWarn("the mixer command queue is full. dropped a command for voice %u", command.voice.index);
+        }
+
+        static mixer_voice_t PlayMixerVoice(mixer_t *mixer,
+            const loaded_wav_t                          &wav,
+            const mixer_voice_params_t                  &params,
+            mixer_command_type_t                         type,
+            uint64_t                                     startFrame,
+            bool                                         bLoop)
+        {
+            DrainRetiredVoices(mixer);
+            bool bCompressed = wav.encoding != io::WAV_ENCODING_PCM16;
+            if (wav.sampleCount <= 0 || (bCompressed ? (!wav.blockData || !wav.framesPerBlock) : !wav.sampleData))
+                return {};
+            if (mixer->freeSlots.empty()) return {};
+
+            uint32_t      index = mixer->freeSlots.back();
+            mixer_slot_t *slot  = &mixer->slots[index];
+            slot->bLoop         = bLoop;
+            InitWavSource(&slot->source, wav);
+            uint32_t generation = slot->generation.load(std::memory_order_relaxed) + 1;
+            if (!generation) generation = 1;
+            slot->generation.store(generation, std::memory_order_relaxed);
+
+            mixer_command_t command = { type, { index, generation }, params, startFrame };
+            if (!PushRing(&mixer->commands, command)) return {};
+            mixer->freeSlots.pop_back();
+            mixer->bPlaying[index] = 1;
+            return command.voice;
+        }
+
+        mixer_voice_t mixerPlay(mixer_t *mixer, const loaded_wav_t &wav, const mixer_voice_params_t &params, bool bLoop)
+        {
+            return PlayMixerVoice(mixer, wav, params, MIXER_COMMAND_PLAY, 0, bLoop);
+        }
+
+        mixer_voice_t mixerPlayAt(mixer_t *mixer,
+            const loaded_wav_t             &wav,
+            const mixer_voice_params_t     &params,
+            uint64_t                        startFrame,
+            bool                            bLoop)
+        {
+            return PlayMixerVoice(mixer, wav, params, MIXER_COMMAND_PLAY_AT, startFrame, bLoop);
+        }
+
+        static bool IsVoiceHandleValid(mixer_t *mixer, mixer_voice_t voice)
+        {
+            return voice.generation && voice.index < mixer->desc.maxVoices &&
+                   mixer->slots[voice.index].generation.load(std::memory_order_relaxed) == voice.generation;
+        }
+
+        void mixerStop(mixer_t *mixer, mixer_voice_t voice)
+        {
+            DrainRetiredVoices(mixer);
+            if (!IsVoiceHandleValid(mixer, voice) || !mixer->bPlaying[voice.index]) return;
+            PushMixerCommand(mixer, { MIXER_COMMAND_STOP, voice, {}, 0 });
+        }
+
+        void mixerSetParams(mixer_t *mixer, mixer_voice_t voice, const mixer_voice_params_t &params)
+        {
+            DrainRetiredVoices(mixer);
+            if (!IsVoiceHandleValid(mixer, voice) || !mixer->bPlaying[voice.index]) return;
+            PushMixerCommand(mixer, { MIXER_COMMAND_SET_PARAMS, voice, params, 0 });
+        }
+
+        bool mixerIsPlaying(mixer_t *mixer, mixer_voice_t voice)
+        {
+            DrainRetiredVoices(mixer);
+            return IsVoiceHandleValid(mixer, voice) && mixer->bPlaying[voice.index];
+        }
+
+        mixer_stats_t getMixerStats(mixer_t *mixer)
+        {
+            return { mixer->playingCount.load(), mixer->realCount.load(), mixer->virtualCount.load(),
+                mixer->lateStarts.load() };
+        }
+
+        mixer_clock_t getMixerClock(mixer_t *mixer)
+        {
+            mixer_clock_t clock;
+            while (true) {
+                uint32_t sequence = mixer->clockSequence.load(std::memory_order_acquire);
+                if (sequence & 1) continue;
+                clock.frame     = mixer->clockFrame.load(std::memory_order_relaxed);
+                clock.wallClock = mixer->clockWall.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (mixer->clockSequence.load(std::memory_order_relaxed) == sequence) return clock;
+            }
+        }
+
+        uint64_t getMixerFrameAt(mixer_t *mixer, uint64_t wallClock)
+        {
+            mixer_clock_t clock     = getMixerClock(mixer);
+            uint64_t      frequency = EM->pfn.getTimerFrequency ? EM->pfn.getTimerFrequency() : 0;
+            if (!clock.wallClock || !frequency) return clock.frame;
+            // NOTE: the time may be before the last render, e.g. when it was taken just before the render began.
+            double  seconds = (wallClock >= clock.wallClock) ? double(wallClock - clock.wallClock) / double(frequency)
+                                                             : -double(clock.wallClock - wallClock) / double(frequency);
+            int64_t frame   = int64_t(clock.frame) + int64_t(llround(seconds * io::ENGINE_DESIRED_SAMPLES_PER_SECOND));
+            return uint64_t(math::max(frame, int64_t(0)));
+        }
+
+        // NOTE: equal power, scaled by sqrt(2) so that the center is unity gain on both channels.
+        static void GetVoiceGains(const mixer_voice_params_t &params, float *gains)
+        {
+            float pan   = math::max(-1.f, math::min(params.pan, 1.f));
+            float angle = (pan + 1.f) * 0.785398163f;
+            gains[0]    = params.gain * 1.41421356f * cosf(angle);
+            gains[1]    = params.gain * 1.41421356f * sinf(angle);
+        }
+
+        static uint64_t GetVoiceStep(const mixer_voice_params_t &params)
+        {
+            float pitch = math::max(0.f, math::min(params.pitch, MIXER_MAX_PITCH));
+            return uint64_t(double(pitch) * 4294967296.0);
+        }
+
+        static void ApplyMixerCommands(mixer_t *mixer)
+        {
+            mixer_command_t command;
+            while (PopRing(&mixer->commands, &command)) {
+                mixer_slot_t *slot = &mixer->slots[command.voice.index];
+                if (slot->generation.load(std::memory_order_relaxed) != command.voice.generation) continue;
+                switch (command.type) {
+                    case MIXER_COMMAND_PLAY:
+                    case MIXER_COMMAND_PLAY_AT: {
+                        if (slot->bActive) break;
+                        slot->startFrame = mixer->clock;
+                        if (command.type == MIXER_COMMAND_PLAY_AT) {
+                            if (command.startFrame >= mixer->clock) slot->startFrame = command.startFrame;
+                            else mixer->lateStarts.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        slot->bActive     = true;
+                        slot->bStopping   = false;
+                        slot->position    = 0;
+                        slot->params      = command.params;
+                        slot->bStarting   = true;
+                        slot->gains[0]    = 0.f;
+                        slot->gains[1]    = 0.f;
+                        slot->activeIndex = uint32_t(mixer->active.size());
+                        mixer->active.push_back(command.voice.index);
+                    } break;
+                    case MIXER_COMMAND_STOP: {
+                        if (slot->bActive) slot->bStopping = true;
+                    } break;
+                    case MIXER_COMMAND_SET_PARAMS: {
+                        if (slot->bActive) slot->params = command.params;
+                    } break;
+                }
+            }
+        }
+
+        static void RetireVoice(mixer_t *mixer, mixer_slot_t *slot)
+        {
+            uint32_t last                    = mixer->active.back();
+            mixer->active[slot->activeIndex] = last;
+            mixer->slots[last].activeIndex   = slot->activeIndex;
+            mixer->active.pop_back();
+            slot->bActive = false;
+            PushRing(&mixer->retired, uint32_t(slot - mixer->slots.get()));
+        }
+
+        static void Int16ToFloat(const int16_t *src, uint32_t count, float *dst)
+        {
+            const __m128 scale = _mm_set1_ps(1.f / 32768.f);
+            uint32_t     i     = 0;
+            for (; i + 8 <= count; i += 8) {
+                __m128i v  = _mm_loadu_si128((const __m128i *)(src + i));
+                __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+                __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+                _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+                _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+            }
+            for (; i < count; i++) dst[i] = float(src[i]) * (1.f / 32768.f);
+        }
+
+        static void FloatToInt16(const float *src, uint32_t count, int16_t *dst)
+        {
+            const __m128 scale = _mm_set1_ps(32768.f), lo = _mm_set1_ps(-32768.f), hi = _mm_set1_ps(32767.f);
+            uint32_t     i     = 0;
+            for (; i + 8 <= count; i += 8) {
+                __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale), lo), hi);
+                __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), lo), hi);
+                _mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+            }
+            for (; i < count; i++) dst[i] = int16_t(lrintf(math::max(-32768.f, math::min(src[i] * 32768.f, 32767.f))));
+        }
+
+        // read count frames of a voice's sound from frame first on. frames past the end of a sound that does not
+        // loop are silence.
+        static void FetchVoiceFrames(mixer_slot_t *slot, uint64_t first, uint32_t count, float *dst)
+        {
+            uint32_t sampleCount = uint32_t(slot->source.wav.sampleCount);
+            while (count) {
+                uint64_t frame = slot->bLoop ? first % sampleCount : first;
+                if (frame >= sampleCount) {
+                    memset(dst, 0, size_t(count) * 2 * sizeof(float));
+                    return;
+                }
+                uint32_t       available;
+                const int16_t *src = GetWavFrames(&slot->source, uint32_t(frame), &available);
+                uint32_t       n   = math::min(count, available);
+                Int16ToFloat(src, n * 2, dst);
+                dst += size_t(n) * 2;
+                first += n;
+                count -= n;
+            }
+        }
+
+        // NOTE: two stereo frames fit a register. the gains move from gains by delta per frame.
+        static void MixFrames(const float *src, uint32_t frameCount, const float *gains, const float *delta, float *dst)
+        {
+            __m128   g  = _mm_setr_ps(gains[0], gains[1], gains[0] + delta[0], gains[1] + delta[1]);
+            __m128   dg = _mm_setr_ps(2.f * delta[0], 2.f * delta[1], 2.f * delta[0], 2.f * delta[1]);
+            uint32_t i  = 0;
+            for (; i + 2 <= frameCount; i += 2) {
+                __m128 s = _mm_loadu_ps(src + size_t(i) * 2);
+                _mm_storeu_ps(dst + size_t(i) * 2, _mm_add_ps(_mm_loadu_ps(dst + size_t(i) * 2), _mm_mul_ps(s, g)));
+                g = _mm_add_ps(g, dg);
+            }
+            if (i < frameCount) {
+                alignas(16) float last[4];
+                _mm_store_ps(last, g);
+                dst[i * 2] += src[i * 2] * last[0];
+                dst[i * 2 + 1] += src[i * 2 + 1] * last[1];
+            }
+        }
+
+        // as MixFrames, but src is resampled with linear interpolation. position is the fractional frame of src
+        // at which to begin, as 32.32 fixed point, and step is the distance between output frames.
+        static void ResampleFrames(const float *src,
+            uint64_t                             position,
+            uint64_t                             step,
+            uint32_t                             frameCount,
+            const float                         *gains,
+            const float                         *delta,
+            float                               *dst)
+        {
+            const float toFraction = 1.f / 4294967296.f;
+            __m128      g          = _mm_setr_ps(gains[0], gains[1], gains[0] + delta[0], gains[1] + delta[1]);
+            __m128      dg         = _mm_setr_ps(2.f * delta[0], 2.f * delta[1], 2.f * delta[0], 2.f * delta[1]);
+            uint32_t    i          = 0;
+            for (; i + 2 <= frameCount; i += 2, position += step * 2) {
+                uint64_t p0 = position, p1 = position + step;
+                // each load holds the frame at or before the position and the frame after it.
+                __m128 v0 = _mm_loadu_ps(src + (p0 >> 32) * 2);
+                __m128 v1 = _mm_loadu_ps(src + (p1 >> 32) * 2);
+                __m128 a  = _mm_movelh_ps(v0, v1);
+                __m128 b  = _mm_movehl_ps(v1, v0);
+                float  f0 = float(uint32_t(p0)) * toFraction, f1 = float(uint32_t(p1)) * toFraction;
+                __m128 s  = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_setr_ps(f0, f0, f1, f1)));
+                _mm_storeu_ps(dst + size_t(i) * 2, _mm_add_ps(_mm_loadu_ps(dst + size_t(i) * 2), _mm_mul_ps(s, g)));
+                g = _mm_add_ps(g, dg);
+            }
+            if (i < frameCount) {
+                alignas(16) float last[4];
+                _mm_store_ps(last, g);
+                const float *s = src + (position >> 32) * 2;
+                float        f = float(uint32_t(position)) * toFraction;
+                dst[i * 2] += (s[0] + (s[2] - s[0]) * f) * last[0];
+                dst[i * 2 + 1] += (s[1] + (s[3] - s[1]) * f) * last[1];
+            }
+        }
+
+        static void MixVoice(
+            mixer_t *mixer, mixer_slot_t *slot, const float *targetGains, float *dst, uint32_t frameCount)
+        {
+            uint64_t step     = GetVoiceStep(slot->params);
+            uint64_t fraction = slot->position & 0xFFFFFFFF;
+            uint32_t count    = uint32_t((fraction + step * (frameCount - 1)) >> 32) + 2;
+            float   *staging  = mixer->staging.data();
+            FetchVoiceFrames(slot, slot->position >> 32, count, staging);
+
+            float delta[2] = { (targetGains[0] - slot->gains[0]) / frameCount,
+                (targetGains[1] - slot->gains[1]) / frameCount };
+            if (step == (1ull << 32) && !fraction) MixFrames(staging, frameCount, slot->gains, delta, dst);
+            else ResampleFrames(staging, fraction, step, frameCount, slot->gains, delta, dst);
+        }
+
+        // returns false once a voice that does not loop has played to its end.
+        static bool AdvanceVoice(mixer_slot_t *slot, uint32_t frameCount)
+        {
+            uint64_t length = uint64_t(slot->source.wav.sampleCount) << 32;
+            slot->position += GetVoiceStep(slot->params) * frameCount;
+            if (slot->position < length) return true;
+            if (!slot->bLoop) return false;
+            slot->position %= length;
+            return true;
+        }
+
+        static void RenderMixerBlock(mixer_t *mixer, float *dst, uint32_t frameCount)
+        {
+            memset(dst, 0, size_t(frameCount) * 2 * sizeof(float));
+
+            // the loudest voices above the threshold are mixed. the rest are virtual, as are voices that start in a
+            // later block.
+            uint64_t blockEnd     = mixer->clock + frameCount;
+            uint32_t audibleCount = 0;
+            for (uint32_t index : mixer->active) {
+                mixer_slot_t *slot = &mixer->slots[index];
+                GetVoiceGains(slot->params, slot->targetGains);
+                slot->audibility = math::max(fabsf(slot->targetGains[0]), fabsf(slot->targetGains[1]));
+                slot->bReal      = false;
+                if (slot->startFrame >= blockEnd) continue;
+                if (!slot->bStopping && slot->audibility >= mixer->desc.virtualThreshold)
+                    mixer->audible[audibleCount++] = index;
+            }
+            if (audibleCount > mixer->desc.maxRealVoices) {
+                auto louder = [mixer](uint32_t a, uint32_t b) {
+                    return mixer->slots[a].audibility > mixer->slots[b].audibility;
+                };
+                std::nth_element(mixer->audible.begin(), mixer->audible.begin() + mixer->desc.maxRealVoices,
+                    mixer->audible.begin() + audibleCount, louder);
+                audibleCount = mixer->desc.maxRealVoices;
+            }
+            for (uint32_t i = 0; i < audibleCount; i++) mixer->slots[mixer->audible[i]].bReal = true;
+
+            uint32_t realCount = 0;
+            for (uint32_t i = uint32_t(mixer->active.size()); i > 0; i--) {
+                mixer_slot_t *slot = &mixer->slots[mixer->active[i - 1]];
+                if (slot->startFrame >= blockEnd) {
+                    // the voice has not started, so it is silent and stops without a fade.
+                    if (slot->bStopping) RetireVoice(mixer, slot);
+                    continue;
+                }
+                // a voice that starts within the block is mixed from its start frame on.
+                uint32_t offset   = uint32_t(math::max(slot->startFrame, mixer->clock) - mixer->clock);
+                float   *voiceDst = dst + size_t(offset) * 2;
+                uint32_t count    = frameCount - offset;
+
+                // NOTE: a voice that goes virtual or stops is faded out over one more block so that it does not
+                // click. one that comes back from being virtual fades in.
+                float targetGains[2] = { 0.f, 0.f };
+                if (slot->bReal) {
+                    targetGains[0] = slot->targetGains[0];
+                    targetGains[1] = slot->targetGains[1];
+                    // a new sound starts at its full level, without a ramp.
+                    if (slot->bStarting) {
+                        slot->gains[0] = targetGains[0];
+                        slot->gains[1] = targetGains[1];
+                    }
+                }
+                slot->bStarting = false;
+                if (slot->bReal || slot->gains[0] != 0.f || slot->gains[1] != 0.f)
+                    MixVoice(mixer, slot, targetGains, voiceDst, count);
+                slot->gains[0] = targetGains[0];
+                slot->gains[1] = targetGains[1];
+                if (!AdvanceVoice(slot, count) || slot->bStopping) RetireVoice(mixer, slot);
+                else if (slot->bReal) realCount++;
+            }
+
+            uint32_t playingCount = uint32_t(mixer->active.size());
+            mixer->playingCount.store(playingCount, std::memory_order_relaxed);
+            mixer->realCount.store(realCount, std::memory_order_relaxed);
+            mixer->virtualCount.store(playingCount - realCount, std::memory_order_relaxed);
+        }
+
+        // NOTE: the clock is stamped once per render, at its start. the blocks of a render are mixed all at once,
+        // well ahead of being heard, so only the first frame of each render is taken to be in step with the device.
+        static void StampMixerClock(mixer_t *mixer)
+        {
+            uint32_t sequence = mixer->clockSequence.load(std::memory_order_relaxed);
+            mixer->clockSequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            mixer->clockFrame.store(mixer->clock, std::memory_order_relaxed);
+            mixer->clockWall.store(EM->pfn.wallClock ? EM->pfn.wallClock() : 0, std::memory_order_relaxed);
+            mixer->clockSequence.store(sequence + 2, std::memory_order_release);
+        }
+
+        static void RenderMixer(mixer_t *mixer, float *dst, uint32_t frameCount)
+        {
+            for (uint32_t done = 0; done < frameCount;) {
+                uint32_t count = math::min(frameCount - done, MIXER_BLOCK_FRAMES);
+                ApplyMixerCommands(mixer);
+                RenderMixerBlock(mixer, dst + size_t(done) * 2, count);
+                mixer->clock += count;
+                done += count;
+            }
+        }
+
+        void mixerRender(mixer_t *mixer, float *dst, uint32_t frameCount)
+        {
+            StampMixerClock(mixer);
+            RenderMixer(mixer, dst, frameCount);
+        }
+
+        static uint32_t MixerFillCallback(void *user, int16_t *dst, uint32_t frameCount)
+        {
+            mixer_t *mixer = (mixer_t *)user;
+            StampMixerClock(mixer);
+            for (uint32_t done = 0; done < frameCount;) {
+                uint32_t count = math::min(frameCount - done, MIXER_BLOCK_FRAMES);
+                RenderMixer(mixer, mixer->output.data(), count);
+                FloatToInt16(mixer->output.data(), count * 2, dst + size_t(done) * 2);
+                done += count;
+            }
+            return frameCount;
+        }
+
+        bool voiceSubmitMixer(intptr_t voiceHandle, mixer_t *mixer)
+        {
+            if (!mixer || !EM->pfn.voiceSubmitCallback) return false;
+            if (!EM->pfn.voiceSubmitCallback(voiceHandle, MixerFillCallback, mixer)) return false;
+            ReleaseWavVoice(voiceHandle);
+            return true;
+        }
+
+        struct device_voice_t {
+            bool                  bStarted;
+            bool                  bHasSound;
+            uint64_t              framesPlayed;
+            // the sound is a buffer of samples, a callback or a queue of buffers.
+            const int16_t        *samples;
+            uint32_t              frameCount;
+            uint32_t              cursor;
+            PFN_voiceFillCallback fill;
+            void                 *user;
+            bool                  bQueued;
+            voice_buffer_t        queue[platform::VOICE_MAX_QUEUED_BUFFERS];
+            uint32_t              queueHead;
+            uint32_t              queueCount;
+        };
+
+        struct ended_buffer_t {
+            intptr_t       voiceHandle;
+            voice_buffer_t buffer;
+        };
+
+        struct audio_device_t {
+            audio_device_desc_t         desc;
+            std::string                 fileName;  // empty for the null device.
+            // NOTE: recursive, so that the callbacks which run within a pass may still query voices.
+            std::recursive_mutex        mutex;
+            std::vector<device_voice_t> voices;
+            std::vector<int16_t>        pulled;
+            std::vector<float>          voiceFrames;
+            std::vector<float>          mix;
+            std::vector<int16_t>        recorded;
+            std::vector<intptr_t>       endedVoices;
+            std::vector<ended_buffer_t> endedBuffers;
+            uint64_t                    clock;
+
+            // the functions of EM->pfn from before the device was installed.
+            bool                    bInstalled;
+            PFN_createVoice         createVoice;
+            PFN_voicePlayBuffer     voicePlayBuffer;
+            PFN_voiceSubmitBuffer   voiceSubmitBuffer;
+            PFN_voiceSubmitCallback voiceSubmitCallback;
+            PFN_voiceQueueBuffer    voiceQueueBuffer;
+            PFN_voiceGetState       voiceGetState;
+        };
+
+        // NOTE: the pfn functions take no context, so they go through the device that is installed.
+        static audio_device_t *g_device = nullptr;
+
+        static audio_device_t *CreateDevice(const char *fileName, const audio_device_desc_t &desc)
+        {
+            if (!desc.periodFrames) {
+                AELoggerError("unable to create an audio device with a period of %u frames", desc.periodFrames);
+                return nullptr;
+            }
+            audio_device_t *device = new audio_device_t();
+            device->desc           = desc;
+            device->fileName       = fileName ? fileName : "";
+            device->pulled.resize(size_t(desc.periodFrames) * 2);
+            device->voiceFrames.resize(size_t(desc.periodFrames) * 2);
+            device->mix.resize(size_t(desc.periodFrames) * 2);
+            return device;
+        }
+
+        audio_device_t *createNullDevice(const audio_device_desc_t &desc) { return CreateDevice(nullptr, desc); }
+
+        audio_device_t *createWavDevice(const char *fileName, const audio_device_desc_t &desc)
+        {
+            return CreateDevice(fileName, desc);
+        }
+
+        static intptr_t Device_createVoice()
+        {
+            std::lock_guard<std::recursive_mutex> lock(g_device->mutex);
+            g_device->voices.push_back({});
+            return intptr_t(g_device->voices.size() - 1);
+        }
+
+        static device_voice_t *Device_getVoice(intptr_t voiceHandle)
+        {
+            if (voiceHandle < 0 || size_t(voiceHandle) >= g_device->voices.size()) return nullptr;
+            return &g_device->voices[voiceHandle];
+        }
+
+        // NOTE: as with XAudio2, giving a voice a new sound stops it. the buffers that were queued are done with.
+        static void Device_stopVoice(device_voice_t *voice, std::vector<voice_buffer_t> *pFlushed)
+        {
+            for (uint32_t i = 0; i < voice->queueCount; i++)
+                pFlushed->push_back(voice->queue[(voice->queueHead + i) % platform::VOICE_MAX_QUEUED_BUFFERS]);
+            *voice = {};
+        }
+
+        static void Device_endBuffers(intptr_t voiceHandle, const std::vector<voice_buffer_t> &buffers)
+        {
+            for (const voice_buffer_t &buffer : buffers) {
+                if (buffer.onEnd) buffer.onEnd(buffer.context, voiceHandle);
+            }
+        }
+
+        static void Device_voicePlayBuffer(intptr_t voiceHandle)
+        {
+            std::lock_guard<std::recursive_mutex> lock(g_device->mutex);
+            if (device_voice_t *voice = Device_getVoice(voiceHandle)) voice->bStarted = true;
+        }
+
+        static bool Device_voiceSubmitBuffer(intptr_t voiceHandle, loaded_wav_t wavFile)
+        {
+            if (!wavFile.sampleData) return false;
+            std::vector<voice_buffer_t> flushed;
+            {
+                std::lock_guard<std::recursive_mutex> lock(g_device->mutex);
+                device_voice_t                       *voice = Device_getVoice(voiceHandle);
+                if (!voice) return false;
+                Device_stopVoice(voice, &flushed);
+                voice->bHasSound  = true;
+                voice->samples    = wavFile.sampleData;
+                voice->frameCount = uint32_t(wavFile.sampleCount);
+            }
+            Device_endBuffers(voiceHandle, flushed);
+            return true;
+        }
+
+        static bool Device_voiceSubmitCallback(intptr_t voiceHandle, PFN_voiceFillCallback fill, void *user)
+        {
+            if (!fill) return false;
+            std::vector<voice_buffer_t> flushed;
+            {
+                std::lock_guard<std::recursive_mutex> lock(g_device->mutex);
+                device_voice_t                       *voice = Device_getVoice(voiceHandle);
+                if (!voice) return false;
+                Device_stopVoice(voice, &flushed);
+                voice->bHasSound = true;
+                voice->fill      = fill;
+                voice->user      = user;
+            }
+            Device_endBuffers(voiceHandle, flushed);
+            return true;
+        }
+
+        static bool Device_voiceQueueBuffer(intptr_t voiceHandle, const voice_buffer_t &buffer)
+        {
+            if (!buffer.frames || !buffer.frameCount) return false;
+            std::lock_guard<std::recursive_mutex> lock(g_device->mutex);
+            device_voice_t                       *voice = Device_getVoice(voiceHandle);
+            if (!voice || voice->queueCount == platform::VOICE_MAX_QUEUED_BUFFERS) return false;
+            if (!voice->bQueued) {
+                // NOTE: the voice played some other sound, so it has no queued buffers to flush.
+                *voice           = {};
+                voice->bQueued   = true;
+                voice->bHasSound = true;
+            }
+            uint32_t index = (voice->queueHead + voice->queueCount++) % platform::VOICE_MAX_QUEUED_BUFFERS;
+            voice->queue[index] = buffer;
+            return true;
+        }
+
+        static bool Device_voiceGetState(intptr_t voiceHandle, voice_state_t *pState)
+        {
+            std::lock_guard<std::recursive_mutex> lock(g_device->mutex);
+            device_voice_t                       *voice = Device_getVoice(voiceHandle);
+            if (!voice) return false;
+            pState->buffersQueued = voice->bQueued ? voice->queueCount : uint32_t(voice->bHasSound);
+            pState->framesPlayed  = voice->framesPlayed;
+            return true;
+        }
+
+        void installDevice(audio_device_t *device)
+        {
+            if (g_device == device) return;
+            if (g_device) {
+                AELoggerError("unable to install an audio device while %s is installed",
+                    g_device->fileName.empty() ? "a null device" : g_device->fileName.c_str());
+                return;
+            }
+            device->bInstalled          = true;
+            device->createVoice         = EM->pfn.createVoice;
+            device->voicePlayBuffer     = EM->pfn.voicePlayBuffer;
+            device->voiceSubmitBuffer   = EM->pfn.voiceSubmitBuffer;
+            device->voiceSubmitCallback = EM->pfn.voiceSubmitCallback;
+            device->voiceQueueBuffer    = EM->pfn.voiceQueueBuffer;
+            device->voiceGetState       = EM->pfn.voiceGetState;
+            EM->pfn.createVoice         = Device_createVoice;
+            EM->pfn.voicePlayBuffer     = Device_voicePlayBuffer;
+            EM->pfn.voiceSubmitBuffer   = Device_voiceSubmitBuffer;
+            EM->pfn.voiceSubmitCallback = Device_voiceSubmitCallback;
+            EM->pfn.voiceQueueBuffer    = Device_voiceQueueBuffer;
+            EM->pfn.voiceGetState       = Device_voiceGetState;
+            g_device                    = device;
+        }
+
+        bool destroyDevice(audio_device_t *device)
+        {
+            if (!device) return false;
+            if (device->bInstalled) {
+                EM->pfn.createVoice         = device->createVoice;
+                EM->pfn.voicePlayBuffer     = device->voicePlayBuffer;
+                EM->pfn.voiceSubmitBuffer   = device->voiceSubmitBuffer;
+                EM->pfn.voiceSubmitCallback = device->voiceSubmitCallback;
+                EM->pfn.voiceQueueBuffer    = device->voiceQueueBuffer;
+                EM->pfn.voiceGetState       = device->voiceGetState;
+                g_device                    = nullptr;
+            }
+            bool bResult = true;
+            if (!device->fileName.empty()) {
+                bResult = io::writeWav(
+                    device->fileName.c_str(), device->recorded.data(), uint32_t(device->recorded.size() / 2));
+                if (!bResult) AELoggerError("unable to write the output of a device to %s", device->fileName.c_str());
+            }
+            delete device;
+            return bResult;
+        }
+
+        // returns the number of frames of the voice's sound that were written to dst. fewer than frameCount ends the
+        // sound.
+        static uint32_t PullDeviceVoice(device_voice_t *voice, int16_t *dst, uint32_t frameCount)
+        {
+            if (voice->fill) return math::min(voice->fill(voice->user, dst, frameCount), frameCount);
+            uint32_t frames = math::min(frameCount, voice->frameCount - voice->cursor);
+            memcpy(dst, voice->samples + size_t(voice->cursor) * 2, size_t(frames) * 2 * sizeof(int16_t));
+            voice->cursor += frames;
+            return frames;
+        }
+
+        // returns the number of frames that were taken from the voice's queue. the rest of dst is silence.
+        static uint32_t PullQueuedFrames(
+            audio_device_t *device, intptr_t voiceHandle, int16_t *dst, uint32_t frameCount)
+        {
+            device_voice_t *voice = &device->voices[voiceHandle];
+            uint32_t        done  = 0;
+            while (done < frameCount && voice->queueCount) {
+                const voice_buffer_t &buffer = voice->queue[voice->queueHead];
+                uint32_t              frames = math::min(frameCount - done, buffer.frameCount - voice->cursor);
+                memcpy(dst + size_t(done) * 2, buffer.frames + size_t(voice->cursor) * 2,
+                    size_t(frames) * 2 * sizeof(int16_t));
+                voice->cursor += frames;
+                done += frames;
+                if (voice->cursor == buffer.frameCount) {
+                    device->endedBuffers.push_back({ voiceHandle, buffer });
+                    voice->queueHead = (voice->queueHead + 1) % platform::VOICE_MAX_QUEUED_BUFFERS;
+                    voice->queueCount--;
+                    voice->cursor = 0;
+                }
+            }
+            memset(dst + size_t(done) * 2, 0, size_t(frameCount - done) * 2 * sizeof(int16_t));
+            return done;
+        }
+
+        static void RenderDevicePass(audio_device_t *device, uint32_t frameCount)
+        {
+            float *mix = device->mix.data();
+            memset(mix, 0, size_t(frameCount) * 2 * sizeof(float));
+            for (size_t i = 0; i < device->voices.size(); i++) {
+                device_voice_t *voice = &device->voices[i];
+                if (!voice->bStarted || !voice->bHasSound) continue;
+                uint32_t frames, processFrames;
+                bool     bEnded;
+                if (voice->bQueued) {
+                    // NOTE: a queue that runs dry does not end the sound. the voice is silent until more is queued.
+                    frames        = PullQueuedFrames(device, intptr_t(i), device->pulled.data(), frameCount);
+                    processFrames = frames ? frameCount : 0;
+                    bEnded        = false;
+                } else {
+                    frames        = PullDeviceVoice(voice, device->pulled.data(), frameCount);
+                    processFrames = frames;
+                    // NOTE: a buffer that runs out right at the end of a pass ends in that pass, as there is no more.
+                    bEnded = frames < frameCount || (!voice->fill && voice->cursor == voice->frameCount);
+                }
+                voice->framesPlayed += frames;
+                if (processFrames) {
+                    float *samples = device->voiceFrames.data();
+                    Int16ToFloat(device->pulled.data(), processFrames * 2, samples);
+                    if (device->desc.onVoiceBufferProcess)
+                        device->desc.onVoiceBufferProcess(
+                            device->desc.gameMemory, intptr_t(i), samples, samples, processFrames, 2, sizeof(float));
+                    for (uint32_t j = 0; j < processFrames * 2; j++) mix[j] += samples[j];
+                }
+                if (bEnded) {
+                    voice->bHasSound = false;
+                    device->endedVoices.push_back(intptr_t(i));
+                }
+            }
+            if (!device->fileName.empty()) {
+                size_t at = device->recorded.size();
+                device->recorded.resize(at + size_t(frameCount) * 2);
+                FloatToInt16(mix, frameCount * 2, device->recorded.data() + at);
+            }
+            device->clock += frameCount;
+        }
+
+        void advanceDevice(audio_device_t *device, uint32_t frameCount)
+        {
+            std::vector<intptr_t>       endedVoices;
+            std::vector<ended_buffer_t> endedBuffers;
+            for (uint32_t done = 0; done < frameCount;) {
+                uint32_t count = math::min(frameCount - done, device->desc.periodFrames);
+                {
+                    std::lock_guard<std::recursive_mutex> lock(device->mutex);
+                    RenderDevicePass(device, count);
+                    endedVoices.swap(device->endedVoices);
+                    endedBuffers.swap(device->endedBuffers);
+                }
+                // NOTE: the end callbacks run after the pass and outside of the lock, as they may give the voices
+                // more to play.
+                for (const ended_buffer_t &ended : endedBuffers) {
+                    if (ended.buffer.onEnd) ended.buffer.onEnd(ended.buffer.context, ended.voiceHandle);
+                }
+                for (intptr_t voiceHandle : endedVoices) {
+                    if (device->desc.onVoiceBufferEnd)
+                        device->desc.onVoiceBufferEnd(device->desc.gameMemory, voiceHandle);
+                }
+                endedVoices.clear();
+                endedBuffers.clear();
+                done += count;
+            }
+        }
+
+        uint64_t getDeviceClock(audio_device_t *device)
+        {
+            std::lock_guard<std::recursive_mutex> lock(device->mutex);
+            return device->clock;
+        }
+
+        // NOTE: the emitters are kept packed in structure of arrays order, so that updateSpatializer works on four
+        // at a time. the arrays are padded to a multiple of four. an emitter handle indexes denseOf, which maps it to
+        // its place in the arrays; removing an emitter moves the last one into its place.
+        struct spatializer_t {
+            mixer_t           *mixer;
+            spatializer_desc_t desc;
+            uint32_t           count;
+
+            std::vector<float> posX, posY, posZ;
+            std::vector<float> velX, velY, velZ;
+            std::vector<float> minDistance, maxDistance, rolloff;
+            std::vector<float> bLinear;  // 1 for ATTENUATION_LINEAR, 0 for ATTENUATION_INVERSE.
+            std::vector<float> baseGain, basePitch;
+            std::vector<float> gain, pan, pitch;  // the results of the last update.
+
+            std::vector<mixer_voice_t>        voices;
+            std::vector<mixer_voice_params_t> sent;  // the parameters last sent to the mixer.
+            std::vector<uint32_t>             denseOf;
+            std::vector<uint32_t>             emitterOf;
+            std::vector<uint32_t>             freeEmitters;
+        };
+
+        // the per emitter arrays, for the code that resizes or moves whole emitters.
+        static std::vector<float> spatializer_t::*const g_emitterArrays[] = { &spatializer_t::posX,
+            &spatializer_t::posY, &spatializer_t::posZ, &spatializer_t::velX, &spatializer_t::velY, &spatializer_t::velZ,
+            &spatializer_t::minDistance, &spatializer_t::maxDistance, &spatializer_t::rolloff, &spatializer_t::bLinear,
+            &spatializer_t::baseGain, &spatializer_t::basePitch, &spatializer_t::gain, &spatializer_t::pan,
+            &spatializer_t::pitch };
+
+        spatializer_t *createSpatializer(mixer_t *mixer, const spatializer_desc_t &desc)
+        {
+            if (!mixer || !desc.maxEmitters || desc.speedOfSound <= 0.f) {
+                AELoggerError("unable to create a spatializer with maxEmitters=%u and speedOfSound=%f",
+                    desc.maxEmitters, desc.speedOfSound);
+                return nullptr;
+            }
+            spatializer_t *spatializer = new spatializer_t();
+            spatializer->mixer         = mixer;
+            spatializer->desc          = desc;
+            uint32_t padded            = (desc.maxEmitters + 3) & ~3u;
+            for (auto array : g_emitterArrays) (spatializer->*array).resize(padded, 0.f);
+            // padding lanes are valid emitters at the listener, so that the math on them stays finite.
+            for (uint32_t i = 0; i < padded; i++) spatializer->maxDistance[i] = 1.f;
+            spatializer->voices.resize(desc.maxEmitters);
+            spatializer->sent.resize(desc.maxEmitters);
+            spatializer->emitterOf.resize(desc.maxEmitters);
+            spatializer->denseOf.resize(desc.maxEmitters, INVALID_EMITTER);
+            for (uint32_t i = desc.maxEmitters; i > 0; i--) spatializer->freeEmitters.push_back(i - 1);
+            return spatializer;
+        }
+
+        void destroySpatializer(spatializer_t *spatializer) { delete spatializer; }
+
+        uint32_t addEmitter(spatializer_t *spatializer, mixer_voice_t voice, const emitter_desc_t &desc)
+        {
+            if (spatializer->freeEmitters.empty()) return INVALID_EMITTER;
+            uint32_t emitter = spatializer->freeEmitters.back();
+            spatializer->freeEmitters.pop_back();
+
+            uint32_t dense                  = spatializer->count++;
+            spatializer->denseOf[emitter]   = dense;
+            spatializer->emitterOf[dense]   = emitter;
+            spatializer->voices[dense]      = voice;
+            spatializer->sent[dense]        = desc.params;
+            spatializer->posX[dense]        = 0.f;
+            spatializer->posY[dense]        = 0.f;
+            spatializer->posZ[dense]        = 0.f;
+            spatializer->velX[dense]        = 0.f;
+            spatializer->velY[dense]        = 0.f;
+            spatializer->velZ[dense]        = 0.f;
+            float minDistance               = math::max(desc.minDistance, 1e-3f);
+            spatializer->minDistance[dense] = minDistance;
+            spatializer->maxDistance[dense] = math::max(desc.maxDistance, minDistance * (1.f + 1e-3f));
+            spatializer->rolloff[dense]     = math::max(desc.rolloff, 0.f);
+            spatializer->bLinear[dense]     = (desc.attenuation == ATTENUATION_LINEAR) ? 1.f : 0.f;
+            spatializer->baseGain[dense]    = desc.params.gain;
+            spatializer->basePitch[dense]   = desc.params.pitch;
+            spatializer->gain[dense]        = desc.params.gain;
+            spatializer->pan[dense]         = 0.f;
+            spatializer->pitch[dense]       = desc.params.pitch;
+            return emitter;
+        }
+
+        void removeEmitter(spatializer_t *spatializer, uint32_t emitter)
+        {
+            if (emitter >= spatializer->desc.maxEmitters || spatializer->denseOf[emitter] == INVALID_EMITTER) return;
+            uint32_t dense = spatializer->denseOf[emitter];
+            uint32_t last  = --spatializer->count;
+            if (dense != last) {
+                for (auto array : g_emitterArrays) (spatializer->*array)[dense] = (spatializer->*array)[last];
+                spatializer->voices[dense]    = spatializer->voices[last];
+                spatializer->sent[dense]      = spatializer->sent[last];
+                spatializer->emitterOf[dense] = spatializer->emitterOf[last];
+                spatializer->denseOf[spatializer->emitterOf[dense]] = dense;
+            }
+            spatializer->denseOf[emitter] = INVALID_EMITTER;
+            spatializer->freeEmitters.push_back(emitter);
+        }
+
+        void setEmitterTransform(spatializer_t *spatializer, uint32_t emitter, math::vec3_t pos, math::vec3_t velocity)
+        {
+            if (emitter >= spatializer->desc.maxEmitters || spatializer->denseOf[emitter] == INVALID_EMITTER) return;
+            uint32_t dense           = spatializer->denseOf[emitter];
+            spatializer->posX[dense] = pos.x;
+            spatializer->posY[dense] = pos.y;
+            spatializer->posZ[dense] = pos.z;
+            spatializer->velX[dense] = velocity.x;
+            spatializer->velY[dense] = velocity.y;
+            spatializer->velZ[dense] = velocity.z;
+        }
+
+        listener_t makeListener(const math::camera_t &cam)
+        {
+            listener_t   listener = {};
+            math::mat4_t rotation = math::buildRotMat4(cam.trans.eulerAngles);
+            listener.pos          = cam.trans.pos;
+            listener.right        = math::vec3_t(rotation * math::vec4_t(1.f, 0.f, 0.f, 0.f));
+            listener.velocity     = cam.velocity;
+            return listener;
+        }
+
+        // NOTE: the Doppler shift follows OpenAL. the velocities are projected onto the line from the emitter to the
+        // listener, and the emitter is kept from reaching the speed of sound, which would divide by zero.
+        static void SpatializeEmitters(spatializer_t *spatializer, const listener_t &listener)
+        {
+            const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f), minusOne = _mm_set1_ps(-1.f);
+            const __m128 lx = _mm_set1_ps(listener.pos.x), ly = _mm_set1_ps(listener.pos.y),
+                         lz = _mm_set1_ps(listener.pos.z);
+            const __m128 rx = _mm_set1_ps(listener.right.x), ry = _mm_set1_ps(listener.right.y),
+                         rz = _mm_set1_ps(listener.right.z);
+            float        factor = spatializer->desc.dopplerFactor, speed = spatializer->desc.speedOfSound;
+            // the listener's velocity, scaled by the doppler factor.
+            const __m128 lvx = _mm_set1_ps(listener.velocity.x * factor), lvy = _mm_set1_ps(listener.velocity.y * factor),
+                         lvz = _mm_set1_ps(listener.velocity.z * factor);
+            const __m128 speedOfSound = _mm_set1_ps(speed), maxApproach = _mm_set1_ps(speed * 0.999f);
+            const __m128 maxPitch     = _mm_set1_ps(MIXER_MAX_PITCH), factors = _mm_set1_ps(factor);
+
+            for (uint32_t i = 0; i < spatializer->count; i += 4) {
+                __m128 dx    = _mm_sub_ps(_mm_loadu_ps(&spatializer->posX[i]), lx);
+                __m128 dy    = _mm_sub_ps(_mm_loadu_ps(&spatializer->posY[i]), ly);
+                __m128 dz    = _mm_sub_ps(_mm_loadu_ps(&spatializer->posZ[i]), lz);
+                __m128 dist2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                __m128 dist  = _mm_sqrt_ps(dist2);
+                // an emitter at the listener has no direction. it is centered and has no Doppler shift.
+                __m128 bAway   = _mm_cmpgt_ps(dist, _mm_set1_ps(1e-6f));
+                __m128 invDist = _mm_and_ps(bAway, _mm_div_ps(one, _mm_max_ps(dist, _mm_set1_ps(1e-6f))));
+
+                __m128 minDistance = _mm_loadu_ps(&spatializer->minDistance[i]);
+                __m128 maxDistance = _mm_loadu_ps(&spatializer->maxDistance[i]);
+                __m128 rolloff     = _mm_loadu_ps(&spatializer->rolloff[i]);
+                __m128 beyond      = _mm_sub_ps(_mm_min_ps(_mm_max_ps(dist, minDistance), maxDistance), minDistance);
+                __m128 inverse     = _mm_div_ps(minDistance, _mm_add_ps(minDistance, _mm_mul_ps(rolloff, beyond)));
+                __m128 linear      = _mm_max_ps(zero,
+                    _mm_sub_ps(one, _mm_div_ps(_mm_mul_ps(rolloff, beyond), _mm_sub_ps(maxDistance, minDistance))));
+                __m128 bLinear     = _mm_cmpneq_ps(_mm_loadu_ps(&spatializer->bLinear[i]), zero);
+                __m128 attenuation = _mm_or_ps(_mm_and_ps(bLinear, linear), _mm_andnot_ps(bLinear, inverse));
+                _mm_storeu_ps(&spatializer->gain[i], _mm_mul_ps(attenuation, _mm_loadu_ps(&spatializer->baseGain[i])));
+
+                // the pan is the sine of the angle between the emitter and the listener's forward.
+                __m128 side = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, rx), _mm_mul_ps(dy, ry)), _mm_mul_ps(dz, rz));
+                __m128 pan  = _mm_min_ps(_mm_max_ps(_mm_mul_ps(side, invDist), minusOne), one);
+                _mm_storeu_ps(&spatializer->pan[i], pan);
+
+                // the speeds of the listener and the emitter toward each other.
+                __m128 listenerSpeed = _mm_mul_ps(invDist,
+                    _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, lvx), _mm_mul_ps(dy, lvy)), _mm_mul_ps(dz, lvz)));
+                __m128 evx          = _mm_loadu_ps(&spatializer->velX[i]);
+                __m128 evy          = _mm_loadu_ps(&spatializer->velY[i]);
+                __m128 evz          = _mm_loadu_ps(&spatializer->velZ[i]);
+                __m128 emitterSpeed = _mm_mul_ps(_mm_mul_ps(invDist, factors),
+                    _mm_sub_ps(zero,
+                        _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, evx), _mm_mul_ps(dy, evy)), _mm_mul_ps(dz, evz))));
+                __m128 ratio        = _mm_div_ps(_mm_add_ps(speedOfSound, _mm_min_ps(listenerSpeed, speedOfSound)),
+                    _mm_sub_ps(speedOfSound, _mm_min_ps(emitterSpeed, maxApproach)));
+                ratio = _mm_max_ps(ratio, zero);
+                _mm_storeu_ps(
+                    &spatializer->pitch[i], _mm_min_ps(_mm_mul_ps(ratio, _mm_loadu_ps(&spatializer->basePitch[i])), maxPitch));
+            }
+        }
+
+        void updateSpatializer(spatializer_t *spatializer, const listener_t &listener)
+        {
+            SpatializeEmitters(spatializer, listener);
+            for (uint32_t i = 0; i < spatializer->count; i++) {
+                mixer_voice_params_t params = { spatializer->gain[i], spatializer->pan[i], spatializer->pitch[i] };
+                mixer_voice_params_t &sent  = spatializer->sent[i];
+                if (params.gain == sent.gain && params.pan == sent.pan && params.pitch == sent.pitch) continue;
+                mixerSetParams(spatializer->mixer, spatializer->voices[i], params);
+                sent = params;
+            }
+        }
+
+        mixer_voice_params_t getEmitterParams(spatializer_t *spatializer, uint32_t emitter)
+        {
+            if (emitter >= spatializer->desc.maxEmitters || spatializer->denseOf[emitter] == INVALID_EMITTER) return {};
+            uint32_t dense = spatializer->denseOf[emitter];
+            return { spatializer->gain[dense], spatializer->pan[dense], spatializer->pitch[dense] };
+        }
+
+    }  // namespace audio
+}  // namespace automata_engine
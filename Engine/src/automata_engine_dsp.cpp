@@ -0,0 +1,505 @@
+#include <automata_engine.hpp>
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include <emmintrin.h>
+
+namespace automata_engine {
+    namespace dsp {
+
+        static constexpr float DSP_PI = 3.14159265f;
+
+        // NOTE: FTZ flushes denormal results to zero and DAZ reads denormal inputs as zero. a recursive effect fed
+        // silence decays through the denormals, where each float operation costs many times more on x86. the mode
+        // of the calling thread is restored on return.
+        struct flush_denormals_t {
+            uint32_t csr;
+            flush_denormals_t() : csr(_mm_getcsr()) { _mm_setcsr(csr | _MM_FLUSH_ZERO_ON | 0x0040 /* DAZ */); }
+            ~flush_denormals_t() { _mm_setcsr(csr); }
+        };
+
+        // load the first LANES channels of a frame into the low lanes. the other lanes are zero.
+        template <uint32_t LANES> static inline __m128 LoadLanes(const float *src)
+        {
+            if constexpr (LANES == 1) return _mm_load_ss(src);
+            if constexpr (LANES == 2) return _mm_castpd_ps(_mm_load_sd((const double *)src));
+            if constexpr (LANES == 3)
+                return _mm_movelh_ps(_mm_castpd_ps(_mm_load_sd((const double *)src)), _mm_load_ss(src + 2));
+            if constexpr (LANES == 4) return _mm_loadu_ps(src);
+        }
+
+        template <uint32_t LANES> static inline void StoreLanes(float *dst, __m128 v)
+        {
+            if constexpr (LANES == 1) _mm_store_ss(dst, v);
+            if constexpr (LANES == 2) _mm_store_sd((double *)dst, _mm_castps_pd(v));
+            if constexpr (LANES == 3) {
+                _mm_store_sd((double *)dst, _mm_castps_pd(v));
+                _mm_store_ss(dst + 2, _mm_movehl_ps(v, v));
+            }
+            if constexpr (LANES == 4) _mm_storeu_ps(dst, v);
+        }
+
+        // run a kernel over the channels of a block, four channels at a time. the kernel is instanced per lane count
+        // so that the loads and stores of the inner loop do not branch.
+        template <typename kernel_t>
+        static void ForEachLaneGroup(float *samples, uint32_t channels, kernel_t kernel)
+        {
+            for (uint32_t first = 0; first < channels; first += 4) {
+                switch (math::min(channels - first, 4u)) {
+                    case 1:
+                        kernel.template operator()<1>(samples + first, first);
+                        break;
+                    case 2:
+                        kernel.template operator()<2>(samples + first, first);
+                        break;
+                    case 3:
+                        kernel.template operator()<3>(samples + first, first);
+                        break;
+                    default:
+                        kernel.template operator()<4>(samples + first, first);
+                        break;
+                }
+            }
+        }
+
+        void designBiquad(
+            biquad_t *filter, biquad_type_t type, float sampleRate, float frequency, float q, float gainDb)
+        {
+            frequency       = math::max(1e-3f, math::min(frequency, sampleRate * 0.4999f));
+            q               = math::max(q, 1e-3f);
+            float w0        = 2.f * DSP_PI * frequency / sampleRate;
+            float cosW0     = cosf(w0);
+            float alpha     = sinf(w0) / (2.f * q);
+            float A         = powf(10.f, gainDb / 40.f);
+            float sqrtAlpha = 2.f * sqrtf(A) * alpha;
+
+            float b0, b1, b2, a0, a1, a2;
+            switch (type) {
+                case BIQUAD_LOWPASS:
+                    b0 = b2 = (1.f - cosW0) * 0.5f;
+                    b1      = 1.f - cosW0;
+                    a0 = 1.f + alpha, a1 = -2.f * cosW0, a2 = 1.f - alpha;
+                    break;
+                case BIQUAD_HIGHPASS:
+                    b0 = b2 = (1.f + cosW0) * 0.5f;
+                    b1      = -(1.f + cosW0);
+                    a0 = 1.f + alpha, a1 = -2.f * cosW0, a2 = 1.f - alpha;
+                    break;
+                case BIQUAD_BANDPASS:  // the peak gain is 0 dB.
+                    b0 = alpha, b1 = 0.f, b2 = -alpha;
+                    a0 = 1.f + alpha, a1 = -2.f * cosW0, a2 = 1.f - alpha;
+                    break;
+                case BIQUAD_NOTCH:
+                    b0 = 1.f, b1 = -2.f * cosW0, b2 = 1.f;
+                    a0 = 1.f + alpha, a1 = -2.f * cosW0, a2 = 1.f - alpha;
+                    break;
+                case BIQUAD_PEAK:
+                    b0 = 1.f + alpha * A, b1 = -2.f * cosW0, b2 = 1.f - alpha * A;
+                    a0 = 1.f + alpha / A, a1 = -2.f * cosW0, a2 = 1.f - alpha / A;
+                    break;
+                case BIQUAD_LOWSHELF:
+                    b0 = A * ((A + 1.f) - (A - 1.f) * cosW0 + sqrtAlpha);
+                    b1 = 2.f * A * ((A - 1.f) - (A + 1.f) * cosW0);
+                    b2 = A * ((A + 1.f) - (A - 1.f) * cosW0 - sqrtAlpha);
+                    a0 = (A + 1.f) + (A - 1.f) * cosW0 + sqrtAlpha;
+                    a1 = -2.f * ((A - 1.f) + (A + 1.f) * cosW0);
+                    a2 = (A + 1.f) + (A - 1.f) * cosW0 - sqrtAlpha;
+                    break;
+                case BIQUAD_HIGHSHELF:
+                    b0 = A * ((A + 1.f) + (A - 1.f) * cosW0 + sqrtAlpha);
+                    b1 = -2.f * A * ((A - 1.f) + (A + 1.f) * cosW0);
+                    b2 = A * ((A + 1.f) + (A - 1.f) * cosW0 - sqrtAlpha);
+                    a0 = (A + 1.f) - (A - 1.f) * cosW0 + sqrtAlpha;
+                    a1 = 2.f * ((A - 1.f) - (A + 1.f) * cosW0);
+                    a2 = (A + 1.f) - (A - 1.f) * cosW0 - sqrtAlpha;
+                    break;
+                default:
+                    AELoggerError("unknown biquad type %u", (uint32_t)type);
+                    b0 = a0 = 1.f, b1 = b2 = a1 = a2 = 0.f;
+                    break;
+            }
+            filter->b0 = b0 / a0;
+            filter->b1 = b1 / a0;
+            filter->b2 = b2 / a0;
+            filter->a1 = a1 / a0;
+            filter->a2 = a2 / a0;
+        }
+
+        void processBiquad(biquad_t *filter, float *samples, uint32_t frameCount, uint32_t channels)
+        {
+            flush_denormals_t ftz;
+            const __m128      b0 = _mm_set1_ps(filter->b0), b1 = _mm_set1_ps(filter->b1), b2 = _mm_set1_ps(filter->b2);
+            const __m128      a1 = _mm_set1_ps(filter->a1), a2 = _mm_set1_ps(filter->a2);
+            ForEachLaneGroup(samples, channels, [&]<uint32_t LANES>(float *p, uint32_t first) {
+                __m128 z1 = _mm_loadu_ps(filter->z1 + first);
+                __m128 z2 = _mm_loadu_ps(filter->z2 + first);
+                for (uint32_t i = 0; i < frameCount; i++, p += channels) {
+                    __m128 x = LoadLanes<LANES>(p);
+                    __m128 y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+                    z1       = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(b1, x), z2), _mm_mul_ps(a1, y));
+                    z2       = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+                    StoreLanes<LANES>(p, y);
+                }
+                _mm_storeu_ps(filter->z1 + first, z1);
+                _mm_storeu_ps(filter->z2 + first, z2);
+            });
+        }
+
+        void designOnePole(one_pole_t *filter, float sampleRate, float cutoff)
+        {
+            filter->a = 1.f - expf(-2.f * DSP_PI * math::max(cutoff, 0.f) / sampleRate);
+        }
+
+        void processOnePole(one_pole_t *filter, float *samples, uint32_t frameCount, uint32_t channels)
+        {
+            flush_denormals_t ftz;
+            const __m128      a = _mm_set1_ps(filter->a);
+            ForEachLaneGroup(samples, channels, [&]<uint32_t LANES>(float *p, uint32_t first) {
+                __m128 y = _mm_loadu_ps(filter->y + first);
+                for (uint32_t i = 0; i < frameCount; i++, p += channels) {
+                    y = _mm_add_ps(y, _mm_mul_ps(a, _mm_sub_ps(LoadLanes<LANES>(p), y)));
+                    StoreLanes<LANES>(p, y);
+                }
+                _mm_storeu_ps(filter->y + first, y);
+            });
+        }
+
+        void applySmoothedGain(one_pole_t *smoother, float gain, float *samples, uint32_t frameCount, uint32_t channels)
+        {
+            flush_denormals_t ftz;
+            // NOTE: n steps of the smoother leave gain + (y - gain) * (1 - a)^n. so the gains of the next four
+            // frames are computed at once, from the powers of 1 - a.
+            float  r       = 1.f - smoother->a;
+            float  r4      = r * r * r * r;
+            float  offset  = smoother->y[0] - gain;
+            __m128 target  = _mm_set1_ps(gain);
+            __m128 offsets = _mm_mul_ps(_mm_set1_ps(offset), _mm_setr_ps(r, r * r, r * r * r, r4));
+
+            uint32_t i = 0;
+            for (; i + 4 <= frameCount; i += 4) {
+                __m128 gains = _mm_add_ps(target, offsets);
+                offsets      = _mm_mul_ps(offsets, _mm_set1_ps(r4));
+                offset *= r4;
+                float *p = samples + size_t(i) * channels;
+                if (channels == 2) {
+                    _mm_storeu_ps(p, _mm_mul_ps(_mm_loadu_ps(p), _mm_unpacklo_ps(gains, gains)));
+                    _mm_storeu_ps(p + 4, _mm_mul_ps(_mm_loadu_ps(p + 4), _mm_unpackhi_ps(gains, gains)));
+                } else {
+                    alignas(16) float frameGains[4];
+                    _mm_store_ps(frameGains, gains);
+                    for (uint32_t f = 0; f < 4; f++)
+                        for (uint32_t c = 0; c < channels; c++) p[f * channels + c] *= frameGains[f];
+                }
+            }
+            for (; i < frameCount; i++) {
+                offset *= r;
+                for (uint32_t c = 0; c < channels; c++) samples[size_t(i) * channels + c] *= gain + offset;
+            }
+            smoother->y[0] = gain + offset;
+        }
+
+        // NOTE: 2^(slope * log2(x)), four at a time, for the gains of the compressor. log2 splits x into its exponent
+        // and mantissa, and fits log2 of the mantissa with a polynomial. exp2 splits its argument into whole and
+        // fractional parts in the same way. both polynomials are least squares fits with an error under 2e-5.
+        static inline __m128 PowFast(__m128 x, __m128 slope)
+        {
+            __m128i bits     = _mm_castps_si128(x);
+            __m128  exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+            __m128  t        = _mm_sub_ps(
+                _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x7FFFFF)), _mm_set1_epi32(0x3F800000))),
+                _mm_set1_ps(1.f));
+            __m128 p = _mm_set1_ps(0.045268292f);
+            p        = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-0.19351652f));
+            p        = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(0.41524556f));
+            p        = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-0.70886522f));
+            p        = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.4418799f));
+            __m128 y = _mm_mul_ps(slope, _mm_add_ps(exponent, _mm_mul_ps(p, t)));
+
+            // 2^y for y <= 0. below -126 the result would be a denormal, so it is clamped there.
+            y              = _mm_max_ps(y, _mm_set1_ps(-126.f));
+            __m128i whole  = _mm_cvttps_epi32(y);  // rounds toward zero, so the fraction is in (-1, 0].
+            __m128  f      = _mm_sub_ps(y, _mm_cvtepi32_ps(whole));
+            whole          = _mm_sub_epi32(whole, _mm_set1_epi32(1));
+            f              = _mm_add_ps(f, _mm_set1_ps(1.f));  // now in (0, 1].
+            __m128 e       = _mm_set1_ps(0.0018951072f);
+            e              = _mm_add_ps(_mm_mul_ps(e, f), _mm_set1_ps(0.0089462150f));
+            e              = _mm_add_ps(_mm_mul_ps(e, f), _mm_set1_ps(0.055863282f));
+            e              = _mm_add_ps(_mm_mul_ps(e, f), _mm_set1_ps(0.24014077f));
+            e              = _mm_add_ps(_mm_mul_ps(e, f), _mm_set1_ps(0.69315462f));
+            e              = _mm_add_ps(_mm_mul_ps(e, f), _mm_set1_ps(0.99999990f));
+            __m128 scale   = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(whole, _mm_set1_epi32(127)), 23));
+            return _mm_mul_ps(e, scale);
+        }
+
+        void designCompressor(compressor_t *compressor, float sampleRate, const compressor_params_t &params)
+        {
+            compressor->threshold = powf(10.f, params.thresholdDb / 20.f);
+            compressor->slope     = 1.f / math::max(params.ratio, 1.f) - 1.f;
+            compressor->attack    = (params.attackTime > 0.f) ? expf(-1.f / (params.attackTime * sampleRate)) : 0.f;
+            compressor->release   = (params.releaseTime > 0.f) ? expf(-1.f / (params.releaseTime * sampleRate)) : 0.f;
+            compressor->makeup    = powf(10.f, params.makeupDb / 20.f);
+        }
+
+        void processCompressor(compressor_t *compressor, float *samples, uint32_t frameCount, uint32_t channels)
+        {
+            flush_denormals_t ftz;
+            // NOTE: the envelope follower is serial, so it runs first over a span of frames. the gains of the span
+            // are then computed four frames at a time.
+            constexpr uint32_t spanFrames = 64;
+            alignas(16) float  gains[spanFrames] = {};
+            const __m128       slope     = _mm_set1_ps(compressor->slope);
+            const __m128       invThresh = _mm_set1_ps(1.f / compressor->threshold);
+            const __m128       one       = _mm_set1_ps(1.f);
+            const __m128       makeup    = _mm_set1_ps(compressor->makeup);
+            // with an infinite ratio, the gain is exactly threshold / envelope, which keeps the limit exact.
+            const bool bLimiter = compressor->slope == -1.f;
+            float      envelope = compressor->envelope;
+
+            for (uint32_t done = 0; done < frameCount; done += spanFrames) {
+                uint32_t count = math::min(frameCount - done, spanFrames);
+                float   *p     = samples + size_t(done) * channels;
+                for (uint32_t i = 0; i < count; i++) {
+                    float peak = 0.f;
+                    for (uint32_t c = 0; c < channels; c++) peak = math::max(peak, fabsf(p[i * channels + c]));
+                    float coeff = (peak > envelope) ? compressor->attack : compressor->release;
+                    envelope    = peak + coeff * (envelope - peak);
+                    gains[i]    = envelope;
+                }
+                for (uint32_t i = 0; i < count; i += 4) {
+                    __m128 over = _mm_max_ps(_mm_mul_ps(_mm_load_ps(gains + i), invThresh), one);
+                    __m128 gain = bLimiter ? _mm_div_ps(one, over) : PowFast(over, slope);
+                    _mm_store_ps(gains + i, _mm_mul_ps(gain, makeup));
+                }
+                if (channels == 2) {
+                    uint32_t i = 0;
+                    for (; i + 2 <= count; i += 2) {
+                        __m128 g = _mm_setr_ps(gains[i], gains[i], gains[i + 1], gains[i + 1]);
+                        _mm_storeu_ps(p + i * 2, _mm_mul_ps(_mm_loadu_ps(p + i * 2), g));
+                    }
+                    for (; i < count; i++) p[i * 2] *= gains[i], p[i * 2 + 1] *= gains[i];
+                } else {
+                    for (uint32_t i = 0; i < count; i++)
+                        for (uint32_t c = 0; c < channels; c++) p[i * channels + c] *= gains[i];
+                }
+            }
+            compressor->envelope = envelope;
+        }
+
+        // NOTE: the delay line holds frames in the layout of the block, so a span of frames is one contiguous span
+        // of samples in both. no sample of a span may be read after it is written, so a span is at most the delay
+        // long, and it stops at the end of the line so that it does not wrap.
+        struct delay_t {
+            delay_desc_t       desc;
+            std::vector<float> line;
+            uint32_t           lineFrames;
+            uint32_t           delayFrames;
+            uint32_t           cursor;  // the frame that is written next.
+        };
+
+        delay_t *createDelay(const delay_desc_t &desc)
+        {
+            if (!desc.channels || desc.channels > DSP_MAX_CHANNELS || desc.sampleRate <= 0.f) {
+                AELoggerError("unable to create a delay with %u channels at %f Hz", desc.channels, desc.sampleRate);
+                return nullptr;
+            }
+            delay_t *delay    = new delay_t();
+            delay->desc       = desc;
+            delay->lineFrames = math::max(1u, uint32_t(ceilf(desc.maxDelayTime * desc.sampleRate)));
+            delay->line.resize(size_t(delay->lineFrames) * desc.channels, 0.f);
+            setDelayParams(delay, desc.params);
+            return delay;
+        }
+
+        void destroyDelay(delay_t *delay) { delete delay; }
+
+        void setDelayParams(delay_t *delay, const delay_params_t &params)
+        {
+            delay->desc.params = params;
+            float frames       = roundf(params.delayTime * delay->desc.sampleRate);
+            delay->delayFrames = uint32_t(math::max(1.f, math::min(frames, float(delay->lineFrames))));
+        }
+
+        void processDelay(delay_t *delay, float *samples, uint32_t frameCount)
+        {
+            flush_denormals_t ftz;
+            const uint32_t    channels = delay->desc.channels;
+            const __m128      feedback = _mm_set1_ps(delay->desc.params.feedback);
+            const __m128      wet      = _mm_set1_ps(delay->desc.params.wet);
+            const __m128      dry      = _mm_set1_ps(delay->desc.params.dry);
+            float             fb = delay->desc.params.feedback, wt = delay->desc.params.wet, dr = delay->desc.params.dry;
+
+            for (uint32_t done = 0; done < frameCount;) {
+                uint32_t read  = (delay->cursor + delay->lineFrames - delay->delayFrames) % delay->lineFrames;
+                uint32_t count = math::min(frameCount - done, delay->delayFrames);
+                count          = math::min(count, delay->lineFrames - delay->cursor);
+                count          = math::min(count, delay->lineFrames - read);
+
+                float       *io  = samples + size_t(done) * channels;
+                float       *dst = delay->line.data() + size_t(delay->cursor) * channels;
+                const float *src = delay->line.data() + size_t(read) * channels;
+                uint32_t     n   = count * channels;
+                uint32_t     i   = 0;
+                for (; i + 4 <= n; i += 4) {
+                    __m128 x = _mm_loadu_ps(io + i);
+                    __m128 d = _mm_loadu_ps(src + i);
+                    _mm_storeu_ps(dst + i, _mm_add_ps(x, _mm_mul_ps(feedback, d)));
+                    _mm_storeu_ps(io + i, _mm_add_ps(_mm_mul_ps(dry, x), _mm_mul_ps(wet, d)));
+                }
+                for (; i < n; i++) {
+                    float x = io[i], d = src[i];
+                    dst[i]  = x + fb * d;
+                    io[i]   = dr * x + wt * d;
+                }
+
+                delay->cursor = (delay->cursor + count) % delay->lineFrames;
+                done += count;
+            }
+        }
+
+        // NOTE: the reverb is a feedback delay network of eight delay lines, mixed by an 8x8 Hadamard matrix. the
+        // matrix is orthogonal, so the network loses energy only through the gain and damping of each line, which
+        // set the decay. the eight lines are two SIMD registers. the lengths are the comb lengths of Freeverb.
+        static constexpr uint32_t REVERB_LINE_COUNT = 8;
+        static constexpr uint32_t g_reverbLengths[REVERB_LINE_COUNT] = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 };
+        static constexpr float    g_reverbLengthsRate                = 44100.f;  // the rate of the lengths.
+
+        struct reverb_t {
+            reverb_desc_t      desc;
+            std::vector<float> lines;
+            float             *line[REVERB_LINE_COUNT];
+            uint32_t           length[REVERB_LINE_COUNT];
+            uint32_t           cursor[REVERB_LINE_COUNT];
+            alignas(16) float  gain[REVERB_LINE_COUNT];
+            alignas(16) float  damped[REVERB_LINE_COUNT];  // the state of the lowpass of each line.
+            float              damping;                    // the coefficient of the lowpasses.
+        };
+
+        reverb_t *createReverb(const reverb_desc_t &desc)
+        {
+            if (!desc.channels || desc.channels > DSP_MAX_CHANNELS || desc.sampleRate <= 0.f) {
+                AELoggerError("unable to create a reverb with %u channels at %f Hz", desc.channels, desc.sampleRate);
+                return nullptr;
+            }
+            reverb_t *reverb = new reverb_t();
+            reverb->desc     = desc;
+            size_t total     = 0;
+            for (uint32_t i = 0; i < REVERB_LINE_COUNT; i++) {
+                reverb->length[i] =
+                    math::max(1u, uint32_t(g_reverbLengths[i] * desc.sampleRate / g_reverbLengthsRate + 0.5f));
+                total += reverb->length[i];
+            }
+            reverb->lines.resize(total, 0.f);
+            float *line = reverb->lines.data();
+            for (uint32_t i = 0; i < REVERB_LINE_COUNT; i++) {
+                reverb->line[i] = line;
+                line += reverb->length[i];
+            }
+            setReverbParams(reverb, desc.params);
+            return reverb;
+        }
+
+        void destroyReverb(reverb_t *reverb) { delete reverb; }
+
+        void setReverbParams(reverb_t *reverb, const reverb_params_t &params)
+        {
+            reverb->desc.params = params;
+            float decayTime     = math::max(params.decayTime, 1e-3f);
+            // each pass through a line of n frames must lose n / (decayTime * sampleRate) of 60 dB.
+            for (uint32_t i = 0; i < REVERB_LINE_COUNT; i++)
+                reverb->gain[i] = powf(10.f, -3.f * reverb->length[i] / (decayTime * reverb->desc.sampleRate));
+            reverb->damping =
+                1.f - expf(-2.f * DSP_PI * math::max(params.dampingFrequency, 1.f) / reverb->desc.sampleRate);
+        }
+
+        // the 4x4 Hadamard matrix, unscaled.
+        static inline __m128 Hadamard4(__m128 v)
+        {
+            // (v0 + v1, v0 - v1, v2 + v3, v2 - v3).
+            __m128 even = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 0, 0));
+            __m128 odd  = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 1, 1));
+            __m128 sign = _mm_setr_ps(1.f, -1.f, 1.f, -1.f);
+            __m128 s    = _mm_add_ps(even, _mm_mul_ps(odd, sign));
+            // (s0 + s2, s1 + s3, s0 - s2, s1 - s3).
+            __m128 lo = _mm_movelh_ps(s, s);
+            __m128 hi = _mm_movehl_ps(s, s);
+            return _mm_add_ps(lo, _mm_mul_ps(hi, _mm_setr_ps(1.f, 1.f, -1.f, -1.f)));
+        }
+
+        static inline float HorizontalSum(__m128 v)
+        {
+            __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+            s        = _mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1)));
+            return _mm_cvtss_f32(s);
+        }
+
+        void processReverb(reverb_t *reverb, float *samples, uint32_t frameCount)
+        {
+            flush_denormals_t ftz;
+            const uint32_t    channels = reverb->desc.channels;
+            const float       wet = reverb->desc.params.wet, dry = reverb->desc.params.dry;
+            const __m128      gainLo = _mm_load_ps(reverb->gain), gainHi = _mm_load_ps(reverb->gain + 4);
+            const __m128      damping = _mm_set1_ps(reverb->damping);
+            // 1 / sqrt(8) makes the Hadamard matrix orthonormal.
+            const __m128 norm = _mm_set1_ps(0.35355339f);
+            // the input goes into every line with alternating signs, and each ear hears its own signs of the lines,
+            // so that the two ears are decorrelated.
+            const __m128 inputSigns = _mm_setr_ps(0.5f, -0.5f, 0.5f, -0.5f);
+            const __m128 leftLo = _mm_setr_ps(1.f, 1.f, -1.f, -1.f), leftHi = _mm_setr_ps(1.f, -1.f, 1.f, -1.f);
+            const __m128 rightLo = _mm_setr_ps(1.f, -1.f, 1.f, -1.f), rightHi = _mm_setr_ps(-1.f, -1.f, 1.f, 1.f);
+            __m128       dampedLo = _mm_load_ps(reverb->damped), dampedHi = _mm_load_ps(reverb->damped + 4);
+
+            for (uint32_t done = 0; done < frameCount;) {
+                // a span ends where the first line wraps, so that the inner loop indexes each line directly.
+                uint32_t count = frameCount - done;
+                for (uint32_t l = 0; l < REVERB_LINE_COUNT; l++)
+                    count = math::min(count, reverb->length[l] - reverb->cursor[l]);
+                float *p[REVERB_LINE_COUNT];
+                for (uint32_t l = 0; l < REVERB_LINE_COUNT; l++) p[l] = reverb->line[l] + reverb->cursor[l];
+
+                float *io = samples + size_t(done) * channels;
+                for (uint32_t i = 0; i < count; i++, io += channels) {
+                    float in = 0.f;
+                    for (uint32_t c = 0; c < channels; c++) in += io[c];
+                    in /= float(channels);
+
+                    __m128 lo = _mm_setr_ps(p[0][i], p[1][i], p[2][i], p[3][i]);
+                    __m128 hi = _mm_setr_ps(p[4][i], p[5][i], p[6][i], p[7][i]);
+                    float  left =
+                        0.25f * HorizontalSum(_mm_add_ps(_mm_mul_ps(lo, leftLo), _mm_mul_ps(hi, leftHi)));
+                    float right =
+                        0.25f * HorizontalSum(_mm_add_ps(_mm_mul_ps(lo, rightLo), _mm_mul_ps(hi, rightHi)));
+
+                    dampedLo = _mm_add_ps(dampedLo, _mm_mul_ps(damping, _mm_sub_ps(lo, dampedLo)));
+                    dampedHi = _mm_add_ps(dampedHi, _mm_mul_ps(damping, _mm_sub_ps(hi, dampedHi)));
+                    __m128 a = Hadamard4(_mm_mul_ps(dampedLo, gainLo));
+                    __m128 b = Hadamard4(_mm_mul_ps(dampedHi, gainHi));
+                    __m128 x = _mm_mul_ps(_mm_set1_ps(in), inputSigns);
+                    lo       = _mm_add_ps(_mm_mul_ps(_mm_add_ps(a, b), norm), x);
+                    hi       = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(a, b), norm), x);
+
+                    alignas(16) float next[REVERB_LINE_COUNT];
+                    _mm_store_ps(next, lo);
+                    _mm_store_ps(next + 4, hi);
+                    for (uint32_t l = 0; l < REVERB_LINE_COUNT; l++) p[l][i] = next[l];
+
+                    if (channels == 1) {
+                        io[0] = dry * io[0] + wet * 0.5f * (left + right);
+                    } else {
+                        for (uint32_t c = 0; c < channels; c++) io[c] = dry * io[c] + wet * ((c & 1) ? right : left);
+                    }
+                }
+
+                for (uint32_t l = 0; l < REVERB_LINE_COUNT; l++) {
+                    reverb->cursor[l] += count;
+                    if (reverb->cursor[l] == reverb->length[l]) reverb->cursor[l] = 0;
+                }
+                done += count;
+            }
+            _mm_store_ps(reverb->damped, dampedLo);
+            _mm_store_ps(reverb->damped + 4, dampedHi);
+        }
+
+    }  // namespace dsp
+}  // namespace automata_engine
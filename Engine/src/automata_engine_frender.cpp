@@ -1,145 +1,370 @@
 #include <automata_engine.hpp>
+#include "automata_engine_frender_platform.h"
+
+#include <algorithm>
+#include <atomic>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+#include <emmintrin.h>
 
 namespace automata_engine {
     namespace frender {
 
-        struct backbuffer_t {
-            uint32_t *memory;
-            uint32_t  width;
-            uint32_t  height;
-            uint32_t  bytesPerPixel;
-            uint32_t  pitch;
-        };
-
-        static int FloatToInt(float Value)
+        // replicate count 0xABGR pixels scale times each into dst as 0xARGB.
+        static void ExpandSpan(uint32_t *dst, const uint32_t *src, uint32_t count, uint32_t scale)
         {
-            //TODO: Intrisnic
-            //apparently there is a lot more complexity than just this.
-            int Result = (int)(Value + 0.5f);
-            if (Value < 0.0f) { Result = (int)(Value - 0.5f); }
-            return Result;
+            uint32_t i = 0;
+            switch (scale) {
+                case 2:
+                    for (; i + 4 <= count; i += 4) {
+                        __m128i s = SwizzleRB(_mm_loadu_si128((const __m128i *)(src + i)));
+                        _mm_storeu_si128((__m128i *)(dst + i * 2), _mm_unpacklo_epi32(s, s));
+                        _mm_storeu_si128((__m128i *)(dst + i * 2 + 4), _mm_unpackhi_epi32(s, s));
+                    }
+                    break;
+                case 3:
+                    for (; i + 4 <= count; i += 4) {
+                        __m128i s = SwizzleRB(_mm_loadu_si128((const __m128i *)(src + i)));
+                        _mm_storeu_si128((__m128i *)(dst + i * 3), _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 0, 0)));
+                        _mm_storeu_si128((__m128i *)(dst + i * 3 + 4), _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 2, 1, 1)));
+                        _mm_storeu_si128((__m128i *)(dst + i * 3 + 8), _mm_shuffle_epi32(s, _MM_SHUFFLE(3, 3, 3, 2)));
+                    }
+                    break;
+                case 4:
+                    for (; i + 4 <= count; i += 4) {
+                        __m128i s = SwizzleRB(_mm_loadu_si128((const __m128i *)(src + i)));
+                        _mm_storeu_si128((__m128i *)(dst + i * 4), _mm_shuffle_epi32(s, 0x00));
+                        _mm_storeu_si128((__m128i *)(dst + i * 4 + 4), _mm_shuffle_epi32(s, 0x55));
+                        _mm_storeu_si128((__m128i *)(dst + i * 4 + 8), _mm_shuffle_epi32(s, 0xAA));
+                        _mm_storeu_si128((__m128i *)(dst + i * 4 + 12), _mm_shuffle_epi32(s, 0xFF));
+                    }
+                    break;
+            }
+            for (; i < count; i++) {
+                uint32_t p = SwizzleRB(src[i]);
+                for (uint32_t k = 0; k < scale; k++) dst[i * scale + k] = p;
+            }
         }
 
-        static void DrawBitmapScaled(backbuffer_t *buffer,
-            ae::loaded_image_t                     Bitmap,
-            float                                  RealMinX,
-            float                                  RealMaxX,
-            float                                  RealMinY,
-            float                                  RealMaxY,
-            unsigned int                           Scalar)
+        void drawBitmap(backbuffer_t *target, const loaded_image_t &image, int32_t x, int32_t y, uint32_t scale)
         {
-            if (Scalar < 0.f) return;
-            float DrawHeight = (RealMaxY - RealMinY) / (float)Scalar;
-            RealMaxY         = RealMinY + DrawHeight;
+            if (!image.pixelPointer || !scale) return;
 
-            int MinX = FloatToInt(RealMinX);
-            int MaxX = FloatToInt(RealMaxX);
-            int MinY = FloatToInt(RealMinY);
-            int MaxY = FloatToInt(RealMaxY);
+            // clip once. everything below works within the clipped rectangle of the target.
+            int64_t right  = int64_t(x) + int64_t(image.width) * scale;
+            int64_t bottom = int64_t(y) + int64_t(image.height) * scale;
+            int32_t minX   = math::max(x, 0);
+            int32_t minY   = math::max(y, 0);
+            int32_t maxX   = int32_t(math::min(right, int64_t(target->width)));
+            int32_t maxY   = int32_t(math::min(bottom, int64_t(target->height)));
+            if (minX >= maxX || minY >= maxY) return;
+            markDirty(target, minX, minY, maxX - minX, maxY - minY);
 
-            unsigned int PitchShift = 0;
-            unsigned int PixelShift = 0;
-
-            if (MaxX > buffer->width) { MaxX = buffer->width; }
+            // NOTE: the image rows are bottom first.
+            auto srcRow = [&](int32_t py) {
+                return image.pixelPointer + size_t(image.height - 1 - uint32_t(py - y) / scale) * image.width;
+            };
+            auto dstRow = [&](int32_t py) {
+                return (uint32_t *)((uint8_t *)target->memory + size_t(py) * target->pitch);
+            };
 
-            if ((MinY + (int)Bitmap.height) < MaxY) { MaxY = MinY + Bitmap.height; }
+            if (scale == 1) {
+                for (int32_t py = minY; py < maxY; py++)
+                    BlendSpan<true>(dstRow(py) + minX, srcRow(py) + (minX - x), uint32_t(maxX - minX));
+                return;
+            }
 
-            if ((MinX + (int)Bitmap.width * (int)Scalar) < MaxX) { MaxX = MinX + Bitmap.width * (int)Scalar; }
+            // a chunk of a source row is replicated and swizzled once, then blended into each of the rows of the
+            // target that it covers.
+            constexpr uint32_t   CHUNK = 256;
+            alignas(16) uint32_t expanded[CHUNK + 8];
+            for (int32_t py = minY; py < maxY;) {
+                int32_t         rowEnd = math::min(maxY, py + int32_t(scale - uint32_t(py - y) % scale));
+                const uint32_t *src    = srcRow(py);
+                for (int32_t px = minX; px < maxX; px += CHUNK) {
+                    uint32_t  length = math::min(uint32_t(maxX - px), CHUNK);
+                    uint32_t  column = uint32_t(px - x) / scale;
+                    uint32_t  phase  = uint32_t(px - x) % scale;
+                    uint32_t *span   = expanded;
+                    if (scale <= 4) {
+                        ExpandSpan(expanded, src + column, (phase + length + scale - 1) / scale, scale);
+                        span += phase;
+                    } else {
+                        for (uint32_t i = 0; i < length; i++) {
+                            expanded[i] = SwizzleRB(src[column]);
+                            if (++phase == scale) phase = 0, column++;
+                        }
+                    }
+                    for (int32_t row = py; row < rowEnd; row++) BlendSpan<false>(dstRow(row) + px, span, length);
+                }
+                py = rowEnd;
+            }
+        }
 
-            int MaxDrawY = (MaxY - MinY) * (int)Scalar + MinY;
-            if (MaxDrawY > buffer->height) { MaxY = (buffer->height - MinY) / (int)Scalar + MinY; }
+        // NOTE: a fill of at least this many bytes streams past the cache, since it would evict more than it could
+        // keep. a fill of at least FILL_PARALLEL_PIXELS is split across the jobs by rows.
+        static constexpr size_t   FILL_STREAM_BYTES    = 1 << 20;
+        static constexpr size_t   FILL_PARALLEL_PIXELS = 1 << 18;
+        static constexpr uint32_t FILL_ROWS_PER_JOB    = 32;
 
-            if (MinX < 0) {
-                PixelShift = (unsigned int)abs((float)MinX / (float)Scalar);
-                MinX       = 0;
+        template <bool STREAM> static void FillSpan(uint32_t *dst, uint32_t count, uint32_t color)
+        {
+            const __m128i c = _mm_set1_epi32(int32_t(color));
+            uint32_t      i = 0;
+            // NOTE: the streaming stores must be aligned to 16 bytes.
+            for (; i < count && (uintptr_t(dst + i) & 15); i++) dst[i] = color;
+            for (; i + 16 <= count; i += 16) {
+                __m128i *p = (__m128i *)(dst + i);
+                if constexpr (STREAM) {
+                    _mm_stream_si128(p, c);
+                    _mm_stream_si128(p + 1, c);
+                    _mm_stream_si128(p + 2, c);
+                    _mm_stream_si128(p + 3, c);
+                } else {
+                    _mm_store_si128(p, c);
+                    _mm_store_si128(p + 1, c);
+                    _mm_store_si128(p + 2, c);
+                    _mm_store_si128(p + 3, c);
+                }
             }
-
-            if (MinY < 0) {
-                PitchShift = (unsigned int)abs((float)MinY / (float)Scalar);
-                MaxY += FloatToInt(abs((float)MinY / (float)Scalar));
-                MinY = 0;
+            for (; i + 4 <= count; i += 4) {
+                if constexpr (STREAM) _mm_stream_si128((__m128i *)(dst + i), c);
+                else _mm_store_si128((__m128i *)(dst + i), c);
             }
+            for (; i < count; i++) dst[i] = color;
+        }
+
+        void fill(backbuffer_t *target, int32_t x, int32_t y, int32_t width, int32_t height, uint32_t color)
+        {
+            int64_t minX = math::max(int64_t(x), int64_t(0));
+            int64_t minY = math::max(int64_t(y), int64_t(0));
+            int64_t maxX = math::min(int64_t(x) + width, int64_t(target->width));
+            int64_t maxY = math::min(int64_t(y) + height, int64_t(target->height));
+            if (minX >= maxX || minY >= maxY) return;
+            markDirty(target, int32_t(minX), int32_t(minY), int32_t(maxX - minX), int32_t(maxY - minY));
 
-            unsigned char *Row =
-                ((unsigned char *)buffer->memory) + MinX * buffer->bytesPerPixel + MinY * buffer->pitch;
+            const uint32_t count   = uint32_t(maxX - minX);
+            const uint32_t rows    = uint32_t(maxY - minY);
+            const bool     bStream = size_t(count) * rows * sizeof(uint32_t) >= FILL_STREAM_BYTES;
+            uint8_t       *first   = (uint8_t *)target->memory + size_t(minY) * target->pitch + minX * sizeof(uint32_t);
+            const uint32_t pitch   = target->pitch;
+            auto           fillRows = [=](uint32_t begin, uint32_t end) {
+                uint8_t *row = first + size_t(begin) * pitch;
+                for (uint32_t r = begin; r < end; r++, row += pitch) {
+                    if (bStream) FillSpan<true>((uint32_t *)row, count, color);
+                    else FillSpan<false>((uint32_t *)row, count, color);
+                }
+                // NOTE: the streaming stores are weakly ordered, so they are fenced before the job is done.
+                if (bStream) _mm_sfence();
+            };
+            if (size_t(count) * rows >= FILL_PARALLEL_PIXELS) jobs::parallelFor(rows, FILL_ROWS_PER_JOB, fillRows);
+            else fillRows(0, rows);
+        }
 
-            unsigned int *SourceRow =
-                Bitmap.pixelPointer + Bitmap.width * (Bitmap.height - 1 - PitchShift) + PixelShift;
-            int Counter = 1;
+        void clear(backbuffer_t *target, uint32_t color)
+        {
+            fill(target, 0, 0, int32_t(target->width), int32_t(target->height), color);
+        }
 
-            for (int Y = MinY; Y < MaxY; ++Y) {
-                unsigned int *Pixel       = (unsigned int *)Row;
-                unsigned int *SourcePixel = SourceRow;
-                for (int X = MinX; X < MaxX; ++X) {
-                    if ((*SourcePixel >> 24) & 1) {
-                        *Pixel = *SourcePixel;
-                        for (unsigned int j = 1; j < (int)Scalar; j++) {
-                            unsigned int *PixelBelow = Pixel + buffer->width * j;
-                            *PixelBelow              = *SourcePixel;
-                        }
-                    }
+        // NOTE: the resampler is separable. each source row that a target row needs is filtered across once, to 16
+        // bits per channel with RESAMPLE_ROW_BITS of fraction, and kept while the next target rows use it. the
+        // weights are fixed point with RESAMPLE_WEIGHT_BITS of fraction and sum to exactly 1, so that a flat image
+        // stays flat.
+        static constexpr int32_t RESAMPLE_WEIGHT_BITS = 14;
+        static constexpr int32_t RESAMPLE_ROW_BITS    = 6;
 
-                    Pixel++;
+        // the taps of a filter, and their weights as pairs of int16 for _mm_madd_epi16.
+        struct resample_taps_t {
+            int32_t index[4];
+            int32_t weightPairs[2];
+        };
 
-                    if (Counter % (int)Scalar == 0) { SourcePixel += 1; }
-                    Counter++;
+        // the taps of a filter at position, in source pixels where the pixel centers are at integers. the taps are
+        // clamped to the edges of the image.
+        static resample_taps_t ResampleTaps(image_filter_t filter, float position, uint32_t size)
+        {
+            float   base  = floorf(position);
+            float   t     = position - base;
+            int32_t first = int32_t(base);
+            float   w[4];
+            int32_t count;
+            if (filter == IMAGE_FILTER_BICUBIC) {
+                // Catmull-Rom, which passes through the pixels and so is exact at a scale of 1.
+                float t2 = t * t, t3 = t2 * t;
+                w[0]     = 0.5f * (-t3 + 2.f * t2 - t);
+                w[1]     = 0.5f * (3.f * t3 - 5.f * t2 + 2.f);
+                w[2]     = 0.5f * (-3.f * t3 + 4.f * t2 + t);
+                w[3]     = 0.5f * (t3 - t2);
+                first -= 1;
+                count = 4;
+            } else {
+                w[0]  = 1.f - t;
+                w[1]  = t;
+                count = 2;
+            }
+            resample_taps_t taps = {};
+            int32_t         one  = 1 << RESAMPLE_WEIGHT_BITS;
+            int32_t         sum  = 0;
+            int32_t         fixed[4];
+            for (int32_t k = 0; k < count; k++) {
+                taps.index[k] = math::min(math::max(first + k, 0), int32_t(size) - 1);
+                fixed[k]      = (k + 1 < count) ? int32_t(lrintf(w[k] * one)) : one - sum;
+                sum += fixed[k];
+            }
+            for (int32_t k = 0; k < count; k += 2)
+                taps.weightPairs[k / 2] = (fixed[k] & 0xFFFF) | (uint32_t(fixed[k + 1]) << 16);
+            return taps;
+        }
+
+        // the channels of two pixels interleaved, as int16 pairs for _mm_madd_epi16.
+        static inline __m128i InterleavePixels(uint32_t a, uint32_t b)
+        {
+            return _mm_unpacklo_epi8(
+                _mm_unpacklo_epi8(_mm_cvtsi32_si128(int32_t(a)), _mm_cvtsi32_si128(int32_t(b))), _mm_setzero_si128());
+        }
+
+        // filter a source row across into count pixels of 4 int16 channels. out has room for an even count.
+        template <uint32_t TAPS>
+        static void ResampleRow(int16_t *out, const uint32_t *src, const resample_taps_t *columns, uint32_t count)
+        {
+            const __m128i round = _mm_set1_epi32(1 << (RESAMPLE_WEIGHT_BITS - RESAMPLE_ROW_BITS - 1));
+            __m128i       pixel[2];
+            for (uint32_t i = 0; i < count; i += 2) {
+                for (uint32_t j = 0; j < 2; j++) {
+                    const resample_taps_t &c   = columns[math::min(i + j, count - 1)];
+                    __m128i                acc = _mm_madd_epi16(InterleavePixels(src[c.index[0]], src[c.index[1]]),
+                        _mm_set1_epi32(c.weightPairs[0]));
+                    if constexpr (TAPS == 4) {
+                        acc = _mm_add_epi32(acc, _mm_madd_epi16(InterleavePixels(src[c.index[2]], src[c.index[3]]),
+                                                     _mm_set1_epi32(c.weightPairs[1])));
+                    }
+                    pixel[j] = _mm_srai_epi32(_mm_add_epi32(acc, round), RESAMPLE_WEIGHT_BITS - RESAMPLE_ROW_BITS);
                 }
+                _mm_storeu_si128((__m128i *)(out + i * 4), _mm_packs_epi32(pixel[0], pixel[1]));
+            }
+        }
 
-                SourceRow -= Bitmap.width;
-                Row     = Row + buffer->pitch * (int)Scalar;
-                Counter = 1;
+        // combine TAPS filtered rows down into count 0xARGB pixels. out has room for a multiple of 4 pixels.
+        template <uint32_t TAPS>
+        static void ResampleColumns(uint32_t *out, int16_t *const *rows, const resample_taps_t &taps, uint32_t count)
+        {
+            constexpr int32_t shift = RESAMPLE_WEIGHT_BITS + RESAMPLE_ROW_BITS;
+            const __m128i     round = _mm_set1_epi32(1 << (shift - 1));
+            const __m128i     w01   = _mm_set1_epi32(taps.weightPairs[0]);
+            const __m128i     w23   = _mm_set1_epi32(taps.weightPairs[1]);
+            // two pixels of 4 int16 channels at a time, as int32 channels.
+            auto twoPixels = [&](uint32_t i) {
+                __m128i r0 = _mm_loadu_si128((const __m128i *)(rows[0] + i * 4));
+                __m128i r1 = _mm_loadu_si128((const __m128i *)(rows[1] + i * 4));
+                __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(r0, r1), w01);
+                __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(r0, r1), w01);
+                if constexpr (TAPS == 4) {
+                    __m128i r2 = _mm_loadu_si128((const __m128i *)(rows[2] + i * 4));
+                    __m128i r3 = _mm_loadu_si128((const __m128i *)(rows[3] + i * 4));
+                    lo         = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(r2, r3), w23));
+                    hi         = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(r2, r3), w23));
+                }
+                lo = _mm_srai_epi32(_mm_add_epi32(lo, round), shift);
+                hi = _mm_srai_epi32(_mm_add_epi32(hi, round), shift);
+                return _mm_packs_epi32(lo, hi);
+            };
+            for (uint32_t i = 0; i < count; i += 4) {
+                __m128i p = SwizzleRB(_mm_packus_epi16(twoPixels(i), twoPixels(i + 2)));
+                if constexpr (TAPS == 4) {
+                    // NOTE: the lobes of the bicubic overshoot, which could leave a color brighter than its alpha.
+                    __m128i alpha = _mm_srli_epi32(p, 24);
+                    alpha         = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 8));
+                    alpha         = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+                    p             = _mm_min_epu8(p, _mm_or_si128(alpha, _mm_set1_epi32(0xFF000000)));
+                }
+                _mm_storeu_si128((__m128i *)(out + i), p);
             }
         }
 
-        // for drawing images loaded from .BMP
-        static void DrawBitmap(backbuffer_t *buffer,
-            ae::loaded_image_t               Bitmap,
-            float                            RealMinX,
-            float                            RealMaxX,
-            float                            RealMinY,
-            float                            RealMaxY)
+        template <uint32_t TAPS>
+        static void DrawBitmapResampled(backbuffer_t *target,
+            const loaded_image_t                     &image,
+            float                                     x,
+            float                                     y,
+            float                                     width,
+            float                                     height,
+            image_filter_t                            filter)
         {
-            int MinX = FloatToInt(RealMinX);
-            int MaxX = FloatToInt(RealMaxX);
-            int MinY = FloatToInt(RealMinY);
-            int MaxY = FloatToInt(RealMaxY);
+            // the pixels whose centers are within the rectangle, clipped to the target.
+            int32_t minX = math::max(0, int32_t(ceilf(x - 0.5f)));
+            int32_t minY = math::max(0, int32_t(ceilf(y - 0.5f)));
+            int32_t maxX = int32_t(math::min(ceilf(x + width - 0.5f), float(target->width)));
+            int32_t maxY = int32_t(math::min(ceilf(y + height - 0.5f), float(target->height)));
+            if (minX >= maxX || minY >= maxY) return;
+            markDirty(target, minX, minY, maxX - minX, maxY - minY);
+
+            const uint32_t count  = uint32_t(maxX - minX);
+            const uint32_t padded = (count + 3) & ~3u;
+            const float    scaleX = image.width / width;
+            const float    scaleY = image.height / height;
 
-            if (MinX < 0) { MinX = 0; }
-            if (MinY < 0) { MinY = 0; }
-            if (MaxX > buffer->width) { MaxX = buffer->width; }
-            if (MaxY > buffer->height) { MaxY = buffer->height; }
-            if (MinX + (int)Bitmap.width < MaxX) { MaxX = MinX + Bitmap.width; }
-            if (MinY + (int)Bitmap.height < MaxY) { MaxY = MinY + Bitmap.height; }
+            std::vector<resample_taps_t> columns(count);
+            for (uint32_t i = 0; i < count; i++)
+                columns[i] = ResampleTaps(filter, (minX + i + 0.5f - x) * scaleX - 0.5f, image.width);
 
-            unsigned char *Row =
-                ((unsigned char *)buffer->memory) + MinX * buffer->bytesPerPixel + MinY * buffer->pitch;
+            // a slot per tap for the filtered source rows. consecutive rows fall in different slots.
+            std::vector<int16_t>  rowMemory(TAPS * size_t(padded) * 4, 0);
+            std::vector<uint32_t> span(padded);
+            int32_t               rowOfSlot[TAPS];
+            for (uint32_t k = 0; k < TAPS; k++) rowOfSlot[k] = -1;
 
-            unsigned int *SourceRow = (unsigned int *)Bitmap.pixelPointer + Bitmap.width * (Bitmap.height - 1);
-            for (int Y = MinY; Y < MaxY; ++Y) {
-                unsigned int *Pixel       = (unsigned int *)Row;
-                unsigned int *SourcePixel = SourceRow;
-                for (int X = MinX; X < MaxX; ++X) {
-                    if ((*SourcePixel >> 24) & 1) { *Pixel = *SourcePixel; }
-                    Pixel++;
-                    SourcePixel += 1;
+            for (int32_t py = minY; py < maxY; py++) {
+                resample_taps_t taps = ResampleTaps(filter, (py + 0.5f - y) * scaleY - 0.5f, image.height);
+                int16_t        *rows[TAPS];
+                for (uint32_t k = 0; k < TAPS; k++) {
+                    int32_t  row  = taps.index[k];
+                    uint32_t slot = uint32_t(row) % TAPS;
+                    rows[k]       = rowMemory.data() + size_t(slot) * padded * 4;
+                    if (rowOfSlot[slot] == row) continue;
+                    // NOTE: the image rows are bottom first.
+                    const uint32_t *src = image.pixelPointer + size_t(image.height - 1 - row) * image.width;
+                    ResampleRow<TAPS>(rows[k], src, columns.data(), count);
+                    rowOfSlot[slot] = row;
                 }
-                SourceRow -= Bitmap.width;
-                Row += buffer->pitch;
+                ResampleColumns<TAPS>(span.data(), rows, taps, count);
+                BlendSpan<false>((uint32_t *)((uint8_t *)target->memory + size_t(py) * target->pitch) + minX,
+                    span.data(), count);
             }
         }
 
+        void drawBitmapScaled(backbuffer_t *target,
+            const loaded_image_t           &image,
+            float                           x,
+            float                           y,
+            float                           width,
+            float                           height,
+            image_filter_t                  filter)
+        {
+            if (!image.pixelPointer || !image.width || !image.height || !(width > 0.f) || !(height > 0.f)) return;
+            if (filter == IMAGE_FILTER_BICUBIC)
+                DrawBitmapResampled<4>(target, image, x, y, width, height, filter);
+            else
+                DrawBitmapResampled<2>(target, image, x, y, width, height, filter);
+        }
+
         void engineIntroRender(
             uint32_t *pixels, uint32_t width, uint32_t height, float introElapsed, loaded_image_t logo)
         {
+            backbuffer_t backbuffer = {.memory = pixels,
+                .width                         = width,
+                .height                        = height,
+                .bytesPerPixel                 = sizeof(uint32_t),
+                .pitch                         = sizeof(uint32_t) * width};
+
             // render solid black.
-            uint32_t *pp = (uint32_t *)pixels;
-            for (uint32_t y = 0; y < height; y++) {
-                for (uint32_t x = 0; x < width; x++) { *(pp + x) = 0; }
-                pp += width;
-            }
+            clear(&backbuffer, 0);
 
             // draw the logo in the middle and scale over time.
-            uint32_t scaleFactor     = (1.0f) + 4.f * sqrtf(introElapsed);
+            float    scaleFactor     = (1.0f) + 4.f * sqrtf(introElapsed);
             float    scaledImgWidth  = logo.width * scaleFactor;
             float    scaledImgHeight = logo.height * scaleFactor;
 
@@ -161,20 +386,1501 @@ namespace automata_engine {
             float posX = offsetX + width / 2.f - scaledImgWidth / 2.f;
             float posY = offsetY + height / 2.f - scaledImgHeight / 2.f;
 
-            backbuffer_t backbuffer = {.memory = pixels,
-                .width                         = width,
-                .height                        = height,
-                .bytesPerPixel                 = sizeof(uint32_t),
-                .pitch                         = sizeof(uint32_t) * width};
-
-            DrawBitmapScaled(&backbuffer, logo, posX, posX + scaledImgWidth, posY, posY + scaledImgHeight, scaleFactor);
+            drawBitmapScaled(
+                &backbuffer, logo, posX, posY, scaledImgWidth, scaledImgHeight, IMAGE_FILTER_BILINEAR);
         }
 
         void engineIntroLoadAssets(loaded_image_t *pLogo, loaded_wav_t *pTheme)
         {
             // TODO: below should be in the IO namespace.
             *pLogo  = ae::platform::stbImageLoad("res\\logo.png");
+            if (pLogo->pixelPointer) premultiplyAlpha(*pLogo);
             *pTheme = ae::io::loadWav("res\\engine.wav");
         }
+
+        // NOTE: the tiles and subpixels of the rasterizer are in automata_engine_frender_platform.h, which the UI
+        // renderer shares them from.
+        // the vertices of raw_model_t::vertexData are x,y,z, u,v, nx,ny,nz.
+        static constexpr uint32_t RASTER_VERTEX_STRIDE = 8;
+        // triangles that reach further than this many pixels from the center of the target are clipped. this keeps
+        // the screen positions within 18 bits of subpixels, so that an edge function that crosses a tile stays
+        // within 32 bits across the tile. see RasterTile.
+        static constexpr float    RASTER_GUARD_BAND = 8192.f;
+        // the near and far planes and the four guard band planes. a triangle gains at most one vertex per plane.
+        static constexpr uint32_t RASTER_CLIP_PLANES       = 6;
+        static constexpr uint32_t RASTER_CLIP_MASK         = (1 << RASTER_CLIP_PLANES) - 1;
+        static constexpr uint32_t RASTER_MAX_CLIP_VERTICES = 3 + RASTER_CLIP_PLANES;
+
+        struct raster_vertex_t {
+            math::vec4_t pos;  // clip space.
+            float        u;
+            float        v;
+            uint32_t     outcode;  // a bit per clip plane, then a bit per side of the viewport, set when outside.
+        };
+
+        // the edge functions are E(x, y) = a * x + b * y + c over subpixel positions, and are >= 0 inside.
+        // the planes give depth, 1/w, u/w and v/w as value + d/dx * (x - x0) + d/dy * (y - y0) over pixels.
+        struct raster_triangle_t {
+            int32_t               a[3];
+            int32_t               b[3];
+            int64_t               c[3];
+            int32_t               minX, minY, maxX, maxY;
+            float                 x0, y0;
+            float                 planes[4][3];
+            const loaded_image_t *texture;
+            uint32_t              color;
+        };
+
+        struct rasterizer_t {
+            backbuffer_t                       target;
+            math::mat4_t                       viewProj;
+            uint32_t                           tilesX;
+            uint32_t                           tilesY;
+            uint32_t                           depthPitch;  // in floats. a multiple of 4 so that spans never wrap.
+            std::vector<float>                 depth;
+            std::vector<raster_vertex_t>       vertices;  // the transformed vertices of the draw in flight.
+            std::vector<raster_triangle_t>     triangles;
+            std::vector<std::vector<uint32_t>> bins;  // triangle indices per tile.
+            raster_stats_t                     stats;
+        };
+
+        rasterizer_t *createRasterizer() { return new rasterizer_t(); }
+
+        void destroyRasterizer(rasterizer_t *rasterizer) { delete rasterizer; }
+
+        bool beginRaster(rasterizer_t *rasterizer, const backbuffer_t &target, const math::mat4_t &viewProj)
+        {
+            if (!target.memory || !target.width || !target.height || target.width > RASTER_MAX_SIZE ||
+                target.height > RASTER_MAX_SIZE || target.bytesPerPixel != sizeof(uint32_t)) {
+                AELoggerError("unable to rasterize to a %ux%u target with %u bytes per pixel",
+                    target.width, target.height, target.bytesPerPixel);
+                return false;
+            }
+            rasterizer->target     = target;
+            rasterizer->viewProj   = viewProj;
+            rasterizer->tilesX     = (target.width + RASTER_TILE_SIZE - 1) >> RASTER_TILE_SHIFT;
+            rasterizer->tilesY     = (target.height + RASTER_TILE_SIZE - 1) >> RASTER_TILE_SHIFT;
+            rasterizer->depthPitch = (target.width + 3) & ~3u;
+            // NOTE: the depth is cleared by each tile as it renders, see RasterTile.
+            rasterizer->depth.resize(size_t(rasterizer->depthPitch) * target.height);
+            rasterizer->triangles.clear();
+            rasterizer->bins.resize(size_t(rasterizer->tilesX) * rasterizer->tilesY);
+            for (auto &bin : rasterizer->bins) bin.clear();
+            rasterizer->stats = {};
+            return true;
+        }
+
+        static float ClipDistance(const math::vec4_t &p, uint32_t plane, float guardX, float guardY)
+        {
+            switch (plane) {
+                case 0:
+                    return p.z + p.w;
+                case 1:
+                    return p.w - p.z;
+                case 2:
+                    return guardX * p.w - p.x;
+                case 3:
+                    return guardX * p.w + p.x;
+                case 4:
+                    return guardY * p.w - p.y;
+                default:
+                    return guardY * p.w + p.y;
+            }
+        }
+
+        // Sutherland-Hodgman against the planes in the mask. poly must have room for RASTER_MAX_CLIP_VERTICES.
+        static uint32_t ClipPolygon(raster_vertex_t *poly, uint32_t count, uint32_t planeMask, float gx, float gy)
+        {
+            raster_vertex_t  scratch[RASTER_MAX_CLIP_VERTICES];
+            raster_vertex_t *in  = poly;
+            raster_vertex_t *out = scratch;
+            for (uint32_t plane = 0; plane < RASTER_CLIP_PLANES && count >= 3; plane++) {
+                if (!(planeMask & (1 << plane))) continue;
+                uint32_t n = 0;
+                for (uint32_t i = 0; i < count; i++) {
+                    const raster_vertex_t &a  = in[i];
+                    const raster_vertex_t &b  = in[(i + 1) % count];
+                    float                  da = ClipDistance(a.pos, plane, gx, gy);
+                    float                  db = ClipDistance(b.pos, plane, gx, gy);
+                    if (da >= 0.f) out[n++] = a;
+                    if ((da >= 0.f) != (db >= 0.f)) {
+                        float            t = da / (da - db);
+                        raster_vertex_t &v = out[n++];
+                        v.pos              = a.pos + (b.pos + a.pos * -1.f) * t;
+                        v.u                = a.u + (b.u - a.u) * t;
+                        v.v                = a.v + (b.v - a.v) * t;
+                    }
+                }
+                raster_vertex_t *swap = in;
+                in                    = out;
+                out                   = swap;
+                count                 = n;
+            }
+            if (count < 3) return 0;
+            if (in != poly) memcpy(poly, in, sizeof(raster_vertex_t) * count);
+            return count;
+        }
+
+        static uint32_t ShadeColor(uint32_t color, float light)
+        {
+            uint32_t result = color & 0xFF000000;
+            for (uint32_t shift = 0; shift < 24; shift += 8) {
+                float channel = float((color >> shift) & 0xFF) * light + 0.5f;
+                result |= uint32_t(math::min(channel, 255.f)) << shift;
+            }
+            return result;
+        }
+
+        static void SetupTriangle(rasterizer_t *rasterizer,
+            const raster_vertex_t                *verts[3],
+            const raster_material_t              &material,
+            math::vec3_t                          normal)
+        {
+            raster_stats_t &stats = rasterizer->stats;
+            float           halfW = rasterizer->target.width * 0.5f;
+            float           halfH = rasterizer->target.height * 0.5f;
+
+            // NOTE: the positions are snapped to subpixels, and the planes are built from the snapped positions so
+            // that they agree with the edge functions.
+            int32_t fx[3], fy[3];
+            float   sx[3], sy[3], attribs[3][4];
+            for (uint32_t i = 0; i < 3; i++) {
+                const raster_vertex_t &v    = *verts[i];
+                float                  invW = 1.f / v.pos.w;
+                fx[i]                       = (int32_t)lrintf((v.pos.x * invW + 1.f) * halfW * RASTER_SUBPIXEL);
+                fy[i]                       = (int32_t)lrintf((1.f - v.pos.y * invW) * halfH * RASTER_SUBPIXEL);
+                sx[i]                       = fx[i] * (1.f / RASTER_SUBPIXEL);
+                sy[i]                       = fy[i] * (1.f / RASTER_SUBPIXEL);
+                attribs[i][0]               = v.pos.z * invW * 0.5f + 0.5f;
+                attribs[i][1]               = invW;
+                attribs[i][2]               = v.u * invW;
+                attribs[i][3]               = v.v * invW;
+            }
+
+            // NOTE: y grows down the target, so the triangles that are counter-clockwise in NDC have negative area.
+            int64_t area = int64_t(fx[1] - fx[0]) * (fy[2] - fy[0]) - int64_t(fy[1] - fy[0]) * (fx[2] - fx[0]);
+            if (area == 0 || (area > 0 && material.bCullBackfaces)) {
+                stats.culled++;
+                return;
+            }
+            bool bFront = area < 0;
+            if (bFront) {
+                // make the winding clockwise on screen so that the inside of every edge is positive.
+                std::swap(fx[1], fx[2]);
+                std::swap(fy[1], fy[2]);
+                std::swap(sx[1], sx[2]);
+                std::swap(sy[1], sy[2]);
+                for (uint32_t k = 0; k < 4; k++) std::swap(attribs[1][k], attribs[2][k]);
+            }
+
+            // the pixels whose centers are within the bounds of the triangle.
+            const int32_t     half = RASTER_SUBPIXEL / 2;
+            raster_triangle_t tri;
+            tri.minX = math::max(0, (math::min(fx[0], math::min(fx[1], fx[2])) - half + RASTER_SUBPIXEL - 1) >> 4);
+            tri.minY = math::max(0, (math::min(fy[0], math::min(fy[1], fy[2])) - half + RASTER_SUBPIXEL - 1) >> 4);
+            tri.maxX = math::min(int32_t(rasterizer->target.width) - 1,
+                (math::max(fx[0], math::max(fx[1], fx[2])) - half) >> RASTER_SUBPIXEL_BITS);
+            tri.maxY = math::min(int32_t(rasterizer->target.height) - 1,
+                (math::max(fy[0], math::max(fy[1], fy[2])) - half) >> RASTER_SUBPIXEL_BITS);
+            if (tri.minX > tri.maxX || tri.minY > tri.maxY) {
+                stats.culled++;
+                return;
+            }
+
+            for (uint32_t e = 0; e < 3; e++) {
+                uint32_t i = e, j = (e + 1) % 3;
+                tri.a[e]   = fy[i] - fy[j];
+                tri.b[e]   = fx[j] - fx[i];
+                tri.c[e]   = -(int64_t(tri.a[e]) * fx[i] + int64_t(tri.b[e]) * fy[i]);
+                // NOTE: the top-left fill rule. a pixel center exactly on an edge shared by two triangles belongs
+                // to the triangle that the edge is the top or the left of, so that it is drawn once.
+                bool bTopLeft = tri.a[e] > 0 || (tri.a[e] == 0 && tri.b[e] > 0);
+                if (!bTopLeft) tri.c[e] -= 1;
+            }
+
+            float dx1 = sx[1] - sx[0], dy1 = sy[1] - sy[0];
+            float dx2 = sx[2] - sx[0], dy2 = sy[2] - sy[0];
+            float invDet = 1.f / (dx1 * dy2 - dx2 * dy1);
+            tri.x0       = sx[0];
+            tri.y0       = sy[0];
+            for (uint32_t k = 0; k < 4; k++) {
+                float da1        = attribs[1][k] - attribs[0][k];
+                float da2        = attribs[2][k] - attribs[0][k];
+                tri.planes[k][0] = attribs[0][k];
+                tri.planes[k][1] = (da1 * dy2 - da2 * dy1) * invDet;
+                tri.planes[k][2] = (da2 * dx1 - da1 * dx2) * invDet;
+            }
+
+            tri.texture = (material.texture && material.texture->pixelPointer) ? material.texture : nullptr;
+            tri.color   = material.color;
+            if (material.bLit) {
+                // NOTE: the normal of a back face that is drawn faces away from the viewer.
+                float len   = math::magnitude(normal);
+                float nDotL = 0.f;
+                if (len > 0.f) nDotL = math::dot(normal * ((bFront ? 1.f : -1.f) / len), material.lightDir);
+                float light = material.ambient + (1.f - material.ambient) * math::max(0.f, nDotL);
+                tri.color   = ShadeColor(material.color, light);
+            }
+
+            // bin to the tiles that the bounds overlap, skipping the tiles that are wholly outside of an edge.
+            uint32_t index   = (uint32_t)rasterizer->triangles.size();
+            bool     bBinned = false;
+            for (int32_t ty = tri.minY >> RASTER_TILE_SHIFT; ty <= tri.maxY >> RASTER_TILE_SHIFT; ty++) {
+                for (int32_t tx = tri.minX >> RASTER_TILE_SHIFT; tx <= tri.maxX >> RASTER_TILE_SHIFT; tx++) {
+                    int32_t x0       = math::max(tri.minX, tx << RASTER_TILE_SHIFT);
+                    int32_t y0       = math::max(tri.minY, ty << RASTER_TILE_SHIFT);
+                    int32_t x1       = math::min(tri.maxX, ((tx + 1) << RASTER_TILE_SHIFT) - 1);
+                    int32_t y1       = math::min(tri.maxY, ((ty + 1) << RASTER_TILE_SHIFT) - 1);
+                    bool    bOutside = false;
+                    for (uint32_t e = 0; e < 3 && !bOutside; e++) {
+                        int64_t corner = int64_t(tri.a[e]) * (x0 * RASTER_SUBPIXEL + half) +
+                                         int64_t(tri.b[e]) * (y0 * RASTER_SUBPIXEL + half) + tri.c[e];
+                        int64_t maxE = corner + int64_t(math::max(tri.a[e], 0)) * (x1 - x0) * RASTER_SUBPIXEL +
+                                       int64_t(math::max(tri.b[e], 0)) * (y1 - y0) * RASTER_SUBPIXEL;
+                        bOutside = maxE < 0;
+                    }
+                    if (bOutside) continue;
+                    rasterizer->bins[ty * rasterizer->tilesX + tx].push_back(index);
+                    stats.tileTriangles++;
+                    bBinned = true;
+                }
+            }
+            if (!bBinned) {
+                stats.culled++;
+                return;
+            }
+            rasterizer->triangles.push_back(tri);
+            stats.binned++;
+        }
+
+        void rasterModel(rasterizer_t *rasterizer,
+            const raw_model_t         &model,
+            const math::mat4_t        &modelMat,
+            const raster_material_t   &material,
+            const uint32_t            *indices,
+            uint32_t                   indexCount)
+        {
+            if (!indices) {
+                indices    = model.indexData;
+                indexCount = StretchyBufferCount(model.indexData);
+            }
+            const uint32_t vertexCount = StretchyBufferCount(model.vertexData) / RASTER_VERTEX_STRIDE;
+            if (!indexCount || !vertexCount) return;
+
+            // transform every vertex of the model once, in parallel.
+            math::mat4_t mvp = rasterizer->viewProj * modelMat;
+            rasterizer->vertices.resize(vertexCount);
+            raster_vertex_t *vertices = rasterizer->vertices.data();
+            const float     *data     = model.vertexData;
+            jobs::parallelFor(vertexCount, 4096, [=](uint32_t begin, uint32_t end) {
+                for (uint32_t i = begin; i < end; i++) {
+                    const float     *src = data + i * RASTER_VERTEX_STRIDE;
+                    raster_vertex_t &v   = vertices[i];
+                    math::vec4_t     p   = mvp * math::vec4_t(src[0], src[1], src[2], 1.f);
+                    v.pos                = p;
+                    v.u                  = src[3];
+                    v.v                  = src[4];
+                    v.outcode            = 0;
+                    // the near and far planes, then the viewport. the guard band is tested per triangle.
+                    if (p.z + p.w < 0.f) v.outcode |= 1 << 0;
+                    if (p.w - p.z < 0.f) v.outcode |= 1 << 1;
+                    if (p.x > p.w) v.outcode |= 1 << 6;
+                    if (p.x < -p.w) v.outcode |= 1 << 7;
+                    if (p.y > p.w) v.outcode |= 1 << 8;
+                    if (p.y < -p.w) v.outcode |= 1 << 9;
+                }
+            });
+
+            float guardX       = RASTER_GUARD_BAND / (rasterizer->target.width * 0.5f);
+            float guardY       = RASTER_GUARD_BAND / (rasterizer->target.height * 0.5f);
+            auto  guardOutcode = [=](const math::vec4_t &p) {
+                uint32_t outcode = 0;
+                for (uint32_t plane = 2; plane < RASTER_CLIP_PLANES; plane++) {
+                    if (ClipDistance(p, plane, guardX, guardY) < 0.f) outcode |= 1 << plane;
+                }
+                return outcode;
+            };
+
+            for (uint32_t t = 0; t + 2 < indexCount; t += 3) {
+                rasterizer->stats.triangles++;
+                if (indices[t] >= vertexCount || indices[t + 1] >= vertexCount || indices[t + 2] >= vertexCount) {
+                    rasterizer->stats.culled++;
+                    continue;
+                }
+                const raster_vertex_t *verts[3] = {
+                    &vertices[indices[t]], &vertices[indices[t + 1]], &vertices[indices[t + 2]]};
+                if (verts[0]->outcode & verts[1]->outcode & verts[2]->outcode) {
+                    rasterizer->stats.culled++;
+                    continue;
+                }
+
+                math::vec3_t normal;
+                if (material.bLit) {
+                    const float *p0 = data + indices[t] * RASTER_VERTEX_STRIDE;
+                    const float *p1 = data + indices[t + 1] * RASTER_VERTEX_STRIDE;
+                    const float *p2 = data + indices[t + 2] * RASTER_VERTEX_STRIDE;
+                    math::vec3_t e1 = math::vec3_t(
+                        modelMat * math::vec4_t(p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2], 0.f));
+                    math::vec3_t e2 = math::vec3_t(
+                        modelMat * math::vec4_t(p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2], 0.f));
+                    normal = math::cross(e1, e2);
+                }
+
+                uint32_t clipMask = (verts[0]->outcode | verts[1]->outcode | verts[2]->outcode) & RASTER_CLIP_MASK;
+                clipMask |= guardOutcode(verts[0]->pos) | guardOutcode(verts[1]->pos) | guardOutcode(verts[2]->pos);
+                if (!clipMask) {
+                    SetupTriangle(rasterizer, verts, material, normal);
+                    continue;
+                }
+
+                rasterizer->stats.clipped++;
+                raster_vertex_t poly[RASTER_MAX_CLIP_VERTICES] = {*verts[0], *verts[1], *verts[2]};
+                uint32_t        count                           = ClipPolygon(poly, 3, clipMask, guardX, guardY);
+                if (!count) rasterizer->stats.culled++;
+                for (uint32_t i = 1; i + 1 < count; i++) {
+                    const raster_vertex_t *fan[3] = {&poly[0], &poly[i], &poly[i + 1]};
+                    SetupTriangle(rasterizer, fan, material, normal);
+                }
+            }
+        }
+
+        // floor(x) for 4 floats that fit in an int32.
+        static inline __m128 Floor4(__m128 x)
+        {
+            __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+            return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.f)));
+        }
+
+        static void RasterTile(rasterizer_t *rasterizer, uint32_t tileIndex)
+        {
+            const std::vector<uint32_t> &bin = rasterizer->bins[tileIndex];
+            if (bin.empty()) return;
+
+            const backbuffer_t &target = rasterizer->target;
+            const int32_t       tileX0 = int32_t(tileIndex % rasterizer->tilesX) << RASTER_TILE_SHIFT;
+            const int32_t       tileY0 = int32_t(tileIndex / rasterizer->tilesX) << RASTER_TILE_SHIFT;
+            const int32_t       tileX1 = math::min(tileX0 + RASTER_TILE_SIZE, int32_t(target.width)) - 1;
+            const int32_t       tileY1 = math::min(tileY0 + RASTER_TILE_SIZE, int32_t(target.height)) - 1;
+            const int32_t       half   = RASTER_SUBPIXEL / 2;
+
+            float *depth = rasterizer->depth.data();
+            for (int32_t y = tileY0; y <= tileY1; y++) {
+                float *row = depth + size_t(y) * rasterizer->depthPitch;
+                for (int32_t x = tileX0; x <= tileX1; x += 4) _mm_storeu_ps(row + x, _mm_set1_ps(1.f));
+            }
+
+            const __m128i laneIndex = _mm_setr_epi32(0, 1, 2, 3);
+            const __m128  laneFloat = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+            for (uint32_t triIndex : bin) {
+                const raster_triangle_t &tri = rasterizer->triangles[triIndex];
+                // spans start on a multiple of 4 pixels, which the tiles and the depth pitch are too.
+                const int32_t x0      = math::max(tri.minX, tileX0) & ~3;
+                const int32_t x1      = math::min(tri.maxX, tileX1);
+                const int32_t y0      = math::max(tri.minY, tileY0);
+                const int32_t y1      = math::min(tri.maxY, tileY1);
+                const int32_t spanEnd = x0 + ((x1 - x0 + 4) & ~3) - 1;
+
+                // NOTE: an edge that is outside of the whole rectangle rejects the triangle. an edge that is inside
+                // of the whole rectangle is not tested. an edge that crosses the rectangle varies by at most
+                // (|a| + |b|) * 64 * 16 < 2^29 across it, so it is stepped in 32 bits.
+                __m128i edgeRow[3], edgeStepX[3], edgeStepY[3];
+                bool    bOutside = false;
+                for (uint32_t e = 0; e < 3 && !bOutside; e++) {
+                    int64_t a = tri.a[e], b = tri.b[e];
+                    int64_t corner =
+                        a * (x0 * RASTER_SUBPIXEL + half) + b * (y0 * RASTER_SUBPIXEL + half) + tri.c[e];
+                    int64_t dx   = int64_t(spanEnd - x0) * RASTER_SUBPIXEL;
+                    int64_t dy   = int64_t(y1 - y0) * RASTER_SUBPIXEL;
+                    int64_t minE = corner + math::min(a, int64_t(0)) * dx + math::min(b, int64_t(0)) * dy;
+                    int64_t maxE = corner + math::max(a, int64_t(0)) * dx + math::max(b, int64_t(0)) * dy;
+                    if (maxE < 0) {
+                        bOutside = true;
+                    } else if (minE >= 0) {
+                        edgeRow[e]   = _mm_setzero_si128();
+                        edgeStepX[e] = _mm_setzero_si128();
+                        edgeStepY[e] = _mm_setzero_si128();
+                    } else {
+                        int32_t stepX = tri.a[e] * RASTER_SUBPIXEL;
+                        edgeRow[e]    = _mm_add_epi32(_mm_set1_epi32(int32_t(corner)),
+                            _mm_setr_epi32(0, stepX, stepX * 2, stepX * 3));
+                        edgeStepX[e] = _mm_set1_epi32(stepX * 4);
+                        edgeStepY[e] = _mm_set1_epi32(tri.b[e] * RASTER_SUBPIXEL);
+                    }
+                }
+                if (bOutside) continue;
+
+                const __m128i         lastX   = _mm_set1_epi32(x1);
+                const __m128          zdx     = _mm_set1_ps(tri.planes[0][1]);
+                const __m128          wdx     = _mm_set1_ps(tri.planes[1][1]);
+                const __m128          udx     = _mm_set1_ps(tri.planes[2][1]);
+                const __m128          vdx     = _mm_set1_ps(tri.planes[3][1]);
+                const __m128i         color   = _mm_set1_epi32(int32_t(tri.color));
+                const bool            bTinted = tri.color != 0xFFFFFFFF;
+                const loaded_image_t *texture = tri.texture;
+
+                for (int32_t y = y0; y <= y1; y++) {
+                    __m128i e0 = edgeRow[0], e1 = edgeRow[1], e2 = edgeRow[2];
+                    // the value of each plane at the pixel center (x + 0.5, y + 0.5) is base + d/dx * (x + 0.5).
+                    float py = float(y) + 0.5f - tri.y0;
+                    float base[4];
+                    for (uint32_t k = 0; k < 4; k++)
+                        base[k] = tri.planes[k][0] + tri.planes[k][2] * py - tri.planes[k][1] * tri.x0;
+
+                    float    *depthRow = depth + size_t(y) * rasterizer->depthPitch;
+                    uint32_t *colorRow = (uint32_t *)((uint8_t *)target.memory + size_t(y) * target.pitch);
+                    for (int32_t x = x0; x <= x1; x += 4) {
+                        __m128i inside = _mm_srai_epi32(_mm_or_si128(_mm_or_si128(e0, e1), e2), 31);
+                        __m128i lanes  = _mm_add_epi32(_mm_set1_epi32(x), laneIndex);
+                        __m128i mask   = _mm_andnot_si128(_mm_or_si128(inside, _mm_cmpgt_epi32(lanes, lastX)),
+                            _mm_set1_epi32(-1));
+                        e0             = _mm_add_epi32(e0, edgeStepX[0]);
+                        e1             = _mm_add_epi32(e1, edgeStepX[1]);
+                        e2             = _mm_add_epi32(e2, edgeStepX[2]);
+                        if (!_mm_movemask_epi8(mask)) continue;
+
+                        __m128 px   = _mm_add_ps(_mm_set1_ps(float(x)), laneFloat);
+                        __m128 z    = _mm_add_ps(_mm_set1_ps(base[0]), _mm_mul_ps(zdx, px));
+                        __m128 oldZ = _mm_loadu_ps(depthRow + x);
+                        mask        = _mm_and_si128(mask, _mm_castps_si128(_mm_cmplt_ps(z, oldZ)));
+                        if (!_mm_movemask_epi8(mask)) continue;
+
+                        __m128i texel = color;
+                        if (texture) {
+                            // NOTE: perspective correct texturing. u/w, v/w and 1/w are linear across the screen.
+                            __m128 invW = _mm_add_ps(_mm_set1_ps(base[1]), _mm_mul_ps(wdx, px));
+                            __m128 w    = _mm_div_ps(_mm_set1_ps(1.f), invW);
+                            __m128 u    = _mm_mul_ps(_mm_add_ps(_mm_set1_ps(base[2]), _mm_mul_ps(udx, px)), w);
+                            __m128 v    = _mm_mul_ps(_mm_add_ps(_mm_set1_ps(base[3]), _mm_mul_ps(vdx, px)), w);
+                            u           = _mm_mul_ps(_mm_sub_ps(u, Floor4(u)), _mm_set1_ps(float(texture->width)));
+                            v           = _mm_mul_ps(_mm_sub_ps(v, Floor4(v)), _mm_set1_ps(float(texture->height)));
+                            alignas(16) int32_t  tu[4], tv[4];
+                            alignas(16) uint32_t fetched[4];
+                            _mm_store_si128((__m128i *)tu, _mm_cvttps_epi32(u));
+                            _mm_store_si128((__m128i *)tv, _mm_cvttps_epi32(v));
+                            for (uint32_t lane = 0; lane < 4; lane++) {
+                                uint32_t s    = math::min(uint32_t(tu[lane]), texture->width - 1);
+                                uint32_t t    = math::min(uint32_t(tv[lane]), texture->height - 1);
+                                fetched[lane] = texture->pixelPointer[t * texture->width + s];
+                            }
+                            texel = SwizzleRB(_mm_load_si128((const __m128i *)fetched));
+                            // texels with alpha below 128 are cut out.
+                            mask = _mm_and_si128(mask, _mm_srai_epi32(texel, 31));
+                            if (!_mm_movemask_epi8(mask)) continue;
+                            if (bTinted) texel = MulColors(texel, color);
+                        }
+
+                        __m128 maskPs = _mm_castsi128_ps(mask);
+                        _mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(maskPs, z), _mm_andnot_ps(maskPs, oldZ)));
+                        if (x + 4 <= int32_t(target.width)) {
+                            __m128i old = _mm_loadu_si128((const __m128i *)(colorRow + x));
+                            _mm_storeu_si128((__m128i *)(colorRow + x),
+                                _mm_or_si128(_mm_and_si128(mask, texel), _mm_andnot_si128(mask, old)));
+                        } else {
+                            alignas(16) uint32_t lanesOut[4], laneMask[4];
+                            _mm_store_si128((__m128i *)lanesOut, texel);
+                            _mm_store_si128((__m128i *)laneMask, mask);
+                            for (int32_t lane = 0; lane < 4; lane++) {
+                                if (laneMask[lane]) colorRow[x + lane] = lanesOut[lane];
+                            }
+                        }
+                    }
+
+                    edgeRow[0] = _mm_add_epi32(edgeRow[0], edgeStepY[0]);
+                    edgeRow[1] = _mm_add_epi32(edgeRow[1], edgeStepY[1]);
+                    edgeRow[2] = _mm_add_epi32(edgeRow[2], edgeStepY[2]);
+                }
+            }
+        }
+
+        void endRaster(rasterizer_t *rasterizer)
+        {
+            uint32_t tileCount = rasterizer->tilesX * rasterizer->tilesY;
+            for (uint32_t tile = 0; tile < tileCount; tile++) {
+                if (rasterizer->bins[tile].empty()) continue;
+                markDirty(&rasterizer->target, int32_t(tile % rasterizer->tilesX) << RASTER_TILE_SHIFT,
+                    int32_t(tile / rasterizer->tilesX) << RASTER_TILE_SHIFT, RASTER_TILE_SIZE, RASTER_TILE_SIZE);
+            }
+            jobs::parallelFor(tileCount, 1, [rasterizer](uint32_t begin, uint32_t end) {
+                for (uint32_t tile = begin; tile < end; tile++) RasterTile(rasterizer, tile);
+            });
+        }
+
+        raster_stats_t getRasterStats(rasterizer_t *rasterizer) { return rasterizer->stats; }
+
+        // NOTE: the sprite batch bins into the tiles of the rasterizer, and draws each tile in the order that the
+        // commands were sorted to.
+        struct sprite_command_t {
+            int32_t               minX, minY, maxX, maxY;  // the pixels drawn, clipped to the target. max is exclusive.
+            const loaded_image_t *image;
+            int32_t               u, v;    // 16.16 texels at the center of the pixel (minX, minY), v from the top.
+            int32_t               du, dv;  // 16.16 texels per pixel.
+            uint32_t              color;   // the premultiplied tint, 0xABGR as the image is. for a rect, 0xARGB.
+            float                 depth;
+        };
+
+        struct sprite_batch_t {
+            backbuffer_t                       target;
+            uint32_t                           tilesX;
+            uint32_t                           tilesY;
+            std::vector<sprite_command_t>      commands;
+            std::vector<std::vector<uint32_t>> bins;  // command indices per tile.
+        };
+
+        sprite_batch_t *createSpriteBatch() { return new sprite_batch_t(); }
+
+        void destroySpriteBatch(sprite_batch_t *batch) { delete batch; }
+
+        bool beginSprites(sprite_batch_t *batch, const backbuffer_t &target)
+        {
+            if (!target.memory || !target.width || !target.height || target.width > RASTER_MAX_SIZE ||
+                target.height > RASTER_MAX_SIZE || target.bytesPerPixel != sizeof(uint32_t)) {
+                AELoggerError("unable to draw sprites to a %ux%u target with %u bytes per pixel",
+                    target.width, target.height, target.bytesPerPixel);
+                return false;
+            }
+            batch->target = target;
+            batch->tilesX = (target.width + RASTER_TILE_SIZE - 1) >> RASTER_TILE_SHIFT;
+            batch->tilesY = (target.height + RASTER_TILE_SIZE - 1) >> RASTER_TILE_SHIFT;
+            batch->commands.clear();
+            batch->bins.resize(size_t(batch->tilesX) * batch->tilesY);
+            for (auto &bin : batch->bins) bin.clear();
+            return true;
+        }
+
+        void pushQuad(sprite_batch_t *batch, const sprite_quad_t &quad)
+        {
+            if (!(quad.width > 0.f) || !(quad.height > 0.f) || !(quad.tint >> 24)) return;
+            if (quad.image && (!quad.image->pixelPointer || !quad.image->width || !quad.image->height)) return;
+
+            // the pixels whose centers are within the rectangle, clipped to the target.
+            sprite_command_t command = {};
+            command.minX = math::max(0, int32_t(ceilf(quad.x - 0.5f)));
+            command.minY = math::max(0, int32_t(ceilf(quad.y - 0.5f)));
+            command.maxX = int32_t(math::min(ceilf(quad.x + quad.width - 0.5f), float(batch->target.width)));
+            command.maxY = int32_t(math::min(ceilf(quad.y + quad.height - 0.5f), float(batch->target.height)));
+            if (command.minX >= command.maxX || command.minY >= command.maxY) return;
+
+            command.image = quad.image;
+            command.depth = quad.depth;
+            uint32_t tint = quad.tint, alpha = tint >> 24;
+            for (uint32_t shift = 0; shift < 24; shift += 8)
+                tint = (tint & ~(0xFFu << shift)) | ((((tint >> shift) & 0xFF) * alpha + 127) / 255 << shift);
+            if (quad.image) {
+                double texelsX = double(quad.u1 - quad.u0) * quad.image->width;
+                double texelsY = double(quad.v1 - quad.v0) * quad.image->height;
+                double u       = double(quad.u0) * quad.image->width +
+                           (command.minX + 0.5 - quad.x) / quad.width * texelsX;
+                double v = double(quad.v0) * quad.image->height +
+                           (command.minY + 0.5 - quad.y) / quad.height * texelsY;
+                command.u     = int32_t(floor(u * 65536.0));
+                command.v     = int32_t(floor(v * 65536.0));
+                command.du    = int32_t(floor(texelsX / quad.width * 65536.0 + 0.5));
+                command.dv    = int32_t(floor(texelsY / quad.height * 65536.0 + 0.5));
+                command.color = SwizzleRB(tint);
+            } else {
+                command.color = tint;
+            }
+            batch->commands.push_back(command);
+        }
+
+        void pushSprite(
+            sprite_batch_t *batch, const loaded_image_t &image, float x, float y, uint32_t tint, float depth)
+        {
+            sprite_quad_t quad = {};
+            quad.image         = &image;
+            quad.x             = x;
+            quad.y             = y;
+            quad.width         = float(image.width);
+            quad.height        = float(image.height);
+            quad.tint          = tint;
+            quad.depth         = depth;
+            pushQuad(batch, quad);
+        }
+
+        void pushRect(sprite_batch_t *batch, float x, float y, float width, float height, uint32_t color, float depth)
+        {
+            sprite_quad_t quad = {};
+            quad.x             = x;
+            quad.y             = y;
+            quad.width         = width;
+            quad.height        = height;
+            quad.tint          = color;
+            quad.depth         = depth;
+            pushQuad(batch, quad);
+        }
+
+        static void DrawSpriteTile(sprite_batch_t *batch, uint32_t tileIndex)
+        {
+            const backbuffer_t &target = batch->target;
+            const int32_t       tileX0 = int32_t(tileIndex % batch->tilesX) << RASTER_TILE_SHIFT;
+            const int32_t       tileY0 = int32_t(tileIndex / batch->tilesX) << RASTER_TILE_SHIFT;
+            const int32_t       tileX1 = math::min(tileX0 + RASTER_TILE_SIZE, int32_t(target.width));
+            const int32_t       tileY1 = math::min(tileY0 + RASTER_TILE_SIZE, int32_t(target.height));
+            alignas(16) uint32_t span[RASTER_TILE_SIZE];
+
+            for (uint32_t index : batch->bins[tileIndex]) {
+                const sprite_command_t &command = batch->commands[index];
+                const int32_t           x0      = math::max(command.minX, tileX0);
+                const int32_t           x1      = math::min(command.maxX, tileX1);
+                const int32_t           y0      = math::max(command.minY, tileY0);
+                const int32_t           y1      = math::min(command.maxY, tileY1);
+                const uint32_t          count   = uint32_t(x1 - x0);
+                uint8_t                *dstRow  = (uint8_t *)target.memory + size_t(y0) * target.pitch;
+
+                if (!command.image) {
+                    for (uint32_t i = 0; i < count; i++) span[i] = command.color;
+                    for (int32_t y = y0; y < y1; y++, dstRow += target.pitch)
+                        BlendSpan<false>((uint32_t *)dstRow + x0, span, count);
+                    continue;
+                }
+
+                const loaded_image_t &image = *command.image;
+                const int32_t         maxU  = int32_t(image.width) - 1;
+                const int32_t         maxV  = int32_t(image.height) - 1;
+                const int32_t         u0    = command.u + (x0 - command.minX) * command.du;
+                const int32_t         first = u0 >> 16;
+                const int32_t         last  = (u0 + int32_t(count - 1) * command.du) >> 16;
+                const bool            bInside = math::min(first, last) >= 0 && math::max(first, last) <= maxU;
+                // NOTE: a sprite drawn 1:1 without a tint blends straight from its rows.
+                const bool bCopy = command.du == 65536 && command.color == 0xFFFFFFFF && bInside;
+                const __m128i tint = _mm_set1_epi32(int32_t(command.color));
+                for (int32_t y = y0; y < y1; y++, dstRow += target.pitch) {
+                    int32_t v = int32_t((command.v + int64_t(y - command.minY) * command.dv) >> 16);
+                    v         = math::min(math::max(v, 0), maxV);
+                    // NOTE: the image rows are bottom first.
+                    const uint32_t *src = image.pixelPointer + size_t(maxV - v) * image.width;
+                    if (bCopy) {
+                        BlendSpan<true>((uint32_t *)dstRow + x0, src + first, count);
+                        continue;
+                    }
+                    int32_t u = u0;
+                    if (bInside) {
+                        for (uint32_t i = 0; i < count; i++, u += command.du) span[i] = src[u >> 16];
+                    } else {
+                        for (uint32_t i = 0; i < count; i++, u += command.du)
+                            span[i] = src[math::min(math::max(u >> 16, 0), maxU)];
+                    }
+                    if (command.color != 0xFFFFFFFF) {
+                        for (uint32_t i = 0; i < count; i += 4) {
+                            __m128i *p = (__m128i *)(span + i);
+                            _mm_store_si128(p, MulColors(_mm_load_si128(p), tint));
+                        }
+                    }
+                    BlendSpan<true>((uint32_t *)dstRow + x0, span, count);
+                }
+            }
+        }
+
+        void endSprites(sprite_batch_t *batch)
+        {
+            // back to front, and in the order pushed at the same depth.
+            std::stable_sort(batch->commands.begin(), batch->commands.end(),
+                [](const sprite_command_t &a, const sprite_command_t &b) { return a.depth > b.depth; });
+            for (uint32_t i = 0; i < uint32_t(batch->commands.size()); i++) {
+                const sprite_command_t &command = batch->commands[i];
+                const int32_t           maxTX   = (command.maxX - 1) >> RASTER_TILE_SHIFT;
+                const int32_t           maxTY   = (command.maxY - 1) >> RASTER_TILE_SHIFT;
+                markDirty(&batch->target, command.minX, command.minY, command.maxX - command.minX,
+                    command.maxY - command.minY);
+                for (int32_t ty = command.minY >> RASTER_TILE_SHIFT; ty <= maxTY; ty++) {
+                    for (int32_t tx = command.minX >> RASTER_TILE_SHIFT; tx <= maxTX; tx++)
+                        batch->bins[size_t(ty) * batch->tilesX + tx].push_back(i);
+                }
+            }
+            uint32_t tileCount = batch->tilesX * batch->tilesY;
+            jobs::parallelFor(tileCount, 1, [batch](uint32_t begin, uint32_t end) {
+                for (uint32_t tile = begin; tile < end; tile++) DrawSpriteTile(batch, tile);
+            });
+        }
+
+        // NOTE: the path tracer keeps its scene as world space triangles in the order of the leaves of a BVH. the BVH
+        // is built with binned SAH the first time that the scene is rendered after it changed. the primary rays are
+        // traced in packets of 2x2 pixels, four rays to an SSE register. the bounces after them are less coherent and
+        // are traced one at a time.
+        static constexpr uint32_t PATH_TILE_SIZE     = 16;
+        static constexpr uint32_t PATH_BVH_BINS      = 12;
+        static constexpr uint32_t PATH_BVH_LEAF_SIZE = 4;
+        static constexpr uint32_t PATH_BVH_MAX_LEAF  = 16;  // the most triangles in a leaf when no split is useful.
+        static constexpr uint32_t PATH_BVH_MAX_DEPTH = 60;
+        static constexpr uint32_t PATH_STACK_SIZE    = PATH_BVH_MAX_DEPTH + 4;
+        static constexpr uint32_t PATH_RR_BOUNCE     = 3;  // russian roulette starts after this many bounces.
+        static constexpr uint32_t PATH_SRGB_LUT_SIZE = 4096;
+        static constexpr float    PATH_RAY_EPSILON   = 1e-4f;
+        static constexpr float    PATH_TWO_PI        = 6.28318530718f;
+
+        // NOTE: the vec3_t operators of math are defined in another translation unit. these are inlined into the inner
+        // loops of the tracer.
+        static inline math::vec3_t Add3(const math::vec3_t &a, const math::vec3_t &b)
+        {
+            return math::vec3_t(a.x + b.x, a.y + b.y, a.z + b.z);
+        }
+        static inline math::vec3_t Sub3(const math::vec3_t &a, const math::vec3_t &b)
+        {
+            return math::vec3_t(a.x - b.x, a.y - b.y, a.z - b.z);
+        }
+        static inline math::vec3_t Mul3(const math::vec3_t &a, const math::vec3_t &b)
+        {
+            return math::vec3_t(a.x * b.x, a.y * b.y, a.z * b.z);
+        }
+        static inline math::vec3_t Scale3(const math::vec3_t &a, float s)
+        {
+            return math::vec3_t(a.x * s, a.y * s, a.z * s);
+        }
+        static inline float Dot3(const math::vec3_t &a, const math::vec3_t &b)
+        {
+            return a.x * b.x + a.y * b.y + a.z * b.z;
+        }
+        static inline math::vec3_t Cross3(const math::vec3_t &a, const math::vec3_t &b)
+        {
+            return math::vec3_t(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+        }
+        static inline math::vec3_t Normalize3(const math::vec3_t &a)
+        {
+            float lengthSq = Dot3(a, a);
+            return (lengthSq > 0.f) ? Scale3(a, 1.f / sqrtf(lengthSq)) : a;
+        }
+
+        // the edges of a triangle, for Möller-Trumbore.
+        struct path_triangle_t {
+            math::vec3_t v0, e1, e2;
+        };
+
+        struct path_shading_t {
+            math::vec3_t normals[3];
+            float        uvs[3][2];
+            math::vec3_t faceNormal;
+            uint32_t     material;
+        };
+
+        // an interior node has count == 0, with its left child right after it and its right child at first.
+        struct bvh_node_t {
+            float    min[3];
+            uint32_t first;
+            float    max[3];
+            uint16_t count;
+            uint16_t axis;
+        };
+
+        struct path_hit_t {
+            float    t;
+            float    u, v;
+            uint32_t triangle;
+        };
+
+        struct path_rng_t {
+            uint64_t state;
+        };
+
+        struct path_tracer_t {
+            std::vector<path_triangle_t> triangles;
+            std::vector<path_shading_t>  shading;
+            std::vector<path_material_t> materials;
+            std::vector<bvh_node_t>      nodes;
+            bool                         bSceneChanged;
+            float                        epsilon;  // the offset of a bounce from its surface, for the scene scale.
+
+            std::vector<math::vec3_t> accumulation;  // the sum of the samples of each pixel.
+            uint32_t                  width;
+            uint32_t                  height;
+            uint32_t                  samples;  // the samples accumulated per pixel.
+            uint32_t                  frame;
+            math::camera_t            camera;
+            path_settings_t           settings;
+
+            std::atomic<uint64_t> rays;
+            path_stats_t          stats;
+            uint8_t               srgb[PATH_SRGB_LUT_SIZE];
+        };
+
+        // PCG32. each tile of each frame has its own stream, so the image does not depend on which thread ran it.
+        static inline uint32_t NextRandom(path_rng_t *rng)
+        {
+            uint64_t old = rng->state;
+            rng->state   = old * 6364136223846793005ULL + 1442695040888963407ULL;
+            uint32_t xorshifted = uint32_t(((old >> 18u) ^ old) >> 27u);
+            uint32_t rot        = uint32_t(old >> 59u);
+            return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+        }
+
+        static inline float NextFloat(path_rng_t *rng) { return float(NextRandom(rng) >> 8) * (1.f / 16777216.f); }
+
+        static path_rng_t SeedRandom(uint64_t a, uint64_t b)
+        {
+            // splitmix64 of the pair, so that neighbouring seeds start far apart.
+            uint64_t z = a * 0x9E3779B97F4A7C15ULL + b + 0x632BE59BD9B4E019ULL;
+            z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z          = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            path_rng_t rng = {z ^ (z >> 31)};
+            NextRandom(&rng);
+            return rng;
+        }
+
+        path_tracer_t *createPathTracer()
+        {
+            path_tracer_t *tracer = new path_tracer_t();
+            for (uint32_t i = 0; i < PATH_SRGB_LUT_SIZE; i++) {
+                float c = (i + 0.5f) / PATH_SRGB_LUT_SIZE;
+                c       = (c <= 0.0031308f) ? c * 12.92f : 1.055f * powf(c, 1.f / 2.4f) - 0.055f;
+                tracer->srgb[i] = uint8_t(math::min(c * 255.f + 0.5f, 255.f));
+            }
+            return tracer;
+        }
+
+        void destroyPathTracer(path_tracer_t *tracer) { delete tracer; }
+
+        void addPathModel(path_tracer_t *tracer,
+            const raw_model_t           &model,
+            const math::mat4_t          &modelMat,
+            const path_material_t       &material)
+        {
+            const uint32_t vertexCount = StretchyBufferCount(model.vertexData) / RASTER_VERTEX_STRIDE;
+            const uint32_t indexCount  = StretchyBufferCount(model.indexData);
+            const uint32_t materialIndex = uint32_t(tracer->materials.size());
+            tracer->materials.push_back(material);
+            if (material.texture && !material.texture->pixelPointer) tracer->materials.back().texture = nullptr;
+
+            std::vector<math::vec3_t> positions(vertexCount), normals(vertexCount);
+            for (uint32_t i = 0; i < vertexCount; i++) {
+                const float *src = model.vertexData + i * RASTER_VERTEX_STRIDE;
+                positions[i]     = math::vec3_t(modelMat * math::vec4_t(src[0], src[1], src[2], 1.f));
+                normals[i]       = Normalize3(math::vec3_t(modelMat * math::vec4_t(src[5], src[6], src[7], 0.f)));
+            }
+            for (uint32_t t = 0; t + 2 < indexCount; t += 3) {
+                const uint32_t *index = model.indexData + t;
+                if (index[0] >= vertexCount || index[1] >= vertexCount || index[2] >= vertexCount) continue;
+                path_triangle_t triangle;
+                triangle.v0 = positions[index[0]];
+                triangle.e1 = Sub3(positions[index[1]], triangle.v0);
+                triangle.e2 = Sub3(positions[index[2]], triangle.v0);
+                math::vec3_t faceNormal = Cross3(triangle.e1, triangle.e2);
+                if (Dot3(faceNormal, faceNormal) == 0.f) continue;
+
+                path_shading_t shading;
+                shading.faceNormal = Normalize3(faceNormal);
+                shading.material   = materialIndex;
+                for (uint32_t k = 0; k < 3; k++) {
+                    const float *src = model.vertexData + index[k] * RASTER_VERTEX_STRIDE;
+                    // NOTE: a model without normals is shaded flat.
+                    shading.normals[k] = (Dot3(normals[index[k]], normals[index[k]]) > 0.5f) ? normals[index[k]]
+                                                                                              : shading.faceNormal;
+                    shading.uvs[k][0]  = src[3];
+                    shading.uvs[k][1]  = src[4];
+                }
+                tracer->triangles.push_back(triangle);
+                tracer->shading.push_back(shading);
+            }
+            tracer->bSceneChanged = true;
+        }
+
+        void clearPathScene(path_tracer_t *tracer)
+        {
+            tracer->triangles.clear();
+            tracer->shading.clear();
+            tracer->materials.clear();
+            tracer->nodes.clear();
+            tracer->bSceneChanged = true;
+        }
+
+        void resetPathAccumulation(path_tracer_t *tracer) { tracer->samples = 0; }
+
+        struct bvh_bounds_t {
+            float min[3], max[3];
+
+            void reset()
+            {
+                for (uint32_t k = 0; k < 3; k++) {
+                    min[k] = FLT_MAX;
+                    max[k] = -FLT_MAX;
+                }
+            }
+            void grow(const float *p)
+            {
+                for (uint32_t k = 0; k < 3; k++) {
+                    min[k] = math::min(min[k], p[k]);
+                    max[k] = math::max(max[k], p[k]);
+                }
+            }
+            void grow(const bvh_bounds_t &b)
+            {
+                if (b.min[0] > b.max[0]) return;  // empty.
+                grow(b.min);
+                grow(b.max);
+            }
+            float area() const
+            {
+                float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+                return (dx < 0.f) ? 0.f : dx * dy + dy * dz + dz * dx;
+            }
+        };
+
+        struct bvh_ref_t {
+            bvh_bounds_t bounds;
+            float        centroid[3];
+            uint32_t     index;
+        };
+
+        static void BuildNode(std::vector<bvh_node_t> &nodes, bvh_ref_t *refs, uint32_t begin, uint32_t end,
+            uint32_t depth)
+        {
+            uint32_t nodeIndex = uint32_t(nodes.size());
+            nodes.push_back({});
+            bvh_bounds_t bounds, centroids;
+            bounds.reset();
+            centroids.reset();
+            for (uint32_t i = begin; i < end; i++) {
+                bounds.grow(refs[i].bounds);
+                centroids.grow(refs[i].centroid);
+            }
+            const uint32_t count = end - begin;
+            auto leaf = [&]() {
+                bvh_node_t &node = nodes[nodeIndex];
+                for (uint32_t k = 0; k < 3; k++) {
+                    node.min[k] = bounds.min[k];
+                    node.max[k] = bounds.max[k];
+                }
+                node.first = begin;
+                node.count = uint16_t(count);
+            };
+            if (count <= PATH_BVH_LEAF_SIZE || depth >= PATH_BVH_MAX_DEPTH) return leaf();
+
+            // the cheapest split of the bins along each axis, by the surface area heuristic.
+            float    bestCost  = FLT_MAX;
+            uint32_t bestAxis  = 0;
+            uint32_t bestSplit = 0;
+            for (uint32_t axis = 0; axis < 3; axis++) {
+                float extent = centroids.max[axis] - centroids.min[axis];
+                if (extent <= 0.f) continue;
+                bvh_bounds_t binBounds[PATH_BVH_BINS];
+                uint32_t     binCounts[PATH_BVH_BINS] = {};
+                for (uint32_t b = 0; b < PATH_BVH_BINS; b++) binBounds[b].reset();
+                float scale = PATH_BVH_BINS / extent;
+                for (uint32_t i = begin; i < end; i++) {
+                    uint32_t b = math::min(uint32_t((refs[i].centroid[axis] - centroids.min[axis]) * scale),
+                        PATH_BVH_BINS - 1);
+                    binCounts[b]++;
+                    binBounds[b].grow(refs[i].bounds);
+                }
+                float        rightCost[PATH_BVH_BINS];
+                bvh_bounds_t right;
+                right.reset();
+                uint32_t rightCount = 0;
+                for (uint32_t b = PATH_BVH_BINS - 1; b > 0; b--) {
+                    right.grow(binBounds[b]);
+                    rightCount += binCounts[b];
+                    rightCost[b] = rightCount ? right.area() * rightCount : 0.f;
+                }
+                bvh_bounds_t left;
+                left.reset();
+                uint32_t leftCount = 0;
+                for (uint32_t b = 0; b + 1 < PATH_BVH_BINS; b++) {
+                    left.grow(binBounds[b]);
+                    leftCount += binCounts[b];
+                    if (!leftCount || leftCount == count) continue;
+                    float cost = left.area() * leftCount + rightCost[b + 1];
+                    if (cost < bestCost) {
+                        bestCost  = cost;
+                        bestAxis  = axis;
+                        bestSplit = b + 1;
+                    }
+                }
+            }
+
+            uint32_t middle;
+            if (bestCost == FLT_MAX) {
+                // NOTE: every centroid is the same, so no split of the bins helps. the triangles are halved by index.
+                if (count <= PATH_BVH_MAX_LEAF) return leaf();
+                middle = begin + count / 2;
+            } else {
+                if (count <= PATH_BVH_MAX_LEAF && bestCost >= bounds.area() * count) return leaf();
+                float scale = PATH_BVH_BINS / (centroids.max[bestAxis] - centroids.min[bestAxis]);
+                bvh_ref_t *split = std::partition(refs + begin, refs + end, [&](const bvh_ref_t &ref) {
+                    uint32_t b = math::min(uint32_t((ref.centroid[bestAxis] - centroids.min[bestAxis]) * scale),
+                        PATH_BVH_BINS - 1);
+                    return b < bestSplit;
+                });
+                middle = uint32_t(split - refs);
+            }
+
+            BuildNode(nodes, refs, begin, middle, depth + 1);
+            uint32_t right = uint32_t(nodes.size());
+            BuildNode(nodes, refs, middle, end, depth + 1);
+            bvh_node_t &node = nodes[nodeIndex];
+            for (uint32_t k = 0; k < 3; k++) {
+                node.min[k] = bounds.min[k];
+                node.max[k] = bounds.max[k];
+            }
+            node.first = right;
+            node.count = 0;
+            node.axis  = uint16_t(bestCost == FLT_MAX ? 0 : bestAxis);
+        }
+
+        static void BuildPathScene(path_tracer_t *tracer)
+        {
+            const uint32_t         count = uint32_t(tracer->triangles.size());
+            std::vector<bvh_ref_t> refs(count);
+            float                  extent = 0.f;
+            for (uint32_t i = 0; i < count; i++) {
+                const path_triangle_t &tri = tracer->triangles[i];
+                math::vec3_t           v[3] = {tri.v0, Add3(tri.v0, tri.e1), Add3(tri.v0, tri.e2)};
+                refs[i].bounds.reset();
+                for (uint32_t k = 0; k < 3; k++) {
+                    refs[i].bounds.grow(&v[k].x);
+                    extent = math::max(extent, math::max(fabsf(v[k].x), math::max(fabsf(v[k].y), fabsf(v[k].z))));
+                }
+                for (uint32_t k = 0; k < 3; k++)
+                    refs[i].centroid[k] = (refs[i].bounds.min[k] + refs[i].bounds.max[k]) * 0.5f;
+                refs[i].index = i;
+            }
+            tracer->nodes.clear();
+            tracer->nodes.reserve(count ? 2 * count : 1);
+            if (count) BuildNode(tracer->nodes, refs.data(), 0, count, 0);
+
+            // the triangles are put in the order of the leaves.
+            std::vector<path_triangle_t> triangles(count);
+            std::vector<path_shading_t>  shading(count);
+            for (uint32_t i = 0; i < count; i++) {
+                triangles[i] = tracer->triangles[refs[i].index];
+                shading[i]   = tracer->shading[refs[i].index];
+            }
+            tracer->triangles.swap(triangles);
+            tracer->shading.swap(shading);
+            tracer->epsilon       = PATH_RAY_EPSILON * math::max(extent, 1.f);
+            tracer->bSceneChanged = false;
+            tracer->samples       = 0;
+        }
+
+        // the reciprocal of a direction, where a zero component is nudged so that the slab tests never see 0 * inf.
+        static inline float SafeReciprocal(float d)
+        {
+            return 1.f / ((fabsf(d) > 1e-20f) ? d : (d < 0.f ? -1e-20f : 1e-20f));
+        }
+
+        static bool IntersectScene(const path_tracer_t *tracer,
+            const math::vec3_t                         &origin,
+            const math::vec3_t                         &dir,
+            float                                       tMax,
+            path_hit_t                                 *hit,
+            bool                                        bAnyHit)
+        {
+            if (tracer->nodes.empty()) return false;
+            const float       inv[3] = {SafeReciprocal(dir.x), SafeReciprocal(dir.y), SafeReciprocal(dir.z)};
+            const float       o[3]   = {origin.x, origin.y, origin.z};
+            const bvh_node_t *nodes  = tracer->nodes.data();
+            auto              enterBox = [&](const bvh_node_t &node) {
+                float tEnter = 0.f, tExit = tMax;
+                for (uint32_t k = 0; k < 3; k++) {
+                    float t0 = (node.min[k] - o[k]) * inv[k];
+                    float t1 = (node.max[k] - o[k]) * inv[k];
+                    tEnter   = math::max(tEnter, math::min(t0, t1));
+                    tExit    = math::min(tExit, math::max(t0, t1));
+                }
+                return (tEnter <= tExit) ? tEnter : FLT_MAX;
+            };
+
+            bool     bHit = false;
+            uint32_t stack[PATH_STACK_SIZE];
+            uint32_t stackSize = 0;
+            if (enterBox(nodes[0]) == FLT_MAX) return false;
+            stack[stackSize++] = 0;
+            while (stackSize) {
+                const bvh_node_t &node = nodes[stack[--stackSize]];
+                if (node.count) {
+                    for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                        const path_triangle_t &tri  = tracer->triangles[i];
+                        math::vec3_t           pvec = Cross3(dir, tri.e2);
+                        float                  det  = Dot3(tri.e1, pvec);
+                        if (fabsf(det) < 1e-12f) continue;
+                        float        invDet = 1.f / det;
+                        math::vec3_t tvec   = Sub3(origin, tri.v0);
+                        float        u      = Dot3(tvec, pvec) * invDet;
+                        if (u < 0.f || u > 1.f) continue;
+                        math::vec3_t qvec = Cross3(tvec, tri.e1);
+                        float        v    = Dot3(dir, qvec) * invDet;
+                        if (v < 0.f || u + v > 1.f) continue;
+                        float t = Dot3(tri.e2, qvec) * invDet;
+                        if (t <= 0.f || t >= tMax) continue;
+                        tMax = t;
+                        bHit = true;
+                        if (bAnyHit) return true;
+                        *hit = {t, u, v, i};
+                    }
+                    continue;
+                }
+                // visit the nearer child first, and skip a child that is farther than the closest hit.
+                uint32_t left = uint32_t(&node - nodes) + 1, right = node.first;
+                float    tLeft = enterBox(nodes[left]), tRight = enterBox(nodes[right]);
+                if (tLeft > tRight) {
+                    std::swap(left, right);
+                    std::swap(tLeft, tRight);
+                }
+                if (tRight != FLT_MAX) stack[stackSize++] = right;
+                if (tLeft != FLT_MAX) stack[stackSize++] = left;
+            }
+            return bHit;
+        }
+
+        // 4 rays in SSE registers.
+        struct path_packet_t {
+            __m128 ox, oy, oz;
+            __m128 dx, dy, dz;
+            __m128 ix, iy, iz;
+        };
+
+        static inline __m128 Select4(__m128 mask, __m128 a, __m128 b)
+        {
+            return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+        }
+
+        // the closest hits of 4 rays. a lane that misses keeps t at FLT_MAX.
+        static void IntersectPacket(
+            const path_tracer_t *tracer, const path_packet_t &ray, __m128 *hitT, __m128 *hitU, __m128 *hitV,
+            __m128i *hitTriangle)
+        {
+            *hitT        = _mm_set1_ps(FLT_MAX);
+            *hitU        = _mm_setzero_ps();
+            *hitV        = _mm_setzero_ps();
+            *hitTriangle = _mm_set1_epi32(-1);
+            if (tracer->nodes.empty()) return;
+
+            const bvh_node_t *nodes = tracer->nodes.data();
+            const __m128      zero  = _mm_setzero_ps();
+            const __m128      one   = _mm_set1_ps(1.f);
+            // the lane 0 direction picks the child that is visited first.
+            float firstDir[3] = {_mm_cvtss_f32(ray.dx), _mm_cvtss_f32(ray.dy), _mm_cvtss_f32(ray.dz)};
+
+            uint32_t stack[PATH_STACK_SIZE];
+            uint32_t stackSize  = 0;
+            stack[stackSize++] = 0;
+            while (stackSize) {
+                const uint32_t    nodeIndex = stack[--stackSize];
+                const bvh_node_t &node      = nodes[nodeIndex];
+                __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min[0]), ray.ox), ray.ix);
+                __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max[0]), ray.ox), ray.ix);
+                __m128 tEnter = _mm_max_ps(zero, _mm_min_ps(t0, t1));
+                __m128 tExit  = _mm_min_ps(*hitT, _mm_max_ps(t0, t1));
+                t0            = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min[1]), ray.oy), ray.iy);
+                t1            = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max[1]), ray.oy), ray.iy);
+                tEnter        = _mm_max_ps(tEnter, _mm_min_ps(t0, t1));
+                tExit         = _mm_min_ps(tExit, _mm_max_ps(t0, t1));
+                t0            = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min[2]), ray.oz), ray.iz);
+                t1            = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max[2]), ray.oz), ray.iz);
+                tEnter        = _mm_max_ps(tEnter, _mm_min_ps(t0, t1));
+                tExit         = _mm_min_ps(tExit, _mm_max_ps(t0, t1));
+                if (!_mm_movemask_ps(_mm_cmple_ps(tEnter, tExit))) continue;
+
+                if (!node.count) {
+                    uint32_t left = nodeIndex + 1, right = node.first;
+                    if (firstDir[node.axis] < 0.f) std::swap(left, right);
+                    stack[stackSize++] = right;
+                    stack[stackSize++] = left;
+                    continue;
+                }
+                for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                    const path_triangle_t &tri = tracer->triangles[i];
+                    const __m128 e1x = _mm_set1_ps(tri.e1.x), e1y = _mm_set1_ps(tri.e1.y), e1z = _mm_set1_ps(tri.e1.z);
+                    const __m128 e2x = _mm_set1_ps(tri.e2.x), e2y = _mm_set1_ps(tri.e2.y), e2z = _mm_set1_ps(tri.e2.z);
+                    // pvec = d x e2, det = e1 . pvec.
+                    __m128 px  = _mm_sub_ps(_mm_mul_ps(ray.dy, e2z), _mm_mul_ps(ray.dz, e2y));
+                    __m128 py  = _mm_sub_ps(_mm_mul_ps(ray.dz, e2x), _mm_mul_ps(ray.dx, e2z));
+                    __m128 pz  = _mm_sub_ps(_mm_mul_ps(ray.dx, e2y), _mm_mul_ps(ray.dy, e2x));
+                    __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+                    __m128 invDet = _mm_div_ps(one, det);
+                    // tvec = o - v0, u = tvec . pvec / det.
+                    __m128 tx = _mm_sub_ps(ray.ox, _mm_set1_ps(tri.v0.x));
+                    __m128 ty = _mm_sub_ps(ray.oy, _mm_set1_ps(tri.v0.y));
+                    __m128 tz = _mm_sub_ps(ray.oz, _mm_set1_ps(tri.v0.z));
+                    __m128 u  = _mm_mul_ps(
+                        _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), invDet);
+                    // qvec = tvec x e1, v = d . qvec / det, t = e2 . qvec / det.
+                    __m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+                    __m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+                    __m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+                    __m128 v  = _mm_mul_ps(
+                        _mm_add_ps(_mm_add_ps(_mm_mul_ps(ray.dx, qx), _mm_mul_ps(ray.dy, qy)), _mm_mul_ps(ray.dz, qz)),
+                        invDet);
+                    __m128 t = _mm_mul_ps(
+                        _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+                    // NOTE: a det of 0 makes u, v and t inf or NaN, which fail the compares.
+                    __m128 mask = _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero));
+                    mask        = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), one));
+                    mask        = _mm_and_ps(mask, _mm_and_ps(_mm_cmpgt_ps(t, zero), _mm_cmplt_ps(t, *hitT)));
+                    if (!_mm_movemask_ps(mask)) continue;
+                    *hitT        = Select4(mask, t, *hitT);
+                    *hitU        = Select4(mask, u, *hitU);
+                    *hitV        = Select4(mask, v, *hitV);
+                    *hitTriangle = _mm_castps_si128(
+                        Select4(mask, _mm_castsi128_ps(_mm_set1_epi32(int32_t(i))), _mm_castsi128_ps(*hitTriangle)));
+                }
+            }
+        }
+
+        // a direction about n, with a density of cos(theta) / pi.
+        static math::vec3_t SampleCosine(const math::vec3_t &n, path_rng_t *rng)
+        {
+            float r   = sqrtf(NextFloat(rng));
+            float phi = PATH_TWO_PI * NextFloat(rng);
+            float x = r * cosf(phi), y = r * sinf(phi), z = sqrtf(math::max(0.f, 1.f - r * r));
+            // an orthonormal basis about n, from "Building an Orthonormal Basis, Revisited" by Duff et al.
+            float        sign = copysignf(1.f, n.z);
+            float        a    = -1.f / (sign + n.z);
+            float        b    = n.x * n.y * a;
+            math::vec3_t t    = math::vec3_t(1.f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+            math::vec3_t s    = math::vec3_t(b, sign + n.y * n.y * a, -n.y);
+            return Add3(Add3(Scale3(t, x), Scale3(s, y)), Scale3(n, z));
+        }
+
+        // the light that arrives along a path whose first hit is known. hit.t == FLT_MAX is a miss.
+        static math::vec3_t TracePath(const path_tracer_t *tracer,
+            const path_settings_t                         &settings,
+            math::vec3_t                                   origin,
+            math::vec3_t                                   dir,
+            path_hit_t                                     hit,
+            path_rng_t                                    *rng,
+            uint64_t                                      *rays)
+        {
+            math::vec3_t radiance   = math::vec3_t(0.f, 0.f, 0.f);
+            math::vec3_t throughput = math::vec3_t(1.f, 1.f, 1.f);
+            const bool   bSun       = Dot3(settings.sunColor, settings.sunColor) > 0.f;
+            for (uint32_t bounce = 0;; bounce++) {
+                if (hit.t == FLT_MAX) {
+                    radiance = Add3(radiance, Mul3(throughput, settings.skyColor));
+                    break;
+                }
+                const path_shading_t  &shading  = tracer->shading[hit.triangle];
+                const path_material_t &material = tracer->materials[shading.material];
+                radiance = Add3(radiance, Mul3(throughput, material.emission));
+                if (bounce >= settings.maxBounces) break;
+
+                float        w  = 1.f - hit.u - hit.v;
+                math::vec3_t ng = shading.faceNormal;
+                math::vec3_t n  = Add3(Scale3(shading.normals[0], w), Scale3(shading.normals[1], hit.u));
+                n               = Normalize3(Add3(n, Scale3(shading.normals[2], hit.v)));
+                // NOTE: the surfaces are two sided, so the normals face the ray.
+                if (Dot3(ng, dir) > 0.f) ng = Scale3(ng, -1.f);
+                if (Dot3(n, ng) < 0.f) n = Scale3(n, -1.f);
+
+                math::vec3_t albedo = material.albedo;
+                if (material.texture) {
+                    const loaded_image_t &texture = *material.texture;
+                    float u = shading.uvs[0][0] * w + shading.uvs[1][0] * hit.u + shading.uvs[2][0] * hit.v;
+                    float v = shading.uvs[0][1] * w + shading.uvs[1][1] * hit.u + shading.uvs[2][1] * hit.v;
+                    uint32_t s = math::min(uint32_t((u - floorf(u)) * texture.width), texture.width - 1);
+                    uint32_t t = math::min(uint32_t((v - floorf(v)) * texture.height), texture.height - 1);
+                    uint32_t texel = texture.pixelPointer[t * texture.width + s];
+                    albedo         = Mul3(albedo, math::vec3_t(float(texel & 0xFF) * (1.f / 255.f),
+                                                     float((texel >> 8) & 0xFF) * (1.f / 255.f),
+                                                     float((texel >> 16) & 0xFF) * (1.f / 255.f)));
+                }
+
+                math::vec3_t position = Add3(origin, Scale3(dir, hit.t));
+                math::vec3_t surface  = Add3(position, Scale3(ng, tracer->epsilon));
+                if (material.reflectivity > 0.f && NextFloat(rng) < material.reflectivity) {
+                    dir = Sub3(dir, Scale3(n, 2.f * Dot3(dir, n)));
+                    // NOTE: a shading normal can mirror the ray into the surface.
+                    if (Dot3(dir, ng) <= 0.f) break;
+                } else {
+                    if (bSun) {
+                        float cosine = Dot3(n, settings.sunDirection);
+                        path_hit_t shadow;
+                        (*rays)++;
+                        if (cosine > 0.f && Dot3(ng, settings.sunDirection) > 0.f &&
+                            !IntersectScene(tracer, surface, settings.sunDirection, FLT_MAX, &shadow, true)) {
+                            math::vec3_t sun = Mul3(throughput, Mul3(albedo, settings.sunColor));
+                            radiance         = Add3(radiance, Scale3(sun, cosine));
+                        }
+                    }
+                    dir = SampleCosine(n, rng);
+                    if (Dot3(dir, ng) <= 0.f) break;
+                }
+                throughput = Mul3(throughput, albedo);
+
+                if (bounce >= PATH_RR_BOUNCE) {
+                    float survive = math::min(math::max(throughput.x, math::max(throughput.y, throughput.z)), 0.95f);
+                    if (NextFloat(rng) >= survive) break;
+                    throughput = Scale3(throughput, 1.f / survive);
+                }
+                origin = surface;
+                hit.t  = FLT_MAX;
+                (*rays)++;
+                IntersectScene(tracer, origin, dir, FLT_MAX, &hit, false);
+            }
+            return radiance;
+        }
+
+        static bool SamePathCamera(const math::camera_t &a, const math::camera_t &b)
+        {
+            return !memcmp(&a.trans, &b.trans, sizeof(a.trans)) && a.fov == b.fov && a.width == b.width &&
+                   a.height == b.height;
+        }
+
+        static bool SamePathSettings(const path_settings_t &a, const path_settings_t &b)
+        {
+            return a.maxBounces == b.maxBounces && !memcmp(&a.skyColor, &b.skyColor, sizeof(a.skyColor)) &&
+                   !memcmp(&a.sunDirection, &b.sunDirection, sizeof(a.sunDirection)) &&
+                   !memcmp(&a.sunColor, &b.sunColor, sizeof(a.sunColor));
+        }
+
+        static void RenderPathTile(path_tracer_t *tracer,
+            const path_settings_t               &settings,
+            uint32_t                             tileIndex,
+            const math::vec3_t                  *basis,
+            float                                tanX,
+            float                                tanY)
+        {
+            const uint32_t tilesX = (tracer->width + PATH_TILE_SIZE - 1) / PATH_TILE_SIZE;
+            const uint32_t x0     = (tileIndex % tilesX) * PATH_TILE_SIZE;
+            const uint32_t y0     = (tileIndex / tilesX) * PATH_TILE_SIZE;
+            const uint32_t x1     = math::min(x0 + PATH_TILE_SIZE, tracer->width);
+            const uint32_t y1     = math::min(y0 + PATH_TILE_SIZE, tracer->height);
+            path_rng_t     rng    = SeedRandom(tracer->frame, tileIndex);
+            uint64_t       rays   = 0;
+            const math::vec3_t origin = tracer->camera.trans.pos;
+            const float    invW   = 2.f / tracer->width, invH = 2.f / tracer->height;
+
+            for (uint32_t sample = 0; sample < settings.samplesPerPixel; sample++) {
+                for (uint32_t y = y0; y < y1; y += 2) {
+                    for (uint32_t x = x0; x < x1; x += 2) {
+                        // a packet of the 2x2 pixels at (x, y), each jittered within its pixel.
+                        alignas(16) float dx[4], dy[4], dz[4];
+                        for (uint32_t lane = 0; lane < 4; lane++) {
+                            float px = ((x + (lane & 1) + NextFloat(&rng)) * invW - 1.f) * tanX;
+                            float py = (1.f - (y + (lane >> 1) + NextFloat(&rng)) * invH) * tanY;
+                            math::vec3_t d = Normalize3(
+                                Sub3(Add3(Scale3(basis[0], px), Scale3(basis[1], py)), basis[2]));
+                            dx[lane] = d.x;
+                            dy[lane] = d.y;
+                            dz[lane] = d.z;
+                        }
+                        path_packet_t packet;
+                        packet.ox = _mm_set1_ps(origin.x);
+                        packet.oy = _mm_set1_ps(origin.y);
+                        packet.oz = _mm_set1_ps(origin.z);
+                        packet.dx = _mm_load_ps(dx);
+                        packet.dy = _mm_load_ps(dy);
+                        packet.dz = _mm_load_ps(dz);
+                        alignas(16) float inv[3][4];
+                        for (uint32_t lane = 0; lane < 4; lane++) {
+                            inv[0][lane] = SafeReciprocal(dx[lane]);
+                            inv[1][lane] = SafeReciprocal(dy[lane]);
+                            inv[2][lane] = SafeReciprocal(dz[lane]);
+                        }
+                        packet.ix = _mm_load_ps(inv[0]);
+                        packet.iy = _mm_load_ps(inv[1]);
+                        packet.iz = _mm_load_ps(inv[2]);
+                        __m128  hitT, hitU, hitV;
+                        __m128i hitTriangle;
+                        IntersectPacket(tracer, packet, &hitT, &hitU, &hitV, &hitTriangle);
+                        rays += 4;
+
+                        alignas(16) float    t[4], u[4], v[4];
+                        alignas(16) uint32_t triangle[4];
+                        _mm_store_ps(t, hitT);
+                        _mm_store_ps(u, hitU);
+                        _mm_store_ps(v, hitV);
+                        _mm_store_si128((__m128i *)triangle, hitTriangle);
+                        for (uint32_t lane = 0; lane < 4; lane++) {
+                            uint32_t px = x + (lane & 1), py = y + (lane >> 1);
+                            // NOTE: the lanes past the edge of an odd sized target are traced, but dropped.
+                            if (px >= x1 || py >= y1) continue;
+                            path_hit_t   hit      = {t[lane], u[lane], v[lane], triangle[lane]};
+                            math::vec3_t radiance = TracePath(tracer, settings, origin,
+                                math::vec3_t(dx[lane], dy[lane], dz[lane]), hit, &rng, &rays);
+                            math::vec3_t &sum = tracer->accumulation[size_t(py) * tracer->width + px];
+                            sum               = Add3(sum, radiance);
+                        }
+                    }
+                }
+            }
+            tracer->rays.fetch_add(rays, std::memory_order_relaxed);
+        }
+
+        bool renderPath(path_tracer_t *tracer,
+            backbuffer_t              *target,
+            const math::camera_t      &camera,
+            const path_settings_t     &settings)
+        {
+            if (!target->memory || !target->width || !target->height || target->bytesPerPixel != sizeof(uint32_t)) {
+                AELoggerError("unable to path trace to a %ux%u target with %u bytes per pixel",
+                    target->width, target->height, target->bytesPerPixel);
+                return false;
+            }
+            uint64_t frequency = EM->pfn.getTimerFrequency ? EM->pfn.getTimerFrequency() : 0;
+            uint64_t begin     = (EM->pfn.wallClock && frequency) ? EM->pfn.wallClock() : 0;
+
+            if (tracer->bSceneChanged) BuildPathScene(tracer);
+            if (tracer->width != target->width || tracer->height != target->height) {
+                tracer->width   = target->width;
+                tracer->height  = target->height;
+                tracer->samples = 0;
+            }
+            if (!SamePathCamera(camera, tracer->camera) || !SamePathSettings(settings, tracer->settings))
+                tracer->samples = 0;
+            tracer->camera   = camera;
+            tracer->settings = settings;
+            if (!tracer->samples)
+                tracer->accumulation.assign(size_t(tracer->width) * tracer->height, math::vec3_t(0.f, 0.f, 0.f));
+
+            // the camera axes are the rows of the rotation of the view matrix: right, up and back.
+            math::mat4_t view     = math::buildViewMat(camera);
+            math::vec3_t basis[3];
+            for (uint32_t k = 0; k < 3; k++)
+                basis[k] = Normalize3(math::vec3_t(view.mat[0][k], view.mat[1][k], view.mat[2][k]));
+            // NOTE: as in buildProjMat, the fov spans the width.
+            float tanX = tanf(camera.fov * DEGREES_TO_RADIANS / 2.f);
+            float tanY = tanX * float(tracer->height) / float(tracer->width);
+
+            path_settings_t frameSettings = settings;
+            frameSettings.samplesPerPixel = math::max(settings.samplesPerPixel, 1u);
+            frameSettings.sunDirection    = Normalize3(settings.sunDirection);
+            tracer->rays.store(0, std::memory_order_relaxed);
+            const uint32_t tilesX = (tracer->width + PATH_TILE_SIZE - 1) / PATH_TILE_SIZE;
+            const uint32_t tilesY = (tracer->height + PATH_TILE_SIZE - 1) / PATH_TILE_SIZE;
+            jobs::parallelFor(tilesX * tilesY, 1, [&](uint32_t first, uint32_t end) {
+                for (uint32_t tile = first; tile < end; tile++)
+                    RenderPathTile(tracer, frameSettings, tile, basis, tanX, tanY);
+            });
+            tracer->samples += frameSettings.samplesPerPixel;
+            tracer->frame++;
+
+            // resolve the average of the samples, exposed and sRGB encoded.
+            const float scale = settings.exposure * (PATH_SRGB_LUT_SIZE - 1) / tracer->samples;
+            jobs::parallelFor(tracer->height, 16, [&](uint32_t first, uint32_t end) {
+                for (uint32_t y = first; y < end; y++) {
+                    const math::vec3_t *src = tracer->accumulation.data() + size_t(y) * tracer->width;
+                    uint32_t           *dst = (uint32_t *)((uint8_t *)target->memory + size_t(y) * target->pitch);
+                    for (uint32_t x = 0; x < tracer->width; x++) {
+                        auto channel = [&](float c) {
+                            return uint32_t(tracer->srgb[uint32_t(math::min(math::max(c * scale, 0.f),
+                                float(PATH_SRGB_LUT_SIZE - 1)))]);
+                        };
+                        dst[x] = 0xFF000000 | (channel(src[x].x) << 16) | (channel(src[x].y) << 8) | channel(src[x].z);
+                    }
+                }
+            });
+            markDirty(target, 0, 0, int32_t(target->width), int32_t(target->height));
+
+            path_stats_t &stats      = tracer->stats;
+            stats.triangles          = uint32_t(tracer->triangles.size());
+            stats.bvhNodes           = uint32_t(tracer->nodes.size());
+            stats.accumulatedSamples = tracer->samples;
+            stats.samples            = uint64_t(tracer->width) * tracer->height * frameSettings.samplesPerPixel;
+            stats.rays               = tracer->rays.load(std::memory_order_relaxed);
+            stats.seconds            = begin ? float(EM->pfn.wallClock() - begin) / float(frequency) : 0.f;
+            stats.samplesPerSecond   = (stats.seconds > 0.f) ? float(stats.samples) / stats.seconds : 0.f;
+            stats.raysPerSecond      = (stats.seconds > 0.f) ? float(stats.rays) / stats.seconds : 0.f;
+            return true;
+        }
+
+        bool intersectPath(path_tracer_t *tracer, const math::vec3_t &origin, const math::vec3_t &dir, float *t)
+        {
+            if (tracer->bSceneChanged) BuildPathScene(tracer);
+            path_hit_t hit = {FLT_MAX, 0.f, 0.f, 0};
+            if (!IntersectScene(tracer, origin, dir, FLT_MAX, &hit, false)) return false;
+            *t = hit.t;
+            return true;
+        }
+
+        path_stats_t getPathStats(path_tracer_t *tracer) { return tracer->stats; }
     }  // namespace frender
 }  // namespace automata_engine
\ No newline at end of file
@@ -0,0 +1,807 @@
+#ifndef AUTOMATA_ENGINE_FRENDER_PLATFORM_H
+#define AUTOMATA_ENGINE_FRENDER_PLATFORM_H
+
+// NOTE: these are the parts of frender that the platform layer calls too: the dirty rects, premultiplyAlpha, the UI
+// renderer and the backbuffer ring. the platform exe does not link the engine library, so as with
+// automata_engine_pak.h, define AE_FRENDER_IMPL in exactly one translation unit of each module to get the
+// implementation. the UI renderer draws with jobs::parallelFor, so a module also needs automata_engine_jobs.cpp.
+//
+// the pixel helpers and the tiles of the rasterizer are here for the rest of frender to share.
+
+#include <automata_engine.hpp>
+
+#include <emmintrin.h>
+
+namespace automata_engine {
+    namespace frender {
+
+        // swap the R and B channels of 4 pixels, e.g. from the 0xABGR of images to the 0xARGB of targets.
+        static inline __m128i SwizzleRB(__m128i p)
+        {
+            const __m128i ag = _mm_set1_epi32(0xFF00FF00);
+            const __m128i lo = _mm_set1_epi32(0xFF);
+            return _mm_or_si128(_mm_and_si128(p, ag),
+                _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 16), lo), _mm_slli_epi32(_mm_and_si128(p, lo), 16)));
+        }
+
+        static inline uint32_t SwizzleRB(uint32_t p)
+        {
+            return (p & 0xFF00FF00) | ((p >> 16) & 0xFF) | ((p & 0xFF) << 16);
+        }
+
+        // multiply the channels of two colors, as (a * b) / 255 rounded.
+        static inline __m128i MulColors(__m128i a, __m128i b)
+        {
+            const __m128i zero  = _mm_setzero_si128();
+            const __m128i round = _mm_set1_epi16(128);
+            __m128i       lo    = _mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+            __m128i       hi    = _mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+            lo                  = _mm_add_epi16(lo, round);
+            hi                  = _mm_add_epi16(hi, round);
+            lo                  = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+            hi                  = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+            return _mm_packus_epi16(lo, hi);
+        }
+
+        // the alpha of each pixel, in all four of its channels. the pixels are 16 bits per channel.
+        static inline __m128i BroadcastAlpha16(__m128i p16)
+        {
+            return _mm_shufflehi_epi16(_mm_shufflelo_epi16(p16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        }
+
+        // src + dst * (255 - src alpha) / 255, for 4 premultiplied pixels. this is the "over" operator.
+        static inline __m128i BlendOver(__m128i src, __m128i dst)
+        {
+            const __m128i zero  = _mm_setzero_si128();
+            const __m128i round = _mm_set1_epi16(128);
+            const __m128i full  = _mm_set1_epi16(255);
+            __m128i       invLo = _mm_sub_epi16(full, BroadcastAlpha16(_mm_unpacklo_epi8(src, zero)));
+            __m128i       invHi = _mm_sub_epi16(full, BroadcastAlpha16(_mm_unpackhi_epi8(src, zero)));
+            __m128i       lo    = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), invLo), round);
+            __m128i       hi    = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), invHi), round);
+            lo                  = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+            hi                  = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+            return _mm_adds_epu8(src, _mm_packus_epi16(lo, hi));
+        }
+
+        // blend count premultiplied pixels over dst. SWIZZLE reads the source as 0xABGR.
+        template <bool SWIZZLE> static void BlendSpan(uint32_t *dst, const uint32_t *src, uint32_t count)
+        {
+            const __m128i alphaMask = _mm_set1_epi32(0xFF000000);
+            uint32_t      i         = 0;
+            for (; i + 4 <= count; i += 4) {
+                __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+                if constexpr (SWIZZLE) s = SwizzleRB(s);
+                // NOTE: sprites are mostly opaque or clear, and those spans skip the blend.
+                int opaque = _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alphaMask), alphaMask));
+                if (opaque == 0xFFFF) {
+                    _mm_storeu_si128((__m128i *)(dst + i), s);
+                } else if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alphaMask), _mm_setzero_si128())) !=
+                           0xFFFF) {
+                    __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+                    _mm_storeu_si128((__m128i *)(dst + i), BlendOver(s, d));
+                }
+            }
+            if (i < count) {
+                alignas(16) uint32_t s[4] = {}, d[4] = {};
+                for (uint32_t j = 0; i + j < count; j++) s[j] = src[i + j], d[j] = dst[i + j];
+                __m128i sv = _mm_load_si128((const __m128i *)s);
+                if constexpr (SWIZZLE) sv = SwizzleRB(sv);
+                _mm_store_si128((__m128i *)d, BlendOver(sv, _mm_load_si128((const __m128i *)d)));
+                for (uint32_t j = 0; i + j < count; j++) dst[i + j] = d[j];
+            }
+        }
+
+        // NOTE: the rasterizer bins triangles into square tiles of the target, then renders the tiles in parallel.
+        // a tile is only touched by the thread that renders it, so the tiles need no synchronization. each tile
+        // draws its triangles in the order that they were submitted, which keeps the image deterministic.
+        static constexpr int32_t  RASTER_TILE_SHIFT    = 6;
+        static constexpr int32_t  RASTER_TILE_SIZE     = 1 << RASTER_TILE_SHIFT;
+        static constexpr int32_t  RASTER_SUBPIXEL_BITS = 4;
+        static constexpr int32_t  RASTER_SUBPIXEL      = 1 << RASTER_SUBPIXEL_BITS;
+        static constexpr uint32_t RASTER_MAX_SIZE      = 8192;  // the largest target, in pixels on a side.
+    }  // namespace frender
+}  // namespace automata_engine
+
+#if defined(AE_FRENDER_IMPL)
+
+#include <chrono>
+#include <condition_variable>
+#include <math.h>
+#include <mutex>
+#include <string.h>
+#include <vector>
+
+namespace automata_engine {
+    namespace frender {
+
+        void premultiplyAlpha(loaded_image_t image)
+        {
+            const __m128i zero      = _mm_setzero_si128();
+            const __m128i alphaLane = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+            const __m128i colorMask = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+            uint32_t     *pixels    = image.pixelPointer;
+            size_t        count     = size_t(image.width) * image.height;
+            size_t        i         = 0;
+            for (; i + 4 <= count; i += 4) {
+                __m128i p = _mm_loadu_si128((const __m128i *)(pixels + i));
+                // the multiplier of each channel is the alpha of the pixel, except for alpha itself.
+                __m128i lo = _mm_and_si128(BroadcastAlpha16(_mm_unpacklo_epi8(p, zero)), colorMask);
+                __m128i hi = _mm_and_si128(BroadcastAlpha16(_mm_unpackhi_epi8(p, zero)), colorMask);
+                lo         = _mm_or_si128(lo, alphaLane);
+                hi         = _mm_or_si128(hi, alphaLane);
+                _mm_storeu_si128((__m128i *)(pixels + i), MulColors(p, _mm_packus_epi16(lo, hi)));
+            }
+            for (; i < count; i++) {
+                uint32_t p = pixels[i], a = p >> 24, result = p & 0xFF000000;
+                for (uint32_t shift = 0; shift < 24; shift += 8) {
+                    uint32_t c = ((p >> shift) & 0xFF) * a + 128;
+                    result |= ((c + (c >> 8)) >> 8) << shift;
+                }
+                pixels[i] = result;
+            }
+        }
+
+        static int64_t RectArea(const dirty_rect_t &r) { return int64_t(r.width) * r.height; }
+
+        static dirty_rect_t RectUnion(const dirty_rect_t &a, const dirty_rect_t &b)
+        {
+            int32_t minX = math::min(a.x, b.x), minY = math::min(a.y, b.y);
+            int32_t maxX = math::max(a.x + a.width, b.x + b.width), maxY = math::max(a.y + a.height, b.y + b.height);
+            return {minX, minY, maxX - minX, maxY - minY};
+        }
+
+        // the pixels that merging two rects would copy but that neither rect covers. negative when they overlap.
+        static int64_t MergeCost(const dirty_rect_t &a, const dirty_rect_t &b)
+        {
+            return RectArea(RectUnion(a, b)) - RectArea(a) - RectArea(b);
+        }
+
+        void markDirty(backbuffer_t *target, int32_t x, int32_t y, int32_t width, int32_t height)
+        {
+            if (!target->dirty) return;
+            int64_t minX = math::max(int64_t(x), int64_t(0));
+            int64_t minY = math::max(int64_t(y), int64_t(0));
+            int64_t maxX = math::min(int64_t(x) + width, int64_t(target->width));
+            int64_t maxY = math::min(int64_t(y) + height, int64_t(target->height));
+            if (minX >= maxX || minY >= maxY) return;
+
+            dirty_rects_t *dirty = target->dirty;
+            dirty_rect_t   rect  = {int32_t(minX), int32_t(minY), int32_t(maxX - minX), int32_t(maxY - minY)};
+            // NOTE: the rect takes in each rect that it can merge with for free, i.e. those that it overlaps enough,
+            // or that contain it or that it contains. since the union can then reach further, the scan restarts.
+            for (uint32_t i = 0; i < dirty->count;) {
+                if (MergeCost(rect, dirty->rects[i]) <= 0) {
+                    rect            = RectUnion(rect, dirty->rects[i]);
+                    dirty->rects[i] = dirty->rects[--dirty->count];
+                    i               = 0;
+                } else {
+                    i++;
+                }
+            }
+            if (dirty->count < DIRTY_RECT_MAX) {
+                dirty->rects[dirty->count++] = rect;
+                return;
+            }
+            // the list is full, so the two rects, of the list and the new one, that cost the least to merge are.
+            uint32_t bestA = DIRTY_RECT_MAX, bestB = 0;
+            int64_t  bestCost = INT64_MAX;
+            for (uint32_t a = 0; a <= DIRTY_RECT_MAX; a++) {
+                const dirty_rect_t &rectA = (a == DIRTY_RECT_MAX) ? rect : dirty->rects[a];
+                for (uint32_t b = 0; b < math::min(a, DIRTY_RECT_MAX); b++) {
+                    int64_t cost = MergeCost(rectA, dirty->rects[b]);
+                    if (cost < bestCost) {
+                        bestCost = cost;
+                        bestA    = a;
+                        bestB    = b;
+                    }
+                }
+            }
+            if (bestA == DIRTY_RECT_MAX) {
+                dirty->rects[bestB] = RectUnion(dirty->rects[bestB], rect);
+            } else {
+                dirty->rects[bestB] = RectUnion(dirty->rects[bestB], dirty->rects[bestA]);
+                dirty->rects[bestA] = rect;
+            }
+        }
+
+        uint64_t presentDirty(backbuffer_t *front, const backbuffer_t &back)
+        {
+            if (front->width != back.width || front->height != back.height ||
+                front->bytesPerPixel != back.bytesPerPixel) {
+                AELoggerError("unable to present a %ux%u backbuffer to a %ux%u one", back.width, back.height,
+                    front->width, front->height);
+                return 0;
+            }
+            // NOTE: a backbuffer that does not track what changed is presented whole.
+            dirty_rects_t  all   = {1, {{0, 0, int32_t(back.width), int32_t(back.height)}}};
+            dirty_rects_t *list  = back.dirty ? back.dirty : &all;
+            uint64_t       bytes = 0;
+            for (uint32_t i = 0; i < list->count; i++) {
+                const dirty_rect_t &rect     = list->rects[i];
+                const size_t        rowBytes = size_t(rect.width) * back.bytesPerPixel;
+                const size_t        offset   = size_t(rect.x) * back.bytesPerPixel;
+                const uint8_t      *src      = (const uint8_t *)back.memory + size_t(rect.y) * back.pitch + offset;
+                uint8_t            *dst      = (uint8_t *)front->memory + size_t(rect.y) * front->pitch + offset;
+                for (int32_t y = 0; y < rect.height; y++) {
+                    memcpy(dst, src, rowBytes);
+                    src += back.pitch;
+                    dst += front->pitch;
+                }
+                bytes += uint64_t(rowBytes) * rect.height;
+            }
+            list->count = 0;
+            return bytes;
+        }
+
+        // NOTE: the UI renderer bins into the tiles of the rasterizer as the sprite batch does, and each tile draws its
+        // shapes in the order of the draw lists, which is the order that ImGui blends in. the vertices are snapped to
+        // the subpixels of the rasterizer, and the edges follow the top-left rule, so a quad drawn as a rect covers
+        // exactly the pixels that its two triangles would.
+        static constexpr float UI_MAX_COORD = float(1 << 22);  // in pixels. a triangle that reaches further is culled.
+
+        struct ui_shape_t {
+            int32_t               minX, minY, maxX, maxY;  // the pixels that may be drawn, clipped. max is exclusive.
+            const loaded_image_t *texture;  // null unless the texture coordinates vary over the shape.
+            uint32_t              color;    // the premultiplied 0xABGR of a shape that is one color.
+            bool                  bRect;
+            bool                  bSolid;
+            // the edge functions of a triangle, E(X, Y) = a * X + b * Y + c over subpixels, >= 0 inside.
+            int64_t a[3], b[3], c[3];
+            // r, g, b, a (premultiplied) and u, v (in texels) as value + d/dx * (x - x0) + d/dy * (y - y0) over pixels.
+            float x0, y0;
+            float planes[6][3];
+        };
+
+        struct ui_renderer_t {
+            backbuffer_t                       target;
+            uint32_t                           tilesX;
+            uint32_t                           tilesY;
+            std::vector<ui_shape_t>            shapes;
+            std::vector<std::vector<uint32_t>> bins;  // shape indices per tile.
+            ui_stats_t                         stats;
+        };
+
+        ui_renderer_t *createUiRenderer() { return new ui_renderer_t(); }
+
+        void destroyUiRenderer(ui_renderer_t *renderer) { delete renderer; }
+
+        static inline int64_t FloorDiv(int64_t n, int64_t d)
+        {
+            // d > 0.
+            int64_t q = n / d;
+            return (n % d && n < 0) ? q - 1 : q;
+        }
+
+        static inline int64_t CeilDiv(int64_t n, int64_t d) { return -FloorDiv(-n, d); }
+
+        // the premultiplied channels of a 0xAABBGGRR vertex color, multiplied by a premultiplied 0xABGR texel. the
+        // rounding is that of the sprite batch, which premultiplies its tint and then uses MulColors.
+        static void UiVertexChannels(uint32_t color, uint32_t texel, float *channels)
+        {
+            const uint32_t alpha = color >> 24;
+            for (uint32_t k = 0; k < 4; k++) {
+                uint32_t c = (color >> (k * 8)) & 0xFF, t = (texel >> (k * 8)) & 0xFF;
+                if (k < 3) c = (c * alpha + 127) / 255;
+                channels[k] = float((c * t * 2 + 255) / 510);
+            }
+        }
+
+        static inline uint32_t PackChannels(const float *channels)
+        {
+            uint32_t result = 0;
+            for (uint32_t k = 0; k < 4; k++)
+                result |= uint32_t(math::min(math::max(channels[k], 0.f), 255.f) + 0.5f) << (k * 8);
+            return result;
+        }
+
+        static inline uint32_t SampleUiTexture(const loaded_image_t &image, float u, float v)
+        {
+            int32_t x = math::min(math::max(int32_t(floorf(u)), 0), int32_t(image.width) - 1);
+            int32_t y = math::min(math::max(int32_t(floorf(v)), 0), int32_t(image.height) - 1);
+            // NOTE: the image rows are bottom first.
+            return image.pixelPointer[size_t(image.height - 1 - y) * image.width + x];
+        }
+
+        // the pixels of the target whose centers are in [min, max) of subpixels, as a triangle edge would cover them.
+        static inline int32_t UiPixelEdge(int64_t subpixels)
+        {
+            return int32_t(CeilDiv(subpixels - RASTER_SUBPIXEL / 2, RASTER_SUBPIXEL));
+        }
+
+        // add the shape of a quad given as the triangles (i0, i1, i2), (i0, i2, i3), if it is an axis aligned rect of
+        // one color with the texture mapped along its axes.
+        static bool PushUiRect(ui_renderer_t *renderer,
+            const ui_vertex_t               *v[4],
+            const int64_t                   *X,
+            const int64_t                   *Y,
+            const int32_t                   *clip,
+            const loaded_image_t            *texture)
+        {
+            if (X[0] != X[3] || X[1] != X[2] || Y[0] != Y[1] || Y[2] != Y[3] || X[0] == X[1] || Y[0] == Y[3])
+                return false;
+            if (v[0]->color != v[1]->color || v[0]->color != v[2]->color || v[0]->color != v[3]->color) return false;
+            if (v[0]->u != v[3]->u || v[1]->u != v[2]->u || v[0]->v != v[1]->v || v[2]->v != v[3]->v) return false;
+
+            ui_shape_t shape = {};
+            shape.bRect      = true;
+            shape.minX       = math::max(UiPixelEdge(math::min(X[0], X[1])), clip[0]);
+            shape.minY       = math::max(UiPixelEdge(math::min(Y[0], Y[3])), clip[1]);
+            shape.maxX       = math::min(UiPixelEdge(math::max(X[0], X[1])), clip[2]);
+            shape.maxY       = math::min(UiPixelEdge(math::max(Y[0], Y[3])), clip[3]);
+            if (shape.minX < shape.maxX && shape.minY < shape.maxY) {
+                const bool bTextured = texture && (v[0]->u != v[1]->u || v[0]->v != v[3]->v);
+                const uint32_t texel =
+                    (texture && !bTextured) ? SampleUiTexture(*texture, v[0]->u * texture->width,
+                                                  v[0]->v * texture->height)
+                                            : 0xFFFFFFFF;
+                float channels[4];
+                UiVertexChannels(v[0]->color, texel, channels);
+                shape.color  = PackChannels(channels);
+                shape.bSolid = !bTextured;
+                if (bTextured) {
+                    // u along x from vertex 0 to 1, and v along y from vertex 0 to 3.
+                    shape.texture      = texture;
+                    shape.x0           = float(X[0]) / RASTER_SUBPIXEL;
+                    shape.y0           = float(Y[0]) / RASTER_SUBPIXEL;
+                    shape.planes[4][0] = v[0]->u * texture->width;
+                    shape.planes[4][1] = (v[1]->u - v[0]->u) * texture->width * RASTER_SUBPIXEL / float(X[1] - X[0]);
+                    shape.planes[5][0] = v[0]->v * texture->height;
+                    shape.planes[5][2] = (v[3]->v - v[0]->v) * texture->height * RASTER_SUBPIXEL / float(Y[3] - Y[0]);
+                }
+                if (shape.color) renderer->shapes.push_back(shape);
+            }
+            renderer->stats.rects++;
+            return true;
+        }
+
+        static void PushUiTriangle(ui_renderer_t *renderer,
+            const ui_vertex_t                   *v[3],
+            int64_t                             *X,
+            int64_t                             *Y,
+            const int32_t                       *clip,
+            const loaded_image_t                *texture)
+        {
+            int64_t area = (X[1] - X[0]) * (Y[2] - Y[0]) - (Y[1] - Y[0]) * (X[2] - X[0]);
+            if (!area) {
+                renderer->stats.culled++;
+                return;
+            }
+            // NOTE: ImGui winds its triangles either way.
+            if (area < 0) {
+                std::swap(v[1], v[2]);
+                std::swap(X[1], X[2]);
+                std::swap(Y[1], Y[2]);
+                area = -area;
+            }
+
+            ui_shape_t shape = {};
+            shape.minX = math::max(UiPixelEdge(math::min(X[0], math::min(X[1], X[2]))), clip[0]);
+            shape.minY = math::max(UiPixelEdge(math::min(Y[0], math::min(Y[1], Y[2]))), clip[1]);
+            shape.maxX = math::min(UiPixelEdge(math::max(X[0], math::max(X[1], X[2])) + 1), clip[2]);
+            shape.maxY = math::min(UiPixelEdge(math::max(Y[0], math::max(Y[1], Y[2])) + 1), clip[3]);
+            if (shape.minX >= shape.maxX || shape.minY >= shape.maxY) {
+                renderer->stats.culled++;
+                return;
+            }
+            for (uint32_t i = 0; i < 3; i++) {
+                uint32_t j = (i + 1) % 3;
+                shape.a[i] = Y[i] - Y[j];
+                shape.b[i] = X[j] - X[i];
+                shape.c[i] = -(shape.a[i] * X[i] + shape.b[i] * Y[i]);
+                // NOTE: the left and top edges are inside, the others are not.
+                if (!(shape.a[i] > 0 || (shape.a[i] == 0 && shape.b[i] > 0))) shape.c[i]--;
+            }
+
+            const bool bTextured = texture && (v[0]->u != v[1]->u || v[0]->u != v[2]->u || v[0]->v != v[1]->v ||
+                                                  v[0]->v != v[2]->v);
+            const uint32_t texel = (texture && !bTextured)
+                                       ? SampleUiTexture(*texture, v[0]->u * texture->width, v[0]->v * texture->height)
+                                       : 0xFFFFFFFF;
+            float values[3][6];
+            for (uint32_t i = 0; i < 3; i++) {
+                UiVertexChannels(v[i]->color, texel, values[i]);
+                values[i][4] = texture ? v[i]->u * texture->width : 0.f;
+                values[i][5] = texture ? v[i]->v * texture->height : 0.f;
+            }
+            shape.bSolid = !bTextured && v[0]->color == v[1]->color && v[0]->color == v[2]->color;
+            shape.color  = PackChannels(values[0]);
+            if (shape.bSolid && !shape.color) {
+                renderer->stats.triangles++;
+                return;
+            }
+            shape.texture = bTextured ? texture : nullptr;
+
+            const float x0 = float(X[0]) / RASTER_SUBPIXEL, y0 = float(Y[0]) / RASTER_SUBPIXEL;
+            const float x1 = float(X[1]) / RASTER_SUBPIXEL - x0, y1 = float(Y[1]) / RASTER_SUBPIXEL - y0;
+            const float x2 = float(X[2]) / RASTER_SUBPIXEL - x0, y2 = float(Y[2]) / RASTER_SUBPIXEL - y0;
+            const float invArea = float(RASTER_SUBPIXEL * RASTER_SUBPIXEL) / float(area);
+            shape.x0            = x0;
+            shape.y0            = y0;
+            for (uint32_t k = 0; k < 6; k++) {
+                float d1           = values[1][k] - values[0][k];
+                float d2           = values[2][k] - values[0][k];
+                shape.planes[k][0] = values[0][k];
+                shape.planes[k][1] = (d1 * y2 - d2 * y1) * invArea;
+                shape.planes[k][2] = (d2 * x1 - d1 * x2) * invArea;
+            }
+            renderer->shapes.push_back(shape);
+            renderer->stats.triangles++;
+        }
+
+        static void DrawUiTile(ui_renderer_t *renderer, uint32_t tileIndex)
+        {
+            const backbuffer_t &target = renderer->target;
+            const int32_t       tileX0 = int32_t(tileIndex % renderer->tilesX) << RASTER_TILE_SHIFT;
+            const int32_t       tileY0 = int32_t(tileIndex / renderer->tilesX) << RASTER_TILE_SHIFT;
+            const int32_t       tileX1 = math::min(tileX0 + RASTER_TILE_SIZE, int32_t(target.width));
+            const int32_t       tileY1 = math::min(tileY0 + RASTER_TILE_SIZE, int32_t(target.height));
+            alignas(16) uint32_t span[RASTER_TILE_SIZE];
+            alignas(16) uint32_t texels[RASTER_TILE_SIZE];
+            int32_t              columns[RASTER_TILE_SIZE];
+
+            for (uint32_t index : renderer->bins[tileIndex]) {
+                const ui_shape_t &shape = renderer->shapes[index];
+                const int32_t     x0    = math::max(shape.minX, tileX0);
+                const int32_t     x1    = math::min(shape.maxX, tileX1);
+                const int32_t     y0    = math::max(shape.minY, tileY0);
+                const int32_t     y1    = math::min(shape.maxY, tileY1);
+                if (shape.bSolid) {
+                    for (int32_t i = 0; i < x1 - x0; i++) span[i] = shape.color;
+                } else if (shape.bRect) {
+                    // NOTE: the texels of a rect are in the same columns on each row.
+                    const float px = x0 + 0.5f - shape.x0;
+                    for (int32_t i = 0; i < x1 - x0; i++) {
+                        float u    = shape.planes[4][0] + shape.planes[4][1] * (px + i);
+                        columns[i] = math::min(math::max(int32_t(floorf(u)), 0), int32_t(shape.texture->width) - 1);
+                    }
+                }
+
+                for (int32_t y = y0; y < y1; y++) {
+                    int32_t minX = x0, maxX = x1;
+                    if (!shape.bRect) {
+                        // the span of the row that is inside of all three edges.
+                        const int64_t Y = int64_t(y) * RASTER_SUBPIXEL + RASTER_SUBPIXEL / 2;
+                        for (uint32_t i = 0; i < 3 && minX < maxX; i++) {
+                            const int64_t a = shape.a[i], k = shape.b[i] * Y + shape.c[i];
+                            if (a > 0) {
+                                int64_t first = CeilDiv(-k - a * (RASTER_SUBPIXEL / 2), a * RASTER_SUBPIXEL);
+                                minX          = int32_t(math::max(int64_t(minX), first));
+                            } else if (a < 0) {
+                                int64_t last = FloorDiv(k + a * (RASTER_SUBPIXEL / 2), -a * RASTER_SUBPIXEL);
+                                maxX         = int32_t(math::min(int64_t(maxX), last + 1));
+                            } else if (k < 0) {
+                                maxX = minX;
+                            }
+                        }
+                        if (minX >= maxX) continue;
+                    }
+                    uint32_t *dst   = (uint32_t *)((uint8_t *)target.memory + size_t(y) * target.pitch) + minX;
+                    uint32_t  count = uint32_t(maxX - minX);
+                    if (shape.bSolid) {
+                        BlendSpan<true>(dst, span, count);
+                        continue;
+                    }
+
+                    const float px = minX + 0.5f - shape.x0, py = y + 0.5f - shape.y0;
+                    if (shape.bRect) {
+                        // NOTE: a textured rect is one color, and its texture row is the same across the span.
+                        const loaded_image_t &image = *shape.texture;
+                        const float           v     = shape.planes[5][0] + shape.planes[5][2] * py;
+                        const int32_t row = math::min(math::max(int32_t(floorf(v)), 0), int32_t(image.height) - 1);
+                        const uint32_t *src = image.pixelPointer + size_t(image.height - 1 - row) * image.width;
+                        for (uint32_t i = 0; i < count; i++) span[i] = src[columns[i]];
+                        if (shape.color != 0xFFFFFFFF) {
+                            const __m128i tint = _mm_set1_epi32(int32_t(shape.color));
+                            for (uint32_t i = 0; i < count; i += 4) {
+                                __m128i *p = (__m128i *)(span + i);
+                                _mm_store_si128(p, MulColors(_mm_load_si128(p), tint));
+                            }
+                        }
+                        BlendSpan<true>(dst, span, count);
+                        continue;
+                    }
+
+                    float values[6], steps[6];
+                    for (uint32_t k = 0; k < 6; k++) {
+                        values[k] = shape.planes[k][0] + shape.planes[k][1] * px + shape.planes[k][2] * py;
+                        steps[k]  = shape.planes[k][1];
+                    }
+                    for (uint32_t i = 0; i < count; i++) {
+                        span[i] = PackChannels(values);
+                        if (shape.texture) texels[i] = SampleUiTexture(*shape.texture, values[4], values[5]);
+                        for (uint32_t k = 0; k < 6; k++) values[k] += steps[k];
+                    }
+                    if (shape.texture) {
+                        for (uint32_t i = 0; i < count; i += 4) {
+                            __m128i *p = (__m128i *)(span + i);
+                            _mm_store_si128(p, MulColors(_mm_load_si128(p), _mm_load_si128((__m128i *)(texels + i))));
+                        }
+                    }
+                    BlendSpan<true>(dst, span, count);
+                }
+            }
+        }
+
+        bool renderUi(ui_renderer_t *renderer, backbuffer_t *target, const ui_draw_data_t &data)
+        {
+            if (!target->memory || !target->width || !target->height || target->width > RASTER_MAX_SIZE ||
+                target->height > RASTER_MAX_SIZE || target->bytesPerPixel != sizeof(uint32_t)) {
+                AELoggerError("unable to draw a UI to a %ux%u target with %u bytes per pixel",
+                    target->width, target->height, target->bytesPerPixel);
+                return false;
+            }
+            renderer->target = *target;
+            renderer->tilesX = (target->width + RASTER_TILE_SIZE - 1) >> RASTER_TILE_SHIFT;
+            renderer->tilesY = (target->height + RASTER_TILE_SIZE - 1) >> RASTER_TILE_SHIFT;
+            renderer->shapes.clear();
+            renderer->bins.resize(size_t(renderer->tilesX) * renderer->tilesY);
+            for (auto &bin : renderer->bins) bin.clear();
+            renderer->stats = {};
+
+            const float scaleX = data.scaleX * RASTER_SUBPIXEL, scaleY = data.scaleY * RASTER_SUBPIXEL;
+            for (uint32_t l = 0; l < data.listCount; l++) {
+                const ui_draw_list_t &list = data.lists[l];
+                for (uint32_t n = 0; n < list.commandCount; n++) {
+                    const ui_command_t &command = list.commands[n];
+                    // the pixels whose centers are in the clip rect.
+                    auto edge = [](float x, uint32_t size) {
+                        return int32_t(math::min(math::max(ceilf(x - 0.5f), 0.f), float(size)));
+                    };
+                    const int32_t clip[4] = {edge((command.clipMinX - data.displayX) * data.scaleX, target->width),
+                        edge((command.clipMinY - data.displayY) * data.scaleY, target->height),
+                        edge((command.clipMaxX - data.displayX) * data.scaleX, target->width),
+                        edge((command.clipMaxY - data.displayY) * data.scaleY, target->height)};
+                    const uint32_t shapes = uint32_t(renderer->shapes.size());
+                    const uint32_t end    = math::min(command.indexOffset + command.indexCount, list.indexCount);
+                    const loaded_image_t *texture = command.texture;
+                    if (texture && (!texture->pixelPointer || !texture->width || !texture->height)) texture = nullptr;
+
+                    for (uint32_t i = command.indexOffset; i + 3 <= end; i += 3) {
+                        if (clip[0] >= clip[2] || clip[1] >= clip[3]) {
+                            renderer->stats.culled += (end - i) / 3;
+                            break;
+                        }
+                        // the quads of ImGui are the triangles (0, 1, 2), (0, 2, 3) of their four vertices.
+                        const uint16_t    *indices  = list.indices + i;
+                        const uint32_t     vertices = (i + 6 <= end && indices[3] == indices[0] &&
+                                                       indices[4] == indices[2]) ? 4 : 3;
+                        const ui_vertex_t *v[4];
+                        int64_t            X[4], Y[4];
+                        bool               bValid = true;
+                        for (uint32_t k = 0; k < vertices && bValid; k++) {
+                            uint32_t index = command.vertexOffset + indices[(k == 3) ? 5 : k];
+                            bValid         = index < list.vertexCount;
+                            if (!bValid) break;
+                            v[k]    = list.vertices + index;
+                            float x = (v[k]->x - data.displayX) * scaleX, y = (v[k]->y - data.displayY) * scaleY;
+                            bValid  = fabsf(x) < UI_MAX_COORD * RASTER_SUBPIXEL &&
+                                     fabsf(y) < UI_MAX_COORD * RASTER_SUBPIXEL;
+                            X[k]    = lrintf(x);
+                            Y[k]    = lrintf(y);
+                        }
+                        if (!bValid) {
+                            renderer->stats.culled++;
+                            continue;
+                        }
+                        if (vertices == 4 && PushUiRect(renderer, v, X, Y, clip, texture)) {
+                            i += 3;
+                            continue;
+                        }
+                        PushUiTriangle(renderer, v, X, Y, clip, texture);
+                    }
+
+                    // NOTE: the dirty rect of a command is the union of its shapes.
+                    int32_t minX = INT32_MAX, minY = INT32_MAX, maxX = INT32_MIN, maxY = INT32_MIN;
+                    for (uint32_t s = shapes; s < uint32_t(renderer->shapes.size()); s++) {
+                        const ui_shape_t &shape = renderer->shapes[s];
+                        minX                    = math::min(minX, shape.minX);
+                        minY                    = math::min(minY, shape.minY);
+                        maxX                    = math::max(maxX, shape.maxX);
+                        maxY                    = math::max(maxY, shape.maxY);
+                        const int32_t maxTX     = (shape.maxX - 1) >> RASTER_TILE_SHIFT;
+                        const int32_t maxTY     = (shape.maxY - 1) >> RASTER_TILE_SHIFT;
+                        for (int32_t ty = shape.minY >> RASTER_TILE_SHIFT; ty <= maxTY; ty++) {
+                            for (int32_t tx = shape.minX >> RASTER_TILE_SHIFT; tx <= maxTX; tx++)
+                                renderer->bins[size_t(ty) * renderer->tilesX + tx].push_back(s);
+                        }
+                        renderer->stats.tileShapes += uint32_t((maxTX - (shape.minX >> RASTER_TILE_SHIFT) + 1) *
+                                                               (maxTY - (shape.minY >> RASTER_TILE_SHIFT) + 1));
+                    }
+                    if (minX < maxX) markDirty(target, minX, minY, maxX - minX, maxY - minY);
+                }
+            }
+
+            uint32_t tileCount = renderer->tilesX * renderer->tilesY;
+            jobs::parallelFor(tileCount, 1, [renderer](uint32_t begin, uint32_t end) {
+                for (uint32_t tile = begin; tile < end; tile++)
+                    if (!renderer->bins[tile].empty()) DrawUiTile(renderer, tile);
+            });
+            return true;
+        }
+
+        ui_stats_t getUiStats(ui_renderer_t *renderer) { return renderer->stats; }
+
+        static constexpr uint32_t RING_NONE = UINT32_MAX;
+
+        struct ring_slot_t {
+            std::vector<uint32_t> pixels;  // only grows. the buffer is the first width * height.
+            backbuffer_t          buffer;
+            dirty_rects_t         dirty;   // what the frame that the buffer holds changed.
+            dirty_rects_t         behind;  // what the frames submitted since the one that it holds changed.
+            bool                  bBehindWhole;
+            uint64_t              frame;  // the frame that the buffer holds, or 0 for none.
+        };
+
+        // NOTE: the renderer has the buffer at rendering, the presenter the one at front, and the one at ready waits
+        // for the presenter. the rest are free. all of it is under the mutex.
+        struct backbuffer_ring_t {
+            std::mutex               mutex;
+            std::condition_variable  changed;
+            std::vector<ring_slot_t> slots;
+            uint32_t                 rendering;
+            uint32_t                 ready;
+            uint32_t                 front;
+            uint64_t                 frame;       // the last submitted frame.
+            dirty_rects_t            frontDirty;  // what the frames since the front buffer changed.
+            uint32_t                 frontWidth;  // the size that frontDirty is of.
+            uint32_t                 frontHeight;
+            bool                     bClosed;
+            backbuffer_ring_stats_t  stats;
+        };
+
+        backbuffer_ring_t *createBackbufferRing(uint32_t count)
+        {
+            backbuffer_ring_t *ring = new backbuffer_ring_t();
+            ring->slots.resize(math::max(count, 2u));
+            for (ring_slot_t &slot : ring->slots) {
+                slot.buffer.bytesPerPixel = sizeof(uint32_t);
+                slot.buffer.dirty         = &slot.dirty;
+                slot.bBehindWhole         = true;
+            }
+            ring->rendering = ring->ready = ring->front = RING_NONE;
+            return ring;
+        }
+
+        void destroyBackbufferRing(backbuffer_ring_t *ring) { delete ring; }
+
+        // set the size of a buffer of the ring. its pixels grow by half again when they are too few, so that
+        // dragging the edge of a window allocates only a few times.
+        static void ResizeRingSlot(backbuffer_ring_t *ring, ring_slot_t *slot, uint32_t width, uint32_t height)
+        {
+            const size_t count = size_t(width) * height;
+            if (slot->pixels.size() < count) {
+                slot->pixels = std::vector<uint32_t>(math::max(count, slot->pixels.size() + slot->pixels.size() / 2));
+                ring->stats.allocations++;
+            }
+            slot->buffer.memory = slot->pixels.data();
+            slot->buffer.width  = width;
+            slot->buffer.height = height;
+            slot->buffer.pitch  = width * uint32_t(sizeof(uint32_t));
+        }
+
+        // bring the acquired buffer up to the last submitted frame, by copying what it is behind by from the buffer
+        // of that frame.
+        static void CatchUpRingSlot(backbuffer_ring_t *ring, uint32_t width, uint32_t height)
+        {
+            ring_slot_t &slot     = ring->slots[ring->rendering];
+            const bool   bResized = slot.buffer.width != width || slot.buffer.height != height;
+            if (bResized) ResizeRingSlot(ring, &slot, width, height);
+            dirty_rects_t behind = slot.behind;
+            if (slot.bBehindWhole || bResized) behind = {1, {{0, 0, int32_t(width), int32_t(height)}}};
+            slot.behind.count = 0;
+            slot.bBehindWhole = false;
+            slot.frame        = 0;
+            slot.dirty.count  = 0;
+
+            const ring_slot_t *latest = nullptr;
+            for (const ring_slot_t &other : ring->slots)
+                if (ring->frame && other.frame == ring->frame) latest = &other;
+            if (!latest || latest->buffer.width != width || latest->buffer.height != height) {
+                // NOTE: there is no frame of this size to start from.
+                if (width && height) memset(slot.buffer.memory, 0, size_t(width) * height * sizeof(uint32_t));
+                markDirty(&slot.buffer, 0, 0, int32_t(width), int32_t(height));
+                return;
+            }
+            backbuffer_t back = latest->buffer;
+            back.dirty        = &behind;
+            ring->stats.copiedBytes += presentDirty(&slot.buffer, back);
+        }
+
+        backbuffer_t *acquireBackbuffer(backbuffer_ring_t *ring, uint32_t width, uint32_t height)
+        {
+            std::unique_lock<std::mutex> lock(ring->mutex);
+            if (ring->rendering != RING_NONE) {
+                if (ring->bClosed) return nullptr;
+                ring_slot_t &slot = ring->slots[ring->rendering];
+                if (slot.buffer.width != width || slot.buffer.height != height) CatchUpRingSlot(ring, width, height);
+                return &slot.buffer;
+            }
+            // NOTE: of the free buffers, the one with the newest frame has the least to catch up on.
+            uint32_t index = RING_NONE;
+            ring->changed.wait(lock, [ring, &index] {
+                for (uint32_t i = 0; i < uint32_t(ring->slots.size()); i++) {
+                    if (i == ring->ready || i == ring->front) continue;
+                    if (index == RING_NONE || ring->slots[i].frame > ring->slots[index].frame) index = i;
+                }
+                return ring->bClosed || index != RING_NONE;
+            });
+            if (ring->bClosed) return nullptr;
+            ring->rendering = index;
+            CatchUpRingSlot(ring, width, height);
+            return &ring->slots[index].buffer;
+        }
+
+        void submitBackbuffer(backbuffer_ring_t *ring)
+        {
+            std::lock_guard<std::mutex> lock(ring->mutex);
+            if (ring->rendering == RING_NONE) return;
+            ring_slot_t &slot = ring->slots[ring->rendering];
+            slot.frame        = ++ring->frame;
+            // NOTE: a frame of a new size is all dirty, so what changed at the old size does not matter.
+            if (slot.buffer.width != ring->frontWidth || slot.buffer.height != ring->frontHeight) {
+                ring->frontDirty.count = 0;
+                ring->frontWidth       = slot.buffer.width;
+                ring->frontHeight      = slot.buffer.height;
+            }
+            backbuffer_t front = slot.buffer;
+            front.dirty        = &ring->frontDirty;
+            for (uint32_t i = 0; i < slot.dirty.count; i++) {
+                const dirty_rect_t &rect = slot.dirty.rects[i];
+                markDirty(&front, rect.x, rect.y, rect.width, rect.height);
+            }
+            // NOTE: every other buffer is now behind by this frame. one of another size has to catch up whole.
+            for (ring_slot_t &other : ring->slots) {
+                if (&other == &slot || other.bBehindWhole) continue;
+                if (other.buffer.width != slot.buffer.width || other.buffer.height != slot.buffer.height) {
+                    other.bBehindWhole = true;
+                    continue;
+                }
+                backbuffer_t behind = other.buffer;
+                behind.dirty        = &other.behind;
+                for (uint32_t i = 0; i < slot.dirty.count; i++) {
+                    const dirty_rect_t &rect = slot.dirty.rects[i];
+                    markDirty(&behind, rect.x, rect.y, rect.width, rect.height);
+                }
+            }
+            if (ring->ready != RING_NONE) ring->stats.dropped++;
+            ring->ready     = ring->rendering;
+            ring->rendering = RING_NONE;
+            ring->stats.submitted++;
+            ring->changed.notify_all();
+        }
+
+        const backbuffer_t *acquireFrontBuffer(backbuffer_ring_t *ring, uint32_t timeoutMs, dirty_rects_t *dirty)
+        {
+            std::unique_lock<std::mutex> lock(ring->mutex);
+            ring->changed.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                [ring] { return ring->bClosed || ring->ready != RING_NONE; });
+            if (ring->bClosed || ring->ready == RING_NONE) return nullptr;
+            ring->front = ring->ready;
+            ring->ready = RING_NONE;
+            if (dirty) *dirty = ring->frontDirty;
+            ring->frontDirty.count = 0;
+            ring->stats.presented++;
+            // NOTE: the previous front buffer is free now.
+            ring->changed.notify_all();
+            return &ring->slots[ring->front].buffer;
+        }
+
+        void closeBackbufferRing(backbuffer_ring_t *ring)
+        {
+            std::lock_guard<std::mutex> lock(ring->mutex);
+            ring->bClosed = true;
+            ring->changed.notify_all();
+        }
+
+        backbuffer_ring_stats_t getBackbufferRingStats(backbuffer_ring_t *ring)
+        {
+            std::lock_guard<std::mutex> lock(ring->mutex);
+            return ring->stats;
+        }
+    }  // namespace frender
+}  // namespace automata_engine
+
+#endif  // AE_FRENDER_IMPL
+
+#endif  // AUTOMATA_ENGINE_FRENDER_PLATFORM_H
@@ -194,6 +194,21 @@ namespace automata_engine {
             const char *filePath,
             GLint minFilter, GLint magFilter, bool generateMips, GLint wrap
         ) {
+            // NOTE: cooked textures bring their own mip chain.
+            size_t pathLen = strlen(filePath);
+            if ((pathLen >= 4 && !_stricmp(filePath + pathLen - 4, ".dds")) ||
+                (pathLen >= 5 && !_stricmp(filePath + pathLen - 5, ".ktx2"))) {
+                texture::texture_t texture = texture::loadTexture(filePath);
+                GLuint tex = 0;
+                if (texture.data) {
+                    tex = createTexture(texture, minFilter, magFilter, wrap);
+                    glFlush(); // push all buffered commands to GPU
+                    glFinish(); // block until GPU is complete
+                    texture::freeTexture(texture);
+                }
+                return tex;
+            }
+
             loaded_image_t img = ae::platform::stbImageLoad((char *)filePath);
             GLuint tex = 0;
             if (img.pixelPointer != nullptr) {
@@ -229,6 +244,52 @@ namespace automata_engine {
             return newTexture;
         }
 
+        GLenum getTextureInternalFormat(texture::texture_format_t format) {
+            switch(format) {
+                case texture::TEXTURE_FORMAT_RGBA8:      return GL_RGBA8;
+                case texture::TEXTURE_FORMAT_RGBA8_SRGB: return GL_SRGB8_ALPHA8;
+                case texture::TEXTURE_FORMAT_BC1:        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+                case texture::TEXTURE_FORMAT_BC1_SRGB:   return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+                case texture::TEXTURE_FORMAT_BC3:        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+                case texture::TEXTURE_FORMAT_BC3_SRGB:   return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+                case texture::TEXTURE_FORMAT_BC5:        return GL_COMPRESSED_RG_RGTC2;
+                case texture::TEXTURE_FORMAT_BC7:        return GL_COMPRESSED_RGBA_BPTC_UNORM;
+                case texture::TEXTURE_FORMAT_BC7_SRGB:   return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+                default:                                 return 0;
+            }
+        }
+
+        GLuint createTexture(
+            const texture::texture_t &texture, GLint minFilter, GLint magFilter, GLint wrap
+        ) {
+            GLenum internalFormat = getTextureInternalFormat(texture.format);
+            if (!internalFormat || !texture.data) return 0;
+            GLuint newTexture;
+            glGenTextures(1, &newTexture);
+            glBindTexture(GL_TEXTURE_2D, newTexture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+            // NOTE: the texture is complete with whatever levels it has, so mip filtering works on partial chains.
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture.levelCount - 1);
+            // NOTE: rows of small levels are not 4 byte aligned for uncompressed formats.
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            for (uint32_t i = 0; i < texture.levelCount; i++) {
+                const texture::texture_level_t &level = texture.levels[i];
+                if (texture::isCompressed(texture.format)) {
+                    glCompressedTexImage2D(GL_TEXTURE_2D, i, internalFormat, level.width, level.height, 0,
+                        level.size, texture.data + level.offset);
+                } else {
+                    glTexImage2D(GL_TEXTURE_2D, i, internalFormat, level.width, level.height, 0, GL_RGBA,
+                        GL_UNSIGNED_BYTE, texture.data + level.offset);
+                }
+            }
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            return newTexture;
+        }
+
         // TODO(Noah): add err checking
         vbo_t createAndSetupVbo(
             uint32_t counts,
@@ -5,6 +5,17 @@
 #define STB_DS_IMPLEMENTATION
 #include "stb_ds.h"
 
+// NOTE: stb_image is implemented (and so already included) by automata_engine.cpp within the amalgamation.
+#if !defined(STBI_INCLUDE_STB_IMAGE_H)
+#include "stb_image.h"
+#endif
+
+#include <atomic>
+#include <math.h>
+#include <vector>
+
+#include <emmintrin.h>
+
 namespace ae = automata_engine;
 
 namespace automata_engine {
@@ -50,7 +61,8 @@ namespace automata_engine {
       Wav_ChunkID_fmt = RIFF_CODE('f','m','t',' '),
       Wav_ChunkID_WAVE = RIFF_CODE('W','A','V','E'),
       Wav_ChunkID_RIFF = RIFF_CODE('R','I','F','F'),
-      Wav_ChunkID_data = RIFF_CODE('d','a','t','a')
+      Wav_ChunkID_data = RIFF_CODE('d','a','t','a'),
+      Wav_ChunkID_fact = RIFF_CODE('f','a','c','t')
     };
     typedef struct wav_file_cursor {
       char *cursor;
@@ -80,9 +92,6 @@ namespace automata_engine {
     // NOTE(Noah): Again. Consistent naming convention. Here, we have the master function
     // LoadWav. All these other functions are "sub" functions. They exist literally to make
     // the code more readable. But these "sub" functions only exist FOR the master function.
-    static bool LoadWav_IsFileCursorValid(wav_file_cursor fileCursor) {
-      return fileCursor.cursor < fileCursor.endOfFile;
-    }
     static void *LoadWav_GetChunkData(wav_file_cursor fileCursor) {
       void *result = fileCursor.cursor + sizeof(wav_chunk_header);
       return result;
@@ -105,56 +114,299 @@ namespace automata_engine {
       int result = wavChunkHeader->chunkID;
       return result;
     }
+    enum {
+      Wav_FormatTag_PCM = 0x0001,
+      Wav_FormatTag_MsAdpcm = 0x0002,
+      Wav_FormatTag_Float = 0x0003,
+      Wav_FormatTag_ImaAdpcm = 0x0011,
+      Wav_FormatTag_Extensible = 0xFFFE
+    };
+
+    // NOTE: how the samples in the data chunk are stored. for ADPCM, format is the 16-bit PCM that the blocks
+    // decode to.
+    struct wav_layout_t {
+      audio_format_t format;
+      wav_encoding_t encoding;
+      uint32_t blockSize;
+      uint32_t framesPerBlock;
+    };
+
+    // the predictor coefficient pairs of MS ADPCM, which every encoder writes into the fmt chunk as is.
+    static const int16_t c_msAdpcmCoefs[7][2] = {
+      {256, 0}, {512, -256}, {0, 0}, {192, 64}, {240, 0}, {460, -208}, {392, -232}
+    };
+
+    static uint32_t GetAdpcmHeaderSize(wav_encoding_t encoding, uint32_t channels) {
+      return (encoding == WAV_ENCODING_IMA_ADPCM ? 4 : 7) * channels;
+    }
+
+    static bool LoadWav_ParseAdpcmFmt(const wav_fmt_t *wavfmt, uint32_t chunkSize, wav_layout_t *pLayout) {
+      uint32_t channels = uint16_t(wavfmt->nChannels);
+      uint32_t blockSize = uint16_t(wavfmt->nBlockAlign);
+      if (wavfmt->wBitsPerSample != 4 || (channels != 1 && channels != 2)) return false;
+      uint32_t headerSize = GetAdpcmHeaderSize(pLayout->encoding, channels);
+      if (blockSize <= headerSize) return false;
+      if (pLayout->encoding == WAV_ENCODING_IMA_ADPCM) {
+        // NOTE: past the header, the channels take turns with 4 bytes (8 samples) each.
+        if ((blockSize - headerSize) % (4 * channels)) return false;
+        pLayout->framesPerBlock = 1 + (blockSize - headerSize) * 2 / channels;
+      } else {
+        if ((blockSize - headerSize) * 2 % channels) return false;
+        pLayout->framesPerBlock = 2 + (blockSize - headerSize) * 2 / channels;
+        // NOTE: a custom coefficient table is allowed by the format, but no encoder in use writes one.
+        const uint8_t *extension = (const uint8_t *)wavfmt + 20;
+        if (chunkSize >= 22 + sizeof(c_msAdpcmCoefs)) {
+          if (uint16_t(extension[0] | extension[1] << 8) < 7) return false;
+          if (memcmp(extension + 2, c_msAdpcmCoefs, sizeof(c_msAdpcmCoefs))) return false;
+        }
+      }
+      // the samples per block that the file claims, if it has the extension, must agree with the block size.
+      if (chunkSize >= 20 && wavfmt->cbSize >= 2 && wavfmt->wValidBitsPerSample &&
+          uint16_t(wavfmt->wValidBitsPerSample) != pLayout->framesPerBlock)
+        return false;
+      pLayout->blockSize = blockSize;
+      pLayout->format.sampleRate = uint32_t(wavfmt->nSamplesPerSec);
+      pLayout->format.channels = channels;
+      pLayout->format.bitsPerSample = 16;
+      pLayout->format.bFloat = false;
+      return true;
+    }
+
+    static bool LoadWav_ParseFmt(const wav_fmt_t *wavfmt, uint32_t chunkSize, wav_layout_t *pLayout) {
+      if (chunkSize < 16) return false;
+      *pLayout = {};
+      uint16_t formatTag = uint16_t(wavfmt->wFormatTag);
+      if (formatTag == Wav_FormatTag_ImaAdpcm || formatTag == Wav_FormatTag_MsAdpcm) {
+        pLayout->encoding = (formatTag == Wav_FormatTag_ImaAdpcm) ? WAV_ENCODING_IMA_ADPCM : WAV_ENCODING_MS_ADPCM;
+        return LoadWav_ParseAdpcmFmt(wavfmt, chunkSize, pLayout);
+      }
+      if (formatTag == Wav_FormatTag_Extensible) {
+        // the actual format is the first two bytes of the SubFormat GUID.
+        if (chunkSize < sizeof(wav_fmt_t)) return false;
+        formatTag = *(const uint16_t *)wavfmt->SubFormat;
+      }
+      if (formatTag != Wav_FormatTag_PCM && formatTag != Wav_FormatTag_Float) return false;
+      pLayout->format.sampleRate = uint32_t(wavfmt->nSamplesPerSec);
+      pLayout->format.channels = uint16_t(wavfmt->nChannels);
+      pLayout->format.bitsPerSample = uint16_t(wavfmt->wBitsPerSample);
+      pLayout->format.bFloat = (formatTag == Wav_FormatTag_Float);
+      return true;
+    }
+
+    // NOTE: the data may end partway into the last block, of which only the whole groups of samples are decoded.
+    // the fact chunk, if any, has the true length, without the padding at the end of the last block.
+    static uint32_t GetAdpcmFrameCount(const wav_layout_t &layout, uint32_t dataSize, uint32_t factFrames) {
+      uint32_t channels = layout.format.channels;
+      uint32_t headerSize = GetAdpcmHeaderSize(layout.encoding, channels);
+      uint32_t frames = (dataSize / layout.blockSize) * layout.framesPerBlock;
+      uint32_t rest = dataSize % layout.blockSize;
+      if (rest >= headerSize) {
+        if (layout.encoding == WAV_ENCODING_IMA_ADPCM) frames += 1 + (rest - headerSize) / (4 * channels) * 8;
+        else frames += 2 + (rest - headerSize) * 2 / channels;
+      }
+      if (factFrames && factFrames < frames) frames = factFrames;
+      return frames;
+    }
+
+    // NOTE(Noah): The end of file computation explained: We go ahead by the initial header size,
+    // then add wavHeader->fileSize, which excludes the 4-byte value after it, so we subtract 4 bytes.
+    // The file size in the header is not trusted past the end of what was actually read.
+    static bool LoadWav_ParseFile(loaded_file_t file, wav_layout_t *pLayout, void **pSamples, uint32_t *pSampleDataSize,
+      uint32_t *pFactFrames) {
+      if (file.contentSize < int(sizeof(wav_header_t))) return false;
+      wav_header *wavHeader = (wav_header *)file.contents;
+      if (wavHeader->chunkID != Wav_ChunkID_RIFF || wavHeader->waveID != Wav_ChunkID_WAVE) return false;
+      char *endOfFile = (char *)file.contents + file.contentSize;
+      if (wavHeader->fileSize >= 4 && wavHeader->fileSize - 4 < endOfFile - (char *)(wavHeader + 1))
+        endOfFile = (char *)(wavHeader + 1) + wavHeader->fileSize - 4;
+      bool bFoundFmt = false;
+      *pSamples = nullptr;
+      *pFactFrames = 0;
+      for(
+        wav_file_cursor fileCursor = LoadWav_ParseChunkAt(wavHeader + 1, endOfFile);
+        fileCursor.cursor + sizeof(wav_chunk_header) <= fileCursor.endOfFile;
+        fileCursor = LoadWav_NextChunk(fileCursor)
+      ) {
+        uint32_t chunkSize = uint32_t(LoadWav_GetChunkSize(fileCursor));
+        // NOTE: a truncated data chunk is still played up to where the file ends.
+        uint32_t available = uint32_t(fileCursor.endOfFile - (char *)LoadWav_GetChunkData(fileCursor));
+        if (chunkSize > available) chunkSize = available;
+        switch(LoadWav_GetType(fileCursor)) {
+          case Wav_ChunkID_fmt: {
+            if (!LoadWav_ParseFmt((wav_fmt *)LoadWav_GetChunkData(fileCursor), chunkSize, pLayout)) return false;
+            bFoundFmt = true;
+          } break;
+          case Wav_ChunkID_fact: {
+            if (chunkSize >= 4) *pFactFrames = *(uint32_t *)LoadWav_GetChunkData(fileCursor);
+          } break;
+          case Wav_ChunkID_data: {
+            *pSamples = LoadWav_GetChunkData(fileCursor);
+            *pSampleDataSize = chunkSize;
+          } break;
+          default:
+          // do nothing I guess, lol.
+          break;
+        }
+        if (LoadWav_GetChunkSize(fileCursor) < 0) break;
+      }
+      return bFoundFmt && *pSamples;
+    }
+
+    // NOTE: this walks the same chunks as LoadWav_ParseFile, but reads just the chunk headers and the fmt chunk.
+    bool readWavInfo(const char *fileName, audio_format_t *pFormat, uint32_t *pDataOffset, uint32_t *pDataSize) {
+      wav_header_t wavHeader;
+      if (EM->pfn.readFileRange(fileName, 0, &wavHeader, sizeof(wavHeader)) != sizeof(wavHeader)) return false;
+      if (wavHeader.chunkID != Wav_ChunkID_RIFF || wavHeader.waveID != Wav_ChunkID_WAVE) return false;
+      bool bFoundFmt = false, bFoundData = false;
+      uint64_t endOfFile = uint64_t(uint32_t(wavHeader.fileSize)) + 8;
+      uint64_t at = sizeof(wav_header_t);
+      while (at + sizeof(wav_chunk_header_t) <= endOfFile && !(bFoundFmt && bFoundData)) {
+        wav_chunk_header_t chunk;
+        if (EM->pfn.readFileRange(fileName, at, &chunk, sizeof(chunk)) != sizeof(chunk)) break;
+        uint32_t chunkSize = uint32_t(chunk.chunkSize);
+        if (chunk.chunkID == Wav_ChunkID_fmt) {
+          wav_fmt_t wavfmt = {};
+          uint32_t readSize = math::min(chunkSize, uint32_t(sizeof(wavfmt)));
+          if (EM->pfn.readFileRange(fileName, at + sizeof(chunk), &wavfmt, readSize) != readSize) return false;
+          // NOTE: streams are decoded in chunks of whole frames, which ADPCM blocks are not.
+          wav_layout_t layout;
+          if (!LoadWav_ParseFmt(&wavfmt, readSize, &layout) || layout.encoding != WAV_ENCODING_PCM16) return false;
+          *pFormat = layout.format;
+          bFoundFmt = true;
+        } else if (chunk.chunkID == Wav_ChunkID_data) {
+          *pDataOffset = uint32_t(at + sizeof(chunk));
+          *pDataSize = chunkSize;
+          bFoundData = true;
+        }
+        at += sizeof(chunk) + chunkSize + (chunkSize & 1);
+      }
+      return bFoundFmt && bFoundData;
+    }
+
     // TODO(Noah): Use stb_vorbis for .ogg file parsing. Prob going to be better (compressed?)
-    // TODO(Noah): Think about failure cases for load file err.
-    loaded_wav_t loadWav(const char *fileName) {
+    loaded_wav_t loadWav(const char *fileName) { return loadWav(fileName, RESAMPLE_QUALITY_DEFAULT); }
+
+    loaded_wav_t loadWav(const char *fileName, resample_quality_t quality, bool bKeepCompressed) {
       loaded_wav_t wavFile = {};
-        loaded_file_t fileResult = EM->pfn.readEntireFile(fileName);
-      wavFile.parentFile = fileResult;
-      if (fileResult.contentSize != 0 ) {
-        wav_header *wavHeader = (wav_header *)fileResult.contents;
-        assert(wavHeader->chunkID == Wav_ChunkID_RIFF);
-        assert(wavHeader->waveID == Wav_ChunkID_WAVE);
-        // NOTE(Noah): The end of file computation explained: We go ahead by the initial header size, 
-        // then add wavHeader->fileSize, which excludes the 4-byte value after it, so we subtract 4 bytes.
-        short *samples = 0;
-        int channels = 0;
-        int sampleDataSize = 0;
-        for(    
-          wav_file_cursor fileCursor = LoadWav_ParseChunkAt(wavHeader + 1, 
-            (char *)(wavHeader + 1) + wavHeader->fileSize - 4);
-          LoadWav_IsFileCursorValid(fileCursor);
-          fileCursor = LoadWav_NextChunk(fileCursor) 
-        ) {
-          switch(LoadWav_GetType(fileCursor)) {
-            case Wav_ChunkID_fmt: {
-              wav_fmt *wavfmt = (wav_fmt *)LoadWav_GetChunkData(fileCursor);
-              assert(wavfmt->wFormatTag == 1);
-              assert(wavfmt->nSamplesPerSec == ENGINE_DESIRED_SAMPLES_PER_SECOND);
-              assert(wavfmt->wBitsPerSample == 16);
-              channels = wavfmt->nChannels;
-            } break;
-            case Wav_ChunkID_data: {
-              samples = (short *)LoadWav_GetChunkData(fileCursor);
-              sampleDataSize = LoadWav_GetChunkSize(fileCursor);
-            } break;
-            default:
-            // do nothing I guess, lol.
-            break;
+      loaded_file_t fileResult = EM->pfn.readEntireFile(fileName);
+      if (fileResult.contentSize == 0) {
+        EM->pfn.freeLoadedFile(fileResult);
+        return wavFile;
+      }
+      wav_layout_t layout = {};
+      void *samples = nullptr;
+      uint32_t sampleDataSize = 0, factFrames = 0;
+      audio_converter_t *converter = nullptr;
+      bool bParsed = LoadWav_ParseFile(fileResult, &layout, &samples, &sampleDataSize, &factFrames);
+      if (bParsed && layout.encoding != WAV_ENCODING_PCM16) {
+        wavFile.sampleCount = int(GetAdpcmFrameCount(layout, sampleDataSize, factFrames));
+        wavFile.channels = int(layout.format.channels);
+        wavFile.encoding = layout.encoding;
+        wavFile.blockData = (const uint8_t *)samples;
+        wavFile.blockSize = layout.blockSize;
+        wavFile.framesPerBlock = layout.framesPerBlock;
+        bParsed = wavFile.sampleCount > 0;
+        // NOTE: the blocks are only kept when the voice can play them without a resampler.
+        if (bParsed && bKeepCompressed && layout.format.sampleRate == ENGINE_DESIRED_SAMPLES_PER_SECOND) {
+          wavFile.parentFile = fileResult;
+          return wavFile;
+        }
+        if (bParsed) {
+          // otherwise the blocks are decoded up front, after which the sound is like any other 16-bit stereo file.
+          uint32_t blockCount = (uint32_t(wavFile.sampleCount) + layout.framesPerBlock - 1) / layout.framesPerBlock;
+          uint32_t decodedSize = blockCount * layout.framesPerBlock * 2 * sizeof(int16_t);
+          int16_t *decoded = (int16_t *)EM->pfn.alloc(decodedSize);
+          if (!decoded) {
+            AELoggerError("unable to allocate the decoded samples of %s", fileName);
+            EM->pfn.freeLoadedFile(fileResult);
+            return {};
           }
+          decodeWavBlocks(wavFile, 0, blockCount, decoded);
+          samples = decoded;
+          sampleDataSize = uint32_t(wavFile.sampleCount) * 2 * sizeof(int16_t);
+          layout.format.channels = 2;
+          wavFile = {};
+          // the decoded samples take the place of the file, as converted samples do below.
+          EM->pfn.freeLoadedFile(fileResult);
+          fileResult.contents = decoded;
+          fileResult.contentSize = int(decodedSize);
         }
-        assert((channels && samples && sampleDataSize));
-        wavFile.sampleCount = sampleDataSize / (channels * sizeof(short));
-        wavFile.channels = channels;
-        if (channels != 2) {
-            assert(!"Unsupported Channel type!");
-        } else {
-          wavFile.sampleData = samples;
+      }
+      const audio_format_t &format = layout.format;
+      if (bParsed) {
+        // NOTE: files already in the mix format are played straight out of the loaded file.
+        if (!format.bFloat && format.bitsPerSample == 16 && format.channels == 2 &&
+            format.sampleRate == ENGINE_DESIRED_SAMPLES_PER_SECOND) {
+          wavFile.sampleCount = sampleDataSize / (2 * sizeof(short));
+          wavFile.channels = 2;
+          wavFile.sampleData = (short *)samples;
+          wavFile.parentFile = fileResult;
+          return wavFile;
         }
+        converter = createAudioConverter(format, quality);
+      }
+      if (!converter) {
+        AELoggerError("unable to load %s. the .WAV file is malformed or of an unsupported format.", fileName);
+        EM->pfn.freeLoadedFile(fileResult);
+        return wavFile;
       }
+
+      uint32_t frameCount = sampleDataSize / (format.channels * (format.bitsPerSample / 8));
+      uint32_t maxFrames = getMaxConvertedFrames(converter, frameCount);
+      int16_t *converted = (int16_t *)EM->pfn.alloc(maxFrames * 2 * sizeof(int16_t));
+      if (converted) {
+        uint32_t outFrames = convertAudio(converter, samples, frameCount, converted);
+        outFrames += flushAudioConverter(converter, converted + size_t(outFrames) * 2);
+        wavFile.sampleCount = int(outFrames);
+        wavFile.channels = 2;
+        wavFile.sampleData = converted;
+        // NOTE: both alloc and readEntireFile memory are freed the same way, so the converted samples take the
+        // place of the file. freeWav then does not need to know whether there was a conversion.
+        wavFile.parentFile.fileName = fileResult.fileName;
+        wavFile.parentFile.contents = converted;
+        wavFile.parentFile.contentSize = int(maxFrames * 2 * sizeof(int16_t));
+      } else {
+        AELoggerError("unable to allocate the converted samples of %s", fileName);
+      }
+      destroyAudioConverter(converter);
+      EM->pfn.freeLoadedFile(fileResult);
       return wavFile;
     }
 
+    bool writeWav(const char *fileName, const int16_t *frames, uint32_t frameCount) {
+      uint32_t dataSize = frameCount * 2 * sizeof(int16_t);
+      uint32_t fmtSize = 16;
+      uint32_t fileSize = uint32_t(sizeof(wav_header_t) + 2 * sizeof(wav_chunk_header_t)) + fmtSize + dataSize;
+      uint8_t *file = (uint8_t *)EM->pfn.alloc(fileSize);
+      if (!file) {
+        AELoggerError("unable to allocate %u bytes to write %s", fileSize, fileName);
+        return false;
+      }
+      uint8_t *at = file;
+      wav_header_t header = { Wav_ChunkID_RIFF, int(fileSize - 8), Wav_ChunkID_WAVE };
+      memcpy(at, &header, sizeof(header));
+      at += sizeof(header);
+      wav_chunk_header_t chunk = { Wav_ChunkID_fmt, int(fmtSize) };
+      memcpy(at, &chunk, sizeof(chunk));
+      at += sizeof(chunk);
+      wav_fmt_t wavfmt = {};
+      wavfmt.wFormatTag = Wav_FormatTag_PCM;
+      wavfmt.nChannels = 2;
+      wavfmt.nSamplesPerSec = int(ENGINE_DESIRED_SAMPLES_PER_SECOND);
+      wavfmt.nBlockAlign = 2 * sizeof(int16_t);
+      wavfmt.nAvgBytesPerSec = wavfmt.nSamplesPerSec * wavfmt.nBlockAlign;
+      wavfmt.wBitsPerSample = 16;
+      memcpy(at, &wavfmt, fmtSize);
+      at += fmtSize;
+      chunk = { Wav_ChunkID_data, int(dataSize) };
+      memcpy(at, &chunk, sizeof(chunk));
+      at += sizeof(chunk);
+      if (dataSize) memcpy(at, frames, dataSize);
+      bool bResult = EM->pfn.writeEntireFile(fileName, file, fileSize);
+      EM->pfn.free(file);
+      return bResult;
+    }
+
     loaded_image_t loadBMP(const char *path) {
       loaded_image_t bitmap = {};
       // bitmap.scale = 1;
@@ -194,6 +446,84 @@ namespace automata_engine {
       return bitmap;
     }
 
+    // NOTE: copy width x height 0xABGR pixels from src to dst, optionally reversing the row order and swapping the
+    // R and B channels. rows are processed four pixels at a time with a scalar tail.
+    static void CopyImagePixels(uint32_t *dst, const uint32_t *src, uint32_t width, uint32_t height,
+      bool bFlipVertically, bool bSwizzleRB)
+    {
+      const __m128i maskRB = _mm_set1_epi32(0x00FF00FF);
+      const __m128i maskAG = _mm_set1_epi32((int)0xFF00FF00);
+      for (uint32_t y = 0; y < height; y++) {
+        const uint32_t *srcRow = src + size_t(y) * width;
+        uint32_t *dstRow = dst + size_t(bFlipVertically ? (height - 1 - y) : y) * width;
+        uint32_t x = 0;
+        if (bSwizzleRB) {
+          for (; x + 4 <= width; x += 4) {
+            __m128i p  = _mm_loadu_si128((const __m128i *)(srcRow + x));
+            __m128i rb = _mm_and_si128(p, maskRB);
+            // the R and B bytes sit in the low byte of each 16-bit half, so a 16-bit lane rotate swaps them.
+            rb = _mm_shufflehi_epi16(_mm_shufflelo_epi16(rb, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+            _mm_storeu_si128((__m128i *)(dstRow + x), _mm_or_si128(rb, _mm_and_si128(p, maskAG)));
+          }
+          for (; x < width; x++) {
+            uint32_t p = srcRow[x];
+            dstRow[x] = (p & 0xFF00FF00) | ((p >> 16) & 0xFF) | ((p & 0xFF) << 16);
+          }
+        } else {
+          for (; x + 4 <= width; x += 4)
+            _mm_storeu_si128((__m128i *)(dstRow + x), _mm_loadu_si128((const __m128i *)(srcRow + x)));
+          for (; x < width; x++) dstRow[x] = srcRow[x];
+        }
+      }
+    }
+
+    static loaded_image_t LoadImageFromFile(const char *path, bool bFlipVertically, bool bSwizzleRB)
+    {
+      loaded_image_t image = {};
+      loaded_file_t file = EM->pfn.readEntireFile(path);
+      if (!file.contents) {
+        AELoggerError("loadImages failed to read '%s'", path);
+        return image;
+      }
+      defer(EM->pfn.freeLoadedFile(file));
+
+      // NOTE: the flip is done by CopyImagePixels rather than by stb_image. the stb_image flag is global, and
+      // images in the same batch may run on any thread. so here we only turn it off for this thread.
+      stbi_set_flip_vertically_on_load_thread(0);
+      int x, y, n;
+      stbi_uc *data = stbi_load_from_memory((stbi_uc *)file.contents, (int)file.contentSize, &x, &y, &n, 4);
+      if (!data) {
+        AELoggerError("loadImages failed to decode '%s': %s", path, stbi_failure_reason());
+        return image;
+      }
+      defer(stbi_image_free(data));
+
+      // NOTE: the pixels are copied into engine memory since that is what freeLoadedImage releases.
+      uint32_t *pixels = (uint32_t *)EM->pfn.alloc(size_t(x) * size_t(y) * sizeof(uint32_t));
+      if (!pixels) {
+        AELoggerError("loadImages failed to alloc %dx%d pixels for '%s'", x, y, path);
+        return image;
+      }
+      CopyImagePixels(pixels, (const uint32_t *)data, x, y, bFlipVertically, bSwizzleRB);
+      image.pixelPointer = pixels;
+      image.width = x;
+      image.height = y;
+      return image;
+    }
+
+    uint32_t loadImages(const char **paths, uint32_t count, loaded_image_t *out, bool bFlipVertically,
+      bool bSwizzleRB)
+    {
+      std::atomic<uint32_t> loadedCount = 0;
+      jobs::parallelFor(count, 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+          out[i] = LoadImageFromFile(paths[i], bFlipVertically, bSwizzleRB);
+          if (out[i].pixelPointer) loadedCount++;
+        }
+      });
+      return loadedCount.load();
+    }
+
     void freeObj(raw_model_t obj) {
       StretchyBufferFree(obj.vertexData);
       StretchyBufferFree(obj.indexData);
@@ -343,5 +673,674 @@ namespace automata_engine {
       }     
       return rawModel;
     }
+
+    // NOTE: a filter kernel for resampling one axis from srcSize to dstSize. output sample d reads tapCount source
+    // samples starting at first[d] with weights[d * tapCount + k].
+    struct mip_kernel_t {
+      std::vector<int32_t> first;
+      std::vector<float> weights;
+      uint32_t tapCount;
+    };
+
+    static float Sinc(float x) {
+      if (fabsf(x) < 1e-5f) return 1.f;
+      x *= PI;
+      return sinf(x) / x;
+    }
+
+    // modified Bessel function of the first kind, order zero. used by the Kaiser window.
+    static float BesselI0(float x) {
+      float sum = 1.f, term = 1.f;
+      for (uint32_t k = 1; k < 20; k++) {
+        term *= (x / (2.f * k)) * (x / (2.f * k));
+        sum += term;
+      }
+      return sum;
+    }
+
+    // NOTE: the support is the half width of the filter in destination pixels.
+    static float GetMipFilterSupport(mip_filter_t filter) {
+      return (filter == MIP_FILTER_BOX) ? 0.5f : 3.f;
+    }
+
+    static float EvalMipFilter(mip_filter_t filter, float t) {
+      switch (filter) {
+        case MIP_FILTER_BOX:
+          return (t >= -0.5f && t < 0.5f) ? 1.f : 0.f;
+        case MIP_FILTER_KAISER: {
+          // windowed sinc with the Kaiser window of width 3 and alpha 4.
+          const float width = 3.f, alpha = 4.f;
+          if (fabsf(t) >= width) return 0.f;
+          float r = t / width;
+          return Sinc(t) * BesselI0(alpha * sqrtf(1.f - r * r)) / BesselI0(alpha);
+        }
+        case MIP_FILTER_LANCZOS:
+          return (fabsf(t) < 3.f) ? Sinc(t) * Sinc(t / 3.f) : 0.f;
+        default:
+          return 0.f;
+      }
+    }
+
+    static void BuildMipKernel(mip_filter_t filter, uint32_t srcSize, uint32_t dstSize, mip_kernel_t *pKernel) {
+      float scale = float(srcSize) / float(dstSize);
+      float support = GetMipFilterSupport(filter) * scale;
+      pKernel->tapCount = uint32_t(ceilf(support * 2.f)) + 1;
+      pKernel->first.resize(dstSize);
+      pKernel->weights.resize(size_t(dstSize) * pKernel->tapCount);
+      for (uint32_t d = 0; d < dstSize; d++) {
+        // NOTE: centers are in continuous coordinates, where source sample j covers [j, j + 1).
+        float center = (d + 0.5f) * scale;
+        int32_t first = int32_t(floorf(center - support));
+        float *weights = &pKernel->weights[size_t(d) * pKernel->tapCount];
+        float sum = 0.f;
+        for (uint32_t k = 0; k < pKernel->tapCount; k++) {
+          weights[k] = EvalMipFilter(filter, (first + int32_t(k) + 0.5f - center) / scale);
+          sum += weights[k];
+        }
+        for (uint32_t k = 0; k < pKernel->tapCount; k++) weights[k] /= sum;
+        pKernel->first[d] = first;
+      }
+    }
+
+    static float SrgbToLinear(float c) {
+      return (c <= 0.04045f) ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    struct srgb_tables_t {
+      float toLinear[256];
+      // NOTE: toByteThresholds[i] is the linear value halfway between the sRGB bytes i and i + 1.
+      float toByteThresholds[255];
+    };
+
+    static const srgb_tables_t &GetSrgbTables() {
+      static const srgb_tables_t tables = [] {
+        srgb_tables_t t;
+        for (uint32_t i = 0; i < 256; i++) t.toLinear[i] = SrgbToLinear(i / 255.f);
+        for (uint32_t i = 0; i < 255; i++) t.toByteThresholds[i] = SrgbToLinear((i + 0.5f) / 255.f);
+        return t;
+      }();
+      return tables;
+    }
+
+    static uint32_t LinearToSrgbByte(const srgb_tables_t &tables, float c) {
+      // the number of thresholds that c is past is the nearest sRGB byte.
+      uint32_t lo = 0, hi = 255;
+      while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (c > tables.toByteThresholds[mid]) lo = mid + 1;
+        else hi = mid;
+      }
+      return lo;
+    }
+
+    texture::texture_t generateMips(loaded_image_t image, mip_filter_t filter, bool bSRGB) {
+      texture::texture_t texture = texture::createTexture(
+        bSRGB ? texture::TEXTURE_FORMAT_RGBA8_SRGB : texture::TEXTURE_FORMAT_RGBA8, image.width, image.height, 0);
+      if (!texture.data) return texture;
+      memcpy(texture.data, image.pixelPointer, texture.levels[0].size);
+
+      const srgb_tables_t &srgb = GetSrgbTables();
+      const uint32_t rowGrain = 16;
+
+      // NOTE: the filtering is done on linear values with premultiplied alpha so that the color of transparent
+      // pixels does not bleed into their neighbours.
+      std::vector<float> src(size_t(image.width) * image.height * 4), tmp, dst;
+      jobs::parallelFor(image.height, rowGrain, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; y++) {
+          for (uint32_t x = 0; x < image.width; x++) {
+            uint32_t p = image.pixelPointer[size_t(y) * image.width + x];
+            float *out = &src[(size_t(y) * image.width + x) * 4];
+            float a = (p >> 24) / 255.f;
+            for (uint32_t c = 0; c < 3; c++) {
+              uint32_t v = (p >> (c * 8)) & 0xFF;
+              out[c] = (bSRGB ? srgb.toLinear[v] : v / 255.f) * a;
+            }
+            out[3] = a;
+          }
+        }
+      });
+
+      mip_kernel_t kx, ky;
+      for (uint32_t i = 1; i < texture.levelCount; i++) {
+        uint32_t srcW = texture.levels[i - 1].width, srcH = texture.levels[i - 1].height;
+        uint32_t dstW = texture.levels[i].width, dstH = texture.levels[i].height;
+        BuildMipKernel(filter, srcW, dstW, &kx);
+        BuildMipKernel(filter, srcH, dstH, &ky);
+        tmp.resize(size_t(dstW) * srcH * 4);
+        dst.resize(size_t(dstW) * dstH * 4);
+
+        // horizontal pass. each pixel is one SIMD register of RGBA.
+        jobs::parallelFor(srcH, rowGrain, [&](uint32_t begin, uint32_t end) {
+          for (uint32_t y = begin; y < end; y++) {
+            const float *row = &src[size_t(y) * srcW * 4];
+            float *out = &tmp[size_t(y) * dstW * 4];
+            for (uint32_t x = 0; x < dstW; x++) {
+              const float *weights = &kx.weights[size_t(x) * kx.tapCount];
+              __m128 acc = _mm_setzero_ps();
+              for (uint32_t k = 0; k < kx.tapCount; k++) {
+                // NOTE: the edges are clamped.
+                int32_t j = math::max(0, math::min(kx.first[x] + int32_t(k), int32_t(srcW) - 1));
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(row + j * 4), _mm_set1_ps(weights[k])));
+              }
+              _mm_storeu_ps(out + x * 4, acc);
+            }
+          }
+        });
+
+        // vertical pass. a weight applies to a whole row, so this runs across the pixels of the row.
+        jobs::parallelFor(dstH, rowGrain, [&](uint32_t begin, uint32_t end) {
+          for (uint32_t y = begin; y < end; y++) {
+            float *out = &dst[size_t(y) * dstW * 4];
+            const float *weights = &ky.weights[size_t(y) * ky.tapCount];
+            for (uint32_t x = 0; x < dstW * 4; x += 4) _mm_storeu_ps(out + x, _mm_setzero_ps());
+            for (uint32_t k = 0; k < ky.tapCount; k++) {
+              if (weights[k] == 0.f) continue;
+              int32_t j = math::max(0, math::min(ky.first[y] + int32_t(k), int32_t(srcH) - 1));
+              const float *in = &tmp[size_t(j) * dstW * 4];
+              __m128 w = _mm_set1_ps(weights[k]);
+              for (uint32_t x = 0; x < dstW * 4; x += 4)
+                _mm_storeu_ps(out + x, _mm_add_ps(_mm_loadu_ps(out + x), _mm_mul_ps(_mm_loadu_ps(in + x), w)));
+            }
+          }
+        });
+
+        // back to 8 bits. the negative lobes of the sinc filters can overshoot, so values are clamped.
+        uint32_t *pixels = (uint32_t *)(texture.data + texture.levels[i].offset);
+        jobs::parallelFor(dstH, rowGrain, [&](uint32_t begin, uint32_t end) {
+          for (uint32_t y = begin; y < end; y++) {
+            for (uint32_t x = 0; x < dstW; x++) {
+              const float *in = &dst[(size_t(y) * dstW + x) * 4];
+              float a = math::max(0.f, math::min(in[3], 1.f));
+              uint32_t p = uint32_t(a * 255.f + 0.5f) << 24;
+              for (uint32_t c = 0; c < 3; c++) {
+                float v = (a > 0.f) ? math::max(0.f, math::min(in[c] / a, 1.f)) : 0.f;
+                p |= (bSRGB ? LinearToSrgbByte(srgb, v) : uint32_t(v * 255.f + 0.5f)) << (c * 8);
+              }
+              pixels[size_t(y) * dstW + x] = p;
+            }
+          }
+        });
+        src.swap(dst);
+      }
+      return texture;
+    }
+
+    // NOTE: the resampler works on interleaved stereo floats. a kernel row holds each tap twice so that one SIMD
+    // register covers two frames of both channels.
+    struct audio_converter_t {
+      audio_format_t format;
+      uint32_t taps;              // zero when the input is already at the mix rate.
+      uint32_t phaseBits;
+      std::vector<float> kernel;  // (2^phaseBits + 1) rows of taps * 2 weights.
+      uint64_t step;              // input frames per output frame, in 32.32 fixed point.
+      uint64_t position;          // of the next output frame within pending, in 32.32 fixed point.
+      uint64_t framesIn;
+      uint64_t framesOut;
+      std::vector<float> pending; // stereo input that the resampler has not moved past yet.
+      std::vector<float> decoded;
+      std::vector<float> mixed;
+    };
+
+    struct resample_preset_t {
+      uint32_t taps;
+      uint32_t phaseBits;
+      float beta;     // of the Kaiser window.
+      float rolloff;  // cutoff as a fraction of the Nyquist frequency of the slower rate.
+    };
+
+    static const resample_preset_t c_resamplePresets[] = {
+      {8, 6, 5.f, 0.85f},   // RESAMPLE_QUALITY_FAST
+      {24, 8, 7.f, 0.91f},  // RESAMPLE_QUALITY_DEFAULT
+      {64, 9, 9.f, 0.95f}   // RESAMPLE_QUALITY_HIGH
+    };
+
+    static void BuildResampleKernel(audio_converter_t *converter, resample_quality_t quality) {
+      const resample_preset_t &preset = c_resamplePresets[math::min(uint32_t(quality), 2u)];
+      double ratio = double(converter->format.sampleRate) / ENGINE_DESIRED_SAMPLES_PER_SECOND;
+      // NOTE: when downsampling, the kernel is stretched over more input frames so that it filters out
+      // everything above the output Nyquist frequency.
+      float scale = float(math::max(ratio, 1.0));
+      converter->taps = math::align_up(uint32_t(ceilf(preset.taps * scale)), 4);
+      converter->phaseBits = preset.phaseBits;
+      converter->step = uint64_t(ratio * 4294967296.0);
+
+      uint32_t phases = 1u << preset.phaseBits;
+      uint32_t half = converter->taps / 2;
+      float cutoff = preset.rolloff * 0.5f / scale;
+      converter->kernel.resize(size_t(phases + 1) * converter->taps * 2);
+      for (uint32_t p = 0; p <= phases; p++) {
+        float *row = &converter->kernel[size_t(p) * converter->taps * 2];
+        float sum = 0.f;
+        for (uint32_t j = 0; j < converter->taps; j++) {
+          // distance of tap j from the output, which is p / phases of the way past input (half - 1).
+          float x = float(j) - float(half - 1) - float(p) / float(phases);
+          float r = x / float(half);
+          float window = BesselI0(preset.beta * sqrtf(math::max(0.f, 1.f - r * r))) / BesselI0(preset.beta);
+          float w = 2.f * cutoff * Sinc(2.f * cutoff * x) * window;
+          row[j * 2] = row[j * 2 + 1] = w;
+          sum += w;
+        }
+        for (uint32_t j = 0; j < converter->taps * 2; j++) row[j] /= sum;
+      }
+    }
+
+    static void ResetAudioConverter(audio_converter_t *converter) {
+      converter->position = 0;
+      converter->framesIn = 0;
+      converter->framesOut = 0;
+      // NOTE: the first output lines up with the first input frame, so the taps before it see silence.
+      converter->pending.assign(converter->taps ? size_t(converter->taps / 2 - 1) * 2 : 0, 0.f);
+    }
+
+    audio_converter_t *createAudioConverter(const audio_format_t &format, resample_quality_t quality) {
+      bool bSupported = format.sampleRate != 0 &&
+        (format.channels == 1 || format.channels == 2 || format.channels == 4 || format.channels == 6) &&
+        (format.bFloat ? (format.bitsPerSample == 32 || format.bitsPerSample == 64)
+                       : (format.bitsPerSample == 8 || format.bitsPerSample == 16 || format.bitsPerSample == 24 ||
+                         format.bitsPerSample == 32));
+      if (!bSupported) return nullptr;
+      audio_converter_t *converter = new audio_converter_t();
+      converter->format = format;
+      if (format.sampleRate != ENGINE_DESIRED_SAMPLES_PER_SECOND) BuildResampleKernel(converter, quality);
+      ResetAudioConverter(converter);
+      return converter;
+    }
+
+    void destroyAudioConverter(audio_converter_t *converter) { delete converter; }
+
+    // the number of outputs for all the input so far, which is every output that lands before the last input.
+    static uint64_t GetResampledFrameCount(audio_converter_t *converter, uint64_t framesIn) {
+      return (framesIn * ENGINE_DESIRED_SAMPLES_PER_SECOND + converter->format.sampleRate - 1) /
+        converter->format.sampleRate;
+    }
+
+    uint32_t getMaxConvertedFrames(audio_converter_t *converter, uint32_t frameCount) {
+      if (!converter->taps) return frameCount;
+      return uint32_t(GetResampledFrameCount(converter, converter->framesIn + frameCount) - converter->framesOut);
+    }
+
+    // convert interleaved samples of any supported format to floats in [-1, 1).
+    static void DecodeAudioSamples(const audio_format_t &format, const void *src, uint32_t count, float *dst) {
+      uint32_t i = 0;
+      switch (format.bitsPerSample) {
+        case 8: {
+          const uint8_t *in = (const uint8_t *)src;
+          const __m128i bias = _mm_set1_epi16(128);
+          const __m128 scale = _mm_set1_ps(1.f / 128.f);
+          for (; i + 16 <= count; i += 16) {
+            __m128i b = _mm_loadu_si128((const __m128i *)(in + i));
+            __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(b, _mm_setzero_si128()), bias);
+            __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(b, _mm_setzero_si128()), bias);
+            // NOTE: interleaving a 16-bit value with itself and shifting right by 16 sign extends it to 32 bits.
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16)), scale));
+            _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16)), scale));
+            _mm_storeu_ps(dst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16)), scale));
+            _mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16)), scale));
+          }
+          for (; i < count; i++) dst[i] = (int32_t(in[i]) - 128) / 128.f;
+        } break;
+        case 16: {
+          const int16_t *in = (const int16_t *)src;
+          const __m128 scale = _mm_set1_ps(1.f / 32768.f);
+          for (; i + 8 <= count; i += 8) {
+            __m128i s = _mm_loadu_si128((const __m128i *)(in + i));
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16)), scale));
+            _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16)), scale));
+          }
+          for (; i < count; i++) dst[i] = in[i] / 32768.f;
+        } break;
+        case 24: {
+          const uint8_t *in = (const uint8_t *)src;
+          for (; i < count; i++, in += 3)
+            dst[i] = int32_t(uint32_t(in[0]) << 8 | uint32_t(in[1]) << 16 | uint32_t(in[2]) << 24) / 2147483648.f;
+        } break;
+        case 32: {
+          if (format.bFloat) {
+            memcpy(dst, src, count * sizeof(float));
+            break;
+          }
+          const int32_t *in = (const int32_t *)src;
+          const __m128 scale = _mm_set1_ps(1.f / 2147483648.f);
+          for (; i + 4 <= count; i += 4)
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(in + i))), scale));
+          for (; i < count; i++) dst[i] = in[i] / 2147483648.f;
+        } break;
+        case 64: {
+          const double *in = (const double *)src;
+          for (; i < count; i++) dst[i] = float(in[i]);
+        } break;
+      }
+    }
+
+    // up/downmix to interleaved stereo. quad is FL FR BL BR and 5.1 is FL FR C LFE BL BR. the downmix weights are
+    // normalized so that a full scale signal on all channels does not clip. the LFE channel is dropped.
+    static void MixToStereo(uint32_t channels, const float *src, uint32_t frameCount, float *dst) {
+      uint32_t i = 0;
+      switch (channels) {
+        case 1:
+          for (; i + 4 <= frameCount; i += 4) {
+            __m128 m = _mm_loadu_ps(src + i);
+            _mm_storeu_ps(dst + i * 2, _mm_unpacklo_ps(m, m));
+            _mm_storeu_ps(dst + i * 2 + 4, _mm_unpackhi_ps(m, m));
+          }
+          for (; i < frameCount; i++) dst[i * 2] = dst[i * 2 + 1] = src[i];
+          break;
+        case 2:
+          memcpy(dst, src, size_t(frameCount) * 2 * sizeof(float));
+          break;
+        case 4: {
+          const float side = 0.7071068f, norm = 1.f / (1.f + side);
+          for (; i < frameCount; i++, src += 4) {
+            dst[i * 2] = (src[0] + side * src[2]) * norm;
+            dst[i * 2 + 1] = (src[1] + side * src[3]) * norm;
+          }
+        } break;
+        case 6: {
+          const float side = 0.7071068f, norm = 1.f / (1.f + 2.f * side);
+          for (; i < frameCount; i++, src += 6) {
+            dst[i * 2] = (src[0] + side * (src[2] + src[4])) * norm;
+            dst[i * 2 + 1] = (src[1] + side * (src[2] + src[5])) * norm;
+          }
+        } break;
+      }
+    }
+
+    // the samples are rounded and saturated to 16 bits. the scale is the inverse of DecodeAudioSamples so that
+    // 16-bit input passes through unchanged.
+    static void FloatToInt16(const float *src, uint32_t count, int16_t *dst) {
+      const __m128 scale = _mm_set1_ps(32768.f);
+      uint32_t i = 0;
+      for (; i + 8 <= count; i += 8) {
+        __m128i lo = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i), scale));
+        __m128i hi = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi32(lo, hi));
+      }
+      for (; i < count; i++) {
+        float v = math::max(-32768.f, math::min(src[i] * 32768.f, 32767.f));
+        dst[i] = int16_t(lrintf(v));
+      }
+    }
+
+    // write every output whose taps are all within pending, up to limit outputs in total.
+    static uint32_t Resample(audio_converter_t *converter, uint64_t limit, int16_t *dst) {
+      const uint32_t taps = converter->taps;
+      const uint32_t phaseShift = 32 - converter->phaseBits;
+      const uint32_t pendingFrames = uint32_t(converter->pending.size() / 2);
+      const float *pending = converter->pending.data();
+      converter->mixed.clear();
+      while (converter->framesOut < limit) {
+        uint32_t first = uint32_t(converter->position >> 32);
+        if (first + taps > pendingFrames) break;
+        // NOTE: the fraction is rounded to the nearest phase. the kernel has a row past the last phase for this.
+        uint32_t frac = uint32_t(converter->position);
+        uint32_t phase = uint32_t((uint64_t(frac) + (1ull << (phaseShift - 1))) >> phaseShift);
+        const float *w = &converter->kernel[size_t(phase) * taps * 2];
+        const float *x = pending + size_t(first) * 2;
+        __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+        for (uint32_t k = 0; k < taps * 2; k += 8) {
+          acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(x + k), _mm_loadu_ps(w + k)));
+          acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(x + k + 4), _mm_loadu_ps(w + k + 4)));
+        }
+        // acc is L R L R. fold the upper pair onto the lower one.
+        __m128 acc = _mm_add_ps(acc0, acc1);
+        acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+        float lr[4];
+        _mm_storeu_ps(lr, acc);
+        converter->mixed.push_back(lr[0]);
+        converter->mixed.push_back(lr[1]);
+        converter->position += converter->step;
+        converter->framesOut++;
+      }
+      uint32_t written = uint32_t(converter->mixed.size() / 2);
+      FloatToInt16(converter->mixed.data(), written * 2, dst);
+
+      // drop the input that no future output reaches.
+      uint32_t consumed = math::min(uint32_t(converter->position >> 32), pendingFrames);
+      converter->pending.erase(converter->pending.begin(), converter->pending.begin() + size_t(consumed) * 2);
+      converter->position -= uint64_t(consumed) << 32;
+      return written;
+    }
+
+    uint32_t convertAudio(audio_converter_t *converter, const void *samples, uint32_t frameCount, int16_t *dst) {
+      const audio_format_t &format = converter->format;
+      float *stereo;
+      if (converter->taps) {
+        size_t at = converter->pending.size();
+        converter->pending.resize(at + size_t(frameCount) * 2);
+        stereo = converter->pending.data() + at;
+      } else {
+        converter->mixed.resize(size_t(frameCount) * 2);
+        stereo = converter->mixed.data();
+      }
+      // NOTE: stereo input is decoded straight into place.
+      if (format.channels == 2) {
+        DecodeAudioSamples(format, samples, frameCount * 2, stereo);
+      } else {
+        converter->decoded.resize(size_t(frameCount) * format.channels);
+        DecodeAudioSamples(format, samples, frameCount * format.channels, converter->decoded.data());
+        MixToStereo(format.channels, converter->decoded.data(), frameCount, stereo);
+      }
+      converter->framesIn += frameCount;
+
+      if (!converter->taps) {
+        FloatToInt16(stereo, frameCount * 2, dst);
+        return frameCount;
+      }
+      return Resample(converter, GetResampledFrameCount(converter, converter->framesIn), dst);
+    }
+
+    uint32_t flushAudioConverter(audio_converter_t *converter, int16_t *dst) {
+      if (!converter->taps) return 0;
+      // silence past the end gives the last outputs all of their taps.
+      converter->pending.resize(converter->pending.size() + size_t(converter->taps) * 2, 0.f);
+      uint32_t written = Resample(converter, GetResampledFrameCount(converter, converter->framesIn), dst);
+      ResetAudioConverter(converter);
+      return written;
+    }
+
+    // NOTE: the predictor of each ADPCM sample depends on the sample before it, so one channel does not vectorize.
+    // independent channels and blocks do, so the decoder runs four lanes side by side, where a lane is one channel
+    // of one block.
+    struct adpcm_lanes_t {
+      uint32_t count;
+      const uint8_t *block[4];
+      uint32_t channel[4];
+      uint32_t frames[4];  // frames of the sound in the block. less than framesPerBlock for a partial last block.
+      int16_t *dst[4];     // the first frame of the block in the output, offset to the lane's channel.
+    };
+
+    static const int16_t c_imaStepTable[89] = {
+      7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97,
+      107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+      876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428,
+      4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385,
+      24623, 27086, 29794, 32767
+    };
+
+    static const int32_t c_msAdpcmAdapt[16] = {
+      230, 230, 230, 230, 307, 409, 512, 614, 768, 614, 512, 409, 307, 230, 230, 230
+    };
+
+    static int32_t ReadInt16(const uint8_t *src) { return int16_t(src[0] | src[1] << 8); }
+
+    static __m128i SaturateInt16(__m128i v) {
+      __m128i packed = _mm_packs_epi32(v, v);
+      return _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+    }
+
+    // lanes of a mono sound write both channels of the output.
+    static void StoreAdpcmLanes(const adpcm_lanes_t &lanes, bool bMono, uint32_t frame, __m128i samples) {
+      alignas(16) int32_t values[4];
+      _mm_store_si128((__m128i *)values, samples);
+      for (uint32_t l = 0; l < lanes.count; l++) {
+        int16_t *dst = lanes.dst[l] + size_t(frame) * 2;
+        dst[0] = int16_t(values[l]);
+        if (bMono) dst[1] = int16_t(values[l]);
+      }
+    }
+
+    static void DecodeImaAdpcmLanes(const adpcm_lanes_t &lanes, uint32_t channels, uint32_t framesPerBlock) {
+      alignas(16) int32_t predictor[4] = {}, index[4] = {};
+      uint32_t groups[4] = {};
+      for (uint32_t l = 0; l < lanes.count; l++) {
+        const uint8_t *header = lanes.block[l] + 4 * lanes.channel[l];
+        predictor[l] = ReadInt16(header);
+        index[l] = math::min(int32_t(header[2]), 88);
+        groups[l] = (lanes.frames[l] - 1 + 7) / 8;
+      }
+      bool bMono = (channels == 1);
+      __m128i vPredictor = _mm_load_si128((const __m128i *)predictor);
+      __m128i vIndex = _mm_load_si128((const __m128i *)index);
+      StoreAdpcmLanes(lanes, bMono, 0, vPredictor);
+
+      const __m128i one = _mm_set1_epi32(1), two = _mm_set1_epi32(2), three = _mm_set1_epi32(3);
+      const __m128i four = _mm_set1_epi32(4), eight = _mm_set1_epi32(8), fifteen = _mm_set1_epi32(15);
+      const __m128i maxIndex = _mm_set1_epi32(88), minusOne = _mm_set1_epi32(-1);
+      uint32_t groupCount = (framesPerBlock - 1) / 8;
+      for (uint32_t g = 0; g < groupCount; g++) {
+        // each lane has 4 bytes (8 nibbles, low nibble first) per group, so one 32-bit word feeds 8 samples.
+        alignas(16) uint32_t words[4] = {};
+        for (uint32_t l = 0; l < lanes.count; l++) {
+          if (g < groups[l])
+            memcpy(&words[l], lanes.block[l] + 4 * channels + (size_t(g) * channels + lanes.channel[l]) * 4, 4);
+        }
+        __m128i vWords = _mm_load_si128((const __m128i *)words);
+        for (uint32_t k = 0; k < 8; k++) {
+          __m128i nibble = _mm_and_si128(vWords, fifteen);
+          vWords = _mm_srli_epi32(vWords, 4);
+          // NOTE: SSE2 has no gather, so the step table is read per lane.
+          _mm_store_si128((__m128i *)index, vIndex);
+          __m128i step = _mm_setr_epi32(c_imaStepTable[index[0]], c_imaStepTable[index[1]],
+            c_imaStepTable[index[2]], c_imaStepTable[index[3]]);
+
+          __m128i diff = _mm_srai_epi32(step, 3);
+          __m128i bit4 = _mm_cmpeq_epi32(_mm_and_si128(nibble, four), four);
+          __m128i bit2 = _mm_cmpeq_epi32(_mm_and_si128(nibble, two), two);
+          __m128i bit1 = _mm_cmpeq_epi32(_mm_and_si128(nibble, one), one);
+          __m128i sign = _mm_cmpeq_epi32(_mm_and_si128(nibble, eight), eight);
+          diff = _mm_add_epi32(diff, _mm_and_si128(bit4, step));
+          diff = _mm_add_epi32(diff, _mm_and_si128(bit2, _mm_srai_epi32(step, 1)));
+          diff = _mm_add_epi32(diff, _mm_and_si128(bit1, _mm_srai_epi32(step, 2)));
+          diff = _mm_sub_epi32(_mm_xor_si128(diff, sign), sign);
+          vPredictor = SaturateInt16(_mm_add_epi32(vPredictor, diff));
+
+          // the index table is -1 for magnitudes 0 to 3 and 2, 4, 6, 8 for magnitudes 4 to 7.
+          __m128i indexUp = _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(nibble, three), 1), two);
+          vIndex = _mm_add_epi32(vIndex, _mm_or_si128(_mm_and_si128(bit4, indexUp), _mm_andnot_si128(bit4, minusOne)));
+          vIndex = _mm_and_si128(vIndex, _mm_cmpgt_epi32(vIndex, minusOne));
+          __m128i over = _mm_cmpgt_epi32(vIndex, maxIndex);
+          vIndex = _mm_or_si128(_mm_andnot_si128(over, vIndex), _mm_and_si128(over, maxIndex));
+
+          StoreAdpcmLanes(lanes, bMono, 1 + g * 8 + k, vPredictor);
+        }
+      }
+    }
+
+    // MS ADPCM stores the nibbles high first, with the channels interleaved. this gathers the 8 nibbles of a lane
+    // from sample first on into a word, low nibble first, as IMA ADPCM stores them.
+    static uint32_t GetMsAdpcmNibbles(const adpcm_lanes_t &lanes, uint32_t l, uint32_t channels, uint32_t first) {
+      // NOTE: the fact chunk may end the sound within the header of the last block.
+      uint32_t frames = math::max(lanes.frames[l], 2u);
+      uint32_t available = ((frames - 2) * channels + 1) / 2;
+      uint32_t offset = first * channels / 2;
+      uint8_t bytes[8] = {};
+      for (uint32_t i = 0; i < 4 * channels && offset + i < available; i++)
+        bytes[i] = lanes.block[l][7 * channels + offset + i];
+      uint64_t x;
+      memcpy(&x, bytes, 8);
+      if (channels == 1) {
+        uint32_t w = uint32_t(x);
+        return ((w >> 4) & 0x0F0F0F0F) | ((w & 0x0F0F0F0F) << 4);
+      }
+      // each byte holds one frame. keep the lane's nibble of each, then pack the 8 nibbles together.
+      x = (lanes.channel[l] == 0) ? (x >> 4) & 0x0F0F0F0F0F0F0F0Full : x & 0x0F0F0F0F0F0F0F0Full;
+      x = (x | (x >> 4)) & 0x00FF00FF00FF00FFull;
+      x = (x | (x >> 8)) & 0x0000FFFF0000FFFFull;
+      return uint32_t(x | (x >> 16));
+    }
+
+    static void DecodeMsAdpcmLanes(const adpcm_lanes_t &lanes, uint32_t channels, uint32_t framesPerBlock) {
+      alignas(16) int32_t coefs[4] = {}, delta[4] = {}, sample1[4] = {}, sample2[4] = {};
+      for (uint32_t l = 0; l < lanes.count; l++) {
+        const uint8_t *block = lanes.block[l];
+        uint32_t c = lanes.channel[l];
+        const int16_t *pair = c_msAdpcmCoefs[math::min(uint32_t(block[c]), 6u)];
+        // the pair is packed so that one madd computes sample1 * coef1 + sample2 * coef2.
+        coefs[l] = int32_t(uint16_t(pair[0]) | uint32_t(uint16_t(pair[1])) << 16);
+        delta[l] = math::max(16, ReadInt16(block + channels + 2 * c));
+        sample1[l] = ReadInt16(block + 3 * channels + 2 * c);
+        sample2[l] = ReadInt16(block + 5 * channels + 2 * c);
+      }
+      bool bMono = (channels == 1);
+      __m128i vCoefs = _mm_load_si128((const __m128i *)coefs);
+      __m128i vDelta = _mm_load_si128((const __m128i *)delta);
+      __m128i vSample1 = _mm_load_si128((const __m128i *)sample1);
+      __m128i vSample2 = _mm_load_si128((const __m128i *)sample2);
+      StoreAdpcmLanes(lanes, bMono, 0, vSample2);
+      StoreAdpcmLanes(lanes, bMono, 1, vSample1);
+
+      const __m128i lowHalf = _mm_set1_epi32(0xFFFF), fifteen = _mm_set1_epi32(15);
+      const __m128i minDelta = _mm_set1_epi32(16), maxDelta = _mm_set1_epi32(0x7FFF);
+      uint32_t sampleCount = framesPerBlock - 2;
+      for (uint32_t j = 0; j < sampleCount; j += 8) {
+        alignas(16) uint32_t words[4] = {};
+        for (uint32_t l = 0; l < lanes.count; l++) words[l] = GetMsAdpcmNibbles(lanes, l, channels, j);
+        __m128i vWords = _mm_load_si128((const __m128i *)words);
+        for (uint32_t k = 0; k < 8 && j + k < sampleCount; k++) {
+          __m128i nibble = _mm_and_si128(vWords, fifteen);
+          vWords = _mm_srli_epi32(vWords, 4);
+          __m128i signedNibble = _mm_srai_epi32(_mm_slli_epi32(nibble, 28), 28);
+
+          __m128i samples = _mm_or_si128(_mm_and_si128(vSample1, lowHalf), _mm_slli_epi32(vSample2, 16));
+          __m128i predictor = _mm_srai_epi32(_mm_madd_epi16(samples, vCoefs), 8);
+          predictor = _mm_add_epi32(predictor, _mm_madd_epi16(_mm_and_si128(signedNibble, lowHalf), vDelta));
+          predictor = SaturateInt16(predictor);
+          vSample2 = vSample1;
+          vSample1 = predictor;
+
+          // NOTE: the delta is kept within 16 bits so that it works with madd. valid streams never reach the limit.
+          alignas(16) int32_t nibbles[4];
+          _mm_store_si128((__m128i *)nibbles, nibble);
+          __m128i adapt = _mm_setr_epi32(c_msAdpcmAdapt[nibbles[0]], c_msAdpcmAdapt[nibbles[1]],
+            c_msAdpcmAdapt[nibbles[2]], c_msAdpcmAdapt[nibbles[3]]);
+          vDelta = _mm_srai_epi32(_mm_madd_epi16(adapt, vDelta), 8);
+          __m128i under = _mm_cmpgt_epi32(minDelta, vDelta);
+          vDelta = _mm_or_si128(_mm_andnot_si128(under, vDelta), _mm_and_si128(under, minDelta));
+          __m128i over = _mm_cmpgt_epi32(vDelta, maxDelta);
+          vDelta = _mm_or_si128(_mm_andnot_si128(over, vDelta), _mm_and_si128(over, maxDelta));
+
+          StoreAdpcmLanes(lanes, bMono, 2 + j + k, predictor);
+        }
+      }
+    }
+
+    uint32_t decodeWavBlocks(const loaded_wav_t &wav, uint32_t firstBlock, uint32_t blockCount, int16_t *dst) {
+      if (wav.encoding == WAV_ENCODING_PCM16 || !wav.blockData || !wav.framesPerBlock || wav.sampleCount <= 0)
+        return 0;
+      uint32_t framesPerBlock = wav.framesPerBlock;
+      uint32_t channels = uint32_t(wav.channels);
+      uint32_t frameCount = uint32_t(wav.sampleCount);
+      uint32_t totalBlocks = (frameCount + framesPerBlock - 1) / framesPerBlock;
+      if (firstBlock >= totalBlocks) return 0;
+      blockCount = math::min(blockCount, totalBlocks - firstBlock);
+
+      uint32_t blocksPerPass = 4 / channels;
+      for (uint32_t b = 0; b < blockCount; b += blocksPerPass) {
+        adpcm_lanes_t lanes = {};
+        for (uint32_t i = b; i < math::min(b + blocksPerPass, blockCount); i++) {
+          uint32_t block = firstBlock + i;
+          for (uint32_t c = 0; c < channels; c++) {
+            uint32_t l = lanes.count++;
+            lanes.block[l] = wav.blockData + size_t(block) * wav.blockSize;
+            lanes.channel[l] = c;
+            lanes.frames[l] = math::min(framesPerBlock, frameCount - block * framesPerBlock);
+            lanes.dst[l] = dst + size_t(i) * framesPerBlock * 2 + (channels == 2 ? c : 0);
+          }
+        }
+        if (wav.encoding == WAV_ENCODING_IMA_ADPCM) DecodeImaAdpcmLanes(lanes, channels, framesPerBlock);
+        else DecodeMsAdpcmLanes(lanes, channels, framesPerBlock);
+      }
+      return math::min(blockCount * framesPerBlock, frameCount - firstBlock * framesPerBlock);
+    }
   }
-}
\ No newline at end of file
+}
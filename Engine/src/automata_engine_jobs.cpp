@@ -0,0 +1,148 @@
+#include <automata_engine.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace automata_engine {
+    namespace jobs {
+
+        struct job_pool_t {
+            std::vector<std::thread>          workers;
+            std::deque<std::function<void()>> queue;
+            std::mutex                        mutex;
+            std::condition_variable           cv;
+            bool                              bStop;
+        };
+
+        // NOTE: the pool is created on first use rather than at module init so that games that never submit a job
+        // never pay for the threads.
+        static std::mutex  g_poolMutex;
+        static job_pool_t *g_pool = nullptr;
+
+        static void WorkerMain(job_pool_t *pool)
+        {
+            while (true) {
+                std::function<void()> job;
+                {
+                    std::unique_lock<std::mutex> lock(pool->mutex);
+                    pool->cv.wait(lock, [pool] { return pool->bStop || !pool->queue.empty(); });
+                    // NOTE: the queue is drained before the workers exit.
+                    if (pool->queue.empty()) return;
+                    job = std::move(pool->queue.front());
+                    pool->queue.pop_front();
+                }
+                job();
+            }
+        }
+
+        static job_pool_t *GetPool()
+        {
+            std::lock_guard<std::mutex> lock(g_poolMutex);
+            if (!g_pool) {
+                g_pool           = new job_pool_t();
+                g_pool->bStop    = false;
+                uint32_t hwCount = std::thread::hardware_concurrency();
+                // leave a core for the thread that is submitting the work.
+                uint32_t workerCount = (hwCount > 1) ? hwCount - 1 : 1;
+                for (uint32_t i = 0; i < workerCount; i++) g_pool->workers.emplace_back(WorkerMain, g_pool);
+            }
+            return g_pool;
+        }
+
+        void submit(std::function<void()> job)
+        {
+            job_pool_t *pool = GetPool();
+            {
+                std::lock_guard<std::mutex> lock(pool->mutex);
+                pool->queue.push_back(std::move(job));
+            }
+            pool->cv.notify_one();
+        }
+
+        uint32_t getWorkerCount() { return (uint32_t)GetPool()->workers.size(); }
+
+        struct parallel_for_t {
+            std::function<void(uint32_t, uint32_t)> body;
+            uint32_t                                count;
+            uint32_t                                grainSize;
+            uint32_t                                chunkCount;
+            std::atomic<uint32_t>                   nextChunk;
+            std::atomic<uint32_t>                   doneChunks;
+            std::mutex                              mutex;
+            std::condition_variable                 cv;
+        };
+
+        static void ParallelForWork(parallel_for_t *state)
+        {
+            while (true) {
+                uint32_t chunk = state->nextChunk.fetch_add(1);
+                if (chunk >= state->chunkCount) return;
+                uint32_t begin = chunk * state->grainSize;
+                uint32_t end   = (state->count - begin < state->grainSize) ? state->count : begin + state->grainSize;
+                state->body(begin, end);
+                if (state->doneChunks.fetch_add(1) + 1 == state->chunkCount) {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->cv.notify_all();
+                }
+            }
+        }
+
+        void parallelFor(uint32_t count, uint32_t grainSize, std::function<void(uint32_t begin, uint32_t end)> body)
+        {
+            if (count == 0) return;
+            if (grainSize == 0) grainSize = 1;
+            uint32_t chunkCount = (count + grainSize - 1) / grainSize;
+            if (chunkCount == 1) {
+                body(0, count);
+                return;
+            }
+
+            // NOTE: the state is shared with the helper jobs since a helper may only get to run after the caller has
+            // already finished every chunk and returned. such a helper finds no chunk left and never calls the body.
+            auto state        = std::make_shared<parallel_for_t>();
+            state->body       = std::move(body);
+            state->count      = count;
+            state->grainSize  = grainSize;
+            state->chunkCount = chunkCount;
+            state->nextChunk  = 0;
+            state->doneChunks = 0;
+
+            uint32_t helperCount = getWorkerCount();
+            if (helperCount > chunkCount - 1) helperCount = chunkCount - 1;
+            for (uint32_t i = 0; i < helperCount; i++) submit([state] { ParallelForWork(state.get()); });
+
+            // the calling thread works on chunks too, so this never deadlocks when called from within a job.
+            ParallelForWork(state.get());
+
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->cv.wait(lock, [&state] { return state->doneChunks.load() == state->chunkCount; });
+        }
+
+        void shutdown()
+        {
+            job_pool_t *pool;
+            {
+                std::lock_guard<std::mutex> lock(g_poolMutex);
+                pool = g_pool;
+            }
+            if (!pool) return;
+            {
+                std::lock_guard<std::mutex> lock(pool->mutex);
+                pool->bStop = true;
+            }
+            pool->cv.notify_all();
+            // NOTE: g_pool stays set while draining so that jobs are still able to submit more jobs.
+            for (std::thread &worker : pool->workers) worker.join();
+            {
+                std::lock_guard<std::mutex> lock(g_poolMutex);
+                g_pool = nullptr;
+            }
+            delete pool;
+        }
+
+    }  // namespace jobs
+}  // namespace automata_engine
@@ -0,0 +1,282 @@
+#include <automata_engine.hpp>
+
+#include <automata_engine_utils.hpp>
+
+namespace automata_engine {
+    namespace mesh {
+
+        // NOTE: raw_model_t vertices are (x,y,z, u,v, nx,ny,nz).
+        static constexpr uint32_t RAW_MODEL_VERTEX_STRIDE = 8;
+
+        static constexpr uint8_t MESHLET_NO_LOCAL_VERTEX = 0xFF;
+
+        static math::vec3_t GetModelPosition(const float *vertexData, uint32_t index)
+        {
+            const float *v = vertexData + index * RAW_MODEL_VERTEX_STRIDE;
+            return math::vec3_t(v[0], v[1], v[2]);
+        }
+
+        // compute the bounding sphere and the normal cone of the meshlet that was just finished.
+        static void ComputeMeshletBounds(meshlet_model_t *pResult, meshlet_t *pMeshlet, const float *vertexData)
+        {
+            const uint32_t *vIndices = pResult->vertexIndices + pMeshlet->vertexOffset;
+            const uint8_t  *tIndices = pResult->triangleIndices + pMeshlet->triangleOffset;
+
+            // bounding sphere. the center is the center of the AABB which is good enough for clusters this small.
+            math::vec3_t minP = GetModelPosition(vertexData, vIndices[0]);
+            math::vec3_t maxP = minP;
+            for (uint32_t i = 1; i < pMeshlet->vertexCount; i++) {
+                math::vec3_t p = GetModelPosition(vertexData, vIndices[i]);
+                minP = math::vec3_t(math::min(minP.x, p.x), math::min(minP.y, p.y), math::min(minP.z, p.z));
+                maxP = math::vec3_t(math::max(maxP.x, p.x), math::max(maxP.y, p.y), math::max(maxP.z, p.z));
+            }
+            math::vec3_t center = (minP + maxP) * 0.5f;
+            float        radius = 0.f;
+            for (uint32_t i = 0; i < pMeshlet->vertexCount; i++) {
+                radius = math::max(radius, math::dist(center, GetModelPosition(vertexData, vIndices[i])));
+            }
+            pMeshlet->center = center;
+            pMeshlet->radius = radius;
+
+            // normal cone. see "Optimizing the Graphics Pipeline with Compute", Wihlidal 2016, for the apex form.
+            math::vec3_t normals[MESHLET_MAX_TRIANGLES];
+            uint32_t     normalCount = 0;
+            math::vec3_t axis        = {};
+            for (uint32_t t = 0; t < pMeshlet->triangleCount; t++) {
+                math::vec3_t p0 = GetModelPosition(vertexData, vIndices[tIndices[t * 3 + 0]]);
+                math::vec3_t p1 = GetModelPosition(vertexData, vIndices[tIndices[t * 3 + 1]]);
+                math::vec3_t p2 = GetModelPosition(vertexData, vIndices[tIndices[t * 3 + 2]]);
+                math::vec3_t n  = math::cross(p1 - p0, p2 - p0);
+                float        l  = math::magnitude(n);
+                // NOTE: degenerate triangles are invisible regardless of view direction so they do not constrain
+                // the cone.
+                if (l == 0.f) continue;
+                n                      = n * (1.f / l);
+                normals[normalCount++] = n;
+                axis += n;
+            }
+
+            pMeshlet->coneApex   = center;
+            pMeshlet->coneAxis   = math::vec3_t(0.f, 0.f, 1.f);
+            pMeshlet->coneCutoff = 1.f;
+
+            float axisLength = math::magnitude(axis);
+            if (normalCount == 0 || axisLength == 0.f) return;
+            axis = axis * (1.f / axisLength);
+
+            float minDot = 1.f;
+            for (uint32_t i = 0; i < normalCount; i++) { minDot = math::min(minDot, math::dot(normals[i], axis)); }
+
+            pMeshlet->coneAxis = axis;
+
+            // NOTE: when the normals span more than a hemisphere (or close to it) there is no view direction from
+            // which every triangle is backfacing.
+            if (minDot <= 0.1f) return;
+
+            // push the apex back along the axis until it is behind the plane of every triangle.
+            float maxT = 0.f;
+            for (uint32_t t = 0, i = 0; t < pMeshlet->triangleCount; t++) {
+                math::vec3_t p0 = GetModelPosition(vertexData, vIndices[tIndices[t * 3 + 0]]);
+                math::vec3_t p1 = GetModelPosition(vertexData, vIndices[tIndices[t * 3 + 1]]);
+                math::vec3_t p2 = GetModelPosition(vertexData, vIndices[tIndices[t * 3 + 2]]);
+                if (math::magnitude(math::cross(p1 - p0, p2 - p0)) == 0.f) continue;
+                math::vec3_t n = normals[i++];
+                maxT           = math::max(maxT, math::dot(center - p0, n) / math::dot(axis, n));
+            }
+
+            pMeshlet->coneApex   = center - axis * maxT;
+            pMeshlet->coneCutoff = math::sqrt(1.f - minDot * minDot);
+        }
+
+        meshlet_model_t buildMeshlets(raw_model_t model, uint32_t maxVertices, uint32_t maxTriangles)
+        {
+            assert(maxVertices >= 3 && maxVertices <= MESHLET_MAX_VERTICES);
+            assert(maxTriangles >= 1 && maxTriangles <= MESHLET_MAX_TRIANGLES);
+
+            meshlet_model_t result = {};
+
+            const uint32_t vertexCount   = StretchyBufferCount(model.vertexData) / RAW_MODEL_VERTEX_STRIDE;
+            const uint32_t indexCount    = StretchyBufferCount(model.indexData);
+            const uint32_t triangleCount = indexCount / 3;
+            if (triangleCount == 0 || vertexCount == 0) return result;
+
+            // build the vertex to triangle adjacency in CSR form.
+            uint32_t *adjOffsets = (uint32_t *)calloc(vertexCount + 1, sizeof(uint32_t));
+            uint32_t *adjTris    = (uint32_t *)malloc(sizeof(uint32_t) * triangleCount * 3);
+            uint32_t *liveCounts = (uint32_t *)calloc(vertexCount, sizeof(uint32_t));
+            uint8_t  *localIndex = (uint8_t *)malloc(vertexCount);
+            bool     *bEmitted   = (bool *)calloc(triangleCount, sizeof(bool));
+            defer(free(adjOffsets); free(adjTris); free(liveCounts); free(localIndex); free(bEmitted));
+
+            memset(localIndex, MESHLET_NO_LOCAL_VERTEX, vertexCount);
+
+            for (uint32_t i = 0; i < triangleCount * 3; i++) {
+                assert(model.indexData[i] < vertexCount);
+                liveCounts[model.indexData[i]]++;
+            }
+            for (uint32_t v = 0; v < vertexCount; v++) adjOffsets[v + 1] = adjOffsets[v] + liveCounts[v];
+            {
+                uint32_t *cursor = (uint32_t *)malloc(sizeof(uint32_t) * vertexCount);
+                defer(free(cursor));
+                memcpy(cursor, adjOffsets, sizeof(uint32_t) * vertexCount);
+                for (uint32_t i = 0; i < triangleCount * 3; i++) adjTris[cursor[model.indexData[i]]++] = i / 3;
+            }
+
+            meshlet_t current  = {};
+            uint32_t  seedScan = 0;
+            uint32_t  lastTri  = UINT32_MAX;
+
+            auto flushMeshlet = [&]() {
+                if (current.triangleCount == 0) return;
+                for (uint32_t i = 0; i < current.vertexCount; i++) {
+                    localIndex[result.vertexIndices[current.vertexOffset + i]] = MESHLET_NO_LOCAL_VERTEX;
+                }
+                StretchyBufferPush(result.meshlets, current);
+                ComputeMeshletBounds(&result, &StretchyBufferLast(result.meshlets), model.vertexData);
+                current                = {};
+                current.vertexOffset   = StretchyBufferCount(result.vertexIndices);
+                current.triangleOffset = StretchyBufferCount(result.triangleIndices);
+                lastTri                = UINT32_MAX;
+            };
+
+            // NOTE: a lower score is a better candidate. triangles that add no new vertices are always preferred,
+            // then triangles whose vertices have few remaining triangles so that we do not leave behind islands.
+            auto scoreTriangle = [&](uint32_t tri) -> uint32_t {
+                uint32_t newVerts = 0, live = 0;
+                for (uint32_t k = 0; k < 3; k++) {
+                    uint32_t v = model.indexData[tri * 3 + k];
+                    newVerts += (localIndex[v] == MESHLET_NO_LOCAL_VERTEX) ? 1 : 0;
+                    live += liveCounts[v];
+                }
+                return newVerts * 0x10000 + math::min(live, 0xFFFFu);
+            };
+
+            auto findCandidateAround = [&](uint32_t vertex, uint32_t *pBest, uint32_t *pBestScore) {
+                for (uint32_t a = adjOffsets[vertex]; a < adjOffsets[vertex + 1]; a++) {
+                    uint32_t tri = adjTris[a];
+                    if (bEmitted[tri]) continue;
+                    uint32_t score = scoreTriangle(tri);
+                    if (score < *pBestScore) {
+                        *pBestScore = score;
+                        *pBest      = tri;
+                    }
+                }
+            };
+
+            for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+                uint32_t best = UINT32_MAX, bestScore = UINT32_MAX;
+
+                // first look around the triangle that was just added, then around the whole meshlet.
+                if (lastTri != UINT32_MAX) {
+                    for (uint32_t k = 0; k < 3; k++)
+                        findCandidateAround(model.indexData[lastTri * 3 + k], &best, &bestScore);
+                }
+                if (best == UINT32_MAX) {
+                    for (uint32_t i = 0; i < current.vertexCount; i++)
+                        findCandidateAround(result.vertexIndices[current.vertexOffset + i], &best, &bestScore);
+                }
+                if (best == UINT32_MAX) {
+                    while (bEmitted[seedScan]) seedScan++;
+                    best = seedScan;
+                }
+
+                uint32_t newVerts = 0;
+                for (uint32_t k = 0; k < 3; k++)
+                    newVerts += (localIndex[model.indexData[best * 3 + k]] == MESHLET_NO_LOCAL_VERTEX) ? 1 : 0;
+                if (current.vertexCount + newVerts > maxVertices || current.triangleCount + 1 > maxTriangles) {
+                    flushMeshlet();
+                }
+
+                for (uint32_t k = 0; k < 3; k++) {
+                    uint32_t v = model.indexData[best * 3 + k];
+                    if (localIndex[v] == MESHLET_NO_LOCAL_VERTEX) {
+                        localIndex[v] = (uint8_t)current.vertexCount++;
+                        StretchyBufferPush(result.vertexIndices, v);
+                    }
+                    StretchyBufferPush(result.triangleIndices, localIndex[v]);
+                    liveCounts[v]--;
+                }
+                current.triangleCount++;
+                bEmitted[best] = true;
+                lastTri        = best;
+            }
+            flushMeshlet();
+
+            result.indexCount = triangleCount * 3;
+            return result;
+        }
+
+        void freeMeshlets(meshlet_model_t meshlets)
+        {
+            StretchyBufferFree(meshlets.meshlets);
+            StretchyBufferFree(meshlets.vertexIndices);
+            StretchyBufferFree(meshlets.triangleIndices);
+        }
+
+        uint32_t cullMeshlets(const meshlet_model_t &meshlets,
+            const math::camera_t                    &cam,
+            const math::mat4_t                      &modelMat,
+            uint32_t                                *indicesOut,
+            uint32_t                                *pVisibleOut)
+        {
+            // extract the world space frustum planes from the clip matrix (Gribb & Hartmann).
+            // NOTE: matrices are column-major, so row i is (mat[0][i], mat[1][i], mat[2][i], mat[3][i]).
+            math::mat4_t clip = math::buildProjMat(cam) * math::buildViewMat(cam);
+            auto         row  = [&](int i) {
+                return math::vec4_t(clip.mat[0][i], clip.mat[1][i], clip.mat[2][i], clip.mat[3][i]);
+            };
+            math::vec4_t r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+            math::vec4_t planes[6] = {r3 + r0, r3 + -r0, r3 + r1, r3 + -r1, r3 + r2, r3 + -r2};
+            for (uint32_t i = 0; i < 6; i++) {
+                float l = math::magnitude(math::vec3_t(planes[i]));
+                planes[i] *= 1.f / l;
+            }
+
+            // NOTE: the sphere radius is scaled by the largest axis scale so that it stays conservative under
+            // non-uniform scale. the cone axis is a normal, which only transforms by the model matrix itself when
+            // that is a rotation and a uniform scale. otherwise the cone test is skipped.
+            math::mat4_t m = modelMat;
+            math::vec3_t x = math::vec3_t(m.matv[0]), y = math::vec3_t(m.matv[1]), z = math::vec3_t(m.matv[2]);
+            float        lx = math::magnitude(x), ly = math::magnitude(y), lz = math::magnitude(z);
+            float        radiusScale = math::max(lx, math::max(ly, lz));
+            float        tolerance   = 1e-3f * radiusScale;
+            bool         bConeTest   = fabsf(lx - ly) <= tolerance && fabsf(lx - lz) <= tolerance &&
+                               fabsf(math::dot(x, y)) <= tolerance * radiusScale &&
+                               fabsf(math::dot(x, z)) <= tolerance * radiusScale &&
+                               fabsf(math::dot(y, z)) <= tolerance * radiusScale;
+            math::vec3_t eye = cam.trans.pos;
+
+            uint32_t indexCount   = 0;
+            uint32_t visibleCount = 0;
+            for (uint32_t i = 0; i < (uint32_t)StretchyBufferCount(meshlets.meshlets); i++) {
+                const meshlet_t &meshlet = meshlets.meshlets[i];
+
+                math::vec3_t center = math::vec3_t(m * math::vec4_t(meshlet.center, 1.f));
+                float        radius = meshlet.radius * radiusScale;
+
+                bool bOutside = false;
+                for (uint32_t p = 0; p < 6 && !bOutside; p++) {
+                    bOutside = math::dot(math::vec3_t(planes[p]), center) + planes[p].w < -radius;
+                }
+                if (bOutside) continue;
+
+                if (bConeTest && meshlet.coneCutoff < 1.f) {
+                    math::vec3_t apex = math::vec3_t(m * math::vec4_t(meshlet.coneApex, 1.f));
+                    math::vec3_t axis = math::normalize(math::vec3_t(m * math::vec4_t(meshlet.coneAxis, 0.f)));
+                    if (math::dot(math::normalize(apex - eye), axis) > meshlet.coneCutoff) continue;
+                }
+
+                const uint32_t *vIndices = meshlets.vertexIndices + meshlet.vertexOffset;
+                const uint8_t  *tIndices = meshlets.triangleIndices + meshlet.triangleOffset;
+                for (uint32_t j = 0; j < meshlet.triangleCount * 3; j++) {
+                    indicesOut[indexCount++] = vIndices[tIndices[j]];
+                }
+                visibleCount++;
+            }
+
+            if (pVisibleOut) *pVisibleOut = visibleCount;
+            return indexCount;
+        }
+
+    }  // namespace mesh
+}  // namespace automata_engine
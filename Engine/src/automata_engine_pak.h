@@ -0,0 +1,585 @@
+#ifndef AUTOMATA_ENGINE_PAK_H
+#define AUTOMATA_ENGINE_PAK_H
+
+// NOTE: this is the .aepak packed asset archive. it is shared between the platform layer (which maps the pack
+// and serves readEntireFile from it) and the aepak CLI tool (which builds packs). define AE_PAK_IMPL in exactly
+// one translation unit of each module to get the implementation.
+//
+// Layout of a pack:
+//
+//   pak_header_t
+//   pak_entry_t[entryCount]       sorted by pathHash so that lookup is a binary search.
+//   char names[namesSize]         null-terminated normalized paths, used to resolve hash collisions.
+//   ... entry data, each entry beginning on a PAK_ALIGNMENT boundary ...
+//
+// Everything that is needed to open the pack sits at the front of the file, so opening the pack is a single
+// small read and the entry data can then be streamed in large sequential reads.
+//
+// A compressed entry begins with a uint32_t chunk count followed by a uint32_t stored size per chunk, after which
+// come the chunk payloads back to back. Each chunk decompresses to PAK_CHUNK_SIZE bytes (the last chunk may be
+// shorter). A chunk whose stored size equals its raw size is stored uncompressed. Chunks use the LZ4 block format.
+
+#include <cstdint>
+#include <cstddef>
+
+namespace automata_engine {
+    namespace pak {
+
+        static constexpr uint32_t PAK_MAGIC     = 0x4B504541;  // "AEPK"
+        static constexpr uint32_t PAK_VERSION   = 1;
+        static constexpr uint64_t PAK_ALIGNMENT = 64 * 1024;
+        static constexpr uint32_t PAK_CHUNK_SIZE = 64 * 1024;
+
+        static constexpr uint32_t PAK_ENTRY_COMPRESSED = 1 << 0;
+
+#pragma pack(push, 1)
+        struct pak_header_t {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t entryCount;
+            uint32_t namesSize;
+            uint64_t fileSize;
+        };
+
+        /// @param pathHash   hashPath of the normalized path.
+        /// @param dataOffset offset of the entry data from the start of the pack. always PAK_ALIGNMENT aligned.
+        /// @param storedSize size of the entry data within the pack.
+        /// @param rawSize    size of the file once extracted.
+        /// @param nameOffset offset of the normalized path within the name table.
+        struct pak_entry_t {
+            uint64_t pathHash;
+            uint64_t dataOffset;
+            uint64_t storedSize;
+            uint64_t rawSize;
+            uint32_t nameOffset;
+            uint32_t flags;
+        };
+#pragma pack(pop)
+
+        /// @brief a view of an opened pack. the pack memory is owned by the caller, typically a mapped view.
+        struct pak_t {
+            const uint8_t      *base;
+            uint64_t            size;
+            const pak_header_t *header;
+            const pak_entry_t  *entries;
+            const char         *names;
+        };
+
+        /// @brief hash a path after normalizing it. normalization lowercases the path, converts '/' to '\' and
+        /// strips any leading ".\".
+        uint64_t hashPath(const char *path);
+
+        /// @brief write the normalized form of path into out. returns false if out is too small.
+        bool normalizePath(const char *path, char *out, size_t outSize);
+
+        /// @brief validate the pack memory and setup the pak_t view of it.
+        bool open(pak_t *pPak, const void *memory, uint64_t size);
+
+        /// @brief find the entry for a path. returns nullptr if the path is not within the pack.
+        const pak_entry_t *find(const pak_t &pak, const char *path);
+
+        /// @brief extract an entry into dst, which must have room for entry->rawSize bytes.
+        bool extract(const pak_t &pak, const pak_entry_t *entry, void *dst);
+
+        /// @brief read size bytes of an entry starting at offset into dst. only the chunks of a compressed entry that
+        /// overlap the range are decompressed, so that an entry can be streamed.
+        /// @return the number of bytes read. this is less than size if the range runs past the end of the entry, and
+        /// 0 if the entry is corrupt.
+        uint64_t read(const pak_t &pak, const pak_entry_t *entry, uint64_t offset, void *dst, uint64_t size);
+
+        /// @brief compress src into dst using the LZ4 block format.
+        /// @return the compressed size, or 0 if the result does not fit within dstCapacity.
+        uint32_t lz4Compress(const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity);
+
+        /// @brief decompress an LZ4 block. the input is not trusted.
+        /// @return the decompressed size, or -1 if the block is malformed or does not fit within dstCapacity.
+        int64_t lz4Decompress(const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity);
+
+        /// @brief build a pack from files on disk.
+        /// @param srcPaths  paths of the files to read.
+        /// @param pakPaths  the paths by which the files are looked up within the pack.
+        /// @param bCompress if true, entries are compressed when this saves space.
+        bool writePack(const char *outPath, const char **srcPaths, const char **pakPaths, uint32_t count, bool bCompress);
+
+    }  // namespace pak
+}  // namespace automata_engine
+
+#if defined(AE_PAK_IMPL)
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+namespace automata_engine {
+    namespace pak {
+
+        static char NormalizePathChar(char c)
+        {
+            if (c == '/') return '\\';
+            if (c >= 'A' && c <= 'Z') return c - 'A' + 'a';
+            return c;
+        }
+
+        static const char *SkipPathPrefix(const char *path)
+        {
+            while (path[0] == '.' && (path[1] == '\\' || path[1] == '/')) path += 2;
+            return path;
+        }
+
+        uint64_t hashPath(const char *path)
+        {
+            // FNV-1a.
+            uint64_t hash = 0xcbf29ce484222325ull;
+            for (const char *c = SkipPathPrefix(path); *c; c++) {
+                hash ^= (uint8_t)NormalizePathChar(*c);
+                hash *= 0x100000001b3ull;
+            }
+            return hash;
+        }
+
+        bool normalizePath(const char *path, char *out, size_t outSize)
+        {
+            size_t i = 0;
+            for (const char *c = SkipPathPrefix(path); *c; c++) {
+                if (i + 1 >= outSize) return false;
+                out[i++] = NormalizePathChar(*c);
+            }
+            if (outSize == 0) return false;
+            out[i] = 0;
+            return true;
+        }
+
+        static bool PathsMatch(const char *normalized, const char *path)
+        {
+            path = SkipPathPrefix(path);
+            while (*normalized && *path) {
+                if (*normalized++ != NormalizePathChar(*path++)) return false;
+            }
+            return *normalized == *path;
+        }
+
+        bool open(pak_t *pPak, const void *memory, uint64_t size)
+        {
+            *pPak = {};
+            if (!memory || size < sizeof(pak_header_t)) return false;
+
+            const uint8_t      *base   = (const uint8_t *)memory;
+            const pak_header_t *header = (const pak_header_t *)base;
+            if (header->magic != PAK_MAGIC || header->version != PAK_VERSION || header->fileSize != size) return false;
+
+            uint64_t tocEnd = sizeof(pak_header_t) + uint64_t(header->entryCount) * sizeof(pak_entry_t);
+            if (tocEnd + header->namesSize > size) return false;
+
+            const pak_entry_t *entries = (const pak_entry_t *)(base + sizeof(pak_header_t));
+            for (uint32_t i = 0; i < header->entryCount; i++) {
+                const pak_entry_t &e = entries[i];
+                if (e.dataOffset > size || e.storedSize > size - e.dataOffset) return false;
+                if (e.nameOffset >= header->namesSize) return false;
+                if (i > 0 && entries[i - 1].pathHash > e.pathHash) return false;
+            }
+            // the name table must be terminated so that no name can run off the end.
+            if (header->namesSize && base[tocEnd + header->namesSize - 1] != 0) return false;
+
+            pPak->base    = base;
+            pPak->size    = size;
+            pPak->header  = header;
+            pPak->entries = entries;
+            pPak->names   = (const char *)(base + tocEnd);
+            return true;
+        }
+
+        const pak_entry_t *find(const pak_t &pak, const char *path)
+        {
+            if (!pak.header) return nullptr;
+            uint64_t hash = hashPath(path);
+
+            uint32_t lo = 0, hi = pak.header->entryCount;
+            while (lo < hi) {
+                uint32_t mid = lo + (hi - lo) / 2;
+                if (pak.entries[mid].pathHash < hash) lo = mid + 1;
+                else hi = mid;
+            }
+            // NOTE: entries with equal hashes are adjacent.
+            for (; lo < pak.header->entryCount && pak.entries[lo].pathHash == hash; lo++) {
+                if (PathsMatch(pak.names + pak.entries[lo].nameOffset, path)) return &pak.entries[lo];
+            }
+            return nullptr;
+        }
+
+        bool extract(const pak_t &pak, const pak_entry_t *entry, void *dst)
+        {
+            const uint8_t *data = pak.base + entry->dataOffset;
+            if (!(entry->flags & PAK_ENTRY_COMPRESSED)) {
+                if (entry->storedSize != entry->rawSize) return false;
+                memcpy(dst, data, entry->rawSize);
+                return true;
+            }
+
+            if (entry->storedSize < sizeof(uint32_t)) return false;
+            uint32_t chunkCount = *(const uint32_t *)data;
+            if (chunkCount != (entry->rawSize + PAK_CHUNK_SIZE - 1) / PAK_CHUNK_SIZE) return false;
+            uint64_t tableSize = sizeof(uint32_t) * (1ull + chunkCount);
+            if (tableSize > entry->storedSize) return false;
+
+            const uint32_t *chunkSizes = (const uint32_t *)data + 1;
+            const uint8_t  *src        = data + tableSize;
+            const uint8_t  *srcEnd     = data + entry->storedSize;
+            uint8_t        *out        = (uint8_t *)dst;
+            uint64_t        remaining  = entry->rawSize;
+            for (uint32_t i = 0; i < chunkCount; i++) {
+                uint32_t rawChunk    = (uint32_t)std::min<uint64_t>(remaining, PAK_CHUNK_SIZE);
+                uint32_t storedChunk = chunkSizes[i];
+                if (storedChunk > uint64_t(srcEnd - src)) return false;
+                if (storedChunk == rawChunk) {
+                    memcpy(out, src, rawChunk);
+                } else if (lz4Decompress(src, storedChunk, out, rawChunk) != rawChunk) {
+                    return false;
+                }
+                src += storedChunk;
+                out += rawChunk;
+                remaining -= rawChunk;
+            }
+            return true;
+        }
+
+        uint64_t read(const pak_t &pak, const pak_entry_t *entry, uint64_t offset, void *dst, uint64_t size)
+        {
+            if (offset >= entry->rawSize || size == 0) return 0;
+            size                = std::min(size, entry->rawSize - offset);
+            const uint8_t *data = pak.base + entry->dataOffset;
+            if (!(entry->flags & PAK_ENTRY_COMPRESSED)) {
+                if (entry->storedSize != entry->rawSize) return 0;
+                memcpy(dst, data + offset, size);
+                return size;
+            }
+
+            if (entry->storedSize < sizeof(uint32_t)) return 0;
+            uint32_t chunkCount = *(const uint32_t *)data;
+            if (chunkCount != (entry->rawSize + PAK_CHUNK_SIZE - 1) / PAK_CHUNK_SIZE) return 0;
+            uint64_t tableSize = sizeof(uint32_t) * (1ull + chunkCount);
+            if (tableSize > entry->storedSize) return 0;
+
+            const uint32_t *chunkSizes = (const uint32_t *)data + 1;
+            const uint8_t  *src        = data + tableSize;
+            const uint8_t  *srcEnd     = data + entry->storedSize;
+            uint32_t        first      = uint32_t(offset / PAK_CHUNK_SIZE);
+            uint32_t        last       = uint32_t((offset + size - 1) / PAK_CHUNK_SIZE);
+            for (uint32_t i = 0; i < first; i++) {
+                if (chunkSizes[i] > uint64_t(srcEnd - src)) return 0;
+                src += chunkSizes[i];
+            }
+
+            std::vector<uint8_t> scratch;
+            uint8_t             *out = (uint8_t *)dst;
+            uint64_t             at  = offset;
+            for (uint32_t i = first; i <= last; i++) {
+                uint64_t chunkStart  = uint64_t(i) * PAK_CHUNK_SIZE;
+                uint32_t rawChunk    = (uint32_t)std::min<uint64_t>(entry->rawSize - chunkStart, PAK_CHUNK_SIZE);
+                uint32_t storedChunk = chunkSizes[i];
+                if (storedChunk > uint64_t(srcEnd - src)) return 0;
+                const uint8_t *raw = src;
+                if (storedChunk != rawChunk) {
+                    scratch.resize(PAK_CHUNK_SIZE);
+                    if (lz4Decompress(src, storedChunk, scratch.data(), rawChunk) != rawChunk) return 0;
+                    raw = scratch.data();
+                }
+                uint32_t begin = uint32_t(at - chunkStart);
+                uint32_t count = (uint32_t)std::min<uint64_t>(rawChunk - begin, offset + size - at);
+                memcpy(out, raw + begin, count);
+                out += count;
+                at += count;
+                src += storedChunk;
+            }
+            return size;
+        }
+
+        // ------------------------------- LZ4 block format -------------------------------
+        // see https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+
+        static constexpr uint32_t LZ4_MIN_MATCH     = 4;
+        static constexpr uint32_t LZ4_LAST_LITERALS = 5;   // the last 5 bytes are always literals.
+        static constexpr uint32_t LZ4_MF_LIMIT      = 12;  // the last match must start 12 bytes before the end.
+        static constexpr uint32_t LZ4_HASH_LOG      = 12;
+        static constexpr uint32_t LZ4_MAX_OFFSET    = 65535;
+
+        static uint32_t Lz4Read32(const uint8_t *p)
+        {
+            uint32_t v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        static uint32_t Lz4Hash(uint32_t sequence) { return (sequence * 2654435761u) >> (32 - LZ4_HASH_LOG); }
+
+        // write a length continuation as a run of 255s. returns false if out of space.
+        static bool Lz4WriteLength(uint8_t **pOp, const uint8_t *opEnd, uint32_t length)
+        {
+            uint8_t *op = *pOp;
+            for (; length >= 255; length -= 255) {
+                if (op >= opEnd) return false;
+                *op++ = 255;
+            }
+            if (op >= opEnd) return false;
+            *op++ = (uint8_t)length;
+            *pOp  = op;
+            return true;
+        }
+
+        static bool Lz4WriteSequence(uint8_t **pOp,
+            const uint8_t                    *opEnd,
+            const uint8_t                    *literals,
+            uint32_t                          literalLength,
+            uint32_t                          offset,
+            uint32_t                          matchLength)
+        {
+            uint8_t *op = *pOp;
+            if (op >= opEnd) return false;
+            uint8_t *token = op++;
+            *token         = uint8_t(std::min(literalLength, 15u) << 4);
+            if (literalLength >= 15 && !Lz4WriteLength(&op, opEnd, literalLength - 15)) return false;
+            if (literalLength > uint32_t(opEnd - op)) return false;
+            memcpy(op, literals, literalLength);
+            op += literalLength;
+            if (matchLength) {
+                if (opEnd - op < 2) return false;
+                *op++ = uint8_t(offset & 0xFF);
+                *op++ = uint8_t(offset >> 8);
+                uint32_t m = matchLength - LZ4_MIN_MATCH;
+                *token |= uint8_t(std::min(m, 15u));
+                if (m >= 15 && !Lz4WriteLength(&op, opEnd, m - 15)) return false;
+            }
+            *pOp = op;
+            return true;
+        }
+
+        uint32_t lz4Compress(const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+        {
+            uint32_t table[1 << LZ4_HASH_LOG] = {};
+
+            uint8_t       *op     = dst;
+            const uint8_t *opEnd  = dst + dstCapacity;
+            uint32_t       ip     = 0;
+            uint32_t       anchor = 0;
+
+            if (srcSize > LZ4_MF_LIMIT) {
+                const uint32_t matchStartLimit = srcSize - LZ4_MF_LIMIT;
+                const uint32_t matchEndLimit   = srcSize - LZ4_LAST_LITERALS;
+                while (ip < matchStartLimit) {
+                    uint32_t sequence = Lz4Read32(src + ip);
+                    uint32_t h        = Lz4Hash(sequence);
+                    uint32_t ref      = table[h];
+                    table[h]          = ip;
+                    if (ref >= ip || ip - ref > LZ4_MAX_OFFSET || Lz4Read32(src + ref) != sequence) {
+                        ip++;
+                        continue;
+                    }
+                    // extend the match backwards into the pending literals, then forwards.
+                    while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                        ip--;
+                        ref--;
+                    }
+                    uint32_t matchEnd = ip + LZ4_MIN_MATCH;
+                    while (matchEnd < matchEndLimit && src[matchEnd] == src[ref + (matchEnd - ip)]) matchEnd++;
+
+                    if (!Lz4WriteSequence(&op, opEnd, src + anchor, ip - anchor, ip - ref, matchEnd - ip)) return 0;
+                    ip     = matchEnd;
+                    anchor = ip;
+                }
+            }
+
+            if (!Lz4WriteSequence(&op, opEnd, src + anchor, srcSize - anchor, 0, 0)) return 0;
+            return uint32_t(op - dst);
+        }
+
+        static bool Lz4ReadLength(const uint8_t **pIp, const uint8_t *ipEnd, uint32_t *pLength)
+        {
+            const uint8_t *ip = *pIp;
+            uint8_t        b;
+            do {
+                if (ip >= ipEnd) return false;
+                b = *ip++;
+                *pLength += b;
+            } while (b == 255);
+            *pIp = ip;
+            return true;
+        }
+
+        int64_t lz4Decompress(const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t dstCapacity)
+        {
+            const uint8_t *ip    = src;
+            const uint8_t *ipEnd = src + srcSize;
+            uint8_t       *op    = dst;
+            uint8_t       *opEnd = dst + dstCapacity;
+
+            while (ip < ipEnd) {
+                uint8_t  token         = *ip++;
+                uint32_t literalLength = token >> 4;
+                if (literalLength == 15 && !Lz4ReadLength(&ip, ipEnd, &literalLength)) return -1;
+                if (literalLength > uint64_t(ipEnd - ip) || literalLength > uint64_t(opEnd - op)) return -1;
+                memcpy(op, ip, literalLength);
+                ip += literalLength;
+                op += literalLength;
+
+                // the last sequence has no match.
+                if (ip == ipEnd) break;
+
+                if (ipEnd - ip < 2) return -1;
+                uint32_t offset = uint32_t(ip[0]) | (uint32_t(ip[1]) << 8);
+                ip += 2;
+                if (offset == 0 || offset > uint64_t(op - dst)) return -1;
+
+                uint32_t matchLength = token & 15;
+                if (matchLength == 15 && !Lz4ReadLength(&ip, ipEnd, &matchLength)) return -1;
+                matchLength += LZ4_MIN_MATCH;
+                if (matchLength > uint64_t(opEnd - op)) return -1;
+
+                const uint8_t *match = op - offset;
+                if (offset >= matchLength) {
+                    memcpy(op, match, matchLength);
+                    op += matchLength;
+                } else {
+                    // NOTE: overlapping matches replicate the pattern so must be copied forwards bytewise.
+                    for (uint32_t i = 0; i < matchLength; i++) *op++ = *match++;
+                }
+            }
+            return int64_t(op - dst);
+        }
+
+        // ------------------------------- pack builder -------------------------------
+
+        static bool ReadWholeFile(const char *path, std::vector<uint8_t> *pOut)
+        {
+            FILE *f = fopen(path, "rb");
+            if (!f) return false;
+            fseek(f, 0, SEEK_END);
+            long size = ftell(f);
+            fseek(f, 0, SEEK_SET);
+            bool bOk = size >= 0;
+            if (bOk) {
+                pOut->resize((size_t)size);
+                bOk = size == 0 || fread(pOut->data(), 1, (size_t)size, f) == (size_t)size;
+            }
+            fclose(f);
+            return bOk;
+        }
+
+        // compress data into the chunked entry layout. returns false if compression does not save space.
+        static bool CompressEntry(const std::vector<uint8_t> &raw, std::vector<uint8_t> *pOut)
+        {
+            uint32_t chunkCount = uint32_t((raw.size() + PAK_CHUNK_SIZE - 1) / PAK_CHUNK_SIZE);
+            pOut->assign(sizeof(uint32_t) * (1 + chunkCount), 0);
+            memcpy(pOut->data(), &chunkCount, sizeof(uint32_t));
+
+            std::vector<uint8_t> scratch(PAK_CHUNK_SIZE);
+            for (uint32_t i = 0; i < chunkCount; i++) {
+                const uint8_t *chunk    = raw.data() + size_t(i) * PAK_CHUNK_SIZE;
+                uint32_t       rawChunk = (uint32_t)std::min<size_t>(raw.size() - size_t(i) * PAK_CHUNK_SIZE, PAK_CHUNK_SIZE);
+                // NOTE: only accept output strictly smaller than the input, so that stored size == raw size
+                // unambiguously marks an uncompressed chunk.
+                uint32_t stored = lz4Compress(chunk, rawChunk, scratch.data(), rawChunk - 1);
+                if (stored == 0) {
+                    pOut->insert(pOut->end(), chunk, chunk + rawChunk);
+                    stored = rawChunk;
+                } else {
+                    pOut->insert(pOut->end(), scratch.data(), scratch.data() + stored);
+                }
+                memcpy(pOut->data() + sizeof(uint32_t) * (1 + i), &stored, sizeof(uint32_t));
+            }
+            // NOTE: not worth decompressing at load for less than an 1/8th saving.
+            return pOut->size() < raw.size() - raw.size() / 8;
+        }
+
+        bool writePack(const char *outPath, const char **srcPaths, const char **pakPaths, uint32_t count, bool bCompress)
+        {
+            struct pending_entry_t {
+                pak_entry_t          entry;
+                std::vector<uint8_t> data;
+            };
+            std::vector<pending_entry_t> pending(count);
+            std::vector<char>            names;
+
+            for (uint32_t i = 0; i < count; i++) {
+                pending_entry_t &p = pending[i];
+                char             normalized[260];
+                if (!normalizePath(pakPaths[i], normalized, sizeof(normalized))) {
+                    fprintf(stderr, "aepak: path too long '%s'\n", pakPaths[i]);
+                    return false;
+                }
+                if (!ReadWholeFile(srcPaths[i], &p.data)) {
+                    fprintf(stderr, "aepak: unable to read '%s'\n", srcPaths[i]);
+                    return false;
+                }
+                p.entry            = {};
+                p.entry.pathHash   = hashPath(normalized);
+                p.entry.rawSize    = p.data.size();
+                p.entry.nameOffset = (uint32_t)names.size();
+                names.insert(names.end(), normalized, normalized + strlen(normalized) + 1);
+
+                std::vector<uint8_t> compressed;
+                if (bCompress && !p.data.empty() && CompressEntry(p.data, &compressed)) {
+                    p.data.swap(compressed);
+                    p.entry.flags |= PAK_ENTRY_COMPRESSED;
+                }
+                p.entry.storedSize = p.data.size();
+            }
+
+            std::sort(pending.begin(), pending.end(), [](const pending_entry_t &a, const pending_entry_t &b) {
+                return a.entry.pathHash < b.entry.pathHash;
+            });
+            for (uint32_t i = 1; i < count; i++) {
+                if (pending[i].entry.pathHash == pending[i - 1].entry.pathHash &&
+                    !strcmp(&names[pending[i].entry.nameOffset], &names[pending[i - 1].entry.nameOffset])) {
+                    fprintf(stderr, "aepak: duplicate path '%s'\n", &names[pending[i].entry.nameOffset]);
+                    return false;
+                }
+            }
+
+            auto alignUp = [](uint64_t v) { return (v + PAK_ALIGNMENT - 1) & ~(PAK_ALIGNMENT - 1); };
+
+            uint64_t offset = sizeof(pak_header_t) + sizeof(pak_entry_t) * uint64_t(count) + names.size();
+            for (pending_entry_t &p : pending) {
+                offset             = alignUp(offset);
+                p.entry.dataOffset = offset;
+                offset += p.entry.storedSize;
+            }
+
+            pak_header_t header = {};
+            header.magic        = PAK_MAGIC;
+            header.version      = PAK_VERSION;
+            header.entryCount   = count;
+            header.namesSize    = (uint32_t)names.size();
+            header.fileSize     = offset;
+
+            FILE *f = fopen(outPath, "wb");
+            if (!f) {
+                fprintf(stderr, "aepak: unable to open '%s' for writing\n", outPath);
+                return false;
+            }
+            bool bOk = fwrite(&header, sizeof(header), 1, f) == 1;
+            for (const pending_entry_t &p : pending) bOk = bOk && fwrite(&p.entry, sizeof(pak_entry_t), 1, f) == 1;
+            bOk = bOk && (names.empty() || fwrite(names.data(), 1, names.size(), f) == names.size());
+
+            static const uint8_t zeros[4096] = {};
+            uint64_t             written     = sizeof(pak_header_t) + sizeof(pak_entry_t) * uint64_t(count) + names.size();
+            for (const pending_entry_t &p : pending) {
+                while (bOk && written < p.entry.dataOffset) {
+                    size_t pad = (size_t)std::min<uint64_t>(sizeof(zeros), p.entry.dataOffset - written);
+                    bOk        = fwrite(zeros, 1, pad, f) == pad;
+                    written += pad;
+                }
+                bOk = bOk && (p.data.empty() || fwrite(p.data.data(), 1, p.data.size(), f) == p.data.size());
+                written += p.data.size();
+            }
+            bOk = (fclose(f) == 0) && bOk;
+            if (!bOk) fprintf(stderr, "aepak: failed writing '%s'\n", outPath);
+            return bOk;
+        }
+
+    }  // namespace pak
+}  // namespace automata_engine
+
+#endif  // AE_PAK_IMPL
+
+#endif  // AUTOMATA_ENGINE_PAK_H
@@ -0,0 +1,468 @@
+#include <automata_engine.hpp>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <math.h>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+#include <emmintrin.h>
+
+namespace automata_engine {
+    namespace frender {
+        // NOTE: the glyphs are rasterized by FreeType the first time that they are drawn, into an atlas of 8 bit
+        // coverage. the atlas is packed with a skyline, i.e. the height of the used part of each column is kept as a
+        // list of segments, and a glyph goes where it lands lowest. when the atlas is full it is emptied, and the
+        // glyphs that are still drawn are rasterized again.
+        static constexpr uint32_t TEXT_GLYPH_PADDING   = 1;
+        static constexpr uint32_t TEXT_MAX_FONTS       = 1 << 8;
+        static constexpr uint32_t TEXT_MAX_PIXEL_SIZE  = 1 << 12;
+        static constexpr uint32_t TEXT_REPLACEMENT     = 0xFFFD;
+        static constexpr uint32_t TEXT_BAND_ROWS       = 32;
+        static constexpr uint64_t TEXT_PARALLEL_PIXELS = 1 << 16;
+
+        struct font_t {
+            loaded_file_t file;
+            FT_Face       face;
+            uint32_t      index;
+            uint32_t      pixelSize;  // the size that the face is set to.
+        };
+
+        struct cached_glyph_t {
+            uint16_t x, y;  // the top left in the atlas.
+            uint16_t width, height;
+            int32_t  left, top;  // from the pen on the baseline to the top left of the bitmap, where +y is up.
+            float    advance;
+            uint32_t glyphIndex;
+        };
+
+        struct skyline_segment_t {
+            uint32_t x, y, width;
+        };
+
+        // a glyph placed in the target, waiting to be blended.
+        struct placed_glyph_t {
+            int32_t  x, y;
+            uint16_t atlasX, atlasY, width, height;
+            uint32_t draw;
+        };
+
+        struct glyph_cache_t {
+            FT_Library                                   library;
+            std::vector<font_t *>                        fonts;
+            std::vector<uint8_t>                         atlas;
+            uint32_t                                     atlasSize;
+            std::vector<skyline_segment_t>               skyline;
+            std::unordered_map<uint64_t, cached_glyph_t> glyphs;
+            std::vector<placed_glyph_t>                  placed;
+            glyph_cache_stats_t                          stats;
+        };
+
+        static void ResetAtlas(glyph_cache_t *cache)
+        {
+            cache->glyphs.clear();
+            cache->skyline.assign(1, {0, 0, cache->atlasSize});
+            memset(cache->atlas.data(), 0, cache->atlas.size());
+        }
+
+        glyph_cache_t *createGlyphCache(uint32_t atlasSize)
+        {
+            glyph_cache_t *cache = new glyph_cache_t();
+            if (FT_Init_FreeType(&cache->library)) {
+                AELoggerError("unable to initialize FreeType for a glyph cache of %ux%u", atlasSize, atlasSize);
+                delete cache;
+                return nullptr;
+            }
+            cache->atlasSize = math::min(math::max(atlasSize, 64u), uint32_t(UINT16_MAX));
+            cache->atlas.resize(size_t(cache->atlasSize) * cache->atlasSize);
+            ResetAtlas(cache);
+            return cache;
+        }
+
+        void destroyGlyphCache(glyph_cache_t *cache)
+        {
+            if (!cache) return;
+            for (font_t *font : cache->fonts) {
+                FT_Done_Face(font->face);
+                EM->pfn.freeLoadedFile(font->file);
+                delete font;
+            }
+            FT_Done_FreeType(cache->library);
+            delete cache;
+        }
+
+        font_t *loadFont(glyph_cache_t *cache, const char *path)
+        {
+            if (cache->fonts.size() >= TEXT_MAX_FONTS) {
+                AELoggerError("unable to load %s, the glyph cache has the most fonts that it can key", path);
+                return nullptr;
+            }
+            loaded_file_t file = EM->pfn.readEntireFile(path);
+            if (!file.contentSize) {
+                AELoggerError("unable to read the font %s", path);
+                return nullptr;
+            }
+            // NOTE: FreeType reads the face from the file memory as it is used, so the font keeps the file.
+            FT_Face face;
+            if (FT_New_Memory_Face(cache->library, (const FT_Byte *)file.contents, file.contentSize, 0, &face)) {
+                AELoggerError("unable to load the font %s", path);
+                EM->pfn.freeLoadedFile(file);
+                return nullptr;
+            }
+            font_t *font = new font_t();
+            font->file   = file;
+            font->face   = face;
+            font->index  = uint32_t(cache->fonts.size());
+            cache->fonts.push_back(font);
+            return font;
+        }
+
+        static bool SetFontSize(font_t *font, uint32_t pixelSize)
+        {
+            if (font->pixelSize == pixelSize) return true;
+            if (FT_Set_Pixel_Sizes(font->face, 0, pixelSize)) return false;
+            font->pixelSize = pixelSize;
+            return true;
+        }
+
+        // find the lowest place for a width x height rect along the skyline.
+        static bool PackSkyline(glyph_cache_t *cache, uint32_t width, uint32_t height, uint32_t *pX, uint32_t *pY)
+        {
+            std::vector<skyline_segment_t> &skyline = cache->skyline;
+            uint32_t                        bestY = UINT32_MAX, bestIndex = 0;
+            for (uint32_t i = 0; i < skyline.size(); i++) {
+                uint32_t x = skyline[i].x, y = 0;
+                if (x + width > cache->atlasSize) break;
+                for (uint32_t j = i; j < skyline.size() && skyline[j].x < x + width; j++)
+                    y = math::max(y, skyline[j].y);
+                if (y + height <= cache->atlasSize && y < bestY) {
+                    bestY     = y;
+                    bestIndex = i;
+                }
+            }
+            if (bestY == UINT32_MAX) return false;
+
+            // the rect covers segments from bestIndex, cutting the last one it reaches.
+            uint32_t          x0 = skyline[bestIndex].x, x1 = x0 + width;
+            skyline_segment_t top = {x0, bestY + height, width};
+            uint32_t          end = bestIndex;
+            while (end < skyline.size() && skyline[end].x + skyline[end].width <= x1) end++;
+            if (end < skyline.size() && skyline[end].x < x1) {
+                skyline[end].width -= x1 - skyline[end].x;
+                skyline[end].x = x1;
+            }
+            skyline.erase(skyline.begin() + bestIndex, skyline.begin() + end);
+            skyline.insert(skyline.begin() + bestIndex, top);
+            // merge the neighbours at the same height.
+            for (uint32_t i = (bestIndex > 0) ? bestIndex - 1 : 0; i + 1 < skyline.size() && i <= bestIndex + 1;) {
+                if (skyline[i].y == skyline[i + 1].y) {
+                    skyline[i].width += skyline[i + 1].width;
+                    skyline.erase(skyline.begin() + i + 1);
+                } else {
+                    i++;
+                }
+            }
+            *pX = x0;
+            *pY = bestY;
+            return true;
+        }
+
+        // get a glyph from the cache, rasterizing it on a miss. bAtlasFull is set when it did not fit in the atlas.
+        static const cached_glyph_t *FindGlyph(
+            glyph_cache_t *cache, font_t *font, uint32_t pixelSize, uint32_t codepoint, bool *pbAtlasFull)
+        {
+            const uint64_t key = (uint64_t(font->index) << 48) | (uint64_t(pixelSize) << 32) | codepoint;
+            auto           it  = cache->glyphs.find(key);
+            if (it != cache->glyphs.end()) {
+                cache->stats.hits++;
+                return &it->second;
+            }
+            if (!SetFontSize(font, pixelSize)) return nullptr;
+            FT_Face face = font->face;
+            // NOTE: a codepoint that the font does not have draws as the glyph for missing characters.
+            if (FT_Load_Char(face, codepoint, FT_LOAD_RENDER)) return nullptr;
+            const FT_Bitmap &bitmap = face->glyph->bitmap;
+            if (bitmap.pixel_mode != FT_PIXEL_MODE_GRAY && bitmap.pixel_mode != FT_PIXEL_MODE_MONO && bitmap.rows)
+                return nullptr;
+
+            cached_glyph_t glyph = {};
+            glyph.width          = uint16_t(bitmap.width);
+            glyph.height         = uint16_t(bitmap.rows);
+            glyph.left           = face->glyph->bitmap_left;
+            glyph.top            = face->glyph->bitmap_top;
+            glyph.advance        = face->glyph->advance.x / 64.f;
+            glyph.glyphIndex     = FT_Get_Char_Index(face, codepoint);
+            if (glyph.width && glyph.height) {
+                uint32_t x, y;
+                if (!PackSkyline(cache, glyph.width + TEXT_GLYPH_PADDING, glyph.height + TEXT_GLYPH_PADDING, &x, &y)) {
+                    *pbAtlasFull = true;
+                    return nullptr;
+                }
+                glyph.x = uint16_t(x);
+                glyph.y = uint16_t(y);
+                for (uint32_t row = 0; row < bitmap.rows; row++) {
+                    const uint8_t *src = bitmap.buffer + int64_t(row) * bitmap.pitch;
+                    uint8_t       *dst = cache->atlas.data() + size_t(y + row) * cache->atlasSize + x;
+                    if (bitmap.pixel_mode == FT_PIXEL_MODE_GRAY) {
+                        memcpy(dst, src, bitmap.width);
+                    } else {
+                        for (uint32_t col = 0; col < bitmap.width; col++)
+                            dst[col] = ((src[col >> 3] >> (7 - (col & 7))) & 1) ? 0xFF : 0;
+                    }
+                }
+            }
+            cache->stats.rasterized++;
+            return &cache->glyphs.emplace(key, glyph).first->second;
+        }
+
+        // decode the next codepoint of a UTF-8 string. a malformed sequence decodes as U+FFFD.
+        static uint32_t NextCodepoint(const char **pText)
+        {
+            const uint8_t *s = (const uint8_t *)*pText;
+            uint32_t       c = s[0], length, codepoint;
+            if (c < 0x80) {
+                *pText += 1;
+                return c;
+            } else if ((c & 0xE0) == 0xC0) {
+                length    = 2;
+                codepoint = c & 0x1F;
+            } else if ((c & 0xF0) == 0xE0) {
+                length    = 3;
+                codepoint = c & 0x0F;
+            } else if ((c & 0xF8) == 0xF0) {
+                length    = 4;
+                codepoint = c & 0x07;
+            } else {
+                *pText += 1;
+                return TEXT_REPLACEMENT;
+            }
+            for (uint32_t i = 1; i < length; i++) {
+                if ((s[i] & 0xC0) != 0x80) {
+                    *pText += i;
+                    return TEXT_REPLACEMENT;
+                }
+                codepoint = (codepoint << 6) | (s[i] & 0x3F);
+            }
+            *pText += length;
+            return (codepoint > 0x10FFFF) ? TEXT_REPLACEMENT : codepoint;
+        }
+
+        struct text_pen_t {
+            float    left;  // where each line starts.
+            float    x;
+            float    baseline;
+            float    width;  // of the widest line so far.
+            uint32_t lines;
+        };
+
+        // lay out a string, calling place(glyph, x, y) with the top left of each glyph in the target. if the atlas
+        // fills up, onAtlasFull() is called before it is emptied.
+        template <typename PLACE, typename ATLAS_FULL>
+        static void LayoutText(glyph_cache_t *cache,
+            font_t                          *font,
+            uint32_t                         pixelSize,
+            const char                      *text,
+            text_pen_t                      *pen,
+            PLACE                          &&place,
+            ATLAS_FULL                     &&onAtlasFull)
+        {
+            FT_Face  face      = font->face;
+            uint32_t prevIndex = 0;
+            pen->lines         = 1;
+            while (*text) {
+                uint32_t codepoint = NextCodepoint(&text);
+                if (codepoint == '\n') {
+                    pen->width = math::max(pen->width, pen->x - pen->left);
+                    pen->x     = pen->left;
+                    pen->baseline += face->size->metrics.height / 64.f;
+                    pen->lines++;
+                    prevIndex = 0;
+                    continue;
+                }
+                bool                  bAtlasFull = false;
+                const cached_glyph_t *glyph      = FindGlyph(cache, font, pixelSize, codepoint, &bAtlasFull);
+                if (bAtlasFull) {
+                    onAtlasFull();
+                    ResetAtlas(cache);
+                    cache->stats.atlasResets++;
+                    // NOTE: a glyph larger than the whole atlas is skipped.
+                    glyph = FindGlyph(cache, font, pixelSize, codepoint, &bAtlasFull);
+                }
+                if (!glyph) continue;
+                if (prevIndex && glyph->glyphIndex && FT_HAS_KERNING(face)) {
+                    FT_Vector kerning;
+                    if (!FT_Get_Kerning(face, prevIndex, glyph->glyphIndex, FT_KERNING_DEFAULT, &kerning))
+                        pen->x += kerning.x / 64.f;
+                }
+                prevIndex = glyph->glyphIndex;
+                place(*glyph, int32_t(lrintf(pen->x)) + glyph->left, int32_t(lrintf(pen->baseline)) - glyph->top);
+                pen->x += glyph->advance;
+            }
+            pen->width = math::max(pen->width, pen->x - pen->left);
+        }
+
+        static inline __m128i Div255(__m128i x)
+        {
+            // round(x / 255) for x up to 255 * 255.
+            return _mm_mulhi_epu16(_mm_add_epi16(x, _mm_set1_epi16(128)), _mm_set1_epi16(257));
+        }
+
+        // a premultiplied color scaled by the coverage, over the target. the pixels are in 16 bit lanes, two at a time.
+        static inline __m128i BlendCoverage(__m128i dst, __m128i coverage, __m128i color)
+        {
+            __m128i src   = Div255(_mm_mullo_epi16(color, coverage));
+            __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, 0xFF), 0xFF);
+            __m128i keep  = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+            return _mm_add_epi16(src, Div255(_mm_mullo_epi16(dst, keep)));
+        }
+
+        static void BlendCoverageSpan(uint32_t *dst, const uint8_t *coverage, uint32_t count, uint32_t color)
+        {
+            const __m128i zero    = _mm_setzero_si128();
+            const __m128i color16 = _mm_unpacklo_epi8(_mm_set1_epi32(int32_t(color)), zero);
+            const bool    bOpaque = (color >> 24) == 0xFF;
+            uint32_t      i       = 0;
+            for (; i + 4 <= count; i += 4) {
+                uint32_t c;
+                memcpy(&c, coverage + i, sizeof(c));
+                if (!c) continue;
+                if (c == 0xFFFFFFFF && bOpaque) {
+                    _mm_storeu_si128((__m128i *)(dst + i), _mm_set1_epi32(int32_t(color)));
+                    continue;
+                }
+                // each coverage byte in the 4 channels of its pixel.
+                __m128i cov = _mm_cvtsi32_si128(int32_t(c));
+                cov         = _mm_unpacklo_epi8(cov, cov);
+                cov         = _mm_unpacklo_epi16(cov, cov);
+                __m128i d   = _mm_loadu_si128((const __m128i *)(dst + i));
+                __m128i lo  = BlendCoverage(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(cov, zero), color16);
+                __m128i hi  = BlendCoverage(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(cov, zero), color16);
+                _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+            }
+            for (; i < count; i++) {
+                if (!coverage[i]) continue;
+                __m128i cov = _mm_set1_epi16(coverage[i]);
+                __m128i d   = _mm_unpacklo_epi8(_mm_cvtsi32_si128(int32_t(dst[i])), zero);
+                dst[i]      = uint32_t(_mm_cvtsi128_si32(_mm_packus_epi16(BlendCoverage(d, cov, color16), zero)));
+            }
+        }
+
+        static uint32_t PremultiplyColor(uint32_t color)
+        {
+            uint32_t a = color >> 24;
+            auto     channel = [a](uint32_t c) { return (c * a + 127) / 255; };
+            return (a << 24) | (channel((color >> 16) & 0xFF) << 16) | (channel((color >> 8) & 0xFF) << 8) |
+                   channel(color & 0xFF);
+        }
+
+        // blend the placed glyphs in the rows [y0, y1) of the target, in the order that they were placed.
+        static void BlendPlacedGlyphs(const glyph_cache_t *cache,
+            backbuffer_t                                  *target,
+            const uint32_t                                *colors,
+            int32_t                                        y0,
+            int32_t                                        y1)
+        {
+            for (const placed_glyph_t &glyph : cache->placed) {
+                int32_t minX = math::max(glyph.x, 0);
+                int32_t maxX = math::min(glyph.x + int32_t(glyph.width), int32_t(target->width));
+                int32_t minY = math::max(glyph.y, y0);
+                int32_t maxY = math::min(glyph.y + int32_t(glyph.height), y1);
+                if (minX >= maxX || minY >= maxY) continue;
+                for (int32_t y = minY; y < maxY; y++) {
+                    const uint8_t *coverage = cache->atlas.data() +
+                                              size_t(glyph.atlasY + y - glyph.y) * cache->atlasSize + glyph.atlasX +
+                                              (minX - glyph.x);
+                    uint32_t *dst = (uint32_t *)((uint8_t *)target->memory + size_t(y) * target->pitch) + minX;
+                    BlendCoverageSpan(dst, coverage, uint32_t(maxX - minX), colors[glyph.draw]);
+                }
+            }
+        }
+
+        static void FlushPlacedGlyphs(glyph_cache_t *cache, backbuffer_t *target, const uint32_t *colors)
+        {
+            uint64_t pixels = 0;
+            for (const placed_glyph_t &glyph : cache->placed) pixels += uint64_t(glyph.width) * glyph.height;
+            if (pixels < TEXT_PARALLEL_PIXELS) {
+                BlendPlacedGlyphs(cache, target, colors, 0, int32_t(target->height));
+            } else {
+                // NOTE: each job takes a band of rows, so the glyphs that overlap still blend in order.
+                uint32_t bands = (target->height + TEXT_BAND_ROWS - 1) / TEXT_BAND_ROWS;
+                jobs::parallelFor(bands, 1, [&](uint32_t begin, uint32_t end) {
+                    BlendPlacedGlyphs(cache, target, colors, int32_t(begin * TEXT_BAND_ROWS),
+                        int32_t(math::min(end * TEXT_BAND_ROWS, target->height)));
+                });
+            }
+            cache->placed.clear();
+        }
+
+        void drawTexts(glyph_cache_t *cache, backbuffer_t *target, const text_draw_t *draws, uint32_t count)
+        {
+            if (!target->memory || target->bytesPerPixel != sizeof(uint32_t)) {
+                AELoggerError("unable to draw text to a target with %u bytes per pixel", target->bytesPerPixel);
+                return;
+            }
+            std::vector<uint32_t> colors(count);
+            for (uint32_t i = 0; i < count; i++) {
+                const text_draw_t &draw = draws[i];
+                colors[i]               = PremultiplyColor(draw.color);
+                if (!draw.font || !draw.text || !(draw.color >> 24)) continue;
+                const uint32_t pixelSize =
+                    math::min(draw.pixelSize, math::min(cache->atlasSize, TEXT_MAX_PIXEL_SIZE - 1));
+                if (!pixelSize || !SetFontSize(draw.font, pixelSize)) continue;
+
+                text_pen_t pen = {draw.x, draw.x, draw.y + draw.font->face->size->metrics.ascender / 64.f, 0.f, 0};
+                int32_t    minX = INT32_MAX, minY = INT32_MAX, maxX = INT32_MIN, maxY = INT32_MIN;
+                auto       place = [&](const cached_glyph_t &glyph, int32_t x, int32_t y) {
+                    if (!glyph.width || !glyph.height) return;
+                    cache->placed.push_back({x, y, glyph.x, glyph.y, glyph.width, glyph.height, i});
+                    minX = math::min(minX, x);
+                    minY = math::min(minY, y);
+                    maxX = math::max(maxX, x + int32_t(glyph.width));
+                    maxY = math::max(maxY, y + int32_t(glyph.height));
+                };
+                // the glyphs placed so far are drawn before the atlas is emptied.
+                auto flush = [&]() { FlushPlacedGlyphs(cache, target, colors.data()); };
+                LayoutText(cache, draw.font, pixelSize, draw.text, &pen, place, flush);
+                if (minX < maxX) markDirty(target, minX, minY, maxX - minX, maxY - minY);
+            }
+            FlushPlacedGlyphs(cache, target, colors.data());
+            cache->stats.glyphs = uint32_t(cache->glyphs.size());
+        }
+
+        void drawText(glyph_cache_t *cache,
+            backbuffer_t            *target,
+            font_t                  *font,
+            uint32_t                 pixelSize,
+            float                    x,
+            float                    y,
+            const char              *text,
+            uint32_t                 color)
+        {
+            text_draw_t draw = {font, pixelSize, x, y, text, color};
+            drawTexts(cache, target, &draw, 1);
+        }
+
+        text_metrics_t measureText(glyph_cache_t *cache, font_t *font, uint32_t pixelSize, const char *text)
+        {
+            text_metrics_t metrics = {};
+            pixelSize              = math::min(pixelSize, math::min(cache->atlasSize, TEXT_MAX_PIXEL_SIZE - 1));
+            if (!font || !text || !*text || !pixelSize || !SetFontSize(font, pixelSize)) return metrics;
+            const FT_Size_Metrics &size = font->face->size->metrics;
+            metrics.ascent              = size.ascender / 64.f;
+            metrics.descent             = -size.descender / 64.f;
+            metrics.lineHeight          = size.height / 64.f;
+
+            text_pen_t pen = {0.f, 0.f, metrics.ascent, 0.f, 0};
+            LayoutText(cache, font, pixelSize, text, &pen, [](const cached_glyph_t &, int32_t, int32_t) {}, []() {});
+            metrics.width  = pen.width;
+            metrics.lines  = pen.lines;
+            metrics.height = metrics.ascent + metrics.descent + (pen.lines - 1) * metrics.lineHeight;
+            cache->stats.glyphs = uint32_t(cache->glyphs.size());
+            return metrics;
+        }
+
+        glyph_cache_stats_t getGlyphCacheStats(glyph_cache_t *cache) { return cache->stats; }
+    }  // namespace frender
+}  // namespace automata_engine
@@ -0,0 +1,1034 @@
+#include <automata_engine.hpp>
+
+#include <automata_engine_utils.hpp>
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include <emmintrin.h>
+
+namespace automata_engine {
+    namespace texture {
+
+        // NOTE: These structs are here and not in a separated header because they are internal
+        // details of how the container formats are read.
+#pragma pack(push, 1)
+        struct dds_pixel_format_t {
+            uint32_t size;
+            uint32_t flags;
+            uint32_t fourCC;
+            uint32_t rgbBitCount;
+            uint32_t rMask;
+            uint32_t gMask;
+            uint32_t bMask;
+            uint32_t aMask;
+        };
+        struct dds_header_t {
+            uint32_t           magic;
+            uint32_t           size;
+            uint32_t           flags;
+            uint32_t           height;
+            uint32_t           width;
+            uint32_t           pitchOrLinearSize;
+            uint32_t           depth;
+            uint32_t           mipMapCount;
+            uint32_t           reserved1[11];
+            dds_pixel_format_t pixelFormat;
+            uint32_t           caps;
+            uint32_t           caps2;
+            uint32_t           caps3;
+            uint32_t           caps4;
+            uint32_t           reserved2;
+        };
+        struct dds_header_dx10_t {
+            uint32_t dxgiFormat;
+            uint32_t resourceDimension;
+            uint32_t miscFlag;
+            uint32_t arraySize;
+            uint32_t miscFlags2;
+        };
+        struct ktx2_header_t {
+            uint8_t  identifier[12];
+            uint32_t vkFormat;
+            uint32_t typeSize;
+            uint32_t pixelWidth;
+            uint32_t pixelHeight;
+            uint32_t pixelDepth;
+            uint32_t layerCount;
+            uint32_t faceCount;
+            uint32_t levelCount;
+            uint32_t supercompressionScheme;
+            uint32_t dfdByteOffset;
+            uint32_t dfdByteLength;
+            uint32_t kvdByteOffset;
+            uint32_t kvdByteLength;
+            uint64_t sgdByteOffset;
+            uint64_t sgdByteLength;
+        };
+        struct ktx2_level_t {
+            uint64_t byteOffset;
+            uint64_t byteLength;
+            uint64_t uncompressedByteLength;
+        };
+#pragma pack(pop)
+
+        static constexpr uint32_t FourCC(char a, char b, char c, char d)
+        {
+            return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) |
+                   (uint32_t(uint8_t(d)) << 24);
+        }
+
+        enum {
+            DDS_MAGIC              = FourCC('D', 'D', 'S', ' '),
+            DDSD_CAPS              = 0x1,
+            DDSD_HEIGHT            = 0x2,
+            DDSD_WIDTH             = 0x4,
+            DDSD_PITCH             = 0x8,
+            DDSD_PIXELFORMAT       = 0x1000,
+            DDSD_MIPMAPCOUNT       = 0x20000,
+            DDSD_LINEARSIZE        = 0x80000,
+            DDSD_DEPTH             = 0x800000,
+            DDPF_FOURCC            = 0x4,
+            DDPF_RGB               = 0x40,
+            DDSCAPS_COMPLEX        = 0x8,
+            DDSCAPS_TEXTURE        = 0x1000,
+            DDSCAPS_MIPMAP         = 0x400000,
+            DDSCAPS2_CUBEMAP       = 0x200,
+            DDS_DIMENSION_TEXTURE2D = 3
+        };
+
+        static const uint8_t KTX2_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+        // NOTE: the containers store the levels in the same row order as the source images. engine images are
+        // bottom-up, which KTX2 files record with this orientation value.
+        static const char KTX2_ORIENTATION_KEY[]   = "KTXorientation";
+        static const char KTX2_ORIENTATION_VALUE[] = "ru";
+
+        struct format_info_t {
+            texture_format_t format;
+            uint32_t         blockSize;  // bytes per 4x4 block, or per pixel for uncompressed formats.
+            uint32_t         dxgiFormat;
+            uint32_t         vkFormat;
+            bool             bSRGB;
+        };
+
+        static const format_info_t g_formatInfos[] = {
+            {TEXTURE_FORMAT_RGBA8, 4, 28, 37, false},
+            {TEXTURE_FORMAT_RGBA8_SRGB, 4, 29, 43, true},
+            {TEXTURE_FORMAT_BC1, 8, 71, 131, false},
+            {TEXTURE_FORMAT_BC1_SRGB, 8, 72, 132, true},
+            {TEXTURE_FORMAT_BC3, 16, 77, 137, false},
+            {TEXTURE_FORMAT_BC3_SRGB, 16, 78, 138, true},
+            {TEXTURE_FORMAT_BC5, 16, 83, 141, false},
+            {TEXTURE_FORMAT_BC7, 16, 98, 145, false},
+            {TEXTURE_FORMAT_BC7_SRGB, 16, 99, 146, true},
+        };
+
+        static const format_info_t *GetFormatInfo(texture_format_t format)
+        {
+            for (const format_info_t &info : g_formatInfos)
+                if (info.format == format) return &info;
+            return nullptr;
+        }
+
+        static texture_format_t FormatFromDXGI(uint32_t dxgiFormat)
+        {
+            for (const format_info_t &info : g_formatInfos)
+                if (info.dxgiFormat == dxgiFormat) return info.format;
+            return TEXTURE_FORMAT_UNKNOWN;
+        }
+
+        static texture_format_t FormatFromVk(uint32_t vkFormat)
+        {
+            for (const format_info_t &info : g_formatInfos)
+                if (info.vkFormat == vkFormat) return info.format;
+            return TEXTURE_FORMAT_UNKNOWN;
+        }
+
+        bool isCompressed(texture_format_t format)
+        {
+            return format != TEXTURE_FORMAT_UNKNOWN && format != TEXTURE_FORMAT_RGBA8 &&
+                   format != TEXTURE_FORMAT_RGBA8_SRGB;
+        }
+
+        bool isSRGB(texture_format_t format)
+        {
+            const format_info_t *info = GetFormatInfo(format);
+            return info && info->bSRGB;
+        }
+
+        uint32_t getBlockSize(texture_format_t format)
+        {
+            const format_info_t *info = GetFormatInfo(format);
+            return info ? info->blockSize : 0;
+        }
+
+        uint32_t getLevelSize(texture_format_t format, uint32_t width, uint32_t height)
+        {
+            if (isCompressed(format)) return math::div_ceil(width, 4) * math::div_ceil(height, 4) * getBlockSize(format);
+            return width * height * getBlockSize(format);
+        }
+
+        uint32_t getMaxLevelCount(uint32_t width, uint32_t height)
+        {
+            uint32_t levelCount = 1;
+            for (uint32_t size = math::max(width, height); size > 1; size >>= 1) levelCount++;
+            return math::min(levelCount, TEXTURE_MAX_LEVELS);
+        }
+
+        texture_t createTexture(texture_format_t format, uint32_t width, uint32_t height, uint32_t levelCount)
+        {
+            texture_t texture = {};
+            if (!GetFormatInfo(format) || width == 0 || height == 0) return texture;
+            uint32_t maxLevelCount = getMaxLevelCount(width, height);
+            if (levelCount == 0 || levelCount > maxLevelCount) levelCount = maxLevelCount;
+
+            texture.format     = format;
+            texture.width      = width;
+            texture.height     = height;
+            texture.levelCount = levelCount;
+            for (uint32_t i = 0; i < levelCount; i++) {
+                texture_level_t &level = texture.levels[i];
+                level.width            = math::max(width >> i, 1u);
+                level.height           = math::max(height >> i, 1u);
+                level.offset           = texture.dataSize;
+                level.size             = getLevelSize(format, level.width, level.height);
+                texture.dataSize += level.size;
+            }
+            texture.data = (uint8_t *)EM->pfn.alloc(texture.dataSize);
+            if (!texture.data) {
+                AELoggerError("failed to alloc %u bytes for a %ux%u texture", texture.dataSize, width, height);
+                return {};
+            }
+            return texture;
+        }
+
+        void freeTexture(texture_t texture) { EM->pfn.free(texture.data); }
+
+        texture_t createTextureFromImage(loaded_image_t image, bool bSRGB)
+        {
+            texture_t texture = createTexture(
+                bSRGB ? TEXTURE_FORMAT_RGBA8_SRGB : TEXTURE_FORMAT_RGBA8, image.width, image.height, 1);
+            if (texture.data) memcpy(texture.data, image.pixelPointer, texture.dataSize);
+            return texture;
+        }
+
+        // ----------------------------------- block encoding -----------------------------------
+
+        // NOTE: a 4x4 block is kept as SoA floats so that the encoders can evaluate four pixels at a time.
+        struct block_t {
+            alignas(16) float c[4][16];  // R, G, B, A.
+        };
+
+        static void LoadBlock(const uint32_t *pixels, uint32_t width, uint32_t height, uint32_t bx, uint32_t by,
+            block_t *pBlock)
+        {
+            for (uint32_t y = 0; y < 4; y++) {
+                // NOTE: blocks that hang over the edge of the image repeat the last row and column.
+                uint32_t py = math::min(by * 4 + y, height - 1);
+                for (uint32_t x = 0; x < 4; x++) {
+                    uint32_t px = math::min(bx * 4 + x, width - 1);
+                    uint32_t p  = pixels[size_t(py) * width + px];
+                    for (uint32_t c = 0; c < 4; c++) pBlock->c[c][y * 4 + x] = float((p >> (c * 8)) & 0xFF);
+                }
+            }
+        }
+
+        static float Clamp255(float v) { return (v < 0.f) ? 0.f : ((v > 255.f) ? 255.f : v); }
+
+        // pick the nearest palette entry for each pixel. the error is the squared distance summed over channels
+        // [channelBegin, channelBegin + channelCount). returns the total error of the block.
+        static float SelectIndices(const block_t &block,
+            uint32_t                              channelBegin,
+            uint32_t                              channelCount,
+            const float (*palette)[4],
+            uint32_t                              paletteCount,
+            uint8_t                              *indicesOut)
+        {
+            float totalError = 0.f;
+            for (uint32_t g = 0; g < 16; g += 4) {
+                __m128  bestError = _mm_set1_ps(FLT_MAX);
+                __m128i bestIndex = _mm_setzero_si128();
+                for (uint32_t e = 0; e < paletteCount; e++) {
+                    __m128 error = _mm_setzero_ps();
+                    for (uint32_t c = 0; c < channelCount; c++) {
+                        __m128 d = _mm_sub_ps(_mm_load_ps(&block.c[channelBegin + c][g]), _mm_set1_ps(palette[e][c]));
+                        error    = _mm_add_ps(error, _mm_mul_ps(d, d));
+                    }
+                    __m128i better = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+                    bestError      = _mm_min_ps(error, bestError);
+                    bestIndex      = _mm_or_si128(
+                        _mm_and_si128(better, _mm_set1_epi32(int(e))), _mm_andnot_si128(better, bestIndex));
+                }
+                alignas(16) float   errors[4];
+                alignas(16) int32_t indices[4];
+                _mm_store_ps(errors, bestError);
+                _mm_store_si128((__m128i *)indices, bestIndex);
+                for (uint32_t i = 0; i < 4; i++) {
+                    indicesOut[g + i] = uint8_t(indices[i]);
+                    totalError += errors[i];
+                }
+            }
+            return totalError;
+        }
+
+        // fit a line through the block. the endpoints are where the projections of the pixels onto the principal
+        // axis begin and end.
+        static void FitPrincipalAxis(const block_t &block, uint32_t channelCount, float e0[4], float e1[4])
+        {
+            float mean[4] = {};
+            for (uint32_t c = 0; c < channelCount; c++) {
+                for (uint32_t i = 0; i < 16; i++) mean[c] += block.c[c][i];
+                mean[c] *= 1.f / 16.f;
+            }
+            float cov[4][4] = {};
+            for (uint32_t i = 0; i < 16; i++) {
+                for (uint32_t a = 0; a < channelCount; a++)
+                    for (uint32_t b = 0; b < channelCount; b++)
+                        cov[a][b] += (block.c[a][i] - mean[a]) * (block.c[b][i] - mean[b]);
+            }
+
+            // NOTE: power iteration, starting from the channel with the most variance.
+            uint32_t k = 0;
+            for (uint32_t c = 1; c < channelCount; c++)
+                if (cov[c][c] > cov[k][k]) k = c;
+            float axis[4] = {};
+            for (uint32_t c = 0; c < channelCount; c++) axis[c] = cov[k][c];
+            for (uint32_t iter = 0; iter < 3; iter++) {
+                float next[4] = {}, scale = 0.f;
+                for (uint32_t a = 0; a < channelCount; a++) {
+                    for (uint32_t b = 0; b < channelCount; b++) next[a] += cov[a][b] * axis[b];
+                    scale = math::max(scale, fabsf(next[a]));
+                }
+                if (scale == 0.f) break;
+                for (uint32_t c = 0; c < channelCount; c++) axis[c] = next[c] / scale;
+            }
+            float length = 0.f;
+            for (uint32_t c = 0; c < channelCount; c++) length += axis[c] * axis[c];
+            length = sqrtf(length);
+
+            for (uint32_t c = 0; c < 4; c++) e0[c] = e1[c] = mean[c];
+            if (length < 1e-6f) return;
+            for (uint32_t c = 0; c < channelCount; c++) axis[c] /= length;
+
+            float minT = FLT_MAX, maxT = -FLT_MAX;
+            for (uint32_t i = 0; i < 16; i++) {
+                float t = 0.f;
+                for (uint32_t c = 0; c < channelCount; c++) t += (block.c[c][i] - mean[c]) * axis[c];
+                minT = math::min(minT, t);
+                maxT = math::max(maxT, t);
+            }
+            for (uint32_t c = 0; c < channelCount; c++) {
+                e0[c] = Clamp255(mean[c] + axis[c] * minT);
+                e1[c] = Clamp255(mean[c] + axis[c] * maxT);
+            }
+        }
+
+        // least squares fit of the endpoints for a fixed choice of indices. pixel i is reconstructed as
+        // e0 * (1 - weights[i]) + e1 * weights[i].
+        static bool RefineEndpoints(
+            const block_t &block, uint32_t channelCount, const float *weights, float e0[4], float e1[4])
+        {
+            float aa = 0.f, ab = 0.f, bb = 0.f;
+            float ap[4] = {}, bp[4] = {};
+            for (uint32_t i = 0; i < 16; i++) {
+                float b = weights[i], a = 1.f - b;
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                for (uint32_t c = 0; c < channelCount; c++) {
+                    ap[c] += a * block.c[c][i];
+                    bp[c] += b * block.c[c][i];
+                }
+            }
+            float det = aa * bb - ab * ab;
+            if (fabsf(det) < 1e-6f) return false;
+            float invDet = 1.f / det;
+            for (uint32_t c = 0; c < channelCount; c++) {
+                e0[c] = Clamp255((bb * ap[c] - ab * bp[c]) * invDet);
+                e1[c] = Clamp255((aa * bp[c] - ab * ap[c]) * invDet);
+            }
+            return true;
+        }
+
+        static void WriteBits(uint8_t *out, uint32_t *pPos, uint32_t value, uint32_t count)
+        {
+            for (uint32_t i = 0; i < count; i++, (*pPos)++)
+                if ((value >> i) & 1) out[*pPos >> 3] |= uint8_t(1 << (*pPos & 7));
+        }
+
+        static uint32_t ReadBits(const uint8_t *in, uint32_t *pPos, uint32_t count)
+        {
+            uint32_t value = 0;
+            for (uint32_t i = 0; i < count; i++, (*pPos)++) value |= uint32_t((in[*pPos >> 3] >> (*pPos & 7)) & 1) << i;
+            return value;
+        }
+
+        // ---- BC1 ----
+
+        static uint16_t PackRGB565(const float c[4])
+        {
+            uint32_t r = uint32_t(Clamp255(c[0]) * (31.f / 255.f) + 0.5f);
+            uint32_t g = uint32_t(Clamp255(c[1]) * (63.f / 255.f) + 0.5f);
+            uint32_t b = uint32_t(Clamp255(c[2]) * (31.f / 255.f) + 0.5f);
+            return uint16_t((r << 11) | (g << 5) | b);
+        }
+
+        static uint32_t UnpackRGB565(uint16_t v)
+        {
+            uint32_t r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+            return ((r << 3) | (r >> 2)) | (((g << 2) | (g >> 4)) << 8) | (((b << 3) | (b >> 2)) << 16) | 0xFF000000;
+        }
+
+        static uint32_t LerpPixel(uint32_t a, uint32_t b, uint32_t wa, uint32_t wb, uint32_t denom)
+        {
+            uint32_t result = 0;
+            for (uint32_t c = 0; c < 32; c += 8)
+                result |= (((((a >> c) & 0xFF) * wa + ((b >> c) & 0xFF) * wb) / denom) & 0xFF) << c;
+            return result;
+        }
+
+        static void DecodeBC1Palette(uint16_t c0, uint16_t c1, bool bForceFourColor, uint32_t palette[4])
+        {
+            palette[0] = UnpackRGB565(c0);
+            palette[1] = UnpackRGB565(c1);
+            if (c0 > c1 || bForceFourColor) {
+                palette[2] = LerpPixel(palette[0], palette[1], 2, 1, 3);
+                palette[3] = LerpPixel(palette[0], palette[1], 1, 2, 3);
+            } else {
+                palette[2] = LerpPixel(palette[0], palette[1], 1, 1, 2);
+                palette[3] = 0;
+            }
+        }
+
+        static void EncodeBC1(const block_t &block, uint8_t *out)
+        {
+            // NOTE: weight of c1 for each palette index in four color mode.
+            static const float weightsOfIndex[4] = {0.f, 1.f, 1.f / 3.f, 2.f / 3.f};
+
+            float e0[4], e1[4];
+            FitPrincipalAxis(block, 3, e0, e1);
+            float bestError = FLT_MAX;
+            for (uint32_t iter = 0; iter < 2; iter++) {
+                uint16_t c0 = PackRGB565(e0), c1 = PackRGB565(e1);
+                // c0 > c1 selects the four color mode.
+                if (c0 < c1) {
+                    uint16_t t = c0;
+                    c0         = c1;
+                    c1         = t;
+                }
+                uint32_t palette[4];
+                DecodeBC1Palette(c0, c1, true, palette);
+                float paletteF[4][4];
+                for (uint32_t e = 0; e < 4; e++)
+                    for (uint32_t c = 0; c < 4; c++) paletteF[e][c] = float((palette[e] >> (c * 8)) & 0xFF);
+                uint8_t indices[16];
+                // NOTE: when c0 == c1 the block is in three color mode, so only index 0 is safe to use.
+                float error = SelectIndices(block, 0, 3, paletteF, (c0 == c1) ? 1 : 4, indices);
+                if (error < bestError) {
+                    bestError = error;
+                    memset(out, 0, 8);
+                    uint32_t pos = 0;
+                    WriteBits(out, &pos, c0, 16);
+                    WriteBits(out, &pos, c1, 16);
+                    for (uint32_t i = 0; i < 16; i++) WriteBits(out, &pos, indices[i], 2);
+                }
+                if (c0 == c1) break;
+
+                float weights[16];
+                for (uint32_t i = 0; i < 16; i++) weights[i] = weightsOfIndex[indices[i]];
+                uint32_t p0 = UnpackRGB565(c0), p1 = UnpackRGB565(c1);
+                for (uint32_t c = 0; c < 3; c++) {
+                    e0[c] = float((p0 >> (c * 8)) & 0xFF);
+                    e1[c] = float((p1 >> (c * 8)) & 0xFF);
+                }
+                if (!RefineEndpoints(block, 3, weights, e0, e1)) break;
+            }
+        }
+
+        static void DecodeBC1(const uint8_t *in, bool bForceFourColor, uint32_t pixelsOut[16])
+        {
+            uint32_t pos = 0;
+            uint16_t c0  = uint16_t(ReadBits(in, &pos, 16));
+            uint16_t c1  = uint16_t(ReadBits(in, &pos, 16));
+            uint32_t palette[4];
+            DecodeBC1Palette(c0, c1, bForceFourColor, palette);
+            for (uint32_t i = 0; i < 16; i++) pixelsOut[i] = palette[ReadBits(in, &pos, 2)];
+        }
+
+        // ---- BC4 (the alpha block of BC3 and both blocks of BC5) ----
+
+        static void DecodeBC4Palette(uint8_t e0, uint8_t e1, uint8_t palette[8])
+        {
+            palette[0] = e0;
+            palette[1] = e1;
+            if (e0 > e1) {
+                for (uint32_t k = 2; k < 8; k++) palette[k] = uint8_t(((8 - k) * e0 + (k - 1) * e1 + 3) / 7);
+            } else {
+                for (uint32_t k = 2; k < 6; k++) palette[k] = uint8_t(((6 - k) * e0 + (k - 1) * e1 + 2) / 5);
+                palette[6] = 0;
+                palette[7] = 255;
+            }
+        }
+
+        static void EncodeBC4(const block_t &block, uint32_t channel, uint8_t *out)
+        {
+            float minV = 255.f, maxV = 0.f;
+            for (uint32_t i = 0; i < 16; i++) {
+                minV = math::min(minV, block.c[channel][i]);
+                maxV = math::max(maxV, block.c[channel][i]);
+            }
+            uint8_t e0 = uint8_t(maxV + 0.5f), e1 = uint8_t(minV + 0.5f);
+            uint8_t palette[8];
+            DecodeBC4Palette(e0, e1, palette);
+            float paletteF[8][4] = {};
+            for (uint32_t e = 0; e < 8; e++) paletteF[e][0] = palette[e];
+            uint8_t indices[16];
+            // NOTE: when e0 == e1 every entry of the palette that matters is e0.
+            SelectIndices(block, channel, 1, paletteF, (e0 == e1) ? 1 : 8, indices);
+
+            memset(out, 0, 8);
+            uint32_t pos = 0;
+            WriteBits(out, &pos, e0, 8);
+            WriteBits(out, &pos, e1, 8);
+            for (uint32_t i = 0; i < 16; i++) WriteBits(out, &pos, indices[i], 3);
+        }
+
+        static void DecodeBC4(const uint8_t *in, uint32_t channel, uint32_t pixelsOut[16])
+        {
+            uint8_t palette[8];
+            DecodeBC4Palette(in[0], in[1], palette);
+            uint32_t pos = 16;
+            uint32_t mask = ~(0xFFu << (channel * 8));
+            for (uint32_t i = 0; i < 16; i++)
+                pixelsOut[i] = (pixelsOut[i] & mask) | (uint32_t(palette[ReadBits(in, &pos, 3)]) << (channel * 8));
+        }
+
+        // ---- BC7 ----
+        //
+        // NOTE: only mode 6 is encoded, i.e. one subset with RGBA endpoints of 7 bits + a p-bit and 4 bit indices.
+        // it is the mode with the most precise palette and handles most blocks well.
+
+        static const uint32_t BC7_WEIGHTS4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        struct bc7_endpoint_t {
+            uint8_t q[4];  // 7 bit channel values.
+            uint8_t p;     // p-bit shared by the channels.
+        };
+
+        static uint32_t BC7EndpointChannel(const bc7_endpoint_t &e, uint32_t c) { return (e.q[c] << 1) | e.p; }
+
+        static bc7_endpoint_t QuantizeBC7Endpoint(const float e[4])
+        {
+            bc7_endpoint_t best      = {};
+            float          bestError = FLT_MAX;
+            for (uint8_t p = 0; p < 2; p++) {
+                bc7_endpoint_t candidate = {};
+                candidate.p              = p;
+                float error              = 0.f;
+                for (uint32_t c = 0; c < 4; c++) {
+                    int q          = int((e[c] - p) * 0.5f + 0.5f);
+                    candidate.q[c] = uint8_t(math::max(0, math::min(q, 127)));
+                    error += math::square(float(BC7EndpointChannel(candidate, c)) - e[c]);
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    best      = candidate;
+                }
+            }
+            return best;
+        }
+
+        static uint32_t BC7Interpolate(uint32_t a, uint32_t b, uint32_t weight)
+        {
+            return ((64 - weight) * a + weight * b + 32) >> 6;
+        }
+
+        static void EncodeBC7(const block_t &block, uint8_t *out)
+        {
+            float e0[4], e1[4];
+            FitPrincipalAxis(block, 4, e0, e1);
+
+            float          bestError = FLT_MAX;
+            bc7_endpoint_t best0 = {}, best1 = {};
+            uint8_t        bestIndices[16] = {};
+            for (uint32_t iter = 0; iter < 3; iter++) {
+                bc7_endpoint_t q0 = QuantizeBC7Endpoint(e0), q1 = QuantizeBC7Endpoint(e1);
+                float          palette[16][4];
+                for (uint32_t e = 0; e < 16; e++)
+                    for (uint32_t c = 0; c < 4; c++)
+                        palette[e][c] = float(BC7Interpolate(
+                            BC7EndpointChannel(q0, c), BC7EndpointChannel(q1, c), BC7_WEIGHTS4[e]));
+                uint8_t indices[16];
+                float   error = SelectIndices(block, 0, 4, palette, 16, indices);
+                if (error < bestError) {
+                    bestError = error;
+                    best0     = q0;
+                    best1     = q1;
+                    memcpy(bestIndices, indices, 16);
+                }
+
+                float weights[16];
+                for (uint32_t i = 0; i < 16; i++) weights[i] = BC7_WEIGHTS4[indices[i]] / 64.f;
+                if (!RefineEndpoints(block, 4, weights, e0, e1)) break;
+            }
+
+            // NOTE: the first index is stored without its top bit, so it must be < 8.
+            if (bestIndices[0] & 8) {
+                bc7_endpoint_t t = best0;
+                best0            = best1;
+                best1            = t;
+                for (uint32_t i = 0; i < 16; i++) bestIndices[i] = 15 - bestIndices[i];
+            }
+
+            memset(out, 0, 16);
+            uint32_t pos = 0;
+            WriteBits(out, &pos, 1 << 6, 7);
+            for (uint32_t c = 0; c < 4; c++) {
+                WriteBits(out, &pos, best0.q[c], 7);
+                WriteBits(out, &pos, best1.q[c], 7);
+            }
+            WriteBits(out, &pos, best0.p, 1);
+            WriteBits(out, &pos, best1.p, 1);
+            for (uint32_t i = 0; i < 16; i++) WriteBits(out, &pos, bestIndices[i], (i == 0) ? 3 : 4);
+        }
+
+        static bool DecodeBC7(const uint8_t *in, uint32_t pixelsOut[16])
+        {
+            if ((in[0] & 0x7F) != 0x40) {
+                for (uint32_t i = 0; i < 16; i++) pixelsOut[i] = 0;
+                return false;
+            }
+            uint32_t       pos = 7;
+            bc7_endpoint_t e0 = {}, e1 = {};
+            for (uint32_t c = 0; c < 4; c++) {
+                e0.q[c] = uint8_t(ReadBits(in, &pos, 7));
+                e1.q[c] = uint8_t(ReadBits(in, &pos, 7));
+            }
+            e0.p = uint8_t(ReadBits(in, &pos, 1));
+            e1.p = uint8_t(ReadBits(in, &pos, 1));
+            for (uint32_t i = 0; i < 16; i++) {
+                uint32_t weight = BC7_WEIGHTS4[ReadBits(in, &pos, (i == 0) ? 3 : 4)];
+                uint32_t pixel  = 0;
+                for (uint32_t c = 0; c < 4; c++)
+                    pixel |= BC7Interpolate(BC7EndpointChannel(e0, c), BC7EndpointChannel(e1, c), weight) << (c * 8);
+                pixelsOut[i] = pixel;
+            }
+            return true;
+        }
+
+        void compressBlocks(
+            const uint32_t *pixels, uint32_t width, uint32_t height, texture_format_t format, void *blocksOut)
+        {
+            if (!isCompressed(format)) {
+                memcpy(blocksOut, pixels, getLevelSize(format, width, height));
+                return;
+            }
+            uint32_t blockSize = getBlockSize(format);
+            uint32_t blocksX   = math::div_ceil(width, 4);
+            uint32_t blocksY   = math::div_ceil(height, 4);
+            // NOTE: small images get several block rows per job so that each job has a worthwhile amount of work.
+            uint32_t grain = math::max(1u, 64 / blocksX);
+            jobs::parallelFor(blocksY, grain, [&](uint32_t begin, uint32_t end) {
+                block_t block;
+                for (uint32_t by = begin; by < end; by++) {
+                    for (uint32_t bx = 0; bx < blocksX; bx++) {
+                        LoadBlock(pixels, width, height, bx, by, &block);
+                        uint8_t *out = (uint8_t *)blocksOut + (size_t(by) * blocksX + bx) * blockSize;
+                        switch (format) {
+                            case TEXTURE_FORMAT_BC1:
+                            case TEXTURE_FORMAT_BC1_SRGB:
+                                EncodeBC1(block, out);
+                                break;
+                            case TEXTURE_FORMAT_BC3:
+                            case TEXTURE_FORMAT_BC3_SRGB:
+                                EncodeBC4(block, 3, out);
+                                EncodeBC1(block, out + 8);
+                                break;
+                            case TEXTURE_FORMAT_BC5:
+                                EncodeBC4(block, 0, out);
+                                EncodeBC4(block, 1, out + 8);
+                                break;
+                            case TEXTURE_FORMAT_BC7:
+                            case TEXTURE_FORMAT_BC7_SRGB:
+                                EncodeBC7(block, out);
+                                break;
+                            default:
+                                assert(!"unhandled texture format");
+                        }
+                    }
+                }
+            });
+        }
+
+        bool decompressBlocks(
+            const void *blocks, uint32_t width, uint32_t height, texture_format_t format, uint32_t *pixelsOut)
+        {
+            if (!isCompressed(format)) {
+                memcpy(pixelsOut, blocks, getLevelSize(format, width, height));
+                return true;
+            }
+            uint32_t blockSize = getBlockSize(format);
+            uint32_t blocksX   = math::div_ceil(width, 4);
+            uint32_t blocksY   = math::div_ceil(height, 4);
+            bool     bResult   = true;
+            for (uint32_t by = 0; by < blocksY; by++) {
+                for (uint32_t bx = 0; bx < blocksX; bx++) {
+                    const uint8_t *in = (const uint8_t *)blocks + (size_t(by) * blocksX + bx) * blockSize;
+                    uint32_t       decoded[16];
+                    switch (format) {
+                        case TEXTURE_FORMAT_BC1:
+                        case TEXTURE_FORMAT_BC1_SRGB:
+                            DecodeBC1(in, false, decoded);
+                            break;
+                        case TEXTURE_FORMAT_BC3:
+                        case TEXTURE_FORMAT_BC3_SRGB:
+                            DecodeBC1(in + 8, true, decoded);
+                            DecodeBC4(in, 3, decoded);
+                            break;
+                        case TEXTURE_FORMAT_BC5:
+                            for (uint32_t i = 0; i < 16; i++) decoded[i] = 0xFF000000;
+                            DecodeBC4(in, 0, decoded);
+                            DecodeBC4(in + 8, 1, decoded);
+                            break;
+                        case TEXTURE_FORMAT_BC7:
+                        case TEXTURE_FORMAT_BC7_SRGB:
+                            if (!DecodeBC7(in, decoded)) bResult = false;
+                            break;
+                        default:
+                            return false;
+                    }
+                    for (uint32_t y = 0; y < 4 && by * 4 + y < height; y++)
+                        for (uint32_t x = 0; x < 4 && bx * 4 + x < width; x++)
+                            pixelsOut[size_t(by * 4 + y) * width + bx * 4 + x] = decoded[y * 4 + x];
+                }
+            }
+            return bResult;
+        }
+
+        texture_t compress(const texture_t &source, texture_format_t format)
+        {
+            if (source.format != TEXTURE_FORMAT_RGBA8 && source.format != TEXTURE_FORMAT_RGBA8_SRGB) {
+                AELoggerError("compress expects an RGBA8 source texture, not format %u", source.format);
+                return {};
+            }
+            texture_t result = createTexture(format, source.width, source.height, source.levelCount);
+            if (!result.data) return result;
+            for (uint32_t i = 0; i < result.levelCount; i++) {
+                const texture_level_t &level = source.levels[i];
+                compressBlocks((const uint32_t *)(source.data + level.offset),
+                    level.width,
+                    level.height,
+                    format,
+                    result.data + result.levels[i].offset);
+            }
+            return result;
+        }
+
+        float computePSNR(const uint32_t *a, const uint32_t *b, uint32_t pixelCount, uint32_t channelMask)
+        {
+            uint64_t sum          = 0;
+            uint32_t channelCount = 0;
+            for (uint32_t c = 0; c < 32; c += 8) {
+                if (!((channelMask >> c) & 0xFF)) continue;
+                channelCount++;
+                for (uint32_t i = 0; i < pixelCount; i++) {
+                    int d = int((a[i] >> c) & 0xFF) - int((b[i] >> c) & 0xFF);
+                    sum += uint64_t(d * d);
+                }
+            }
+            if (sum == 0) return INFINITY;
+            double mse = double(sum) / (double(pixelCount) * channelCount);
+            return float(10.0 * ::log10(255.0 * 255.0 / mse));
+        }
+
+        // ----------------------------------- containers -----------------------------------
+
+        static texture_t ParseDDS(const uint8_t *data, size_t size, const char *path)
+        {
+            if (size < sizeof(dds_header_t)) {
+                AELoggerError("'%s' is too small to be a .DDS file", path);
+                return {};
+            }
+            dds_header_t header = {};
+            memcpy(&header, data, sizeof(header));
+            size_t offset = sizeof(header);
+
+            texture_format_t          format = TEXTURE_FORMAT_UNKNOWN;
+            const dds_pixel_format_t &pf     = header.pixelFormat;
+            if (pf.flags & DDPF_FOURCC) {
+                if (pf.fourCC == FourCC('D', 'X', '1', '0')) {
+                    dds_header_dx10_t dx10 = {};
+                    if (size < offset + sizeof(dx10)) {
+                        AELoggerError("'%s' is missing its DX10 header", path);
+                        return {};
+                    }
+                    memcpy(&dx10, data + offset, sizeof(dx10));
+                    offset += sizeof(dx10);
+                    if (dx10.resourceDimension != DDS_DIMENSION_TEXTURE2D || dx10.arraySize > 1) {
+                        AELoggerError("'%s' is not a single 2D texture", path);
+                        return {};
+                    }
+                    format = FormatFromDXGI(dx10.dxgiFormat);
+                } else if (pf.fourCC == FourCC('D', 'X', 'T', '1')) {
+                    format = TEXTURE_FORMAT_BC1;
+                } else if (pf.fourCC == FourCC('D', 'X', 'T', '5')) {
+                    format = TEXTURE_FORMAT_BC3;
+                } else if (pf.fourCC == FourCC('A', 'T', 'I', '2') || pf.fourCC == FourCC('B', 'C', '5', 'U')) {
+                    format = TEXTURE_FORMAT_BC5;
+                }
+            } else if ((pf.flags & DDPF_RGB) && pf.rgbBitCount == 32 && pf.rMask == 0xFF && pf.gMask == 0xFF00 &&
+                       pf.bMask == 0xFF0000) {
+                format = TEXTURE_FORMAT_RGBA8;
+            }
+            if (format == TEXTURE_FORMAT_UNKNOWN) {
+                AELoggerError("'%s' has an unsupported .DDS pixel format", path);
+                return {};
+            }
+            if ((header.caps2 & DDSCAPS2_CUBEMAP) || ((header.flags & DDSD_DEPTH) && header.depth > 1)) {
+                AELoggerError("'%s' is not a 2D texture", path);
+                return {};
+            }
+
+            uint32_t levelCount = ((header.flags & DDSD_MIPMAPCOUNT) && header.mipMapCount) ? header.mipMapCount : 1;
+            if (levelCount > getMaxLevelCount(header.width, header.height)) {
+                AELoggerError("'%s' has too many mip levels", path);
+                return {};
+            }
+            texture_t texture = createTexture(format, header.width, header.height, levelCount);
+            if (!texture.data) return texture;
+            if (size < offset + texture.dataSize) {
+                AELoggerError("'%s' is truncated", path);
+                freeTexture(texture);
+                return {};
+            }
+            // NOTE: the levels in a .DDS file are contiguous and in the same order as texture_t keeps them.
+            memcpy(texture.data, data + offset, texture.dataSize);
+            return texture;
+        }
+
+        static texture_t ParseKTX2(const uint8_t *data, size_t size, const char *path)
+        {
+            if (size < sizeof(ktx2_header_t)) {
+                AELoggerError("'%s' is too small to be a .KTX2 file", path);
+                return {};
+            }
+            ktx2_header_t header = {};
+            memcpy(&header, data, sizeof(header));
+            texture_format_t format = FormatFromVk(header.vkFormat);
+            if (format == TEXTURE_FORMAT_UNKNOWN) {
+                AELoggerError("'%s' has an unsupported VkFormat %u", path, header.vkFormat);
+                return {};
+            }
+            if (header.supercompressionScheme != 0) {
+                AELoggerError("'%s' is supercompressed, which is not supported", path);
+                return {};
+            }
+            if (header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1) {
+                AELoggerError("'%s' is not a single 2D texture", path);
+                return {};
+            }
+
+            // NOTE: levelCount == 0 asks the loader to generate the mips, which we leave to the caller.
+            uint32_t levelCount = math::max(header.levelCount, 1u);
+            if (levelCount > getMaxLevelCount(header.pixelWidth, header.pixelHeight) ||
+                size < sizeof(header) + sizeof(ktx2_level_t) * levelCount) {
+                AELoggerError("'%s' has an invalid level index", path);
+                return {};
+            }
+            texture_t texture = createTexture(format, header.pixelWidth, header.pixelHeight, levelCount);
+            if (!texture.data) return texture;
+            for (uint32_t i = 0; i < levelCount; i++) {
+                ktx2_level_t level = {};
+                memcpy(&level, data + sizeof(header) + sizeof(level) * i, sizeof(level));
+                if (level.byteLength != texture.levels[i].size || level.byteOffset > size ||
+                    size - level.byteOffset < level.byteLength) {
+                    AELoggerError("'%s' level %u is invalid", path, i);
+                    freeTexture(texture);
+                    return {};
+                }
+                memcpy(texture.data + texture.levels[i].offset, data + level.byteOffset, texture.levels[i].size);
+            }
+            return texture;
+        }
+
+        texture_t loadTexture(const char *path)
+        {
+            loaded_file_t file = EM->pfn.readEntireFile(path);
+            if (!file.contents) {
+                AELoggerError("failed to read texture '%s'", path);
+                return {};
+            }
+            defer(EM->pfn.freeLoadedFile(file));
+
+            const uint8_t *data = (const uint8_t *)file.contents;
+            size_t         size = file.contentSize;
+            if (size >= 4 && *(const uint32_t *)data == DDS_MAGIC) return ParseDDS(data, size, path);
+            if (size >= sizeof(KTX2_IDENTIFIER) && !memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)))
+                return ParseKTX2(data, size, path);
+            AELoggerError("'%s' is neither a .DDS nor a .KTX2 file", path);
+            return {};
+        }
+
+        bool writeDDS(const char *path, const texture_t &texture)
+        {
+            const format_info_t *info = GetFormatInfo(texture.format);
+            if (!info || !texture.data) return false;
+
+            uint32_t size = sizeof(dds_header_t) + sizeof(dds_header_dx10_t) + texture.dataSize;
+            uint8_t *file = (uint8_t *)EM->pfn.alloc(size);
+            if (!file) return false;
+            defer(EM->pfn.free(file));
+
+            dds_header_t header = {};
+            header.magic        = DDS_MAGIC;
+            header.size         = sizeof(dds_header_t) - sizeof(header.magic);
+            header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT |
+                           (isCompressed(texture.format) ? DDSD_LINEARSIZE : DDSD_PITCH);
+            header.height            = texture.height;
+            header.width             = texture.width;
+            header.pitchOrLinearSize = isCompressed(texture.format) ? texture.levels[0].size : texture.width * 4;
+            header.mipMapCount       = texture.levelCount;
+            header.pixelFormat.size  = sizeof(dds_pixel_format_t);
+            header.pixelFormat.flags = DDPF_FOURCC;
+            header.pixelFormat.fourCC = FourCC('D', 'X', '1', '0');
+            header.caps = DDSCAPS_TEXTURE | ((texture.levelCount > 1) ? (DDSCAPS_MIPMAP | DDSCAPS_COMPLEX) : 0);
+
+            dds_header_dx10_t dx10 = {};
+            dx10.dxgiFormat        = info->dxgiFormat;
+            dx10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+            dx10.arraySize         = 1;
+
+            memcpy(file, &header, sizeof(header));
+            memcpy(file + sizeof(header), &dx10, sizeof(dx10));
+            memcpy(file + sizeof(header) + sizeof(dx10), texture.data, texture.dataSize);
+            return EM->pfn.writeEntireFile(path, file, size);
+        }
+
+        // write the Khronos data format descriptor for the format. returns the size in bytes.
+        static uint32_t WriteKTX2DFD(texture_format_t format, uint32_t *out)
+        {
+            constexpr uint32_t KHR_DF_MODEL_RGBSDA           = 1;
+            constexpr uint32_t KHR_DF_MODEL_BC1A             = 128;
+            constexpr uint32_t KHR_DF_MODEL_BC3              = 130;
+            constexpr uint32_t KHR_DF_MODEL_BC5              = 132;
+            constexpr uint32_t KHR_DF_MODEL_BC7              = 134;
+            constexpr uint32_t KHR_DF_PRIMARIES_BT709        = 1;
+            constexpr uint32_t KHR_DF_TRANSFER_LINEAR        = 1;
+            constexpr uint32_t KHR_DF_TRANSFER_SRGB          = 2;
+            constexpr uint32_t KHR_DF_SAMPLE_DATATYPE_LINEAR = 0x10;
+            struct sample_t {
+                uint32_t bitOffset, bitLength, channelType, upper;
+            };
+            sample_t samples[4];
+            uint32_t sampleCount = 0, model = 0;
+            // NOTE: alpha is never sRGB encoded.
+            const uint32_t alphaChannel = 15u | (isSRGB(format) ? KHR_DF_SAMPLE_DATATYPE_LINEAR : 0u);
+            switch (format) {
+                case TEXTURE_FORMAT_RGBA8:
+                case TEXTURE_FORMAT_RGBA8_SRGB:
+                    model = KHR_DF_MODEL_RGBSDA;
+                    for (uint32_t c = 0; c < 3; c++) samples[sampleCount++] = {c * 8, 8, c, 255};
+                    samples[sampleCount++] = {24, 8, alphaChannel, 255};
+                    break;
+                case TEXTURE_FORMAT_BC1:
+                case TEXTURE_FORMAT_BC1_SRGB:
+                    model                  = KHR_DF_MODEL_BC1A;
+                    samples[sampleCount++] = {0, 64, 0, 0xFFFFFFFF};
+                    break;
+                case TEXTURE_FORMAT_BC3:
+                case TEXTURE_FORMAT_BC3_SRGB:
+                    model                  = KHR_DF_MODEL_BC3;
+                    samples[sampleCount++] = {0, 64, alphaChannel, 0xFFFFFFFF};
+                    samples[sampleCount++] = {64, 64, 0, 0xFFFFFFFF};
+                    break;
+                case TEXTURE_FORMAT_BC5:
+                    model                  = KHR_DF_MODEL_BC5;
+                    samples[sampleCount++] = {0, 64, 0, 0xFFFFFFFF};
+                    samples[sampleCount++] = {64, 64, 1, 0xFFFFFFFF};
+                    break;
+                case TEXTURE_FORMAT_BC7:
+                case TEXTURE_FORMAT_BC7_SRGB:
+                    model                  = KHR_DF_MODEL_BC7;
+                    samples[sampleCount++] = {0, 128, 0, 0xFFFFFFFF};
+                    break;
+                default:
+                    return 0;
+            }
+            uint32_t blockDim  = isCompressed(format) ? 3 : 0;
+            uint32_t blockSize = 24 + 16 * sampleCount;
+            out[0]             = 4 + blockSize;  // dfdTotalSize.
+            out[1]             = 0;              // vendorId, descriptorType.
+            out[2]             = 2 | (blockSize << 16);
+            out[3] = model | (KHR_DF_PRIMARIES_BT709 << 8) |
+                     ((isSRGB(format) ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR) << 16);
+            out[4] = blockDim | (blockDim << 8);
+            out[5] = getBlockSize(format);
+            out[6] = 0;
+            for (uint32_t i = 0; i < sampleCount; i++) {
+                uint32_t *s = out + 7 + i * 4;
+                s[0]        = samples[i].bitOffset | ((samples[i].bitLength - 1) << 16) | (samples[i].channelType << 24);
+                s[1]        = 0;
+                s[2]        = 0;
+                s[3]        = samples[i].upper;
+            }
+            return out[0];
+        }
+
+        bool writeKTX2(const char *path, const texture_t &texture)
+        {
+            const format_info_t *info = GetFormatInfo(texture.format);
+            if (!info || !texture.data) return false;
+
+            uint32_t dfd[7 + 4 * 4];
+            uint32_t dfdSize = WriteKTX2DFD(texture.format, dfd);
+
+            uint32_t keyAndValueSize = sizeof(KTX2_ORIENTATION_KEY) + sizeof(KTX2_ORIENTATION_VALUE);
+            uint32_t kvdSize         = math::align_up(4 + keyAndValueSize, 4);
+
+            uint32_t dfdOffset = sizeof(ktx2_header_t) + sizeof(ktx2_level_t) * texture.levelCount;
+            uint32_t kvdOffset = dfdOffset + dfdSize;
+            uint32_t size      = kvdOffset + kvdSize;
+
+            // NOTE: the level data is stored smallest level first, each level aligned to the block size.
+            ktx2_level_t levels[TEXTURE_MAX_LEVELS] = {};
+            for (uint32_t i = texture.levelCount; i-- > 0;) {
+                size                         = math::align_up(size, info->blockSize);
+                levels[i].byteOffset             = size;
+                levels[i].byteLength             = texture.levels[i].size;
+                levels[i].uncompressedByteLength = texture.levels[i].size;
+                size += texture.levels[i].size;
+            }
+
+            uint8_t *file = (uint8_t *)EM->pfn.alloc(size);
+            if (!file) return false;
+            defer(EM->pfn.free(file));
+            memset(file, 0, size);
+
+            ktx2_header_t header = {};
+            memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+            header.vkFormat      = info->vkFormat;
+            header.typeSize      = 1;
+            header.pixelWidth    = texture.width;
+            header.pixelHeight   = texture.height;
+            header.faceCount     = 1;
+            header.levelCount    = texture.levelCount;
+            header.dfdByteOffset = dfdOffset;
+            header.dfdByteLength = dfdSize;
+            header.kvdByteOffset = kvdOffset;
+            header.kvdByteLength = kvdSize;
+            memcpy(file, &header, sizeof(header));
+            memcpy(file + sizeof(header), levels, sizeof(ktx2_level_t) * texture.levelCount);
+            memcpy(file + dfdOffset, dfd, dfdSize);
+            memcpy(file + kvdOffset, &keyAndValueSize, 4);
+            memcpy(file + kvdOffset + 4, KTX2_ORIENTATION_KEY, sizeof(KTX2_ORIENTATION_KEY));
+            memcpy(file + kvdOffset + 4 + sizeof(KTX2_ORIENTATION_KEY), KTX2_ORIENTATION_VALUE,
+                sizeof(KTX2_ORIENTATION_VALUE));
+            for (uint32_t i = 0; i < texture.levelCount; i++)
+                memcpy(file + levels[i].byteOffset, texture.data + texture.levels[i].offset, texture.levels[i].size);
+            return EM->pfn.writeEntireFile(path, file, size);
+        }
+
+    }  // namespace texture
+}  // namespace automata_engine
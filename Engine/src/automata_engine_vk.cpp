@@ -166,6 +166,55 @@ namespace automata_engine {
             return image;
         }
 
+        VkFormat getTextureFormat(texture::texture_format_t format)
+        {
+            switch (format) {
+                case texture::TEXTURE_FORMAT_RGBA8:
+                    return VK_FORMAT_R8G8B8A8_UNORM;
+                case texture::TEXTURE_FORMAT_RGBA8_SRGB:
+                    return VK_FORMAT_R8G8B8A8_SRGB;
+                case texture::TEXTURE_FORMAT_BC1:
+                    return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+                case texture::TEXTURE_FORMAT_BC1_SRGB:
+                    return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+                case texture::TEXTURE_FORMAT_BC3:
+                    return VK_FORMAT_BC3_UNORM_BLOCK;
+                case texture::TEXTURE_FORMAT_BC3_SRGB:
+                    return VK_FORMAT_BC3_SRGB_BLOCK;
+                case texture::TEXTURE_FORMAT_BC5:
+                    return VK_FORMAT_BC5_UNORM_BLOCK;
+                case texture::TEXTURE_FORMAT_BC7:
+                    return VK_FORMAT_BC7_UNORM_BLOCK;
+                case texture::TEXTURE_FORMAT_BC7_SRGB:
+                    return VK_FORMAT_BC7_SRGB_BLOCK;
+                default:
+                    return VK_FORMAT_UNDEFINED;
+            }
+        }
+
+        Image createImage(const texture::texture_t &texture, VkImageUsageFlags usage)
+        {
+            return createImage(texture.width, texture.height, getTextureFormat(texture.format), usage)
+                .mipLevels(texture.levelCount);
+        }
+
+        void cmdCopyTextureToImage(
+            VkCommandBuffer cmd, VkBuffer src, VkDeviceSize srcOffset, VkImage dst, const texture::texture_t &texture)
+        {
+            VkBufferImageCopy regions[texture::TEXTURE_MAX_LEVELS] = {};
+            for (uint32_t i = 0; i < texture.levelCount; i++) {
+                const texture::texture_level_t &level = texture.levels[i];
+                VkBufferImageCopy              &region = regions[i];
+                // NOTE: a zero row length and image height means that the levels are tightly packed, which they are.
+                region.bufferOffset                   = srcOffset + level.offset;
+                region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+                region.imageSubresource.mipLevel       = i;
+                region.imageSubresource.layerCount     = 1;
+                region.imageExtent                     = {level.width, level.height, 1};
+            }
+            vkCmdCopyBufferToImage(cmd, src, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, texture.levelCount, regions);
+        }
+
         size_t createImage_dumb(
             VkDevice device, uint32_t heapIdx, const Image &imageInfo, VkImage *imageOut, VkDeviceMemory *memOut)
         {
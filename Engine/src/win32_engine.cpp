@@ -20,6 +20,12 @@
 #include <automata_engine.hpp>
 #include <win32_engine.h>
 
+#define AE_PAK_IMPL
+#include "automata_engine_pak.h"
+
+#define AE_FRENDER_IMPL
+#include "automata_engine_frender_platform.h"
+
 #define NOMINMAX
 #include <windows.h>
 #include <io.h> // TODO(Noah): What is this used for again?
@@ -43,6 +49,10 @@
 
 #include <timeapi.h> // for timeBeginPeriod.
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #pragma comment(lib, "Winmm.lib")
 
 #include <winuser.h>
@@ -84,9 +94,16 @@ static HFILE g_debugFileLog = NULL;
 // multiple threads, but Windows OS handles that sort of sync.
 static HANDLE g_inputThreadEvent = NULL;
 
-static ae::game_memory_t   g_gameMemory     = {};
-static ae::engine_memory_t g_engineMemory   = {};
-static win32_backbuffer_t  globalBackBuffer = {};
+static ae::game_memory_t   g_gameMemory   = {};
+static ae::engine_memory_t g_engineMemory = {};
+
+// NOTE: the fallback backbuffers. the render thread draws each frame into one while the present thread copies the
+// last one to the window, see Win32PresentHandlingLoop. the size is the client area, as of the last WM_SIZE.
+static ae::frender::backbuffer_ring_t *g_backbufferRing   = nullptr;
+static std::atomic<uint32_t>           g_backbufferWidth  = 0;
+static std::atomic<uint32_t>           g_backbufferHeight = 0;
+// NOTE: set by WM_PAINT for the present thread to copy the whole front buffer to the window again.
+static std::atomic<bool> g_bRepaintBackbuffer = false;
 
 static bool g_bIsWindowFocused = true;
 
@@ -96,14 +113,6 @@ void (*g_redirectedFprintf)(const char *) = nullptr;
 
 typedef void (*PFN_GameHandleWindowResize)(ae::game_memory_t *, int, int);
 typedef ae::PFN_GameFunctionKind (*PFN_GameGetUpdateAndRender)(ae::game_memory_t *);
-typedef void (*PFN_GameOnVoiceBufferEnd)(ae::game_memory_t *gameMemory, intptr_t voiceHandle);
-typedef void (*PFN_GameOnVoiceBufferProcess)(ae::game_memory_t *gameMemory,
-    intptr_t                                                    voiceHandle,
-    float *                                                     dst,
-    float *                                                     src,
-    uint32_t                                                    samplesToWrite,
-    int                                                         channels,
-    int                                                         bytesPerSample);
 
 /// On the Windows platform, when a WM_SIZE message is recieved, this callback is invoked.
 /// the provided width and height are the client dimensions of the window.
@@ -113,8 +122,8 @@ static ae::PFN_GameFunctionKind     GamePreInit              = nullptr;
 static ae::PFN_GameFunctionKind     GameHandleInput          = nullptr;
 static ae::PFN_GameFunctionKind     GameCleanup              = nullptr;
 static PFN_GameGetUpdateAndRender   GameGetUpdateAndRender   = nullptr;
-static PFN_GameOnVoiceBufferProcess GameOnVoiceBufferProcess = nullptr;
-static PFN_GameOnVoiceBufferEnd     GameOnVoiceBufferEnd     = nullptr;
+static ae::PFN_GameOnVoiceBufferProcess GameOnVoiceBufferProcess = nullptr;
+static ae::PFN_GameOnVoiceBufferEnd     GameOnVoiceBufferEnd     = nullptr;
 
 static ae::PFN_GameFunctionKind GameOnHotload = nullptr;
 static ae::PFN_GameFunctionKind GameOnUnload = nullptr;
@@ -213,8 +222,94 @@ bool Platform_writeEntireFile(
 	return Result;
 }
 
+// NOTE: when a resource pack sits next to the loose res\ folder, the pack is mapped once at startup and
+// readEntireFile serves any path found within it from the mapped view. anything not in the pack falls back to disk.
+// the build names the pack after the resource folder.
+#if !defined(AUTOMATA_ENGINE_RESOURCE_PAK)
+#define AUTOMATA_ENGINE_RESOURCE_PAK "res.aepak"
+#endif
+static const char *g_resourcePakPath = AUTOMATA_ENGINE_RESOURCE_PAK;
+
+static HANDLE         g_resourcePakFile    = INVALID_HANDLE_VALUE;
+static HANDLE         g_resourcePakMapping = NULL;
+static void          *g_resourcePakView    = nullptr;
+static ae::pak::pak_t g_resourcePak        = {};
+
+static void Win32CloseResourcePak()
+{
+    g_resourcePak = {};
+    if (g_resourcePakView) UnmapViewOfFile(g_resourcePakView);
+    if (g_resourcePakMapping) CloseHandle(g_resourcePakMapping);
+    if (g_resourcePakFile != INVALID_HANDLE_VALUE) CloseHandle(g_resourcePakFile);
+    g_resourcePakView    = nullptr;
+    g_resourcePakMapping = NULL;
+    g_resourcePakFile    = INVALID_HANDLE_VALUE;
+}
+
+static bool Win32OpenResourcePak(const char *pakPath)
+{
+    g_resourcePakFile = CreateFileA(
+        pakPath, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    if (g_resourcePakFile == INVALID_HANDLE_VALUE) {
+        // no pack is not an error, the resources are loose files.
+        return false;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if (GetFileSizeEx(g_resourcePakFile, &fileSize) && fileSize.QuadPart > 0) {
+        g_resourcePakMapping = CreateFileMappingA(g_resourcePakFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    }
+    if (g_resourcePakMapping) { g_resourcePakView = MapViewOfFile(g_resourcePakMapping, FILE_MAP_READ, 0, 0, 0); }
+
+    if (!g_resourcePakView || !ae::pak::open(&g_resourcePak, g_resourcePakView, fileSize.QuadPart)) {
+        AELoggerError("%s is not a valid resource pack", pakPath);
+        Win32CloseResourcePak();
+        return false;
+    }
+
+    // NOTE: ask the OS to bring in the whole pack with a few large sequential reads up front rather than
+    // taking a page fault per 4KB page as resources are first touched.
+    WIN32_MEMORY_RANGE_ENTRY range = {g_resourcePakView, (SIZE_T)fileSize.QuadPart};
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+
+    AELoggerLog("mapped resource pack %s with %u entries", pakPath, g_resourcePak.header->entryCount);
+    return true;
+}
+
+// returns true if the file was found in the resource pack.
+static bool Win32ReadFileFromResourcePak(const char *fileName, ae::loaded_file_t *pFileOut)
+{
+    const ae::pak::pak_entry_t *entry = ae::pak::find(g_resourcePak, fileName);
+    if (!entry) return false;
+
+    // TODO(Noah): Add a #define for maximum file size value.
+    assert(entry->rawSize <= 0xFFFFFFF);
+
+    *pFileOut          = {};
+    pFileOut->fileName = fileName;
+    void *result       = VirtualAlloc(0, (SIZE_T)entry->rawSize, MEM_COMMIT, PAGE_READWRITE);
+    if (result == NULL) {
+        AELoggerError("Could not allocate memory for file %s", fileName);
+        return true;
+    }
+    if (!ae::pak::extract(g_resourcePak, entry, result)) {
+        AELoggerError("File '%s' is corrupt within %s", fileName, g_resourcePakPath);
+        VirtualFree(result, 0, MEM_RELEASE);
+        return true;
+    }
+    pFileOut->contents    = result;
+    pFileOut->contentSize = (int)entry->rawSize;
+    AELoggerLog("File '%s' read successfully from %s", fileName, g_resourcePakPath);
+    return true;
+}
+
 ae::loaded_file_t Platform_readEntireFile(const char *fileName)
 {
+    {
+        ae::loaded_file_t pakFile;
+        if (Win32ReadFileFromResourcePak(fileName, &pakFile)) return pakFile;
+    }
+
 	void *result = 0;
 	int fileSize32 = 0;
 	HANDLE fileHandle = CreateFileA(fileName, GENERIC_READ,
@@ -264,6 +359,31 @@ ae::loaded_file_t Platform_readEntireFile(const char *fileName)
 	return fileResult;
 }
 
+// NOTE: the file is opened for each read. this is used for streaming, where reads are large and infrequent.
+uint32_t Platform_readFileRange(const char *fileName, uint64_t offset, void *dst, uint32_t size)
+{
+    if (const ae::pak::pak_entry_t *entry = ae::pak::find(g_resourcePak, fileName)) {
+        return (uint32_t)ae::pak::read(g_resourcePak, entry, offset, dst, size);
+    }
+
+    uint32_t result = 0;
+    HANDLE fileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        LogLastError(GetLastError(), "Could not open file");
+        return 0;
+    }
+    LARGE_INTEGER distance;
+    distance.QuadPart = (LONGLONG)offset;
+    DWORD bytesRead;
+    if (SetFilePointerEx(fileHandle, distance, NULL, FILE_BEGIN) && ReadFile(fileHandle, dst, size, &bytesRead, 0)) {
+        result = (uint32_t)bytesRead;
+    } else {
+        LogLastError(GetLastError(), "Could not read file");
+    }
+    CloseHandle(fileHandle);
+    return result;
+}
+
 static bool g_isImGuiInitialized = false;
 #if !defined(AUTOMATA_ENGINE_DISABLE_IMGUI)
 #include "imgui.h"
@@ -970,9 +1090,16 @@ size_t ae::platform::getGpuCurrentMemoryUsage(intptr_t gpuAdapter)
 }
 
 #if !defined(AUTOMATA_ENGINE_DISABLE_IMGUI)
+// NOTE: in the fallback mode, ImGui is drawn into the backbuffer by the frender UI renderer. the renderer samples
+// a copy of the font atlas, which is made again after the fonts change.
+static ae::frender::ui_renderer_t *g_imguiUiRenderer      = nullptr;
+static ae::loaded_image_t          g_imguiFontImage       = {};
+static bool                        g_bImGuiFontImageStale = true;
+
 void ScaleImGui_Impl(float systemScale)
 {
     if (g_isImGuiInitialized) {
+        g_bImGuiFontImageStale = true;
         float size_in_pixels = float(uint32_t(16 * systemScale));
 
         ImGui::GetIO().Fonts->Clear();
@@ -998,6 +1125,15 @@ void ScaleImGuiForGL(float systemScale)
 }
 #endif
 
+#if defined(AUTOMATA_ENGINE_CPU_BACKEND)
+void ScaleImGuiForCPU(float systemScale)
+{
+    ScaleImGui_Impl(systemScale);
+    // NOTE: there is no renderer backend to build the atlas in NewFrame.
+    ImGui::GetIO().Fonts->Build();
+}
+#endif
+
 #if defined(AUTOMATA_ENGINE_VK_BACKEND)
 void ScaleImGuiForVK(VkCommandBuffer cmd, VkCommandPool cmdPool, float systemScale)
 {
@@ -1029,13 +1165,118 @@ void ScaleImGuiForVK(VkCommandBuffer cmd, VkCommandPool cmdPool, float systemSca
 }
 #endif  // defined(AUTOMATA_ENGINE_VK_BACKEND)
 
+static void Win32UpdateImGuiFontImage()
+{
+    if (!g_bImGuiFontImageStale && g_imguiFontImage.pixelPointer) return;
+    unsigned char *pixels;
+    int            width, height;
+    ImGui::GetIO().Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+    delete[] g_imguiFontImage.pixelPointer;
+    g_imguiFontImage.pixelPointer = new uint32_t[size_t(width) * height];
+    g_imguiFontImage.width        = width;
+    g_imguiFontImage.height       = height;
+    // NOTE: the rows of the atlas are top first, and those of a loaded_image_t are bottom first.
+    for (int y = 0; y < height; y++)
+        memcpy(g_imguiFontImage.pixelPointer + size_t(height - 1 - y) * width, pixels + size_t(y) * width * 4,
+            size_t(width) * 4);
+    ae::frender::premultiplyAlpha(g_imguiFontImage);
+    g_bImGuiFontImageStale = false;
+}
+
+// draw the ImGui draw data of this frame into the backbuffer, for when there is no GPU renderer to draw it.
+static void Win32RenderImGuiToBackbuffer(ae::frender::backbuffer_t *target)
+{
+    static_assert(sizeof(ImDrawVert) == sizeof(ae::frender::ui_vertex_t) &&
+                      offsetof(ImDrawVert, uv) == offsetof(ae::frender::ui_vertex_t, u) &&
+                      offsetof(ImDrawVert, col) == offsetof(ae::frender::ui_vertex_t, color),
+        "ImDrawVert must have the layout of ui_vertex_t");
+    static_assert(sizeof(ImDrawIdx) == sizeof(uint16_t), "ImDrawIdx must be 16 bits");
+
+    ImDrawData *drawData = ImGui::GetDrawData();
+    if (!drawData || !target->memory) return;
+    if (!g_imguiUiRenderer) g_imguiUiRenderer = ae::frender::createUiRenderer();
+
+    // NOTE: the vertices and indices are read from the draw lists in place. only the commands are converted.
+    static std::vector<ae::frender::ui_command_t>   commands;
+    static std::vector<ae::frender::ui_draw_list_t> lists;
+    size_t                                          commandCount = 0;
+    for (int n = 0; n < drawData->CmdListsCount; n++) commandCount += drawData->CmdLists[n]->CmdBuffer.Size;
+    commands.clear();
+    commands.reserve(commandCount);  // so that the lists can point into it.
+    lists.clear();
+    ImTextureID fontTexture = ImGui::GetIO().Fonts->TexID;
+    for (int n = 0; n < drawData->CmdListsCount; n++) {
+        const ImDrawList           *cmdList = drawData->CmdLists[n];
+        ae::frender::ui_draw_list_t list    = {};
+        list.vertices                       = (const ae::frender::ui_vertex_t *)cmdList->VtxBuffer.Data;
+        list.vertexCount                    = uint32_t(cmdList->VtxBuffer.Size);
+        list.indices                        = cmdList->IdxBuffer.Data;
+        list.indexCount                     = uint32_t(cmdList->IdxBuffer.Size);
+        list.commands                       = commands.data() + commands.size();
+        for (const ImDrawCmd &cmd : cmdList->CmdBuffer) {
+            // NOTE: callbacks record GPU state, which the fallback has none of.
+            if (cmd.UserCallback) continue;
+            ae::frender::ui_command_t command = {};
+            command.clipMinX                  = cmd.ClipRect.x;
+            command.clipMinY                  = cmd.ClipRect.y;
+            command.clipMaxX                  = cmd.ClipRect.z;
+            command.clipMaxY                  = cmd.ClipRect.w;
+            command.vertexOffset              = cmd.VtxOffset;
+            command.indexOffset               = cmd.IdxOffset;
+            command.indexCount                = cmd.ElemCount;
+            // NOTE: with only the CPU backend, the textures of the game are loaded_image_t. with a GPU backend, they
+            // are GPU handles, which are drawn untextured here.
+            if (cmd.GetTexID() == fontTexture) {
+                command.texture = &g_imguiFontImage;
+            } else {
+#if !defined(AUTOMATA_ENGINE_GL_BACKEND) && !defined(AUTOMATA_ENGINE_VK_BACKEND)
+                command.texture = (const ae::loaded_image_t *)cmd.GetTexID();
+#endif
+            }
+            commands.push_back(command);
+            list.commandCount++;
+        }
+        lists.push_back(list);
+    }
+
+    ae::frender::ui_draw_data_t data = {};
+    data.lists                       = lists.data();
+    data.listCount                   = uint32_t(lists.size());
+    data.displayX                    = drawData->DisplayPos.x;
+    data.displayY                    = drawData->DisplayPos.y;
+    data.scaleX                      = drawData->FramebufferScale.x;
+    data.scaleY                      = drawData->FramebufferScale.y;
+    ae::frender::renderUi(g_imguiUiRenderer, target, data);
+}
+
 #endif // !defined(AUTOMATA_ENGINE_DISABLE_IMGUI)
 
-static void UpdateGlobalEngineFallbackBackbuffer(win32_backbuffer_t *buffer)
+// NOTE: the buffer holds the last frame, and after a resize is all dirty. see acquireBackbuffer.
+static void UpdateGlobalEngineFallbackBackbuffer(ae::frender::backbuffer_t *buffer)
 {
-    g_gameMemory.backbufferPixels = (uint32_t *)buffer->memory;
+    g_gameMemory.backbufferPixels = buffer->memory;
     g_gameMemory.backbufferWidth = buffer->width;
     g_gameMemory.backbufferHeight = buffer->height;
+    g_gameMemory.backbufferDirty = buffer->dirty;
+}
+
+// a top-down DIB of a backbuffer of the ring, for GDI to copy from.
+static win32_backbuffer_t Win32BackbufferView(const ae::frender::backbuffer_t &buffer)
+{
+    win32_backbuffer_t view           = {};
+    view.info.bmiHeader.biSize        = sizeof(view.info.bmiHeader);
+    view.info.bmiHeader.biWidth       = LONG(buffer.width);
+    view.info.bmiHeader.biHeight      = -LONG(buffer.height);
+    view.info.bmiHeader.biPlanes      = 1;
+    view.info.bmiHeader.biBitCount    = 32;
+    view.info.bmiHeader.biCompression = BI_RGB;
+    view.memory                       = buffer.memory;
+    view.width                        = int(buffer.width);
+    view.height                       = int(buffer.height);
+    view.pitch                        = int(buffer.pitch);
+    view.bytesPerPixel                = int(buffer.bytesPerPixel);
+    return view;
 }
 
 // NOTE: client can pass 0,0 as the new width,height to free the buffer and not allocate a new one.
@@ -1118,6 +1359,40 @@ static void Win32DisplayBufferToDC(HDC deviceContext, LPRECT drawRect, win32_bac
         SRCCOPY);
 }
 
+// NOTE: copy only the dirty rects of the backbuffer to the window, and empty them. SetDIBitsToDevice copies without
+// stretching, so this falls back to presenting the whole buffer when the window is not the size of the backbuffer.
+static uint64_t Win32PresentDirtyRects(
+    HDC deviceContext, LPRECT drawRect, win32_backbuffer_t *backbuffer, ae::frender::dirty_rects_t *dirty)
+{
+    int      rectWidth  = drawRect->right - drawRect->left;
+    int      rectHeight = drawRect->bottom - drawRect->top;
+    uint64_t bytes      = 0;
+    if (rectWidth != backbuffer->width || rectHeight != backbuffer->height) {
+        Win32DisplayBufferToDC(deviceContext, drawRect, backbuffer);
+        bytes = uint64_t(backbuffer->pitch) * backbuffer->height;
+    } else {
+        for (uint32_t i = 0; i < dirty->count; i++) {
+            const ae::frender::dirty_rect_t &rect = dirty->rects[i];
+            // NOTE: the origin of a top-down DIB is its top left.
+            SetDIBitsToDevice(deviceContext,
+                drawRect->left + rect.x,
+                drawRect->top + rect.y,
+                rect.width,
+                rect.height,
+                rect.x,
+                rect.y,
+                0,
+                backbuffer->height,
+                backbuffer->memory,
+                &backbuffer->info,
+                DIB_RGB_COLORS);
+            bytes += uint64_t(rect.width) * rect.height * backbuffer->bytesPerPixel;
+        }
+    }
+    dirty->count = 0;
+    return bytes;
+}
+
 BOOL Win32CtrlHandler(DWORD ctrlType) {
     switch (ctrlType) {
         case CTRL_C_EVENT:
@@ -1495,6 +1770,8 @@ void WINAPI Win32WindowProcImpl(_In_ LPVOID lpParameter)
 #if !defined(AUTOMATA_ENGINE_DISABLE_IMGUI)
 #if defined(AUTOMATA_ENGINE_GL_BACKEND)
             ScaleImGuiForGL(systemScale);
+#elif defined(AUTOMATA_ENGINE_CPU_BACKEND)
+            ScaleImGuiForCPU(systemScale);
 #endif
 // TODO: for the VK case, this is kind of a concern.
 // when we look at updating the imgui font, it means that we need to stall the entire device.
@@ -1542,21 +1819,20 @@ void WINAPI Win32WindowProcImpl(_In_ LPVOID lpParameter)
             ) {
                 GameHandleWindowResize(&g_gameMemory, width, height);
             }
-            Win32ResizeBackbuffer(&globalBackBuffer, width, height);
-            UpdateGlobalEngineFallbackBackbuffer(&globalBackBuffer);
+            // NOTE: the render thread acquires its next backbuffer at this size.
+            g_backbufferWidth.store(width);
+            g_backbufferHeight.store(height);
         } break;
         case WM_PAINT:
         {
             bool bRenderFallback = !g_gameMemory.getInitialized(); 
             if ( bRenderFallback )
             {
+                // NOTE: the front buffer belongs to the present thread, so it paints it.
                 PAINTSTRUCT ps;
-                HDC hdc = BeginPaint(window, &ps);
-                ae::game_window_info_t winInfo = Platform_getWindowInfo(false);
-                // TODO: just use rcPaint.
-                RECT dst = { .left = 0, .top = 0, .right = LONG(winInfo.width), .bottom = LONG(winInfo.height) };
-                Win32DisplayBufferToDC(hdc, &dst, &globalBackBuffer);
+                BeginPaint(window, &ps);
                 EndPaint(window, &ps);
+                g_bRepaintBackbuffer.store(true);
             }
             else
             {
@@ -1715,9 +1991,9 @@ static void Win32LoadGameCode(const char *SourceDLLName, const char *TempDLLName
 		GameInit = (ae::PFN_GameFunctionKind)GetProcAddress(g_gameCodeDLL, "GameInit");
         GamePreInit   = (ae::PFN_GameFunctionKind)GetProcAddress(g_gameCodeDLL, "GamePreInit");
 
-        GameOnVoiceBufferEnd     = (PFN_GameOnVoiceBufferEnd)GetProcAddress(g_gameCodeDLL, "GameOnVoiceBufferEnd");
+        GameOnVoiceBufferEnd     = (ae::PFN_GameOnVoiceBufferEnd)GetProcAddress(g_gameCodeDLL, "GameOnVoiceBufferEnd");
         GameOnVoiceBufferProcess =
-            (PFN_GameOnVoiceBufferProcess)GetProcAddress(g_gameCodeDLL, "GameOnVoiceBufferProcess");
+            (ae::PFN_GameOnVoiceBufferProcess)GetProcAddress(g_gameCodeDLL, "GameOnVoiceBufferProcess");
         GameCleanup              = (ae::PFN_GameFunctionKind)GetProcAddress(g_gameCodeDLL, "GameClose");
 
         // TODO: prolly don't need this. window resize happens at a predictable time.
@@ -1765,19 +2041,110 @@ static void AssertSanePlatform(void) {
     assert(sizeof(float64_t) == 8);
 }
 
+// NOTE: a voice that pulls its sound data from a callback keeps WIN32_VOICE_FILL_BUFFER_COUNT buffers queued. each
+// is refilled from the callback as soon as XAudio2 is done with it. the buffer contexts hold the set of buffers that
+// they belong to, and only the set of the current submission is refilled. the mutex keeps a refill from racing with
+// a new submission; it is only ever contended when the game submits to the voice.
+//
+// XAudio2 may still read a flushed buffer until its OnBufferEnd, which comes some time after the flush. so each
+// submission takes a set that XAudio2 is done with, and a new set is made when every set is still in use.
+#define WIN32_VOICE_FILL_BUFFER_COUNT  3
+#define WIN32_VOICE_FILL_BUFFER_FRAMES 2048
+
+typedef struct {
+    uint32_t index;     // in the sets of the voice.
+    uint32_t inFlight;  // buffers submitted whose OnBufferEnd has not come yet, flushed or not.
+    int16_t  buffers[WIN32_VOICE_FILL_BUFFER_COUNT][WIN32_VOICE_FILL_BUFFER_FRAMES * 2];
+} win32_voice_fill_set_t;
+
+typedef struct {
+    IXAudio2SourceVoice                                  *voice;
+    std::mutex                                            mutex;
+    ae::PFN_voiceFillCallback                             fill;
+    void                                                 *user;
+    win32_voice_fill_set_t                               *pCurrent;  // nullptr when the voice plays something else.
+    std::vector<std::unique_ptr<win32_voice_fill_set_t>>  sets;
+    bool                                                  bEnded;
+} win32_voice_fill_t;
+
+static void *Win32MakeFillBufferContext(uint32_t setIndex, uint32_t index)
+{
+    // NOTE: the set is offset by one so that no context is null.
+    return (void *)(((uintptr_t)(setIndex + 1) << 8) | index);
+}
+
+static void Win32VoiceFillAndSubmit(win32_voice_fill_t *fill, win32_voice_fill_set_t *set, uint32_t index)
+{
+    int16_t *samples = set->buffers[index];
+    uint32_t frames  = fill->fill(fill->user, samples, WIN32_VOICE_FILL_BUFFER_FRAMES);
+    XAUDIO2_BUFFER buffer = {};
+    if (frames < WIN32_VOICE_FILL_BUFFER_FRAMES) {
+        // NOTE: XAudio2 does not take empty buffers, so the end of the sound is marked with a silent frame.
+        if (frames == 0) {
+            samples[0] = samples[1] = 0;
+            frames = 1;
+        }
+        buffer.Flags = XAUDIO2_END_OF_STREAM;
+        fill->bEnded = true;
+    }
+    buffer.AudioBytes = frames * 2 * sizeof(int16_t);
+    buffer.pAudioData = (const BYTE *)samples;
+    buffer.pContext   = Win32MakeFillBufferContext(set->index, index);
+    if (SUCCEEDED(fill->voice->SubmitSourceBuffer(&buffer))) set->inFlight++;
+}
+
+// NOTE: the buffers queued to a voice carry a record of their onEnd as their context. the records are used round
+// robin. there are twice as many as there may be buffers queued, since XAudio2 only reports a flushed buffer as done
+// some time after the flush.
+#define WIN32_VOICE_QUEUE_RECORD_COUNT (2 * ae::platform::VOICE_MAX_QUEUED_BUFFERS)
+
+typedef struct {
+    ae::PFN_voiceBufferEndCallback onEnd;
+    void                          *context;
+} win32_queued_buffer_t;
+
+typedef struct {
+    win32_queued_buffer_t records[WIN32_VOICE_QUEUE_RECORD_COUNT];
+    uint32_t              nextRecord;
+} win32_voice_queue_t;
+
 namespace automata_engine {
     class IXAudio2VoiceCallback : public ::IXAudio2VoiceCallback  {
     public:
         IXAudio2VoiceCallback() = delete;
-        IXAudio2VoiceCallback(intptr_t voiceHandle) : m_voiceHandle(voiceHandle) {}
+        IXAudio2VoiceCallback(intptr_t voiceHandle)
+            : m_voiceHandle(voiceHandle), m_pFill(nullptr), m_pQueue(nullptr) {}
+        // NOTE: the voice is destroyed first, so no callback can still be using the buffers.
+        ~IXAudio2VoiceCallback()
+        {
+            delete m_pFill;
+            delete m_pQueue;
+        }
         void OnLoopEnd(void *pBufferContext) {
             AELoggerLog("voice: %d, OnLoopEnd", m_voiceHandle);
         }
         void OnBufferEnd(void *pBufferContext) {
-            AELoggerLog("voice: %d, OnBufferEnd", m_voiceHandle);
+            win32_voice_queue_t *queue = m_pQueue;
+            if (queue && pBufferContext >= (void *)queue->records &&
+                pBufferContext < (void *)(queue->records + WIN32_VOICE_QUEUE_RECORD_COUNT)) {
+                win32_queued_buffer_t *record = (win32_queued_buffer_t *)pBufferContext;
+                if (record->onEnd) record->onEnd(record->context, m_voiceHandle);
+                return;
+            }
+            win32_voice_fill_t *fill = m_pFill;
+            if (!pBufferContext || !fill) {
+                AELoggerLog("voice: %d, OnBufferEnd", m_voiceHandle);
+                return;
+            }
+            uint32_t setIndex = (uint32_t)((uintptr_t)pBufferContext >> 8) - 1;
+            uint32_t index    = (uint32_t)((uintptr_t)pBufferContext & 0xFF);
+            std::lock_guard<std::mutex> lock(fill->mutex);
+            win32_voice_fill_set_t *set = fill->sets[setIndex].get();
+            set->inFlight--;
+            if (set == fill->pCurrent && !fill->bEnded) Win32VoiceFillAndSubmit(fill, set, index);
         }
         void OnBufferStart(void *pBufferContext) {
-            AELoggerLog("voice: %d, OnBufferStart", m_voiceHandle);
+            if (!pBufferContext) AELoggerLog("voice: %d, OnBufferStart", m_voiceHandle);
         }
         void OnStreamEnd() {
             AELoggerLog("voice: %d, OnStreamEnd", m_voiceHandle);
@@ -1794,6 +2161,10 @@ namespace automata_engine {
         void OnVoiceProcessingPassStart(UINT32 BytesRequired) {
             //AELoggerLog("OnVoiceProcessingPassStart");
         }
+        // NOTE: these are set on the first callback submission and the first queued buffer, and live as long as
+        // the voice.
+        win32_voice_fill_t  *m_pFill;
+        win32_voice_queue_t *m_pQueue;
     private:
         intptr_t m_voiceHandle;
     };
@@ -1899,6 +2270,8 @@ typedef struct {
     IXAudio2SourceVoice *voice;
     ae::IXAudio2VoiceCallback *callback;
     AutomataXAPO *xapo;
+    bool bQueued;               // the voice plays queued buffers.
+    uint64_t framesPlayedBase;  // SamplesPlayed when the first buffer was queued.
 } win32_voice_t;
 
 static XAUDIO2_BUFFER g_xa2Buffer = {0};
@@ -2004,7 +2377,7 @@ intptr_t Platform_createVoice() {
         AELoggerError("atoXAPO->Initialize() returned with code (0x%x)", hr);
     }
 
-    win32_voice_t w32NewVoice = {newVoice, voiceCallback, atoXAPO};
+    win32_voice_t w32NewVoice = {newVoice, voiceCallback, atoXAPO, false, 0};
     StretchyBufferPush(g_ppSourceVoices, w32NewVoice);
     return (intptr_t)newVoiceIdx;
 }
@@ -2034,7 +2407,13 @@ static bool Platform_voiceSubmitBuffer2(intptr_t voiceHandle, void *data, uint32
     auto pSourceVoice = (IXAudio2SourceVoice *)g_ppSourceVoices[voiceHandle].voice;
     if (pSourceVoice != nullptr) {
         if (FAILED(pSourceVoice->Stop(0))) { return false; }
+        // NOTE: this stops any callback buffers from being refilled.
+        if (win32_voice_fill_t *fill = g_ppSourceVoices[voiceHandle].callback->m_pFill) {
+            std::lock_guard<std::mutex> lock(fill->mutex);
+            fill->pCurrent = nullptr;
+        }
         if (FAILED(pSourceVoice->FlushSourceBuffers())) { return false; }
+        g_ppSourceVoices[voiceHandle].bQueued = false;
     } else {
         return false; // no source voice...
     }
@@ -2056,11 +2435,105 @@ bool automata_engine::platform::voiceSubmitBuffer(intptr_t voiceHandle, void *da
 }
 
 static bool Platform_voiceSubmitBuffer(intptr_t voiceHandle, ae::loaded_wav_t wavFile) {
+    // NOTE: a wav kept compressed has no samples to hand to XAudio2. it is played with ae::audio::voiceSubmitWav.
+    if (wavFile.sampleData == nullptr) return false;
     return Platform_voiceSubmitBuffer2(voiceHandle, 
         wavFile.sampleData, 
         wavFile.sampleCount * wavFile.channels * sizeof(short), false);
 }
 
+static bool Platform_voiceSubmitCallback(intptr_t voiceHandle, ae::PFN_voiceFillCallback fillCallback, void *user) {
+    auto pSourceVoice = (IXAudio2SourceVoice *)g_ppSourceVoices[voiceHandle].voice;
+    if (pSourceVoice == nullptr || fillCallback == nullptr) return false;
+    if (FAILED(pSourceVoice->Stop(0))) { return false; }
+
+    ae::IXAudio2VoiceCallback *callback = g_ppSourceVoices[voiceHandle].callback;
+    win32_voice_fill_t        *fill     = callback->m_pFill;
+    if (!fill) {
+        fill        = new win32_voice_fill_t();
+        fill->voice = pSourceVoice;
+        callback->m_pFill = fill;
+    }
+    // NOTE: the current set is dropped before the flush, so the buffers that it flushes are not refilled. they are
+    // not written either until their OnBufferEnd, since the new submission takes a set that is not in flight.
+    win32_voice_fill_set_t *set = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(fill->mutex);
+        fill->pCurrent = nullptr;
+        for (auto &candidate : fill->sets) {
+            if (candidate->inFlight == 0) {
+                set = candidate.get();
+                break;
+            }
+        }
+        if (!set) {
+            fill->sets.push_back(std::make_unique<win32_voice_fill_set_t>());
+            set        = fill->sets.back().get();
+            set->index = (uint32_t)fill->sets.size() - 1;
+        }
+    }
+    if (FAILED(pSourceVoice->FlushSourceBuffers())) { return false; }
+    g_ppSourceVoices[voiceHandle].bQueued = false;
+
+    // NOTE: the first buffers are filled without the lock, as the fill callback may take a while. nothing else
+    // touches the set meanwhile: the voice is stopped, and OnBufferEnd refills only the current set.
+    fill->fill   = fillCallback;
+    fill->user   = user;
+    fill->bEnded = false;
+    for (uint32_t i = 0; i < WIN32_VOICE_FILL_BUFFER_COUNT && !fill->bEnded; i++) {
+        Win32VoiceFillAndSubmit(fill, set, i);
+    }
+    std::lock_guard<std::mutex> lock(fill->mutex);
+    fill->pCurrent = set;
+    return true;
+}
+
+static bool Platform_voiceQueueBuffer(intptr_t voiceHandle, const ae::voice_buffer_t &buffer) {
+    win32_voice_t *w32Voice = &g_ppSourceVoices[voiceHandle];
+    IXAudio2SourceVoice *pSourceVoice = w32Voice->voice;
+    if (pSourceVoice == nullptr || buffer.frames == nullptr || buffer.frameCount == 0) return false;
+
+    ae::IXAudio2VoiceCallback *callback = w32Voice->callback;
+    if (!callback->m_pQueue) callback->m_pQueue = new win32_voice_queue_t();
+    win32_voice_queue_t *queue = callback->m_pQueue;
+
+    XAUDIO2_VOICE_STATE state;
+    if (!w32Voice->bQueued) {
+        // NOTE: the first buffer replaces whatever the voice was playing. the callback buffers are not refilled.
+        if (FAILED(pSourceVoice->Stop(0))) { return false; }
+        if (win32_voice_fill_t *fill = callback->m_pFill) {
+            std::lock_guard<std::mutex> lock(fill->mutex);
+            fill->pCurrent = nullptr;
+        }
+        if (FAILED(pSourceVoice->FlushSourceBuffers())) { return false; }
+        pSourceVoice->GetState(&state);
+        w32Voice->bQueued = true;
+        w32Voice->framesPlayedBase = state.SamplesPlayed;
+    }
+    pSourceVoice->GetState(&state, XAUDIO2_VOICE_NOSAMPLESPLAYED);
+    if (state.BuffersQueued >= ae::platform::VOICE_MAX_QUEUED_BUFFERS) return false;
+
+    win32_queued_buffer_t *record = &queue->records[queue->nextRecord++ % WIN32_VOICE_QUEUE_RECORD_COUNT];
+    record->onEnd   = buffer.onEnd;
+    record->context = buffer.context;
+    // NOTE: no end of stream flag, so a queue that runs dry leaves the voice starved rather than ended.
+    XAUDIO2_BUFFER xa2Buffer = {};
+    xa2Buffer.AudioBytes = buffer.frameCount * 2 * sizeof(int16_t);
+    xa2Buffer.pAudioData = (const BYTE *)buffer.frames;
+    xa2Buffer.pContext   = record;
+    return !FAILED(pSourceVoice->SubmitSourceBuffer(&xa2Buffer));
+}
+
+static bool Platform_voiceGetState(intptr_t voiceHandle, ae::voice_state_t *pState) {
+    const win32_voice_t *w32Voice = &g_ppSourceVoices[voiceHandle];
+    if (w32Voice->voice == nullptr) return false;
+    XAUDIO2_VOICE_STATE state;
+    w32Voice->voice->GetState(&state);
+    pState->buffersQueued = state.BuffersQueued;
+    pState->framesPlayed  = state.SamplesPlayed - (w32Voice->bQueued ? w32Voice->framesPlayedBase : 0);
+    return true;
+}
+
 
 #include <thread>
 
@@ -2216,6 +2689,39 @@ static BOOL CALLBACK Win32MonitorEnumProc(HMONITOR hMon, HDC hdc, LPRECT lprcMon
     return TRUE;// continue enumeration.
 }
 
+// copy the frames that the render thread submits in the fallback mode to the window, so that the render thread draws
+// the next frame while GDI copies the last one.
+DWORD WINAPI Win32PresentHandlingLoop(_In_ LPVOID lpParameter)
+{
+    const ae::frender::backbuffer_t *front = nullptr;
+    while (g_engineMemory.globalRunning.load()) {
+        ae::frender::dirty_rects_t       dirty    = {};
+        const ae::frender::backbuffer_t *next     = ae::frender::acquireFrontBuffer(g_backbufferRing, 16, &dirty);
+        bool                             bRepaint = g_bRepaintBackbuffer.exchange(false);
+        if (next) {
+            front = next;
+        } else if (!bRepaint || !front) {
+            continue;
+        }
+
+        HDC  deviceContext = GetDC(g_hwnd);
+        RECT dst           = {};
+        GetClientRect(g_hwnd, &dst);
+        win32_backbuffer_t view  = Win32BackbufferView(*front);
+        uint64_t           bytes = 0;
+        // NOTE: a repaint is of the whole buffer, since the window may have lost any of it.
+        if (ae::EM->requestDirtyRectPresent && !bRepaint) {
+            bytes = Win32PresentDirtyRects(deviceContext, &dst, &view, &dirty);
+        } else {
+            Win32DisplayBufferToDC(deviceContext, &dst, &view);
+            bytes = uint64_t(view.pitch) * view.height;
+        }
+        ReleaseDC(g_hwnd, deviceContext);
+        if (next) ae::EM->lastFramePresentedBytes.store(bytes);
+    }
+    return 0;
+}
+
 DWORD WINAPI Win32GameUpdateAndRenderHandlingLoop(_In_ LPVOID lpParameter) {
     
     // TODO: consider multiple monitor setups.
@@ -2268,17 +2774,32 @@ DWORD WINAPI Win32GameUpdateAndRenderHandlingLoop(_In_ LPVOID lpParameter) {
 
         bool bRenderFallback = !g_gameMemory.getInitialized();
 
+        // NOTE: only the fallback draws into the ring. its frame is drawn into another buffer than the one that the
+        // present thread copies to the window.
+        ae::frender::backbuffer_t *backbuffer = nullptr;
+        if (bRenderFallback) {
+            backbuffer =
+                ae::frender::acquireBackbuffer(g_backbufferRing, g_backbufferWidth.load(), g_backbufferHeight.load());
+            if (!backbuffer) break;  // the ring is closed for shutdown.
+            UpdateGlobalEngineFallbackBackbuffer(backbuffer);
+        }
+
         bool bRenderImGui              = g_engineMemory.g_renderImGui.load();
         g_engineMemory.bCanRenderImGui = bRenderImGui;
 
 #if !defined(AUTOMATA_ENGINE_DISABLE_IMGUI)
-        if (bRenderImGui && g_isImGuiInitialized && !bRenderFallback) {
+        if (bRenderImGui && g_isImGuiInitialized) {
+            if (bRenderFallback) {
+                // NOTE: the fallback draws ImGui into the backbuffer, see Win32RenderImGuiToBackbuffer.
+                Win32UpdateImGuiFontImage();
+            } else {
 #if defined(AUTOMATA_ENGINE_GL_BACKEND)
-            ImGui_ImplOpenGL3_NewFrame();
+                ImGui_ImplOpenGL3_NewFrame();
 #endif
 #if defined(AUTOMATA_ENGINE_VK_BACKEND)
-            ImGui_ImplVulkan_NewFrame();
+                ImGui_ImplVulkan_NewFrame();
 #endif
+            }
             ImGui_ImplWin32_NewFrame();
             ImGui::NewFrame();
         }
@@ -2296,9 +2817,11 @@ DWORD WINAPI Win32GameUpdateAndRenderHandlingLoop(_In_ LPVOID lpParameter) {
             if (!bFoundUpdate) AELoggerWarn("gameUpdateAndRender == nullptr");
         }
 
-        // TODO: maybe imgui even works in the fallback mode?
 #if !defined(AUTOMATA_ENGINE_DISABLE_IMGUI)
-        if (bRenderImGui && g_isImGuiInitialized && !bRenderFallback) {
+        if (bRenderImGui && g_isImGuiInitialized && bRenderFallback) {
+            ImGui::Render();
+            Win32RenderImGuiToBackbuffer(backbuffer);
+        } else if (bRenderImGui && g_isImGuiInitialized) {
 #if defined(AUTOMATA_ENGINE_GL_BACKEND)
             ImGui::Render();
             ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -2373,15 +2896,8 @@ DWORD WINAPI Win32GameUpdateAndRenderHandlingLoop(_In_ LPVOID lpParameter) {
         }
 #endif
 
-        if (bRenderFallback) {
-            // NOTE(Noah): Here we are going to call our custom windows platform layer function that
-            // will write our custom buffer to the screen.
-            HDC                    deviceContext = GetDC(g_hwnd);
-            ae::game_window_info_t winInfo       = Platform_getWindowInfo(false);
-            RECT dst = { .left = 0, .top = 0, .right = LONG(winInfo.width), .bottom = LONG(winInfo.height) };
-            Win32DisplayBufferToDC(deviceContext, &dst, &globalBackBuffer);
-            ReleaseDC(g_hwnd, deviceContext);
-        }
+        // NOTE: the present thread writes the frame to the window, see Win32PresentHandlingLoop.
+        if (bRenderFallback) ae::frender::submitBackbuffer(g_backbufferRing);
 
         {
             LARGE_INTEGER beforeVblankCall = Win32GetWallClock();
@@ -2672,6 +3188,10 @@ int CALLBACK WinMain(HINSTANCE instance,
     ae::EM->pfn.setAdditionalLogger = Platform_setAdditionalLogger;
     ae::EM->pfn.voicePlayBuffer     = Platform_voicePlayBuffer;
     ae::EM->pfn.voiceSubmitBuffer   = Platform_voiceSubmitBuffer;
+    ae::EM->pfn.voiceSubmitCallback = Platform_voiceSubmitCallback;
+    ae::EM->pfn.voiceQueueBuffer    = Platform_voiceQueueBuffer;
+    ae::EM->pfn.voiceGetState       = Platform_voiceGetState;
+    ae::EM->pfn.readFileRange       = Platform_readFileRange;
     ae::EM->pfn.createVoice         = Platform_createVoice;
     ae::EM->pfn.getGpuInfos         = Platform_getGpuInfos;
     ae::EM->pfn.freeGpuInfos        = Platform_freeGpuInfos;
@@ -2782,6 +3302,10 @@ int CALLBACK WinMain(HINSTANCE instance,
     }
 #endif
 
+    // map the resource pack (if there is one) before anything is read from res\.
+    Win32OpenResourcePak(g_resourcePakPath);
+    defer(Win32CloseResourcePak());
+
     // load the icon baked into the .EXE. we'll be using this to render to the nonclient area of the window.
     uint32_t *iconPixels = nullptr;
     defer(iconPixels ? free(iconPixels) : (void)0);
@@ -2854,6 +3378,7 @@ int CALLBACK WinMain(HINSTANCE instance,
     if (GameOnHotload) GameOnHotload(&g_gameMemory);
 
     HANDLE renderThread = NULL;
+    HANDLE presentThread = NULL;
     HANDLE inputThread = NULL;
 
     // NOTE: this event is used to wait for when the input thread window has completed create.
@@ -2979,11 +3504,14 @@ int CALLBACK WinMain(HINSTANCE instance,
         ShowWindow(windowHandle, (beginMaximized) ? SW_MAXIMIZE : showCode);
         UpdateWindow(windowHandle);
 
-        // Create the globalBackBuffer
+        // Create the backbuffers of the fallback, and acquire the first for the game.
         {
             ae::game_window_info_t winInfo = Platform_getWindowInfo(false);
-            Win32ResizeBackbuffer(&globalBackBuffer, winInfo.width, winInfo.height);
-            UpdateGlobalEngineFallbackBackbuffer(&globalBackBuffer);
+            g_backbufferWidth.store(winInfo.width);
+            g_backbufferHeight.store(winInfo.height);
+            g_backbufferRing = ae::frender::createBackbufferRing(3);
+            UpdateGlobalEngineFallbackBackbuffer(
+                ae::frender::acquireBackbuffer(g_backbufferRing, winInfo.width, winInfo.height));
         }
 
         // Initialize XAudio2 !!!
@@ -3157,6 +3685,8 @@ int CALLBACK WinMain(HINSTANCE instance,
 
 #if defined(AUTOMATA_ENGINE_GL_BACKEND)
         ScaleImGuiForGL(initSystemScale);
+#elif defined(AUTOMATA_ENGINE_CPU_BACKEND)
+        ScaleImGuiForCPU(initSystemScale);
 #endif
 #if defined(AUTOMATA_ENGINE_VK_BACKEND)
         ScaleImGuiForVK(vkImguiCommandBuffer, vkImguiCommandPool, initSystemScale);
@@ -3175,6 +3705,15 @@ int CALLBACK WinMain(HINSTANCE instance,
             nullptr   // pointer to a thing that recieves the thread identifier.
                      );
 
+        presentThread = CreateThread(
+            nullptr,  // lp thread attributes.
+            0,        // default stack size.
+            Win32PresentHandlingLoop,
+            nullptr,  // lpParameter
+            0,        // thread runs immediately after creation.
+            nullptr   // pointer to a thing that recieves the thread identifier.
+                     );
+
         inputThread = CreateThread(
             nullptr,  // lp thread attributes.
             0,        // default stack size.
@@ -3225,14 +3764,23 @@ int CALLBACK WinMain(HINSTANCE instance,
     // communicate to the other threads that they should close and join with them here
     // before terminate the application.
     g_engineMemory.globalRunning.store(false);
+    // NOTE: wake the render and present threads, if they wait on the backbuffers.
+    if (g_backbufferRing) ae::frender::closeBackbufferRing(g_backbufferRing);
     if (renderThread) WaitForSingleObject(renderThread, INFINITE);
+    if (presentThread) WaitForSingleObject(presentThread, INFINITE);
     if (inputThread) WaitForSingleObject(inputThread, INFINITE);
 
     // TODO(Noah): Can we leverage our new nc_defer.h to replace this code below?
     {
         // dealloc the backbuffers that were allocated.
-        Win32ResizeBackbuffer(&globalBackBuffer, 0, 0);
+        if (g_backbufferRing) ae::frender::destroyBackbufferRing(g_backbufferRing);
         Win32ResizeBackbuffer(&g_ncBackbuffer, 0, 0);
+#if !defined(AUTOMATA_ENGINE_DISABLE_IMGUI)
+        if (g_imguiUiRenderer) ae::frender::destroyUiRenderer(g_imguiUiRenderer);
+        delete[] g_imguiFontImage.pixelPointer;
+#endif
+        // NOTE: the jobs of the exe, which the UI renderer ran on. the game DLL has its own.
+        ae::jobs::shutdown();
 
         // before kill Xaudio2, stop all audio and flush, for all voices.
         for (uint32_t i = 0; i < StretchyBufferCount(g_ppSourceVoices); i++) {
@@ -1,7 +1,22 @@
 #define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+// NOTE: benchmarks are tagged [.][bench] so that they are hidden. run them with "[bench]".
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include <catch.hpp>
 
 #include <automata_engine.hpp>
+#include <automata_engine_utils.hpp>
+
+#include <automata_engine_pak.h>
+#include "stb_image_write.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <float.h>
+#include <thread>
+
+#include <xmmintrin.h>
 
 unsigned int Factorial( unsigned int number ) {
     return number <= 1 ? number : Factorial(number-1)*number;
@@ -23,12 +38,289 @@ namespace utils {
         return (uint32_t)( (uint64_t)rand() % (diff + 1) + (uint64_t)lower );
     }
 
+    // NOTE: RAND_MAX may be as small as 32767, so values wider than a byte are built from bytes.
+    uint32_t RandomBits(uint32_t bits) {
+        assert(bits <= 32);
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < bits; i += 8) value = (value << 8) | RandomUINT32(0, 255);
+        return bits < 32 ? value & ((1u << bits) - 1) : value;
+    }
+
     float32_t RandomFloat(float begin, float end) {
         assert(RAND_MAX != 0); // this should be obvious ... 
         const float f = (float32_t)rand() / (float32_t)RAND_MAX;
         return begin + f * (end - begin);
     }
 
+    // NOTE: the engine library reaches the platform through ae::EM. the tests stand in for the platform layer
+    // with the C runtime.
+    static ae::loaded_file_t ReadEntireFile(const char *fileName) {
+        ae::loaded_file_t result = {};
+        result.fileName = fileName;
+        FILE *file = fopen(fileName, "rb");
+        if (!file) return result;
+        fseek(file, 0, SEEK_END);
+        result.contentSize = (int)ftell(file);
+        fseek(file, 0, SEEK_SET);
+        // NOTE: one extra zero byte so that text files are null-terminated.
+        result.contents = calloc(result.contentSize + 1, 1);
+        fread(result.contents, 1, result.contentSize, file);
+        fclose(file);
+        return result;
+    }
+
+    static bool WriteEntireFile(const char *fileName, void *memory, uint32_t memorySize) {
+        FILE *file = fopen(fileName, "wb");
+        if (!file) return false;
+        bool result = fwrite(memory, 1, memorySize, file) == memorySize;
+        fclose(file);
+        return result;
+    }
+
+    static uint32_t ReadFileRange(const char *fileName, uint64_t offset, void *dst, uint32_t size) {
+        FILE *file = fopen(fileName, "rb");
+        if (!file) return 0;
+        uint32_t result = 0;
+        if (fseek(file, long(offset), SEEK_SET) == 0) result = uint32_t(fread(dst, 1, size, file));
+        fclose(file);
+        return result;
+    }
+
+    static void FreeLoadedFile(ae::loaded_file_t file) { free(file.contents); }
+    static void *Alloc(uint32_t bytes) { return calloc(bytes, 1); }
+    static void Free(void *data) { free(data); }
+    static void FprintfProxy(int handle, const char *fmt, ...) {}
+
+    void SetupTestEngineContext() {
+        static ae::engine_memory_t engineMemory = {};
+        engineMemory.pfn.readEntireFile  = ReadEntireFile;
+        engineMemory.pfn.writeEntireFile = WriteEntireFile;
+        engineMemory.pfn.freeLoadedFile  = FreeLoadedFile;
+        engineMemory.pfn.readFileRange   = ReadFileRange;
+        engineMemory.pfn.alloc           = Alloc;
+        engineMemory.pfn.free            = Free;
+        engineMemory.pfn.fprintf_proxy   = FprintfProxy;
+        ae::setEngineContext(&engineMemory);
+    }
+
+    // a model from x,y,z,u,v,nx,ny,nz vertices. the values left off the end of a vertex are zero.
+    ae::raw_model_t MakeModel(std::initializer_list<std::array<float, 8>> vertices,
+        std::initializer_list<uint32_t> indices) {
+        ae::raw_model_t model = {};
+        for (const auto &v : vertices) {
+            for (float f : v) StretchyBufferPush(model.vertexData, f);
+        }
+        for (uint32_t i : indices) StretchyBufferPush(model.indexData, i);
+        return model;
+    }
+
+    void FreeModel(ae::raw_model_t &model) {
+        StretchyBufferFree(model.vertexData);
+        StretchyBufferFree(model.indexData);
+    }
+
+    // write a canonical .WAV file. formatTag is 1 for integer PCM and 3 for float PCM.
+    bool WriteWav(const char *path, uint16_t formatTag, uint16_t channels, uint32_t sampleRate,
+        uint16_t bitsPerSample, const void *data, uint32_t dataSize) {
+        std::vector<uint8_t> file(44 + dataSize);
+        uint8_t *p = file.data();
+        auto put32 = [&p](uint32_t v) { memcpy(p, &v, 4); p += 4; };
+        auto put16 = [&p](uint16_t v) { memcpy(p, &v, 2); p += 2; };
+        uint16_t blockAlign = channels * bitsPerSample / 8;
+        memcpy(p, "RIFF", 4); p += 4;
+        put32(36 + dataSize);
+        memcpy(p, "WAVEfmt ", 8); p += 8;
+        put32(16);
+        put16(formatTag);
+        put16(channels);
+        put32(sampleRate);
+        put32(sampleRate * blockAlign);
+        put16(blockAlign);
+        put16(bitsPerSample);
+        memcpy(p, "data", 4); p += 4;
+        put32(dataSize);
+        memcpy(p, data, dataSize);
+        return WriteEntireFile(path, file.data(), uint32_t(file.size()));
+    }
+
+    // write an ADPCM .WAV file. formatTag is 0x11 for IMA and 2 for MS. factFrames of 0 omits the fact chunk.
+    bool WriteAdpcmWav(const char *path, uint16_t formatTag, uint16_t channels, uint32_t sampleRate,
+        uint16_t blockAlign, uint16_t framesPerBlock, const void *data, uint32_t dataSize, uint32_t factFrames) {
+        static const int16_t msCoefs[14] = { 256, 0, 512, -256, 0, 0, 192, 64, 240, 0, 460, -208, 392, -232 };
+        uint32_t fmtSize = (formatTag == 2) ? 50 : 20;
+        uint32_t factSize = factFrames ? 12 : 0;
+        std::vector<uint8_t> file(20 + fmtSize + factSize + 8 + dataSize);
+        uint8_t *p = file.data();
+        auto put32 = [&p](uint32_t v) { memcpy(p, &v, 4); p += 4; };
+        auto put16 = [&p](uint16_t v) { memcpy(p, &v, 2); p += 2; };
+        memcpy(p, "RIFF", 4); p += 4;
+        put32(uint32_t(file.size()) - 8);
+        memcpy(p, "WAVEfmt ", 8); p += 8;
+        put32(fmtSize);
+        put16(formatTag);
+        put16(channels);
+        put32(sampleRate);
+        put32(framesPerBlock ? sampleRate * blockAlign / framesPerBlock : 0);
+        put16(blockAlign);
+        put16(4);
+        put16(uint16_t(fmtSize - 18));
+        put16(framesPerBlock);
+        if (formatTag == 2) {
+            put16(7);
+            memcpy(p, msCoefs, sizeof(msCoefs)); p += sizeof(msCoefs);
+        }
+        if (factFrames) {
+            memcpy(p, "fact", 4); p += 4;
+            put32(4);
+            put32(factFrames);
+        }
+        memcpy(p, "data", 4); p += 4;
+        put32(dataSize);
+        memcpy(p, data, dataSize);
+        return WriteEntireFile(path, file.data(), uint32_t(file.size()));
+    }
+
+    // scalar ADPCM, written straight from the format descriptions. the encoders run the decoder step to track
+    // the decoder state, and the reference decoders check the SIMD decoder in the engine.
+    static const int32_t c_imaSteps[89] = { 7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41,
+        45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408,
+        449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749,
+        3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+        15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767 };
+    static const int32_t c_imaIndexAdjust[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+    static const int32_t c_msCoefs[7][2] = { { 256, 0 }, { 512, -256 }, { 0, 0 }, { 192, 64 }, { 240, 0 },
+        { 460, -208 }, { 392, -232 } };
+    static const int32_t c_msAdapt[16] = { 230, 230, 230, 230, 307, 409, 512, 614, 768, 614, 512, 409, 307, 230,
+        230, 230 };
+
+    int32_t ImaStep(int32_t &predictor, int32_t &index, uint32_t nibble) {
+        int32_t step = c_imaSteps[index];
+        int32_t diff = step >> 3;
+        if (nibble & 4) diff += step;
+        if (nibble & 2) diff += step >> 1;
+        if (nibble & 1) diff += step >> 2;
+        predictor = std::clamp(predictor + ((nibble & 8) ? -diff : diff), -32768, 32767);
+        index = std::clamp(index + c_imaIndexAdjust[nibble & 7], 0, 88);
+        return predictor;
+    }
+
+    int32_t MsStep(int32_t &sample1, int32_t &sample2, int32_t &delta, const int32_t *coef, uint32_t nibble) {
+        int32_t predictor = (sample1 * coef[0] + sample2 * coef[1]) >> 8;
+        predictor = std::clamp(predictor + (int32_t(nibble << 28) >> 28) * delta, -32768, 32767);
+        sample2 = sample1;
+        sample1 = predictor;
+        delta = std::clamp((c_msAdapt[nibble] * delta) >> 8, 16, 0x7FFF);
+        return predictor;
+    }
+
+    uint32_t GetAdpcmFramesPerBlock(bool bIma, uint32_t channels, uint32_t blockAlign) {
+        return bIma ? 1 + (blockAlign - 4 * channels) * 2 / channels : 2 + (blockAlign - 7 * channels) * 2 / channels;
+    }
+
+    // encode interleaved 16-bit samples into whole blocks. the last block is padded with silence.
+    std::vector<uint8_t> EncodeAdpcm(bool bIma, const int16_t *samples, uint32_t channels, uint32_t frameCount,
+        uint32_t blockAlign) {
+        uint32_t framesPerBlock = GetAdpcmFramesPerBlock(bIma, channels, blockAlign);
+        uint32_t blockCount = (frameCount + framesPerBlock - 1) / framesPerBlock;
+        std::vector<uint8_t> out(size_t(blockCount) * blockAlign);
+        auto sampleAt = [&](uint32_t frame, uint32_t c) {
+            return frame < frameCount ? int32_t(samples[size_t(frame) * channels + c]) : 0;
+        };
+        auto put16 = [](uint8_t *p, int32_t v) { p[0] = uint8_t(v); p[1] = uint8_t(v >> 8); };
+        int32_t imaIndex[2] = {};
+        for (uint32_t b = 0; b < blockCount; b++) {
+            uint8_t *block = out.data() + size_t(b) * blockAlign;
+            uint32_t first = b * framesPerBlock;
+            for (uint32_t c = 0; c < channels; c++) {
+                if (bIma) {
+                    int32_t predictor = sampleAt(first, c);
+                    put16(block + 4 * c, predictor);
+                    block[4 * c + 2] = uint8_t(imaIndex[c]);
+                    for (uint32_t j = 0; j + 1 < framesPerBlock; j++) {
+                        int32_t diff = sampleAt(first + 1 + j, c) - predictor, step = c_imaSteps[imaIndex[c]];
+                        uint32_t nibble = 0;
+                        if (diff < 0) { nibble = 8; diff = -diff; }
+                        if (diff >= step) { nibble |= 4; diff -= step; }
+                        if (diff >= step / 2) { nibble |= 2; diff -= step / 2; }
+                        if (diff >= step / 4) nibble |= 1;
+                        ImaStep(predictor, imaIndex[c], nibble);
+                        block[4 * channels + (j / 8) * 4 * channels + c * 4 + (j % 8) / 2] |= nibble << ((j & 1) * 4);
+                    }
+                } else {
+                    // every predictor is tried and the one with the least error is kept.
+                    int64_t bestError = INT64_MAX;
+                    std::vector<uint8_t> nibbles(framesPerBlock), bestNibbles;
+                    uint32_t bestPredictor = 0;
+                    for (uint32_t k = 0; k < 7; k++) {
+                        int32_t sample1 = sampleAt(first + 1, c), sample2 = sampleAt(first, c), delta = 16;
+                        int64_t error = 0;
+                        for (uint32_t j = 0; j + 2 < framesPerBlock; j++) {
+                            int32_t target = sampleAt(first + 2 + j, c);
+                            int32_t predictor = (sample1 * c_msCoefs[k][0] + sample2 * c_msCoefs[k][1]) >> 8;
+                            int32_t q = int32_t(lrint(double(target - predictor) / delta));
+                            nibbles[j] = uint8_t(std::clamp(q, -8, 7) & 15);
+                            int32_t decoded = MsStep(sample1, sample2, delta, c_msCoefs[k], nibbles[j]);
+                            error += int64_t(decoded - target) * (decoded - target);
+                        }
+                        if (error < bestError) {
+                            bestError = error;
+                            bestNibbles = nibbles;
+                            bestPredictor = k;
+                        }
+                    }
+                    block[c] = uint8_t(bestPredictor);
+                    put16(block + channels + 2 * c, 16);
+                    put16(block + 3 * channels + 2 * c, sampleAt(first + 1, c));
+                    put16(block + 5 * channels + 2 * c, sampleAt(first, c));
+                    for (uint32_t j = 0; j + 2 < framesPerBlock; j++) {
+                        uint32_t q = j * channels + c;
+                        block[7 * channels + q / 2] |= (q & 1) ? bestNibbles[j] : bestNibbles[j] << 4;
+                    }
+                }
+            }
+        }
+        return out;
+    }
+
+    // decode blocks to 16-bit stereo, one sample at a time.
+    std::vector<int16_t> DecodeAdpcmReference(bool bIma, const uint8_t *data, uint32_t channels, uint32_t frameCount,
+        uint32_t blockAlign) {
+        uint32_t framesPerBlock = GetAdpcmFramesPerBlock(bIma, channels, blockAlign);
+        std::vector<int16_t> out(size_t(frameCount) * 2);
+        for (uint32_t f = 0; f < frameCount; f += framesPerBlock) {
+            const uint8_t *block = data + size_t(f / framesPerBlock) * blockAlign;
+            uint32_t count = std::min(framesPerBlock, frameCount - f);
+            for (uint32_t c = 0; c < channels; c++) {
+                auto put = [&](uint32_t frame, int32_t v) {
+                    out[size_t(f + frame) * 2 + c] = int16_t(v);
+                    if (channels == 1) out[size_t(f + frame) * 2 + 1] = int16_t(v);
+                };
+                auto get16 = [](const uint8_t *p) { return int32_t(int16_t(p[0] | p[1] << 8)); };
+                if (bIma) {
+                    int32_t predictor = get16(block + 4 * c), index = std::min(int32_t(block[4 * c + 2]), 88);
+                    put(0, predictor);
+                    for (uint32_t j = 0; j + 1 < count; j++) {
+                        uint8_t byte = block[4 * channels + (j / 8) * 4 * channels + c * 4 + (j % 8) / 2];
+                        put(1 + j, ImaStep(predictor, index, (byte >> ((j & 1) * 4)) & 15));
+                    }
+                } else {
+                    const int32_t *coef = c_msCoefs[std::min(uint32_t(block[c]), 6u)];
+                    int32_t delta = std::max(16, get16(block + channels + 2 * c));
+                    int32_t sample1 = get16(block + 3 * channels + 2 * c);
+                    int32_t sample2 = get16(block + 5 * channels + 2 * c);
+                    put(0, sample2);
+                    if (count > 1) put(1, sample1);
+                    for (uint32_t j = 0; j + 2 < count; j++) {
+                        uint32_t q = j * channels + c;
+                        uint8_t byte = block[7 * channels + q / 2];
+                        put(2 + j, MsStep(sample1, sample2, delta, coef, (q & 1) ? (byte & 15) : (byte >> 4)));
+                    }
+                }
+            }
+        }
+        return out;
+    }
+
 }
 
 
@@ -146,6 +438,4287 @@ TEST_CASE( "signed angle", "[ae::math]" ) {
     REQUIRE(abs(ang)>halfPi);
 }
 
+TEST_CASE( "meshlets", "[ae::mesh]" ) {
+    // a flat grid in the XY plane facing +Z.
+    constexpr uint32_t gridDim = 32;
+    ae::raw_model_t grid = {};
+    for (uint32_t y = 0; y <= gridDim; y++) {
+        for (uint32_t x = 0; x <= gridDim; x++) {
+            float v[8] = { x / (float)gridDim * 2.f - 1.f, y / (float)gridDim * 2.f - 1.f, 0, 0, 0, 0, 0, 1 };
+            for (float f : v) StretchyBufferPush(grid.vertexData, f);
+        }
+    }
+    for (uint32_t y = 0; y < gridDim; y++) {
+        for (uint32_t x = 0; x < gridDim; x++) {
+            uint32_t i0 = y * (gridDim + 1) + x, i1 = i0 + 1, i2 = i0 + gridDim + 1, i3 = i2 + 1;
+            uint32_t quad[6] = { i0, i1, i3, i0, i3, i2 };
+            for (uint32_t i : quad) StretchyBufferPush(grid.indexData, i);
+        }
+    }
+    const uint32_t indexCount = StretchyBufferCount(grid.indexData);
+
+    ae::mesh::meshlet_model_t meshlets = ae::mesh::buildMeshlets(grid);
+    REQUIRE( meshlets.indexCount == indexCount );
+
+    SECTION( "meshlets respect the limits and cover every triangle once" ) {
+        std::vector<uint64_t> expected, actual;
+        auto triKey = [](uint32_t a, uint32_t b, uint32_t c) {
+            // rotate so that the smallest index is first; this keeps the winding.
+            while (a > b || a > c) { uint32_t t = a; a = b; b = c; c = t; }
+            return ((uint64_t)a << 42) | ((uint64_t)b << 21) | (uint64_t)c;
+        };
+        for (uint32_t i = 0; i < indexCount; i += 3)
+            expected.push_back(triKey(grid.indexData[i], grid.indexData[i + 1], grid.indexData[i + 2]));
+        for (uint32_t m = 0; m < StretchyBufferCount(meshlets.meshlets); m++) {
+            const ae::mesh::meshlet_t &meshlet = meshlets.meshlets[m];
+            REQUIRE( meshlet.vertexCount <= ae::mesh::MESHLET_MAX_VERTICES );
+            REQUIRE( meshlet.triangleCount <= ae::mesh::MESHLET_MAX_TRIANGLES );
+            const uint32_t *v = meshlets.vertexIndices + meshlet.vertexOffset;
+            const uint8_t  *t = meshlets.triangleIndices + meshlet.triangleOffset;
+            for (uint32_t i = 0; i < meshlet.triangleCount * 3; i += 3) {
+                REQUIRE( t[i] < meshlet.vertexCount );
+                actual.push_back(triKey(v[t[i]], v[t[i + 1]], v[t[i + 2]]));
+            }
+            for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+                const float *p = grid.vertexData + v[i] * 8;
+                REQUIRE( ae::math::dist({p[0], p[1], p[2]}, meshlet.center) <= meshlet.radius + 1e-5f );
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+        std::sort(actual.begin(), actual.end());
+        REQUIRE( expected == actual );
+    }
+
+    SECTION( "culling" ) {
+        ae::math::camera_t cam = {};
+        cam.trans.scale = {1, 1, 1};
+        cam.fov = 90.f;
+        cam.nearPlane = 0.1f;
+        cam.farPlane = 100.f;
+        cam.width = cam.height = 512;
+        std::vector<uint32_t> indices(meshlets.indexCount);
+        ae::math::mat4_t identity = {};
+
+        // in front of the grid and looking at it.
+        cam.trans.pos = {0, 0, 5};
+        REQUIRE( ae::mesh::cullMeshlets(meshlets, cam, identity, indices.data()) == indexCount );
+
+        // behind the grid and looking at it, everything is backfacing.
+        cam.trans.pos = {0, 0, -5};
+        cam.trans.eulerAngles = {0, PI, 0};
+        REQUIRE( ae::mesh::cullMeshlets(meshlets, cam, identity, indices.data()) == 0 );
+
+        // in front of the grid but looking away.
+        cam.trans.pos = {0, 0, 5};
+        REQUIRE( ae::mesh::cullMeshlets(meshlets, cam, identity, indices.data()) == 0 );
+
+        // looking at the corner of the grid from close up, only some of the meshlets survive.
+        cam.trans.pos = {1, 1, 0.5f};
+        cam.trans.eulerAngles = {};
+        uint32_t visible = 0;
+        uint32_t count = ae::mesh::cullMeshlets(meshlets, cam, identity, indices.data(), &visible);
+        REQUIRE( count > 0 );
+        REQUIRE( count < indexCount );
+        REQUIRE( visible < StretchyBufferCount(meshlets.meshlets) );
+
+        // the cone test still culls under a uniform scale.
+        ae::math::mat4_t scaled = {};
+        scaled.mat[0][0] = scaled.mat[1][1] = scaled.mat[2][2] = 2.f;
+        cam.trans.pos = {0, 0, -5};
+        cam.trans.eulerAngles = {0, PI, 0};
+        REQUIRE( ae::mesh::cullMeshlets(meshlets, cam, scaled, indices.data()) == 0 );
+
+        // the grid turned and then stretched along X still faces a camera that sees all of it, even though the
+        // cone axes that the model matrix maps are nearly along X.
+        ae::math::mat4_t stretch = {};
+        stretch.mat[0][0] = 10.f;
+        ae::math::mat4_t model = stretch * ae::math::buildRotMat4({0, PI / 4.f, 0});
+        cam.trans.pos = {0, 0, 20};
+        cam.trans.eulerAngles = {};
+        REQUIRE( ae::mesh::cullMeshlets(meshlets, cam, model, indices.data()) == indexCount );
+    }
+
+    ae::mesh::freeMeshlets(meshlets);
+    ae::io::freeObj(grid);
+}
+
+TEST_CASE( "asset packs", "[ae::pak]" ) {
+    utils::Seed(__LINE__);
+
+    // a text that compresses, spanning a few chunks, and noise that does not.
+    std::vector<uint8_t> text, noise(ae::pak::PAK_CHUNK_SIZE + 100);
+    const char *line = "the quick brown fox jumps over the lazy dog.\n";
+    while (text.size() < ae::pak::PAK_CHUNK_SIZE * 2 + 300) text.insert(text.end(), line, line + strlen(line));
+    for (uint8_t &b : noise) b = (uint8_t)utils::RandomUINT32(0, 255);
+
+    SECTION( "LZ4 blocks round-trip" ) {
+        std::vector<uint8_t> compressed(text.size()), decompressed(text.size());
+        uint32_t stored =
+            ae::pak::lz4Compress(text.data(), (uint32_t)text.size(), compressed.data(), (uint32_t)compressed.size());
+        REQUIRE( stored > 0 );
+        REQUIRE( stored < text.size() / 4 );
+        int64_t size = ae::pak::lz4Decompress(compressed.data(), stored, decompressed.data(), (uint32_t)text.size());
+        REQUIRE( size == (int64_t)text.size() );
+        REQUIRE( decompressed == text );
+
+        // noise does not fit in less than its own size.
+        uint32_t noiseSize = (uint32_t)noise.size();
+        REQUIRE( ae::pak::lz4Compress(noise.data(), noiseSize, compressed.data(), noiseSize - 1) == 0 );
+        // a truncated block is rejected.
+        size = ae::pak::lz4Decompress(compressed.data(), stored / 2, decompressed.data(), (uint32_t)text.size());
+        REQUIRE( size < (int64_t)text.size() );
+    }
+
+    SECTION( "entries are found and extracted" ) {
+        const char *srcPaths[] = { "ae_test_pak_text.txt", "ae_test_pak_noise.bin", "ae_test_pak_empty.bin" };
+        const char *pakPaths[] = { "res/Text.txt", "res\\noise.bin", "./res/empty.bin" };
+        const std::vector<uint8_t> *contents[] = { &text, &noise, nullptr };
+        for (uint32_t i = 0; i < 3; i++) {
+            FILE *f = fopen(srcPaths[i], "wb");
+            REQUIRE( f );
+            if (contents[i]) fwrite(contents[i]->data(), 1, contents[i]->size(), f);
+            fclose(f);
+        }
+        REQUIRE( ae::pak::writePack("ae_test.aepak", srcPaths, pakPaths, 3, true) );
+
+        std::vector<uint8_t> memory;
+        FILE *f = fopen("ae_test.aepak", "rb");
+        REQUIRE( f );
+        fseek(f, 0, SEEK_END);
+        memory.resize((size_t)ftell(f));
+        fseek(f, 0, SEEK_SET);
+        REQUIRE( fread(memory.data(), 1, memory.size(), f) == memory.size() );
+        fclose(f);
+
+        ae::pak::pak_t pak;
+        REQUIRE( ae::pak::open(&pak, memory.data(), memory.size()) );
+        REQUIRE( pak.header->entryCount == 3 );
+
+        // lookups are normalized, so case, slashes and a leading ".\" do not matter.
+        const ae::pak::pak_entry_t *textEntry = ae::pak::find(pak, "RES\\text.txt");
+        const ae::pak::pak_entry_t *noiseEntry = ae::pak::find(pak, "./res/noise.bin");
+        const ae::pak::pak_entry_t *emptyEntry = ae::pak::find(pak, "res/empty.bin");
+        REQUIRE( textEntry );
+        REQUIRE( noiseEntry );
+        REQUIRE( emptyEntry );
+        REQUIRE( ae::pak::find(pak, "res/missing.bin") == nullptr );
+
+        REQUIRE( (textEntry->flags & ae::pak::PAK_ENTRY_COMPRESSED) );
+        REQUIRE( textEntry->storedSize < text.size() );
+        REQUIRE( !(noiseEntry->flags & ae::pak::PAK_ENTRY_COMPRESSED) );
+        REQUIRE( noiseEntry->storedSize == noise.size() );
+        REQUIRE( emptyEntry->rawSize == 0 );
+        for (const ae::pak::pak_entry_t *entry : { textEntry, noiseEntry, emptyEntry })
+            REQUIRE( entry->dataOffset % ae::pak::PAK_ALIGNMENT == 0 );
+
+        std::vector<uint8_t> extracted(textEntry->rawSize);
+        REQUIRE( ae::pak::extract(pak, textEntry, extracted.data()) );
+        REQUIRE( extracted == text );
+        extracted.resize(noiseEntry->rawSize);
+        REQUIRE( ae::pak::extract(pak, noiseEntry, extracted.data()) );
+        REQUIRE( extracted == noise );
+
+        // a pack that was cut short does not open.
+        REQUIRE( !ae::pak::open(&pak, memory.data(), memory.size() - 1) );
+
+        for (const char *path : srcPaths) remove(path);
+        remove("ae_test.aepak");
+    }
+}
+
+TEST_CASE( "asset cache", "[ae::asset]" ) {
+    utils::SetupTestEngineContext();
+
+    const char *objText = "o quad\nv 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nvt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+                          "vn 0 0 1\nf 1/1/1 2/2/1 3/3/1\nf 1/1/1 3/3/1 4/4/1\n";
+    REQUIRE( ae::EM->pfn.writeEntireFile("ae_test_quad.obj", (void *)objText, (uint32_t)strlen(objText)) );
+    REQUIRE( ae::EM->pfn.writeEntireFile("ae_test_quad2.obj", (void *)objText, (uint32_t)strlen(objText)) );
+
+    SECTION( "loads are deduplicated by normalized path" ) {
+        ae::asset::asset_handle_t a = ae::asset::loadModel("ae_test_quad.obj");
+        ae::asset::asset_handle_t b = ae::asset::loadModel("./AE_TEST_QUAD.OBJ");
+        REQUIRE( ae::asset::getState(a) == ae::asset::ASSET_STATE_LOADED );
+        REQUIRE( a.index == b.index );
+        REQUIRE( a.generation == b.generation );
+        REQUIRE( ae::asset::getModel(a).vertexData == ae::asset::getModel(b).vertexData );
+        REQUIRE( StretchyBufferCount(ae::asset::getModel(a).indexData) == 6 );
+        // a model handle is not an image handle.
+        REQUIRE( ae::asset::getImage(a).pixelPointer == nullptr );
+        ae::asset::release(a);
+        ae::asset::release(b);
+    }
+
+    SECTION( "unreferenced assets are evicted to meet the budget and their handles go stale" ) {
+        ae::asset::asset_handle_t a = ae::asset::loadModel("ae_test_quad.obj");
+        uint64_t oneModel = ae::asset::getMemoryUsage();
+        REQUIRE( oneModel > 0 );
+        ae::asset::setMemoryBudget(oneModel);
+
+        // referenced assets are never evicted, even over budget.
+        ae::asset::asset_handle_t b = ae::asset::loadModel("ae_test_quad2.obj");
+        REQUIRE( ae::asset::getMemoryUsage() == 2 * oneModel );
+        REQUIRE( ae::asset::getState(a) == ae::asset::ASSET_STATE_LOADED );
+
+        ae::asset::release(a);
+        REQUIRE( ae::asset::getState(a) == ae::asset::ASSET_STATE_INVALID );
+        REQUIRE( ae::asset::getMemoryUsage() == oneModel );
+
+        // the slot is reused with a new generation.
+        ae::asset::asset_handle_t c = ae::asset::loadModel("ae_test_quad.obj");
+        REQUIRE( ae::asset::getState(c) == ae::asset::ASSET_STATE_LOADED );
+        REQUIRE( ae::asset::getState(a) == ae::asset::ASSET_STATE_INVALID );
+        ae::asset::release(b);
+        ae::asset::release(c);
+    }
+
+    SECTION( "async loads" ) {
+        ae::asset::asset_handle_t handles[8];
+        for (auto &h : handles) h = ae::asset::loadModel("ae_test_quad.obj", true);
+        ae::asset::asset_handle_t missing = ae::asset::loadModel("ae_test_missing.obj", true);
+        for (auto &h : handles) {
+            REQUIRE( h.index == handles[0].index );
+            REQUIRE( ae::asset::wait(h) == ae::asset::ASSET_STATE_LOADED );
+        }
+        REQUIRE( ae::asset::wait(missing) == ae::asset::ASSET_STATE_FAILED );
+        for (auto &h : handles) ae::asset::release(h);
+        ae::asset::release(missing);
+    }
+
+    SECTION( "a failed asset is loaded again" ) {
+        ae::asset::asset_handle_t a = ae::asset::loadModel("ae_test_late.obj");
+        REQUIRE( ae::asset::getState(a) == ae::asset::ASSET_STATE_FAILED );
+        REQUIRE( ae::EM->pfn.writeEntireFile("ae_test_late.obj", (void *)objText, (uint32_t)strlen(objText)) );
+        ae::asset::asset_handle_t b = ae::asset::loadModel("ae_test_late.obj", true);
+        REQUIRE( b.index == a.index );
+        REQUIRE( ae::asset::wait(b) == ae::asset::ASSET_STATE_LOADED );
+        REQUIRE( ae::asset::getState(a) == ae::asset::ASSET_STATE_LOADED );
+        ae::asset::release(a);
+        ae::asset::release(b);
+        remove("ae_test_late.obj");
+    }
+
+    ae::asset::clear();
+    REQUIRE( ae::asset::getMemoryUsage() == 0 );
+    ae::jobs::shutdown();
+    remove("ae_test_quad.obj");
+    remove("ae_test_quad2.obj");
+}
+
+TEST_CASE( "parallel for", "[ae::jobs]" ) {
+    const uint32_t count = 1000;
+    std::atomic<uint32_t> hits[count];
+    for (auto &h : hits) h = 0;
+    // NOTE: Catch assertions are not thread-safe, so the chunks only record what they saw.
+    std::atomic<uint32_t> maxChunk = 0;
+    ae::jobs::parallelFor(count, 7, [&](uint32_t begin, uint32_t end) {
+        uint32_t size = end - begin, prev = maxChunk.load();
+        while (size > prev && !maxChunk.compare_exchange_weak(prev, size)) {}
+        for (uint32_t i = begin; i < end; i++) hits[i]++;
+    });
+    REQUIRE( maxChunk.load() == 7 );
+    for (auto &h : hits) REQUIRE( h.load() == 1 );
+
+    // nested calls from within a chunk complete too.
+    std::atomic<uint32_t> nested = 0;
+    ae::jobs::parallelFor(8, 1, [&](uint32_t, uint32_t) {
+        ae::jobs::parallelFor(16, 2, [&](uint32_t begin, uint32_t end) { nested += end - begin; });
+    });
+    REQUIRE( nested.load() == 8 * 16 );
+    ae::jobs::shutdown();
+}
+
+TEST_CASE( "batched image loads", "[ae::io]" ) {
+    utils::SetupTestEngineContext();
+
+    // NOTE: odd widths exercise the scalar tail of the row copy.
+    const uint32_t widths[]  = { 1, 5, 13, 64 };
+    const uint32_t heights[] = { 3, 1, 7, 33 };
+    const uint32_t imageCount = 4;
+    char pathStorage[imageCount][64];
+    const char *paths[imageCount + 1];
+    for (uint32_t i = 0; i < imageCount; i++) {
+        std::vector<uint32_t> pixels(widths[i] * heights[i]);
+        // R = x, G = y, B = image index, A = 255 - x. the first row in the file is the top row.
+        for (uint32_t y = 0; y < heights[i]; y++)
+            for (uint32_t x = 0; x < widths[i]; x++)
+                pixels[y * widths[i] + x] = x | (y << 8) | (i << 16) | ((255 - x) << 24);
+        snprintf(pathStorage[i], sizeof(pathStorage[i]), "ae_test_image%u.png", i);
+        REQUIRE( stbi_write_png(pathStorage[i], widths[i], heights[i], 4, pixels.data(), widths[i] * 4) );
+        paths[i] = pathStorage[i];
+    }
+    paths[imageCount] = "ae_test_missing.png";
+
+    auto check = [&](bool bFlip, bool bSwizzle) {
+        ae::loaded_image_t images[imageCount + 1];
+        REQUIRE( ae::io::loadImages(paths, imageCount + 1, images, bFlip, bSwizzle) == imageCount );
+        REQUIRE( images[imageCount].pixelPointer == nullptr );
+        for (uint32_t i = 0; i < imageCount; i++) {
+            REQUIRE( images[i].width == widths[i] );
+            REQUIRE( images[i].height == heights[i] );
+            for (uint32_t row = 0; row < heights[i]; row++) {
+                uint32_t y = bFlip ? heights[i] - 1 - row : row;
+                for (uint32_t x = 0; x < widths[i]; x++) {
+                    uint32_t expected = bSwizzle ? (i | (y << 8) | (x << 16) | ((255 - x) << 24))
+                                                 : (x | (y << 8) | (i << 16) | ((255 - x) << 24));
+                    REQUIRE( images[i].pixelPointer[row * widths[i] + x] == expected );
+                }
+            }
+            ae::io::freeLoadedImage(images[i]);
+        }
+    };
+    check(true, false);
+    check(false, false);
+    check(true, true);
+    check(false, true);
+
+    ae::jobs::shutdown();
+    for (uint32_t i = 0; i < imageCount; i++) remove(paths[i]);
+}
+
+TEST_CASE( "texture compression", "[ae::texture]" ) {
+    utils::SetupTestEngineContext();
+    utils::Seed(1);
+
+    // NOTE: smooth gradients with a little noise, which is what the block formats are designed for. the size is
+    // not a multiple of 4 so that partial blocks are covered.
+    const uint32_t width = 70, height = 45;
+    ae::loaded_image_t image = {};
+    std::vector<uint32_t> pixels(width * height);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t r = x * 255 / width, g = y * 255 / height, b = (x + y) * 255 / (width + height);
+            uint32_t a = 255 - (x * y * 255) / (width * height);
+            uint32_t noise = utils::RandomUINT32(0, 6);
+            pixels[y * width + x] = ae::math::min(r + noise, 255u) | (g << 8) | (b << 16) | (a << 24);
+        }
+    }
+    image.pixelPointer = pixels.data();
+    image.width = width;
+    image.height = height;
+
+    ae::texture::texture_t source = ae::texture::createTextureFromImage(image, false);
+    REQUIRE( source.levelCount == 1 );
+    std::vector<uint32_t> decoded(width * height);
+
+    struct {
+        ae::texture::texture_format_t format;
+        uint32_t channelMask;
+        float minPSNR;
+    } cases[] = {
+        { ae::texture::TEXTURE_FORMAT_BC1, 0x00FFFFFF, 35.f },
+        { ae::texture::TEXTURE_FORMAT_BC3, 0xFFFFFFFF, 36.f },
+        { ae::texture::TEXTURE_FORMAT_BC5, 0x0000FFFF, 45.f },
+        { ae::texture::TEXTURE_FORMAT_BC7, 0xFFFFFFFF, 38.f },
+    };
+    for (auto &c : cases) {
+        ae::texture::texture_t compressed = ae::texture::compress(source, c.format);
+        REQUIRE( compressed.dataSize == 18 * 12 * ae::texture::getBlockSize(c.format) );
+        REQUIRE( ae::texture::decompressBlocks(compressed.data, width, height, c.format, decoded.data()) );
+        float psnr = ae::texture::computePSNR(pixels.data(), decoded.data(), width * height, c.channelMask);
+        INFO( "format " << c.format << " PSNR " << psnr );
+        REQUIRE( psnr > c.minPSNR );
+        ae::texture::freeTexture(compressed);
+    }
+
+    SECTION( "a solid block is exact" ) {
+        uint32_t solid[16];
+        for (auto &p : solid) p = 0x80604020;
+        uint8_t block[16];
+        uint32_t out[16];
+        ae::texture::compressBlocks(solid, 4, 4, ae::texture::TEXTURE_FORMAT_BC7, block);
+        REQUIRE( ae::texture::decompressBlocks(block, 4, 4, ae::texture::TEXTURE_FORMAT_BC7, out) );
+        REQUIRE( ae::texture::computePSNR(solid, out, 16) > 45.f );
+        ae::texture::compressBlocks(solid, 4, 4, ae::texture::TEXTURE_FORMAT_BC5, block);
+        ae::texture::decompressBlocks(block, 4, 4, ae::texture::TEXTURE_FORMAT_BC5, out);
+        REQUIRE( ae::texture::computePSNR(solid, out, 16, 0x0000FFFF) == INFINITY );
+    }
+
+    SECTION( "containers round trip with mip chains" ) {
+        ae::texture::texture_t chain = ae::texture::createTexture(ae::texture::TEXTURE_FORMAT_BC7_SRGB, width, height, 0);
+        REQUIRE( chain.levelCount == 7 );
+        REQUIRE( chain.levels[6].width == 1 );
+        REQUIRE( chain.levels[6].height == 1 );
+        for (uint32_t i = 0; i < chain.dataSize; i++) chain.data[i] = uint8_t(i * 31);
+
+        const char *paths[] = { "ae_test_texture.dds", "ae_test_texture.ktx2" };
+        REQUIRE( ae::texture::writeDDS(paths[0], chain) );
+        REQUIRE( ae::texture::writeKTX2(paths[1], chain) );
+        for (const char *path : paths) {
+            ae::texture::texture_t loaded = ae::texture::loadTexture(path);
+            REQUIRE( loaded.format == chain.format );
+            REQUIRE( loaded.width == width );
+            REQUIRE( loaded.height == height );
+            REQUIRE( loaded.levelCount == chain.levelCount );
+            REQUIRE( loaded.dataSize == chain.dataSize );
+            REQUIRE( memcmp(loaded.data, chain.data, chain.dataSize) == 0 );
+            ae::texture::freeTexture(loaded);
+            remove(path);
+        }
+        REQUIRE( ae::texture::loadTexture("ae_test_missing.ktx2").data == nullptr );
+        ae::texture::freeTexture(chain);
+    }
+
+    ae::texture::freeTexture(source);
+    ae::jobs::shutdown();
+}
+
+TEST_CASE( "mip generation", "[ae::io]" ) {
+    utils::SetupTestEngineContext();
+
+    auto makeImage = [](std::vector<uint32_t> &pixels, uint32_t width, uint32_t height) {
+        ae::loaded_image_t image = {};
+        image.pixelPointer = pixels.data();
+        image.width = width;
+        image.height = height;
+        return image;
+    };
+    auto channel = [](uint32_t p, uint32_t c) { return int((p >> (c * 8)) & 0xFF); };
+
+    SECTION( "box filter averages in linear space" ) {
+        std::vector<uint32_t> pixels = { 0xFF000000, 0xFFFFFFFF, 0xFFFFFFFF, 0xFF000000 };
+        ae::loaded_image_t image = makeImage(pixels, 2, 2);
+
+        ae::texture::texture_t linear = ae::io::generateMips(image, ae::io::MIP_FILTER_BOX, false);
+        REQUIRE( linear.format == ae::texture::TEXTURE_FORMAT_RGBA8 );
+        REQUIRE( linear.levelCount == 2 );
+        uint32_t p = *(uint32_t *)(linear.data + linear.levels[1].offset);
+        REQUIRE( std::abs(channel(p, 0) - 128) <= 1 );
+        REQUIRE( channel(p, 3) == 255 );
+
+        // NOTE: half way between black and white in linear light is 188 in sRGB, not 128.
+        ae::texture::texture_t srgb = ae::io::generateMips(image, ae::io::MIP_FILTER_BOX, true);
+        REQUIRE( srgb.format == ae::texture::TEXTURE_FORMAT_RGBA8_SRGB );
+        p = *(uint32_t *)(srgb.data + srgb.levels[1].offset);
+        REQUIRE( std::abs(channel(p, 0) - 188) <= 1 );
+        REQUIRE( memcmp(srgb.data, pixels.data(), 16) == 0 );
+
+        ae::texture::freeTexture(linear);
+        ae::texture::freeTexture(srgb);
+    }
+
+    SECTION( "transparent pixels do not bleed" ) {
+        // transparent red next to opaque green.
+        std::vector<uint32_t> pixels = { 0x000000FF, 0xFF00FF00, 0x000000FF, 0xFF00FF00 };
+        ae::texture::texture_t mips = ae::io::generateMips(makeImage(pixels, 2, 2), ae::io::MIP_FILTER_BOX, false);
+        uint32_t p = *(uint32_t *)(mips.data + mips.levels[1].offset);
+        REQUIRE( channel(p, 0) == 0 );
+        REQUIRE( channel(p, 1) == 255 );
+        REQUIRE( std::abs(channel(p, 3) - 128) <= 1 );
+        ae::texture::freeTexture(mips);
+    }
+
+    SECTION( "every filter keeps a constant image constant" ) {
+        const uint32_t width = 37, height = 10;
+        std::vector<uint32_t> pixels(width * height, 0x80406080);
+        for (auto filter : { ae::io::MIP_FILTER_BOX, ae::io::MIP_FILTER_KAISER, ae::io::MIP_FILTER_LANCZOS }) {
+            ae::texture::texture_t mips = ae::io::generateMips(makeImage(pixels, width, height), filter);
+            REQUIRE( mips.levelCount == 6 );
+            REQUIRE( mips.levels[1].width == 18 );
+            REQUIRE( mips.levels[1].height == 5 );
+            REQUIRE( mips.levels[5].width == 1 );
+            REQUIRE( mips.levels[5].height == 1 );
+            for (uint32_t i = 1; i < mips.levelCount; i++) {
+                const uint32_t *level = (const uint32_t *)(mips.data + mips.levels[i].offset);
+                for (uint32_t j = 0; j < mips.levels[i].width * mips.levels[i].height; j++)
+                    for (uint32_t c = 0; c < 4; c++)
+                        REQUIRE( std::abs(channel(level[j], c) - channel(0x80406080, c)) <= 1 );
+            }
+
+            // the chain can be cooked.
+            ae::texture::texture_t bc1 = ae::texture::compress(mips, ae::texture::TEXTURE_FORMAT_BC1_SRGB);
+            REQUIRE( bc1.levelCount == mips.levelCount );
+            REQUIRE( bc1.levels[5].size == 8 );
+            ae::texture::freeTexture(bc1);
+            ae::texture::freeTexture(mips);
+        }
+    }
+
+    ae::jobs::shutdown();
+}
+
+TEST_CASE( "wav loading and conversion", "[ae::io]" ) {
+    utils::SetupTestEngineContext();
+    const char *path = "ae_test_sound.wav";
+    const double twoPi = 6.283185307179586;
+
+    SECTION( "mix format files are not converted" ) {
+        std::vector<int16_t> samples = { 0, 1, -1, 32767, -32768, 1234, 4321, -7 };
+        REQUIRE( utils::WriteWav(path, 1, 2, 44100, 16, samples.data(), 16) );
+        ae::loaded_wav_t wav = ae::io::loadWav(path);
+        REQUIRE( wav.sampleCount == 4 );
+        REQUIRE( wav.channels == 2 );
+        REQUIRE( (void *)wav.sampleData == (uint8_t *)wav.parentFile.contents + 44 );
+        REQUIRE( memcmp(wav.sampleData, samples.data(), 16) == 0 );
+        ae::io::freeWav(wav);
+    }
+
+    SECTION( "sample formats at the mix rate convert exactly" ) {
+        // every format below can hold these 16-bit values exactly, so they must come back unchanged.
+        const uint32_t frameCount = 37;
+        std::vector<int16_t> expected(frameCount);
+        for (uint32_t i = 0; i < frameCount; i++) expected[i] = int16_t(i * 1771 - 32768);
+        expected[1] = 32767;
+
+        std::vector<uint8_t> pcm24(frameCount * 3);
+        std::vector<int32_t> pcm32(frameCount);
+        std::vector<float> f32(frameCount);
+        std::vector<double> f64(frameCount);
+        for (uint32_t i = 0; i < frameCount; i++) {
+            pcm24[i * 3] = 0;
+            pcm24[i * 3 + 1] = uint8_t(expected[i]);
+            pcm24[i * 3 + 2] = uint8_t(expected[i] >> 8);
+            pcm32[i] = int32_t(expected[i]) * 65536;
+            f32[i] = expected[i] / 32768.f;
+            f64[i] = expected[i] / 32768.0;
+        }
+        struct { uint16_t tag, bits; const void *data; } formats[] = {
+            { 1, 16, expected.data() }, { 1, 24, pcm24.data() }, { 1, 32, pcm32.data() },
+            { 3, 32, f32.data() }, { 3, 64, f64.data() } };
+        for (auto &format : formats) {
+            REQUIRE( utils::WriteWav(path, format.tag, 1, 44100, format.bits, format.data, frameCount * format.bits / 8) );
+            ae::loaded_wav_t wav = ae::io::loadWav(path);
+            REQUIRE( wav.sampleCount == frameCount );
+            REQUIRE( wav.channels == 2 );
+            for (uint32_t i = 0; i < frameCount; i++) {
+                REQUIRE( wav.sampleData[i * 2] == expected[i] );
+                REQUIRE( wav.sampleData[i * 2 + 1] == expected[i] );
+            }
+            ae::io::freeWav(wav);
+        }
+
+        // 8-bit is unsigned.
+        std::vector<uint8_t> pcm8(frameCount);
+        for (uint32_t i = 0; i < frameCount; i++) pcm8[i] = uint8_t(i * 7);
+        REQUIRE( utils::WriteWav(path, 1, 1, 44100, 8, pcm8.data(), frameCount) );
+        ae::loaded_wav_t wav = ae::io::loadWav(path);
+        REQUIRE( wav.sampleCount == frameCount );
+        for (uint32_t i = 0; i < frameCount; i++) REQUIRE( wav.sampleData[i * 2] == (int(pcm8[i]) - 128) * 256 );
+        ae::io::freeWav(wav);
+    }
+
+    SECTION( "5.1 is downmixed" ) {
+        // FL FR C LFE BL BR. the LFE channel is dropped.
+        std::vector<float> frame = { 0.5f, 0.f, 0.25f, 1.f, 0.f, 0.f };
+        REQUIRE( utils::WriteWav(path, 3, 6, 44100, 32, frame.data(), 24) );
+        ae::loaded_wav_t wav = ae::io::loadWav(path);
+        REQUIRE( wav.sampleCount == 1 );
+        const float norm = 1.f / (1.f + 2.f * 0.7071068f);
+        REQUIRE( std::abs(wav.sampleData[0] - (0.5f + 0.7071068f * 0.25f) * norm * 32768.f) <= 1.f );
+        REQUIRE( std::abs(wav.sampleData[1] - 0.7071068f * 0.25f * norm * 32768.f) <= 1.f );
+        ae::io::freeWav(wav);
+    }
+
+    SECTION( "resampled sines stay sines" ) {
+        const uint32_t rates[] = { 8000, 22050, 32000, 48000, 96000 };
+        const float maxError[] = { 0.01f, 0.004f, 0.0015f };
+        for (uint32_t rate : rates) {
+            // a stereo sine at 1 kHz on the left and 3 kHz on the right, half a second long.
+            uint32_t frameCount = rate / 2;
+            std::vector<int16_t> samples(frameCount * 2);
+            for (uint32_t i = 0; i < frameCount; i++) {
+                samples[i * 2] = int16_t(lrint(16384.0 * sin(twoPi * 1000.0 * i / rate)));
+                samples[i * 2 + 1] = int16_t(lrint(16384.0 * sin(twoPi * 3000.0 * i / rate)));
+            }
+            REQUIRE( utils::WriteWav(path, 1, 2, rate, 16, samples.data(), frameCount * 4) );
+            for (uint32_t quality = 0; quality < 3; quality++) {
+                ae::loaded_wav_t wav = ae::io::loadWav(path, ae::io::resample_quality_t(quality));
+                REQUIRE( wav.sampleCount == (frameCount * 44100ull + rate - 1) / rate );
+                float error = 0.f;
+                // NOTE: the ends are skipped since the sine starts and stops abruptly there.
+                for (int i = 200; i < wav.sampleCount - 200; i++) {
+                    double l = 0.5 * sin(twoPi * 1000.0 * i / 44100.0), r = 0.5 * sin(twoPi * 3000.0 * i / 44100.0);
+                    error = std::max(error, float(std::abs(wav.sampleData[i * 2] / 32768.0 - l)));
+                    error = std::max(error, float(std::abs(wav.sampleData[i * 2 + 1] / 32768.0 - r)));
+                }
+                // NOTE: the fast preset rolls off early, so 3 kHz is outside of its passband at 8 kHz.
+                if (rate > 8000 || quality != ae::io::RESAMPLE_QUALITY_FAST) REQUIRE( error < maxError[quality] );
+                ae::io::freeWav(wav);
+            }
+        }
+    }
+
+    SECTION( "downsampling removes tones above the output nyquist" ) {
+        const uint32_t rate = 96000, frameCount = rate / 4;
+        std::vector<float> samples(frameCount);
+        for (uint32_t i = 0; i < frameCount; i++) samples[i] = float(0.5 * sin(twoPi * 30000.0 * i / rate));
+        REQUIRE( utils::WriteWav(path, 3, 1, rate, 32, samples.data(), frameCount * 4) );
+        ae::loaded_wav_t wav = ae::io::loadWav(path, ae::io::RESAMPLE_QUALITY_DEFAULT);
+        double energy = 0.0;
+        for (int i = 200; i < wav.sampleCount - 200; i++) energy += double(wav.sampleData[i * 2]) * wav.sampleData[i * 2];
+        double rms = sqrt(energy / (wav.sampleCount - 400)) / 32768.0;
+        REQUIRE( rms < 0.001 );
+        ae::io::freeWav(wav);
+    }
+
+    SECTION( "chunked conversion matches a single conversion" ) {
+        ae::io::audio_format_t format = { 48000, 2, 16, false };
+        const uint32_t frameCount = 10000;
+        std::vector<int16_t> samples(frameCount * 2);
+        utils::Seed(__LINE__);
+        for (auto &sample : samples) sample = int16_t(utils::RandomBits(16) - 32768);
+
+        ae::io::audio_converter_t *converter = ae::io::createAudioConverter(format, ae::io::RESAMPLE_QUALITY_HIGH);
+        REQUIRE( converter );
+        std::vector<int16_t> whole(ae::io::getMaxConvertedFrames(converter, frameCount) * 2);
+        uint32_t wholeFrames = ae::io::convertAudio(converter, samples.data(), frameCount, whole.data());
+        wholeFrames += ae::io::flushAudioConverter(converter, whole.data() + wholeFrames * 2);
+        REQUIRE( wholeFrames == 9188 );
+
+        // the converter is reusable after a flush.
+        std::vector<int16_t> chunked;
+        for (uint32_t at = 0, chunk = 1; at < frameCount; at += chunk, chunk = chunk * 3 + 1) {
+            uint32_t count = std::min(chunk, frameCount - at);
+            size_t size = chunked.size();
+            chunked.resize(size + ae::io::getMaxConvertedFrames(converter, count) * 2);
+            uint32_t written = ae::io::convertAudio(converter, samples.data() + at * 2, count, chunked.data() + size);
+            chunked.resize(size + written * 2);
+        }
+        size_t size = chunked.size();
+        chunked.resize(size + ae::io::getMaxConvertedFrames(converter, 0) * 2);
+        chunked.resize(size + ae::io::flushAudioConverter(converter, chunked.data() + size) * 2);
+        REQUIRE( chunked.size() == wholeFrames * 2 );
+        REQUIRE( memcmp(chunked.data(), whole.data(), wholeFrames * 4) == 0 );
+        ae::io::destroyAudioConverter(converter);
+    }
+
+    SECTION( "unsupported files fail" ) {
+        uint8_t sample = 0;
+        REQUIRE( utils::WriteWav(path, 2, 1, 44100, 4, &sample, 1) );
+        ae::loaded_wav_t wav = ae::io::loadWav(path);
+        REQUIRE( wav.sampleData == nullptr );
+        REQUIRE( wav.sampleCount == 0 );
+        REQUIRE( ae::io::loadWav("ae_test_missing.wav").sampleData == nullptr );
+        ae::io::audio_format_t format = { 44100, 3, 16, false };
+        REQUIRE( ae::io::createAudioConverter(format, ae::io::RESAMPLE_QUALITY_DEFAULT) == nullptr );
+    }
+
+    remove(path);
+}
+
+TEST_CASE( "adpcm", "[ae::io]" ) {
+    utils::SetupTestEngineContext();
+    const char *path = "ae_test_adpcm.wav";
+
+    // a sweep with some noise, so that the predictors and step sizes move around. the channels differ.
+    const uint32_t frameCount = 5000;
+    std::vector<int16_t> samples(frameCount * 2);
+    utils::Seed(__LINE__);
+    for (uint32_t i = 0; i < frameCount; i++) {
+        for (uint32_t c = 0; c < 2; c++) {
+            double tone = 14000.0 * sin(i * (0.01 + i * 0.00001) + c) + utils::RandomFloat(-300.f, 300.f);
+            samples[i * 2 + c] = int16_t(lrint(tone));
+        }
+    }
+    std::vector<int16_t> mono(frameCount);
+    for (uint32_t i = 0; i < frameCount; i++) mono[i] = samples[i * 2];
+
+    struct case_t {
+        bool bIma;
+        uint16_t channels;
+        uint16_t blockAlign;
+    };
+    const case_t cases[] = { { true, 1, 256 }, { true, 2, 512 }, { false, 1, 256 }, { false, 2, 512 } };
+
+    SECTION( "decoding matches a scalar decoder" ) {
+        for (const case_t &test : cases) {
+            const int16_t *src = (test.channels == 1) ? mono.data() : samples.data();
+            uint32_t framesPerBlock = utils::GetAdpcmFramesPerBlock(test.bIma, test.channels, test.blockAlign);
+            std::vector<uint8_t> blocks = utils::EncodeAdpcm(test.bIma, src, test.channels, frameCount, test.blockAlign);
+            std::vector<int16_t> reference =
+                utils::DecodeAdpcmReference(test.bIma, blocks.data(), test.channels, frameCount, test.blockAlign);
+            REQUIRE( utils::WriteAdpcmWav(path, test.bIma ? 0x11 : 2, test.channels, 44100, test.blockAlign,
+                uint16_t(framesPerBlock), blocks.data(), uint32_t(blocks.size()), frameCount) );
+
+            ae::loaded_wav_t wav = ae::io::loadWav(path);
+            REQUIRE( wav.encoding == ae::io::WAV_ENCODING_PCM16 );
+            REQUIRE( wav.sampleCount == int(frameCount) );
+            REQUIRE( wav.channels == 2 );
+            REQUIRE( memcmp(wav.sampleData, reference.data(), frameCount * 4) == 0 );
+            // 4 bits per sample still tracks the signal closely.
+            double error = 0.0;
+            for (uint32_t i = 0; i < frameCount; i++) {
+                double diff = double(wav.sampleData[i * 2 + 1]) - src[i * test.channels + test.channels - 1];
+                error += diff * diff;
+            }
+            REQUIRE( sqrt(error / frameCount) < 600.0 );
+
+            // the compressed blocks decode to the same samples.
+            ae::loaded_wav_t compressed = ae::io::loadWav(path, ae::io::RESAMPLE_QUALITY_DEFAULT, true);
+            REQUIRE( compressed.sampleData == nullptr );
+            ae::io::wav_encoding_t encoding = test.bIma ? ae::io::WAV_ENCODING_IMA_ADPCM : ae::io::WAV_ENCODING_MS_ADPCM;
+            REQUIRE( compressed.encoding == encoding );
+            REQUIRE( compressed.sampleCount == int(frameCount) );
+            REQUIRE( compressed.channels == test.channels );
+            REQUIRE( compressed.framesPerBlock == framesPerBlock );
+            uint32_t blockCount = (frameCount + framesPerBlock - 1) / framesPerBlock;
+            std::vector<int16_t> decoded(size_t(blockCount) * framesPerBlock * 2);
+            REQUIRE( ae::io::decodeWavBlocks(compressed, 0, blockCount, decoded.data()) == frameCount );
+            REQUIRE( memcmp(decoded.data(), reference.data(), frameCount * 4) == 0 );
+            // from partway in, too.
+            REQUIRE( ae::io::decodeWavBlocks(compressed, 3, 2, decoded.data()) == 2 * framesPerBlock );
+            REQUIRE( memcmp(decoded.data(), &reference[3 * framesPerBlock * 2], 2 * framesPerBlock * 4) == 0 );
+            REQUIRE( ae::io::decodeWavBlocks(compressed, blockCount, 1, decoded.data()) == 0 );
+            ae::io::freeWav(compressed);
+            ae::io::freeWav(wav);
+        }
+    }
+
+    SECTION( "a data chunk that ends partway into a block" ) {
+        for (const case_t &test : cases) {
+            const int16_t *src = (test.channels == 1) ? mono.data() : samples.data();
+            std::vector<uint8_t> blocks = utils::EncodeAdpcm(test.bIma, src, test.channels, frameCount, test.blockAlign);
+            // without a fact chunk, the length comes from the size of the data. cut the data into the second block.
+            // only the whole groups of nibbles past the header of the partial block are decoded.
+            uint32_t rest = 8 * test.channels + 3;
+            uint32_t size = test.blockAlign + (test.bIma ? 4u : 7u) * test.channels + rest;
+            uint32_t framesPerBlock = utils::GetAdpcmFramesPerBlock(test.bIma, test.channels, test.blockAlign);
+            uint32_t expected =
+                framesPerBlock + (test.bIma ? 1 + rest / (4 * test.channels) * 8 : 2 + rest * 2 / test.channels);
+            REQUIRE( utils::WriteAdpcmWav(path, test.bIma ? 0x11 : 2, test.channels, 44100, test.blockAlign,
+                uint16_t(framesPerBlock), blocks.data(), size, 0) );
+            std::vector<int16_t> reference =
+                utils::DecodeAdpcmReference(test.bIma, blocks.data(), test.channels, expected, test.blockAlign);
+
+            ae::loaded_wav_t wav = ae::io::loadWav(path);
+            REQUIRE( wav.sampleCount == int(expected) );
+            REQUIRE( memcmp(wav.sampleData, reference.data(), expected * 4) == 0 );
+            ae::io::freeWav(wav);
+        }
+    }
+
+    SECTION( "other rates are decoded and converted" ) {
+        std::vector<uint8_t> blocks = utils::EncodeAdpcm(true, mono.data(), 1, frameCount, 256);
+        REQUIRE( utils::WriteAdpcmWav(path, 0x11, 1, 22050, 256, 505, blocks.data(), uint32_t(blocks.size()),
+            frameCount) );
+        ae::loaded_wav_t wav = ae::io::loadWav(path, ae::io::RESAMPLE_QUALITY_DEFAULT, true);
+        REQUIRE( wav.encoding == ae::io::WAV_ENCODING_PCM16 );
+        REQUIRE( wav.sampleData != nullptr );
+        REQUIRE( std::abs(wav.sampleCount - int(frameCount * 2)) <= 2 );
+        ae::io::freeWav(wav);
+    }
+
+    SECTION( "compressed voices decode just in time" ) {
+        static ae::PFN_voiceFillCallback s_fill;
+        static void *s_user;
+        static bool s_bSubmittedBuffer;
+        ae::EM->pfn.voiceSubmitCallback = [](intptr_t voiceHandle, ae::PFN_voiceFillCallback fill, void *user) {
+            s_fill = fill;
+            s_user = user;
+            return true;
+        };
+        ae::EM->pfn.voiceSubmitBuffer = [](intptr_t voiceHandle, ae::loaded_wav_t wav) {
+            s_bSubmittedBuffer = true;
+            return true;
+        };
+
+        std::vector<uint8_t> blocks = utils::EncodeAdpcm(false, samples.data(), 2, frameCount, 512);
+        std::vector<int16_t> reference = utils::DecodeAdpcmReference(false, blocks.data(), 2, frameCount, 512);
+        REQUIRE( utils::WriteAdpcmWav(path, 2, 2, 44100, 512, 500, blocks.data(), uint32_t(blocks.size()),
+            frameCount) );
+        ae::loaded_wav_t wav = ae::io::loadWav(path, ae::io::RESAMPLE_QUALITY_DEFAULT, true);
+        REQUIRE( wav.encoding == ae::io::WAV_ENCODING_MS_ADPCM );
+
+        // a voice pulls in odd sized buffers that do not line up with the blocks.
+        for (bool bLoop : { false, true }) {
+            REQUIRE( ae::audio::voiceSubmitWav(0, wav, bLoop) );
+            std::vector<int16_t> played;
+            int16_t buffer[777 * 2];
+            uint32_t filled;
+            while ((filled = s_fill(s_user, buffer, 777)) == 777 && played.size() < frameCount * 5) {
+                played.insert(played.end(), buffer, buffer + filled * 2);
+            }
+            played.insert(played.end(), buffer, buffer + filled * 2);
+            if (bLoop) {
+                REQUIRE( played.size() >= frameCount * 5 );
+            } else {
+                REQUIRE( played.size() == frameCount * 2 );
+                REQUIRE( s_fill(s_user, buffer, 777) == 0 );
+            }
+            for (size_t i = 0; i < played.size() / 2; i++) {
+                REQUIRE( played[i * 2] == reference[(i % frameCount) * 2] );
+                REQUIRE( played[i * 2 + 1] == reference[(i % frameCount) * 2 + 1] );
+            }
+        }
+
+        // plain samples that do not loop go straight to the platform.
+        ae::loaded_wav_t pcm = ae::io::loadWav(path);
+        REQUIRE( ae::audio::voiceSubmitWav(0, pcm) );
+        REQUIRE( s_bSubmittedBuffer );
+        ae::loaded_wav_t empty = {};
+        REQUIRE( !ae::audio::voiceSubmitWav(0, empty) );
+        ae::io::freeWav(pcm);
+        ae::io::freeWav(wav);
+        ae::EM->pfn.voiceSubmitCallback = nullptr;
+        ae::EM->pfn.voiceSubmitBuffer = nullptr;
+    }
+
+    SECTION( "malformed files fail" ) {
+        uint8_t block[256] = {};
+        // the block size does not fit whole groups of samples.
+        REQUIRE( utils::WriteAdpcmWav(path, 0x11, 1, 44100, 250, 0, block, sizeof(block), 0) );
+        REQUIRE( ae::io::loadWav(path).sampleCount == 0 );
+        // the samples per block disagree with the block size.
+        REQUIRE( utils::WriteAdpcmWav(path, 0x11, 1, 44100, 256, 500, block, sizeof(block), 0) );
+        REQUIRE( ae::io::loadWav(path).sampleCount == 0 );
+        REQUIRE( utils::WriteAdpcmWav(path, 2, 3, 44100, 256 * 3, 0, block, sizeof(block), 0) );
+        REQUIRE( ae::io::loadWav(path).sampleCount == 0 );
+        // ADPCM is not streamed.
+        REQUIRE( utils::WriteAdpcmWav(path, 0x11, 1, 44100, 256, 505, block, sizeof(block), 0) );
+        REQUIRE( ae::io::loadWav(path).sampleCount == 505 );
+        REQUIRE( ae::audio::openStream(path) == nullptr );
+    }
+
+    remove(path);
+}
+
+TEST_CASE( "audio streaming", "[ae::audio]" ) {
+    utils::SetupTestEngineContext();
+    const char *path = "ae_test_stream.wav";
+
+    // read a stream to its end (or to maxFrames). the decoder runs on its own thread, so reads may come up empty.
+    auto readAll = [](ae::audio::audio_stream_t *stream, uint32_t maxFrames) {
+        std::vector<int16_t> out;
+        int16_t chunk[1000 * 2];
+        while (out.size() / 2 < maxFrames && !ae::audio::isStreamEnded(stream)) {
+            uint32_t count = std::min(1000u, maxFrames - uint32_t(out.size() / 2));
+            uint32_t read = ae::audio::readStream(stream, chunk, count);
+            if (!read) std::this_thread::yield();
+            out.insert(out.end(), chunk, chunk + read * 2);
+        }
+        return out;
+    };
+
+    SECTION( "a resampled stream matches loadWav" ) {
+        // long enough for the ring of buffers to wrap around a few times.
+        const uint32_t frameCount = 48000 * 2 + 777;
+        std::vector<int16_t> samples(frameCount * 2);
+        for (uint32_t i = 0; i < frameCount * 2; i++) samples[i] = int16_t(lrint(12000.0 * sin(i * 0.013)));
+        REQUIRE( utils::WriteWav(path, 1, 2, 48000, 16, samples.data(), frameCount * 4) );
+
+        ae::loaded_wav_t wav = ae::io::loadWav(path);
+        ae::audio::audio_stream_t *stream = ae::audio::openStream(path);
+        REQUIRE( stream );
+        REQUIRE( ae::audio::getStreamLength(stream) == uint64_t(wav.sampleCount) );
+        std::vector<int16_t> streamed = readAll(stream, UINT32_MAX);
+        REQUIRE( streamed.size() == size_t(wav.sampleCount) * 2 );
+        REQUIRE( memcmp(streamed.data(), wav.sampleData, streamed.size() * sizeof(int16_t)) == 0 );
+        int16_t frame[2];
+        REQUIRE( ae::audio::readStream(stream, frame, 1) == 0 );
+        ae::audio::closeStream(stream);
+        ae::io::freeWav(wav);
+    }
+
+    SECTION( "looping and seeking" ) {
+        // NOTE: the file is at the mix rate, so the stream is the file samples exactly.
+        const uint32_t frameCount = 10000;
+        std::vector<int16_t> samples(frameCount);
+        for (uint32_t i = 0; i < frameCount; i++) samples[i] = int16_t(i * 3 - 15000);
+        REQUIRE( utils::WriteWav(path, 1, 1, 44100, 16, samples.data(), frameCount * 2) );
+
+        // the whole file is shorter than a buffer, so it wraps around within a buffer.
+        ae::audio::audio_stream_t *stream = ae::audio::openStream(path, true);
+        REQUIRE( stream );
+        std::vector<int16_t> looped = readAll(stream, frameCount * 3 + 500);
+        REQUIRE( looped.size() == (frameCount * 3 + 500) * 2 );
+        for (uint32_t i = 0; i < frameCount * 3 + 500; i++) {
+            REQUIRE( looped[i * 2] == samples[i % frameCount] );
+            REQUIRE( looped[i * 2 + 1] == samples[i % frameCount] );
+        }
+
+        ae::audio::seekStream(stream, 2500);
+        std::vector<int16_t> seeked = readAll(stream, 1000);
+        REQUIRE( seeked.size() == 2000 );
+        for (uint32_t i = 0; i < 1000; i++) REQUIRE( seeked[i * 2] == samples[2500 + i] );
+        ae::audio::closeStream(stream);
+
+        // without a loop, a seek after the end plays the rest of the file again.
+        stream = ae::audio::openStream(path);
+        REQUIRE( readAll(stream, UINT32_MAX).size() == frameCount * 2 );
+        REQUIRE( ae::audio::isStreamEnded(stream) );
+        ae::audio::seekStream(stream, frameCount - 100);
+        REQUIRE( !ae::audio::isStreamEnded(stream) );
+        std::vector<int16_t> tail = readAll(stream, UINT32_MAX);
+        REQUIRE( tail.size() == 200 );
+        REQUIRE( tail[0] == samples[frameCount - 100] );
+        ae::audio::closeStream(stream);
+    }
+
+    SECTION( "voices pull from the stream" ) {
+        static ae::PFN_voiceFillCallback s_fill;
+        static void *s_user;
+        ae::EM->pfn.voiceSubmitCallback = [](intptr_t voiceHandle, ae::PFN_voiceFillCallback fill, void *user) {
+            s_fill = fill;
+            s_user = user;
+            return true;
+        };
+        const uint32_t frameCount = 5000;
+        std::vector<int16_t> samples(frameCount * 2, 1000);
+        REQUIRE( utils::WriteWav(path, 1, 2, 44100, 16, samples.data(), frameCount * 4) );
+        ae::audio::audio_stream_t *stream = ae::audio::openStream(path);
+        REQUIRE( ae::audio::voiceSubmitStream(0, stream) );
+
+        // the first buffer is decoded by openStream.
+        std::vector<int16_t> buffer(4096 * 2);
+        REQUIRE( s_fill(s_user, buffer.data(), 4096) == 4096 );
+        REQUIRE( buffer[0] == 1000 );
+        REQUIRE( buffer[4095 * 2 + 1] == 1000 );
+        // the voice is always given a full buffer until the stream ends, after which it is given less.
+        uint32_t filled;
+        while ((filled = s_fill(s_user, buffer.data(), 4096)) == 4096) {}
+        REQUIRE( filled < 4096 );
+        REQUIRE( s_fill(s_user, buffer.data(), 4096) == 0 );
+        ae::audio::closeStream(stream);
+        ae::EM->pfn.voiceSubmitCallback = nullptr;
+    }
+
+    SECTION( "missing and malformed files fail to open" ) {
+        REQUIRE( ae::audio::openStream("ae_test_missing.wav") == nullptr );
+        uint8_t sample = 0;
+        REQUIRE( utils::WriteWav(path, 2, 1, 44100, 4, &sample, 1) );
+        REQUIRE( ae::audio::openStream(path) == nullptr );
+    }
+
+    ae::jobs::shutdown();
+    remove(path);
+}
+
+TEST_CASE( "mixer", "[ae::audio]" ) {
+    utils::SetupTestEngineContext();
+
+    // a wav in memory. each frame is the same on both channels unless right is given.
+    auto makeWav = [](std::vector<int16_t> &data, uint32_t frameCount, std::function<int16_t(uint32_t)> left,
+        std::function<int16_t(uint32_t)> right = nullptr) {
+        data.resize(size_t(frameCount) * 2);
+        for (uint32_t i = 0; i < frameCount; i++) {
+            data[i * 2] = left(i);
+            data[i * 2 + 1] = right ? right(i) : left(i);
+        }
+        ae::loaded_wav_t wav = {};
+        wav.sampleCount = int(frameCount);
+        wav.channels = 2;
+        wav.sampleData = data.data();
+        wav.encoding = ae::io::WAV_ENCODING_PCM16;
+        return wav;
+    };
+    auto render = [](ae::audio::mixer_t *mixer, uint32_t frameCount) {
+        std::vector<float> out(size_t(frameCount) * 2);
+        ae::audio::mixerRender(mixer, out.data(), frameCount);
+        return out;
+    };
+
+    ae::audio::mixer_desc_t desc = {};
+    desc.maxVoices = 8;
+    desc.maxRealVoices = 8;
+
+    SECTION( "a voice at unity plays its sound as is, then ends" ) {
+        ae::audio::mixer_t *mixer = ae::audio::createMixer(desc);
+        std::vector<int16_t> data;
+        ae::loaded_wav_t wav = makeWav(data, 600, [](uint32_t i) { return int16_t(i * 37); },
+            [](uint32_t i) { return int16_t(-int(i) * 29); });
+        ae::audio::mixer_voice_t voice = ae::audio::mixerPlay(mixer, wav, {});
+        REQUIRE( voice.generation != 0 );
+        REQUIRE( ae::audio::mixerIsPlaying(mixer, voice) );
+
+        std::vector<float> out = render(mixer, 1000);
+        for (uint32_t i = 0; i < 1000; i++) {
+            float left = (i < 600) ? data[i * 2] / 32768.f : 0.f;
+            float right = (i < 600) ? data[i * 2 + 1] / 32768.f : 0.f;
+            REQUIRE( out[i * 2] == Approx(left).margin(1e-6) );
+            REQUIRE( out[i * 2 + 1] == Approx(right).margin(1e-6) );
+        }
+        REQUIRE( !ae::audio::mixerIsPlaying(mixer, voice) );
+        REQUIRE( ae::audio::getMixerStats(mixer).playingVoices == 0 );
+        ae::audio::destroyMixer(mixer);
+    }
+
+    SECTION( "pan is equal power" ) {
+        ae::audio::mixer_t *mixer = ae::audio::createMixer(desc);
+        std::vector<int16_t> data;
+        ae::loaded_wav_t wav = makeWav(data, 1000, [](uint32_t i) { return int16_t(8000); });
+        ae::audio::mixer_voice_params_t params = {};
+        for (float pan : { -1.f, -0.5f, 0.f, 0.25f, 1.f }) {
+            params.pan = pan;
+            ae::audio::mixer_voice_t voice = ae::audio::mixerPlay(mixer, wav, params);
+            std::vector<float> out = render(mixer, 100);
+            float left = out[50 * 2] / (8000.f / 32768.f);
+            float right = out[50 * 2 + 1] / (8000.f / 32768.f);
+            REQUIRE( left * left + right * right == Approx(2.f) );
+            if (pan == -1.f) REQUIRE( right == Approx(0.f).margin(1e-6) );
+            if (pan == 0.f) REQUIRE( left == Approx(1.f) );
+            if (pan == 0.f) REQUIRE( right == Approx(1.f) );
+            if (pan == 1.f) REQUIRE( left == Approx(0.f).margin(1e-6) );
+            ae::audio::mixerStop(mixer, voice);
+            render(mixer, ae::audio::MIXER_BLOCK_FRAMES);
+        }
+        ae::audio::destroyMixer(mixer);
+    }
+
+    SECTION( "gain changes ramp across a block" ) {
+        ae::audio::mixer_t *mixer = ae::audio::createMixer(desc);
+        std::vector<int16_t> data;
+        ae::loaded_wav_t wav = makeWav(data, 4096, [](uint32_t i) { return int16_t(16384); });
+        ae::audio::mixer_voice_t voice = ae::audio::mixerPlay(mixer, wav, {});
+        render(mixer, ae::audio::MIXER_BLOCK_FRAMES);
+
+        ae::audio::mixer_voice_params_t params = {};
+        params.gain = 0.f;
+        ae::audio::mixerSetParams(mixer, voice, params);
+        std::vector<float> out = render(mixer, ae::audio::MIXER_BLOCK_FRAMES * 2);
+        for (uint32_t i = 0; i < ae::audio::MIXER_BLOCK_FRAMES; i++) {
+            float expected = 0.5f * (1.f - float(i) / ae::audio::MIXER_BLOCK_FRAMES);
+            REQUIRE( out[i * 2] == Approx(expected).margin(1e-5) );
+        }
+        for (uint32_t i = ae::audio::MIXER_BLOCK_FRAMES; i < ae::audio::MIXER_BLOCK_FRAMES * 2; i++) {
+            REQUIRE( out[i * 2] == 0.f );
+        }
+        // a silent voice is virtual but keeps playing.
+        REQUIRE( ae::audio::mixerIsPlaying(mixer, voice) );
+        REQUIRE( ae::audio::getMixerStats(mixer).virtualVoices == 1 );
+        ae::audio::destroyMixer(mixer);
+    }
+
+    SECTION( "pitch resamples the sound" ) {
+        std::vector<int16_t> data;
+        ae::loaded_wav_t wav = makeWav(data, 4000, [](uint32_t i) { return int16_t(i * 8); });
+        for (float pitch : { 2.f, 0.5f, 1.3f }) {
+            ae::audio::mixer_t *mixer = ae::audio::createMixer(desc);
+            ae::audio::mixer_voice_params_t params = {};
+            params.pitch = pitch;
+            ae::audio::mixerPlay(mixer, wav, params);
+            std::vector<float> out = render(mixer, 1500);
+            for (uint32_t i = 0; i < 1500; i++) {
+                float position = float(i) * pitch;
+                float expected = (position < 3999.f) ? position * 8.f / 32768.f : 0.f;
+                if (position >= 3999.f) break;
+                REQUIRE( out[i * 2] == Approx(expected).margin(1e-4) );
+                REQUIRE( out[i * 2 + 1] == Approx(expected).margin(1e-4) );
+            }
+            ae::audio::destroyMixer(mixer);
+        }
+    }
+
+    SECTION( "looping, stopping and stale handles" ) {
+        ae::audio::mixer_t *mixer = ae::audio::createMixer(desc);
+        std::vector<int16_t> data;
+        ae::loaded_wav_t wav = makeWav(data, 100, [](uint32_t i) { return int16_t(i * 100 - 5000); });
+        ae::audio::mixer_voice_t voice = ae::audio::mixerPlay(mixer, wav, {}, true);
+        std::vector<float> out = render(mixer, 1000);
+        for (uint32_t i = 0; i < 1000; i++) {
+            REQUIRE( out[i * 2] == Approx(data[(i % 100) * 2] / 32768.f).margin(1e-6) );
+        }
+
+        // the voice fades out over the next block, then is free.
+        ae::audio::mixerStop(mixer, voice);
+        REQUIRE( ae::audio::mixerIsPlaying(mixer, voice) );
+        out = render(mixer, ae::audio::MIXER_BLOCK_FRAMES);
+        REQUIRE( out[(ae::audio::MIXER_BLOCK_FRAMES - 1) * 2] == Approx(0.f).margin(0.01f) );
+        REQUIRE( !ae::audio::mixerIsPlaying(mixer, voice) );
+
+        // the voice is reused for the next sound, under a new generation.
+        ae::audio::mixer_voice_t next = ae::audio::mixerPlay(mixer, wav, {}, true);
+        REQUIRE( next.index == voice.index );
+        REQUIRE( next.generation != voice.generation );
+        REQUIRE( !ae::audio::mixerIsPlaying(mixer, voice) );
+        ae::audio::mixerStop(mixer, voice);
+        ae::audio::mixer_voice_params_t params = {};
+        params.gain = 0.f;
+        ae::audio::mixerSetParams(mixer, voice, params);
+        out = render(mixer, ae::audio::MIXER_BLOCK_FRAMES * 2);
+        REQUIRE( ae::audio::mixerIsPlaying(mixer, next) );
+        REQUIRE( out[300 * 2] == Approx(data[0] / 32768.f).margin(1e-6) );
+        ae::audio::destroyMixer(mixer);
+    }
+
+    SECTION( "the pool runs out" ) {
+        desc.maxVoices = 4;
+        ae::audio::mixer_t *mixer = ae::audio::createMixer(desc);
+        std::vector<int16_t> data;
+        ae::loaded_wav_t wav = makeWav(data, 300, [](uint32_t i) { return int16_t(100); });
+        for (uint32_t i = 0; i < 4; i++) REQUIRE( ae::audio::mixerPlay(mixer, wav, {}).generation != 0 );
+        REQUIRE( ae::audio::mixerPlay(mixer, wav, {}).generation == 0 );
+        ae::loaded_wav_t empty = {};
+        REQUIRE( ae::audio::mixerPlay(mixer, empty, {}).generation == 0 );
+        // once the sounds end, their voices are free again.
+        render(mixer, 300);
+        REQUIRE( ae::audio::mixerPlay(mixer, wav, {}).generation != 0 );
+        ae::audio::destroyMixer(mixer);
+    }
+
+    SECTION( "quiet voices are virtual and keep their place" ) {
+        desc.maxRealVoices = 2;
+        ae::audio::mixer_t *mixer = ae::audio::createMixer(desc);
+        std::vector<int16_t> dc, ramp;
+        ae::loaded_wav_t dcWav = makeWav(dc, 8192, [](uint32_t i) { return int16_t(1024); });
+        ae::loaded_wav_t rampWav = makeWav(ramp, 8192, [](uint32_t i) { return int16_t(i); });
+
+        ae::audio::mixer_voice_params_t params = {};
+        params.gain = 1.f;
+        ae::audio::mixerPlay(mixer, dcWav, params);
+        params.gain = 0.5f;
+        ae::audio::mixerPlay(mixer, dcWav, params);
+        params.gain = 0.25f;
+        ae::audio::mixer_voice_t ramped = ae::audio::mixerPlay(mixer, rampWav, params);
+        params.gain = 0.0001f;
+        ae::audio::mixerPlay(mixer, dcWav, params);
+
+        std::vector<float> out = render(mixer, ae::audio::MIXER_BLOCK_FRAMES);
+        ae::audio::mixer_stats_t stats = ae::audio::getMixerStats(mixer);
+        REQUIRE( stats.playingVoices == 4 );
+        REQUIRE( stats.realVoices == 2 );
+        REQUIRE( stats.virtualVoices == 2 );
+        REQUIRE( out[100 * 2] == Approx(1.5f * 1024.f / 32768.f) );
+
+        // the ramp becomes the loudest voice. it comes in where it would have been had it been mixed all along.
+        params.gain = 2.f;
+        ae::audio::mixerSetParams(mixer, ramped, params);
+        render(mixer, ae::audio::MIXER_BLOCK_FRAMES);
+        out = render(mixer, ae::audio::MIXER_BLOCK_FRAMES);
+        for (uint32_t i = 0; i < ae::audio::MIXER_BLOCK_FRAMES; i++) {
+            float expected = (1024.f + 2.f * float(ae::audio::MIXER_BLOCK_FRAMES * 2 + i)) / 32768.f;
+            REQUIRE( out[i * 2] == Approx(expected).margin(1e-5) );
+        }
+
+        // below the threshold a voice is virtual even with real voices to spare.
+        desc.maxRealVoices = 8;
+        ae::audio::mixer_t *roomy = ae::audio::createMixer(desc);
+        params.gain = 0.0001f;
+        ae::audio::mixerPlay(roomy, dcWav, params);
+        render(roomy, 10);
+        REQUIRE( ae::audio::getMixerStats(roomy).virtualVoices == 1 );
+        ae::audio::destroyMixer(roomy);
+        ae::audio::destroyMixer(mixer);
+    }
+
+    SECTION( "the game thread and the audio thread do not wait on each other" ) {
+        desc.maxVoices = 64;
+        desc.maxRealVoices = 16;
+        desc.commandCapacity = 64;
+        ae::audio::mixer_t *mixer = ae::audio::createMixer(desc);
+        std::vector<int16_t> data;
+        ae::loaded_wav_t wav = makeWav(data, 2000, [](uint32_t i) { return int16_t(i); });
+
+        std::atomic<bool> bDone = false;
+        std::thread audioThread([mixer, &bDone] {
+            std::vector<float> out(441 * 2);
+            while (!bDone.load()) ae::audio::mixerRender(mixer, out.data(), 441);
+        });
+        utils::Seed(__LINE__);
+        std::vector<ae::audio::mixer_voice_t> voices;
+        for (uint32_t i = 0; i < 20000; i++) {
+            uint32_t what = utils::RandomUINT32(0, 3);
+            if (what == 0 || voices.empty()) {
+                ae::audio::mixer_voice_params_t params = {};
+                params.gain = utils::RandomFloat(0.f, 1.f);
+                params.pitch = utils::RandomFloat(0.5f, 1.5f);
+                ae::audio::mixer_voice_t voice = ae::audio::mixerPlay(mixer, wav, params, what == 0);
+                if (voice.generation) voices.push_back(voice);
+            } else {
+                ae::audio::mixer_voice_t voice = voices[utils::RandomUINT32(0, uint32_t(voices.size() - 1))];
+                if (what == 1) ae::audio::mixerStop(mixer, voice);
+                else if (what == 2) ae::audio::mixerSetParams(mixer, voice, {});
+                else ae::audio::mixerIsPlaying(mixer, voice);
+            }
+            if (voices.size() > 256) voices.erase(voices.begin(), voices.begin() + 128);
+        }
+        bDone = true;
+        audioThread.join();
+        ae::audio::mixer_stats_t stats = ae::audio::getMixerStats(mixer);
+        REQUIRE( stats.realVoices <= desc.maxRealVoices );
+        REQUIRE( stats.realVoices + stats.virtualVoices == stats.playingVoices );
+        ae::audio::destroyMixer(mixer);
+    }
+
+    SECTION( "a platform voice plays the mixer" ) {
+        static ae::PFN_voiceFillCallback s_fill;
+        static void *s_user;
+        ae::EM->pfn.voiceSubmitCallback = [](intptr_t voiceHandle, ae::PFN_voiceFillCallback fill, void *user) {
+            s_fill = fill;
+            s_user = user;
+            return true;
+        };
+        ae::audio::mixer_t *mixer = ae::audio::createMixer(desc);
+        std::vector<int16_t> data;
+        ae::loaded_wav_t wav = makeWav(data, 700, [](uint32_t i) { return int16_t(i * 97 - 30000); });
+        REQUIRE( ae::audio::voiceSubmitMixer(0, mixer) );
+        ae::audio::mixerPlay(mixer, wav, {});
+        // two loud voices clip rather than wrap around.
+        ae::audio::mixerPlay(mixer, wav, {});
+        int16_t buffer[1000 * 2];
+        REQUIRE( s_fill(s_user, buffer, 1000) == 1000 );
+        for (uint32_t i = 0; i < 1000; i++) {
+            int expected = (i < 700) ? std::max(-32768, std::min(data[i * 2] * 2, 32767)) : 0;
+            REQUIRE( buffer[i * 2] == expected );
+        }
+        ae::audio::destroyMixer(mixer);
+        ae::EM->pfn.voiceSubmitCallback = nullptr;
+    }
+}
+
+TEST_CASE( "software audio devices", "[ae::audio]" ) {
+    utils::SetupTestEngineContext();
+    const char *path = "ae_test_device.wav";
+
+    // the game's callbacks. the process callback halves the voice in place, as an effect would.
+    struct callbacks_t {
+        std::vector<std::pair<intptr_t, uint32_t>> buffers;
+        std::vector<intptr_t> ended;
+        ae::loaded_wav_t resubmit;
+    };
+    static callbacks_t s_callbacks;
+    s_callbacks = {};
+    ae::audio::audio_device_desc_t desc = {};
+    desc.onVoiceBufferProcess = [](ae::game_memory_t *gameMemory, intptr_t voiceHandle, float *dst, float *src,
+        uint32_t samplesToWrite, int channels, int bytesPerSample) {
+        REQUIRE( dst == src );
+        REQUIRE( channels == 2 );
+        REQUIRE( bytesPerSample == 4 );
+        for (uint32_t i = 0; i < samplesToWrite * 2; i++) dst[i] = src[i] * 0.5f;
+        s_callbacks.buffers.push_back({ voiceHandle, samplesToWrite });
+    };
+    desc.onVoiceBufferEnd = [](ae::game_memory_t *gameMemory, intptr_t voiceHandle) {
+        s_callbacks.ended.push_back(voiceHandle);
+        // the end callback is allowed to give the voice its next sound.
+        if (s_callbacks.resubmit.sampleData) {
+            REQUIRE( ae::EM->pfn.voiceSubmitBuffer(voiceHandle, s_callbacks.resubmit) );
+            ae::EM->pfn.voicePlayBuffer(voiceHandle);
+            s_callbacks.resubmit = {};
+        }
+    };
+
+    std::vector<int16_t> samples(1000 * 2);
+    for (uint32_t i = 0; i < 1000; i++) {
+        samples[i * 2] = int16_t(i * 31 - 15000);
+        samples[i * 2 + 1] = int16_t(12000 - int(i) * 17);
+    }
+    ae::loaded_wav_t wav = {};
+    wav.sampleCount = 1000;
+    wav.channels = 2;
+    wav.sampleData = samples.data();
+
+    SECTION( "the null device calls the game like the platform device" ) {
+        ae::audio::audio_device_t *device = ae::audio::createNullDevice(desc);
+        ae::audio::installDevice(device);
+        intptr_t first = ae::EM->pfn.createVoice();
+        intptr_t second = ae::EM->pfn.createVoice();
+        REQUIRE( first != second );
+        REQUIRE( ae::EM->pfn.voiceSubmitBuffer(first, wav) );
+        REQUIRE( ae::EM->pfn.voiceSubmitBuffer(second, wav) );
+        REQUIRE( !ae::EM->pfn.voiceSubmitBuffer(second + 1, wav) );
+        // only the voice that is playing is pulled from.
+        ae::EM->pfn.voicePlayBuffer(first);
+        ae::audio::advanceDevice(device, 1500);
+        REQUIRE( ae::audio::getDeviceClock(device) == 1500 );
+        std::vector<std::pair<intptr_t, uint32_t>> buffers = { { first, 441 }, { first, 441 }, { first, 118 } };
+        REQUIRE( s_callbacks.buffers == buffers );
+        REQUIRE( s_callbacks.ended == std::vector<intptr_t>{ first } );
+
+        // a new sound stops the voice until it is played again.
+        s_callbacks = {};
+        ae::EM->pfn.voicePlayBuffer(second);
+        REQUIRE( ae::EM->pfn.voiceSubmitBuffer(second, wav) );
+        ae::audio::advanceDevice(device, 441);
+        REQUIRE( s_callbacks.buffers.empty() );
+
+        // a sound that runs out right at the end of a pass ends in that pass.
+        ae::loaded_wav_t exact = wav;
+        exact.sampleCount = 882;
+        REQUIRE( ae::EM->pfn.voiceSubmitBuffer(second, exact) );
+        s_callbacks.resubmit = exact;
+        ae::EM->pfn.voicePlayBuffer(second);
+        ae::audio::advanceDevice(device, 882);
+        buffers = { { second, 441 }, { second, 441 } };
+        REQUIRE( s_callbacks.buffers == buffers );
+        REQUIRE( s_callbacks.ended == std::vector<intptr_t>{ second } );
+        ae::audio::advanceDevice(device, 882);
+        REQUIRE( s_callbacks.ended == std::vector<intptr_t>{ second, second } );
+        REQUIRE( s_callbacks.buffers.size() == 4 );
+
+        REQUIRE( ae::audio::destroyDevice(device) );
+        REQUIRE( ae::EM->pfn.createVoice == nullptr );
+    }
+
+    SECTION( "the wav device records the mix bit-exactly" ) {
+        auto record = [&](std::vector<int16_t> *pOut) {
+            ae::audio::audio_device_t *device = ae::audio::createWavDevice(path, desc);
+            ae::audio::installDevice(device);
+            intptr_t buffered = ae::EM->pfn.createVoice();
+            intptr_t looped = ae::EM->pfn.createVoice();
+            REQUIRE( ae::EM->pfn.voiceSubmitBuffer(buffered, wav) );
+            REQUIRE( ae::audio::voiceSubmitWav(looped, wav, true) );
+            ae::EM->pfn.voicePlayBuffer(buffered);
+            ae::EM->pfn.voicePlayBuffer(looped);
+            ae::audio::advanceDevice(device, 2500);
+            REQUIRE( ae::audio::destroyDevice(device) );
+            ae::loaded_wav_t recorded = ae::io::loadWav(path);
+            REQUIRE( recorded.sampleCount == 2500 );
+            pOut->assign(recorded.sampleData, recorded.sampleData + 2500 * 2);
+            ae::io::freeWav(recorded);
+        };
+        std::vector<int16_t> out, again;
+        record(&out);
+        for (uint32_t i = 0; i < 2500; i++) {
+            for (uint32_t c = 0; c < 2; c++) {
+                float looped = samples[(i % 1000) * 2 + c] * 0.5f;
+                float buffered = (i < 1000) ? samples[i * 2 + c] * 0.5f : 0.f;
+                REQUIRE( out[i * 2 + c] == int16_t(lrintf(looped + buffered)) );
+            }
+        }
+        record(&again);
+        REQUIRE( out == again );
+        remove(path);
+    }
+
+    SECTION( "a mixer renders through the device" ) {
+        ae::audio::audio_device_t *device = ae::audio::createWavDevice(path, {});
+        ae::audio::installDevice(device);
+        ae::audio::mixer_t *mixer = ae::audio::createMixer({});
+        intptr_t voice = ae::EM->pfn.createVoice();
+        REQUIRE( ae::audio::voiceSubmitMixer(voice, mixer) );
+        ae::EM->pfn.voicePlayBuffer(voice);
+        ae::audio::mixer_voice_params_t params = {};
+        params.pan = -1.f;
+        ae::audio::mixerPlay(mixer, wav, params);
+        ae::audio::advanceDevice(device, 1200);
+        REQUIRE( ae::audio::destroyDevice(device) );
+        ae::audio::destroyMixer(mixer);
+
+        ae::loaded_wav_t recorded = ae::io::loadWav(path);
+        REQUIRE( recorded.sampleCount == 1200 );
+        for (uint32_t i = 0; i < 1000; i++) {
+            float left = samples[i * 2] * 1.41421356f;
+            REQUIRE( std::abs(recorded.sampleData[i * 2] - std::max(-32768.f, std::min(left, 32767.f))) <= 1.f );
+            REQUIRE( recorded.sampleData[i * 2 + 1] == 0 );
+        }
+        ae::io::freeWav(recorded);
+        remove(path);
+    }
+
+    SECTION( "one device at a time" ) {
+        ae::audio::audio_device_t *device = ae::audio::createNullDevice(desc);
+        ae::audio::audio_device_t *other = ae::audio::createNullDevice(desc);
+        ae::audio::installDevice(device);
+        ae::audio::installDevice(other);
+        ae::EM->pfn.voicePlayBuffer(ae::EM->pfn.createVoice());
+        REQUIRE( ae::audio::destroyDevice(device) );
+        REQUIRE( ae::audio::destroyDevice(other) );
+        REQUIRE( ae::EM->pfn.createVoice == nullptr );
+        ae::audio::audio_device_desc_t bad = {};
+        bad.periodFrames = 0;
+        REQUIRE( ae::audio::createNullDevice(bad) == nullptr );
+    }
+}
+
+TEST_CASE( "voice buffer queues", "[ae::audio]" ) {
+    utils::SetupTestEngineContext();
+    const char *path = "ae_test_queue.wav";
+
+    // a generator that streams a tone through a ring of buffers, refilling each buffer as the voice finishes it.
+    struct generator_t {
+        intptr_t voice;
+        int16_t buffers[4][300 * 2];
+        uint32_t nextFrame;
+        uint32_t endedCount;
+        bool bRefill;
+    };
+    static auto s_toneAt = [](uint32_t frame) { return int16_t(10000.f * sinf(float(frame) * 0.05f)); };
+    static bool (*s_queueNext)(generator_t *generator, uint32_t index);
+    s_queueNext = [](generator_t *generator, uint32_t index) {
+        for (uint32_t i = 0; i < 300; i++) {
+            generator->buffers[index][i * 2] = s_toneAt(generator->nextFrame + i);
+            generator->buffers[index][i * 2 + 1] = int16_t(-s_toneAt(generator->nextFrame + i));
+        }
+        generator->nextFrame += 300;
+        ae::voice_buffer_t buffer = {};
+        buffer.frames = generator->buffers[index];
+        buffer.frameCount = 300;
+        buffer.context = generator;
+        buffer.onEnd = [](void *context, intptr_t voiceHandle) {
+            generator_t *generator = (generator_t *)context;
+            REQUIRE( voiceHandle == generator->voice );
+            uint32_t index = generator->endedCount++ % 4;
+            if (generator->bRefill) s_queueNext(generator, index);
+        };
+        return ae::audio::voiceQueueBuffer(generator->voice, buffer);
+    };
+    static uint32_t s_streamEnds;
+    s_streamEnds = 0;
+    ae::audio::audio_device_desc_t desc = {};
+    desc.onVoiceBufferEnd = [](ae::game_memory_t *gameMemory, intptr_t voiceHandle) { s_streamEnds++; };
+
+    SECTION( "queued buffers play back to back" ) {
+        ae::audio::audio_device_t *device = ae::audio::createWavDevice(path, desc);
+        ae::audio::installDevice(device);
+        generator_t generator = {};
+        generator.voice = ae::EM->pfn.createVoice();
+        generator.bRefill = true;
+        for (uint32_t i = 0; i < 4; i++) REQUIRE( s_queueNext(&generator, i) );
+        ae::voice_state_t state;
+        REQUIRE( ae::EM->pfn.voiceGetState(generator.voice, &state) );
+        REQUIRE( state.buffersQueued == 4 );
+        REQUIRE( state.framesPlayed == 0 );
+
+        ae::EM->pfn.voicePlayBuffer(generator.voice);
+        ae::audio::advanceDevice(device, 5000);
+        REQUIRE( ae::EM->pfn.voiceGetState(generator.voice, &state) );
+        REQUIRE( state.framesPlayed == 5000 );
+        REQUIRE( state.buffersQueued == 4 );
+        REQUIRE( generator.endedCount == 5000 / 300 );
+
+        // once the game stops refilling, the voice plays out what is queued, then starves without ending.
+        generator.bRefill = false;
+        ae::audio::advanceDevice(device, 2000);
+        REQUIRE( ae::EM->pfn.voiceGetState(generator.voice, &state) );
+        REQUIRE( state.buffersQueued == 0 );
+        REQUIRE( state.framesPlayed == generator.nextFrame );
+        REQUIRE( s_streamEnds == 0 );
+        // and picks up again as soon as there is more, without being played again.
+        uint32_t resumeFrame = generator.nextFrame;
+        REQUIRE( s_queueNext(&generator, 0) );
+        ae::audio::advanceDevice(device, 500);
+        REQUIRE( ae::audio::destroyDevice(device) );
+
+        ae::loaded_wav_t recorded = ae::io::loadWav(path);
+        REQUIRE( recorded.sampleCount == 7500 );
+        for (uint32_t i = 0; i < 7500; i++) {
+            int16_t expected = 0;
+            if (i < resumeFrame) expected = s_toneAt(i);
+            else if (i >= 7000 && i < 7300) expected = s_toneAt(resumeFrame + i - 7000);
+            REQUIRE( recorded.sampleData[i * 2] == expected );
+            REQUIRE( recorded.sampleData[i * 2 + 1] == -expected );
+        }
+        ae::io::freeWav(recorded);
+        remove(path);
+    }
+
+    SECTION( "a queue is bounded and replaced by other sounds" ) {
+        ae::audio::audio_device_t *device = ae::audio::createNullDevice(desc);
+        ae::audio::installDevice(device);
+        generator_t generator = {};
+        generator.voice = ae::EM->pfn.createVoice();
+        // the first buffer queued replaces a looping wav.
+        ae::loaded_wav_t loop = {};
+        loop.sampleCount = 300;
+        loop.channels = 2;
+        loop.sampleData = generator.buffers[2];
+        REQUIRE( ae::audio::voiceSubmitWav(generator.voice, loop, true) );
+        for (uint32_t i = 0; i < ae::platform::VOICE_MAX_QUEUED_BUFFERS; i++) REQUIRE( s_queueNext(&generator, 0) );
+        REQUIRE( !s_queueNext(&generator, 0) );
+        ae::voice_buffer_t empty = {};
+        REQUIRE( !ae::EM->pfn.voiceQueueBuffer(generator.voice, empty) );
+
+        // a submit is done with every queued buffer.
+        ae::loaded_wav_t wav = {};
+        wav.sampleCount = 300;
+        wav.channels = 2;
+        wav.sampleData = generator.buffers[1];
+        REQUIRE( ae::EM->pfn.voiceSubmitBuffer(generator.voice, wav) );
+        REQUIRE( generator.endedCount == ae::platform::VOICE_MAX_QUEUED_BUFFERS );
+        ae::voice_state_t state;
+        REQUIRE( ae::EM->pfn.voiceGetState(generator.voice, &state) );
+        REQUIRE( state.buffersQueued == 1 );
+
+        // and a buffer queued after the submit replaces it, which stops the voice.
+        ae::EM->pfn.voicePlayBuffer(generator.voice);
+        REQUIRE( s_queueNext(&generator, 0) );
+        ae::audio::advanceDevice(device, 441);
+        REQUIRE( ae::EM->pfn.voiceGetState(generator.voice, &state) );
+        REQUIRE( state.framesPlayed == 0 );
+        REQUIRE( s_streamEnds == 0 );
+        REQUIRE( ae::audio::destroyDevice(device) );
+    }
+}
+
+TEST_CASE( "scheduled mixer voices", "[ae::audio]" ) {
+    utils::SetupTestEngineContext();
+    // a click: one loud frame, then silence.
+    std::vector<int16_t> click(64 * 2, 0);
+    click[0] = click[1] = 16384;
+    ae::loaded_wav_t wav = {};
+    wav.sampleCount = 64;
+    wav.channels = 2;
+    wav.sampleData = click.data();
+    wav.encoding = ae::io::WAV_ENCODING_PCM16;
+    auto clicksIn = [](const std::vector<float> &out, uint64_t first) {
+        std::vector<uint64_t> frames;
+        for (size_t i = 0; i < out.size() / 2; i++)
+            if (out[i * 2] != 0.f) frames.push_back(first + i);
+        return frames;
+    };
+
+    ae::audio::mixer_desc_t desc = {};
+    desc.maxVoices = 16;
+    desc.maxRealVoices = 16;
+    ae::audio::mixer_t *mixer = ae::audio::createMixer(desc);
+    std::vector<float> out(2048 * 2);
+
+    SECTION( "voices start on their frame, within any block" ) {
+        // on the first frame of a block, within a block, on the last frame of a block, one frame apart, and
+        // several renders ahead.
+        std::vector<uint64_t> starts = { 0, 300, 511, 767, 768, 1000, 1001, 3000 };
+        for (uint64_t start : starts) REQUIRE( ae::audio::mixerPlayAt(mixer, wav, {}, start).generation );
+        std::vector<uint64_t> clicks;
+        // renders that are not a multiple of the block size.
+        for (uint64_t first = 0; first < 4000;) {
+            uint32_t count = (first < 1000) ? 1000 : 1500;
+            std::vector<float> render(count * 2);
+            ae::audio::mixerRender(mixer, render.data(), count);
+            for (uint64_t frame : clicksIn(render, first)) clicks.push_back(frame);
+            REQUIRE( ae::audio::getMixerClock(mixer).frame == first );
+            first += count;
+        }
+        REQUIRE( clicks == starts );
+        REQUIRE( ae::audio::getMixerStats(mixer).lateStarts == 0 );
+        REQUIRE( ae::audio::getMixerStats(mixer).playingVoices == 0 );
+    }
+
+    SECTION( "a voice waits as a virtual voice" ) {
+        ae::audio::mixer_voice_t voice = ae::audio::mixerPlayAt(mixer, wav, {}, 5000, true);
+        ae::audio::mixerRender(mixer, out.data(), 2048);
+        REQUIRE( ae::audio::mixerIsPlaying(mixer, voice) );
+        ae::audio::mixer_stats_t stats = ae::audio::getMixerStats(mixer);
+        REQUIRE( stats.playingVoices == 1 );
+        REQUIRE( stats.realVoices == 0 );
+        REQUIRE( stats.virtualVoices == 1 );
+        REQUIRE( clicksIn(out, 0).empty() );
+
+        // one that is stopped before its start is never heard.
+        ae::audio::mixerStop(mixer, voice);
+        ae::audio::mixerRender(mixer, out.data(), 2048);
+        ae::audio::mixerRender(mixer, out.data(), 2048);
+        REQUIRE( clicksIn(out, 4096).empty() );
+        REQUIRE( !ae::audio::mixerIsPlaying(mixer, voice) );
+    }
+
+    SECTION( "a start that is already rendered plays at once" ) {
+        ae::audio::mixerRender(mixer, out.data(), 1000);
+        ae::audio::mixerPlayAt(mixer, wav, {}, 10);
+        ae::audio::mixerRender(mixer, out.data(), 1000);
+        REQUIRE( clicksIn(out, 1000) == std::vector<uint64_t>{ 1000 } );
+        REQUIRE( ae::audio::getMixerStats(mixer).lateStarts == 1 );
+        // as does mixerPlay, which is not late.
+        ae::audio::mixerPlay(mixer, wav, {});
+        ae::audio::mixerRender(mixer, out.data(), 1000);
+        REQUIRE( clicksIn(out, 2000) == std::vector<uint64_t>{ 2000 } );
+        REQUIRE( ae::audio::getMixerStats(mixer).lateStarts == 1 );
+    }
+
+    SECTION( "the clock follows the wall clock" ) {
+        static uint64_t s_now;
+        ae::EM->pfn.wallClock = []() { return s_now; };
+        ae::EM->pfn.getTimerFrequency = []() { return uint64_t(1000000); };
+        // no render yet.
+        REQUIRE( ae::audio::getMixerClock(mixer).wallClock == 0 );
+        REQUIRE( ae::audio::getMixerFrameAt(mixer, 123456) == 0 );
+
+        s_now = 5000000;
+        ae::audio::mixerRender(mixer, out.data(), 441);
+        s_now = 5010000;
+        ae::audio::mixerRender(mixer, out.data(), 441);
+        ae::audio::mixer_clock_t clock = ae::audio::getMixerClock(mixer);
+        REQUIRE( clock.frame == 441 );
+        REQUIRE( clock.wallClock == 5010000 );
+        // 10 ms is 441 frames.
+        REQUIRE( ae::audio::getMixerFrameAt(mixer, 5020000) == 882 );
+        REQUIRE( ae::audio::getMixerFrameAt(mixer, 5005000) == 441 - 221 );
+        REQUIRE( ae::audio::getMixerFrameAt(mixer, 0) == 0 );
+
+        // a voice scheduled from the wall clock, a render ahead, starts on that frame.
+        uint64_t start = ae::audio::getMixerFrameAt(mixer, 5013000 + 10000);
+        REQUIRE( start == 1014 );
+        ae::audio::mixerPlayAt(mixer, wav, {}, start);
+        s_now = 5020000;
+        std::vector<float> render(441 * 2);
+        ae::audio::mixerRender(mixer, render.data(), 441);
+        REQUIRE( clicksIn(render, 882) == std::vector<uint64_t>{ start } );
+        REQUIRE( ae::audio::getMixerStats(mixer).lateStarts == 0 );
+        ae::EM->pfn.wallClock = nullptr;
+        ae::EM->pfn.getTimerFrequency = nullptr;
+    }
+
+    SECTION( "a device render stamps the clock once" ) {
+        ae::audio::audio_device_desc_t deviceDesc = {};
+        ae::audio::audio_device_t *device = ae::audio::createNullDevice(deviceDesc);
+        ae::audio::installDevice(device);
+        intptr_t voiceHandle = ae::EM->pfn.createVoice();
+        REQUIRE( ae::audio::voiceSubmitMixer(voiceHandle, mixer) );
+        ae::EM->pfn.voicePlayBuffer(voiceHandle);
+        // a pass of 441 frames is two blocks, but the clock is the start of the pass.
+        ae::audio::advanceDevice(device, 882);
+        REQUIRE( ae::audio::getMixerClock(mixer).frame == 441 );
+        REQUIRE( ae::audio::destroyDevice(device) );
+    }
+
+    ae::audio::destroyMixer(mixer);
+}
+
+TEST_CASE( "spatializer", "[ae::audio]" ) {
+    utils::SetupTestEngineContext();
+
+    ae::audio::mixer_desc_t mixerDesc = {};
+    mixerDesc.maxVoices = 64;
+    mixerDesc.maxRealVoices = 64;
+    ae::audio::mixer_t *mixer = ae::audio::createMixer(mixerDesc);
+    std::vector<int16_t> data(1000 * 2, int16_t(8000));
+    ae::loaded_wav_t wav = {};
+    wav.sampleCount = 1000;
+    wav.channels = 2;
+    wav.sampleData = data.data();
+    wav.encoding = ae::io::WAV_ENCODING_PCM16;
+
+    ae::audio::spatializer_desc_t desc = {};
+    desc.maxEmitters = 32;
+    ae::audio::spatializer_t *spatializer = ae::audio::createSpatializer(mixer, desc);
+    REQUIRE( spatializer );
+
+    ae::audio::listener_t listener = {};
+    listener.right = ae::math::vec3_t(1.f, 0.f, 0.f);
+
+    // a scalar version of the math in updateSpatializer.
+    auto reference = [&desc](const ae::audio::listener_t &listener, const ae::audio::emitter_desc_t &emitter,
+                         ae::math::vec3_t pos, ae::math::vec3_t velocity) {
+        ae::math::vec3_t d = pos - listener.pos;
+        float dist = sqrtf(d.x * d.x + d.y * d.y + d.z * d.z);
+        float beyond = std::min(std::max(dist, emitter.minDistance), emitter.maxDistance) - emitter.minDistance;
+        float gain = (emitter.attenuation == ae::audio::ATTENUATION_LINEAR)
+                         ? std::max(0.f, 1.f - emitter.rolloff * beyond / (emitter.maxDistance - emitter.minDistance))
+                         : emitter.minDistance / (emitter.minDistance + emitter.rolloff * beyond);
+        float dirX = d.x / dist, dirY = d.y / dist, dirZ = d.z / dist;
+        float pan = dirX * listener.right.x + dirY * listener.right.y + dirZ * listener.right.z;
+        float c = desc.speedOfSound;
+        float listenerSpeed =
+            desc.dopplerFactor * (dirX * listener.velocity.x + dirY * listener.velocity.y + dirZ * listener.velocity.z);
+        float emitterSpeed = -desc.dopplerFactor * (dirX * velocity.x + dirY * velocity.y + dirZ * velocity.z);
+        float ratio = (c + std::min(listenerSpeed, c)) / (c - std::min(emitterSpeed, 0.999f * c));
+        ae::audio::mixer_voice_params_t params = {};
+        params.gain = gain * emitter.params.gain;
+        params.pan = std::min(std::max(pan, -1.f), 1.f);
+        params.pitch = std::min(std::max(ratio, 0.f) * emitter.params.pitch, ae::audio::MIXER_MAX_PITCH);
+        return params;
+    };
+
+    SECTION( "emitters match the scalar math" ) {
+        utils::Seed(__LINE__);
+        auto randomVec3 = [](float range) {
+            return ae::math::vec3_t(utils::RandomFloat(-range, range), utils::RandomFloat(-range, range),
+                utils::RandomFloat(-range, range));
+        };
+        listener.pos = randomVec3(10.f);
+        listener.velocity = randomVec3(20.f);
+        // 29 emitters, so that the last group of four is partly padding.
+        std::vector<ae::audio::emitter_desc_t> emitters(29);
+        std::vector<uint32_t> ids;
+        std::vector<ae::math::vec3_t> positions, velocities;
+        for (ae::audio::emitter_desc_t &emitter : emitters) {
+            emitter.params.gain = utils::RandomFloat(0.1f, 1.f);
+            emitter.params.pitch = utils::RandomFloat(0.5f, 2.f);
+            emitter.attenuation = utils::RandomUINT32(0, 1) ? ae::audio::ATTENUATION_LINEAR
+                                                            : ae::audio::ATTENUATION_INVERSE;
+            emitter.minDistance = utils::RandomFloat(0.5f, 5.f);
+            emitter.maxDistance = emitter.minDistance + utils::RandomFloat(1.f, 50.f);
+            emitter.rolloff = utils::RandomFloat(0.f, 2.f);
+            ae::audio::mixer_voice_t voice = ae::audio::mixerPlay(mixer, wav, emitter.params, true);
+            ids.push_back(ae::audio::addEmitter(spatializer, voice, emitter));
+            REQUIRE( ids.back() != ae::audio::INVALID_EMITTER );
+            positions.push_back(randomVec3(40.f));
+            velocities.push_back(randomVec3(100.f));
+            ae::audio::setEmitterTransform(spatializer, ids.back(), positions.back(), velocities.back());
+        }
+        ae::audio::updateSpatializer(spatializer, listener);
+        for (size_t i = 0; i < emitters.size(); i++) {
+            ae::audio::mixer_voice_params_t expected = reference(listener, emitters[i], positions[i], velocities[i]);
+            ae::audio::mixer_voice_params_t params = ae::audio::getEmitterParams(spatializer, ids[i]);
+            REQUIRE( params.gain == Approx(expected.gain).margin(1e-5) );
+            REQUIRE( params.pan == Approx(expected.pan).margin(1e-5) );
+            REQUIRE( params.pitch == Approx(expected.pitch).margin(1e-5) );
+        }
+
+        // removing emitters moves others in the arrays, which must keep their own state.
+        for (size_t i = 0; i < emitters.size(); i += 3) ae::audio::removeEmitter(spatializer, ids[i]);
+        ae::audio::updateSpatializer(spatializer, listener);
+        for (size_t i = 0; i < emitters.size(); i++) {
+            ae::audio::mixer_voice_params_t params = ae::audio::getEmitterParams(spatializer, ids[i]);
+            if (i % 3 == 0) {
+                // removed emitters read as the default parameters.
+                REQUIRE( params.gain == 1.f );
+                REQUIRE( params.pitch == 1.f );
+                continue;
+            }
+            ae::audio::mixer_voice_params_t expected = reference(listener, emitters[i], positions[i], velocities[i]);
+            REQUIRE( params.gain == Approx(expected.gain).margin(1e-5) );
+            REQUIRE( params.pan == Approx(expected.pan).margin(1e-5) );
+            REQUIRE( params.pitch == Approx(expected.pitch).margin(1e-5) );
+        }
+    }
+
+    SECTION( "attenuation curves" ) {
+        ae::audio::emitter_desc_t emitter = {};
+        emitter.minDistance = 2.f;
+        emitter.maxDistance = 10.f;
+        uint32_t inverse = ae::audio::addEmitter(spatializer, {}, emitter);
+        emitter.attenuation = ae::audio::ATTENUATION_LINEAR;
+        uint32_t linear = ae::audio::addEmitter(spatializer, {}, emitter);
+        struct {
+            float distance, inverse, linear;
+        } cases[] = { { 0.5f, 1.f, 1.f }, { 2.f, 1.f, 1.f }, { 4.f, 0.5f, 0.75f }, { 10.f, 0.2f, 0.f },
+            { 50.f, 0.2f, 0.f } };
+        for (auto c : cases) {
+            ae::audio::setEmitterTransform(spatializer, inverse, ae::math::vec3_t(0.f, 0.f, -c.distance), {});
+            ae::audio::setEmitterTransform(spatializer, linear, ae::math::vec3_t(0.f, 0.f, -c.distance), {});
+            ae::audio::updateSpatializer(spatializer, listener);
+            REQUIRE( ae::audio::getEmitterParams(spatializer, inverse).gain == Approx(c.inverse) );
+            REQUIRE( ae::audio::getEmitterParams(spatializer, linear).gain == Approx(c.linear).margin(1e-6) );
+            REQUIRE( ae::audio::getEmitterParams(spatializer, inverse).pan == Approx(0.f).margin(1e-6) );
+        }
+    }
+
+    SECTION( "pan follows the listener's right" ) {
+        uint32_t emitter = ae::audio::addEmitter(spatializer, {}, {});
+        ae::audio::setEmitterTransform(spatializer, emitter, ae::math::vec3_t(3.f, 0.f, 0.f), {});
+        ae::audio::updateSpatializer(spatializer, listener);
+        REQUIRE( ae::audio::getEmitterParams(spatializer, emitter).pan == Approx(1.f) );
+        ae::audio::setEmitterTransform(spatializer, emitter, ae::math::vec3_t(-3.f, 0.f, -3.f), {});
+        ae::audio::updateSpatializer(spatializer, listener);
+        REQUIRE( ae::audio::getEmitterParams(spatializer, emitter).pan == Approx(-sqrtf(0.5f)) );
+        // an emitter at the listener is centered.
+        ae::audio::setEmitterTransform(spatializer, emitter, listener.pos, {});
+        ae::audio::updateSpatializer(spatializer, listener);
+        REQUIRE( ae::audio::getEmitterParams(spatializer, emitter).pan == 0.f );
+        REQUIRE( ae::audio::getEmitterParams(spatializer, emitter).gain == 1.f );
+        REQUIRE( ae::audio::getEmitterParams(spatializer, emitter).pitch == 1.f );
+    }
+
+    SECTION( "Doppler" ) {
+        uint32_t emitter = ae::audio::addEmitter(spatializer, {}, {});
+        ae::math::vec3_t pos = ae::math::vec3_t(0.f, 0.f, -10.f);
+        ae::audio::setEmitterTransform(spatializer, emitter, pos, ae::math::vec3_t(0.f, 0.f, 34.3f));
+        ae::audio::updateSpatializer(spatializer, listener);
+        REQUIRE( ae::audio::getEmitterParams(spatializer, emitter).pitch == Approx(1.f / 0.9f) );
+        ae::audio::setEmitterTransform(spatializer, emitter, pos, ae::math::vec3_t(0.f, 0.f, -34.3f));
+        ae::audio::updateSpatializer(spatializer, listener);
+        REQUIRE( ae::audio::getEmitterParams(spatializer, emitter).pitch == Approx(1.f / 1.1f) );
+        // moving across the line to the listener does not shift the pitch.
+        ae::audio::setEmitterTransform(spatializer, emitter, pos, ae::math::vec3_t(50.f, 0.f, 0.f));
+        ae::audio::updateSpatializer(spatializer, listener);
+        REQUIRE( ae::audio::getEmitterParams(spatializer, emitter).pitch == Approx(1.f) );
+        // the listener moving toward the emitter.
+        ae::audio::setEmitterTransform(spatializer, emitter, pos, {});
+        listener.velocity = ae::math::vec3_t(0.f, 0.f, -34.3f);
+        ae::audio::updateSpatializer(spatializer, listener);
+        REQUIRE( ae::audio::getEmitterParams(spatializer, emitter).pitch == Approx(1.1f) );
+        // an emitter faster than sound is clamped.
+        ae::audio::setEmitterTransform(spatializer, emitter, pos, ae::math::vec3_t(0.f, 0.f, 1000.f));
+        ae::audio::updateSpatializer(spatializer, listener);
+        REQUIRE( ae::audio::getEmitterParams(spatializer, emitter).pitch == ae::audio::MIXER_MAX_PITCH );
+        ae::audio::destroySpatializer(spatializer);
+
+        desc.dopplerFactor = 0.f;
+        spatializer = ae::audio::createSpatializer(mixer, desc);
+        emitter = ae::audio::addEmitter(spatializer, {}, {});
+        ae::audio::setEmitterTransform(spatializer, emitter, pos, ae::math::vec3_t(0.f, 0.f, 100.f));
+        ae::audio::updateSpatializer(spatializer, listener);
+        REQUIRE( ae::audio::getEmitterParams(spatializer, emitter).pitch == 1.f );
+    }
+
+    SECTION( "only the parameters that changed are sent to the mixer" ) {
+        ae::audio::mixer_voice_t voice = ae::audio::mixerPlay(mixer, wav, {}, true);
+        ae::audio::emitter_desc_t emitterDesc = {};
+        emitterDesc.minDistance = 1.f;
+        uint32_t emitter = ae::audio::addEmitter(spatializer, voice, emitterDesc);
+        ae::audio::setEmitterTransform(spatializer, emitter, ae::math::vec3_t(0.f, 0.f, -4.f), {});
+        ae::audio::updateSpatializer(spatializer, listener);
+        std::vector<float> out(ae::audio::MIXER_BLOCK_FRAMES * 8);
+        ae::audio::mixerRender(mixer, out.data(), ae::audio::MIXER_BLOCK_FRAMES * 4);
+        // a centered voice at a quarter of the gain.
+        float expected = 0.25f * (8000.f / 32768.f);
+        REQUIRE( out.back() == Approx(expected) );
+
+        // the mixer still has the voice at these parameters, so an update with nothing changed must not send them.
+        ae::audio::mixer_voice_params_t params = {};
+        params.gain = 0.5f;
+        ae::audio::mixerSetParams(mixer, voice, params);
+        ae::audio::updateSpatializer(spatializer, listener);
+        ae::audio::mixerRender(mixer, out.data(), ae::audio::MIXER_BLOCK_FRAMES * 4);
+        REQUIRE( out.back() == Approx(0.5f * (8000.f / 32768.f)) );
+
+        ae::audio::setEmitterTransform(spatializer, emitter, ae::math::vec3_t(0.f, 0.f, -2.f), {});
+        ae::audio::updateSpatializer(spatializer, listener);
+        ae::audio::mixerRender(mixer, out.data(), ae::audio::MIXER_BLOCK_FRAMES * 4);
+        REQUIRE( out.back() == Approx(0.5f * (8000.f / 32768.f)) );
+    }
+
+    SECTION( "emitter handles" ) {
+        std::vector<uint32_t> ids;
+        for (uint32_t i = 0; i < desc.maxEmitters; i++) {
+            ids.push_back(ae::audio::addEmitter(spatializer, {}, {}));
+            REQUIRE( ids.back() != ae::audio::INVALID_EMITTER );
+        }
+        REQUIRE( ae::audio::addEmitter(spatializer, {}, {}) == ae::audio::INVALID_EMITTER );
+        ae::audio::removeEmitter(spatializer, ids[5]);
+        // removing twice or removing an invalid emitter does nothing.
+        ae::audio::removeEmitter(spatializer, ids[5]);
+        ae::audio::removeEmitter(spatializer, ae::audio::INVALID_EMITTER);
+        REQUIRE( ae::audio::addEmitter(spatializer, {}, {}) == ids[5] );
+        REQUIRE( ae::audio::addEmitter(spatializer, {}, {}) == ae::audio::INVALID_EMITTER );
+    }
+
+    SECTION( "a listener from a camera" ) {
+        ae::math::camera_t cam = {};
+        cam.trans.scale = ae::math::vec3_t(1.f, 1.f, 1.f);
+        cam.trans.pos = ae::math::vec3_t(1.f, 2.f, 3.f);
+        cam.trans.eulerAngles = ae::math::vec3_t(0.3f, 1.1f, 0.f);
+        cam.velocity = ae::math::vec3_t(4.f, 5.f, 6.f);
+        ae::audio::listener_t camListener = ae::audio::makeListener(cam);
+        REQUIRE( camListener.pos.x == 1.f );
+        REQUIRE( camListener.velocity.z == 6.f );
+        // the right axis is +X in the view space of the camera.
+        ae::math::vec4_t right = ae::math::buildViewMat(cam) *
+                                 ae::math::vec4_t(cam.trans.pos + camListener.right, 1.f);
+        REQUIRE( right.x == Approx(1.f) );
+        REQUIRE( right.y == Approx(0.f).margin(1e-6) );
+        REQUIRE( right.z == Approx(0.f).margin(1e-6) );
+    }
+
+    ae::audio::destroySpatializer(spatializer);
+    ae::audio::destroyMixer(mixer);
+}
+
+TEST_CASE( "dsp effects", "[ae::dsp]" ) {
+    utils::SetupTestEngineContext();
+    utils::Seed(__LINE__);
+    const float sampleRate = 44100.f;
+    auto noise = [](uint32_t count) {
+        std::vector<float> samples(count);
+        for (float &sample : samples) sample = utils::RandomFloat(-1.f, 1.f);
+        return samples;
+    };
+    // the amplitude of a steady sine through an effect, measured after it has settled.
+    auto sineGain = [sampleRate](float frequency, uint32_t channels, std::function<void(float *, uint32_t)> effect) {
+        const uint32_t frameCount = 44100;
+        std::vector<float> samples(size_t(frameCount) * channels);
+        for (uint32_t i = 0; i < frameCount; i++)
+            for (uint32_t c = 0; c < channels; c++)
+                samples[size_t(i) * channels + c] = sinf(2.f * 3.14159265f * frequency * i / sampleRate);
+        effect(samples.data(), frameCount);
+        float peak = 0.f;
+        for (uint32_t i = frameCount / 2; i < frameCount; i++) peak = std::max(peak, fabsf(samples[size_t(i) * channels]));
+        return peak;
+    };
+    auto toDb = [](float gain) { return 20.f * log10f(gain); };
+
+    SECTION( "biquads match a scalar filter for any channel count and block size" ) {
+        for (uint32_t channels : { 1u, 2u, 3u, 4u, 6u, 8u }) {
+            ae::dsp::biquad_t filter = {};
+            ae::dsp::designBiquad(&filter, ae::dsp::BIQUAD_PEAK, sampleRate, 1000.f, 2.f, 6.f);
+            const uint32_t frameCount = 1000;
+            std::vector<float> samples = noise(frameCount * channels);
+            std::vector<float> expected = samples;
+            for (uint32_t c = 0; c < channels; c++) {
+                float z1 = 0.f, z2 = 0.f;
+                for (uint32_t i = 0; i < frameCount; i++) {
+                    float x = expected[i * channels + c];
+                    float y = filter.b0 * x + z1;
+                    z1 = filter.b1 * x + z2 - filter.a1 * y;
+                    z2 = filter.b2 * x - filter.a2 * y;
+                    expected[i * channels + c] = y;
+                }
+            }
+            // odd block sizes, so that the state is carried between blocks.
+            for (uint32_t done = 0; done < frameCount;) {
+                uint32_t count = std::min(frameCount - done, utils::RandomUINT32(1, 100));
+                ae::dsp::processBiquad(&filter, samples.data() + done * channels, count, channels);
+                done += count;
+            }
+            for (size_t i = 0; i < samples.size(); i++) REQUIRE( samples[i] == Approx(expected[i]).margin(1e-5) );
+        }
+    }
+
+    SECTION( "biquad responses" ) {
+        ae::dsp::biquad_t filter = {};
+        auto run = [&filter](float *samples, uint32_t frameCount) {
+            filter = { filter.b0, filter.b1, filter.b2, filter.a1, filter.a2 };
+            ae::dsp::processBiquad(&filter, samples, frameCount, 2);
+        };
+        ae::dsp::designBiquad(&filter, ae::dsp::BIQUAD_LOWPASS, sampleRate, 1000.f, 0.7071f);
+        REQUIRE( toDb(sineGain(100.f, 2, run)) == Approx(0.f).margin(0.05) );
+        REQUIRE( toDb(sineGain(1000.f, 2, run)) == Approx(-3.f).margin(0.1) );
+        REQUIRE( toDb(sineGain(10000.f, 2, run)) < -35.f );
+        ae::dsp::designBiquad(&filter, ae::dsp::BIQUAD_HIGHPASS, sampleRate, 1000.f, 0.7071f);
+        REQUIRE( toDb(sineGain(100.f, 2, run)) < -35.f );
+        REQUIRE( toDb(sineGain(10000.f, 2, run)) == Approx(0.f).margin(0.05) );
+        ae::dsp::designBiquad(&filter, ae::dsp::BIQUAD_BANDPASS, sampleRate, 2000.f, 4.f);
+        REQUIRE( toDb(sineGain(2000.f, 2, run)) == Approx(0.f).margin(0.05) );
+        REQUIRE( toDb(sineGain(200.f, 2, run)) < -20.f );
+        ae::dsp::designBiquad(&filter, ae::dsp::BIQUAD_NOTCH, sampleRate, 2000.f, 4.f);
+        REQUIRE( toDb(sineGain(2000.f, 2, run)) < -40.f );
+        REQUIRE( toDb(sineGain(200.f, 2, run)) == Approx(0.f).margin(0.05) );
+        ae::dsp::designBiquad(&filter, ae::dsp::BIQUAD_PEAK, sampleRate, 2000.f, 2.f, -9.f);
+        REQUIRE( toDb(sineGain(2000.f, 2, run)) == Approx(-9.f).margin(0.05) );
+        ae::dsp::designBiquad(&filter, ae::dsp::BIQUAD_LOWSHELF, sampleRate, 500.f, 0.7071f, 6.f);
+        REQUIRE( toDb(sineGain(30.f, 2, run)) == Approx(6.f).margin(0.1) );
+        REQUIRE( toDb(sineGain(15000.f, 2, run)) == Approx(0.f).margin(0.1) );
+        ae::dsp::designBiquad(&filter, ae::dsp::BIQUAD_HIGHSHELF, sampleRate, 5000.f, 0.7071f, -6.f);
+        REQUIRE( toDb(sineGain(50.f, 2, run)) == Approx(0.f).margin(0.1) );
+        REQUIRE( toDb(sineGain(18000.f, 2, run)) == Approx(-6.f).margin(0.2) );
+    }
+
+    SECTION( "one-pole lowpass and smoothed gain" ) {
+        ae::dsp::one_pole_t filter = {};
+        ae::dsp::designOnePole(&filter, sampleRate, 100.f);
+        // the step response reaches 1 - 1/e after one time constant.
+        std::vector<float> step(441 * 3, 1.f);
+        ae::dsp::processOnePole(&filter, step.data(), 441, 3);
+        float tau = sampleRate / (2.f * 3.14159265f * 100.f);
+        uint32_t frame = uint32_t(tau + 0.5f) - 1;
+        REQUIRE( step[frame * 3 + 2] == Approx(1.f - expf(-float(frame + 1) / tau)).margin(1e-3) );
+        REQUIRE( step[frame * 3] == step[frame * 3 + 2] );
+
+        for (uint32_t channels : { 1u, 2u, 5u }) {
+            ae::dsp::one_pole_t smoother = {};
+            ae::dsp::designOnePole(&smoother, sampleRate, 50.f);
+            float a = smoother.a;
+            float current = 0.f;
+            for (float target : { 1.f, 0.25f, 0.25f, 0.8f }) {
+                uint32_t frameCount = utils::RandomUINT32(1, 600);
+                std::vector<float> samples(size_t(frameCount) * channels, 1.f);
+                ae::dsp::applySmoothedGain(&smoother, target, samples.data(), frameCount, channels);
+                for (uint32_t i = 0; i < frameCount; i++) {
+                    current += a * (target - current);
+                    for (uint32_t c = 0; c < channels; c++)
+                        REQUIRE( samples[size_t(i) * channels + c] == Approx(current).margin(1e-5) );
+                }
+                REQUIRE( smoother.y[0] == Approx(current).margin(1e-5) );
+            }
+        }
+    }
+
+    SECTION( "compressor" ) {
+        ae::dsp::compressor_params_t params = {};
+        params.thresholdDb = -20.f;
+        params.ratio = 4.f;
+        params.attackTime = 0.f;
+        params.releaseTime = 0.05f;
+        params.makeupDb = 3.f;
+        ae::dsp::compressor_t compressor = {};
+        auto run = [&](float *samples, uint32_t frameCount) {
+            compressor.envelope = 0.f;
+            ae::dsp::designCompressor(&compressor, sampleRate, params);
+            ae::dsp::processCompressor(&compressor, samples, frameCount, 2);
+        };
+        // 0 dB in is 20 dB over, which comes out 5 dB over, plus the makeup. with no attack, the envelope is at each
+        // peak as it passes.
+        REQUIRE( toDb(sineGain(100.f, 2, run)) == Approx(-20.f + 5.f + 3.f).margin(0.05) );
+        // below the threshold, only the makeup is applied.
+        auto quiet = [&](float *samples, uint32_t frameCount) {
+            for (uint32_t i = 0; i < frameCount * 2; i++) samples[i] *= 0.05f;
+            run(samples, frameCount);
+        };
+        REQUIRE( toDb(sineGain(100.f, 2, quiet)) == Approx(toDb(0.05f) + 3.f).margin(0.01) );
+
+        // a limiter never lets a peak through.
+        params.ratio = INFINITY;
+        params.attackTime = 0.f;
+        params.makeupDb = 0.f;
+        ae::dsp::designCompressor(&compressor, sampleRate, params);
+        compressor.envelope = 0.f;
+        std::vector<float> samples = noise(4410 * 3);
+        for (float &sample : samples) sample *= 4.f;
+        ae::dsp::processCompressor(&compressor, samples.data(), 4410, 3);
+        float threshold = powf(10.f, -20.f / 20.f);
+        float peak = 0.f;
+        for (float sample : samples) peak = std::max(peak, fabsf(sample));
+        REQUIRE( peak <= threshold * (1.f + 1e-6f) );
+        REQUIRE( peak > threshold * 0.99f );
+    }
+
+    SECTION( "delay" ) {
+        for (uint32_t channels : { 1u, 2u, 3u }) {
+            ae::dsp::delay_desc_t desc = {};
+            desc.channels = channels;
+            desc.maxDelayTime = 0.01f;
+            // a delay of 3 frames is shorter than every block, and so the spans are cut short.
+            for (float delayTime : { 3.f / sampleRate, 0.0071f, 0.01f }) {
+                desc.params.delayTime = delayTime;
+                desc.params.feedback = 0.5f;
+                desc.params.wet = 0.7f;
+                desc.params.dry = 0.9f;
+                ae::dsp::delay_t *delay = ae::dsp::createDelay(desc);
+                REQUIRE( delay );
+                uint32_t delayFrames = uint32_t(roundf(delayTime * sampleRate));
+                const uint32_t frameCount = 2000;
+                std::vector<float> samples = noise(frameCount * channels);
+                std::vector<float> line(size_t(frameCount) * channels, 0.f), expected = samples;
+                for (uint32_t i = 0; i < frameCount; i++) {
+                    for (uint32_t c = 0; c < channels; c++) {
+                        float x = samples[size_t(i) * channels + c];
+                        float d = (i >= delayFrames) ? line[size_t(i - delayFrames) * channels + c] : 0.f;
+                        line[size_t(i) * channels + c] = x + 0.5f * d;
+                        expected[size_t(i) * channels + c] = 0.9f * x + 0.7f * d;
+                    }
+                }
+                for (uint32_t done = 0; done < frameCount;) {
+                    uint32_t count = std::min(frameCount - done, utils::RandomUINT32(1, 300));
+                    ae::dsp::processDelay(delay, samples.data() + done * channels, count);
+                    done += count;
+                }
+                for (size_t i = 0; i < samples.size(); i++) REQUIRE( samples[i] == Approx(expected[i]).margin(1e-5) );
+                ae::dsp::destroyDelay(delay);
+            }
+        }
+        ae::dsp::delay_desc_t desc = {};
+        desc.channels = ae::dsp::DSP_MAX_CHANNELS + 1;
+        REQUIRE( ae::dsp::createDelay(desc) == nullptr );
+    }
+
+    SECTION( "reverb" ) {
+        ae::dsp::reverb_desc_t desc = {};
+        desc.params.decayTime = 0.5f;
+        desc.params.dampingFrequency = 20000.f;
+        desc.params.wet = 1.f;
+        desc.params.dry = 0.f;
+        ae::dsp::reverb_t *reverb = ae::dsp::createReverb(desc);
+        REQUIRE( reverb );
+        // the response to an impulse, over three decay times.
+        const uint32_t frameCount = 44100 * 3 / 2;
+        std::vector<float> samples(frameCount * 2, 0.f);
+        samples[0] = samples[1] = 1.f;
+        for (uint32_t done = 0; done < frameCount; done += 441)
+            ae::dsp::processReverb(reverb, samples.data() + done * 2, 441);
+        auto energy = [&samples](float begin, float end) {
+            double sum = 0.0;
+            for (uint32_t i = uint32_t(begin * 44100.f); i < uint32_t(end * 44100.f); i++)
+                sum += double(samples[i * 2]) * samples[i * 2] + double(samples[i * 2 + 1]) * samples[i * 2 + 1];
+            return sum;
+        };
+        // the tail falls 60 dB per decay time, which is 6 dB per 50 ms.
+        double early = energy(0.1f, 0.15f), late = energy(0.6f, 0.65f);
+        REQUIRE( early > 0.0 );
+        REQUIRE( 10.0 * log10(early / late) == Approx(60.0).margin(6.0) );
+        // the ears differ.
+        double difference = 0.0;
+        for (uint32_t i = 0; i < 44100 / 2; i++) difference += fabs(samples[i * 2] - samples[i * 2 + 1]);
+        REQUIRE( difference > 1.0 );
+        // the tail reaches silence, without passing through denormals.
+        for (uint32_t block = 0; block < 200; block++) {
+            std::fill(samples.begin(), samples.begin() + 441 * 2, 0.f);
+            ae::dsp::processReverb(reverb, samples.data(), 441);
+        }
+        for (uint32_t i = 0; i < 441 * 2; i++) REQUIRE( (samples[i] == 0.f || fabsf(samples[i]) >= FLT_MIN) );
+        ae::dsp::destroyReverb(reverb);
+    }
+
+    SECTION( "the denormal mode of the caller is kept" ) {
+        uint32_t csr = _mm_getcsr();
+        ae::dsp::biquad_t filter = {};
+        ae::dsp::designBiquad(&filter, ae::dsp::BIQUAD_LOWPASS, sampleRate, 1000.f, 0.7071f);
+        // a denormal in the state is read as zero.
+        filter.z1[0] = 1e-40f;
+        float sample = 0.f;
+        ae::dsp::processBiquad(&filter, &sample, 1, 1);
+        REQUIRE( sample == 0.f );
+        REQUIRE( _mm_getcsr() == csr );
+    }
+}
+
+TEST_CASE( "software rasterizer", "[ae::frender]" ) {
+    utils::SetupTestEngineContext();
+    // NOTE: the models are given without normals, which the rasterizer does not use.
+    const uint32_t red = 0xFFFF0000, green = 0xFF00FF00;
+    ae::math::mat4_t identity = {};
+
+    ae::frender::rasterizer_t *rasterizer = ae::frender::createRasterizer();
+    std::vector<uint32_t> pixels(64 * 64, 0);
+    ae::frender::backbuffer_t target = { pixels.data(), 64, 64, sizeof(uint32_t), 64 * sizeof(uint32_t) };
+    auto count = [&](uint32_t color) { return (uint32_t)std::count(pixels.begin(), pixels.end(), color); };
+
+    SECTION( "a quad covers the pixels whose centers it contains once" ) {
+        // NDC [-0.5, 0.5] is pixels [16, 48). the diagonal that the triangles share passes through 32 pixel centers.
+        ae::raw_model_t quad = utils::MakeModel(
+            { {-0.5f, -0.5f, 0, 0, 0}, {0.5f, -0.5f, 0, 0, 0}, {0.5f, 0.5f, 0, 0, 0}, {-0.5f, 0.5f, 0, 0, 0} }, {});
+        uint32_t lower[3] = { 0, 1, 2 }, upper[3] = { 0, 2, 3 };
+        ae::frender::raster_material_t material = {};
+        REQUIRE( ae::frender::beginRaster(rasterizer, target, identity) );
+        material.color = red;
+        ae::frender::rasterModel(rasterizer, quad, identity, material, lower, 3);
+        material.color = green;
+        ae::frender::rasterModel(rasterizer, quad, identity, material, upper, 3);
+        ae::frender::endRaster(rasterizer);
+
+        for (uint32_t y = 0; y < 64; y++) {
+            for (uint32_t x = 0; x < 64; x++) {
+                bool bInside = x >= 16 && x < 48 && y >= 16 && y < 48;
+                REQUIRE( (pixels[y * 64 + x] != 0) == bInside );
+            }
+        }
+        REQUIRE( count(red) + count(green) == 32 * 32 );
+        REQUIRE( std::min(count(red), count(green)) == (32 * 32 - 32) / 2 );
+
+        ae::frender::raster_stats_t stats = ae::frender::getRasterStats(rasterizer);
+        REQUIRE( stats.triangles == 2 );
+        REQUIRE( stats.binned == 2 );
+        REQUIRE( stats.culled == 0 );
+
+        // the same quad wound clockwise is a back face.
+        uint32_t back[6] = { 0, 2, 1, 0, 3, 2 };
+        REQUIRE( ae::frender::beginRaster(rasterizer, target, identity) );
+        ae::frender::rasterModel(rasterizer, quad, identity, material, back, 6);
+        REQUIRE( ae::frender::getRasterStats(rasterizer).culled == 2 );
+        material.bCullBackfaces = false;
+        ae::frender::rasterModel(rasterizer, quad, identity, material, back, 6);
+        REQUIRE( ae::frender::getRasterStats(rasterizer).binned == 2 );
+        utils::FreeModel(quad);
+    }
+
+    SECTION( "the nearest triangle wins regardless of order" ) {
+        ae::raw_model_t quads = utils::MakeModel({ {-1, -1, 0.5f, 0, 0}, {1, -1, 0.5f, 0, 0}, {1, 1, 0.5f, 0, 0},
+            {-1, 1, 0.5f, 0, 0}, {-1, -1, -0.5f, 0, 0}, {1, -1, -0.5f, 0, 0}, {1, 1, -0.5f, 0, 0},
+            {-1, 1, -0.5f, 0, 0} }, {});
+        uint32_t far[6] = { 0, 1, 2, 0, 2, 3 }, near[6] = { 4, 5, 6, 4, 6, 7 };
+        ae::frender::raster_material_t farMaterial = {}, nearMaterial = {};
+        farMaterial.color = red;
+        nearMaterial.color = green;
+        for (bool bNearFirst : { true, false }) {
+            REQUIRE( ae::frender::beginRaster(rasterizer, target, identity) );
+            if (bNearFirst) ae::frender::rasterModel(rasterizer, quads, identity, nearMaterial, near, 6);
+            ae::frender::rasterModel(rasterizer, quads, identity, farMaterial, far, 6);
+            if (!bNearFirst) ae::frender::rasterModel(rasterizer, quads, identity, nearMaterial, near, 6);
+            ae::frender::endRaster(rasterizer);
+            REQUIRE( count(green) == 64 * 64 );
+        }
+        utils::FreeModel(quads);
+    }
+
+    SECTION( "textures are sampled perspective correct" ) {
+        // a wall that recedes from z=-1 on the left to z=-3 on the right, with u across it. u=0.5 is at x=0,
+        // z=-2, which projects to the center of the screen. interpolating u affinely would put it a third of the way
+        // across instead.
+        ae::raw_model_t wall = utils::MakeModel(
+            { {-1, -1, -1, 0, 0}, {1, -1, -3, 1, 0}, {1, 1, -3, 1, 1}, {-1, 1, -1, 0, 1} }, { 0, 1, 2, 0, 2, 3 });
+        uint32_t texels[2] = { 0xFF0000FF, 0xFF00FF00 };  // red then green, as 0xABGR.
+        ae::loaded_image_t texture = {};
+        texture.pixelPointer = texels;
+        texture.width = 2;
+        texture.height = 1;
+        ae::math::camera_t cam = {};
+        cam.trans.scale = { 1, 1, 1 };
+        cam.fov = 90.f;
+        cam.nearPlane = 0.1f;
+        cam.farPlane = 100.f;
+        cam.width = cam.height = 64;
+        ae::frender::raster_material_t material = {};
+        material.texture = &texture;
+        REQUIRE( ae::frender::beginRaster(
+            rasterizer, target, ae::math::buildProjMat(cam) * ae::math::buildViewMat(cam)) );
+        ae::frender::rasterModel(rasterizer, wall, identity, material);
+        ae::frender::endRaster(rasterizer);
+        const uint32_t *row = pixels.data() + 32 * 64;
+        REQUIRE( row[1] == red );
+        REQUIRE( row[22] == red );
+        REQUIRE( row[30] == red );
+        REQUIRE( row[33] == green );
+        REQUIRE( row[42] == green );
+        REQUIRE( row[43] == 0 );
+
+        // a tint multiplies the texture.
+        material.color = 0xFF808080;
+        REQUIRE( ae::frender::beginRaster(
+            rasterizer, target, ae::math::buildProjMat(cam) * ae::math::buildViewMat(cam)) );
+        ae::frender::rasterModel(rasterizer, wall, identity, material);
+        ae::frender::endRaster(rasterizer);
+        REQUIRE( row[1] == 0xFF800000 );
+        utils::FreeModel(wall);
+    }
+
+    SECTION( "triangles through the near plane and past the guard band are clipped" ) {
+        // a floor that extends far behind and to the sides of a camera above it. it fills the screen below the
+        // horizon. the far plane puts the horizon a third of a pixel below the center.
+        ae::raw_model_t floor = utils::MakeModel({ {-1000, 0, 1000, 0, 0}, {1000, 0, 1000, 0, 0},
+            {1000, 0, -1000, 0, 0}, {-1000, 0, -1000, 0, 0} }, { 0, 1, 2, 0, 2, 3 });
+        ae::math::camera_t cam = {};
+        cam.trans.pos = { 0, 1, 0 };
+        cam.trans.scale = { 1, 1, 1 };
+        cam.fov = 90.f;
+        cam.nearPlane = 0.1f;
+        cam.farPlane = 100.f;
+        cam.width = cam.height = 64;
+        ae::frender::raster_material_t material = {};
+        material.color = green;
+        REQUIRE( ae::frender::beginRaster(
+            rasterizer, target, ae::math::buildProjMat(cam) * ae::math::buildViewMat(cam)) );
+        ae::frender::rasterModel(rasterizer, floor, identity, material);
+        ae::frender::endRaster(rasterizer);
+        for (uint32_t y = 0; y < 64; y++) {
+            uint32_t expected = y >= 32 ? 64 : 0;
+            REQUIRE( (uint32_t)std::count(pixels.begin() + y * 64, pixels.begin() + (y + 1) * 64, green) == expected );
+        }
+        REQUIRE( ae::frender::getRasterStats(rasterizer).clipped == 2 );
+        utils::FreeModel(floor);
+    }
+
+    SECTION( "faces are flat shaded" ) {
+        ae::raw_model_t quad = utils::MakeModel(
+            { {-1, -1, 0, 0, 0}, {1, -1, 0, 0, 0}, {1, 1, 0, 0, 0}, {-1, 1, 0, 0, 0} }, { 0, 1, 2, 0, 2, 3 });
+        ae::frender::raster_material_t material = {};
+        material.color = 0xFFC8C8C8;
+        material.bLit = true;
+        material.ambient = 0.25f;
+        // NOTE: the identity view looks down -Z at the quad, which faces +Z.
+        for (float lightZ : { 1.f, -1.f }) {
+            material.lightDir = ae::math::vec3_t(0.f, 0.f, lightZ);
+            REQUIRE( ae::frender::beginRaster(rasterizer, target, identity) );
+            ae::frender::rasterModel(rasterizer, quad, identity, material);
+            ae::frender::endRaster(rasterizer);
+            REQUIRE( count(lightZ > 0.f ? 0xFFC8C8C8 : 0xFF323232) == 64 * 64 );
+        }
+        utils::FreeModel(quad);
+    }
+
+    SECTION( "random triangles match a reference rasterizer" ) {
+        // an odd target size, so that the right and bottom tiles are partial and the rows do not end on a span.
+        const uint32_t width = 203, height = 150;
+        std::vector<uint32_t> image(width * height, 0);
+        ae::frender::backbuffer_t bigTarget = { image.data(), width, height, sizeof(uint32_t), width * 4 };
+        utils::Seed(__LINE__);
+        const uint32_t triangleCount = 200;
+        ae::raw_model_t soup = {};
+        for (uint32_t i = 0; i < triangleCount; i++) {
+            // some of the triangles hang off of the target.
+            float cx = utils::RandomFloat(-1.1f, 1.1f), cy = utils::RandomFloat(-1.1f, 1.1f);
+            for (uint32_t k = 0; k < 3; k++) {
+                float vertex[8] = { cx + utils::RandomFloat(-0.3f, 0.3f), cy + utils::RandomFloat(-0.3f, 0.3f),
+                    utils::RandomFloat(-0.9f, 0.9f), 0, 0, 0, 0, 1 };
+                for (float f : vertex) StretchyBufferPush(soup.vertexData, f);
+                StretchyBufferPush(soup.indexData, i * 3 + k);
+            }
+        }
+        REQUIRE( ae::frender::beginRaster(rasterizer, bigTarget, identity) );
+        for (uint32_t i = 0; i < triangleCount; i++) {
+            ae::frender::raster_material_t material = {};
+            material.color = 0xFF000000 | (i + 1);
+            material.bCullBackfaces = false;
+            ae::frender::rasterModel(rasterizer, soup, identity, material, soup.indexData + i * 3, 3);
+        }
+        ae::frender::endRaster(rasterizer);
+
+        // NOTE: the reference snaps the vertices to subpixels as the rasterizer does, but does not follow its fill
+        // rule, so the pixels whose centers are about on an edge, or where two triangles are at about the same depth,
+        // may go either way. they are skipped.
+        auto snap = [](float pixels) { return lrintf(pixels * 16.f) / 16.f; };
+        uint32_t mismatches = 0, skipped = 0;
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                float px = x + 0.5f, py = y + 0.5f;
+                float nearest = 1.f;
+                uint32_t expected = 0;
+                bool bAmbiguous = false;
+                for (uint32_t i = 0; i < triangleCount && !bAmbiguous; i++) {
+                    float sx[3], sy[3], sz[3];
+                    for (uint32_t k = 0; k < 3; k++) {
+                        const float *v = soup.vertexData + (i * 3 + k) * 8;
+                        sx[k] = snap((v[0] + 1.f) * width * 0.5f);
+                        sy[k] = snap((1.f - v[1]) * height * 0.5f);
+                        sz[k] = v[2] * 0.5f + 0.5f;
+                    }
+                    float area = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sy[1] - sy[0]) * (sx[2] - sx[0]);
+                    if (fabsf(area) < 1.f) continue;
+                    // the barycentrics, and the distances in pixels to the edges, which are negative outside.
+                    float l[3], distance[3];
+                    for (uint32_t e = 0; e < 3; e++) {
+                        uint32_t i0 = (e + 1) % 3, i1 = (e + 2) % 3;
+                        float dx = sx[i1] - sx[i0], dy = sy[i1] - sy[i0];
+                        l[e] = (dx * (py - sy[i0]) - dy * (px - sx[i0])) / area;
+                        distance[e] = l[e] * fabsf(area) / sqrtf(dx * dx + dy * dy);
+                    }
+                    float closest = std::min(distance[0], std::min(distance[1], distance[2]));
+                    bAmbiguous |= fabsf(closest) < 1.f / 32.f;
+                    if (closest < 0.f) continue;
+                    float depth = l[0] * sz[0] + l[1] * sz[1] + l[2] * sz[2];
+                    bAmbiguous |= fabsf(depth - nearest) < 1e-3f;
+                    if (depth < nearest) {
+                        nearest = depth;
+                        expected = 0xFF000000 | (i + 1);
+                    }
+                }
+                skipped += bAmbiguous;
+                mismatches += !bAmbiguous && image[y * width + x] != expected;
+            }
+        }
+        REQUIRE( skipped < width * height / 10 );
+        REQUIRE( mismatches == 0 );
+        utils::FreeModel(soup);
+    }
+
+    ae::frender::destroyRasterizer(rasterizer);
+}
+
+TEST_CASE( "bitmap blits", "[ae::frender]" ) {
+    utils::SetupTestEngineContext();
+    utils::Seed(__LINE__);
+    // NOTE: the alpha comes in runs, so that the opaque and the clear spans are hit as well as the blended ones.
+    auto randomImage = [](uint32_t width, uint32_t height) {
+        std::vector<uint32_t> pixels(width * height);
+        uint32_t alpha = 0;
+        for (uint32_t i = 0; i < width * height; i++) {
+            if (i % 8 == 0) alpha = utils::RandomUINT32(0, 2);
+            uint32_t a = alpha == 0 ? 0 : alpha == 1 ? 255 : utils::RandomUINT32(0, 255);
+            pixels[i] = (a << 24) | (utils::RandomUINT32(0, 255) << 16) | (utils::RandomUINT32(0, 255) << 8) |
+                        utils::RandomUINT32(0, 255);
+        }
+        return pixels;
+    };
+    auto premultiplied = [](uint32_t p) {
+        uint32_t a = p >> 24, result = p & 0xFF000000;
+        for (uint32_t shift = 0; shift < 24; shift += 8) result |= ((2 * ((p >> shift) & 0xFF) * a + 255) / 510) << shift;
+        return result;
+    };
+
+    SECTION( "premultiplied alpha" ) {
+        std::vector<uint32_t> pixels = randomImage(37, 5);
+        std::vector<uint32_t> expected = pixels;
+        for (uint32_t &p : expected) p = premultiplied(p);
+        ae::loaded_image_t image = {};
+        image.pixelPointer = pixels.data();
+        image.width = 37;
+        image.height = 5;
+        ae::frender::premultiplyAlpha(image);
+        REQUIRE( pixels == expected );
+    }
+
+    SECTION( "the first row of the image is the bottom" ) {
+        uint32_t pixels[2] = { 0xFF0000FF, 0xFF00FF00 };  // red, then green above it, as 0xABGR.
+        ae::loaded_image_t image = {};
+        image.pixelPointer = pixels;
+        image.width = 1;
+        image.height = 2;
+        uint32_t out[4 * 4] = {};
+        ae::frender::backbuffer_t target = { out, 4, 4, sizeof(uint32_t), 4 * sizeof(uint32_t) };
+        ae::frender::drawBitmap(&target, image, 1, 1);
+        REQUIRE( out[1 * 4 + 1] == 0xFF00FF00 );
+        REQUIRE( out[2 * 4 + 1] == 0xFFFF0000 );
+        REQUIRE( std::count(out, out + 16, 0u) == 14 );
+    }
+
+    SECTION( "blits match a reference at every scale and clipping" ) {
+        const uint32_t width = 103, height = 71;
+        std::vector<uint32_t> pixels = randomImage(width, height), expected = pixels;
+        ae::frender::backbuffer_t target = { pixels.data(), width, height, sizeof(uint32_t), width * 4 };
+        for (uint32_t iteration = 0; iteration < 200; iteration++) {
+            uint32_t imageWidth = utils::RandomUINT32(1, 40), imageHeight = utils::RandomUINT32(1, 40);
+            uint32_t scale = utils::RandomUINT32(1, 6);
+            int32_t x = (int32_t)utils::RandomUINT32(0, 220) - 110, y = (int32_t)utils::RandomUINT32(0, 160) - 80;
+            std::vector<uint32_t> imagePixels = randomImage(imageWidth, imageHeight);
+            ae::loaded_image_t image = {};
+            image.pixelPointer = imagePixels.data();
+            image.width = imageWidth;
+            image.height = imageHeight;
+            ae::frender::premultiplyAlpha(image);
+            ae::frender::drawBitmap(&target, image, x, y, scale);
+
+            for (int32_t py = std::max(y, 0); py < std::min(y + int32_t(imageHeight * scale), int32_t(height)); py++) {
+                for (int32_t px = std::max(x, 0); px < std::min(x + int32_t(imageWidth * scale), int32_t(width)); px++) {
+                    uint32_t s = imagePixels[(imageHeight - 1 - (py - y) / scale) * imageWidth + (px - x) / scale];
+                    uint32_t &d = expected[py * width + px];
+                    uint32_t a = s >> 24, result = 0;
+                    for (uint32_t shift = 0; shift < 32; shift += 8) {
+                        // the image is 0xABGR and the target is 0xARGB.
+                        uint32_t srcShift = (shift == 0) ? 16 : (shift == 16) ? 0 : shift;
+                        uint32_t c = ((s >> srcShift) & 0xFF) + (2 * ((d >> shift) & 0xFF) * (255 - a) + 255) / 510;
+                        result |= std::min(c, 255u) << shift;
+                    }
+                    d = result;
+                }
+            }
+            REQUIRE( pixels == expected );
+        }
+    }
+
+    SECTION( "scaled blits at 1x match the blits" ) {
+        const uint32_t width = 61, height = 47;
+        for (auto filter : { ae::frender::IMAGE_FILTER_BILINEAR, ae::frender::IMAGE_FILTER_BICUBIC }) {
+            for (uint32_t iteration = 0; iteration < 50; iteration++) {
+                uint32_t imageWidth = utils::RandomUINT32(1, 40), imageHeight = utils::RandomUINT32(1, 40);
+                int32_t x = (int32_t)utils::RandomUINT32(0, 120) - 60, y = (int32_t)utils::RandomUINT32(0, 100) - 50;
+                std::vector<uint32_t> imagePixels = randomImage(imageWidth, imageHeight);
+                ae::loaded_image_t image = {};
+                image.pixelPointer = imagePixels.data();
+                image.width = imageWidth;
+                image.height = imageHeight;
+                ae::frender::premultiplyAlpha(image);
+                std::vector<uint32_t> pixels = randomImage(width, height), expected = pixels;
+                ae::frender::backbuffer_t target = { pixels.data(), width, height, sizeof(uint32_t), width * 4 };
+                ae::frender::backbuffer_t reference = { expected.data(), width, height, sizeof(uint32_t), width * 4 };
+                ae::frender::drawBitmapScaled(&target, image, float(x), float(y), float(imageWidth), float(imageHeight),
+                    filter);
+                ae::frender::drawBitmap(&reference, image, x, y);
+                REQUIRE( pixels == expected );
+            }
+        }
+    }
+
+    SECTION( "scaled blits of a flat image cover the pixel centers in the rectangle" ) {
+        uint32_t flat[5 * 3];
+        std::fill(flat, flat + 15, 0xFF336699u);
+        ae::loaded_image_t image = {};
+        image.pixelPointer = flat;
+        image.width = 5;
+        image.height = 3;
+        const float rects[][4] = {
+            { 10.3f, 5.7f, 20.2f, 7.4f }, { -3.5f, 20.1f, 2.2f, 1.3f }, { 50.f, -4.f, 30.f, 40.f } };
+        for (auto filter : { ae::frender::IMAGE_FILTER_BILINEAR, ae::frender::IMAGE_FILTER_BICUBIC }) {
+            for (const auto &rect : rects) {
+                uint32_t out[64 * 32] = {};
+                ae::frender::backbuffer_t target = { out, 64, 32, sizeof(uint32_t), 64 * sizeof(uint32_t) };
+                ae::frender::drawBitmapScaled(&target, image, rect[0], rect[1], rect[2], rect[3], filter);
+                for (uint32_t y = 0; y < 32; y++) {
+                    for (uint32_t x = 0; x < 64; x++) {
+                        bool bInside = x + 0.5f >= rect[0] && x + 0.5f < rect[0] + rect[2] && y + 0.5f >= rect[1] &&
+                                       y + 0.5f < rect[1] + rect[3];
+                        REQUIRE( out[y * 64 + x] == (bInside ? 0xFF996633u : 0u) );
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION( "bilinear blits match a reference when stretched and shrunk" ) {
+        const uint32_t width = 80, height = 60;
+        for (uint32_t iteration = 0; iteration < 50; iteration++) {
+            uint32_t imageWidth = utils::RandomUINT32(1, 30), imageHeight = utils::RandomUINT32(1, 30);
+            std::vector<uint32_t> imagePixels = randomImage(imageWidth, imageHeight);
+            for (uint32_t &p : imagePixels) p |= 0xFF000000;
+            ae::loaded_image_t image = {};
+            image.pixelPointer = imagePixels.data();
+            image.width = imageWidth;
+            image.height = imageHeight;
+            float x = utils::RandomUINT32(0, 1000) / 10.f - 20.f, y = utils::RandomUINT32(0, 800) / 10.f - 20.f;
+            float w = utils::RandomUINT32(5, 600) / 10.f, h = utils::RandomUINT32(5, 600) / 10.f;
+            std::vector<uint32_t> pixels(width * height, 0);
+            ae::frender::backbuffer_t target = { pixels.data(), width, height, sizeof(uint32_t), width * 4 };
+            ae::frender::drawBitmapScaled(&target, image, x, y, w, h, ae::frender::IMAGE_FILTER_BILINEAR);
+
+            auto texel = [&](int32_t tx, int32_t ty, uint32_t shift) {
+                tx = std::min(std::max(tx, 0), int32_t(imageWidth) - 1);
+                ty = std::min(std::max(ty, 0), int32_t(imageHeight) - 1);
+                return float((imagePixels[(imageHeight - 1 - ty) * imageWidth + tx] >> shift) & 0xFF);
+            };
+            for (uint32_t py = 0; py < height; py++) {
+                for (uint32_t px = 0; px < width; px++) {
+                    uint32_t p = pixels[py * width + px];
+                    if (px + 0.5f < x || px + 0.5f >= x + w || py + 0.5f < y || py + 0.5f >= y + h) {
+                        REQUIRE( p == 0 );
+                        continue;
+                    }
+                    float u = (px + 0.5f - x) * imageWidth / w - 0.5f, v = (py + 0.5f - y) * imageHeight / h - 0.5f;
+                    float fu = floorf(u), fv = floorf(v), tu = u - fu, tv = v - fv;
+                    for (uint32_t shift = 0; shift < 32; shift += 8) {
+                        // the image is 0xABGR and the target is 0xARGB.
+                        uint32_t srcShift = (shift == 0) ? 16 : (shift == 16) ? 0 : shift;
+                        int32_t  x0 = int32_t(fu), y0 = int32_t(fv);
+                        float    top = texel(x0, y0, srcShift) * (1 - tu) + texel(x0 + 1, y0, srcShift) * tu;
+                        float    bottom = texel(x0, y0 + 1, srcShift) * (1 - tu) + texel(x0 + 1, y0 + 1, srcShift) * tu;
+                        float    expected = top * (1 - tv) + bottom * tv;
+                        REQUIRE( fabsf(float((p >> shift) & 0xFF) - expected) <= 1.f );
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION( "scaled blits clip the same as they draw" ) {
+        std::vector<uint32_t> imagePixels = randomImage(23, 17);
+        ae::loaded_image_t image = {};
+        image.pixelPointer = imagePixels.data();
+        image.width = 23;
+        image.height = 17;
+        ae::frender::premultiplyAlpha(image);
+        for (auto filter : { ae::frender::IMAGE_FILTER_BILINEAR, ae::frender::IMAGE_FILTER_BICUBIC }) {
+            std::vector<uint32_t> whole(128 * 128, 0xFF102030), clipped(40 * 30, 0xFF102030);
+            ae::frender::backbuffer_t wholeTarget = { whole.data(), 128, 128, sizeof(uint32_t), 128 * 4 };
+            ae::frender::backbuffer_t clippedTarget = { clipped.data(), 40, 30, sizeof(uint32_t), 40 * 4 };
+            ae::frender::drawBitmapScaled(&wholeTarget, image, 30.25f, 40.75f, 61.3f, 37.9f, filter);
+            // the clipped target is the window of the whole one at (50, 55).
+            ae::frender::drawBitmapScaled(&clippedTarget, image, 30.25f - 50.f, 40.75f - 55.f, 61.3f, 37.9f, filter);
+            for (uint32_t y = 0; y < 30; y++) {
+                for (uint32_t x = 0; x < 40; x++) REQUIRE( clipped[y * 40 + x] == whole[(y + 55) * 128 + x + 50] );
+            }
+        }
+    }
+}
+
+TEST_CASE( "fills", "[ae::frender]" ) {
+    utils::SetupTestEngineContext();
+    utils::Seed(__LINE__);
+
+    SECTION( "fills are clipped to the target and leave the padding of the rows" ) {
+        // NOTE: the rows are 5 pixels longer than the target, and the target starts off of a 16 byte boundary.
+        const uint32_t width = 77, height = 41, stride = 82;
+        std::vector<uint32_t> memory(stride * height + 1, 0xDEADBEEF);
+        std::vector<uint32_t> expected = memory;
+        ae::frender::backbuffer_t target = { memory.data() + 1, width, height, sizeof(uint32_t), stride * 4 };
+        for (uint32_t iteration = 0; iteration < 200; iteration++) {
+            int32_t x = (int32_t)utils::RandomUINT32(0, 120) - 30, y = (int32_t)utils::RandomUINT32(0, 70) - 20;
+            int32_t w = (int32_t)utils::RandomUINT32(0, 90), h = (int32_t)utils::RandomUINT32(0, 50);
+            uint32_t color = utils::RandomBits(32);
+            ae::frender::fill(&target, x, y, w, h, color);
+            for (int32_t py = std::max(y, 0); py < std::min(y + h, int32_t(height)); py++) {
+                for (int32_t px = std::max(x, 0); px < std::min(x + w, int32_t(width)); px++)
+                    expected[1 + py * stride + px] = color;
+            }
+            REQUIRE( memory == expected );
+        }
+        ae::frender::clear(&target, 0xFF102030);
+        for (uint32_t y = 0; y < height; y++) std::fill_n(expected.begin() + 1 + y * stride, width, 0xFF102030u);
+        REQUIRE( memory == expected );
+    }
+
+    SECTION( "large clears stream and split across the jobs" ) {
+        const uint32_t width = 1999, height = 1001, stride = 2003;
+        std::vector<uint32_t> memory(stride * height, 0xDEADBEEF);
+        ae::frender::backbuffer_t target = { memory.data(), width, height, sizeof(uint32_t), stride * 4 };
+        ae::frender::clear(&target, 0xFF00FF00);
+        uint32_t wrong = 0;
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < stride; x++)
+                wrong += memory[y * stride + x] != (x < width ? 0xFF00FF00 : 0xDEADBEEF);
+        }
+        REQUIRE( wrong == 0 );
+    }
+}
+
+TEST_CASE( "dirty rects", "[ae::frender]" ) {
+    utils::SetupTestEngineContext();
+    utils::Seed(__LINE__);
+    const uint32_t width = 200, height = 150;
+    std::vector<uint32_t> back(width * height, 0xFF000000), front = back;
+    ae::frender::dirty_rects_t dirty = {};
+    ae::frender::backbuffer_t target = { back.data(), width, height, sizeof(uint32_t), width * 4, &dirty };
+    ae::frender::backbuffer_t window = { front.data(), width, height, sizeof(uint32_t), width * 4 };
+    auto covered = [&](int32_t x, int32_t y) {
+        for (uint32_t i = 0; i < dirty.count; i++) {
+            const ae::frender::dirty_rect_t &r = dirty.rects[i];
+            if (x >= r.x && x < r.x + r.width && y >= r.y && y < r.y + r.height) return true;
+        }
+        return false;
+    };
+
+    SECTION( "rects are clipped and merged" ) {
+        ae::frender::markDirty(&target, -10, -10, 30, 20);
+        REQUIRE( dirty.count == 1 );
+        REQUIRE( dirty.rects[0].x == 0 );
+        REQUIRE( dirty.rects[0].y == 0 );
+        REQUIRE( dirty.rects[0].width == 20 );
+        REQUIRE( dirty.rects[0].height == 10 );
+        // inside the first, then overlapping it by half.
+        ae::frender::markDirty(&target, 5, 2, 4, 4);
+        REQUIRE( dirty.count == 1 );
+        ae::frender::markDirty(&target, 10, 0, 20, 10);
+        REQUIRE( dirty.count == 1 );
+        REQUIRE( dirty.rects[0].width == 30 );
+        // far away, and outside of the target.
+        ae::frender::markDirty(&target, 100, 100, 10, 10);
+        ae::frender::markDirty(&target, 300, 0, 10, 10);
+        REQUIRE( dirty.count == 2 );
+        // a rect that joins both takes them in.
+        ae::frender::markDirty(&target, 0, 0, 120, 120);
+        REQUIRE( dirty.count == 1 );
+    }
+
+    SECTION( "the list is bounded and covers every marked pixel" ) {
+        std::vector<std::array<int32_t, 2>> marked;
+        for (uint32_t i = 0; i < 300; i++) {
+            int32_t x = utils::RandomUINT32(0, width - 1), y = utils::RandomUINT32(0, height - 1);
+            ae::frender::markDirty(&target, x, y, 1, 1);
+            marked.push_back({ x, y });
+            REQUIRE( dirty.count <= ae::frender::DIRTY_RECT_MAX );
+        }
+        for (const auto &pixel : marked) REQUIRE( covered(pixel[0], pixel[1]) );
+    }
+
+    SECTION( "a present of the marked draws matches a present of everything" ) {
+        std::vector<uint32_t> imagePixels(24 * 16);
+        for (uint32_t &p : imagePixels) p = 0x80000000 | utils::RandomBits(24);
+        ae::loaded_image_t image = {};
+        image.pixelPointer = imagePixels.data();
+        image.width = 24;
+        image.height = 16;
+        ae::frender::premultiplyAlpha(image);
+        ae::frender::sprite_batch_t *batch = ae::frender::createSpriteBatch();
+        REQUIRE( ae::frender::presentDirty(&window, target) == 0 );
+        for (uint32_t frame = 0; frame < 20; frame++) {
+            auto x = [&]() { return (int32_t)utils::RandomUINT32(0, width + 40) - 20; };
+            auto y = [&]() { return (int32_t)utils::RandomUINT32(0, height + 40) - 20; };
+            ae::frender::fill(&target, x(), y(), utils::RandomUINT32(0, 30), utils::RandomUINT32(0, 30),
+                0xFF000000 | utils::RandomBits(24));
+            ae::frender::drawBitmap(&target, image, x(), y(), utils::RandomUINT32(1, 3));
+            ae::frender::drawBitmapScaled(&target, image, x() + 0.3f, y() + 0.6f, 37.5f, 11.2f,
+                ae::frender::IMAGE_FILTER_BILINEAR);
+            REQUIRE( ae::frender::beginSprites(batch, target) );
+            ae::frender::pushSprite(batch, image, float(x()), float(y()));
+            ae::frender::pushRect(batch, float(x()), float(y()), 9.f, 13.f, 0x80FF0000);
+            ae::frender::endSprites(batch);
+            uint64_t bytes = ae::frender::presentDirty(&window, target);
+            REQUIRE( bytes < width * height * 4 );
+            REQUIRE( dirty.count == 0 );
+            REQUIRE( front == back );
+        }
+        ae::frender::destroySpriteBatch(batch);
+    }
+}
+
+TEST_CASE( "sprite batches", "[ae::frender]" ) {
+    utils::SetupTestEngineContext();
+    utils::Seed(__LINE__);
+    auto randomImage = [](uint32_t width, uint32_t height) {
+        std::vector<uint32_t> pixels(width * height);
+        for (uint32_t &p : pixels) {
+            uint32_t alpha = utils::RandomUINT32(0, 2);
+            uint32_t a = alpha == 0 ? 0 : alpha == 1 ? 255 : utils::RandomUINT32(0, 255);
+            p = (a << 24) | (utils::RandomUINT32(0, 255) << 16) | (utils::RandomUINT32(0, 255) << 8) |
+                utils::RandomUINT32(0, 255);
+        }
+        return pixels;
+    };
+    auto mul = [](uint32_t a, uint32_t b) { return (2 * a * b + 255) / 510; };
+    // the premultiplied 0xARGB s over d.
+    auto blend = [&](uint32_t s, uint32_t d) {
+        uint32_t result = 0;
+        for (uint32_t shift = 0; shift < 32; shift += 8)
+            result |= std::min(((s >> shift) & 0xFF) + mul((d >> shift) & 0xFF, 255 - (s >> 24)), 255u) << shift;
+        return result;
+    };
+    const uint32_t width = 150, height = 110;
+    ae::frender::sprite_batch_t *batch = ae::frender::createSpriteBatch();
+
+    SECTION( "sprites at 1x match drawBitmap in depth order" ) {
+        std::vector<uint32_t> pixels = randomImage(width, height);
+        for (uint32_t &p : pixels) p |= 0xFF000000;
+        std::vector<uint32_t> expected = pixels;
+        ae::frender::backbuffer_t target = { pixels.data(), width, height, sizeof(uint32_t), width * 4 };
+        ae::frender::backbuffer_t reference = { expected.data(), width, height, sizeof(uint32_t), width * 4 };
+        struct sprite_t {
+            std::vector<uint32_t> pixels;
+            ae::loaded_image_t image;
+            int32_t x, y;
+            float depth;
+        };
+        std::vector<sprite_t> sprites(300);
+        REQUIRE( ae::frender::beginSprites(batch, target) );
+        for (sprite_t &sprite : sprites) {
+            uint32_t w = utils::RandomUINT32(1, 40), h = utils::RandomUINT32(1, 40);
+            sprite.pixels = randomImage(w, h);
+            sprite.image = {};
+            sprite.image.pixelPointer = sprite.pixels.data();
+            sprite.image.width = w;
+            sprite.image.height = h;
+            ae::frender::premultiplyAlpha(sprite.image);
+            sprite.x = (int32_t)utils::RandomUINT32(0, 200) - 40;
+            sprite.y = (int32_t)utils::RandomUINT32(0, 160) - 40;
+            sprite.depth = float(utils::RandomUINT32(0, 4));
+            ae::frender::pushSprite(batch, sprite.image, float(sprite.x), float(sprite.y), 0xFFFFFFFF, sprite.depth);
+        }
+        ae::frender::endSprites(batch);
+        std::stable_sort(sprites.begin(), sprites.end(), [](const sprite_t &a, const sprite_t &b) {
+            return a.depth > b.depth;
+        });
+        for (const sprite_t &sprite : sprites) ae::frender::drawBitmap(&reference, sprite.image, sprite.x, sprite.y);
+        REQUIRE( pixels == expected );
+    }
+
+    SECTION( "atlas regions, scaling, flips and tints match a reference" ) {
+        std::vector<uint32_t> atlasPixels = randomImage(64, 64);
+        ae::loaded_image_t atlas = {};
+        atlas.pixelPointer = atlasPixels.data();
+        atlas.width = atlas.height = 64;
+        ae::frender::premultiplyAlpha(atlas);
+        for (uint32_t iteration = 0; iteration < 20; iteration++) {
+            std::vector<uint32_t> pixels(width * height, 0xFF405060), expected = pixels;
+            ae::frender::backbuffer_t target = { pixels.data(), width, height, sizeof(uint32_t), width * 4 };
+            REQUIRE( ae::frender::beginSprites(batch, target) );
+            for (uint32_t i = 0; i < 20; i++) {
+                int32_t rx = utils::RandomUINT32(0, 48), ry = utils::RandomUINT32(0, 48);
+                int32_t rw = utils::RandomUINT32(1, 16), rh = utils::RandomUINT32(1, 16);
+                int32_t sx = utils::RandomUINT32(1, 3), sy = utils::RandomUINT32(1, 3);
+                int32_t x = (int32_t)utils::RandomUINT32(0, 180) - 30, y = (int32_t)utils::RandomUINT32(0, 140) - 30;
+                bool bFlip = utils::RandomUINT32(0, 1);
+                uint32_t tint = utils::RandomUINT32(0, 1) ? 0xFFFFFFFF
+                                                          : (utils::RandomUINT32(1, 255) << 24) | utils::RandomBits(24);
+                ae::frender::sprite_quad_t quad = {};
+                quad.image = &atlas;
+                quad.x = float(x);
+                quad.y = float(y);
+                quad.width = float(rw * sx);
+                quad.height = float(rh * sy);
+                quad.u0 = (bFlip ? rx + rw : rx) / 64.f;
+                quad.u1 = (bFlip ? rx : rx + rw) / 64.f;
+                quad.v0 = ry / 64.f;
+                quad.v1 = (ry + rh) / 64.f;
+                quad.tint = tint;
+                ae::frender::pushQuad(batch, quad);
+
+                uint32_t premultipliedTint = tint & 0xFF000000;
+                for (uint32_t shift = 0; shift < 24; shift += 8)
+                    premultipliedTint |= mul((tint >> shift) & 0xFF, tint >> 24) << shift;
+                for (int32_t py = std::max(y, 0); py < std::min(y + rh * sy, int32_t(height)); py++) {
+                    for (int32_t px = std::max(x, 0); px < std::min(x + rw * sx, int32_t(width)); px++) {
+                        int32_t tx = bFlip ? rx + rw - 1 - (px - x) / sx : rx + (px - x) / sx;
+                        int32_t ty = ry + (py - y) / sy;
+                        uint32_t s = atlasPixels[(63 - ty) * 64 + tx], texel = 0;
+                        s = (s & 0xFF00FF00) | ((s >> 16) & 0xFF) | ((s & 0xFF) << 16);
+                        for (uint32_t shift = 0; shift < 32; shift += 8)
+                            texel |= mul((s >> shift) & 0xFF, (premultipliedTint >> shift) & 0xFF) << shift;
+                        expected[py * width + px] = blend(texel, expected[py * width + px]);
+                    }
+                }
+            }
+            ae::frender::endSprites(batch);
+            REQUIRE( pixels == expected );
+        }
+    }
+
+    SECTION( "rects cover the pixel centers and are drawn back to front" ) {
+        std::vector<uint32_t> pixels(width * height, 0xFF000000);
+        ae::frender::backbuffer_t target = { pixels.data(), width, height, sizeof(uint32_t), width * 4 };
+        REQUIRE( ae::frender::beginSprites(batch, target) );
+        ae::frender::pushRect(batch, 10.3f, 20.6f, 80.4f, 70.1f, 0xFFFF0000, 0.f);
+        ae::frender::pushRect(batch, 50.f, -10.f, 200.f, 60.f, 0x800000FF, 1.f);
+        ae::frender::endSprites(batch);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                bool bRed = x + 0.5f >= 10.3f && x + 0.5f < 90.7f && y + 0.5f >= 20.6f && y + 0.5f < 90.7f;
+                bool bBlue = x >= 50 && y < 50;
+                uint32_t expected = bRed ? 0xFFFF0000 : 0xFF000000;
+                // the blue is deeper, so it is under the red.
+                if (bBlue && !bRed) expected = blend(0x80000080, expected);
+                REQUIRE( pixels[y * width + x] == expected );
+            }
+        }
+    }
+
+    ae::frender::destroySpriteBatch(batch);
+}
+
+TEST_CASE( "path tracer", "[ae::frender]" ) {
+    utils::SetupTestEngineContext();
+    utils::Seed(__LINE__);
+    // the channel that a linear value resolves to, up to the rounding of the sRGB table.
+    auto srgb = [](float c) {
+        c = std::min(std::max(c, 0.f), 1.f);
+        c = (c <= 0.0031308f) ? c * 12.92f : 1.055f * powf(c, 1.f / 2.4f) - 0.055f;
+        return (int32_t)(c * 255.f + 0.5f);
+    };
+    auto near = [&](uint32_t pixel, ae::math::vec3_t color) {
+        return abs(int32_t((pixel >> 16) & 0xFF) - srgb(color.x)) <= 1 &&
+               abs(int32_t((pixel >> 8) & 0xFF) - srgb(color.y)) <= 1 &&
+               abs(int32_t(pixel & 0xFF) - srgb(color.z)) <= 1;
+    };
+    ae::math::mat4_t identity = {};
+    // a floor of y = 0 and a camera at y = 1 looking down -Z, so that the floor fills the lower half of the image.
+    ae::raw_model_t floor = utils::MakeModel({ {-1000, 0, 1000, 0, 0, 0, 1, 0}, {1000, 0, 1000, 0, 0, 0, 1, 0},
+        {1000, 0, -1000, 0, 0, 0, 1, 0}, {-1000, 0, -1000, 0, 0, 0, 1, 0} }, { 0, 1, 2, 0, 2, 3 });
+    ae::math::camera_t cam = {};
+    cam.trans.pos = { 0, 1, 0 };
+    cam.trans.scale = { 1, 1, 1 };
+    cam.fov = 90.f;
+    cam.width = cam.height = 32;
+    std::vector<uint32_t> pixels(32 * 32, 0);
+    ae::frender::backbuffer_t target = { pixels.data(), 32, 32, sizeof(uint32_t), 32 * sizeof(uint32_t) };
+    ae::frender::path_tracer_t *tracer = ae::frender::createPathTracer();
+
+    // the closest of a list of triangles along a ray, by brute force.
+    std::vector<std::array<ae::math::vec3_t, 3>> soup;
+    auto closestTriangle = [&](ae::math::vec3_t origin, ae::math::vec3_t dir, float *pT) {
+        int32_t closest = -1;
+        *pT = FLT_MAX;
+        for (uint32_t i = 0; i < soup.size(); i++) {
+            ae::math::vec3_t e1 = soup[i][1] - soup[i][0], e2 = soup[i][2] - soup[i][0];
+            ae::math::vec3_t p = ae::math::cross(dir, e2);
+            float det = ae::math::dot(e1, p);
+            if (fabsf(det) < 1e-12f) continue;
+            ae::math::vec3_t tv = origin - soup[i][0], q = ae::math::cross(tv, e1);
+            float u = ae::math::dot(tv, p) / det, v = ae::math::dot(dir, q) / det, t = ae::math::dot(e2, q) / det;
+            if (u >= 0 && v >= 0 && u + v <= 1 && t > 0 && t < *pT) {
+                *pT = t;
+                closest = int32_t(i);
+            }
+        }
+        return closest;
+    };
+    // add the triangles of the soup to the tracer, each as its own model.
+    auto addSoup = [&](const std::vector<ae::math::vec3_t> &emission) {
+        for (uint32_t i = 0; i < soup.size(); i++) {
+            const auto &v = soup[i];
+            ae::raw_model_t model = utils::MakeModel({ {v[0].x, v[0].y, v[0].z, 0, 0, 0, 0, 0},
+                {v[1].x, v[1].y, v[1].z, 0, 0, 0, 0, 0}, {v[2].x, v[2].y, v[2].z, 0, 0, 0, 0, 0} }, { 0, 1, 2 });
+            ae::frender::path_material_t material = {};
+            if (!emission.empty()) material.emission = emission[i];
+            ae::frender::addPathModel(tracer, model, identity, material);
+            utils::FreeModel(model);
+        }
+    };
+
+    SECTION( "the BVH finds the same hits as brute force" ) {
+        soup.resize(3000);
+        for (auto &triangle : soup) {
+            ae::math::vec3_t center = { utils::RandomFloat(-10, 10), utils::RandomFloat(-10, 10),
+                utils::RandomFloat(-10, 10) };
+            for (auto &v : triangle) {
+                v = { center.x + utils::RandomFloat(-1, 1), center.y + utils::RandomFloat(-1, 1),
+                    center.z + utils::RandomFloat(-1, 1) };
+            }
+        }
+        addSoup({});
+        uint32_t hits = 0;
+        for (uint32_t i = 0; i < 2000; i++) {
+            ae::math::vec3_t origin = { utils::RandomFloat(-15, 15), utils::RandomFloat(-15, 15),
+                utils::RandomFloat(-15, 15) };
+            ae::math::vec3_t dir = ae::math::normalize(ae::math::vec3_t(utils::RandomFloat(-1, 1),
+                utils::RandomFloat(-1, 1), utils::RandomFloat(-1, 1)));
+            float closest, t = FLT_MAX;
+            bool bExpected = closestTriangle(origin, dir, &closest) >= 0;
+            bool bHit = ae::frender::intersectPath(tracer, origin, dir, &t);
+            REQUIRE( bHit == bExpected );
+            if (bHit) REQUIRE( t == Approx(closest).epsilon(1e-4) );
+            hits += bHit;
+        }
+        REQUIRE( hits > 200 );
+    }
+
+    SECTION( "packets of primary rays see the same triangles as brute force" ) {
+        // emissive triangles of distinct colors in front of a black sky, without bounces.
+        soup.resize(60);
+        std::vector<ae::math::vec3_t> colors(soup.size());
+        for (uint32_t i = 0; i < soup.size(); i++) {
+            float x = utils::RandomFloat(-4, 4), y = utils::RandomFloat(-3, 5), z = utils::RandomFloat(-12, -4);
+            soup[i] = { ae::math::vec3_t(x - 1.5f, y - 1, z), ae::math::vec3_t(x + 1.5f, y - 1, z + 1),
+                ae::math::vec3_t(x, y + 1.5f, z - 1) };
+            colors[i] = { (i % 4 + 1) / 4.f, (i / 4 % 4 + 1) / 4.f, (i / 16 + 1) / 4.f };
+        }
+        addSoup(colors);
+        ae::frender::path_settings_t settings = {};
+        settings.maxBounces = 0;
+        settings.skyColor = { 0, 0, 0 };
+        REQUIRE( ae::frender::renderPath(tracer, &target, cam, settings) );
+
+        // a pixel that a grid of rays over it sees a single triangle (or only the sky) in is of its color.
+        uint32_t checked = 0;
+        for (uint32_t y = 0; y < 32; y++) {
+            for (uint32_t x = 0; x < 32; x++) {
+                bool bUniform = true;
+                int32_t triangle = -2;
+                for (uint32_t i = 0; i < 81 && bUniform; i++) {
+                    float t, px = x + (i % 9) / 8.f, py = y + (i / 9) / 8.f;
+                    int32_t seen = closestTriangle(cam.trans.pos,
+                        ae::math::normalize(ae::math::vec3_t(px / 16.f - 1.f, 1.f - py / 16.f, -1.f)), &t);
+                    bUniform = (triangle == -2 || triangle == seen);
+                    triangle = seen;
+                }
+                if (!bUniform) continue;
+                REQUIRE( near(pixels[y * 32 + x], triangle < 0 ? ae::math::vec3_t(0, 0, 0) : colors[triangle]) );
+                checked += triangle >= 0;
+            }
+        }
+        REQUIRE( checked > 100 );
+    }
+
+    SECTION( "a floor lit by the sun" ) {
+        ae::frender::path_material_t material = {};
+        material.albedo = { 0.5f, 0.25f, 0.125f };
+        ae::frender::addPathModel(tracer, floor, identity, material);
+        ae::frender::path_settings_t settings = {};
+        settings.skyColor = { 0, 0, 0 };
+        settings.sunColor = { 1, 1, 1 };
+        settings.sunDirection = { 0, 2, 0 };
+        settings.maxBounces = 1;
+        REQUIRE( ae::frender::renderPath(tracer, &target, cam, settings) );
+        for (uint32_t y = 0; y < 32; y++) {
+            for (uint32_t x = 0; x < 32; x++) {
+                // NOTE: the samples of the row below the horizon that are nearly level pass the end of the floor.
+                if (y == 16) continue;
+                ae::math::vec3_t expected = (y > 16) ? material.albedo : ae::math::vec3_t(0, 0, 0);
+                REQUIRE( near(pixels[y * 32 + x], expected) );
+                REQUIRE( (pixels[y * 32 + x] >> 24) == 0xFF );
+            }
+        }
+        // at an angle, the light falls off with the cosine. and the samples of a second frame do not change it.
+        settings.sunDirection = { 0, 1, 1 };
+        REQUIRE( ae::frender::renderPath(tracer, &target, cam, settings) );
+        REQUIRE( ae::frender::renderPath(tracer, &target, cam, settings) );
+        REQUIRE( near(pixels[24 * 32 + 16], material.albedo * sqrtf(0.5f)) );
+
+        // a roof far above blocks the sun, and its underside is dark.
+        ae::raw_model_t roof = utils::MakeModel({ {-1000, 10, 1000, 0, 0, 0, -1, 0}, {1000, 10, 1000, 0, 0, 0, -1, 0},
+            {1000, 10, -1000, 0, 0, 0, -1, 0}, {-1000, 10, -1000, 0, 0, 0, -1, 0} }, { 0, 2, 1, 0, 3, 2 });
+        ae::frender::addPathModel(tracer, roof, identity, material);
+        REQUIRE( ae::frender::renderPath(tracer, &target, cam, settings) );
+        for (uint32_t pixel : pixels) REQUIRE( pixel == 0xFF000000 );
+        REQUIRE( ae::frender::getPathStats(tracer).triangles == 4 );
+        utils::FreeModel(roof);
+    }
+
+    SECTION( "the sky, emission and mirrors" ) {
+        ae::frender::path_settings_t settings = {};
+        settings.skyColor = { 0.1f, 0.4f, 0.8f };
+        REQUIRE( ae::frender::renderPath(tracer, &target, cam, settings) );
+        for (uint32_t pixel : pixels) REQUIRE( near(pixel, settings.skyColor) );
+
+        // an emissive floor that reflects nothing.
+        ae::frender::path_material_t material = {};
+        material.albedo = { 0, 0, 0 };
+        material.emission = { 0.3f, 0.2f, 0.1f };
+        ae::frender::addPathModel(tracer, floor, identity, material);
+        REQUIRE( ae::frender::renderPath(tracer, &target, cam, settings) );
+        REQUIRE( near(pixels[0], settings.skyColor) );
+        REQUIRE( near(pixels[31 * 32 + 31], material.emission) );
+
+        // a mirror floor shows the sky, tinted by its albedo.
+        ae::frender::clearPathScene(tracer);
+        material = {};
+        material.albedo = { 0.5f, 0.5f, 0.5f };
+        material.reflectivity = 1.f;
+        ae::frender::addPathModel(tracer, floor, identity, material);
+        REQUIRE( ae::frender::renderPath(tracer, &target, cam, settings) );
+        REQUIRE( near(pixels[0], settings.skyColor) );
+        REQUIRE( near(pixels[31 * 32 + 31], settings.skyColor * 0.5f) );
+    }
+
+    SECTION( "samples accumulate until the camera, settings or scene change" ) {
+        ae::frender::addPathModel(tracer, floor, identity, {});
+        ae::frender::path_settings_t settings = {};
+        settings.samplesPerPixel = 2;
+        auto samples = [&]() {
+            REQUIRE( ae::frender::renderPath(tracer, &target, cam, settings) );
+            return ae::frender::getPathStats(tracer).accumulatedSamples;
+        };
+        REQUIRE( samples() == 2 );
+        REQUIRE( samples() == 4 );
+        settings.exposure = 2.f;
+        REQUIRE( samples() == 6 );
+        ae::frender::path_stats_t stats = ae::frender::getPathStats(tracer);
+        REQUIRE( stats.triangles == 2 );
+        REQUIRE( stats.samples == 32 * 32 * 2 );
+        REQUIRE( stats.rays >= stats.samples );
+
+        cam.trans.pos.x += 0.01f;
+        REQUIRE( samples() == 2 );
+        cam.trans.eulerAngles.y += 0.01f;
+        REQUIRE( samples() == 2 );
+        settings.sunColor = { 1, 1, 1 };
+        REQUIRE( samples() == 2 );
+        REQUIRE( samples() == 4 );
+        ae::frender::addPathModel(tracer, floor, identity, {});
+        REQUIRE( samples() == 2 );
+        ae::frender::resetPathAccumulation(tracer);
+        REQUIRE( samples() == 2 );
+    }
+
+    SECTION( "the image does not depend on the threads" ) {
+        ae::frender::path_material_t material = {};
+        material.reflectivity = 0.3f;
+        ae::frender::addPathModel(tracer, floor, identity, material);
+        ae::frender::path_settings_t settings = {};
+        settings.sunColor = { 2, 2, 2 };
+        settings.sunDirection = { 0.3f, 1, 0.2f };
+        cam.trans.eulerAngles = { -0.3f, 0.2f, 0 };
+        REQUIRE( ae::frender::renderPath(tracer, &target, cam, settings) );
+        REQUIRE( ae::frender::renderPath(tracer, &target, cam, settings) );
+        std::vector<uint32_t> first = pixels;
+
+        ae::frender::path_tracer_t *other = ae::frender::createPathTracer();
+        ae::frender::addPathModel(other, floor, identity, material);
+        std::vector<uint32_t> otherPixels(32 * 32);
+        ae::frender::backbuffer_t otherTarget = { otherPixels.data(), 32, 32, sizeof(uint32_t), 32 * sizeof(uint32_t) };
+        REQUIRE( ae::frender::renderPath(other, &otherTarget, cam, settings) );
+        REQUIRE( ae::frender::renderPath(other, &otherTarget, cam, settings) );
+        REQUIRE( otherPixels == first );
+        ae::frender::destroyPathTracer(other);
+    }
+
+    ae::frender::destroyPathTracer(tracer);
+    utils::FreeModel(floor);
+}
+
+TEST_CASE( "glyph cache", "[ae::frender]" ) {
+    utils::SetupTestEngineContext();
+    // the font that ships with the engine, found from the path of this file.
+    std::string fontPath = __FILE__;
+    fontPath = fontPath.substr(0, fontPath.find_last_of("/\\") + 1) +
+               "../../external/ProggyVector/ProggyVector Regular.ttf";
+    ae::frender::glyph_cache_t *cache = ae::frender::createGlyphCache();
+    REQUIRE( cache );
+    ae::frender::font_t *font = ae::frender::loadFont(cache, fontPath.c_str());
+    REQUIRE( font );
+    REQUIRE( ae::frender::loadFont(cache, "not a font.ttf") == nullptr );
+
+    std::vector<uint32_t> pixels(200 * 100, 0xFF000000);
+    ae::frender::backbuffer_t target = { pixels.data(), 200, 100, sizeof(uint32_t), 200 * sizeof(uint32_t) };
+    auto clearTarget = [&]() { std::fill(pixels.begin(), pixels.end(), 0xFF000000); };
+
+    SECTION( "repeated strings cost only blits" ) {
+        ae::frender::drawText(cache, &target, font, 16, 10, 10, "Hello, world!", 0xFFFFFFFF);
+        ae::frender::glyph_cache_stats_t stats = ae::frender::getGlyphCacheStats(cache);
+        REQUIRE( stats.rasterized == 10 );  // H e l o , space w r d !
+        REQUIRE( stats.hits == 3 );
+        REQUIRE( stats.glyphs == 10 );
+        std::vector<uint32_t> first = pixels;
+        REQUIRE( std::count(first.begin(), first.end(), 0xFF000000) < (int)first.size() );
+
+        clearTarget();
+        ae::frender::drawText(cache, &target, font, 16, 10, 10, "Hello, world!", 0xFFFFFFFF);
+        REQUIRE( ae::frender::getGlyphCacheStats(cache).rasterized == 10 );
+        REQUIRE( ae::frender::getGlyphCacheStats(cache).hits == 3 + 13 );
+        REQUIRE( pixels == first );
+        // another size is another glyph.
+        ae::frender::drawText(cache, &target, font, 17, 10, 40, "H", 0xFFFFFFFF);
+        REQUIRE( ae::frender::getGlyphCacheStats(cache).rasterized == 11 );
+    }
+
+    SECTION( "coverage blends match a scalar reference" ) {
+        // white on black gives the coverage of each pixel. the glyphs of the string do not overlap.
+        const char *text = "Hxg 0123 @#";
+        ae::frender::drawText(cache, &target, font, 24, 7.3f, 20, text, 0xFFFFFFFF);
+        std::vector<uint32_t> coverage = pixels;
+        uint32_t partial = 0;
+        for (uint32_t pixel : coverage) {
+            uint32_t c = pixel & 0xFF;
+            REQUIRE( ((pixel >> 8) & 0xFF) == c );
+            REQUIRE( ((pixel >> 16) & 0xFF) == c );
+            partial += c > 0 && c < 255;
+        }
+        REQUIRE( partial > 50 );
+
+        const uint32_t background = 0xFF4080C0, color = 0x80F06010;
+        std::fill(pixels.begin(), pixels.end(), background);
+        ae::frender::drawText(cache, &target, font, 24, 7.3f, 20, text, color);
+        auto div255 = [](uint32_t x) { return (x + 128) * 257 >> 16; };
+        uint32_t a = color >> 24, src[4];
+        for (uint32_t k = 0; k < 4; k++) src[k] = (k == 3) ? a : (((color >> (k * 8)) & 0xFF) * a + 127) / 255;
+        for (uint32_t i = 0; i < pixels.size(); i++) {
+            uint32_t c = coverage[i] & 0xFF, covered[4], expected = 0;
+            for (uint32_t k = 0; k < 4; k++) covered[k] = div255(src[k] * c);
+            for (uint32_t k = 0; k < 4; k++) {
+                uint32_t d = (background >> (k * 8)) & 0xFF;
+                expected |= (c ? covered[k] + div255(d * (255 - covered[3])) : d) << (k * 8);
+            }
+            REQUIRE( pixels[i] == expected );
+        }
+    }
+
+    SECTION( "strings are laid out in lines" ) {
+        ae::frender::text_metrics_t metrics = ae::frender::measureText(cache, font, 16, "abc\nabcdef\n");
+        REQUIRE( metrics.lines == 3 );
+        REQUIRE( metrics.height == Approx(metrics.ascent + metrics.descent + 2 * metrics.lineHeight) );
+        ae::frender::text_metrics_t longest = ae::frender::measureText(cache, font, 16, "abcdef");
+        REQUIRE( longest.lines == 1 );
+        REQUIRE( longest.height == Approx(longest.ascent + longest.descent) );
+        REQUIRE( metrics.width == longest.width );
+        REQUIRE( ae::frender::measureText(cache, font, 16, "abc").width < longest.width );
+        REQUIRE( ae::frender::measureText(cache, font, 16, "").width == 0 );
+
+        // the drawn pixels are within the measured box, and each line starts at x.
+        const float x = 20, y = 15;
+        ae::frender::drawText(cache, &target, font, 16, x, y, "abc\nabcdef\n", 0xFFFFFFFF);
+        uint32_t minX = 200, minY = 100, maxX = 0, maxY = 0;
+        for (uint32_t py = 0; py < 100; py++) {
+            for (uint32_t px = 0; px < 200; px++) {
+                if (pixels[py * 200 + px] == 0xFF000000) continue;
+                minX = std::min(minX, px);
+                minY = std::min(minY, py);
+                maxX = std::max(maxX, px + 1);
+                maxY = std::max(maxY, py + 1);
+            }
+        }
+        REQUIRE( minX >= x - 1 );
+        REQUIRE( minY >= y );
+        REQUIRE( maxX <= x + metrics.width + 1 );
+        REQUIRE( maxY <= y + metrics.height - metrics.lineHeight + 1 );
+        REQUIRE( maxY > y + metrics.lineHeight );
+    }
+
+    SECTION( "malformed UTF-8 draws as U+FFFD" ) {
+        ae::frender::drawText(cache, &target, font, 20, 10, 10, "a\xFF" "b", 0xFFFFFFFF);
+        std::vector<uint32_t> malformed = pixels;
+        clearTarget();
+        ae::frender::drawText(cache, &target, font, 20, 10, 10, "a\xEF\xBF\xBD" "b", 0xFFFFFFFF);
+        REQUIRE( pixels == malformed );
+    }
+
+    SECTION( "a full atlas is emptied and refilled" ) {
+        // the same strings through the smallest atlas, which fills up many times in the one batch.
+        ae::frender::glyph_cache_t *small = ae::frender::createGlyphCache(64);
+        ae::frender::font_t *smallFont = ae::frender::loadFont(small, fontPath.c_str());
+        std::vector<std::string> strings;
+        std::vector<ae::frender::text_draw_t> draws, smallDraws;
+        for (uint32_t i = 0; i < 24; i++) {
+            std::string s;
+            for (uint32_t k = 0; k < 12; k++) s += char('!' + (i * 7 + k * 13) % 94);
+            strings.push_back(s);
+        }
+        for (uint32_t i = 0; i < 24; i++) {
+            ae::frender::text_draw_t draw = { font, 10 + i, float(i % 3) * 60.f, float(i % 8) * 11.f,
+                strings[i].c_str(), 0xC0FFFFFF - i * 0x050301 };
+            draws.push_back(draw);
+            draw.font = smallFont;
+            smallDraws.push_back(draw);
+        }
+        ae::frender::drawTexts(cache, &target, draws.data(), uint32_t(draws.size()));
+        std::vector<uint32_t> expected = pixels;
+        clearTarget();
+        ae::frender::drawTexts(small, &target, smallDraws.data(), uint32_t(smallDraws.size()));
+        REQUIRE( ae::frender::getGlyphCacheStats(cache).atlasResets == 0 );
+        REQUIRE( ae::frender::getGlyphCacheStats(small).atlasResets > 2 );
+        REQUIRE( pixels == expected );
+        ae::frender::destroyGlyphCache(small);
+    }
+
+    SECTION( "text marks what it draws" ) {
+        ae::frender::dirty_rects_t dirty = {};
+        target.dirty = &dirty;
+        ae::frender::drawText(cache, &target, font, 16, 150, 80, "clipped at the edge", 0xFFFFFFFF);
+        REQUIRE( dirty.count == 1 );
+        const ae::frender::dirty_rect_t &rect = dirty.rects[0];
+        for (uint32_t py = 0; py < 100; py++) {
+            for (uint32_t px = 0; px < 200; px++) {
+                bool bInside = int32_t(px) >= rect.x && int32_t(px) < rect.x + rect.width && int32_t(py) >= rect.y &&
+                               int32_t(py) < rect.y + rect.height;
+                if (!bInside) REQUIRE( pixels[py * 200 + px] == 0xFF000000 );
+            }
+        }
+        REQUIRE( rect.x + rect.width == 200 );
+    }
+
+    ae::frender::destroyGlyphCache(cache);
+}
+
+TEST_CASE( "ui renderer", "[ae::frender]" ) {
+    utils::SetupTestEngineContext();
+    utils::Seed(__LINE__);
+    const uint32_t width = 160, height = 120;
+    std::vector<uint32_t> pixels(width * height, 0xFF000000);
+    ae::frender::backbuffer_t target = { pixels.data(), width, height, sizeof(uint32_t), width * 4 };
+    ae::frender::ui_renderer_t *renderer = ae::frender::createUiRenderer();
+
+    // a frame of one draw list, as ImGui would give it.
+    std::vector<ae::frender::ui_vertex_t> vertices;
+    std::vector<uint16_t> indices;
+    std::vector<ae::frender::ui_command_t> commands;
+    ae::frender::ui_draw_data_t data = {};
+    auto command = [&](const ae::loaded_image_t *texture = nullptr, float minX = -1e6f, float minY = -1e6f,
+                       float maxX = 1e6f, float maxY = 1e6f) {
+        commands.push_back({ minX, minY, maxX, maxY, texture, 0, uint32_t(indices.size()), 0 });
+    };
+    auto vertex = [&](float x, float y, float u, float v, uint32_t color) {
+        vertices.push_back({ x, y, u, v, color });
+        return uint16_t(vertices.size() - 1);
+    };
+    auto triangle = [&](uint16_t a, uint16_t b, uint16_t c) {
+        indices.insert(indices.end(), { a, b, c });
+        commands.back().indexCount += 3;
+    };
+    // as ImGui::PrimRectUV does, unless bAsRect is false, which orders the triangles so that it is not seen as one.
+    auto quad = [&](float x, float y, float w, float h, uint32_t color, bool bAsRect = true, float u0 = 0.f,
+                    float v0 = 0.f, float u1 = 0.f, float v1 = 0.f) {
+        uint16_t a = vertex(x, y, u0, v0, color), b = vertex(x + w, y, u1, v0, color);
+        uint16_t c = vertex(x + w, y + h, u1, v1, color), d = vertex(x, y + h, u0, v1, color);
+        triangle(a, b, c);
+        if (bAsRect) triangle(a, c, d);
+        else triangle(c, d, a);
+    };
+    auto render = [&](ae::frender::backbuffer_t *pTarget) {
+        ae::frender::ui_draw_list_t list = { vertices.data(), uint32_t(vertices.size()), indices.data(),
+            uint32_t(indices.size()), commands.data(), uint32_t(commands.size()) };
+        data.lists = &list;
+        data.listCount = 1;
+        return ae::frender::renderUi(renderer, pTarget, data);
+    };
+    auto mul = [](uint32_t a, uint32_t b) { return (2 * a * b + 255) / 510; };
+    // the premultiplied 0xARGB s over d.
+    auto blend = [&](uint32_t s, uint32_t d) {
+        uint32_t result = 0;
+        for (uint32_t shift = 0; shift < 32; shift += 8)
+            result |= std::min(((s >> shift) & 0xFF) + mul((d >> shift) & 0xFF, 255 - (s >> 24)), 255u) << shift;
+        return result;
+    };
+    auto randomColor = [](uint32_t alphaMin) {
+        return (utils::RandomUINT32(alphaMin, 255) << 24) | utils::RandomBits(24);
+    };
+
+    SECTION( "axis aligned quads draw the same as their triangles" ) {
+        for (uint32_t n = 0; n < 4; n++) {
+            command(nullptr, float(utils::RandomUINT32(0, 40)), float(utils::RandomUINT32(0, 40)),
+                float(utils::RandomUINT32(80, 170)), float(utils::RandomUINT32(60, 130)));
+            for (uint32_t i = 0; i < 80; i++) {
+                float x = utils::RandomUINT32(0, 3400) / 16.f - 20.f, y = utils::RandomUINT32(0, 2600) / 16.f - 20.f;
+                float w = utils::RandomUINT32(1, 800) / 17.f, h = utils::RandomUINT32(1, 800) / 17.f;
+                quad(x, y, w, h, randomColor(0));
+            }
+        }
+        REQUIRE( render(&target) );
+        ae::frender::ui_stats_t stats = ae::frender::getUiStats(renderer);
+        REQUIRE( stats.rects == 320 );
+        REQUIRE( stats.triangles == 0 );
+        std::vector<uint32_t> rects = pixels;
+        REQUIRE( std::count(rects.begin(), rects.end(), 0xFF000000) < int(rects.size()) );
+
+        // the same quads, split the other way round.
+        for (uint32_t i = 0; i < indices.size(); i += 6) {
+            std::swap(indices[i + 3], indices[i + 4]);
+            std::swap(indices[i + 3], indices[i + 5]);
+        }
+        std::fill(pixels.begin(), pixels.end(), 0xFF000000);
+        REQUIRE( render(&target) );
+        REQUIRE( ae::frender::getUiStats(renderer).rects == 0 );
+        REQUIRE( ae::frender::getUiStats(renderer).triangles + ae::frender::getUiStats(renderer).culled == 640 );
+        REQUIRE( pixels == rects );
+    }
+
+    SECTION( "a mesh covers each pixel once" ) {
+        // a grid of cells whose inner vertices are jittered, so that the edges are shared at every angle.
+        const uint32_t cols = 9, rows = 7;
+        const float left = 3.25f, top = 5.5f, cellW = 16.5f, cellH = 15.75f;
+        command();
+        for (uint32_t y = 0; y <= rows; y++) {
+            for (uint32_t x = 0; x <= cols; x++) {
+                bool bInner = x > 0 && x < cols && y > 0 && y < rows;
+                float jx = bInner ? utils::RandomFloat(-0.25f, 0.25f) * cellW : 0.f;
+                float jy = bInner ? utils::RandomFloat(-0.25f, 0.25f) * cellH : 0.f;
+                vertex(left + x * cellW + jx, top + y * cellH + jy, 0, 0, 0x80FFFFFF);
+            }
+        }
+        for (uint32_t y = 0; y < rows; y++) {
+            for (uint32_t x = 0; x < cols; x++) {
+                uint16_t a = uint16_t(y * (cols + 1) + x), b = uint16_t(a + 1);
+                uint16_t d = uint16_t(a + cols + 1), c = uint16_t(d + 1);
+                // either diagonal, wound either way.
+                uint16_t t[6] = { a, b, c, c, d, a };
+                if (utils::RandomUINT32(0, 1)) {
+                    uint16_t other[6] = { b, c, d, d, a, b };
+                    std::copy(other, other + 6, t);
+                }
+                if (utils::RandomUINT32(0, 1)) {
+                    std::swap(t[1], t[2]);
+                    std::swap(t[4], t[5]);
+                }
+                triangle(t[0], t[1], t[2]);
+                triangle(t[3], t[4], t[5]);
+            }
+        }
+        REQUIRE( render(&target) );
+        REQUIRE( ae::frender::getUiStats(renderer).triangles == cols * rows * 2 );
+        const uint32_t once = blend(0x80808080, 0xFF000000);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                float cx = x + 0.5f, cy = y + 0.5f;
+                bool bInside = cx >= left && cx < left + cols * cellW && cy >= top && cy < top + rows * cellH;
+                REQUIRE( pixels[y * width + x] == (bInside ? once : 0xFF000000) );
+            }
+        }
+    }
+
+    SECTION( "triangles cover the pixels whose centers are inside of them" ) {
+        uint32_t wrong = 0;
+        for (uint32_t n = 0; n < 100; n++) {
+            vertices.clear();
+            indices.clear();
+            commands.clear();
+            std::fill(pixels.begin(), pixels.end(), 0xFF000000);
+            float x[3], y[3];
+            for (uint32_t k = 0; k < 3; k++) {
+                x[k] = utils::RandomFloat(-20.f, width + 20.f);
+                y[k] = utils::RandomFloat(-20.f, height + 20.f);
+            }
+            command();
+            triangle(vertex(x[0], y[0], 0, 0, 0xFFFFFFFF), vertex(x[1], y[1], 0, 0, 0xFFFFFFFF),
+                vertex(x[2], y[2], 0, 0, 0xFFFFFFFF));
+            REQUIRE( render(&target) );
+            float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+            if (fabsf(area) < 1.f) continue;
+            for (uint32_t py = 0; py < height; py++) {
+                for (uint32_t px = 0; px < width; px++) {
+                    // the distance of the center inside of the nearest edge, where the snapping cannot change it.
+                    float inside = FLT_MAX;
+                    for (uint32_t k = 0; k < 3; k++) {
+                        uint32_t j = (k + 1) % 3;
+                        float ex = x[j] - x[k], ey = y[j] - y[k];
+                        float e = (ex * (py + 0.5f - y[k]) - ey * (px + 0.5f - x[k])) / sqrtf(ex * ex + ey * ey);
+                        inside = std::min(inside, area > 0 ? e : -e);
+                    }
+                    wrong += inside > 0.1f && pixels[py * width + px] != 0xFFFFFFFF;
+                    wrong += inside < -0.1f && pixels[py * width + px] != 0xFF000000;
+                }
+            }
+        }
+        REQUIRE( wrong == 0 );
+    }
+
+    SECTION( "clip rects are in display units" ) {
+        data.displayX = 100.f;
+        data.displayY = 50.f;
+        data.scaleX = 2.f;
+        data.scaleY = 2.f;
+        // the display is (100, 50) to (180, 110). the clip rects are those of ImGui, in display units.
+        command(nullptr, 110.f, 60.f, 130.f, 75.f);
+        quad(90.f, 40.f, 200.f, 200.f, 0xFF0000FF);
+        command(nullptr, 150.f, 80.f, 170.f, 200.f);
+        triangle(vertex(140.f, 70.f, 0, 0, 0xFF00FF00), vertex(300.f, 70.f, 0, 0, 0xFF00FF00),
+            vertex(140.f, 300.f, 0, 0, 0xFF00FF00));
+        REQUIRE( render(&target) );
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                uint32_t expected = 0xFF000000;
+                if (x >= 20 && x < 60 && y >= 20 && y < 50) expected = 0xFFFF0000;
+                if (x >= 100 && x < 140 && y >= 60) expected = 0xFF00FF00;
+                REQUIRE( pixels[y * width + x] == expected );
+            }
+        }
+    }
+
+    SECTION( "textured quads match the sprite batch" ) {
+        std::vector<uint32_t> texels(32 * 24);
+        for (uint32_t &p : texels) p = randomColor(0);
+        ae::loaded_image_t image = {};
+        image.pixelPointer = texels.data();
+        image.width = 32;
+        image.height = 24;
+        ae::frender::premultiplyAlpha(image);
+        for (uint32_t &p : pixels) p = randomColor(255);
+        std::vector<uint32_t> expected = pixels;
+        ae::frender::backbuffer_t reference = { expected.data(), width, height, sizeof(uint32_t), width * 4 };
+
+        // 1:1, tinted and flipped, as rects and as triangles. the tint of a vertex is 0xAABBGGRR.
+        const uint32_t tint = 0xC080FF40;
+        command(&image);
+        quad(10.f, 12.f, 32.f, 24.f, 0xFFFFFFFF, true, 0.f, 0.f, 1.f, 1.f);
+        quad(60.f, 12.f, 32.f, 24.f, tint, true, 1.f, 1.f, 0.f, 0.f);
+        quad(10.f, 60.f, 32.f, 24.f, 0xFFFFFFFF, false, 0.f, 0.f, 1.f, 1.f);
+        quad(60.f, 60.f, 32.f, 24.f, tint, false, 1.f, 1.f, 0.f, 0.f);
+        // a region of one texel is one color.
+        quad(100.f, 60.f, 40.f, 30.f, tint, true, 0.5f / 32.f, 0.5f / 24.f, 0.5f / 32.f, 0.5f / 24.f);
+        REQUIRE( render(&target) );
+        REQUIRE( ae::frender::getUiStats(renderer).rects == 3 );
+
+        ae::frender::sprite_batch_t *batch = ae::frender::createSpriteBatch();
+        REQUIRE( ae::frender::beginSprites(batch, reference) );
+        const uint32_t argb = (tint & 0xFF00FF00) | ((tint >> 16) & 0xFF) | ((tint & 0xFF) << 16);
+        for (uint32_t i = 0; i < 5; i++) {
+            ae::frender::sprite_quad_t sprite = {};
+            sprite.image = &image;
+            sprite.x = (i % 2) ? 60.f : 10.f;
+            sprite.y = (i < 2) ? 12.f : 60.f;
+            sprite.width = 32.f;
+            sprite.height = 24.f;
+            sprite.tint = (i % 2) ? argb : 0xFFFFFFFF;
+            if (i % 2) sprite.u0 = sprite.v0 = 1.f, sprite.u1 = sprite.v1 = 0.f;
+            if (i == 4) {
+                sprite.x = 100.f;
+                sprite.width = 40.f;
+                sprite.height = 30.f;
+                sprite.tint = argb;
+                sprite.u0 = sprite.u1 = 0.5f / 32.f;
+                sprite.v0 = sprite.v1 = 0.5f / 24.f;
+            }
+            // NOTE: the sprite batch draws the quads of one depth in the order that they were pushed.
+            ae::frender::pushQuad(batch, sprite);
+        }
+        ae::frender::endSprites(batch);
+        ae::frender::destroySpriteBatch(batch);
+        REQUIRE( pixels == expected );
+    }
+
+    SECTION( "vertex colors are interpolated" ) {
+        const float x[3] = { 10.f, 150.f, 40.f }, y[3] = { 8.f, 30.f, 110.f };
+        const uint32_t colors[3] = { 0xFF0000FF, 0x8000FF00, 0xFFFF0000 };
+        command();
+        triangle(vertex(x[0], y[0], 0, 0, colors[0]), vertex(x[1], y[1], 0, 0, colors[1]),
+            vertex(x[2], y[2], 0, 0, colors[2]));
+        REQUIRE( render(&target) );
+        float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+        uint32_t covered = 0;
+        for (uint32_t py = 0; py < height; py++) {
+            for (uint32_t px = 0; px < width; px++) {
+                float w[3];
+                for (uint32_t k = 0; k < 3; k++) {
+                    uint32_t i = (k + 1) % 3, j = (k + 2) % 3;
+                    w[k] = ((x[j] - x[i]) * (py + 0.5f - y[i]) - (y[j] - y[i]) * (px + 0.5f - x[i])) / area;
+                }
+                if (std::min(w[0], std::min(w[1], w[2])) < 0.01f) continue;
+                covered++;
+                // the premultiplied colors are interpolated, and blended over black.
+                uint32_t p = pixels[py * width + px];
+                REQUIRE( (p >> 24) == 255 );
+                for (uint32_t channel = 0; channel < 3; channel++) {
+                    float expected = 0.f;
+                    for (uint32_t k = 0; k < 3; k++)
+                        expected += w[k] * ((colors[k] >> (channel * 8)) & 0xFF) * (colors[k] >> 24) / 255.f;
+                    // NOTE: the vertex colors are 0xAABBGGRR, and the target is 0xAARRGGBB.
+                    REQUIRE( fabsf(float((p >> (16 - channel * 8)) & 0xFF) - expected) <= 2.f );
+                }
+            }
+        }
+        REQUIRE( covered > 3000 );
+    }
+
+    SECTION( "commands draw in order and mark what they change" ) {
+        ae::frender::dirty_rects_t dirty = {};
+        target.dirty = &dirty;
+        command();
+        quad(20.f, 20.f, 50.f, 40.f, 0xFF0000FF);
+        command(nullptr, 0.f, 0.f, 100.f, 100.f);
+        quad(40.f, 30.f, 80.f, 30.f, 0xFF00FF00);
+        triangle(vertex(130.f, 70.f, 0, 0, 0x80FFFFFF), vertex(150.f, 100.f, 0, 0, 0x80FFFFFF),
+            vertex(120.f, 90.f, 0, 0, 0x80FFFFFF));
+        REQUIRE( render(&target) );
+        REQUIRE( pixels[25 * width + 25] == 0xFFFF0000 );
+        REQUIRE( pixels[35 * width + 45] == 0xFF00FF00 );
+        REQUIRE( pixels[35 * width + 99] == 0xFF00FF00 );
+        REQUIRE( pixels[35 * width + 100] == 0xFF000000 );
+        REQUIRE( pixels[85 * width + 130] == 0xFF000000 );
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                bool bDirty = false;
+                for (uint32_t i = 0; i < dirty.count; i++) {
+                    const ae::frender::dirty_rect_t &r = dirty.rects[i];
+                    bDirty |= int32_t(x) >= r.x && int32_t(x) < r.x + r.width && int32_t(y) >= r.y &&
+                              int32_t(y) < r.y + r.height;
+                }
+                if (!bDirty) REQUIRE( pixels[y * width + x] == 0xFF000000 );
+            }
+        }
+    }
+
+    SECTION( "bad triangles are culled" ) {
+        command();
+        triangle(vertex(10.f, 10.f, 0, 0, ~0u), vertex(20.f, 20.f, 0, 0, ~0u), vertex(30.f, 30.f, 0, 0, ~0u));
+        triangle(0, 1, 1000);
+        triangle(vertex(1e30f, 10.f, 0, 0, ~0u), 0, 1);
+        triangle(vertex(NAN, 10.f, 0, 0, ~0u), 0, 1);
+        // a command that reads past the end of the indices.
+        commands.push_back({ 0.f, 0.f, 1e6f, 1e6f, nullptr, 0, uint32_t(indices.size()) - 3, 30 });
+        REQUIRE( render(&target) );
+        REQUIRE( ae::frender::getUiStats(renderer).culled == 5 );
+        REQUIRE( std::count(pixels.begin(), pixels.end(), 0xFF000000) == int(pixels.size()) );
+
+        ae::frender::backbuffer_t small = target;
+        small.bytesPerPixel = 2;
+        REQUIRE_FALSE( render(&small) );
+    }
+
+    ae::frender::destroyUiRenderer(renderer);
+}
+
+TEST_CASE( "backbuffer ring", "[ae::frender]" ) {
+    utils::SetupTestEngineContext();
+    utils::Seed(__LINE__);
+    const uint32_t width = 200, height = 150;
+    ae::frender::backbuffer_ring_t *ring = ae::frender::createBackbufferRing(3);
+    auto pixelsOf = [](const ae::frender::backbuffer_t *buffer) {
+        return std::vector<uint32_t>(buffer->memory, buffer->memory + buffer->width * buffer->height);
+    };
+    auto covered = [](const ae::frender::dirty_rects_t &dirty, uint32_t x, uint32_t y) {
+        for (uint32_t i = 0; i < dirty.count; i++) {
+            const ae::frender::dirty_rect_t &r = dirty.rects[i];
+            if (int32_t(x) >= r.x && int32_t(x) < r.x + r.width && int32_t(y) >= r.y && int32_t(y) < r.y + r.height)
+                return true;
+        }
+        return false;
+    };
+
+    SECTION( "an acquired buffer holds the last frame, and the front dirty rects cover what changed" ) {
+        std::vector<uint32_t>      expected(width * height, 0), shown = expected;
+        ae::frender::dirty_rects_t dirty    = {};
+        const uint32_t             frames   = 60;
+        for (uint32_t frame = 0; frame < frames; frame++) {
+            ae::frender::backbuffer_t *buffer = ae::frender::acquireBackbuffer(ring, width, height);
+            REQUIRE( buffer );
+            REQUIRE( pixelsOf(buffer) == expected );
+            REQUIRE( buffer->dirty->count == (frame ? 0 : 1) );
+            int32_t  x = utils::RandomUINT32(0, width), y = utils::RandomUINT32(0, height);
+            int32_t  w = utils::RandomUINT32(1, 30), h = utils::RandomUINT32(1, 30);
+            uint32_t color = 0xFF000000 | utils::RandomBits(24);
+            ae::frender::fill(buffer, x, y, w, h, color);
+            for (uint32_t py = y; py < ae::math::min(uint32_t(y + h), height); py++)
+                for (uint32_t px = x; px < ae::math::min(uint32_t(x + w), width); px++)
+                    expected[py * width + px] = color;
+            ae::frender::submitBackbuffer(ring);
+
+            if (utils::RandomUINT32(0, 2) == 0) continue;
+            const ae::frender::backbuffer_t *front = ae::frender::acquireFrontBuffer(ring, 0, &dirty);
+            REQUIRE( front );
+            REQUIRE( front == buffer );
+            std::vector<uint32_t> pixels = pixelsOf(front);
+            REQUIRE( pixels == expected );
+            for (uint32_t py = 0; py < height; py++)
+                for (uint32_t px = 0; px < width; px++)
+                    if (pixels[py * width + px] != shown[py * width + px]) REQUIRE( covered(dirty, px, py) );
+            shown = pixels;
+            REQUIRE( ae::frender::acquireFrontBuffer(ring, 0, &dirty) == nullptr );
+        }
+        ae::frender::acquireFrontBuffer(ring, 0, nullptr);
+        ae::frender::backbuffer_ring_stats_t stats = ae::frender::getBackbufferRingStats(ring);
+        REQUIRE( stats.submitted == frames );
+        REQUIRE( stats.presented + stats.dropped == frames );
+        REQUIRE( stats.allocations == 3 );
+        // NOTE: the buffers catch up by the rects of the frames that they missed, not whole.
+        REQUIRE( stats.copiedBytes < uint64_t(frames) * width * height * 4 / 8 );
+    }
+
+    SECTION( "the renderer does not wait on a presenter that falls behind" ) {
+        for (uint32_t frame = 0; frame < 5; frame++) {
+            ae::frender::backbuffer_t *buffer = ae::frender::acquireBackbuffer(ring, width, height);
+            // NOTE: acquiring again before the submit gives the same buffer.
+            REQUIRE( ae::frender::acquireBackbuffer(ring, width, height) == buffer );
+            ae::frender::fill(buffer, frame * 20, 10, 10, 10, 0xFFFF0000);
+            ae::frender::submitBackbuffer(ring);
+        }
+        ae::frender::dirty_rects_t       dirty = {};
+        const ae::frender::backbuffer_t *front = ae::frender::acquireFrontBuffer(ring, 0, &dirty);
+        REQUIRE( front );
+        // the first frame is all dirty.
+        REQUIRE( dirty.count == 1 );
+        REQUIRE( dirty.rects[0].width == int32_t(width) );
+        for (uint32_t frame = 0; frame < 5; frame++) REQUIRE( front->memory[10 * width + frame * 20] == 0xFFFF0000 );
+        ae::frender::backbuffer_ring_stats_t stats = ae::frender::getBackbufferRingStats(ring);
+        REQUIRE( stats.presented == 1 );
+        REQUIRE( stats.dropped == 4 );
+
+        // the rects of the dropped frames are presented with the next one.
+        for (uint32_t frame = 0; frame < 3; frame++) {
+            ae::frender::fill(ae::frender::acquireBackbuffer(ring, width, height), 5, frame * 30, 4, 4, 0xFF00FF00);
+            ae::frender::submitBackbuffer(ring);
+        }
+        REQUIRE( ae::frender::acquireFrontBuffer(ring, 0, &dirty) );
+        for (uint32_t frame = 0; frame < 3; frame++) REQUIRE( covered(dirty, 6, frame * 30 + 1) );
+        REQUIRE_FALSE( covered(dirty, 100, 100) );
+    }
+
+    SECTION( "resizes reuse the pixels that there are" ) {
+        // NOTE: while the presenter keeps up, the renderer takes turns with it on two of the buffers.
+        for (uint32_t frame = 0; frame < 6; frame++) {
+            ae::frender::clear(ae::frender::acquireBackbuffer(ring, width, height), 0xFFFFFFFF);
+            ae::frender::submitBackbuffer(ring);
+            ae::frender::acquireFrontBuffer(ring, 0, nullptr);
+        }
+        REQUIRE( ae::frender::getBackbufferRingStats(ring).allocations == 2 );
+        const uint32_t sizes[][2] = { { 100, 80 }, { 150, 200 }, { width, height } };
+        for (const auto &size : sizes) {
+            for (uint32_t frame = 0; frame < 4; frame++) {
+                ae::frender::backbuffer_t *buffer = ae::frender::acquireBackbuffer(ring, size[0], size[1]);
+                REQUIRE( buffer->width == size[0] );
+                REQUIRE( buffer->height == size[1] );
+                REQUIRE( buffer->pitch == size[0] * 4 );
+                std::vector<uint32_t> pixels = pixelsOf(buffer);
+                if (frame == 0) {
+                    // the first frame of a size starts black, and all dirty.
+                    REQUIRE( std::count(pixels.begin(), pixels.end(), 0u) == int(pixels.size()) );
+                    REQUIRE( buffer->dirty->count == 1 );
+                    REQUIRE( buffer->dirty->rects[0].width == int32_t(size[0]) );
+                    ae::frender::clear(buffer, 0xFF123456);
+                } else {
+                    REQUIRE( std::count(pixels.begin(), pixels.end(), 0xFF123456) == int(pixels.size()) );
+                }
+                ae::frender::submitBackbuffer(ring);
+                ae::frender::acquireFrontBuffer(ring, 0, nullptr);
+            }
+        }
+        REQUIRE( ae::frender::getBackbufferRingStats(ring).allocations == 2 );
+        ae::frender::acquireBackbuffer(ring, width + 1, height);
+        REQUIRE( ae::frender::getBackbufferRingStats(ring).allocations == 3 );
+    }
+
+    SECTION( "a present thread sees whole frames" ) {
+        // NOTE: frame f writes f to pixel 0 and to one of the other pixels, so that the presenter knows each pixel of
+        // the frame that it is given.
+        const uint32_t        cells = width * height - 1, frames = 2000;
+        std::atomic<uint32_t> failures = 0, presented = 0;
+        std::thread           presenter([&]() {
+            uint32_t last = 0;
+            while (const ae::frender::backbuffer_t *front = ae::frender::acquireFrontBuffer(ring, 1000, nullptr)) {
+                uint32_t frame = front->memory[0];
+                if (frame <= last) failures++;
+                last = frame;
+                for (uint32_t cell = 0; cell < ae::math::min(frame, cells); cell++) {
+                    uint32_t newest = frame - (frame - 1 - cell) % cells;
+                    if (front->memory[1 + cell] != newest) failures++;
+                }
+                presented++;
+            }
+        });
+        for (uint32_t frame = 1; frame <= frames; frame++) {
+            ae::frender::backbuffer_t *buffer = ae::frender::acquireBackbuffer(ring, width, height);
+            uint32_t                   cell   = 1 + (frame - 1) % cells;
+            buffer->memory[0]                 = frame;
+            buffer->memory[cell]              = frame;
+            ae::frender::markDirty(buffer, 0, 0, 1, 1);
+            ae::frender::markDirty(buffer, cell % width, cell / width, 1, 1);
+            ae::frender::submitBackbuffer(ring);
+        }
+        while (ae::frender::getBackbufferRingStats(ring).submitted !=
+               ae::frender::getBackbufferRingStats(ring).presented + ae::frender::getBackbufferRingStats(ring).dropped)
+            std::this_thread::yield();
+        ae::frender::closeBackbufferRing(ring);
+        presenter.join();
+        REQUIRE( failures == 0 );
+        REQUIRE( presented > 0 );
+        REQUIRE( ae::frender::acquireBackbuffer(ring, width, height) == nullptr );
+    }
+
+    ae::frender::destroyBackbufferRing(ring);
+}
+
+TEST_CASE( "pak ranged reads", "[ae::pak]" ) {
+    utils::SetupTestEngineContext();
+
+    // four and a bit chunks of compressible data.
+    const uint32_t size = ae::pak::PAK_CHUNK_SIZE * 4 + 1234;
+    std::vector<uint8_t> data(size);
+    for (uint32_t i = 0; i < size; i++) data[i] = uint8_t((i / 7) ^ (i >> 12));
+    REQUIRE( ae::EM->pfn.writeEntireFile("ae_test_pak_src.bin", data.data(), size) );
+
+    for (bool bCompress : { false, true }) {
+        const char *srcPath = "ae_test_pak_src.bin", *pakPath = "data\\blob.bin";
+        REQUIRE( ae::pak::writePack("ae_test.aepak", &srcPath, &pakPath, 1, bCompress) );
+        ae::loaded_file_t file = ae::EM->pfn.readEntireFile("ae_test.aepak");
+        ae::pak::pak_t pak;
+        REQUIRE( ae::pak::open(&pak, file.contents, file.contentSize) );
+        const ae::pak::pak_entry_t *entry = ae::pak::find(pak, "data/blob.bin");
+        REQUIRE( entry );
+        REQUIRE( bool(entry->flags & ae::pak::PAK_ENTRY_COMPRESSED) == bCompress );
+
+        std::vector<uint8_t> out(size);
+        const uint64_t ranges[][2] = { { 0, 10 }, { 100, ae::pak::PAK_CHUNK_SIZE * 2 }, { ae::pak::PAK_CHUNK_SIZE, 1 },
+            { ae::pak::PAK_CHUNK_SIZE - 1, 2 }, { size - 5, 5 }, { 0, size } };
+        for (auto &range : ranges) {
+            REQUIRE( ae::pak::read(pak, entry, range[0], out.data(), range[1]) == range[1] );
+            REQUIRE( memcmp(out.data(), data.data() + range[0], range[1]) == 0 );
+        }
+        // reads past the end are short.
+        REQUIRE( ae::pak::read(pak, entry, size - 3, out.data(), 100) == 3 );
+        REQUIRE( ae::pak::read(pak, entry, size, out.data(), 100) == 0 );
+        ae::EM->pfn.freeLoadedFile(file);
+    }
+    remove("ae_test_pak_src.bin");
+    remove("ae_test.aepak");
+}
+
+TEST_CASE( "wav conversion", "[.][bench]" ) {
+    // one second of 16-bit stereo at 48 kHz, converted to the mix format.
+    const uint32_t frameCount = 48000;
+    std::vector<int16_t> samples(frameCount * 2);
+    for (uint32_t i = 0; i < frameCount * 2; i++) samples[i] = int16_t(lrint(16384.0 * sin(i * 0.01)));
+    std::vector<int16_t> out(frameCount * 2);
+
+    const char *names[] = { "48 kHz -> 44.1 kHz, fast", "48 kHz -> 44.1 kHz, default", "48 kHz -> 44.1 kHz, high" };
+    for (uint32_t quality = 0; quality < 3; quality++) {
+        ae::io::audio_converter_t *converter =
+            ae::io::createAudioConverter({ 48000, 2, 16, false }, ae::io::resample_quality_t(quality));
+        BENCHMARK( names[quality] ) {
+            uint32_t written = ae::io::convertAudio(converter, samples.data(), frameCount, out.data());
+            return written + ae::io::flushAudioConverter(converter, out.data() + written * 2);
+        };
+        ae::io::destroyAudioConverter(converter);
+    }
+
+    ae::io::audio_converter_t *converter =
+        ae::io::createAudioConverter({ 44100, 1, 24, false }, ae::io::RESAMPLE_QUALITY_DEFAULT);
+    BENCHMARK( "24-bit mono -> 16-bit stereo at the mix rate" ) {
+        return ae::io::convertAudio(converter, samples.data(), frameCount, out.data());
+    };
+    ae::io::destroyAudioConverter(converter);
+}
+
+TEST_CASE( "adpcm decode", "[.][bench]" ) {
+    // one second of stereo at the mix rate, in the block sizes that common encoders use.
+    const uint32_t frameCount = 44100;
+    std::vector<int16_t> samples(frameCount * 2);
+    for (uint32_t i = 0; i < frameCount * 2; i++) samples[i] = int16_t(lrint(16384.0 * sin(i * 0.01)));
+    std::vector<int16_t> out((frameCount + 4096) * 2);
+
+    const char *names[] = { "IMA mono", "IMA stereo", "MS mono", "MS stereo" };
+    for (uint32_t k = 0; k < 4; k++) {
+        bool bIma = k < 2;
+        uint32_t channels = 1 + k % 2, blockAlign = 512 * channels;
+        std::vector<uint8_t> blocks = utils::EncodeAdpcm(bIma, samples.data(), channels, frameCount, blockAlign);
+        ae::loaded_wav_t wav = {};
+        wav.sampleCount = int(frameCount);
+        wav.channels = int(channels);
+        wav.encoding = bIma ? ae::io::WAV_ENCODING_IMA_ADPCM : ae::io::WAV_ENCODING_MS_ADPCM;
+        wav.blockData = blocks.data();
+        wav.blockSize = blockAlign;
+        wav.framesPerBlock = utils::GetAdpcmFramesPerBlock(bIma, channels, blockAlign);
+        uint32_t blockCount = uint32_t(blocks.size()) / blockAlign;
+
+        BENCHMARK( std::string(names[k]) + ", 1 s" ) {
+            return ae::io::decodeWavBlocks(wav, 0, blockCount, out.data());
+        };
+        BENCHMARK( std::string(names[k]) + ", 1 s, scalar reference" ) {
+            return utils::DecodeAdpcmReference(bIma, blocks.data(), channels, frameCount, blockAlign);
+        };
+    }
+
+    // the cost that a voice callback pays per 10 ms buffer, on average, for a compressed stereo sound.
+    std::vector<uint8_t> blocks = utils::EncodeAdpcm(true, samples.data(), 2, frameCount, 1024);
+    REQUIRE( utils::WriteAdpcmWav("ae_test_adpcm_bench.wav", 0x11, 2, 44100, 1024, 1017, blocks.data(),
+        uint32_t(blocks.size()), frameCount) );
+    utils::SetupTestEngineContext();
+    static ae::PFN_voiceFillCallback s_fill;
+    static void *s_user;
+    ae::EM->pfn.voiceSubmitCallback = [](intptr_t voiceHandle, ae::PFN_voiceFillCallback fill, void *user) {
+        s_fill = fill;
+        s_user = user;
+        return true;
+    };
+    ae::loaded_wav_t wav = ae::io::loadWav("ae_test_adpcm_bench.wav", ae::io::RESAMPLE_QUALITY_DEFAULT, true);
+    ae::audio::voiceSubmitWav(0, wav, true);
+    BENCHMARK( "IMA stereo voice, 441 frame buffer" ) {
+        return s_fill(s_user, out.data(), 441);
+    };
+    ae::io::freeWav(wav);
+    ae::EM->pfn.voiceSubmitCallback = nullptr;
+    remove("ae_test_adpcm_bench.wav");
+}
+
+TEST_CASE( "mixer render", "[.][bench]" ) {
+    utils::SetupTestEngineContext();
+    std::vector<int16_t> data(44100 * 2);
+    utils::Seed(__LINE__);
+    for (int16_t &sample : data) sample = int16_t(utils::RandomBits(16) - 32768);
+    ae::loaded_wav_t wav = {};
+    wav.sampleCount = 44100;
+    wav.channels = 2;
+    wav.sampleData = data.data();
+    wav.encoding = ae::io::WAV_ENCODING_PCM16;
+
+    std::vector<float> out(ae::audio::MIXER_BLOCK_FRAMES * 2);
+    for (uint32_t voiceCount : { 64u, 256u }) {
+        for (float pitch : { 1.f, 1.3f }) {
+            ae::audio::mixer_desc_t desc = {};
+            desc.maxVoices = voiceCount;
+            desc.maxRealVoices = voiceCount;
+            ae::audio::mixer_t *mixer = ae::audio::createMixer(desc);
+            ae::audio::mixer_voice_params_t params = {};
+            for (uint32_t i = 0; i < voiceCount; i++) {
+                params.pan = utils::RandomFloat(-1.f, 1.f);
+                params.pitch = pitch;
+                ae::audio::mixerPlay(mixer, wav, params, true);
+            }
+            BENCHMARK( std::to_string(voiceCount) + " voices at pitch " + std::to_string(pitch).substr(0, 3) +
+                ", 256 frames" ) {
+                ae::audio::mixerRender(mixer, out.data(), ae::audio::MIXER_BLOCK_FRAMES);
+                return out[0];
+            };
+            ae::audio::destroyMixer(mixer);
+        }
+    }
+
+    // the cost of the voices that are not mixed.
+    ae::audio::mixer_desc_t desc = {};
+    desc.maxVoices = 1024;
+    desc.maxRealVoices = 32;
+    ae::audio::mixer_t *mixer = ae::audio::createMixer(desc);
+    for (uint32_t i = 0; i < desc.maxVoices; i++) ae::audio::mixerPlay(mixer, wav, {}, true);
+    BENCHMARK( "1024 voices, 32 real, 256 frames" ) {
+        ae::audio::mixerRender(mixer, out.data(), ae::audio::MIXER_BLOCK_FRAMES);
+        return out[0];
+    };
+    ae::audio::destroyMixer(mixer);
+}
+
+TEST_CASE( "audio device pass", "[.][bench]" ) {
+    utils::SetupTestEngineContext();
+    std::vector<int16_t> data(44100 * 2);
+    utils::Seed(__LINE__);
+    for (int16_t &sample : data) sample = int16_t(utils::RandomBits(16) - 32768);
+    ae::loaded_wav_t wav = {};
+    wav.sampleCount = 44100;
+    wav.channels = 2;
+    wav.sampleData = data.data();
+
+    // a one-pole lowpass per voice stands in for the game's DSP.
+    static float s_state[64][2];
+    ae::audio::audio_device_desc_t desc = {};
+    desc.onVoiceBufferProcess = [](ae::game_memory_t *gameMemory, intptr_t voiceHandle, float *dst, float *src,
+        uint32_t samplesToWrite, int channels, int bytesPerSample) {
+        float *state = s_state[voiceHandle];
+        for (uint32_t i = 0; i < samplesToWrite; i++) {
+            for (int c = 0; c < 2; c++) dst[i * 2 + c] = state[c] += 0.2f * (src[i * 2 + c] - state[c]);
+        }
+    };
+    for (bool bProcess : { false, true }) {
+        ae::audio::audio_device_desc_t passDesc = desc;
+        if (!bProcess) passDesc.onVoiceBufferProcess = nullptr;
+        ae::audio::audio_device_t *device = ae::audio::createNullDevice(passDesc);
+        ae::audio::installDevice(device);
+        for (uint32_t i = 0; i < 16; i++) {
+            intptr_t voice = ae::EM->pfn.createVoice();
+            ae::audio::voiceSubmitWav(voice, wav, true);
+            ae::EM->pfn.voicePlayBuffer(voice);
+        }
+        BENCHMARK( std::string("16 voices, 441 frame pass") + (bProcess ? ", one-pole per voice" : "") ) {
+            ae::audio::advanceDevice(device, 441);
+            return ae::audio::getDeviceClock(device);
+        };
+        ae::audio::destroyDevice(device);
+    }
+}
+
+TEST_CASE( "spatializer update", "[.][bench]" ) {
+    utils::SetupTestEngineContext();
+    ae::audio::mixer_t *mixer = ae::audio::createMixer({});
+    utils::Seed(__LINE__);
+    for (uint32_t emitterCount : { 256u, 1024u }) {
+        ae::audio::spatializer_desc_t desc = {};
+        desc.maxEmitters = emitterCount;
+        ae::audio::spatializer_t *spatializer = ae::audio::createSpatializer(mixer, desc);
+        // NOTE: the emitters have no voices, so that the parameters are computed and compared on each update but
+        // nothing fills the mixer's command queue.
+        for (uint32_t i = 0; i < emitterCount; i++) {
+            uint32_t emitter = ae::audio::addEmitter(spatializer, {}, {});
+            ae::audio::setEmitterTransform(spatializer, emitter,
+                ae::math::vec3_t(utils::RandomFloat(-50.f, 50.f), utils::RandomFloat(-50.f, 50.f),
+                    utils::RandomFloat(-50.f, 50.f)),
+                ae::math::vec3_t(utils::RandomFloat(-20.f, 20.f), 0.f, utils::RandomFloat(-20.f, 20.f)));
+        }
+        ae::audio::listener_t listener = {};
+        listener.right = ae::math::vec3_t(1.f, 0.f, 0.f);
+        BENCHMARK( std::to_string(emitterCount) + " emitters" ) {
+            listener.pos.x += 0.01f;
+            ae::audio::updateSpatializer(spatializer, listener);
+            return ae::audio::getEmitterParams(spatializer, 0).gain;
+        };
+        ae::audio::destroySpatializer(spatializer);
+    }
+    ae::audio::destroyMixer(mixer);
+}
+
+TEST_CASE( "dsp effect costs", "[.][bench]" ) {
+    utils::SetupTestEngineContext();
+    utils::Seed(__LINE__);
+    const float sampleRate = 44100.f;
+    // 441 frames is the 10 ms pass of XAudio2.
+    for (uint32_t frameCount : { 256u, 441u }) {
+        std::vector<float> samples(frameCount * 2);
+        for (float &sample : samples) sample = utils::RandomFloat(-1.f, 1.f);
+        std::string suffix = ", " + std::to_string(frameCount) + " stereo frames";
+
+        ae::dsp::biquad_t biquad = {};
+        ae::dsp::designBiquad(&biquad, ae::dsp::BIQUAD_LOWPASS, sampleRate, 2000.f, 0.7071f);
+        BENCHMARK( "biquad" + suffix ) {
+            ae::dsp::processBiquad(&biquad, samples.data(), frameCount, 2);
+            return samples[0];
+        };
+        ae::dsp::one_pole_t onePole = {};
+        ae::dsp::designOnePole(&onePole, sampleRate, 2000.f);
+        BENCHMARK( "one-pole" + suffix ) {
+            ae::dsp::processOnePole(&onePole, samples.data(), frameCount, 2);
+            return samples[0];
+        };
+        ae::dsp::one_pole_t smoother = {};
+        ae::dsp::designOnePole(&smoother, sampleRate, 20.f);
+        float target = 0.5f;
+        BENCHMARK( "smoothed gain" + suffix ) {
+            target = 1.5f - target;
+            ae::dsp::applySmoothedGain(&smoother, target, samples.data(), frameCount, 2);
+            return samples[0];
+        };
+        ae::dsp::compressor_t compressor = {};
+        ae::dsp::designCompressor(&compressor, sampleRate, {});
+        BENCHMARK( "compressor" + suffix ) {
+            ae::dsp::processCompressor(&compressor, samples.data(), frameCount, 2);
+            return samples[0];
+        };
+        ae::dsp::delay_t *delay = ae::dsp::createDelay({});
+        BENCHMARK( "delay" + suffix ) {
+            ae::dsp::processDelay(delay, samples.data(), frameCount);
+            return samples[0];
+        };
+        ae::dsp::destroyDelay(delay);
+        ae::dsp::reverb_t *reverb = ae::dsp::createReverb({});
+        BENCHMARK( "reverb" + suffix ) {
+            ae::dsp::processReverb(reverb, samples.data(), frameCount);
+            return samples[0];
+        };
+        ae::dsp::destroyReverb(reverb);
+    }
+}
+
+TEST_CASE( "software rasterizer frame", "[.][bench]" ) {
+    utils::SetupTestEngineContext();
+    // a textured grid of 2 * 128 * 128 triangles on the floor, seen from above at an angle.
+    constexpr uint32_t gridDim = 128;
+    ae::raw_model_t grid = {};
+    for (uint32_t z = 0; z <= gridDim; z++) {
+        for (uint32_t x = 0; x <= gridDim; x++) {
+            float u = x / (float)gridDim, v = z / (float)gridDim;
+            float vertex[8] = { u * 40.f - 20.f, 0, 10.f - v * 40.f, u * 8.f, v * 8.f, 0, 1, 0 };
+            for (float f : vertex) StretchyBufferPush(grid.vertexData, f);
+        }
+    }
+    for (uint32_t z = 0; z < gridDim; z++) {
+        for (uint32_t x = 0; x < gridDim; x++) {
+            uint32_t i0 = z * (gridDim + 1) + x, i1 = i0 + 1, i2 = i0 + gridDim + 1, i3 = i2 + 1;
+            uint32_t quad[6] = { i0, i1, i3, i0, i3, i2 };
+            for (uint32_t i : quad) StretchyBufferPush(grid.indexData, i);
+        }
+    }
+    std::vector<uint32_t> checker(64 * 64);
+    for (uint32_t i = 0; i < 64 * 64; i++) checker[i] = (((i / 64) ^ i) & 8) ? 0xFFFFFFFF : 0xFF404040;
+    ae::loaded_image_t texture = {};
+    texture.pixelPointer = checker.data();
+    texture.width = texture.height = 64;
+
+    ae::math::camera_t cam = {};
+    cam.trans.pos = { 0, 4, 6 };
+    cam.trans.eulerAngles = { -0.5f, 0, 0 };
+    cam.trans.scale = { 1, 1, 1 };
+    cam.fov = 70.f;
+    cam.nearPlane = 0.1f;
+    cam.farPlane = 100.f;
+    cam.width = 1280;
+    cam.height = 720;
+    std::vector<uint32_t> pixels(1280 * 720);
+    ae::frender::backbuffer_t target = { pixels.data(), 1280, 720, sizeof(uint32_t), 1280 * sizeof(uint32_t) };
+    ae::math::mat4_t viewProj = ae::math::buildProjMat(cam) * ae::math::buildViewMat(cam);
+    ae::math::mat4_t identity = {};
+
+    ae::frender::rasterizer_t *rasterizer = ae::frender::createRasterizer();
+    ae::frender::raster_material_t textured = {};
+    textured.texture = &texture;
+    BENCHMARK( "1280x720, 32K textured triangles" ) {
+        ae::frender::beginRaster(rasterizer, target, viewProj);
+        ae::frender::rasterModel(rasterizer, grid, identity, textured);
+        ae::frender::endRaster(rasterizer);
+        return pixels[640 + 600 * 1280];
+    };
+    ae::frender::raster_material_t lit = {};
+    lit.color = 0xFF80C0FF;
+    lit.bLit = true;
+    BENCHMARK( "1280x720, 32K flat shaded triangles" ) {
+        ae::frender::beginRaster(rasterizer, target, viewProj);
+        ae::frender::rasterModel(rasterizer, grid, identity, lit);
+        ae::frender::endRaster(rasterizer);
+        return pixels[640 + 600 * 1280];
+    };
+    ae::frender::destroyRasterizer(rasterizer);
+    ae::io::freeObj(grid);
+}
+
+TEST_CASE( "bitmap blit", "[.][bench]" ) {
+    utils::SetupTestEngineContext();
+    std::vector<uint32_t> pixels(1280 * 720, 0xFF203040);
+    ae::frender::backbuffer_t target = { pixels.data(), 1280, 720, sizeof(uint32_t), 1280 * sizeof(uint32_t) };
+    // a sprite that is opaque in a circle with a soft edge, and clear outside of it.
+    auto makeSprite = [](uint32_t size) {
+        std::vector<uint32_t> sprite(size * size);
+        for (uint32_t y = 0; y < size; y++) {
+            for (uint32_t x = 0; x < size; x++) {
+                float dx = x + 0.5f - size * 0.5f, dy = y + 0.5f - size * 0.5f;
+                float edge = size * 0.5f - sqrtf(dx * dx + dy * dy);
+                uint32_t a = (uint32_t)(std::min(std::max(edge / 2.f, 0.f), 1.f) * 255.f);
+                sprite[y * size + x] = (a << 24) | 0x4080C0;
+            }
+        }
+        return sprite;
+    };
+    for (uint32_t size : { 16u, 32u, 64u, 128u }) {
+        std::vector<uint32_t> spritePixels = makeSprite(size);
+        ae::loaded_image_t sprite = {};
+        sprite.pixelPointer = spritePixels.data();
+        sprite.width = sprite.height = size;
+        ae::frender::premultiplyAlpha(sprite);
+        for (uint32_t scale : { 1u, 2u, 3u, 4u }) {
+            if (size * scale > 256) continue;
+            int32_t x = 0;
+            BENCHMARK( std::to_string(size) + "x" + std::to_string(size) + " sprite at " + std::to_string(scale) + "x" ) {
+                x = (x + 37) % 1000;
+                ae::frender::drawBitmap(&target, sprite, x, 100, scale);
+                return pixels[100 * 1280 + x];
+            };
+        }
+    }
+    // the resampled blits, against the integer scale of drawBitmap.
+    std::vector<uint32_t> spritePixels = makeSprite(64);
+    ae::loaded_image_t sprite = {};
+    sprite.pixelPointer = spritePixels.data();
+    sprite.width = sprite.height = 64;
+    ae::frender::premultiplyAlpha(sprite);
+    for (float scale : { 0.5f, 1.f, 2.37f, 3.f }) {
+        for (auto filter : { ae::frender::IMAGE_FILTER_BILINEAR, ae::frender::IMAGE_FILTER_BICUBIC }) {
+            char name[64];
+            snprintf(name, sizeof(name), "%s 64x64 sprite at %.2fx",
+                filter == ae::frender::IMAGE_FILTER_BICUBIC ? "bicubic" : "bilinear", scale);
+            float x = 0.f;
+            BENCHMARK( name ) {
+                x = fmodf(x + 37.3f, 1000.f);
+                ae::frender::drawBitmapScaled(&target, sprite, x, 100.5f, 64 * scale, 64 * scale, filter);
+                return pixels[100 * 1280 + int32_t(x)];
+            };
+        }
+    }
+}
+
+TEST_CASE( "sprite batch frame", "[.][bench]" ) {
+    utils::SetupTestEngineContext();
+    utils::Seed(__LINE__);
+    std::vector<uint32_t> pixels(1280 * 720, 0xFF203040);
+    ae::frender::backbuffer_t target = { pixels.data(), 1280, 720, sizeof(uint32_t), 1280 * sizeof(uint32_t) };
+    // an atlas of 8x8 sprites of 32x32, each opaque in a circle with a soft edge.
+    std::vector<uint32_t> atlasPixels(256 * 256);
+    for (uint32_t y = 0; y < 256; y++) {
+        for (uint32_t x = 0; x < 256; x++) {
+            float dx = x % 32 + 0.5f - 16.f, dy = y % 32 + 0.5f - 16.f;
+            uint32_t a = (uint32_t)(std::min(std::max((16.f - sqrtf(dx * dx + dy * dy)) / 2.f, 0.f), 1.f) * 255.f);
+            atlasPixels[y * 256 + x] = (a << 24) | ((x / 32 * 32) << 8) | (y / 32 * 32);
+        }
+    }
+    ae::loaded_image_t atlas = {};
+    atlas.pixelPointer = atlasPixels.data();
+    atlas.width = atlas.height = 256;
+    ae::frender::premultiplyAlpha(atlas);
+    std::vector<ae::frender::sprite_quad_t> quads(5000);
+    for (ae::frender::sprite_quad_t &quad : quads) {
+        uint32_t cell = utils::RandomUINT32(0, 63);
+        quad.image = &atlas;
+        quad.x = float(utils::RandomUINT32(0, 1280 - 32));
+        quad.y = float(utils::RandomUINT32(0, 720 - 32));
+        quad.width = quad.height = 32.f;
+        quad.u0 = (cell % 8) / 8.f;
+        quad.v0 = (cell / 8) / 8.f;
+        quad.u1 = quad.u0 + 1.f / 8.f;
+        quad.v1 = quad.v0 + 1.f / 8.f;
+        quad.depth = float(utils::RandomUINT32(0, 9));
+    }
+
+    ae::frender::sprite_batch_t *batch = ae::frender::createSpriteBatch();
+    BENCHMARK( "5000 sprites of 32x32 from an atlas" ) {
+        ae::frender::beginSprites(batch, target);
+        for (const ae::frender::sprite_quad_t &quad : quads) ae::frender::pushQuad(batch, quad);
+        ae::frender::endSprites(batch);
+        return pixels[360 * 1280 + 640];
+    };
+    BENCHMARK( "5000 tinted sprites of 48x48 from an atlas" ) {
+        ae::frender::beginSprites(batch, target);
+        for (ae::frender::sprite_quad_t quad : quads) {
+            quad.width = quad.height = 48.f;
+            quad.tint = 0xC0FF8040;
+            ae::frender::pushQuad(batch, quad);
+        }
+        ae::frender::endSprites(batch);
+        return pixels[360 * 1280 + 640];
+    };
+    ae::frender::destroySpriteBatch(batch);
+}
+
+TEST_CASE( "backbuffer clear", "[.][bench]" ) {
+    utils::SetupTestEngineContext();
+    std::vector<uint32_t> pixels(3840 * 2160);
+    ae::frender::backbuffer_t target = { pixels.data(), 3840, 2160, sizeof(uint32_t), 3840 * sizeof(uint32_t) };
+    uint32_t color = 0;
+    BENCHMARK( "4K scalar loop" ) {
+        color++;
+        uint32_t *pp = pixels.data();
+        for (uint32_t y = 0; y < 2160; y++) {
+            for (uint32_t x = 0; x < 3840; x++) { *(pp + x) = color; }
+            pp += 3840;
+        }
+        return pixels[1000];
+    };
+    BENCHMARK( "4K clear" ) {
+        ae::frender::clear(&target, ++color);
+        return pixels[1000];
+    };
+    BENCHMARK( "256x256 fill" ) {
+        ae::frender::fill(&target, 100, 100, 256, 256, ++color);
+        return pixels[200 * 3840 + 200];
+    };
+}
+
+TEST_CASE( "backbuffer present", "[.][bench]" ) {
+    utils::SetupTestEngineContext();
+    std::vector<uint32_t> back(3840 * 2160), front(3840 * 2160);
+    ae::frender::dirty_rects_t dirty = {};
+    ae::frender::backbuffer_t target = { back.data(), 3840, 2160, sizeof(uint32_t), 3840 * sizeof(uint32_t), &dirty };
+    ae::frender::backbuffer_t window = { front.data(), 3840, 2160, sizeof(uint32_t), 3840 * sizeof(uint32_t) };
+    uint32_t color = 0;
+    BENCHMARK( "4K whole" ) {
+        ae::frender::markDirty(&target, 0, 0, 3840, 2160);
+        return ae::frender::presentDirty(&window, target);
+    };
+    BENCHMARK( "4K with a 200x30 widget and a 16x16 cursor changed" ) {
+        ae::frender::fill(&target, 100, 100, 200, 30, ++color);
+        ae::frender::fill(&target, 1000 + color % 64, 500, 16, 16, color);
+        return ae::frender::presentDirty(&window, target);
+    };
+}
+
+TEST_CASE( "path tracer frame", "[.][bench]" ) {
+    utils::SetupTestEngineContext();
+    utils::Seed(__LINE__);
+    ae::EM->pfn.wallClock = []() { return uint64_t(std::chrono::steady_clock::now().time_since_epoch().count()); };
+    ae::EM->pfn.getTimerFrequency = []() { return uint64_t(std::chrono::steady_clock::period::den); };
+    // a floor with 300 cubes of random sizes on it, i.e. 3602 triangles.
+    ae::raw_model_t scene = {};
+    auto pushVertex = [&](float x, float y, float z, float nx, float ny, float nz) {
+        float vertex[8] = { x, y, z, 0, 0, nx, ny, nz };
+        for (float f : vertex) StretchyBufferPush(scene.vertexData, f);
+    };
+    auto pushQuad = [&](ae::math::vec3_t corner, ae::math::vec3_t a, ae::math::vec3_t b) {
+        ae::math::vec3_t n = ae::math::normalize(ae::math::cross(a, b));
+        uint32_t first = StretchyBufferCount(scene.vertexData) / 8;
+        for (ae::math::vec3_t v : { corner, corner + a, corner + a + b, corner + b })
+            pushVertex(v.x, v.y, v.z, n.x, n.y, n.z);
+        for (uint32_t i : { 0, 1, 2, 0, 2, 3 }) StretchyBufferPush(scene.indexData, first + i);
+    };
+    pushQuad({ -50, 0, 50 }, { 100, 0, 0 }, { 0, 0, -100 });
+    for (uint32_t i = 0; i < 300; i++) {
+        float s = utils::RandomFloat(0.2f, 1.5f);
+        ae::math::vec3_t p = { utils::RandomFloat(-15, 15), 0, utils::RandomFloat(-30, 0) };
+        ae::math::vec3_t x = { s, 0, 0 }, y = { 0, s, 0 }, z = { 0, 0, s };
+        pushQuad(p, z, x);
+        pushQuad(p + y, x, z);
+        pushQuad(p, x, y);
+        pushQuad(p + z, y, x);
+        pushQuad(p, y, z);
+        pushQuad(p + x, z, y);
+    }
+    ae::frender::path_tracer_t *tracer = ae::frender::createPathTracer();
+    ae::math::mat4_t identity = {};
+    ae::frender::addPathModel(tracer, scene, identity, {});
+
+    ae::math::camera_t cam = {};
+    cam.trans.pos = { 0, 3, 6 };
+    cam.trans.eulerAngles = { -0.3f, 0, 0 };
+    cam.trans.scale = { 1, 1, 1 };
+    cam.fov = 70.f;
+    cam.width = 320;
+    cam.height = 180;
+    std::vector<uint32_t> pixels(320 * 180);
+    ae::frender::backbuffer_t target = { pixels.data(), 320, 180, sizeof(uint32_t), 320 * sizeof(uint32_t) };
+    ae::frender::path_settings_t settings = {};
+    settings.sunColor = { 3, 3, 3 };
+    settings.sunDirection = { 0.4f, 1, 0.3f };
+    BENCHMARK( "320x180, 3602 triangles, 1 sample per pixel" ) {
+        ae::frender::renderPath(tracer, &target, cam, settings);
+        return pixels[90 * 320 + 160];
+    };
+    ae::frender::path_stats_t stats = ae::frender::getPathStats(tracer);
+    WARN( stats.samplesPerSecond / 1e6f << " M samples/s, " << stats.raysPerSecond / 1e6f << " M rays/s, "
+                                       << stats.bvhNodes << " BVH nodes" );
+    ae::frender::destroyPathTracer(tracer);
+    ae::io::freeObj(scene);
+    ae::EM->pfn.wallClock = nullptr;
+    ae::EM->pfn.getTimerFrequency = nullptr;
+}
+
+TEST_CASE( "text draw", "[.][bench]" ) {
+    utils::SetupTestEngineContext();
+    std::string fontPath = __FILE__;
+    fontPath = fontPath.substr(0, fontPath.find_last_of("/\\") + 1) +
+               "../../external/ProggyVector/ProggyVector Regular.ttf";
+    ae::frender::glyph_cache_t *cache = ae::frender::createGlyphCache();
+    ae::frender::font_t *font = ae::frender::loadFont(cache, fontPath.c_str());
+    std::vector<uint32_t> pixels(1280 * 720, 0xFF203040);
+    ae::frender::backbuffer_t target = { pixels.data(), 1280, 720, sizeof(uint32_t), 1280 * sizeof(uint32_t) };
+    // a screen of 40 lines of 120 characters.
+    std::vector<std::string> lines(40);
+    std::vector<ae::frender::text_draw_t> draws;
+    for (uint32_t i = 0; i < 40; i++) {
+        for (uint32_t k = 0; k < 120; k++) lines[i] += char('!' + (i * 31 + k * 7) % 94);
+        draws.push_back({ font, 16, 4.f, float(i * 18), lines[i].c_str(), 0xFFE0E0E0 });
+    }
+    BENCHMARK( "4800 cached glyphs at 16px" ) {
+        ae::frender::drawTexts(cache, &target, draws.data(), uint32_t(draws.size()));
+        return pixels[360 * 1280 + 640];
+    };
+    for (auto &draw : draws) draw.color = 0xA0E0E0E0;
+    BENCHMARK( "4800 cached glyphs at 16px, translucent" ) {
+        ae::frender::drawTexts(cache, &target, draws.data(), uint32_t(draws.size()));
+        return pixels[360 * 1280 + 640];
+    };
+    uint32_t size = 16;
+    BENCHMARK( "one line at a new size each time" ) {
+        ae::frender::drawText(cache, &target, font, 10 + size++ % 400, 4.f, 4.f, lines[0].c_str(), 0xFFE0E0E0);
+        return pixels[10 * 1280 + 10];
+    };
+    ae::frender::destroyGlyphCache(cache);
+}
+
+TEST_CASE( "ui frame", "[.][bench]" ) {
+    utils::SetupTestEngineContext();
+    utils::Seed(__LINE__);
+    // a frame like ImGui gives: windows of rects, text from a font atlas and anti-aliased fringes.
+    std::vector<uint32_t> atlasPixels(512 * 64);
+    for (uint32_t &p : atlasPixels) p = (utils::RandomUINT32(0, 255) << 24) | 0xFFFFFF;
+    ae::loaded_image_t atlas = {};
+    atlas.pixelPointer = atlasPixels.data();
+    atlas.width = 512;
+    atlas.height = 64;
+    ae::frender::premultiplyAlpha(atlas);
+
+    std::vector<ae::frender::ui_vertex_t> vertices;
+    std::vector<uint16_t> indices;
+    std::vector<ae::frender::ui_command_t> commands;
+    std::vector<ae::frender::ui_draw_list_t> lists;
+    // NOTE: the commands are reserved so that the lists can point into them.
+    commands.reserve(64);
+    std::vector<std::vector<ae::frender::ui_vertex_t>> listVertices(12);
+    std::vector<std::vector<uint16_t>> listIndices(12);
+    uint32_t glyphs = 0;
+    for (uint32_t w = 0; w < 12; w++) {
+        auto &v = listVertices[w];
+        auto &idx = listIndices[w];
+        const float x0 = 20.f + (w % 4) * 310.f, y0 = 20.f + (w / 4) * 230.f;
+        auto quad = [&](float x, float y, float width, float height, float u0, float v0, float u1, float v1,
+                        uint32_t color) {
+            uint16_t base = uint16_t(v.size());
+            v.push_back({ x, y, u0, v0, color });
+            v.push_back({ x + width, y, u1, v0, color });
+            v.push_back({ x + width, y + height, u1, v1, color });
+            v.push_back({ x, y + height, u0, v1, color });
+            idx.insert(idx.end(), { base, uint16_t(base + 1), uint16_t(base + 2), base, uint16_t(base + 2),
+                                    uint16_t(base + 3) });
+        };
+        const float white = 0.5f / 512.f;
+        quad(x0, y0, 300.f, 220.f, white, white, white, white, 0xF0242424);
+        quad(x0, y0, 300.f, 20.f, white, white, white, white, 0xFF8A4A29);
+        // the fringe of the border, which fades out over a pixel.
+        for (uint32_t side = 0; side < 4; side++) {
+            float ax = x0 + ((side == 1 || side == 2) ? 300.f : 0.f), ay = y0 + ((side >= 2) ? 220.f : 0.f);
+            float bx = x0 + ((side <= 1) ? 300.f : 0.f), by = y0 + ((side == 1 || side == 2) ? 220.f : 0.f);
+            float nx = (side == 1) ? -1.f : (side == 3) ? 1.f : 0.f, ny = (side == 2) ? -1.f : (side == 0) ? 1.f : 0.f;
+            uint16_t base = uint16_t(v.size());
+            v.push_back({ ax, ay, white, white, 0xFF6E6E80 });
+            v.push_back({ bx, by, white, white, 0xFF6E6E80 });
+            v.push_back({ bx + nx, by + ny, white, white, 0x006E6E80 });
+            v.push_back({ ax + nx, ay + ny, white, white, 0x006E6E80 });
+            idx.insert(idx.end(), { base, uint16_t(base + 1), uint16_t(base + 2), uint16_t(base + 2),
+                                    uint16_t(base + 3), base });
+        }
+        for (uint32_t line = 0; line < 14; line++) {
+            for (uint32_t c = 0; c < 40; c++, glyphs++) {
+                float u = float(utils::RandomUINT32(0, 63) * 8) / 512.f;
+                float t = float(utils::RandomUINT32(0, 3) * 16) / 64.f;
+                quad(x0 + 6.f + c * 7.f, y0 + 26.f + line * 14.f, 7.f, 13.f, u, t, u + 7.f / 512.f, t + 13.f / 64.f,
+                    0xFFE6E6E6);
+            }
+        }
+        commands.push_back({ x0, y0, x0 + 300.f, y0 + 220.f, &atlas, 0, 0, uint32_t(idx.size()) });
+        lists.push_back({ v.data(), uint32_t(v.size()), idx.data(), uint32_t(idx.size()), &commands.back(), 1 });
+    }
+    ae::frender::ui_draw_data_t data = {};
+    data.lists = lists.data();
+    data.listCount = uint32_t(lists.size());
+
+    std::vector<uint32_t> pixels(1280 * 720, 0xFF405060);
+    ae::frender::backbuffer_t target = { pixels.data(), 1280, 720, sizeof(uint32_t), 1280 * sizeof(uint32_t) };
+    ae::frender::ui_renderer_t *renderer = ae::frender::createUiRenderer();
+    BENCHMARK( "12 windows of 560 glyphs at 1280x720" ) {
+        ae::frender::renderUi(renderer, &target, data);
+        return pixels[360 * 1280 + 640];
+    };
+    ae::frender::ui_stats_t stats = ae::frender::getUiStats(renderer);
+    WARN( glyphs << " glyphs, " << stats.rects << " rects, " << stats.triangles << " triangles, " << stats.tileShapes
+                 << " tile shapes" );
+    ae::frender::destroyUiRenderer(renderer);
+}
+
 // TEST_CASE( name, tags )
 TEST_CASE( "Factorials are computed", "[factorial]" ) {
     REQUIRE( Factorial(1) == 1 );